@@ -33,6 +33,7 @@
 #include "bsPrimitiveCreator.h"
 #include "bsRayCastUtil.h"
 #include "bsSmoothCameraMovement.h"
+#include "bsMemoryTracker.h"
 #include "bsText3D.h"
 
 #include "bsDeferredRenderer.h"
@@ -48,16 +49,46 @@
 bsSmoothCameraMovement* camMov;
 
 Application::Application(HINSTANCE hInstance, int showCmd, const int windowWidth,
-	const int windowHeight)
+	const int windowHeight, const ApplicationReplayInfo& replayInfo)
 	: mInputManager(nullptr)
 	, mKeyboard(nullptr)
 	, mMouse(nullptr)
+	, mInputRecorder(nullptr)
+	, mInputPlayback(nullptr)
+	, mFixedTimeStepMs(replayInfo.fixedTimeStepMs)
+	, mRandomSeed(GetTickCount())
 	, mCameraSpeed(1.0f)
 	, mFreeCamMode(false)
 {
-	w = a = s = d = space = c = shift = false;
+	w = a = s = d = g = space = c = shift = false;
 	rightMouseDown = leftMouseDown = mQuit = false;
 
+	BS_ASSERT2(replayInfo.recordFileName.empty() || replayInfo.playbackFileName.empty(),
+		"Input can't be recorded and played back at the same time");
+
+	if (!replayInfo.playbackFileName.empty())
+	{
+		mInputPlayback = new bsInputPlayback();
+		if (mInputPlayback->load(replayInfo.playbackFileName))
+		{
+			mRandomSeed = mInputPlayback->getRandomSeed();
+		}
+		else
+		{
+			delete mInputPlayback;
+			mInputPlayback = nullptr;
+		}
+	}
+	else if (!replayInfo.recordFileName.empty())
+	{
+		mInputRecorder = new bsInputRecorder();
+		if (!mInputRecorder->open(replayInfo.recordFileName, mRandomSeed))
+		{
+			delete mInputRecorder;
+			mInputRecorder = nullptr;
+		}
+	}
+
 	bsCoreCInfo coreCInfo;
 	coreCInfo.hInstance = hInstance;
 	coreCInfo.showCmd = showCmd;
@@ -80,6 +111,7 @@ Application::Application(HINSTANCE hInstance, int showCmd, const int windowWidth
 
 	mMouse->getMouseState().width = windowWidth;
 	mMouse->getMouseState().height = windowHeight;
+	mMouseState = mMouse->getMouseState();
 
 	mKeyboard->setEventCallback(this);
 	mMouse->setEventCallback(this);
@@ -93,11 +125,12 @@ Application::Application(HINSTANCE hInstance, int showCmd, const int windowWidth
 	bsTextManager* textManager = mCore->getResourceManager()->getTextManager();
 
 	
-	mScene = new bsScene(mCore->getDx11Renderer(), mCore->getHavokManager(), coreCInfo);
+	mScene = new bsScene(mCore->getDx11Renderer(), mCore->getHavokManager(),
+		mCore->getJobSystem(), coreCInfo);
 
 	mDeferredRenderer = new bsDeferredRenderer(mCore->getDx11Renderer(),
 		mScene->getCamera(), mCore->getResourceManager()->getShaderManager(),
-		window, mCore->getRenderQueue());
+		mCore->getRenderQueue());
 	//Register the text manager with the rendering system so that it'll draw texts
 	mDeferredRenderer->registerEndOfRenderCallback(std::bind(&bsTextManager::drawAllTexts, textManager));
 
@@ -173,7 +206,7 @@ Application::Application(HINSTANCE hInstance, int showCmd, const int windowWidth
 	*/
 	/*
 	bsEntity* test = new bsEntity();
-	test->getEntity().attach(mCore->getResourceManager()->getMeshCache()->getMesh("bun_zipper.bsm"));
+	test->getEntity().attach(mCore->getResourceManager()->getMeshCache()->getMesh(bsStringId("bun_zipper.bsm")));
 	test->setLocalScaleUniform(15.0f);
 	test->setLocalPosition(hkVector4(10.0f, 10.0f, 10.0f));
 	
@@ -195,7 +228,7 @@ Application::Application(HINSTANCE hInstance, int showCmd, const int windowWidth
 		lightEntity->attachLight(*light);
 		mScene->addEntity(*lightEntity);
 
-		entities["light"] = lightEntity;
+		entities[bsStringId("light")] = lightEntity;
 	}
 
 	{
@@ -226,6 +259,9 @@ Application::~Application()
 	mInputManager->destroyInputObject(mKeyboard);
 	mInputManager->destroyInputObject(mMouse);
 	mInputManager->destroyInputSystem(mInputManager);
+
+	delete mInputRecorder;
+	delete mInputPlayback;
 	
 	delete camMov;
 
@@ -242,8 +278,48 @@ bool goingUp = true;
 
 void Application::update(float deltaTime)
 {
-	mKeyboard->capture();
-	mMouse->capture();
+	//Entities are moved below, which must not overlap a pipelined simulation step.
+	mScene->waitForSimulation();
+
+	std::string logLine;
+	while (mLogLines.try_pop(logLine))
+	{
+		mLogTextBox->addTextLine(logLine);
+	}
+
+	//Time the simulation advances by this frame. deltaTime is still used for statistics.
+	float stepTime = deltaTime;
+
+	if (mInputPlayback)
+	{
+		if (!mInputPlayback->nextFrame())
+		{
+			BS_LOG_INFO(GENERAL, "Input playback finished after %u frames",
+				mInputPlayback->getFrameCount());
+			mQuit = true;
+
+			return;
+		}
+
+		//Live input is ignored, the recorded events are handled instead.
+		stepTime = mInputPlayback->getDeltaTime();
+		playBackEvents();
+	}
+	else
+	{
+		mKeyboard->capture();
+		mMouse->capture();
+	}
+
+	if (mFixedTimeStepMs > 0.0f)
+	{
+		stepTime = mFixedTimeStepMs;
+	}
+
+	if (mInputRecorder)
+	{
+		mInputRecorder->endFrame(stepTime);
+	}
 	
 	bsCamera* camera = mScene->getCamera();
 	bsEntity& camEntity = *camera->getEntity();
@@ -253,7 +329,7 @@ void Application::update(float deltaTime)
 	float forward = s ? (-1.0f) : (w ? 1.0f : 0.0f);
 	float up = c ? (-1.0f) : (space ? 1.0f : 0.0f);
 	
-	//camMov->update(forward, right, up, deltaTime);
+	//camMov->update(forward, right, up, stepTime);
 
 	mRenderStats.setFps(1.0f / deltaTime * 1000.0f);
 	mRenderStats.setFrameTime(deltaTime);
@@ -263,7 +339,7 @@ void Application::update(float deltaTime)
 
 	if (mFreeCamMode)
 	{
-		camMov->update(forward, right, up, deltaTime);
+		camMov->update(forward, right, up, stepTime);
 	}
 	else
 	{
@@ -275,11 +351,11 @@ void Application::update(float deltaTime)
 
 
 	//Update texts
-	mCore->getResourceManager()->getTextManager()->updateTexts(deltaTime);
+	mCore->getResourceManager()->getTextManager()->updateTexts(stepTime);
 
-	mTexts["stats"]->setText(mRenderStats.getStatsString());
-	mTexts["frameStats"]->setText(mDeferredRenderer->getRenderQueue()->getFrameStats()
-		.getFrameStatsStringWide());
+	mTexts[bsStringId("stats")]->setText(mRenderStats.getStatsString());
+	mTexts[bsStringId("frameStats")]->setText(
+		mDeferredRenderer->getRenderQueue()->getFrameStats().getFrameStatsStringWide());
 
 	XMFLOAT4A camPos;
 	XMStoreFloat4A(&camPos, camEntity.mTransform.getPosition());
@@ -291,19 +367,19 @@ void Application::update(float deltaTime)
 		L"Cam rot: x: %.3f, y: %.3f, z: %.3f, w: %.3f", camPos.x, camPos.y, camPos.z,
 		camRot.x, camRot.y, camRot.z, camRot.w);
 	
-	mTexts["camPos"]->setText(cameraInfoBuffer);
+	mTexts[bsStringId("camPos")]->setText(cameraInfoBuffer);
 
 
 	if (leftMouseDown)
 	{
-		bsEntity& lineEntity = *entities["line"];
+		bsEntity& lineEntity = *entities[bsStringId("line")];
 		bsLineRenderer& line = *lineEntity.getLineRenderer();
 		const float rayLength = 100.0f;
 
 		hkpWorldRayCastOutput output;
 		XMVECTOR destinationOut, originOut;
-		output = camera->screenPointToWorldRay(XMFLOAT2((float)mMouse->getMouseState().X.abs,
-			(float)mMouse->getMouseState().Y.abs), rayLength, destinationOut, originOut);
+		output = camera->screenPointToWorldRay(XMFLOAT2((float)mMouseState.X.abs,
+			(float)mMouseState.Y.abs), rayLength, destinationOut, originOut);
 
 		if (output.hasHit())
 		{
@@ -357,10 +433,10 @@ void Application::update(float deltaTime)
 			}
 			rb->getWorld()->unmarkForWrite();
 
-			entities["light"]->mTransform.setPosition(XMVectorAdd(hitPoint, XMLoadFloat3(&normal)));
+			entities[bsStringId("light")]->mTransform.setPosition(XMVectorAdd(hitPoint, XMLoadFloat3(&normal)));
 
 			
-			bsEntity& textEntity = *entities["text"];
+			bsEntity& textEntity = *entities[bsStringId("text")];
 			textEntity.mTransform.setPosition(XMLoadFloat3(points + 1));
 			bsText3D& text = *textEntity.getTextRenderer();
 
@@ -387,7 +463,7 @@ void Application::update(float deltaTime)
 	{
 		static float accumulatedDt = mCurve->getEnd();
 		const float speed = (1.0f / mCurve->getEnd()) * 50000.0f;
-		if (!mKeyboard->isKeyDown(OIS::KC_G))
+		if (!g)
 			accumulatedDt -= 0.01666667f * speed;
 
 		while (accumulatedDt < 0.0f)
@@ -397,7 +473,7 @@ void Application::update(float deltaTime)
 		
 		const float invDeltaTimeSecs = 1.0f / 0.016666667f;
 
-		hkpRigidBody& liftRigidBody = *entities["lift"]->mRigidBody;
+		hkpRigidBody& liftRigidBody = *entities[bsStringId("lift")]->mRigidBody;
 		liftRigidBody.getWorld()->markForWrite();
 		hkQuaternion nextRotation = liftRigidBody.getRotation();
 		nextRotation.mul(hkQuaternion(hkVector4(0.0f, 1.0f, 0.0f), 0.0025f));
@@ -430,7 +506,7 @@ void Application::update(float deltaTime)
 		liftRigidBody.getWorld()->unmarkForWrite();
 	}
 
-	mScene->update(deltaTime);
+	mScene->update(stepTime);
 
 	if (!mCore->update(deltaTime))
 	{
@@ -440,10 +516,16 @@ void Application::update(float deltaTime)
 
 bool Application::keyPressed(const OIS::KeyEvent& arg)
 {
+	recordKeyEvent(bsInputEvent::KEY_PRESSED, arg);
+
 	if (arg.key == OIS::KC_W)
 	{
 		w = true;
 	}
+	if (arg.key == OIS::KC_G)
+	{
+		g = true;
+	}
 	if (arg.key == OIS::KC_S)
 	{
 		s = true;
@@ -529,15 +611,15 @@ bool Application::keyPressed(const OIS::KeyEvent& arg)
 
 	case OIS::KC_R:
 		{
-			hkPseudoRandomGenerator rng(GetTickCount());
+			hkPseudoRandomGenerator rng(nextRandomSeed());
 			hkVector4 p;
 			rng.getRandomVector11(p);
 			hkQuaternion q;
 			rng.getRandomRotation(q);
 
 
-			entities["line"]->mTransform.setPosition(bsMath::toXM(p));
-			entities["line"]->mTransform.setLocalRotation(bsMath::toXM(q));
+			entities[bsStringId("line")]->mTransform.setPosition(bsMath::toXM(p));
+			entities[bsStringId("line")]->mTransform.setLocalRotation(bsMath::toXM(q));
 		}
 		break;
 
@@ -556,11 +638,118 @@ bool Application::keyPressed(const OIS::KeyEvent& arg)
 	case OIS::KC_U:
 		mCore->getRenderQueue()->setUseInstancing(false);
 		break;
+
+	case OIS::KC_M:
+		bsMemoryTracker::logReport(25);
+		break;
+
+	case OIS::KC_F11:
+		mCore->getRenderQueue()->requestFrameCapture("frame.bsfc");
+		break;
 	}
 
 	return true;
 }
 
+void Application::recordKeyEvent(bsInputEvent::Type type, const OIS::KeyEvent& arg)
+{
+	if (!mInputRecorder)
+	{
+		return;
+	}
+
+	bsInputEvent inputEvent;
+	memset(&inputEvent, 0, sizeof(inputEvent));
+	inputEvent.type = static_cast<unsigned char>(type);
+	inputEvent.key = static_cast<unsigned short>(arg.key);
+
+	mInputRecorder->addEvent(inputEvent);
+}
+
+void Application::recordMouseEvent(bsInputEvent::Type type, const OIS::MouseEvent& arg,
+	OIS::MouseButtonID id)
+{
+	if (!mInputRecorder)
+	{
+		return;
+	}
+
+	bsInputEvent inputEvent;
+	inputEvent.type = static_cast<unsigned char>(type);
+	inputEvent.button = static_cast<unsigned char>(id);
+	inputEvent.key = 0;
+	inputEvent.absX = arg.state.X.abs;
+	inputEvent.absY = arg.state.Y.abs;
+	inputEvent.absZ = arg.state.Z.abs;
+	inputEvent.relX = arg.state.X.rel;
+	inputEvent.relY = arg.state.Y.rel;
+	inputEvent.relZ = arg.state.Z.rel;
+	inputEvent.buttons = arg.state.buttons;
+
+	mInputRecorder->addEvent(inputEvent);
+}
+
+void Application::playBackEvents()
+{
+	const bsInputEvent* events = mInputPlayback->getEvents();
+	const unsigned int eventCount = mInputPlayback->getEventCount();
+
+	for (unsigned int i = 0; i < eventCount; ++i)
+	{
+		const bsInputEvent& inputEvent = events[i];
+
+		if (inputEvent.type == bsInputEvent::KEY_PRESSED
+			|| inputEvent.type == bsInputEvent::KEY_RELEASED)
+		{
+			const OIS::KeyEvent keyEvent(mKeyboard,
+				static_cast<OIS::KeyCode>(inputEvent.key), 0);
+
+			if (inputEvent.type == bsInputEvent::KEY_PRESSED)
+			{
+				keyPressed(keyEvent);
+			}
+			else
+			{
+				keyReleased(keyEvent);
+			}
+
+			continue;
+		}
+
+		//Keeps the window size of the live state.
+		OIS::MouseState state = mMouseState;
+		state.X.abs = inputEvent.absX;
+		state.Y.abs = inputEvent.absY;
+		state.Z.abs = inputEvent.absZ;
+		state.X.rel = inputEvent.relX;
+		state.Y.rel = inputEvent.relY;
+		state.Z.rel = inputEvent.relZ;
+		state.buttons = inputEvent.buttons;
+
+		const OIS::MouseEvent mouseEvent(mMouse, state);
+		const OIS::MouseButtonID id = static_cast<OIS::MouseButtonID>(inputEvent.button);
+
+		switch (inputEvent.type)
+		{
+		case bsInputEvent::MOUSE_MOVED:
+			mouseMoved(mouseEvent);
+			break;
+
+		case bsInputEvent::MOUSE_PRESSED:
+			mousePressed(mouseEvent, id);
+			break;
+
+		case bsInputEvent::MOUSE_RELEASED:
+			mouseReleased(mouseEvent, id);
+			break;
+
+		default:
+			BS_ASSERT2(false, "Unknown input event type");
+			break;
+		}
+	}
+}
+
 void Application::toggleFreeCam()
 {
 	bsEntity& camEntity = *mScene->getCamera()->getEntity();
@@ -591,10 +780,16 @@ void Application::toggleFreeCam()
 
 bool Application::keyReleased(const OIS::KeyEvent& arg)
 {
+	recordKeyEvent(bsInputEvent::KEY_RELEASED, arg);
+
 	if (arg.key == OIS::KC_W)
 	{
 		w = false;
 	}
+	if (arg.key == OIS::KC_G)
+	{
+		g = false;
+	}
 	if (arg.key == OIS::KC_S)
 	{
 		s = false;
@@ -628,6 +823,9 @@ XMFLOAT3 yawPitchRoll = XMFLOAT3(0.0f, 0.0f, 0.0f);
 
 bool Application::mouseMoved(const OIS::MouseEvent& arg)
 {
+	recordMouseEvent(bsInputEvent::MOUSE_MOVED, arg, OIS::MB_Left);
+	mMouseState = arg.state;
+
 	bsCamera* camera = mScene->getCamera();
 	bsEntity& camEntity = *camera->getEntity();
 	const XMVECTOR& cameraRot = camEntity.mTransform.getRotation();
@@ -679,6 +877,9 @@ bool Application::mouseMoved(const OIS::MouseEvent& arg)
 
 bool Application::mousePressed(const OIS::MouseEvent& arg, OIS::MouseButtonID id)
 {
+	recordMouseEvent(bsInputEvent::MOUSE_PRESSED, arg, id);
+	mMouseState = arg.state;
+
 	switch (id)
 	{
 	case OIS::MB_Left:
@@ -690,7 +891,7 @@ bool Application::mousePressed(const OIS::MouseEvent& arg, OIS::MouseButtonID id
 		break;
 
 	case OIS::MB_Middle:
-		entities["line"]->getLineRenderer()->clear();
+		entities[bsStringId("line")]->getLineRenderer()->clear();
 		break;
 	}
 
@@ -699,6 +900,9 @@ bool Application::mousePressed(const OIS::MouseEvent& arg, OIS::MouseButtonID id
 
 bool Application::mouseReleased(const OIS::MouseEvent &arg, OIS::MouseButtonID id)
 {
+	recordMouseEvent(bsInputEvent::MOUSE_RELEASED, arg, id);
+	mMouseState = arg.state;
+
 	switch (id)
 	{
 	case OIS::MB_Left:
@@ -763,7 +967,7 @@ void Application::createSomeLights()
 
 	//Random position lights
 	{
-		hkPseudoRandomGenerator rng(GetTickCount());
+		hkPseudoRandomGenerator rng(nextRandomSeed());
 		const float offsetPositive = 80.0f;
 		const float offsetNegative = -5.0f;
 		const float maxHeight = 15.0f;
@@ -791,12 +995,17 @@ void Application::createMeshes()
 {
 	bsMeshCache* meshCache = mCore->getResourceManager()->getMeshCache();
 
-	mMeshes.insert(std::make_pair("teapot", meshCache->getMesh("teapot.bsm")));
-	mMeshes.insert(std::make_pair("gourd", meshCache->getMesh("gourd.bsm")));
-	mMeshes.insert(std::make_pair("sphere", meshCache->getMesh("sphere_1m_d.bsm")));
-	mMeshes.insert(std::make_pair("greeble", meshCache->getMesh("greeble_town_small.bsm")));
-	mMeshes.insert(std::make_pair("plane", meshCache->getMesh("plane_1m.bsm")));
-	mMeshes["cube"] = meshCache->getMesh("unit_cube.bsm");
+	mMeshes.insert(std::make_pair(bsStringId("teapot"),
+		meshCache->getMesh(bsStringId("teapot.bsm"))));
+	mMeshes.insert(std::make_pair(bsStringId("gourd"),
+		meshCache->getMesh(bsStringId("gourd.bsm"))));
+	mMeshes.insert(std::make_pair(bsStringId("sphere"),
+		meshCache->getMesh(bsStringId("sphere_1m_d.bsm"))));
+	mMeshes.insert(std::make_pair(bsStringId("greeble"),
+		meshCache->getMesh(bsStringId("greeble_town_small.bsm"))));
+	mMeshes.insert(std::make_pair(bsStringId("plane"),
+		meshCache->getMesh(bsStringId("plane_1m.bsm"))));
+	mMeshes[bsStringId("cube")] = meshCache->getMesh(bsStringId("unit_cube.bsm"));
 }
 
 void Application::createTexts()
@@ -815,9 +1024,10 @@ void Application::createTexts()
 	textBox->getText()->setPosition(10.0f, 350.0f);
 	textBox->getText()->addFlags(FW1_BOTTOM | FW1_RESTORESTATE);
 	textBox->getText()->setFontSize(14.0f);
-	bsLog::addCallback([textBox](const char* message)
+	mLogTextBox = textBox;
+	bsLog::addCallback([this](const char* message)
 	{
-		textBox->addTextLine(message);
+		mLogLines.push(message);
 	});
 
 	auto frameStats = textManager->createText2D(L"");
@@ -840,11 +1050,11 @@ void Application::createTexts()
 	crosshair->setFontSize(12.0f);
 
 
-	mTexts.insert(std::make_pair("stats", statsText));
-	//mTexts.insert(std::make_pair("scrolling", textBox));
-	mTexts.insert(std::make_pair("frameStats", frameStats));
-	mTexts.insert(std::make_pair("camPos", camPos));
-	mTexts.insert(std::make_pair("crosshair", crosshair));
+	mTexts.insert(std::make_pair(bsStringId("stats"), statsText));
+	//mTexts.insert(std::make_pair(bsStringId("scrolling"), textBox));
+	mTexts.insert(std::make_pair(bsStringId("frameStats"), frameStats));
+	mTexts.insert(std::make_pair(bsStringId("camPos"), camPos));
+	mTexts.insert(std::make_pair(bsStringId("crosshair"), crosshair));
 }
 
 #include <Common/Base/Reflection/hkClass.h>
@@ -863,7 +1073,7 @@ void Application::createEntities()
 		const XMVECTOR spherePosition = XMVectorSet(12.5f, 5.0f, 5.0f, 0.0f);
 
 		bsEntity* sphereEntity = new bsEntity();
-		sphereEntity->attachMesh(mMeshes["sphere"]);
+		sphereEntity->attachMesh(mMeshes[bsStringId("sphere")]);
 
 		hkpRigidBodyCinfo ci;
 		ci.m_shape = new hkpSphereShape(0.5f);
@@ -885,7 +1095,7 @@ void Application::createEntities()
 		sphereEntity->attachLight(*light);
 	
 		mScene->addEntity(*sphereEntity);
-		entities.insert(std::make_pair("sphere", sphereEntity));
+		entities.insert(std::make_pair(bsStringId("sphere"), sphereEntity));
 
 		sphereEntity->mTransform.setPosition(spherePosition);
 	}
@@ -901,20 +1111,20 @@ void Application::createEntities()
 	bsEntity* lineEntity = new bsEntity();
 	bsLineRenderer* line3D = new bsLineRenderer(XMFLOAT4(1.0f, 0.0f, 0.0f, 1.0f));
 	lineEntity->attachLineRenderer(*line3D);
-	entities.insert(std::make_pair("line", lineEntity));
+	entities.insert(std::make_pair(bsStringId("line"), lineEntity));
 	mScene->addEntity(*lineEntity);
 
 	bsEntity* textEntity = new bsEntity();
 	bsText3D* text3D = new bsText3D(mCore->getDx11Renderer()->getDeviceContext(),
 		mCore->getDx11Renderer()->getDevice(), mCore->getResourceManager()->getTextManager()->getFw1Factory());
 	textEntity->attachTextRenderer(*text3D);
-	entities["text"] = textEntity;
+	entities[bsStringId("text")] = textEntity;
 	mScene->addEntity(*textEntity);
 }
 
 void Application::createSpheres(unsigned int count)
 {
-	hkPseudoRandomGenerator rng(GetTickCount());
+	hkPseudoRandomGenerator rng(nextRandomSeed());
 	const hkVector4 minPos(-25.0f,  2.5f, -25.0f);
 	const hkVector4 maxPos( 25.0f, 15.0f,  25.0f);
 
@@ -934,7 +1144,7 @@ void Application::createSpheres(unsigned int count)
 
 #if 1
 		bsEntity* sphereEntity = new bsEntity();
-		sphereEntity->attachMesh(mMeshes["sphere"]);
+		sphereEntity->attachMesh(mMeshes[bsStringId("sphere")]);
 
 		hkpMassProperties massProps;
 		hkInertiaTensorComputer::computeSphereVolumeMassProperties(radius, volume, massProps);
@@ -972,11 +1182,12 @@ void Application::createSpheres(unsigned int count)
 
 void Application::createBoxes(bool staticBoxes, unsigned int count)
 {
-	hkPseudoRandomGenerator rng(GetTickCount());
+	hkPseudoRandomGenerator rng(nextRandomSeed());
 	const hkVector4 minPos(-25.0f,  2.5f, -25.0f);
 	const hkVector4 maxPos( 25.0f, 15.0f,  25.0f);
 
-	auto mesh = mCore->getResourceManager()->getMeshCache()->getMesh("unit_cube.bsm");
+	auto mesh = mCore->getResourceManager()->getMeshCache()->getMesh(
+		bsStringId("unit_cube.bsm"));
 	//auto mesh = mCore->getResourceManager()->getMeshCache()->getMesh("teapot.bsm");
 
 	XMFLOAT3 boundingSphereCenter;
@@ -1105,7 +1316,7 @@ void Application::createKeyframedRb()
 	bsEntity* keyframedEntity = new bsEntity();
 	keyframedEntity->mTransform.setPosition(position);
 
-	keyframedEntity->attachMesh(mMeshes["cube"]);
+	keyframedEntity->attachMesh(mMeshes[bsStringId("cube")]);
 	keyframedEntity->mTransform.setLocalScale(boxSize);
 
 	float volume = XMVectorGetX(boxSize) * XMVectorGetY(boxSize) * XMVectorGetZ(boxSize);
@@ -1140,7 +1351,7 @@ void Application::createKeyframedRb()
 
 	mScene->addEntity(*keyframedEntity);
 
-	entities["lift"] = keyframedEntity;
+	entities[bsStringId("lift")] = keyframedEntity;
 
 	float j = 1.0f;
 	for (size_t i = 0; i < 10; ++i, j += 1.0f)
@@ -1167,7 +1378,7 @@ void Application::createKeyframedRb()
 
 		bsEntity* boxEntity = new bsEntity();
 		boxEntity->attachRigidBody(*rb);
-		boxEntity->attachMesh(mMeshes["cube"]);
+		boxEntity->attachMesh(mMeshes[bsStringId("cube")]);
 
 		//const XMVECTOR boxPosition = XMVectorAdd(position, XMVectorSet(x, (j + 1.1001f) * 1.01f, z, 0.0f));
 		const XMVECTOR boxPosition = XMVectorAdd(position, XMVectorSet(0.0f, j * 1.0001f, 0.0f, 0.0f));
@@ -1257,7 +1468,7 @@ void Application::createLines()
 	line->build(mCore->getDx11Renderer());
 	lineEntity->attachLineRenderer(*line);
 	mScene->addEntity(*lineEntity);
-	entities["mCurve"] = lineEntity;
+	entities[bsStringId("mCurve")] = lineEntity;
 }
 
 bsEntity* Application::createLightAtPosition(const XMVECTOR& position, float radius, const XMFLOAT3& color)
@@ -1283,11 +1494,12 @@ void Application::createFactory()
 	bsEntity* greebleEntity = new bsEntity();
 	//greebleEntity.attach(mMeshes["greeble"]);
 	//greebleEntity.attach(mCore->getResourceManager()->getMeshCache()->getMesh("greeble_town.bsm"));
-	greebleEntity->attachMesh(mCore->getResourceManager()->getMeshCache()->getMesh("factory.bsm"));
+	greebleEntity->attachMesh(mCore->getResourceManager()->getMeshCache()->getMesh(
+		bsStringId("factory.bsm")));
 	//greebleEntity.attach(mCore->getResourceManager()->getMeshCache()->getMesh("arrow.bsm"));
 	greebleEntity->mTransform.setPosition(XMVectorSet(0.0f, 0.1f, 0.0f, 0.0f));
 
-	entities.insert(std::make_pair("greeble", greebleEntity));
+	entities.insert(std::make_pair(bsStringId("greeble"), greebleEntity));
 	{
 		const std::string fileName = mCore->getResourceManager()->getFileSystem()->
 			getPathFromFilename("factory.hkx");
@@ -7,8 +7,12 @@
 
 #include <OIS.h>
 
+#include <tbb/concurrent_queue.h>
+
 #include "bsRenderStats.h"
 #include "bsPrimitiveCreator.h"
+#include "bsStringId.h"
+#include "bsInputRecording.h"
 
 #include <Common/Base/hkBase.h>
 #include <Physics/Dynamics/hkpDynamics.h>
@@ -19,15 +23,42 @@ class bsCore;
 class bsDeferredRenderer;
 class bsMesh;
 class bsText2D;
+class bsScrollingText2D;
 class bsEntity;
 class bsScene;
 class bsCharacterController;
 
 
+/*	Input recording and playback settings, see bsInputRecording.h.
+	Recording and playback can't be used at the same time.
+*/
+struct ApplicationReplayInfo
+{
+	ApplicationReplayInfo()
+		: fixedTimeStepMs(0.0f)
+	{
+	}
+
+	//Records the input of every frame to this file when not empty.
+	std::string	recordFileName;
+
+	/*	Drives the application from this recording instead of the keyboard and mouse when
+		not empty. The application quits when the recording ends.
+	*/
+	std::string	playbackFileName;
+
+	/*	When not 0, every frame advances the simulation by this many milliseconds instead
+		of the measured (or recorded, when playing back) frame time.
+	*/
+	float		fixedTimeStepMs;
+};
+
+
 class Application : public OIS::KeyListener, public OIS::MouseListener
 {
 public:
-	Application(HINSTANCE hInstance, int showCmd, const int windowWidth, const int windowHeight);
+	Application(HINSTANCE hInstance, int showCmd, const int windowWidth,
+		const int windowHeight, const ApplicationReplayInfo& replayInfo);
 
 	~Application();
 
@@ -75,20 +106,49 @@ private:
 
 	void toggleFreeCam();
 
+	void recordKeyEvent(bsInputEvent::Type type, const OIS::KeyEvent& arg);
+
+	void recordMouseEvent(bsInputEvent::Type type, const OIS::MouseEvent& arg,
+		OIS::MouseButtonID id);
+
+	//Feeds the current playback frame's events to the listener functions.
+	void playBackEvents();
+
+	//Seeds are handed out in order, so a replayed session gets the same random values.
+	inline unsigned int nextRandomSeed()
+	{
+		return mRandomSeed++;
+	}
+
 	OIS::InputManager	*mInputManager;
 	OIS::Keyboard		*mKeyboard;
 	OIS::Mouse			*mMouse;
 
-	bool w, a, s, d, space, c, shift, rightMouseDown, leftMouseDown, mQuit;
+	bool w, a, s, d, g, space, c, shift, rightMouseDown, leftMouseDown, mQuit;
+
+	//Mouse state of the last mouse event, whether it was live or played back.
+	OIS::MouseState		mMouseState;
+
+	//Null when not recording or playing back.
+	bsInputRecorder*	mInputRecorder;
+	bsInputPlayback*	mInputPlayback;
+	float				mFixedTimeStepMs;
+	unsigned int		mRandomSeed;
 	float mCameraSpeed;
 
 	bsCore*		mCore;
 
 	bsDeferredRenderer*	mDeferredRenderer;
 
-	std::unordered_map<std::string, std::shared_ptr<bsMesh>> mMeshes;
-	std::unordered_map<std::string, std::shared_ptr<bsText2D>> mTexts;
-	std::unordered_map<std::string, bsEntity*> entities;
+	std::unordered_map<bsStringId, std::shared_ptr<bsMesh>, bsStringId::Hasher> mMeshes;
+	std::unordered_map<bsStringId, std::shared_ptr<bsText2D>, bsStringId::Hasher> mTexts;
+	std::unordered_map<bsStringId, bsEntity*, bsStringId::Hasher> entities;
+
+	/*	Log messages are queued by the log's callback, which runs on the log writer
+		thread, and added to the text box by update on the main thread.
+	*/
+	std::shared_ptr<bsScrollingText2D>		mLogTextBox;
+	tbb::concurrent_queue<std::string>		mLogLines;
 
 	bsRenderStats mRenderStats;
 	bsScene* mScene;
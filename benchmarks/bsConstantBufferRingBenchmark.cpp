@@ -0,0 +1,374 @@
+/*	Checks bsConstantBufferRing with and without constant buffer offsets, by driving it
+	through a bsRecordingRenderDevice in front of a bsNullRenderDevice, and measures the
+	time to write, upload and bind a frame's constants.
+
+	Checked for both paths:
+	- Allocations are aligned to bsConstantBufferRing::kAlignment (256 bytes), follow
+	  each other and are at least as large as requested.
+	- With offsets, every frame maps the ring's buffer once, and every bind sets the
+	  allocation's constants as a range of that buffer.
+	- Without offsets, every bind maps a buffer once, and nothing is bound by range.
+	- With offsets, a frame needing more than the capacity doubles it until the frame
+	  fits, replacing the buffer. Without offsets, the capacity stays 0.
+	- No device objects are left once the ring has been destroyed.
+
+	Options:
+	-allocations N	Allocations in the measured frames. Default 4096.
+	-iterations N	Frames measured. Default 100.
+
+	Exits with 1 if a check fails.
+
+	Build together with bsConstantBufferRing.cpp, bsNullRenderDevice.cpp,
+	bsRecordingRenderDevice.cpp, bsMemoryTracker.cpp, bsLog.cpp and bsLogFormat.cpp.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "../bsConstantBufferRing.h"
+#include "../bsNullRenderDevice.h"
+#include "../bsRecordingRenderDevice.h"
+#include "../bsTimer.h"
+
+
+namespace
+{
+//Small enough that the growth check frame does not fit.
+const unsigned int kInitialCapacity = 1024;
+
+//Sizes of the allocations, cycled through. Includes sizes of one, several and a
+//fraction of the alignment.
+const unsigned int kAllocationSizes[] = { 64, 256, 300, 16, 512, 80 };
+
+struct Options
+{
+	unsigned int	allocationCount;
+	unsigned int	iterations;
+};
+
+double elapsedMilliSeconds(long long startTicks)
+{
+	return bsTimer::ticksToMicroSeconds(bsTimer::getTicks() - startTicks) * 0.001;
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+	options.allocationCount = 4096;
+	options.iterations = 100;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		const unsigned int number = strtoul(argv[i + 1], nullptr, 10);
+
+		if (strcmp(argv[i], "-allocations") == 0)
+		{
+			options.allocationCount = number;
+		}
+		else if (strcmp(argv[i], "-iterations") == 0)
+		{
+			options.iterations = number;
+		}
+		else
+		{
+			printf("Unknown option '%s'\n", argv[i]);
+			return false;
+		}
+	}
+
+	return options.allocationCount > 0 && options.iterations > 0;
+}
+
+/*	Allocates allocationCount constants, uploads them and binds each one to a slot, the
+	way bsRenderQueue does in a frame. Returns false if an allocation is misplaced.
+*/
+bool writeFrame(bsConstantBufferRing& ring, unsigned int allocationCount,
+	std::vector<bsConstantBufferRing::Allocation>& allocations)
+{
+	bool passed = true;
+
+	ring.beginFrame();
+
+	allocations.resize(allocationCount);
+	unsigned int expectedOffset = 0;
+	for (unsigned int i = 0; i < allocationCount; ++i)
+	{
+		const unsigned int size = kAllocationSizes[i % ARRAYSIZE(kAllocationSizes)];
+		bsConstantBufferRing::Allocation& allocation = allocations[i];
+
+		void* constants = ring.allocate(size, allocation);
+		memset(constants, i & 0xff, size);
+
+		if (allocation.offset % bsConstantBufferRing::kAlignment != 0
+			|| allocation.size % bsConstantBufferRing::kAlignment != 0
+			|| allocation.size < size || allocation.offset != expectedOffset)
+		{
+			printf("Allocation %u of %u bytes at offset %u with size %u, expected offset"
+				" %u\n", i, size, allocation.offset, allocation.size, expectedOffset);
+			passed = false;
+		}
+
+		expectedOffset = allocation.offset + allocation.size;
+	}
+
+	if (ring.getUsedSize() != expectedOffset)
+	{
+		printf("%u bytes used, expected %u\n", ring.getUsedSize(), expectedOffset);
+		passed = false;
+	}
+
+	ring.upload();
+
+	for (unsigned int i = 0; i < allocationCount; ++i)
+	{
+		const unsigned int stages = i % 3 + 1;
+		ring.bind(i % D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT, allocations[i],
+			stages);
+	}
+
+	return passed;
+}
+
+//Binds done by writeFrame for each stage.
+unsigned int getStageBindCount(unsigned int allocationCount,
+	bsConstantBufferRing::Stage stage)
+{
+	unsigned int count = 0;
+	for (unsigned int i = 0; i < allocationCount; ++i)
+	{
+		if ((i % 3 + 1) & stage)
+		{
+			++count;
+		}
+	}
+
+	return count;
+}
+
+/*	Checks the maps and binds recorded for a frame written by writeFrame.
+	Returns true if they are the ones expected.
+*/
+bool checkFrame(const char* name, const bsConstantBufferRing& ring,
+	const bsRecordingRenderDevice& device,
+	const std::vector<bsConstantBufferRing::Allocation>& allocations,
+	bool constantBufferOffsets)
+{
+	bool passed = true;
+
+	const unsigned int allocationCount = static_cast<unsigned int>(allocations.size());
+	const unsigned int vertexBinds = getStageBindCount(allocationCount,
+		bsConstantBufferRing::VERTEX_STAGE);
+	const unsigned int pixelBinds = getStageBindCount(allocationCount,
+		bsConstantBufferRing::PIXEL_STAGE);
+
+	const unsigned int expectedMaps = constantBufferOffsets ? 1 : allocationCount;
+	const unsigned int maps = device.getCommandCount(bsRecordingRenderDevice::MAP_BUFFER);
+	if (maps != expectedMaps || ring.getMapCount() != expectedMaps
+		|| device.getCommandCount(bsRecordingRenderDevice::UNMAP_BUFFER) != expectedMaps)
+	{
+		printf("%s: %u maps recorded and %u counted by the ring, expected %u\n", name,
+			maps, ring.getMapCount(), expectedMaps);
+		passed = false;
+	}
+
+	typedef bsRecordingRenderDevice Device;
+	const unsigned int rangeBinds =
+		device.getCommandCount(Device::SET_VERTEX_CONSTANT_BUFFER_RANGE)
+		+ device.getCommandCount(Device::SET_PIXEL_CONSTANT_BUFFER_RANGE);
+	const unsigned int bufferBinds =
+		device.getCommandCount(Device::SET_VERTEX_CONSTANT_BUFFERS)
+		+ device.getCommandCount(Device::SET_PIXEL_CONSTANT_BUFFERS);
+
+	const unsigned int expectedRangeBinds =
+		constantBufferOffsets ? vertexBinds + pixelBinds : 0;
+	const unsigned int expectedBufferBinds =
+		constantBufferOffsets ? 0 : vertexBinds + pixelBinds;
+	if (rangeBinds != expectedRangeBinds || bufferBinds != expectedBufferBinds)
+	{
+		printf("%s: %u range binds and %u buffer binds, expected %u and %u\n", name,
+			rangeBinds, bufferBinds, expectedRangeBinds, expectedBufferBinds);
+		passed = false;
+	}
+
+	//Range binds are recorded in bind order, one or two per allocation.
+	const std::vector<bsRecordingRenderDevice::Command>& commands = device.getCommands();
+	unsigned int allocationIndex = 0;
+	unsigned int stagesLeft = 0;
+	for (size_t i = 0; i < commands.size() && passed; ++i)
+	{
+		const bsRecordingRenderDevice::Command& command = commands[i];
+		if (command.type != bsRecordingRenderDevice::SET_VERTEX_CONSTANT_BUFFER_RANGE
+			&& command.type != bsRecordingRenderDevice::SET_PIXEL_CONSTANT_BUFFER_RANGE)
+		{
+			continue;
+		}
+
+		if (stagesLeft == 0)
+		{
+			stagesLeft = allocationIndex % 3 == 2 ? 2 : 1;
+			++allocationIndex;
+		}
+		--stagesLeft;
+
+		//Ranges are in constants of 16 bytes.
+		const unsigned int offset = command.value * 16;
+		const unsigned int size = command.count * 16;
+
+		const bsConstantBufferRing::Allocation& allocation =
+			allocations[allocationIndex - 1];
+		if (offset != allocation.offset || size != allocation.size)
+		{
+			printf("%s: Allocation %u bound at offset %u with size %u, expected offset %u"
+				" and size %u\n", name, allocationIndex - 1, offset, size,
+				allocation.offset, allocation.size);
+			passed = false;
+		}
+	}
+
+	return passed;
+}
+
+/*	Checks that a frame larger than the ring doubles its capacity until it fits, and that
+	the next frame keeps that capacity.
+*/
+bool checkGrowth(const char* name, bsConstantBufferRing& ring,
+	bsRecordingRenderDevice& device, bool constantBufferOffsets)
+{
+	bool passed = true;
+
+	const unsigned int capacityBefore = ring.getCapacity();
+	std::vector<bsConstantBufferRing::Allocation> allocations;
+
+	//Needs more than 3 times the initial capacity.
+	const unsigned int allocationCount =
+		(kInitialCapacity * 3) / bsConstantBufferRing::kAlignment + 1;
+
+	device.clear();
+	passed &= writeFrame(ring, allocationCount, allocations);
+
+	unsigned int expectedCapacity = 0;
+	if (constantBufferOffsets)
+	{
+		expectedCapacity = capacityBefore;
+		while (expectedCapacity < ring.getUsedSize())
+		{
+			expectedCapacity *= 2;
+		}
+	}
+
+	if (ring.getCapacity() != expectedCapacity)
+	{
+		printf("%s: Capacity %u after growing from %u for %u bytes, expected %u\n",
+			name, ring.getCapacity(), capacityBefore, ring.getUsedSize(),
+			expectedCapacity);
+		passed = false;
+	}
+
+	//Growing replaces the buffer once, however many times the capacity doubles.
+	if (constantBufferOffsets && (device.getCreatedObjectCount() != 1
+		|| device.getReleasedObjectCount() != 1))
+	{
+		printf("%s: %u buffers created and %u released when growing, expected 1 and 1\n",
+			name, device.getCreatedObjectCount(), device.getReleasedObjectCount());
+		passed = false;
+	}
+
+	passed &= checkFrame(name, ring, device, allocations, constantBufferOffsets);
+
+	//The next frame fits.
+	device.clear();
+	passed &= writeFrame(ring, allocationCount, allocations);
+	if (ring.getCapacity() != expectedCapacity || device.getCreatedObjectCount() != 0)
+	{
+		printf("%s: Capacity %u with %u buffers created after growing, expected %u and"
+			" 0\n", name, ring.getCapacity(), device.getCreatedObjectCount(),
+			expectedCapacity);
+		passed = false;
+	}
+	passed &= checkFrame(name, ring, device, allocations, constantBufferOffsets);
+
+	return passed;
+}
+
+bool run(const char* name, bool constantBufferOffsets, const Options& options)
+{
+	bool passed = true;
+
+	bsNullRenderDevice nullDevice(constantBufferOffsets);
+	{
+		bsRecordingRenderDevice device(nullDevice);
+		bsConstantBufferRing ring(device, kInitialCapacity);
+
+		const unsigned int expectedCapacity =
+			constantBufferOffsets ? kInitialCapacity : 0;
+		if (ring.getCapacity() != expectedCapacity)
+		{
+			printf("%s: Initial capacity %u, expected %u\n", name, ring.getCapacity(),
+				expectedCapacity);
+			passed = false;
+		}
+
+		std::vector<bsConstantBufferRing::Allocation> allocations;
+
+		//A frame which fits, twice to check that the counts start over every frame.
+		const unsigned int smallAllocationCount =
+			kInitialCapacity / bsConstantBufferRing::kAlignment;
+		for (unsigned int i = 0; i < 2; ++i)
+		{
+			device.clear();
+			passed &= writeFrame(ring, smallAllocationCount, allocations);
+			passed &= checkFrame(name, ring, device, allocations, constantBufferOffsets);
+		}
+
+		passed &= checkGrowth(name, ring, device, constantBufferOffsets);
+
+		std::vector<double> frameTimes;
+		frameTimes.reserve(options.iterations);
+		for (unsigned int i = 0; i < options.iterations; ++i)
+		{
+			device.clear();
+
+			const long long startTicks = bsTimer::getTicks();
+			passed &= writeFrame(ring, options.allocationCount, allocations);
+			frameTimes.push_back(elapsedMilliSeconds(startTicks));
+		}
+		passed &= checkFrame(name, ring, device, allocations, constantBufferOffsets);
+
+		std::sort(frameTimes.begin(), frameTimes.end());
+		printf("%-12s %6u allocations: min %7.3f ms, median %7.3f ms, max %7.3f ms,"
+			" capacity %u KB, %u maps\n", name, options.allocationCount,
+			frameTimes.front(), frameTimes[frameTimes.size() / 2], frameTimes.back(),
+			ring.getCapacity() / 1024, ring.getMapCount());
+	}
+
+	if (nullDevice.getLiveObjectCount() != 0)
+	{
+		printf("%s: %u device objects were not released\n", name,
+			nullDevice.getLiveObjectCount());
+		passed = false;
+	}
+
+	return passed;
+}
+}
+
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!parseOptions(argc, argv, options))
+	{
+		printf("Usage: bsConstantBufferRingBenchmark [-allocations N] [-iterations N]\n");
+		return 1;
+	}
+
+	bool passed = run("Offsets", true, options);
+	passed &= run("No offsets", false, options);
+
+	printf(passed ? "All checks passed\n" : "Checks failed\n");
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+/*	Compares bsFlatHashMap with std::unordered_map at 1k, 100k and 1M entries.
+
+	For each size, both maps are filled with random 64 bit keys, then every key is looked
+	up, then as many keys which are not in the map are looked up, and finally every key is
+	erased. Times are per operation.
+
+	Windows only, like the engine. bsFlatHashMap is header only, but it asserts and
+	tracks its memory, so build together with bsLog.cpp, bsLogFormat.cpp, bsMemory.cpp
+	and bsMemoryTracker.cpp using the engine's include paths (for StdAfx.h), and link
+	TBB.
+*/
+
+#include <stdio.h>
+
+#include <unordered_map>
+#include <vector>
+
+#include "../bsFlatHashMap.h"
+#include "../bsRandomNumberGenerator.h"
+#include "../bsTimer.h"
+
+
+namespace
+{
+const unsigned int kEntryCounts[] = { 1000, 100000, 1000000 };
+
+//Repeats small sizes, so that every measurement does roughly the same amount of work.
+const unsigned int kOperationsPerMeasurement = 4000000;
+
+struct Timings
+{
+	double insert;
+	double findHit;
+	double findMiss;
+	double erase;
+};
+
+double nanoSecondsPerOperation(long long startTicks, unsigned int operationCount)
+{
+	return bsTimer::ticksToMicroSeconds(bsTimer::getTicks() - startTicks) * 1000.0
+		/ operationCount;
+}
+
+//Works for both map types, since bsFlatHashMap has the same interface.
+template <typename Map>
+Timings measure(const std::vector<unsigned long long>& keys,
+	const std::vector<unsigned long long>& missingKeys, unsigned int& checksum)
+{
+	const unsigned int entryCount = keys.size();
+	const unsigned int repetitions = kOperationsPerMeasurement / entryCount;
+	const unsigned int operationCount = repetitions * entryCount;
+
+	Timings timings = { 0.0, 0.0, 0.0, 0.0 };
+
+	for (unsigned int repetition = 0; repetition < repetitions; ++repetition)
+	{
+		Map map;
+
+		long long startTicks = bsTimer::getTicks();
+		for (unsigned int i = 0; i < entryCount; ++i)
+		{
+			map.insert(std::make_pair(keys[i], i));
+		}
+		timings.insert += nanoSecondsPerOperation(startTicks, operationCount);
+
+		startTicks = bsTimer::getTicks();
+		for (unsigned int i = 0; i < entryCount; ++i)
+		{
+			checksum += map.find(keys[i])->second;
+		}
+		timings.findHit += nanoSecondsPerOperation(startTicks, operationCount);
+
+		startTicks = bsTimer::getTicks();
+		for (unsigned int i = 0; i < entryCount; ++i)
+		{
+			checksum += map.find(missingKeys[i]) != map.end();
+		}
+		timings.findMiss += nanoSecondsPerOperation(startTicks, operationCount);
+
+		startTicks = bsTimer::getTicks();
+		for (unsigned int i = 0; i < entryCount; ++i)
+		{
+			checksum += map.erase(keys[i]);
+		}
+		timings.erase += nanoSecondsPerOperation(startTicks, operationCount);
+	}
+
+	return timings;
+}
+
+void printTimings(const char* name, const Timings& timings)
+{
+	printf("  %-20s insert %6.1f ns, find hit %6.1f ns, find miss %6.1f ns,"
+		" erase %6.1f ns\n", name, timings.insert, timings.findHit, timings.findMiss,
+		timings.erase);
+}
+}
+
+
+int main()
+{
+	bsRandomNumberGenerator random(1234);
+	unsigned int checksum = 0;
+
+	for (unsigned int i = 0; i < sizeof(kEntryCounts) / sizeof(kEntryCounts[0]); ++i)
+	{
+		const unsigned int entryCount = kEntryCounts[i];
+
+		//Odd keys are stored, even keys are guaranteed to be missing.
+		std::vector<unsigned long long> keys(entryCount);
+		std::vector<unsigned long long> missingKeys(entryCount);
+		for (unsigned int j = 0; j < entryCount; ++j)
+		{
+			const unsigned long long key = (static_cast<unsigned long long>(random.uint())
+				<< 32) | random.uint();
+			keys[j] = key | 1;
+			missingKeys[j] = key & ~1ULL;
+		}
+
+		printf("%u entries\n", entryCount);
+
+		printTimings("std::unordered_map", measure<std::unordered_map<unsigned long long,
+			unsigned int>>(keys, missingKeys, checksum));
+		printTimings("bsFlatHashMap", measure<bsFlatHashMap<unsigned long long,
+			unsigned int>>(keys, missingKeys, checksum));
+	}
+
+	//Printed so the lookups can't be optimized away.
+	printf("Checksum: %u\n", checksum);
+
+	return 0;
+}
@@ -0,0 +1,615 @@
+/*	Measures the CPU side of a frame on synthetic scenes, without a GPU or a window, and
+	writes the results as JSON for comparing runs, for example in continuous integration.
+
+	Stages measured for every scene size:
+	Transforms: Moving the root of every hierarchy, which resolves the world transforms
+		of all its descendants.
+	Cull: Frustum tests of every entity in a snapshot, see bsRenderBatcher::cull.
+	Batch: Grouping the visible entities by renderer and light type, see
+		bsRenderBatcher::batch.
+	Every scene is also saved as a frame capture and replayed once, which must cull and
+	batch to the same result (not measured, see bsFrameCapture.h).
+	And once, independent of scene size:
+	Mesh save/load: Saving a generated mesh with bsSaveSerializedMesh and loading it
+		again from disk and from memory.
+	Ini parse: Parsing a generated ini file with bsIniParser.
+
+	Scenes with 10k, 100k and 1M entities are measured by default. Options:
+	-entities N		Only measure a scene with N entities.
+	-renderers N	Distinct mesh renderers (mesh and material combinations). Default 256.
+	-depth N		Entities in each transform hierarchy, 1 for none. Default 4.
+	-lights N		Entities with a light, half point and half spot lights. Default 1024.
+	-threads N		Job system threads, including the main thread. Default: all.
+	-iterations N	Times every stage is measured. Default 10.
+	-output file	Where the results are written. Default "frame_pipeline.json".
+
+	Every result has the minimum, median and maximum time of a stage in milliseconds.
+	Compare medians between runs to find regressions.
+
+	Renderers and lights can't be created without a device, so the snapshot entities
+	refer to placeholder addresses instead. Batching only uses them as keys, so it does
+	the same work as it would with real components.
+
+	Build together with the engine's sources except main.cpp and Application.cpp, and
+	link the same libraries. No device or window is created.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <tbb/tbb_thread.h>
+
+//Declares the device types used by bsLight.h, no device is created.
+#include <d3d11.h>
+
+#include "../bsEntity.h"
+#include "../bsFrameCapture.h"
+#include "../bsFrameSnapshot.h"
+#include "../bsFrustum.h"
+#include "../bsIniParser.h"
+#include "../bsJobSystem.h"
+#include "../bsLight.h"
+#include "../bsMeshSerializer.h"
+#include "../bsRandomNumberGenerator.h"
+#include "../bsRenderBatcher.h"
+#include "../bsTimer.h"
+
+
+namespace
+{
+const unsigned int kDefaultEntityCounts[] = { 10000, 100000, 1000000 };
+
+//Entities are placed in a cube with sides this long, centered on the camera.
+const float kWorldSize = 1000.0f;
+
+//Size of the generated mesh and ini file.
+const unsigned int kSubMeshCount = 4;
+const unsigned int kVerticesPerSubMesh = 65536;
+const unsigned int kIniSectionCount = 2000;
+const unsigned int kIniPropertiesPerSection = 100;
+
+const char* const kMeshFileName = "frame_pipeline_benchmark.bsm";
+const char* const kCaptureFileName = "frame_pipeline_benchmark.bsfc";
+
+struct Options
+{
+	std::vector<unsigned int>	entityCounts;
+	unsigned int	rendererCount;
+	unsigned int	hierarchyDepth;
+	unsigned int	lightCount;
+	unsigned int	threadCount;
+	unsigned int	iterations;
+	std::string		outputFileName;
+};
+
+struct Result
+{
+	std::string		name;
+	//0 for stages that don't depend on the scene.
+	unsigned int	entityCount;
+	//Something the stage produced, like the number of visible entities, so that
+	//results with different outputs are not compared by mistake.
+	unsigned int	outputCount;
+	double			minMs;
+	double			medianMs;
+	double			maxMs;
+};
+
+double elapsedMilliSeconds(long long startTicks)
+{
+	return bsTimer::ticksToMicroSeconds(bsTimer::getTicks() - startTicks) * 0.001;
+}
+
+Result summarize(const char* name, unsigned int entityCount, unsigned int outputCount,
+	std::vector<double>& samples)
+{
+	std::sort(samples.begin(), samples.end());
+
+	Result result;
+	result.name = name;
+	result.entityCount = entityCount;
+	result.outputCount = outputCount;
+	result.minMs = samples.front();
+	result.medianMs = samples[samples.size() / 2];
+	result.maxMs = samples.back();
+
+	printf("%-16s %8u entities: min %9.3f ms, median %9.3f ms, max %9.3f ms (%u)\n",
+		name, entityCount, result.minMs, result.medianMs, result.maxMs, outputCount);
+
+	return result;
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+	options.rendererCount = 256;
+	options.hierarchyDepth = 4;
+	options.lightCount = 1024;
+	options.threadCount = std::max(tbb::tbb_thread::hardware_concurrency(), 1u);
+	options.iterations = 10;
+	options.outputFileName = "frame_pipeline.json";
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		const char* value = argv[i + 1];
+		const unsigned int number = strtoul(value, nullptr, 10);
+
+		if (strcmp(argv[i], "-entities") == 0)
+		{
+			options.entityCounts.push_back(number);
+		}
+		else if (strcmp(argv[i], "-renderers") == 0)
+		{
+			options.rendererCount = number;
+		}
+		else if (strcmp(argv[i], "-depth") == 0)
+		{
+			options.hierarchyDepth = number;
+		}
+		else if (strcmp(argv[i], "-lights") == 0)
+		{
+			options.lightCount = number;
+		}
+		else if (strcmp(argv[i], "-threads") == 0)
+		{
+			options.threadCount = number;
+		}
+		else if (strcmp(argv[i], "-iterations") == 0)
+		{
+			options.iterations = number;
+		}
+		else if (strcmp(argv[i], "-output") == 0)
+		{
+			options.outputFileName = value;
+		}
+		else
+		{
+			printf("Unknown option '%s'\n", argv[i]);
+			return false;
+		}
+	}
+
+	if (options.entityCounts.empty())
+	{
+		options.entityCounts.assign(kDefaultEntityCounts,
+			kDefaultEntityCounts + ARRAYSIZE(kDefaultEntityCounts));
+	}
+
+	return options.rendererCount > 0 && options.hierarchyDepth > 0
+		&& options.threadCount > 0 && options.iterations > 0;
+}
+
+
+/*	Entities in hierarchies of options.hierarchyDepth, each child a meter above its
+	parent, and a snapshot of them like the one bsFrameSnapshot::capture would make.
+*/
+class SyntheticScene
+{
+public:
+	SyntheticScene(unsigned int entityCount, const Options& options)
+		: mEntityCount(entityCount)
+		, mSnapshot(static_cast<bsEntitySnapshot*>(bsMemoryTracker::allocate(
+			sizeof(bsEntitySnapshot) * entityCount, __alignof(bsEntitySnapshot),
+			bsMemoryTracker::TAG_SCENE)))
+		//Placeholder components, only their addresses are used.
+		, mPlaceholders(options.rendererCount + options.lightCount)
+	{
+		bsRandomNumberGenerator random(entityCount);
+
+		mEntities.reserve(entityCount);
+		for (unsigned int i = 0; i < entityCount; ++i)
+		{
+			bsEntity* entity = new bsEntity();
+			bsTransform& transform = entity->getTransform();
+
+			if (i % options.hierarchyDepth == 0)
+			{
+				transform.setPosition(XMVectorScale(random.vector11(),
+					kWorldSize * 0.5f));
+				mRoots.push_back(entity);
+			}
+			else
+			{
+				transform.setParentTransform(&mEntities.back()->getTransform());
+				transform.setLocalPosition(XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+			}
+
+			mEntities.push_back(entity);
+		}
+
+		//Lights are spread evenly over the entities, renderers given to the rest.
+		const unsigned int lightCount = std::min(options.lightCount, entityCount);
+		const unsigned int lightSpacing = lightCount ? entityCount / lightCount : 0;
+		for (unsigned int i = 0; i < entityCount; ++i)
+		{
+			bsEntitySnapshot& snapshot = mSnapshot[i];
+			memset(&snapshot, 0, sizeof(snapshot));
+			snapshot.boundingSphere.positionAndRadius = XMVectorSet(0.0f, 0.0f, 0.0f,
+				random.range(0.5f, 5.0f));
+			snapshot.entity = mEntities[i];
+
+			const unsigned int lightIndex = lightSpacing ? i / lightSpacing : 0;
+			if (lightSpacing && i % lightSpacing == 0 && lightIndex < lightCount)
+			{
+				snapshot.light = reinterpret_cast<const bsLight*>(
+					&mPlaceholders[options.rendererCount + lightIndex]);
+				snapshot.lightType = static_cast<unsigned char>(lightIndex % 2
+					? bsLight::LT_SPOT : bsLight::LT_POINT);
+			}
+			else
+			{
+				snapshot.meshRenderer = reinterpret_cast<const bsMeshRenderer*>(
+					&mPlaceholders[random.uint() % options.rendererCount]);
+			}
+		}
+
+		copyTransforms();
+	}
+
+	~SyntheticScene()
+	{
+		//Entities delete their children.
+		for (size_t i = 0; i < mRoots.size(); ++i)
+		{
+			delete mRoots[i];
+		}
+
+		bsMemoryTracker::deallocate(mSnapshot);
+	}
+
+	//Moves every root, resolving the transforms of the whole hierarchy below it.
+	void moveRoots(float offset)
+	{
+		const XMVECTOR translation = XMVectorSet(offset, 0.0f, 0.0f, 0.0f);
+		for (size_t i = 0; i < mRoots.size(); ++i)
+		{
+			bsTransform& transform = mRoots[i]->getTransform();
+			transform.setPosition(XMVectorAdd(transform.getPosition(), translation));
+		}
+	}
+
+	//Copies the resolved transforms into the snapshot.
+	void copyTransforms()
+	{
+		for (unsigned int i = 0; i < mEntityCount; ++i)
+		{
+			const bsTransform& transform = mEntities[i]->getTransform();
+			bsEntitySnapshot& snapshot = mSnapshot[i];
+
+			snapshot.transposedTransform = transform.getTransposedTransform();
+			snapshot.position = transform.getPosition();
+			snapshot.rotation = transform.getRotation();
+		}
+	}
+
+	inline const bsEntitySnapshot* getSnapshot() const
+	{
+		return mSnapshot;
+	}
+
+	inline unsigned int getEntityCount() const
+	{
+		return mEntityCount;
+	}
+
+private:
+	//Non-copyable.
+	SyntheticScene(const SyntheticScene&);
+	SyntheticScene& operator=(const SyntheticScene&);
+
+	struct Placeholder
+	{
+		char	data[16];
+	};
+
+	const unsigned int		mEntityCount;
+	std::vector<bsEntity*>	mEntities;
+	std::vector<bsEntity*>	mRoots;
+	bsEntitySnapshot*		mSnapshot;
+
+	std::vector<Placeholder>	mPlaceholders;
+};
+
+/*	Saves the scene as a frame capture and replays it with a new batcher.
+	Returns false if the replay differs from what batcher produced for the scene.
+*/
+bool replayCapture(const SyntheticScene& scene, const bsFrustum& frustum,
+	const bsRenderBatcher& batcher, bsJobSystem& jobSystem)
+{
+	//The camera is in the middle of the scene, looking down the Z axis.
+	if (!bsSaveFrameCapture(kCaptureFileName, scene.getSnapshot(), scene.getEntityCount(),
+		XMMatrixIdentity(), XMVectorZero(), frustum, batcher))
+	{
+		return false;
+	}
+
+	bsFrameCapture capture;
+	const bool loaded = capture.load(kCaptureFileName);
+	remove(kCaptureFileName);
+	if (!loaded)
+	{
+		return false;
+	}
+
+	bsRenderBatcher replayBatcher(jobSystem);
+	replayBatcher.cullAndBatch(capture.getEntities(), capture.getEntityCount(),
+		capture.getFrustum());
+
+	const bsFrameCaptureHeader& header = capture.getHeader();
+	const bool identical = header.entityCount == scene.getEntityCount()
+		&& header.visibleEntityCount == replayBatcher.getBatchedEntityCount()
+		&& header.meshBatchCount == replayBatcher.getMeshBatches().size()
+		&& header.lineBatchCount == replayBatcher.getLineBatches().size()
+		&& header.pointLightCount == replayBatcher.getPointLights().size()
+		&& header.spotLightCount == replayBatcher.getSpotLights().size();
+	if (!identical)
+	{
+		printf("Replayed capture of %u entities differs: %u visible, captured %u\n",
+			scene.getEntityCount(), replayBatcher.getBatchedEntityCount(),
+			header.visibleEntityCount);
+	}
+
+	return identical;
+}
+
+//Returns false if the scene's frame capture did not replay identically.
+bool measureScene(unsigned int entityCount, const Options& options,
+	bsJobSystem& jobSystem, std::vector<Result>& results)
+{
+	SyntheticScene scene(entityCount, options);
+	bsRenderBatcher batcher(jobSystem);
+
+	//A camera in the middle of the scene, looking down the Z axis.
+	const bsFrustum frustum = bsTransformFrustum(bsComputeFrustumFromProjection(
+		XMMatrixPerspectiveFovLH(XMConvertToRadians(60.0f), 16.0f / 9.0f, 0.1f,
+		kWorldSize)), XMQuaternionIdentity(), XMVectorZero());
+
+	std::vector<const bsEntitySnapshot*> visibleEntities(entityCount);
+	unsigned int visibleEntityCount = 0;
+
+	std::vector<double> transformSamples;
+	std::vector<double> cullSamples;
+	std::vector<double> batchSamples;
+
+	for (unsigned int iteration = 0; iteration < options.iterations; ++iteration)
+	{
+		//Back and forth, so that the scene stays where it was generated.
+		long long startTicks = bsTimer::getTicks();
+		scene.moveRoots(iteration % 2 ? -1.0f : 1.0f);
+		transformSamples.push_back(elapsedMilliSeconds(startTicks));
+
+		scene.copyTransforms();
+
+		startTicks = bsTimer::getTicks();
+		visibleEntityCount = batcher.cull(scene.getSnapshot(), scene.getEntityCount(),
+			frustum, visibleEntities.data());
+		cullSamples.push_back(elapsedMilliSeconds(startTicks));
+
+		batcher.reset();
+		startTicks = bsTimer::getTicks();
+		batcher.batch(visibleEntities.data(), visibleEntityCount);
+		batchSamples.push_back(elapsedMilliSeconds(startTicks));
+	}
+
+	results.push_back(summarize("transforms", entityCount, entityCount,
+		transformSamples));
+	results.push_back(summarize("cull", entityCount, visibleEntityCount, cullSamples));
+	results.push_back(summarize("batch", entityCount,
+		batcher.getMeshBatches().size(), batchSamples));
+
+	//The batcher holds the last iteration's batches of the snapshot as it is now.
+	return replayCapture(scene, frustum, batcher, jobSystem);
+}
+
+
+//Generates a mesh laid out like bsLoadSerializedMeshFromMemory expects it.
+void generateMesh(bsSerializedMesh& mesh)
+{
+	const unsigned int indicesPerSubMesh = kVerticesPerSubMesh * 3;
+	const unsigned int dataSize = (sizeof(bsVertexBuffer) + sizeof(bsIndexBuffer)
+		+ sizeof(bsVertexNormalTangentTex) * kVerticesPerSubMesh
+		+ sizeof(unsigned int) * indicesPerSubMesh) * kSubMeshCount;
+
+	char* const data = static_cast<char*>(malloc(dataSize));
+	char* head = data;
+
+	mesh.bufferCount = kSubMeshCount;
+	mesh.vertexBuffers = reinterpret_cast<bsVertexBuffer*>(head);
+	head += sizeof(bsVertexBuffer) * kSubMeshCount;
+	mesh.indexBuffers = reinterpret_cast<bsIndexBuffer*>(head);
+	head += sizeof(bsIndexBuffer) * kSubMeshCount;
+
+	bsRandomNumberGenerator random(kSubMeshCount);
+	for (unsigned int i = 0; i < kSubMeshCount; ++i)
+	{
+		bsVertexBuffer& vertexBuffer = mesh.vertexBuffers[i];
+		vertexBuffer.vertexCount = kVerticesPerSubMesh;
+		vertexBuffer.vertices = reinterpret_cast<bsVertexNormalTangentTex*>(head);
+		head += sizeof(bsVertexNormalTangentTex) * kVerticesPerSubMesh;
+
+		for (unsigned int j = 0; j < kVerticesPerSubMesh; ++j)
+		{
+			bsVertexNormalTangentTex& vertex = vertexBuffer.vertices[j];
+			vertex.position = XMFLOAT3(random.float11(), random.float11(),
+				random.float11());
+			vertex.normal = XMFLOAT3(0.0f, 1.0f, 0.0f);
+			vertex.tangent = XMFLOAT3(1.0f, 0.0f, 0.0f);
+			vertex.textureCoord = XMFLOAT2(random.float01(), random.float01());
+		}
+
+		bsIndexBuffer& indexBuffer = mesh.indexBuffers[i];
+		indexBuffer.indexCount = indicesPerSubMesh;
+		indexBuffer.indices = reinterpret_cast<unsigned int*>(head);
+		head += sizeof(unsigned int) * indicesPerSubMesh;
+
+		for (unsigned int j = 0; j < indicesPerSubMesh; ++j)
+		{
+			indexBuffer.indices[j] = random.uint() % kVerticesPerSubMesh;
+		}
+	}
+
+	mesh.boundingSphereCenterAndRadius = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.75f);
+	mesh.dynamicData = data;
+	mesh.dynamicDataSize = dataSize;
+}
+
+bool measureMeshSerializer(const Options& options, std::vector<Result>& results)
+{
+	bsSerializedMesh mesh;
+	generateMesh(mesh);
+
+	std::vector<double> saveSamples;
+	std::vector<double> loadSamples;
+	std::vector<double> loadFromMemorySamples;
+	std::vector<char> fileData(mesh.dynamicDataSize + 16 + sizeof(XMFLOAT4));
+	bool identical = true;
+
+	for (unsigned int iteration = 0; iteration < options.iterations; ++iteration)
+	{
+		long long startTicks = bsTimer::getTicks();
+		bsSaveSerializedMesh(kMeshFileName, mesh);
+		saveSamples.push_back(elapsedMilliSeconds(startTicks));
+
+		bsSerializedMesh loadedMesh;
+		startTicks = bsTimer::getTicks();
+		identical &= bsLoadSerializedMesh(kMeshFileName, loadedMesh);
+		loadSamples.push_back(elapsedMilliSeconds(startTicks));
+		identical &= loadedMesh == mesh;
+
+#pragma warning (disable : 4996)//warning C4996: 'fopen' was declared deprecated
+		FILE* file = fopen(kMeshFileName, "rb");
+#pragma warning (default : 4996)
+		identical &= file != nullptr
+			&& fread(fileData.data(), fileData.size(), 1, file) == 1;
+		if (file)
+		{
+			fclose(file);
+		}
+
+		bsSerializedMesh meshFromMemory;
+		startTicks = bsTimer::getTicks();
+		identical &= bsLoadSerializedMeshFromMemory(fileData.data(), fileData.size(),
+			meshFromMemory);
+		loadFromMemorySamples.push_back(elapsedMilliSeconds(startTicks));
+	}
+
+	remove(kMeshFileName);
+
+	const unsigned int sizeKb = fileData.size() / 1024;
+	results.push_back(summarize("mesh save", 0, sizeKb, saveSamples));
+	results.push_back(summarize("mesh load", 0, sizeKb, loadSamples));
+	results.push_back(summarize("mesh load memory", 0, sizeKb, loadFromMemorySamples));
+
+	return identical;
+}
+
+void measureIniParser(const Options& options, std::vector<Result>& results)
+{
+	std::string ini;
+	ini.reserve(kIniSectionCount * kIniPropertiesPerSection * 32);
+
+	char line[128];
+	for (unsigned int i = 0; i < kIniSectionCount; ++i)
+	{
+		sprintf_s(line, "[section %u]\n; comment for section %u\n", i, i);
+		ini += line;
+
+		for (unsigned int j = 0; j < kIniPropertiesPerSection; ++j)
+		{
+			sprintf_s(line, "property%u = %u.%03u\n", j, i, j);
+			ini += line;
+		}
+	}
+
+	bsIniParser parser;
+	std::vector<double> samples;
+	for (unsigned int iteration = 0; iteration < options.iterations; ++iteration)
+	{
+		const long long startTicks = bsTimer::getTicks();
+		parser.parseData(ini.c_str(), ini.length());
+		samples.push_back(elapsedMilliSeconds(startTicks));
+	}
+
+	results.push_back(summarize("ini parse", 0, ini.length() / 1024, samples));
+}
+
+bool writeJson(const Options& options, const std::vector<Result>& results)
+{
+#pragma warning (disable : 4996)//warning C4996: 'fopen' was declared deprecated
+	FILE* file = fopen(options.outputFileName.c_str(), "w");
+#pragma warning (default : 4996)
+	if (!file)
+	{
+		return false;
+	}
+
+	fprintf(file, "{\n\t\"config\": {\"renderers\": %u, \"hierarchyDepth\": %u, "
+		"\"lights\": %u, \"threads\": %u, \"iterations\": %u},\n\t\"results\": [",
+		options.rendererCount, options.hierarchyDepth, options.lightCount,
+		options.threadCount, options.iterations);
+
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const Result& result = results[i];
+		fprintf(file, "%s\n\t\t{\"name\": \"%s\", \"entities\": %u, \"output\": %u, "
+			"\"minMs\": %.4f, \"medianMs\": %.4f, \"maxMs\": %.4f}", i ? "," : "",
+			result.name.c_str(), result.entityCount, result.outputCount, result.minMs,
+			result.medianMs, result.maxMs);
+	}
+	fprintf(file, "\n\t]\n}\n");
+
+	const bool success = ferror(file) == 0;
+	fclose(file);
+
+	return success;
+}
+}
+
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!parseOptions(argc, argv, options))
+	{
+		printf("Usage: bsFramePipelineBenchmark [-entities N]... [-renderers N]"
+			" [-depth N] [-lights N] [-threads N] [-iterations N] [-output file]\n");
+		return 1;
+	}
+
+	printf("%u renderers, hierarchy depth %u, %u lights, %u threads, %u iterations\n",
+		options.rendererCount, options.hierarchyDepth, options.lightCount,
+		options.threadCount, options.iterations);
+
+	std::vector<Result> results;
+	bool capturesIdentical = true;
+	{
+		bsJobSystem jobSystem(options.threadCount - 1);
+
+		for (size_t i = 0; i < options.entityCounts.size(); ++i)
+		{
+			capturesIdentical &= measureScene(options.entityCounts[i], options,
+				jobSystem, results);
+		}
+	}
+
+	const bool meshesIdentical = measureMeshSerializer(options, results);
+	if (!meshesIdentical)
+	{
+		printf("Loaded mesh differs from the saved mesh\n");
+	}
+
+	measureIniParser(options, results);
+
+	if (!writeJson(options, results))
+	{
+		printf("Failed to write results to '%s'\n", options.outputFileName.c_str());
+		return 1;
+	}
+	printf("Results written to '%s'\n", options.outputFileName.c_str());
+
+	return meshesIdentical && capturesIdentical ? 0 : 1;
+}
@@ -0,0 +1,451 @@
+/*	Renders frames with the deferred renderer on a bsNullRenderDevice, without a GPU or a
+	window, and checks the commands they issue through a bsRecordingRenderDevice.
+
+	The renderer, render queue and deferred renderer are created the same way bsCore
+	creates them, but on the headless bsDx11Renderer. The scene is a registered
+	bsFrameSnapshot of entities with generated meshes and lines, since a bsScene would
+	need physics. Shaders are compiled from the asset directory like in the engine.
+
+	Every frame must:
+	- Present once.
+	- Cull at least one entity as visible.
+	- Draw every visible mesh with one instanced draw, and every visible line and the two
+	  full screen passes (merge and FXAA) with one indexed draw.
+	- Map the constant buffer ring once with constant buffer offsets, or once per
+	  constant buffer bind without them.
+	- Not allocate from the heap on any thread, after the first kWarmUpFrameCount
+	  frames. Only checked in builds where bsAllocationCounter counts allocations.
+	And once everything has been destroyed, no device objects may be left.
+
+	Options:
+	-assets dir		Asset directory containing the shaders. Default "..\assets\".
+	-entities N		Entities with a mesh. Default 10000.
+	-meshes N		Distinct meshes. Default 64.
+	-lines N		Entities with a line. Default 64.
+	-threads N		Job system threads, including the main thread. Default: all.
+	-frames N		Frames rendered. Default 100.
+	-offsets N		1 to use constant buffer offsets, 0 for the D3D11.0 fallback.
+					Default 1.
+
+	Frame times include recording the commands. Exits with 1 if a check fails.
+
+	Build together with the engine's sources except main.cpp and Application.cpp, and
+	link the same libraries.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <tbb/tbb_thread.h>
+
+#include <d3d11.h>
+
+#include "../bsAllocationCounter.h"
+#include "../bsCamera.h"
+#include "../bsDeferredRenderer.h"
+#include "../bsDx11Renderer.h"
+#include "../bsEntity.h"
+#include "../bsFileSystem.h"
+#include "../bsFrameSnapshot.h"
+#include "../bsFrameStatistics.h"
+#include "../bsJobSystem.h"
+#include "../bsLineRenderer.h"
+#include "../bsMesh.h"
+#include "../bsMeshRenderer.h"
+#include "../bsNullRenderDevice.h"
+#include "../bsRandomNumberGenerator.h"
+#include "../bsRecordingRenderDevice.h"
+#include "../bsRenderQueue.h"
+#include "../bsShaderManager.h"
+#include "../bsTimer.h"
+#include "../bsVertexTypes.h"
+
+
+namespace
+{
+const unsigned int kBackBufferWidth = 1280;
+const unsigned int kBackBufferHeight = 720;
+
+//Entities are placed in a cube with sides this long, centered on the camera.
+const float kWorldSize = 200.0f;
+
+//Indexed draws done by every frame besides the lines, the merge and FXAA passes.
+const unsigned int kFullScreenDrawCount = 2;
+
+//Frames which may allocate while pools and containers grow to their steady state size.
+const unsigned int kWarmUpFrameCount = 2;
+
+struct Options
+{
+	std::string		assetDirectory;
+	unsigned int	entityCount;
+	unsigned int	meshCount;
+	unsigned int	lineCount;
+	unsigned int	threadCount;
+	unsigned int	frameCount;
+	bool			constantBufferOffsets;
+};
+
+double elapsedMilliSeconds(long long startTicks)
+{
+	return bsTimer::ticksToMicroSeconds(bsTimer::getTicks() - startTicks) * 0.001;
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+	options.assetDirectory = "..\\assets\\";
+	options.entityCount = 10000;
+	options.meshCount = 64;
+	options.lineCount = 64;
+	options.threadCount = std::max(tbb::tbb_thread::hardware_concurrency(), 1u);
+	options.frameCount = 100;
+	options.constantBufferOffsets = true;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		const char* value = argv[i + 1];
+		const unsigned int number = strtoul(value, nullptr, 10);
+
+		if (strcmp(argv[i], "-assets") == 0)
+		{
+			options.assetDirectory = value;
+		}
+		else if (strcmp(argv[i], "-entities") == 0)
+		{
+			options.entityCount = number;
+		}
+		else if (strcmp(argv[i], "-meshes") == 0)
+		{
+			options.meshCount = number;
+		}
+		else if (strcmp(argv[i], "-lines") == 0)
+		{
+			options.lineCount = number;
+		}
+		else if (strcmp(argv[i], "-threads") == 0)
+		{
+			options.threadCount = number;
+		}
+		else if (strcmp(argv[i], "-frames") == 0)
+		{
+			options.frameCount = number;
+		}
+		else if (strcmp(argv[i], "-offsets") == 0)
+		{
+			options.constantBufferOffsets = number != 0;
+		}
+		else
+		{
+			printf("Unknown option '%s'\n", argv[i]);
+			return false;
+		}
+	}
+
+	return options.entityCount > 0 && options.meshCount > 0 && options.threadCount > 0
+		&& options.frameCount > 0;
+}
+
+/*	A single triangle. The null device never reads the buffers, but they are created
+	like bsMeshCreator creates them, so the mesh is drawn like a loaded one.
+*/
+bsSharedMesh createTriangleMesh(bsRenderDevice& renderDevice, unsigned int id)
+{
+	bsVertexNormalTangentTex vertices[3];
+	memset(vertices, 0, sizeof(vertices));
+	vertices[0].position = XMFLOAT3(-1.0f, 0.0f, 0.0f);
+	vertices[1].position = XMFLOAT3(0.0f, 1.0f, 0.0f);
+	vertices[2].position = XMFLOAT3(1.0f, 0.0f, 0.0f);
+
+	const unsigned int indices[3] = { 0, 1, 2 };
+
+	D3D11_BUFFER_DESC bufferDescription;
+	memset(&bufferDescription, 0, sizeof(bufferDescription));
+	bufferDescription.Usage = D3D11_USAGE_DEFAULT;
+	bufferDescription.ByteWidth = sizeof(vertices);
+	bufferDescription.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+	D3D11_SUBRESOURCE_DATA initData;
+	memset(&initData, 0, sizeof(initData));
+	initData.pSysMem = vertices;
+
+	ID3D11Buffer* vertexBuffer = nullptr;
+	renderDevice.createBuffer(bufferDescription, &initData, &vertexBuffer);
+
+	bufferDescription.ByteWidth = sizeof(indices);
+	bufferDescription.BindFlags = D3D11_BIND_INDEX_BUFFER;
+	initData.pSysMem = indices;
+
+	ID3D11Buffer* indexBuffer = nullptr;
+	renderDevice.createBuffer(bufferDescription, &initData, &indexBuffer);
+
+	std::vector<ID3D11Buffer*> vertexBuffers(1, vertexBuffer);
+	std::vector<ID3D11Buffer*> indexBuffers(1, indexBuffer);
+	std::vector<unsigned int> indexCounts(1, 3);
+	std::vector<unsigned int> vertexCounts(1, 3);
+
+	bsCollision::Sphere boundingSphere;
+	boundingSphere.positionAndRadius = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+
+	return bsSharedMesh(new bsMesh(id, renderDevice, std::move(vertexBuffers),
+		std::move(indexBuffers), std::move(indexCounts), std::move(vertexCounts),
+		boundingSphere));
+}
+
+/*	Entities with meshes and lines scattered around the camera, and a snapshot of them.
+	The entities own their components, and must be destroyed before the renderer.
+*/
+class HeadlessScene
+{
+public:
+	HeadlessScene(bsDx11Renderer& renderer, bsJobSystem& jobSystem,
+		const Options& options)
+		: mCameraEntity(new bsEntity())
+		, mSnapshot(new bsFrameSnapshot())
+	{
+		bsRenderDevice& renderDevice = renderer.getRenderDevice();
+
+		const float aspectRatio = static_cast<float>(kBackBufferWidth)
+			/ static_cast<float>(kBackBufferHeight);
+		bsProjectionInfo projectionInfo(60.0f, 1000.0f, 0.1f, aspectRatio,
+			static_cast<float>(kBackBufferWidth), static_cast<float>(kBackBufferHeight));
+		mCamera = new bsCamera(projectionInfo, &renderer);
+		mCameraEntity->attachCamera(*mCamera);
+
+		std::vector<bsSharedMesh> meshes;
+		for (unsigned int i = 0; i < options.meshCount; ++i)
+		{
+			meshes.push_back(createTriangleMesh(renderDevice, i));
+		}
+
+		bsRandomNumberGenerator random(options.entityCount);
+
+		const unsigned int entityCount = options.entityCount + options.lineCount;
+		mEntities.reserve(entityCount);
+		for (unsigned int i = 0; i < entityCount; ++i)
+		{
+			bsEntity* entity = new bsEntity();
+			entity->getTransform().setPosition(XMVectorScale(random.vector11(),
+				kWorldSize * 0.5f));
+
+			if (i < options.entityCount)
+			{
+				entity->attachMeshRenderer(*new bsMeshRenderer(
+					meshes[random.uint() % options.meshCount], nullptr));
+			}
+			else
+			{
+				bsLineRenderer* line =
+					new bsLineRenderer(XMFLOAT4(1.0f, 0.0f, 0.0f, 1.0f));
+				line->addPoint(XMFLOAT3(-1.0f, 0.0f, 0.0f));
+				line->addPoint(XMFLOAT3(1.0f, 0.0f, 0.0f));
+				line->build(&renderer);
+
+				entity->attachLineRenderer(*line);
+			}
+
+			mEntities.push_back(entity);
+		}
+
+		mSnapshot->capture(mEntities, *mCamera, jobSystem);
+	}
+
+	~HeadlessScene()
+	{
+		delete mSnapshot;
+
+		for (size_t i = 0; i < mEntities.size(); ++i)
+		{
+			delete mEntities[i];
+		}
+		delete mCameraEntity;
+	}
+
+	inline bsCamera* getCamera() const
+	{
+		return mCamera;
+	}
+
+	inline const bsFrameSnapshot& getSnapshot() const
+	{
+		return *mSnapshot;
+	}
+
+private:
+	//Non-copyable.
+	HeadlessScene(const HeadlessScene&);
+	HeadlessScene& operator=(const HeadlessScene&);
+
+	std::vector<bsEntity*>	mEntities;
+	bsEntity*			mCameraEntity;
+	//Owned by mCameraEntity.
+	bsCamera*			mCamera;
+	bsFrameSnapshot*	mSnapshot;
+};
+
+//Prints every check that failed, returns true if none did.
+bool checkFrame(unsigned int frame, const bsRecordingRenderDevice& device,
+	const bsFrameStats& frameStats, bool constantBufferOffsets)
+{
+	bool passed = true;
+
+	const unsigned int presents =
+		device.getCommandCount(bsRecordingRenderDevice::PRESENT);
+	if (presents != 1)
+	{
+		printf("Frame %u: %u presents, expected 1\n", frame, presents);
+		passed = false;
+	}
+
+	if (frameStats.visibleEntityCount == 0)
+	{
+		printf("Frame %u: No visible entities\n", frame);
+		passed = false;
+	}
+
+	const unsigned int instancedDraws = device.getCommandCount(
+		bsRecordingRenderDevice::DRAW_INDEXED_INSTANCED);
+	if (instancedDraws != frameStats.uniqueMeshesDrawn)
+	{
+		printf("Frame %u: %u instanced draws, expected one for each of the %u meshes\n",
+			frame, instancedDraws, frameStats.uniqueMeshesDrawn);
+		passed = false;
+	}
+
+	const unsigned int indexedDraws = device.getCommandCount(
+		bsRecordingRenderDevice::DRAW_INDEXED);
+	if (indexedDraws != frameStats.linesDrawn + kFullScreenDrawCount)
+	{
+		printf("Frame %u: %u indexed draws, expected %u lines and %u full screen"
+			" passes\n", frame, indexedDraws, frameStats.linesDrawn,
+			kFullScreenDrawCount);
+		passed = false;
+	}
+
+	//Every mesh batch and line binds its constants once.
+	const unsigned int expectedMaps = constantBufferOffsets
+		? 1 : frameStats.uniqueMeshesDrawn + frameStats.linesDrawn;
+	const unsigned int maps = device.getCommandCount(bsRecordingRenderDevice::MAP_BUFFER);
+	if (maps != expectedMaps)
+	{
+		printf("Frame %u: %u constant buffer maps, expected %u\n", frame, maps,
+			expectedMaps);
+		passed = false;
+	}
+
+	if (frame >= kWarmUpFrameCount && frameStats.heapAllocations != 0)
+	{
+		printf("Frame %u: %u heap allocations, expected none after warm up\n", frame,
+			frameStats.heapAllocations);
+		passed = false;
+	}
+
+	return passed;
+}
+
+void printCommandCounts(const bsRecordingRenderDevice& device)
+{
+	for (unsigned int i = 0; i < bsRecordingRenderDevice::COMMAND_TYPE_COUNT; ++i)
+	{
+		const bsRecordingRenderDevice::CommandType type =
+			static_cast<bsRecordingRenderDevice::CommandType>(i);
+
+		if (device.getCommandCount(type) != 0)
+		{
+			printf("  %-32s %6u\n", bsRecordingRenderDevice::getCommandTypeName(type),
+				device.getCommandCount(type));
+		}
+	}
+	printf("  %-32s %6llu\n", "Updated bytes", device.getUpdatedByteCount());
+}
+}
+
+
+int main(int argc, char** argv)
+{
+	//Before the job system starts its threads.
+	bsAllocationCounter::install();
+
+	Options options;
+	if (!parseOptions(argc, argv, options))
+	{
+		printf("Usage: bsHeadlessFrameBenchmark [-assets dir] [-entities N] [-meshes N]"
+			" [-lines N] [-threads N] [-frames N] [-offsets 0|1]\n");
+		return 1;
+	}
+
+	printf("%u entities, %u meshes, %u lines, %u threads, %u frames, constant buffer"
+		" offsets %s\n", options.entityCount, options.meshCount, options.lineCount,
+		options.threadCount, options.frameCount,
+		options.constantBufferOffsets ? "on" : "off");
+	if (!bsAllocationCounter::isEnabled())
+	{
+		printf("Heap allocations are not counted in this build and won't be checked\n");
+	}
+
+	bsNullRenderDevice nullDevice(options.constantBufferOffsets);
+	bool passed = true;
+	{
+		bsRecordingRenderDevice recordingDevice(nullDevice);
+		bsJobSystem jobSystem(options.threadCount - 1);
+
+		bsDx11Renderer renderer(recordingDevice, kBackBufferWidth, kBackBufferHeight);
+
+		bsFileSystem fileSystem(options.assetDirectory);
+		bsShaderManager shaderManager(renderer, fileSystem,
+			options.assetDirectory + "shaders\\precompiled");
+
+		bsRenderQueue renderQueue(&renderer, &shaderManager, &jobSystem);
+		bsDeferredRenderer deferredRenderer(&renderer, &shaderManager, &renderQueue);
+
+		HeadlessScene scene(renderer, jobSystem, options);
+		renderQueue.setCamera(scene.getCamera());
+		renderQueue.registerSnapshot(scene.getSnapshot());
+
+		printf("Setup: %u objects created, %u commands\n",
+			recordingDevice.getCreatedObjectCount(),
+			static_cast<unsigned int>(recordingDevice.getCommands().size()));
+
+		bsFrameStatistics frameStatistics;
+		memset(&frameStatistics, 0, sizeof(frameStatistics));
+
+		std::vector<double> frameTimes;
+		frameTimes.reserve(options.frameCount);
+		for (unsigned int i = 0; i < options.frameCount; ++i)
+		{
+			recordingDevice.clear();
+
+			const long long startTicks = bsTimer::getTicks();
+			deferredRenderer.renderOneFrame(frameStatistics);
+			frameTimes.push_back(elapsedMilliSeconds(startTicks));
+
+			passed &= checkFrame(i, recordingDevice, renderQueue.getFrameStats(),
+				options.constantBufferOffsets);
+		}
+
+		const bsFrameStats& frameStats = renderQueue.getFrameStats();
+		printf("Last frame: %u visible entities, %u meshes, %u lines, %u commands\n",
+			frameStats.visibleEntityCount, frameStats.uniqueMeshesDrawn,
+			frameStats.linesDrawn,
+			static_cast<unsigned int>(recordingDevice.getCommands().size()));
+		printCommandCounts(recordingDevice);
+
+		std::sort(frameTimes.begin(), frameTimes.end());
+		printf("Frame: min %.3f ms, median %.3f ms, max %.3f ms\n", frameTimes.front(),
+			frameTimes[frameTimes.size() / 2], frameTimes.back());
+	}
+
+	if (nullDevice.getLiveObjectCount() != 0)
+	{
+		printf("%u device objects were not released\n", nullDevice.getLiveObjectCount());
+		passed = false;
+	}
+
+	printf(passed ? "All checks passed\n" : "Checks failed\n");
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+/*	Measures the effect of huge pages on frustum culling over structure of arrays entity
+	data with millions of entities.
+
+	Every entity has a bounding sphere, stored as separate x, y, z and radius arrays, and
+	the indices of the visible entities are written to an output array. All arrays are
+	allocated with bsMemory::allocateLarge, once with normal pages and once with huge
+	pages.
+	Culling is done in two orders: sequentially, and through a shuffled index array, the
+	way entities are reached through pointers in scene order. The shuffled order touches
+	a different page for almost every entity, which is where huge pages help the most.
+
+	Windows only, like the engine. Build together with bsMemory.cpp using the engine's
+	include paths (for StdAfx.h). The user needs the "Lock pages in memory" privilege
+	for huge pages to be used.
+*/
+
+#include <stdio.h>
+
+#include "../bsMemory.h"
+#include "../bsRandomNumberGenerator.h"
+#include "../bsTimer.h"
+
+
+namespace
+{
+const unsigned int kEntityCounts[] = { 1000000, 4000000, 16000000 };
+const unsigned int kIterations = 5;
+
+struct Plane
+{
+	float x, y, z, d;
+};
+
+//A frustum looking down the z axis, containing roughly a quarter of the entities.
+const Plane kFrustum[6] =
+{
+	{  0.7071f,  0.0f,    0.7071f, 0.0f },
+	{ -0.7071f,  0.0f,    0.7071f, 0.0f },
+	{  0.0f,     0.7071f, 0.7071f, 0.0f },
+	{  0.0f,    -0.7071f, 0.7071f, 0.0f },
+	{  0.0f,     0.0f,    1.0f,    -1.0f },
+	{  0.0f,     0.0f,   -1.0f,    1000.0f },
+};
+
+struct Entities
+{
+	float*			x;
+	float*			y;
+	float*			z;
+	float*			radius;
+
+	unsigned int*	shuffledIndices;
+	unsigned int*	visibleIndices;
+};
+
+inline bool isVisible(const Entities& entities, unsigned int index)
+{
+	const float x = entities.x[index];
+	const float y = entities.y[index];
+	const float z = entities.z[index];
+	const float negativeRadius = -entities.radius[index];
+
+	bool visible = true;
+	for (unsigned int i = 0; i < 6; ++i)
+	{
+		const Plane& plane = kFrustum[i];
+		visible &= plane.x * x + plane.y * y + plane.z * z + plane.d >= negativeRadius;
+	}
+
+	return visible;
+}
+
+unsigned int cullSequential(const Entities& entities, unsigned int entityCount)
+{
+	unsigned int visibleCount = 0;
+	for (unsigned int i = 0; i < entityCount; ++i)
+	{
+		entities.visibleIndices[visibleCount] = i;
+		visibleCount += isVisible(entities, i);
+	}
+
+	return visibleCount;
+}
+
+unsigned int cullShuffled(const Entities& entities, unsigned int entityCount)
+{
+	unsigned int visibleCount = 0;
+	for (unsigned int i = 0; i < entityCount; ++i)
+	{
+		const unsigned int index = entities.shuffledIndices[i];
+		entities.visibleIndices[visibleCount] = index;
+		visibleCount += isVisible(entities, index);
+	}
+
+	return visibleCount;
+}
+
+template <typename T>
+T* allocateArray(unsigned int count, bool useHugePages)
+{
+	return static_cast<T*>(bsMemory::allocateLarge(sizeof(T) * count, useHugePages));
+}
+
+//Returns milliseconds per pass for sequential and shuffled culling.
+void measure(unsigned int entityCount, bool useHugePages, double& sequentialMs,
+	double& shuffledMs, unsigned int& checksum)
+{
+	Entities entities;
+	entities.x = allocateArray<float>(entityCount, useHugePages);
+	entities.y = allocateArray<float>(entityCount, useHugePages);
+	entities.z = allocateArray<float>(entityCount, useHugePages);
+	entities.radius = allocateArray<float>(entityCount, useHugePages);
+	entities.shuffledIndices = allocateArray<unsigned int>(entityCount, useHugePages);
+	entities.visibleIndices = allocateArray<unsigned int>(entityCount, useHugePages);
+
+	//Same seed for both page sizes, so that both cull the same entities.
+	bsRandomNumberGenerator random(1234);
+	for (unsigned int i = 0; i < entityCount; ++i)
+	{
+		entities.x[i] = random.float11() * 1000.0f;
+		entities.y[i] = random.float11() * 1000.0f;
+		entities.z[i] = random.float11() * 1000.0f;
+		entities.radius[i] = random.float01() * 5.0f;
+		entities.shuffledIndices[i] = i;
+	}
+
+	for (unsigned int i = entityCount - 1; i > 0; --i)
+	{
+		const unsigned int j = random.uint() % (i + 1);
+		const unsigned int temp = entities.shuffledIndices[i];
+		entities.shuffledIndices[i] = entities.shuffledIndices[j];
+		entities.shuffledIndices[j] = temp;
+	}
+
+	//Warm up, so that every page has been touched before measuring.
+	checksum += cullSequential(entities, entityCount);
+
+	long long startTicks = bsTimer::getTicks();
+	for (unsigned int i = 0; i < kIterations; ++i)
+	{
+		checksum += cullSequential(entities, entityCount);
+	}
+	sequentialMs = bsTimer::ticksToMicroSeconds(bsTimer::getTicks() - startTicks) * 0.001
+		/ kIterations;
+
+	startTicks = bsTimer::getTicks();
+	for (unsigned int i = 0; i < kIterations; ++i)
+	{
+		checksum += cullShuffled(entities, entityCount);
+	}
+	shuffledMs = bsTimer::ticksToMicroSeconds(bsTimer::getTicks() - startTicks) * 0.001
+		/ kIterations;
+
+	bsMemory::freeLarge(entities.x);
+	bsMemory::freeLarge(entities.y);
+	bsMemory::freeLarge(entities.z);
+	bsMemory::freeLarge(entities.radius);
+	bsMemory::freeLarge(entities.shuffledIndices);
+	bsMemory::freeLarge(entities.visibleIndices);
+}
+}
+
+
+int main()
+{
+	const size_t hugePageSize = bsMemory::getHugePageSize();
+	if (hugePageSize == 0)
+	{
+		printf("Huge pages are not available, both runs will use normal pages\n");
+	}
+	else
+	{
+		printf("Huge page size: %u KB\n", static_cast<unsigned int>(hugePageSize / 1024));
+	}
+
+	unsigned int checksum = 0;
+
+	for (unsigned int i = 0; i < sizeof(kEntityCounts) / sizeof(kEntityCounts[0]); ++i)
+	{
+		const unsigned int entityCount = kEntityCounts[i];
+
+		double sequentialMs, shuffledMs, hugeSequentialMs, hugeShuffledMs;
+		measure(entityCount, false, sequentialMs, shuffledMs, checksum);
+		measure(entityCount, true, hugeSequentialMs, hugeShuffledMs, checksum);
+
+		printf("%u entities (%u MB)\n", entityCount,
+			static_cast<unsigned int>(entityCount * 24ULL / (1024 * 1024)));
+		printf("  sequential: normal pages %8.2f ms, huge pages %8.2f ms (%.2fx)\n",
+			sequentialMs, hugeSequentialMs, sequentialMs / hugeSequentialMs);
+		printf("  shuffled:   normal pages %8.2f ms, huge pages %8.2f ms (%.2fx)\n",
+			shuffledMs, hugeShuffledMs, shuffledMs / hugeShuffledMs);
+	}
+
+	//Printed so the culling can't be optimized away.
+	printf("Checksum: %u\n", checksum);
+
+	return 0;
+}
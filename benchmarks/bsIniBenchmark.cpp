@@ -0,0 +1,203 @@
+/*	Compares bsIniParser with a reference parser that works like the previous
+	implementation: copy the whole buffer into a std::stringstream, split it into a
+	vector of std::string lines and store every name and value as a std::string in
+	nested std::unordered_maps.
+
+	Parses a generated multi-megabyte ini file several times with each parser, then
+	looks up every property by name.
+
+	Windows only, like the engine. Build together with bsIniParser.cpp, bsLog.cpp,
+	bsLogFormat.cpp, bsMemory.cpp and bsMemoryTracker.cpp using the engine's include
+	paths (for StdAfx.h), and link TBB.
+*/
+
+#include <stdio.h>
+
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../bsIniParser.h"
+#include "../bsTimer.h"
+
+
+namespace
+{
+const unsigned int kSectionCount = 2000;
+const unsigned int kPropertiesPerSection = 100;
+const unsigned int kIterations = 5;
+
+typedef std::unordered_map<std::string, std::string> ReferenceSection;
+typedef std::unordered_map<std::string, ReferenceSection> ReferenceSections;
+
+void referenceParse(const char* data, size_t dataSizeBytes, ReferenceSections& sections)
+{
+	sections.clear();
+
+	std::vector<std::string> lines;
+	std::stringstream ss(std::string(data, data + dataSizeBytes));
+	std::string line;
+	while (std::getline(ss, line))
+	{
+		lines.push_back(line);
+	}
+
+	std::string sectionName;
+	ReferenceSection currentSection;
+	for (size_t i = 0; i < lines.size(); ++i)
+	{
+		const std::string& currentLine = lines[i];
+		if (currentLine.empty() || currentLine[0] == ';' || currentLine[0] == ' '
+			|| currentLine[0] == '\t')
+		{
+			continue;
+		}
+
+		if (currentLine[0] == '[')
+		{
+			const size_t endBracket = currentLine.find(']');
+			if (endBracket != std::string::npos && endBracket > 1)
+			{
+				if (!currentSection.empty())
+				{
+					sections.insert(std::make_pair(sectionName, currentSection));
+					currentSection.clear();
+				}
+				sectionName = currentLine.substr(1, endBracket - 1);
+			}
+		}
+		else
+		{
+			const size_t equals = currentLine.find('=');
+			if (equals != std::string::npos)
+			{
+				std::string name = currentLine.substr(0, equals);
+				std::string value = currentLine.substr(equals + 1);
+				while (!name.empty() && (name.back() == ' ' || name.back() == '\t'))
+				{
+					name.pop_back();
+				}
+				while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+				{
+					value.pop_back();
+				}
+				const size_t firstNonWhitespace = value.find_first_not_of(" \t");
+				value.erase(0, firstNonWhitespace == std::string::npos ? value.length()
+					: firstNonWhitespace);
+
+				if (!name.empty() && !value.empty())
+				{
+					currentSection.insert(std::make_pair(name, value));
+				}
+			}
+		}
+	}
+
+	if (!currentSection.empty())
+	{
+		sections.insert(std::make_pair(sectionName, currentSection));
+	}
+}
+
+std::string generateIni()
+{
+	std::string ini;
+	ini.reserve(kSectionCount * kPropertiesPerSection * 32);
+
+	char line[128];
+	for (unsigned int i = 0; i < kSectionCount; ++i)
+	{
+		sprintf_s(line, "[section %u]\n; comment for section %u\n", i, i);
+		ini += line;
+
+		for (unsigned int j = 0; j < kPropertiesPerSection; ++j)
+		{
+			sprintf_s(line, "property%u = %u.%03u\n", j, i, j);
+			ini += line;
+		}
+	}
+
+	return ini;
+}
+
+double elapsedMilliSeconds(long long startTicks)
+{
+	return bsTimer::ticksToMicroSeconds(bsTimer::getTicks() - startTicks) * 0.001;
+}
+}
+
+
+int main()
+{
+	const std::string ini = generateIni();
+	printf("Parsing %u KB, %u sections with %u properties each, %u iterations\n",
+		ini.length() / 1024, kSectionCount, kPropertiesPerSection, kIterations);
+
+	//Section and property names to look up.
+	std::vector<std::string> sectionNames(kSectionCount);
+	std::vector<std::string> propertyNames(kPropertiesPerSection);
+	char name[64];
+	for (unsigned int i = 0; i < kSectionCount; ++i)
+	{
+		sprintf_s(name, "section %u", i);
+		sectionNames[i] = name;
+	}
+	for (unsigned int i = 0; i < kPropertiesPerSection; ++i)
+	{
+		sprintf_s(name, "property%u", i);
+		propertyNames[i] = name;
+	}
+
+	//Reference.
+	ReferenceSections referenceSections;
+	long long startTicks = bsTimer::getTicks();
+	for (unsigned int i = 0; i < kIterations; ++i)
+	{
+		referenceParse(ini.c_str(), ini.length(), referenceSections);
+	}
+	const double referenceParseTime = elapsedMilliSeconds(startTicks) / kIterations;
+
+	unsigned int referenceFound = 0;
+	startTicks = bsTimer::getTicks();
+	for (unsigned int i = 0; i < kSectionCount; ++i)
+	{
+		//Lookups with const char*, constructing temporary strings like most callers would.
+		auto section = referenceSections.find(sectionNames[i].c_str());
+		for (unsigned int j = 0; j < kPropertiesPerSection; ++j)
+		{
+			referenceFound += section->second.find(propertyNames[j].c_str())
+				!= section->second.end();
+		}
+	}
+	const double referenceLookupTime = elapsedMilliSeconds(startTicks);
+
+	//bsIniParser.
+	bsIniParser parser;
+	startTicks = bsTimer::getTicks();
+	for (unsigned int i = 0; i < kIterations; ++i)
+	{
+		parser.parseData(ini.c_str(), ini.length());
+	}
+	const double parseTime = elapsedMilliSeconds(startTicks) / kIterations;
+
+	unsigned int found = 0;
+	startTicks = bsTimer::getTicks();
+	for (unsigned int i = 0; i < kSectionCount; ++i)
+	{
+		const bsIniSection* section = parser.getSection(sectionNames[i].c_str());
+		for (unsigned int j = 0; j < kPropertiesPerSection; ++j)
+		{
+			found += section->getProperty(propertyNames[j].c_str()) != nullptr;
+		}
+	}
+	const double lookupTime = elapsedMilliSeconds(startTicks);
+
+	printf("Reference:   parse %8.2f ms, lookup %8.2f ms, found %u\n", referenceParseTime,
+		referenceLookupTime, referenceFound);
+	printf("bsIniParser: parse %8.2f ms, lookup %8.2f ms, found %u\n", parseTime,
+		lookupTime, found);
+	printf("Parse speedup: %.1fx\n", referenceParseTime / parseTime);
+
+	return found == referenceFound ? 0 : 1;
+}
@@ -0,0 +1,252 @@
+/*	Measures how bsJobSystem scales from 1 to 32 threads.
+
+	Three workloads are run with every thread count:
+	- Culling: a parallelFor testing 1M bounding spheres against a frustum, writing one
+	  visibility flag per sphere, like bsRenderQueue does.
+	- Transform graph: 8 stages over 1M transforms, each stage split into jobs which depend
+	  on the previous stage's counter, so the stages form a chain of job graphs.
+	- Small jobs: 4000 jobs which do almost nothing, measuring the overhead per job.
+
+	The thread count includes the main thread, which runs jobs while it waits. Counts
+	above the number of hardware threads show the cost of oversubscription.
+
+	Build together with bsJobSystem.cpp, bsProfiler.cpp, bsThreadPlacement.cpp and
+	bsCpuTopology.cpp.
+*/
+
+#include <stdio.h>
+
+#include <math.h>
+
+#include <vector>
+
+#include "../bsJobSystem.h"
+#include "../bsRandomNumberGenerator.h"
+#include "../bsTimer.h"
+
+
+namespace
+{
+const unsigned int kThreadCounts[] = { 1, 2, 4, 8, 16, 32 };
+const unsigned int kIterations = 20;
+
+const unsigned int kSphereCount = 1000000;
+const unsigned int kCullingGrainSize = 1024;
+
+const unsigned int kTransformCount = 1000000;
+const unsigned int kStageCount = 8;
+const unsigned int kTransformGrainSize = 4096;
+
+const unsigned int kSmallJobCount = 4000;
+
+struct Plane
+{
+	float x, y, z, d;
+};
+
+//A frustum looking down the z axis, containing roughly a quarter of the spheres.
+const Plane kFrustum[6] =
+{
+	{  0.7071f,  0.0f,    0.7071f, 0.0f },
+	{ -0.7071f,  0.0f,    0.7071f, 0.0f },
+	{  0.0f,     0.7071f, 0.7071f, 0.0f },
+	{  0.0f,    -0.7071f, 0.7071f, 0.0f },
+	{  0.0f,     0.0f,    1.0f,    -1.0f },
+	{  0.0f,     0.0f,   -1.0f,    1000.0f },
+};
+
+struct Sphere
+{
+	float x, y, z, radius;
+};
+
+//Position and rotation angle, rotated and moved a little by every stage.
+struct Transform
+{
+	float x, y, z, angle;
+};
+
+struct Stage
+{
+	Transform*	transforms;
+	float		step;
+};
+
+struct Timings
+{
+	double culling;
+	double transformGraph;
+	double smallJobs;
+};
+
+
+void cullSpheres(const Sphere* spheres, unsigned char* visible, unsigned int begin,
+	unsigned int end)
+{
+	for (unsigned int i = begin; i < end; ++i)
+	{
+		const Sphere& sphere = spheres[i];
+		bool inside = true;
+
+		for (unsigned int j = 0; j < 6 && inside; ++j)
+		{
+			const Plane& plane = kFrustum[j];
+			inside = plane.x * sphere.x + plane.y * sphere.y + plane.z * sphere.z + plane.d
+				>= -sphere.radius;
+		}
+
+		visible[i] = inside;
+	}
+}
+
+void updateTransforms(void* data, unsigned int begin, unsigned int end)
+{
+	const Stage& stage = *static_cast<const Stage*>(data);
+
+	for (unsigned int i = begin; i < end; ++i)
+	{
+		Transform& transform = stage.transforms[i];
+		transform.angle += stage.step;
+
+		const float sine = sinf(transform.angle);
+		const float cosine = cosf(transform.angle);
+		const float x = transform.x * cosine - transform.z * sine;
+		const float z = transform.x * sine + transform.z * cosine;
+
+		transform.x = x + stage.step;
+		transform.y += stage.step;
+		transform.z = z;
+	}
+}
+
+void emptyJob(void* data, unsigned int begin, unsigned int)
+{
+	static_cast<unsigned char*>(data)[begin] = 1;
+}
+
+double elapsedMilliSeconds(long long startTicks)
+{
+	return bsTimer::ticksToMicroSeconds(bsTimer::getTicks() - startTicks) * 0.001;
+}
+
+Timings measure(unsigned int threadCount, const std::vector<Sphere>& spheres,
+	std::vector<Transform>& transforms, unsigned int& checksum)
+{
+	bsJobSystem jobSystem(threadCount - 1);
+
+	std::vector<unsigned char> visible(kSphereCount);
+	std::vector<unsigned char> smallJobOutput(kSmallJobCount);
+	Timings timings = { 0.0, 0.0, 0.0 };
+
+	for (unsigned int iteration = 0; iteration < kIterations; ++iteration)
+	{
+		//Culling.
+		long long startTicks = bsTimer::getTicks();
+
+		const Sphere* sphereData = spheres.data();
+		unsigned char* visibleData = visible.data();
+		jobSystem.parallelFor(kSphereCount, kCullingGrainSize,
+			[=](unsigned int begin, unsigned int end)
+		{
+			cullSpheres(sphereData, visibleData, begin, end);
+		});
+
+		timings.culling += elapsedMilliSeconds(startTicks);
+
+		for (unsigned int i = 0; i < kSphereCount; ++i)
+		{
+			checksum += visible[i];
+		}
+
+		//Transform graph, every stage waits for the whole previous stage.
+		startTicks = bsTimer::getTicks();
+
+		Stage stages[kStageCount];
+		bsJobCounter counters[kStageCount];
+		for (unsigned int i = 0; i < kStageCount; ++i)
+		{
+			stages[i].transforms = transforms.data();
+			stages[i].step = 0.001f * (i + 1);
+
+			jobSystem.runRange(&updateTransforms, &stages[i], kTransformCount,
+				kTransformGrainSize, counters[i], i != 0 ? &counters[i - 1] : nullptr);
+		}
+
+		//Waiting for the last stage implies the others, but counters must be done before
+		//they are destroyed.
+		for (unsigned int i = kStageCount; i > 0; --i)
+		{
+			jobSystem.wait(counters[i - 1]);
+		}
+
+		timings.transformGraph += elapsedMilliSeconds(startTicks);
+
+		//Small jobs.
+		startTicks = bsTimer::getTicks();
+
+		bsJobCounter smallJobs;
+		jobSystem.runRange(&emptyJob, smallJobOutput.data(), kSmallJobCount, 1, smallJobs);
+		jobSystem.wait(smallJobs);
+
+		timings.smallJobs += elapsedMilliSeconds(startTicks);
+
+		checksum += smallJobOutput[iteration % kSmallJobCount];
+	}
+
+	timings.culling /= kIterations;
+	timings.transformGraph /= kIterations;
+	timings.smallJobs /= kIterations;
+
+	return timings;
+}
+}
+
+
+int main()
+{
+	bsRandomNumberGenerator random(1234);
+
+	std::vector<Sphere> spheres(kSphereCount);
+	for (unsigned int i = 0; i < kSphereCount; ++i)
+	{
+		spheres[i].x = random.float11() * 500.0f;
+		spheres[i].y = random.float11() * 500.0f;
+		spheres[i].z = random.float01() * 1000.0f;
+		spheres[i].radius = random.float01() * 5.0f;
+	}
+
+	std::vector<Transform> transforms(kTransformCount);
+	for (unsigned int i = 0; i < kTransformCount; ++i)
+	{
+		transforms[i].x = random.float11() * 100.0f;
+		transforms[i].y = random.float11() * 100.0f;
+		transforms[i].z = random.float11() * 100.0f;
+		transforms[i].angle = random.float11();
+	}
+
+	printf("%u spheres, %u transforms in %u stages, %u small jobs, %u iterations\n",
+		kSphereCount, kTransformCount, kStageCount, kSmallJobCount, kIterations);
+	printf("Threads     Culling    Speedup   Transforms    Speedup   Small jobs\n");
+
+	unsigned int checksum = 0;
+	Timings singleThreaded = { 0.0, 0.0, 0.0 };
+
+	for (unsigned int i = 0; i < sizeof(kThreadCounts) / sizeof(kThreadCounts[0]); ++i)
+	{
+		const Timings timings = measure(kThreadCounts[i], spheres, transforms, checksum);
+		if (i == 0)
+		{
+			singleThreaded = timings;
+		}
+
+		printf("%7u %8.2f ms %9.2fx %9.2f ms %9.2fx %9.1f us/job\n", kThreadCounts[i],
+			timings.culling, singleThreaded.culling / timings.culling,
+			timings.transformGraph, singleThreaded.transformGraph / timings.transformGraph,
+			timings.smallJobs * 1000.0 / kSmallJobCount);
+	}
+
+	//Printed so the work can't be optimized away.
+	printf("Checksum: %u\n", checksum);
+
+	return 0;
+}
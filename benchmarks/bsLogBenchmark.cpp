@@ -0,0 +1,91 @@
+/*	Measures how many messages per second bsLog accepts from several threads logging at
+	the same time, and how many were dropped because the writer could not keep up.
+
+	Build together with bsLog.cpp and TBB, and run from a writable directory.
+*/
+
+#include <stdio.h>
+
+#include <Windows.h>
+
+#include <tbb/tbb_thread.h>
+#include <tbb/atomic.h>
+
+#include "../bsLog.h"
+#include "../bsTimer.h"
+
+
+namespace
+{
+const unsigned int kThreadCount = 8;
+const unsigned int kMessagesPerThread = 200000;
+
+tbb::atomic<int> gStart;
+
+void logMessages(unsigned int threadIndex)
+{
+	while (!gStart)
+	{
+		SwitchToThread();
+	}
+
+	for (unsigned int i = 0; i < kMessagesPerThread; ++i)
+	{
+		bsLog::logf(bsLog::SEV_INFO, "Thread %u logging message %u with value %f",
+			threadIndex, i, i * 0.5f);
+	}
+}
+}
+
+
+int main()
+{
+#pragma warning (disable : 4996)//warning C4996: 'fopen' was declared deprecated
+	FILE* file = fopen("bsLogBenchmark.log", "w");
+#pragma warning (default : 4996)
+	if (!file)
+	{
+		printf("Failed to open log file\n");
+		return 1;
+	}
+
+	bsLog::init(file, bsLog::SEV_DEBUG, bsLog::TIMESTAMP_MILLISECS | bsLog::THREAD_ID_ENABLED);
+
+	gStart = 0;
+	tbb::tbb_thread* threads[kThreadCount];
+	for (unsigned int i = 0; i < kThreadCount; ++i)
+	{
+		threads[i] = new tbb::tbb_thread(&logMessages, i);
+	}
+
+	const long long startTicks = bsTimer::getTicks();
+	gStart = 1;
+
+	for (unsigned int i = 0; i < kThreadCount; ++i)
+	{
+		threads[i]->join();
+		delete threads[i];
+	}
+
+	const long long loggedTicks = bsTimer::getTicks();
+
+	bsLog::flush();
+
+	const long long flushedTicks = bsTimer::getTicks();
+
+	const double loggedSeconds = bsTimer::ticksToMicroSeconds(loggedTicks - startTicks) * 1e-6;
+	const double flushedSeconds = bsTimer::ticksToMicroSeconds(flushedTicks - startTicks) * 1e-6;
+	const unsigned int messageCount = kThreadCount * kMessagesPerThread;
+	const unsigned int droppedCount = bsLog::getDroppedMessageCount();
+
+	printf("%u threads, %u messages\n", kThreadCount, messageCount);
+	printf("Logging:  %.3f s, %.0f messages/s per producer thread\n", loggedSeconds,
+		kMessagesPerThread / loggedSeconds);
+	printf("Written:  %.3f s, %.0f messages/s\n", flushedSeconds,
+		(messageCount - droppedCount) / flushedSeconds);
+	printf("Dropped:  %u (%.2f%%)\n", droppedCount, 100.0 * droppedCount / messageCount);
+
+	bsLog::deinit();
+
+	return 0;
+}
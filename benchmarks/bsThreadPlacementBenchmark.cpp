@@ -0,0 +1,285 @@
+/*	Measures how thread placement affects frame times when the job system, physics and
+	background threads are busy at the same time.
+
+	Every frame starts a physics step on the physics threads, like a pipelined simulation
+	step running on the simulation thread and Havok's workers, and then culls spheres in
+	a parallelFor on the job system. The frame ends when both are done. A background
+	thread copies memory in bursts the whole time, standing in for file IO.
+
+	Thread counts are the defaults of each policy, like bsCore picks them. Without
+	placement they are sized to the logical processors, so the job workers and physics
+	threads oversubscribe the machine. The mean, standard deviation, 99th percentile and
+	worst frame time are printed for each policy.
+
+	Build together with bsJobSystem.cpp, bsProfiler.cpp, bsCpuTopology.cpp and
+	bsThreadPlacement.cpp.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <math.h>
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include <tbb/atomic.h>
+#include <tbb/tbb_thread.h>
+
+#include "../bsJobSystem.h"
+#include "../bsCpuTopology.h"
+#include "../bsThreadPlacement.h"
+#include "../bsRandomNumberGenerator.h"
+#include "../bsTimer.h"
+
+
+namespace
+{
+const unsigned int kFrameCount = 500;
+const unsigned int kWarmupFrameCount = 20;
+
+const unsigned int kSphereCount = 500000;
+const unsigned int kCullingGrainSize = 1024;
+
+//Iterations of the physics work per thread per frame.
+const unsigned int kPhysicsWork = 200000;
+
+const unsigned int kBackgroundCopySize = 4 * 1024 * 1024;
+
+struct Sphere
+{
+	float x, y, z, radius;
+};
+
+struct PhysicsState
+{
+	//Incremented by the main thread to start a step.
+	tbb::atomic<unsigned int>	frame;
+	//Threads which have finished the current step.
+	tbb::atomic<unsigned int>	finished;
+	tbb::atomic<bool>			quit;
+};
+
+struct Statistics
+{
+	double mean;
+	double standardDeviation;
+	double percentile99;
+	double worst;
+};
+
+unsigned int cullSpheres(const Sphere* spheres, unsigned char* visible,
+	unsigned int begin, unsigned int end)
+{
+	unsigned int visibleCount = 0;
+	for (unsigned int i = begin; i < end; ++i)
+	{
+		const Sphere& sphere = spheres[i];
+		visible[i] = sphere.z + sphere.radius > 0.0f
+			&& fabsf(sphere.x) - sphere.radius < sphere.z
+			&& fabsf(sphere.y) - sphere.radius < sphere.z;
+		visibleCount += visible[i];
+	}
+
+	return visibleCount;
+}
+
+//Does a fixed amount of floating point work, like a slice of a physics step.
+float simulateStep(float seed)
+{
+	float value = seed;
+	for (unsigned int i = 0; i < kPhysicsWork; ++i)
+	{
+		value = value * 0.9999f + sqrtf(value + static_cast<float>(i & 15));
+	}
+
+	return value;
+}
+
+void physicsThreadLoop(PhysicsState* state, float* result)
+{
+	unsigned int lastFrame = 0;
+
+	while (!state->quit)
+	{
+		const unsigned int frame = state->frame;
+		if (frame == lastFrame)
+		{
+			tbb::this_tbb_thread::yield();
+			continue;
+		}
+
+		lastFrame = frame;
+		*result += simulateStep(static_cast<float>(frame));
+		++state->finished;
+	}
+}
+
+void backgroundThreadLoop(PhysicsState* state, unsigned int* checksum)
+{
+	std::vector<unsigned char> source(kBackgroundCopySize, 1);
+	std::vector<unsigned char> destination(kBackgroundCopySize);
+
+	while (!state->quit)
+	{
+		memcpy(destination.data(), source.data(), kBackgroundCopySize);
+		*checksum += destination[*checksum % kBackgroundCopySize];
+
+		Sleep(1);
+	}
+}
+
+Statistics computeStatistics(std::vector<double>& frameTimes)
+{
+	Statistics statistics;
+
+	double sum = 0.0;
+	for (size_t i = 0; i < frameTimes.size(); ++i)
+	{
+		sum += frameTimes[i];
+	}
+	statistics.mean = sum / frameTimes.size();
+
+	double squaredDifferences = 0.0;
+	for (size_t i = 0; i < frameTimes.size(); ++i)
+	{
+		const double difference = frameTimes[i] - statistics.mean;
+		squaredDifferences += difference * difference;
+	}
+	statistics.standardDeviation = sqrt(squaredDifferences / frameTimes.size());
+
+	std::sort(frameTimes.begin(), frameTimes.end());
+	statistics.percentile99 = frameTimes[frameTimes.size() * 99 / 100];
+	statistics.worst = frameTimes.back();
+
+	return statistics;
+}
+
+Statistics measure(const bsThreadPlacement& placement, const std::vector<Sphere>& spheres,
+	unsigned int& checksum)
+{
+	const unsigned int jobWorkerCount = placement.getDefaultJobWorkerCount();
+	//The simulation thread and Havok's workers.
+	const unsigned int physicsThreadCount = placement.getDefaultPhysicsThreadCount() + 1;
+
+	placement.apply(GetCurrentThread(), bsThreadPlacement::ROLE_MAIN);
+	bsJobSystem jobSystem(jobWorkerCount, &placement);
+
+	PhysicsState state;
+	state.frame = 0;
+	state.finished = 0;
+	state.quit = false;
+
+	std::vector<float> physicsResults(physicsThreadCount, 0.0f);
+	std::vector<tbb::tbb_thread*> physicsThreads;
+	for (unsigned int i = 0; i < physicsThreadCount; ++i)
+	{
+		physicsThreads.push_back(new tbb::tbb_thread(std::bind(&physicsThreadLoop,
+			&state, &physicsResults[i])));
+		placement.apply(physicsThreads.back()->native_handle(),
+			bsThreadPlacement::ROLE_PHYSICS, i);
+	}
+
+	unsigned int backgroundChecksum = 0;
+	tbb::tbb_thread backgroundThread(std::bind(&backgroundThreadLoop, &state,
+		&backgroundChecksum));
+	placement.apply(backgroundThread.native_handle(), bsThreadPlacement::ROLE_BACKGROUND);
+
+	std::vector<unsigned char> visible(kSphereCount);
+	std::vector<double> frameTimes;
+	frameTimes.reserve(kFrameCount);
+
+	for (unsigned int frame = 0; frame < kWarmupFrameCount + kFrameCount; ++frame)
+	{
+		const long long startTicks = bsTimer::getTicks();
+
+		state.finished = 0;
+		++state.frame;
+
+		const Sphere* sphereData = spheres.data();
+		unsigned char* visibleData = visible.data();
+		jobSystem.parallelFor(kSphereCount, kCullingGrainSize,
+			[=](unsigned int begin, unsigned int end)
+		{
+			cullSpheres(sphereData, visibleData, begin, end);
+		});
+
+		while (state.finished != physicsThreadCount)
+		{
+			tbb::this_tbb_thread::yield();
+		}
+
+		if (frame >= kWarmupFrameCount)
+		{
+			frameTimes.push_back(
+				bsTimer::ticksToMicroSeconds(bsTimer::getTicks() - startTicks) * 0.001);
+		}
+
+		checksum += visible[frame % kSphereCount];
+	}
+
+	state.quit = true;
+	backgroundThread.join();
+	for (unsigned int i = 0; i < physicsThreadCount; ++i)
+	{
+		physicsThreads[i]->join();
+		delete physicsThreads[i];
+
+		checksum += static_cast<unsigned int>(physicsResults[i]);
+	}
+	checksum += backgroundChecksum;
+
+	//Let the main thread run anywhere again before the next policy places it.
+	const bsCpuTopology& topology = placement.getTopology();
+	SetThreadAffinityMask(GetCurrentThread(), topology.getAllProcessorsMask());
+
+	printf("%-6s %7u %8u", bsThreadPlacement::getPolicyName(placement.getPolicy()),
+		jobWorkerCount, physicsThreadCount);
+
+	return computeStatistics(frameTimes);
+}
+}
+
+
+int main()
+{
+	const bsCpuTopology topology = bsCpuTopology::query();
+	printf("%s, %u frames\n", topology.toString().c_str(), kFrameCount);
+
+	bsRandomNumberGenerator random(1234);
+
+	std::vector<Sphere> spheres(kSphereCount);
+	for (unsigned int i = 0; i < kSphereCount; ++i)
+	{
+		spheres[i].x = random.float11() * 500.0f;
+		spheres[i].y = random.float11() * 500.0f;
+		spheres[i].z = random.float11() * 1000.0f;
+		spheres[i].radius = random.float01() * 5.0f;
+	}
+
+	const bsThreadPlacement::Policy policies[] =
+	{
+		bsThreadPlacement::POLICY_NONE,
+		bsThreadPlacement::POLICY_CORE,
+		bsThreadPlacement::POLICY_PIN
+	};
+
+	printf("Policy  Workers  Physics       Mean    Std dev        p99      Worst\n");
+
+	unsigned int checksum = 0;
+
+	for (unsigned int i = 0; i < sizeof(policies) / sizeof(policies[0]); ++i)
+	{
+		const bsThreadPlacement placement(topology, policies[i]);
+		const Statistics statistics = measure(placement, spheres, checksum);
+
+		printf(" %7.2f ms %7.2f ms %7.2f ms %7.2f ms\n", statistics.mean,
+			statistics.standardDeviation, statistics.percentile99, statistics.worst);
+	}
+
+	//Printed so the work can't be optimized away.
+	printf("Checksum: %u\n", checksum);
+
+	return 0;
+}
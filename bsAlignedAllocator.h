@@ -1,9 +1,10 @@
 #pragma once
 
-#include <stdlib.h>//_aligned_malloc
+#include "bsMemoryTracker.h"
 
 
-/*	Stateless allocator which forwards all allocation requests to _aligned_malloc.
+/*	Stateless allocator which forwards all allocation requests to bsMemoryTracker, tagged
+	with the calling thread's memory tag.
 */
 template <typename T, size_t Alignment = 16>
 class bsAlignedAllocator : public std::allocator<T>
@@ -46,7 +47,8 @@ public:
 	pointer allocate(size_type count)
 	{
 		const size_type sizeToAllocate = count * sizeof(value_type);
-		return static_cast<pointer>(_aligned_malloc(sizeToAllocate, Alignment));
+		return static_cast<pointer>(bsMemoryTracker::allocate(sizeToAllocate, Alignment,
+			bsMemoryTracker::getThreadTag()));
 	}
 
 	pointer allocate(size_type count, const void*)
@@ -56,7 +58,7 @@ public:
 
 	void deallocate(pointer ptr, size_type)
 	{
-		_aligned_free(ptr);
+		bsMemoryTracker::deallocate(ptr);
 	}
 
 	void construct(pointer ptr, const T& val)
@@ -0,0 +1,82 @@
+#include "StdAfx.h"
+
+#include "bsAllocationCounter.h"
+
+#include <crtdbg.h>
+
+#include <tbb/atomic.h>
+
+#include "bsMemoryTracker.h"
+
+
+#ifdef _DEBUG
+namespace
+{
+//Shared by all threads. Only debug builds pay for the contention.
+tbb::atomic<unsigned int> gAllocationCount;
+
+_CRT_ALLOC_HOOK gPreviousAllocHook = nullptr;
+bool gInstalled = false;
+
+/*	Called by the debug CRT for every allocation, reallocation and free.
+	Must not allocate or call CRT functions, since it may be called for the CRT's own
+	allocations.
+*/
+int __cdecl allocationHook(int allocationType, void* userData, size_t size, int blockType,
+	long requestNumber, const unsigned char* fileName, int lineNumber)
+{
+	if (allocationType == _HOOK_ALLOC || allocationType == _HOOK_REALLOC)
+	{
+		++gAllocationCount;
+	}
+
+	if (gPreviousAllocHook != nullptr)
+	{
+		return gPreviousAllocHook(allocationType, userData, size, blockType, requestNumber,
+			fileName, lineNumber);
+	}
+
+	//Allow the allocation.
+	return TRUE;
+}
+}
+#endif // _DEBUG
+
+
+void bsAllocationCounter::install()
+{
+#ifdef _DEBUG
+	if (!gInstalled)
+	{
+		gPreviousAllocHook = _CrtSetAllocHook(allocationHook);
+		gInstalled = true;
+	}
+#endif // _DEBUG
+}
+
+unsigned int bsAllocationCounter::getAllocationCount()
+{
+#if defined(_DEBUG)
+	return gAllocationCount;
+#elif defined(BS_ENABLE_MEMORY_TRACKING)
+	unsigned long long count = 0;
+	for (unsigned int i = 0; i < bsMemoryTracker::TAG_COUNT; ++i)
+	{
+		count += bsMemoryTracker::getTagStatistics(static_cast<bsMemoryTracker::Tag>(i))
+			.totalAllocations;
+	}
+
+	return static_cast<unsigned int>(count);
+#else
+	return 0;
+#endif // _DEBUG
+}
+
+bool bsAllocationCounter::isEnabled()
+{
+#if defined(_DEBUG) || defined(BS_ENABLE_MEMORY_TRACKING)
+	return true;
+#else
+	return false;
+#endif // _DEBUG
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+
+/*	Counts heap allocations made by all threads.
+	Used to verify that code which should not allocate, such as steady state frames,
+	doesn't.
+
+	When using the debug CRT, an allocation hook counts everything allocated through the
+	CRT (malloc, new and everything using them). Otherwise, when BS_ENABLE_MEMORY_TRACKING
+	is defined, the allocations recorded by bsMemoryTracker are counted, which include
+	everything allocated with new. In other builds nothing is counted, see isEnabled.
+*/
+namespace bsAllocationCounter
+{
+/*	Installs the allocation hook, chaining to any previously installed hook.
+	Call once during startup, before any threads are started.
+*/
+void install();
+
+/*	Returns the number of allocations and reallocations made by all threads since
+	install was called. Compare two counts to get the number of allocations made between
+	them.
+	This function is thread safe.
+*/
+unsigned int getAllocationCount();
+
+//Whether allocations are counted in this build. If not, getAllocationCount returns 0.
+bool isEnabled();
+}
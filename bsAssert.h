@@ -28,6 +28,7 @@ do																						 \
 		<< "File: " << __FILE__ << '(' << __LINE__ << ")\n"								 \
 		<< "Function: " << __FUNCTION__;												 \
 		bsLog::log(ss.str().c_str(), bsLog::SEV_ERROR);									 \
+		bsLog::flush();																	 \
 		ss << "\n";																		 \
 		OutputDebugStringA(ss.str().c_str());											 \
 																						 \
@@ -57,6 +58,7 @@ do																						 \
 		<< "File: " << __FILE__ << '(' << __LINE__ << ")\n"								 \
 		<< "Function: " << __FUNCTION__;												 \
 		bsLog::log(ss.str().c_str(), bsLog::SEV_ERROR);									 \
+		bsLog::flush();																	 \
 		ss << "\n";																		 \
 		OutputDebugStringA(ss.str().c_str());											 \
 																						 \
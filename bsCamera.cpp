@@ -13,6 +13,7 @@
 #include "bsAssert.h"
 #include "bsHavokManager.h"
 #include "bsDx11Renderer.h"
+#include "bsRenderDevice.h"
 #include "bsConstantBuffers.h"
 #include "bsRayCastUtil.h"
 
@@ -21,7 +22,7 @@ bsCamera::bsCamera(const bsProjectionInfo& projectionInfo, bsDx11Renderer* dx11R
 	: mProjectionInfo(projectionInfo)
 	, mScene(nullptr)
 	, mEntity(nullptr)
-	, mDeviceContext(dx11Renderer->getDeviceContext())
+	, mRenderDevice(&dx11Renderer->getRenderDevice())
 {
 	//Create view projection buffer
 	D3D11_BUFFER_DESC bufferDescription;
@@ -31,18 +32,16 @@ bsCamera::bsCamera(const bsProjectionInfo& projectionInfo, bsDx11Renderer* dx11R
 	bufferDescription.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
 	bufferDescription.CPUAccessFlags = 0;
 
-	if (FAILED(dx11Renderer->getDevice()->CreateBuffer(&bufferDescription, nullptr,
+	if (FAILED(mRenderDevice->createBuffer(bufferDescription, nullptr,
 		&mCameraConstantBuffer)))
 	{
 		BS_ASSERT(!"Failed to create view projection buffer");
 	}
-	mDeviceContext->PSSetConstantBuffers(0, 1, &mCameraConstantBuffer);
-	mDeviceContext->VSSetConstantBuffers(0, 1, &mCameraConstantBuffer);
+	mRenderDevice->setPixelConstantBuffers(0, 1, &mCameraConstantBuffer);
+	mRenderDevice->setVertexConstantBuffers(0, 1, &mCameraConstantBuffer);
 
 #ifdef BS_DEBUG
-	const char* debugMessage = "bsCamera constant buffer";
-	mCameraConstantBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, strlen(debugMessage),
-		debugMessage);
+	mRenderDevice->setDebugName(mCameraConstantBuffer, "bsCamera constant buffer");
 #endif
 
 	updateProjection();
@@ -50,7 +49,7 @@ bsCamera::bsCamera(const bsProjectionInfo& projectionInfo, bsDx11Renderer* dx11R
 
 bsCamera::~bsCamera()
 {
-	mCameraConstantBuffer->Release();
+	mRenderDevice->release(mCameraConstantBuffer);
 }
 
 void bsCamera::update()
@@ -58,7 +57,12 @@ void bsCamera::update()
 	BS_ASSERT2(mEntity != nullptr, "Camera must be attached to an entity before calling"
 		" update");
 
-	updateViewProjection();
+	updateViewProjection(getViewMatrix(), mEntity->getTransform().getPosition());
+}
+
+void bsCamera::update(const XMMATRIX& view, const XMVECTOR& position)
+{
+	updateViewProjection(view, position);
 }
 
 void bsCamera::updateProjection()
@@ -71,7 +75,8 @@ void bsCamera::updateProjection()
 	mFrustum = bsComputeFrustumFromProjection(mProjection);
 }
 
-void bsCamera::updateViewProjection()
+void bsCamera::updateViewProjection(const XMMATRIX& viewTransform,
+	const XMVECTOR& position)
 {
 	/*	Calculating view and viewProjection matrix every frame, even if the camera does
 		not move since the camera will likely move almost every frame during a game,
@@ -89,8 +94,6 @@ void bsCamera::updateViewProjection()
 
 	const XMMATRIX viewTransform = XMMatrixMultiply(rotationMat, inversePositionMat);
 	*/
-	const XMMATRIX viewTransform = getViewMatrix();
-
 	XMMATRIX viewProjection = XMMatrixMultiply(viewTransform, mProjection);
 	mViewProjection = viewProjection;
 
@@ -98,11 +101,11 @@ void bsCamera::updateViewProjection()
 	cbCam.view = XMMatrixTranspose(viewTransform);
 	cbCam.projection = XMMatrixTranspose(mProjection);
 	cbCam.viewProjection = XMMatrixTranspose(viewProjection);
-	cbCam.cameraPosition = mEntity->getTransform().getPosition();
+	cbCam.cameraPosition = position;
 	XMVECTOR determinant;
 	cbCam.inverseViewProjection = XMMatrixInverse(&determinant, viewProjection);
 
-	mDeviceContext->UpdateSubresource(mCameraConstantBuffer, 0, nullptr, &cbCam, 0, 0);
+	mRenderDevice->updateBuffer(mCameraConstantBuffer, &cbCam, sizeof(cbCam));
 }
 
 XMMATRIX bsCamera::getViewMatrix() const
@@ -6,6 +6,7 @@
 
 #include "bsScene.h"
 #include "bsFrustum.h"
+#include "bsMemoryTracker.h"
 
 struct hkpWorldRayCastOutput;
 
@@ -13,6 +14,7 @@ class bsScene;
 class bsEntity;
 class bsCamera;
 class bsDx11Renderer;
+class bsRenderDevice;
 
 void* allocateCamera();
 void deallocateCamera(void* p);
@@ -110,6 +112,11 @@ public:
 	*/
 	void update();
 
+	/*	Like update, but with a view matrix and position captured earlier, for rendering
+		a bsFrameSnapshot while the camera's entity is being moved by the simulation.
+	*/
+	void update(const XMMATRIX& view, const XMVECTOR& position);
+
 	inline bsEntity* getEntity() const
 	{
 		return mEntity;
@@ -165,7 +172,7 @@ private:
 	/*	Updates view projection matrix based on current projection and view matrices
 		and uploads it to the GPU
 	*/
-	void updateViewProjection();
+	void updateViewProjection(const XMMATRIX& viewTransform, const XMVECTOR& position);
 
 	bsFrustum	mFrustum;
 
@@ -181,16 +188,16 @@ private:
 	bsEntity*	mEntity;
 	bsScene*	mScene;
 
-	ID3D11DeviceContext*	mDeviceContext;
+	bsRenderDevice*	mRenderDevice;
 };
 
 
 inline void* allocateCamera()
 {
-	return _aligned_malloc(sizeof(bsCamera), 16);
+	return bsMemoryTracker::allocate(sizeof(bsCamera), 16, bsMemoryTracker::TAG_SCENE);
 }
 
 inline void deallocateCamera(void* ptr)
 {
-	_aligned_free(ptr);
+	bsMemoryTracker::deallocate(ptr);
 }
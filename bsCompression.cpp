@@ -0,0 +1,105 @@
+#ifndef BS_PACK_FILE_EXTERNAL
+#include "StdAfx.h"
+#endif
+
+#include "bsCompression.h"
+
+#include <stdlib.h>
+
+#include <Windows.h>
+
+
+/*	LZNT1 (de)compression is exported by ntdll, but there is no import library for it in
+	the regular SDK, so the functions are looked up at runtime.
+*/
+typedef LONG (WINAPI* RtlCompressBufferFunction)(USHORT compressionFormat,
+	PUCHAR uncompressedBuffer, ULONG uncompressedBufferSize, PUCHAR compressedBuffer,
+	ULONG compressedBufferSize, ULONG uncompressedChunkSize, PULONG finalCompressedSize,
+	PVOID workSpace);
+
+typedef LONG (WINAPI* RtlDecompressBufferFunction)(USHORT compressionFormat,
+	PUCHAR uncompressedBuffer, ULONG uncompressedBufferSize, PUCHAR compressedBuffer,
+	ULONG compressedBufferSize, PULONG finalUncompressedSize);
+
+typedef LONG (WINAPI* RtlGetCompressionWorkSpaceSizeFunction)(USHORT compressionFormat,
+	PULONG compressBufferWorkSpaceSize, PULONG compressFragmentWorkSpaceSize);
+
+
+namespace
+{
+struct NtdllFunctions
+{
+	NtdllFunctions()
+	{
+		const HMODULE ntdll = GetModuleHandleA("ntdll.dll");
+
+		compressBuffer = reinterpret_cast<RtlCompressBufferFunction>(
+			GetProcAddress(ntdll, "RtlCompressBuffer"));
+		decompressBuffer = reinterpret_cast<RtlDecompressBufferFunction>(
+			GetProcAddress(ntdll, "RtlDecompressBuffer"));
+		getCompressionWorkSpaceSize = reinterpret_cast<RtlGetCompressionWorkSpaceSizeFunction>(
+			GetProcAddress(ntdll, "RtlGetCompressionWorkSpaceSize"));
+	}
+
+	RtlCompressBufferFunction				compressBuffer;
+	RtlDecompressBufferFunction				decompressBuffer;
+	RtlGetCompressionWorkSpaceSizeFunction	getCompressionWorkSpaceSize;
+};
+
+//Looked up once on first use. ntdll is always loaded, so the module is never freed.
+const NtdllFunctions& getNtdllFunctions()
+{
+	static NtdllFunctions functions;
+	return functions;
+}
+}
+
+
+unsigned int bsCompression::compress(const char* source, unsigned int sourceSize,
+	char* destination, unsigned int destinationSize)
+{
+	const NtdllFunctions& ntdll = getNtdllFunctions();
+	if (!ntdll.compressBuffer || !ntdll.getCompressionWorkSpaceSize)
+	{
+		return 0;
+	}
+
+	const USHORT format = COMPRESSION_FORMAT_LZNT1 | COMPRESSION_ENGINE_MAXIMUM;
+
+	ULONG workSpaceSize = 0;
+	ULONG fragmentWorkSpaceSize = 0;
+	if (ntdll.getCompressionWorkSpaceSize(format, &workSpaceSize, &fragmentWorkSpaceSize) != 0)
+	{
+		return 0;
+	}
+
+	void* workSpace = malloc(workSpaceSize);
+
+	ULONG compressedSize = 0;
+	const LONG status = ntdll.compressBuffer(format,
+		reinterpret_cast<PUCHAR>(const_cast<char*>(source)), sourceSize,
+		reinterpret_cast<PUCHAR>(destination), destinationSize, 4096, &compressedSize,
+		workSpace);
+
+	free(workSpace);
+
+	//Any non-zero status means failure, including the buffer being too small.
+	return status == 0 ? compressedSize : 0;
+}
+
+bool bsCompression::decompress(const char* source, unsigned int sourceSize,
+	char* destination, unsigned int destinationSize)
+{
+	const NtdllFunctions& ntdll = getNtdllFunctions();
+	if (!ntdll.decompressBuffer)
+	{
+		return false;
+	}
+
+	ULONG decompressedSize = 0;
+	const LONG status = ntdll.decompressBuffer(COMPRESSION_FORMAT_LZNT1,
+		reinterpret_cast<PUCHAR>(destination), destinationSize,
+		reinterpret_cast<PUCHAR>(const_cast<char*>(source)), sourceSize, &decompressedSize);
+
+	return status == 0 && decompressedSize == destinationSize;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+
+/*	Contains functions for compressing and decompressing blocks of memory.
+	The LZNT1 format supported by Windows is used, meaning no external libraries are
+	required.
+*/
+namespace bsCompression
+{
+
+/*	Compresses source into destination.
+	Returns the size of the compressed data, or 0 if compression failed or if the compressed
+	data would not fit in destination.
+*/
+unsigned int compress(const char* source, unsigned int sourceSize, char* destination,
+	unsigned int destinationSize);
+
+/*	Decompresses source into destination. destinationSize must be exactly the size of the
+	decompressed data.
+	Returns true on success.
+*/
+bool decompress(const char* source, unsigned int sourceSize, char* destination,
+	unsigned int destinationSize);
+
+}
@@ -0,0 +1,252 @@
+#include "StdAfx.h"
+
+#include "bsConstantBufferRing.h"
+
+#include <string.h>
+
+#include "bsRenderDevice.h"
+#include "bsMemoryTracker.h"
+#include "bsLog.h"
+#include "bsAssert.h"
+
+
+namespace
+{
+inline unsigned int alignUp(unsigned int size, unsigned int alignment)
+{
+	return (size + alignment - 1) & ~(alignment - 1);
+}
+}
+
+
+bsConstantBufferRing::bsConstantBufferRing(bsRenderDevice& renderDevice,
+	unsigned int capacity)
+	: mRenderDevice(renderDevice)
+	, mUseOffsets(renderDevice.supportsConstantBufferOffsets())
+	, mStaging(nullptr)
+	, mStagingCapacity(alignUp(capacity, kAlignment))
+	, mUsedSize(0)
+	, mUploadedSize(0)
+	, mBuffer(nullptr)
+	, mCapacity(alignUp(capacity, kAlignment))
+	, mMapCount(0)
+{
+	BS_ASSERT2(capacity != 0, "Constant buffer ring capacity must not be 0");
+
+	mStaging = static_cast<char*>(bsMemoryTracker::allocate(mStagingCapacity,
+		kAlignment, bsMemoryTracker::TAG_RENDER));
+
+	memset(mFallbackBuffers, 0, sizeof(mFallbackBuffers));
+	memset(mFallbackSizes, 0, sizeof(mFallbackSizes));
+
+	if (mUseOffsets)
+	{
+		createBuffer();
+	}
+	else
+	{
+		BS_LOG_INFO(RENDER, "Constant buffer offsets are not supported, constants are"
+			" uploaded when they are bound");
+	}
+}
+
+bsConstantBufferRing::~bsConstantBufferRing()
+{
+	if (mBuffer != nullptr)
+	{
+		mRenderDevice.release(mBuffer);
+	}
+
+	const unsigned int slotCount = D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT;
+	for (unsigned int i = 0; i < kStageCombinationCount; ++i)
+	{
+		for (unsigned int j = 0; j < slotCount; ++j)
+		{
+			if (mFallbackBuffers[i][j] != nullptr)
+			{
+				mRenderDevice.release(mFallbackBuffers[i][j]);
+			}
+		}
+	}
+
+	bsMemoryTracker::deallocate(mStaging);
+}
+
+void bsConstantBufferRing::createBuffer()
+{
+	D3D11_BUFFER_DESC bufferDescription;
+	memset(&bufferDescription, 0, sizeof(bufferDescription));
+	bufferDescription.Usage = D3D11_USAGE_DYNAMIC;
+	bufferDescription.ByteWidth = mCapacity;
+	bufferDescription.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	bufferDescription.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+	const HRESULT hres = mRenderDevice.createBuffer(bufferDescription, nullptr, &mBuffer);
+	BS_ASSERT2(SUCCEEDED(hres), "Failed to create constant buffer ring");
+
+#ifdef BS_DEBUG
+	mRenderDevice.setDebugName(mBuffer, "bsConstantBufferRing buffer");
+#endif
+}
+
+void bsConstantBufferRing::beginFrame()
+{
+	mUsedSize = 0;
+	mUploadedSize = 0;
+	mMapCount = 0;
+}
+
+void* bsConstantBufferRing::allocate(unsigned int size, Allocation& allocationOut)
+{
+	BS_ASSERT2(size != 0, "Allocating 0 bytes of constants");
+
+	allocationOut.offset = mUsedSize;
+	allocationOut.size = alignUp(size, kAlignment);
+
+	const unsigned int requiredSize = mUsedSize + allocationOut.size;
+	if (requiredSize > mStagingCapacity)
+	{
+		unsigned int newCapacity = mStagingCapacity * 2;
+		while (newCapacity < requiredSize)
+		{
+			newCapacity *= 2;
+		}
+
+		char* newStaging = static_cast<char*>(bsMemoryTracker::allocate(newCapacity,
+			kAlignment, bsMemoryTracker::TAG_RENDER));
+		memcpy(newStaging, mStaging, mUsedSize);
+		bsMemoryTracker::deallocate(mStaging);
+
+		mStaging = newStaging;
+		mStagingCapacity = newCapacity;
+	}
+
+	mUsedSize = requiredSize;
+
+	return mStaging + allocationOut.offset;
+}
+
+void bsConstantBufferRing::upload()
+{
+	if (!mUseOffsets || mUsedSize == 0)
+	{
+		mUploadedSize = mUsedSize;
+
+		return;
+	}
+
+	if (mUsedSize > mCapacity)
+	{
+		mRenderDevice.release(mBuffer);
+
+		while (mCapacity < mUsedSize)
+		{
+			mCapacity *= 2;
+		}
+		createBuffer();
+
+		BS_LOG_INFO(RENDER, "Constant buffer ring grown to %u KB", mCapacity / 1024);
+	}
+
+	void* mapped = mRenderDevice.mapDiscard(mBuffer);
+	++mMapCount;
+	if (mapped == nullptr)
+	{
+		BS_LOG_ERROR(RENDER, "Failed to map constant buffer ring");
+
+		return;
+	}
+
+	//Everything is copied again, since discarding drops what earlier uploads wrote.
+	memcpy(mapped, mStaging, mUsedSize);
+	mRenderDevice.unmap(mBuffer);
+
+	mUploadedSize = mUsedSize;
+}
+
+void bsConstantBufferRing::bind(unsigned int slot, const Allocation& allocation,
+	unsigned int stages)
+{
+	BS_ASSERT2(allocation.offset + allocation.size <= mUploadedSize,
+		"Binding constants which have not been uploaded");
+	BS_ASSERT(slot < D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT);
+	BS_ASSERT(stages != 0 && stages <= kStageCombinationCount);
+
+	if (!mUseOffsets)
+	{
+		bindFallback(slot, allocation, stages);
+
+		return;
+	}
+
+	const unsigned int firstConstant = allocation.offset / 16;
+	const unsigned int constantCount = allocation.size / 16;
+
+	if (stages & VERTEX_STAGE)
+	{
+		mRenderDevice.setVertexConstantBufferRange(slot, mBuffer, firstConstant,
+			constantCount);
+	}
+	if (stages & PIXEL_STAGE)
+	{
+		mRenderDevice.setPixelConstantBufferRange(slot, mBuffer, firstConstant,
+			constantCount);
+	}
+}
+
+void bsConstantBufferRing::bindFallback(unsigned int slot, const Allocation& allocation,
+	unsigned int stages)
+{
+	ID3D11Buffer*& buffer = mFallbackBuffers[stages - 1][slot];
+	unsigned int& bufferSize = mFallbackSizes[stages - 1][slot];
+
+	if (bufferSize < allocation.size)
+	{
+		if (buffer != nullptr)
+		{
+			mRenderDevice.release(buffer);
+			buffer = nullptr;
+		}
+
+		D3D11_BUFFER_DESC bufferDescription;
+		memset(&bufferDescription, 0, sizeof(bufferDescription));
+		bufferDescription.Usage = D3D11_USAGE_DYNAMIC;
+		bufferDescription.ByteWidth = allocation.size;
+		bufferDescription.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		bufferDescription.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+		const HRESULT hres = mRenderDevice.createBuffer(bufferDescription, nullptr,
+			&buffer);
+		BS_ASSERT2(SUCCEEDED(hres), "Failed to create fallback constant buffer");
+		if (FAILED(hres))
+		{
+			buffer = nullptr;
+			bufferSize = 0;
+
+			return;
+		}
+
+		bufferSize = allocation.size;
+	}
+
+	void* mapped = mRenderDevice.mapDiscard(buffer);
+	++mMapCount;
+	if (mapped == nullptr)
+	{
+		BS_LOG_ERROR(RENDER, "Failed to map fallback constant buffer");
+
+		return;
+	}
+
+	memcpy(mapped, mStaging + allocation.offset, allocation.size);
+	mRenderDevice.unmap(buffer);
+
+	if (stages & VERTEX_STAGE)
+	{
+		mRenderDevice.setVertexConstantBuffers(slot, 1, &buffer);
+	}
+	if (stages & PIXEL_STAGE)
+	{
+		mRenderDevice.setPixelConstantBuffers(slot, 1, &buffer);
+	}
+}
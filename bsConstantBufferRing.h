@@ -0,0 +1,137 @@
+#pragma once
+
+#include <d3d11.h>
+
+class bsRenderDevice;
+
+
+/*	Linear allocator for the constant buffer data of the draws in one frame.
+
+	Constants are written to CPU memory as the frame is prepared, then uploaded to a
+	single dynamic constant buffer with one map, and each draw binds its part of that
+	buffer by offset. This replaces a buffer update per draw with one upload per frame.
+	The buffer is discarded by every upload, so the driver rotates its memory between the
+	frames in flight without stalling.
+
+	Without support for constant buffer offsets (D3D11.0, see
+	bsRenderDevice::supportsConstantBufferOffsets), upload does nothing, and binding an
+	allocation instead copies it to a small dynamic buffer for its slot with a map.
+
+	Every frame: beginFrame, allocate and write all constants, upload, then bind the
+	allocations while drawing. Allocating after an upload is allowed, but needs another
+	upload before the new allocations are bound.
+
+	Not thread safe. Everything but the constructor must be called from the rendering
+	thread.
+*/
+class bsConstantBufferRing
+{
+public:
+	/*	Allocations start at multiples of this, which is what offset binding requires
+		(16 constants of 16 bytes).
+	*/
+	static const unsigned int kAlignment = 256;
+
+	enum Stage
+	{
+		VERTEX_STAGE = 1 << 0,
+		PIXEL_STAGE = 1 << 1
+	};
+
+	struct Allocation
+	{
+		//Offset in bytes from the start of the frame's constants.
+		unsigned int	offset;
+		//Size in bytes, a multiple of kAlignment.
+		unsigned int	size;
+	};
+
+
+	/*	capacity is the number of bytes the buffer starts with. It grows when a frame
+		needs more.
+	*/
+	bsConstantBufferRing(bsRenderDevice& renderDevice, unsigned int capacity);
+
+	~bsConstantBufferRing();
+
+	//Invalidates every allocation of the previous frame.
+	void beginFrame();
+
+	/*	Reserves size bytes of constants, and returns where to write them. The memory is
+		aligned to kAlignment, and is only valid until the next allocate.
+	*/
+	void* allocate(unsigned int size, Allocation& allocationOut);
+
+	template <typename T>
+	inline T* allocate(Allocation& allocationOut)
+	{
+		return static_cast<T*>(allocate(sizeof(T), allocationOut));
+	}
+
+	/*	Copies everything allocated since beginFrame to the GPU with one map, growing the
+		buffer first if it is too small.
+	*/
+	void upload();
+
+	/*	Binds an uploaded allocation to slot of the stages in stages (a combination of
+		Stage values).
+	*/
+	void bind(unsigned int slot, const Allocation& allocation, unsigned int stages);
+
+	//Bytes allocated since beginFrame.
+	inline unsigned int getUsedSize() const
+	{
+		return mUsedSize;
+	}
+
+	//Size of the GPU buffer in bytes, 0 without constant buffer offsets.
+	inline unsigned int getCapacity() const
+	{
+		return mBuffer != nullptr ? mCapacity : 0;
+	}
+
+	//Maps done by uploads and fallback binds since beginFrame.
+	inline unsigned int getMapCount() const
+	{
+		return mMapCount;
+	}
+
+private:
+	//Non-copyable.
+	bsConstantBufferRing(const bsConstantBufferRing&);
+	bsConstantBufferRing& operator=(const bsConstantBufferRing&);
+
+	//Creates mBuffer with mCapacity bytes.
+	void createBuffer();
+
+	static const unsigned int kStageCombinationCount = VERTEX_STAGE | PIXEL_STAGE;
+
+	//Copies an allocation to the fallback buffer of slot and stages, and binds it.
+	void bindFallback(unsigned int slot, const Allocation& allocation,
+		unsigned int stages);
+
+
+	bsRenderDevice&	mRenderDevice;
+	const bool		mUseOffsets;
+
+	//Constants of the current frame, written before being uploaded.
+	char*			mStaging;
+	unsigned int	mStagingCapacity;
+	unsigned int	mUsedSize;
+	//Bytes copied to the GPU by the last upload.
+	unsigned int	mUploadedSize;
+
+	//Only created with constant buffer offsets.
+	ID3D11Buffer*	mBuffer;
+	unsigned int	mCapacity;
+
+	unsigned int	mMapCount;
+
+	/*	Buffers used instead of offsets, one per slot and combination of stages, so that
+		binding to one slot never changes what another slot sees. Created when first used.
+	*/
+	ID3D11Buffer*	mFallbackBuffers[kStageCombinationCount]
+		[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+	unsigned int	mFallbackSizes[kStageCombinationCount]
+		[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+};
@@ -17,21 +17,67 @@
 #include "bsDeferredRenderer.h"
 #include "bsTimer.h"
 #include "bsFrameStatistics.h"
+#include "bsFileSystemWatcher.h"
+#include "bsAllocationCounter.h"
+#include "bsScratchAllocator.h"
+#include "bsMemoryTracker.h"
+#include "bsJobSystem.h"
+#include "bsCpuTopology.h"
+#include "bsThreadPlacement.h"
+#include "bsProfiler.h"
+#include "bsMetrics.h"
 
 
 bsCore::bsCore(const bsCoreCInfo& cInfo)
 	: mCInfo(cInfo)
+	, mFileSystemWatcher(nullptr)
 	, mResizeQueued(false)
 	, mResizeWidth(0)
 	, mResizeHeight(0)
 {
-	bsLog::init(fopen(cInfo.logFileFileName.c_str(), "w"), bsLog::SEV_DEBUG,
-		bsLog::TIMESTAMP_MILLISECS | bsLog::SEVERITY_AS_TEXT);
+	bsAllocationCounter::install();
+
+	unsigned char logFlags = bsLog::TIMESTAMP_MILLISECS | bsLog::SEVERITY_AS_TEXT;
+	if (cInfo.binaryLog)
+	{
+		logFlags |= bsLog::BINARY_OUTPUT;
+	}
+	bsLog::init(fopen(cInfo.logFileFileName.c_str(), cInfo.binaryLog ? "wb" : "w"),
+		bsLog::SEV_DEBUG, logFlags);
 
 	BS_ASSERT2(mCInfo.isOk(), "Invalid construction info was sent to bsCore");
 
 	bsLog::log("Initializing core");
 
+	bsProfiler::setThreadName("Main");
+
+	mThreadPlacement = new bsThreadPlacement(bsCpuTopology::query(),
+		cInfo.threadPlacement);
+	BS_LOG_INFO(GENERAL, "CPU topology: %s, thread placement: %s",
+		mThreadPlacement->getTopology().toString().c_str(),
+		bsThreadPlacement::getPolicyName(mThreadPlacement->getPolicy()));
+
+	if (!mThreadPlacement->apply(GetCurrentThread(), bsThreadPlacement::ROLE_MAIN))
+	{
+		BS_LOG_WARNING(GENERAL, "Failed to set main thread affinity: %s",
+			bsWindowsUtils::winApiErrorCodeToString(GetLastError()).c_str());
+	}
+
+	mMetrics = new bsMetricsRegistry();
+	mFrameTimeMetric = &mMetrics->getHistogram("frame.time_us");
+	mCullTimeMetric = &mMetrics->getHistogram("render.cull_us");
+	mMeshesDrawnMetric = &mMetrics->getGauge("render.meshes_drawn");
+	mTrianglesDrawnMetric = &mMetrics->getGauge("render.triangles_drawn");
+	mFrameCountMetric = &mMetrics->getCounter("frame.count");
+	mFileIoManager.setReadLatencyMetric(&mMetrics->getHistogram("io.read_us"));
+	mMetrics->setExport(cInfo.metricsFileName, cInfo.metricsExportIntervalMs);
+
+	const unsigned int jobWorkerThreadCount = cInfo.jobWorkerThreadCount >= 0
+		? cInfo.jobWorkerThreadCount : mThreadPlacement->getDefaultJobWorkerCount();
+	mJobSystem = new bsJobSystem(jobWorkerThreadCount, mThreadPlacement);
+	BS_LOG_INFO(GENERAL, "Job system started with %u worker threads",
+		jobWorkerThreadCount);
+
 	auto windowResizeCallback = std::bind(&bsCore::windowResizedCallback,
 		this, std::placeholders::_1,std::placeholders::_2, std::placeholders::_3);
 
@@ -41,17 +87,36 @@ bsCore::bsCore(const bsCoreCInfo& cInfo)
 	mDx11Renderer = new bsDx11Renderer(mWindow->getHwnd(), cInfo.windowWidth, cInfo.windowHeight);
 
 	mResourceManager = new bsResourceManager();
-	mResourceManager->initAll(cInfo.assetDirectory, mDx11Renderer, mFileIoManager);
+	mResourceManager->initAll(cInfo.assetDirectory, mDx11Renderer, mFileIoManager,
+		*mJobSystem, cInfo.fileSystemCacheFileName);
+
+	//Mount packs before the file IO thread starts, mounting is not thread safe.
+	for (size_t i = 0; i < cInfo.packFiles.size(); ++i)
+	{
+		mResourceManager->getFileSystem()->mountPackFile(cInfo.assetDirectory
+			+ cInfo.packFiles[i]);
+	}
+	mFileIoManager.setFileSystem(mResourceManager->getFileSystem());
 
-	mHavokManager = new bsHavokManager();
+	if (cInfo.watchAssetDirectory)
+	{
+		mFileSystemWatcher = new bsFileSystemWatcher(*mResourceManager->getFileSystem());
+	}
 
-	mRenderQueue = new bsRenderQueue(mDx11Renderer, mResourceManager->getShaderManager());
+	const unsigned int physicsThreadCount = cInfo.physicsThreadCount >= 0
+		? cInfo.physicsThreadCount : mThreadPlacement->getDefaultPhysicsThreadCount();
+	mHavokManager = new bsHavokManager(*mThreadPlacement, physicsThreadCount);
+
+	mRenderQueue = new bsRenderQueue(mDx11Renderer, mResourceManager->getShaderManager(),
+		mJobSystem);
 
 	mRenderSystem = new bsDeferredRenderer(mDx11Renderer,
-		mResourceManager->getShaderManager(), mWindow, mRenderQueue);
+		mResourceManager->getShaderManager(), mRenderQueue);
 
 	mFileIoThread = new tbb::tbb_thread(std::bind(&bsFileIoManager::threadLoop, &mFileIoManager));
 	bsWindowsUtils::setThreadName(GetThreadId(mFileIoThread->native_handle()), "Background File Loader");
+	mThreadPlacement->apply(mFileIoThread->native_handle(),
+		bsThreadPlacement::ROLE_BACKGROUND);
 
 	bsLog::log("Initialization of core completed successfully");
 }
@@ -68,6 +133,20 @@ bsCore::~bsCore()
 	mFileIoThread->join();
 	delete mFileIoThread;
 
+	if (!mCInfo.fileIoStatisticsFileName.empty())
+	{
+		mFileIoManager.writeStatistics(mCInfo.fileIoStatisticsFileName);
+	}
+
+	if (!mCInfo.profilerTraceFileName.empty()
+		&& !bsProfiler::writeChromeTrace(mCInfo.profilerTraceFileName))
+	{
+		BS_LOG_ERROR(GENERAL, "Failed to write profiler trace to '%s'",
+			mCInfo.profilerTraceFileName.c_str());
+	}
+
+	delete mFileSystemWatcher;
+
 	delete mRenderSystem;
 	delete mRenderQueue;
 
@@ -81,6 +160,20 @@ bsCore::~bsCore()
 
 	delete mWindow;
 
+	//Joins the workers, nothing can run jobs after this.
+	delete mJobSystem;
+
+	delete mThreadPlacement;
+
+	delete mMetrics;
+
+	//Every thread which could have used scratch memory has been shut down by now.
+	bsScratchAllocator::shutdown();
+	bsProfiler::shutdown();
+
+	//Whatever is still alive at this point is likely leaked.
+	bsMemoryTracker::logReport(25);
+
 	bsLog::log("Core shut down successfully, closing log");
 	bsLog::deinit();
 }
@@ -99,12 +192,27 @@ bool bsCore::update(float deltaTimeMs, bsFrameStatistics& framStatistics)
 		mResizeQueued = false;
 	}
 
-	bsTimer timer;
-	float preRender = timer.getTimeMilliSeconds();
+	if (mFileSystemWatcher)
+	{
+		mFileSystemWatcher->update();
+	}
+
+	bsMemoryTracker::update();
 
-	mRenderSystem->renderOneFrame(framStatistics);
+	framStatistics.renderingInfo.totalRenderingDuration = 0.0f;
+	{
+		BS_PROFILE_SCOPE_STAT("Render",
+			framStatistics.renderingInfo.totalRenderingDuration);
+		mRenderSystem->renderOneFrame(framStatistics);
+	}
 
-	framStatistics.renderingInfo.totalRenderingDuration = timer.getTimeMilliSeconds() - preRender;
+	const bsFrameStats& frameStats = mRenderQueue->getFrameStats();
+	mFrameTimeMetric->recordMilliSeconds(deltaTimeMs);
+	mCullTimeMetric->recordMilliSeconds(framStatistics.renderingInfo.cullDuration);
+	mMeshesDrawnMetric->set(frameStats.totalMeshesDrawn);
+	mTrianglesDrawnMetric->set(frameStats.totalTrianglesDrawn);
+	mFrameCountMetric->add();
+	mMetrics->update(deltaTimeMs);
 
 	return true;
 }
@@ -13,6 +13,13 @@ class bsHavokManager;
 class bsWindow;
 class bsRenderQueue;
 class bsDeferredRenderer;
+class bsFileSystemWatcher;
+class bsJobSystem;
+class bsThreadPlacement;
+class bsMetricsRegistry;
+class bsMetricHistogram;
+class bsMetricGauge;
+class bsMetricCounter;
 struct bsFrameStatistics;
 
 
@@ -67,6 +74,24 @@ public:
 		return mRenderSystem;
 	}
 
+	inline bsJobSystem* getJobSystem() const
+	{
+		return mJobSystem;
+	}
+
+	inline const bsThreadPlacement* getThreadPlacement() const
+	{
+		return mThreadPlacement;
+	}
+
+	/*	Frame time, cull time, draw counts and file read latency are recorded here every
+		frame. Other systems can add their own metrics during initialization.
+	*/
+	inline bsMetricsRegistry* getMetrics() const
+	{
+		return mMetrics;
+	}
+
 private:
 	void windowResizedCallback(unsigned int width, unsigned int height, const bsWindow& window);
 
@@ -85,11 +110,25 @@ private:
 
 	bsDeferredRenderer*	mRenderSystem;
 
+	bsJobSystem*		mJobSystem;
+	bsThreadPlacement*	mThreadPlacement;
+
+	bsMetricsRegistry*	mMetrics;
+	//Metrics recorded every frame, owned by mMetrics.
+	bsMetricHistogram*	mFrameTimeMetric;
+	bsMetricHistogram*	mCullTimeMetric;
+	bsMetricGauge*		mMeshesDrawnMetric;
+	bsMetricGauge*		mTrianglesDrawnMetric;
+	bsMetricCounter*	mFrameCountMetric;
+
 	bsCoreCInfo			mCInfo;
 
 	bsFileIoManager		mFileIoManager;
 	tbb::tbb_thread*	mFileIoThread;
 
+	//Null unless watching the asset directory is enabled.
+	bsFileSystemWatcher*	mFileSystemWatcher;
+
 	bool			mResizeQueued;
 	unsigned int	mResizeWidth;
 	unsigned int	mResizeHeight;
@@ -3,6 +3,9 @@
 
 #include <Windows.h>
 #include <string>
+#include <vector>
+
+#include "bsThreadPlacement.h"
 
 
 /*	Structure which holds all necessary information for starting the engine.
@@ -12,7 +15,18 @@ struct bsCoreCInfo
 {
 	bsCoreCInfo()
 		: assetDirectory("..\\assets\\")
+		, fileSystemCacheFileName("filesystem.bsc")
+		, watchAssetDirectory(false)
 		, logFileFileName("log.bsl")
+		, binaryLog(false)
+		, fileIoStatisticsFileName("fileio.json")
+		, profilerTraceFileName("trace.json")
+		, metricsFileName("")
+		, metricsExportIntervalMs(1000.0f)
+		, jobWorkerThreadCount(-1)
+		, physicsThreadCount(-1)
+		, threadPlacement(bsThreadPlacement::POLICY_NONE)
+		, pipelinedSimulation(false)
 		, worldSize(1000.0f)
 		, windowWidth(1280)
 		, windowHeight(720)
@@ -27,11 +41,93 @@ struct bsCoreCInfo
 	*/
 	std::string	assetDirectory;
 
+	/*	Pack files to mount, relative to the asset directory. Files in packs later in the
+		list override files with the same name in earlier packs, so patch packs should be
+		placed after the packs they patch.
+		Default: empty
+	*/
+	std::vector<std::string>	packFiles;
+
+	/*	The file system index is cached in this file, making startup faster when the asset
+		directory has not changed. Set to an empty string to always scan the asset directory.
+		Default: "filesystem.bsc"
+	*/
+	std::string	fileSystemCacheFileName;
+
+	/*	If true, the asset directory is watched for changes, and added, removed or modified
+		files are applied to the file system as they happen. Modified textures are reloaded.
+		Default: false
+	*/
+	bool	watchAssetDirectory;
+
 	/*	The file name of the log file.
 		Default: "log.bsl"
 	*/
 	std::string logFileFileName;
 
+	/*	If true, the log is written in bsLog's binary format, which is smaller and cheaper
+		to write. Use the bsLogDecoder tool to convert it to text.
+		Default: false
+	*/
+	bool	binaryLog;
+
+	/*	File IO statistics (request latencies, sizes and throughput) are written to this
+		file as JSON on shutdown. Set to an empty string to disable.
+		Default: "fileio.json"
+	*/
+	std::string	fileIoStatisticsFileName;
+
+	/*	The zones recorded by bsProfiler during the last seconds before shutdown are
+		written to this file, in Chrome's trace event format. Open it in chrome://tracing.
+		Set to an empty string to disable. Nothing is written if profiling is compiled
+		out.
+		Default: "trace.json"
+	*/
+	std::string	profilerTraceFileName;
+
+	/*	Runtime metrics (frame time percentiles, cull time, draw counts, file read
+		latency) are written to this file every metricsExportIntervalMs. Files ending in
+		.csv get a row per metric appended every time, other files are overwritten with
+		the latest values as JSON. See bsMetricsRegistry. Set to an empty string to
+		disable.
+		Default: ""
+	*/
+	std::string	metricsFileName;
+
+	/*	How often metrics are exported, in milliseconds.
+		Default: 1000.0f
+	*/
+	float	metricsExportIntervalMs;
+
+	/*	Number of worker threads started by the job system, in addition to the main
+		thread. Negative to let the thread placement decide, see
+		bsThreadPlacement::getDefaultJobWorkerCount.
+		Default: -1
+	*/
+	int		jobWorkerThreadCount;
+
+	/*	Number of worker threads in Havok's thread pool, in addition to the thread
+		stepping the world. Negative to let the thread placement decide.
+		Default: -1
+	*/
+	int		physicsThreadCount;
+
+	/*	How the main thread, job workers, physics and file IO threads are placed on the
+		processors. POLICY_NONE leaves it to the operating system. The other policies
+		give every thread a physical core of its own where possible, and default to one
+		worker per core instead of per hardware thread, avoiding oversubscription on
+		machines with SMT. See bsThreadPlacement.
+		Default: bsThreadPlacement::POLICY_NONE
+	*/
+	bsThreadPlacement::Policy	threadPlacement;
+
+	/*	If true, scenes simulate the next frame on a separate thread while the current
+		frame is rendered, adding one frame of latency.
+		See bsScene::setPipelinedSimulation.
+		Default: false
+	*/
+	bool	pipelinedSimulation;
+
 	/*	The world size is a cube with sides equal to this many meters.
 		Default: 1000.0f
 	*/
@@ -0,0 +1,160 @@
+#include "StdAfx.h"
+
+#include "bsCpuTopology.h"
+
+#include <algorithm>
+
+#include "bsAssert.h"
+#include "bsFixedSizeString.h"
+
+
+namespace
+{
+unsigned int countBits(ULONG_PTR mask)
+{
+	unsigned int count = 0;
+	for (; mask != 0; mask &= mask - 1)
+	{
+		++count;
+	}
+
+	return count;
+}
+
+bool coreIsBefore(const bsCpuTopology::Core& a, const bsCpuTopology::Core& b)
+{
+	if (a.numaNode != b.numaNode)
+	{
+		return a.numaNode < b.numaNode;
+	}
+
+	return a.processorMask < b.processorMask;
+}
+
+//Fallback when the topology can't be read, one core per allowed processor.
+void fillFromProcessMask(bsCpuTopology& topology)
+{
+	DWORD_PTR processMask = 0;
+	DWORD_PTR systemMask = 0;
+	if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask)
+		|| processMask == 0)
+	{
+		processMask = 1;
+	}
+
+	for (unsigned int i = 0; i < sizeof(ULONG_PTR) * 8; ++i)
+	{
+		const ULONG_PTR bit = static_cast<ULONG_PTR>(1) << i;
+		if (processMask & bit)
+		{
+			const bsCpuTopology::Core core = { bit, 0 };
+			topology.cores.push_back(core);
+		}
+	}
+
+	topology.logicalProcessorCount = topology.cores.size();
+	topology.numaNodeCount = 1;
+}
+}
+
+
+bsCpuTopology bsCpuTopology::query()
+{
+	bsCpuTopology topology;
+
+	//Ask for the size first, then fill the buffer.
+	DWORD bufferSize = 0;
+	GetLogicalProcessorInformation(nullptr, &bufferSize);
+
+	std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> information(
+		bufferSize / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+	if (information.empty()
+		|| !GetLogicalProcessorInformation(information.data(), &bufferSize))
+	{
+		fillFromProcessMask(topology);
+
+		return topology;
+	}
+
+	std::vector<std::pair<ULONG_PTR, unsigned int>> numaNodes;
+	for (size_t i = 0; i < information.size(); ++i)
+	{
+		const SYSTEM_LOGICAL_PROCESSOR_INFORMATION& entry = information[i];
+
+		switch (entry.Relationship)
+		{
+		case RelationProcessorCore:
+			{
+				const Core core = { entry.ProcessorMask, 0 };
+				topology.cores.push_back(core);
+				topology.logicalProcessorCount += countBits(entry.ProcessorMask);
+			}
+			break;
+
+		case RelationNumaNode:
+			numaNodes.push_back(std::make_pair(entry.ProcessorMask,
+				static_cast<unsigned int>(entry.NumaNode.NodeNumber)));
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	if (topology.cores.empty())
+	{
+		fillFromProcessMask(topology);
+
+		return topology;
+	}
+
+	for (size_t i = 0; i < topology.cores.size(); ++i)
+	{
+		for (size_t j = 0; j < numaNodes.size(); ++j)
+		{
+			if (topology.cores[i].processorMask & numaNodes[j].first)
+			{
+				topology.cores[i].numaNode = numaNodes[j].second;
+				break;
+			}
+		}
+	}
+	topology.numaNodeCount = std::max<unsigned int>(numaNodes.size(), 1);
+
+	std::sort(topology.cores.begin(), topology.cores.end(), coreIsBefore);
+
+	return topology;
+}
+
+bool bsCpuTopology::hasSmt() const
+{
+	for (size_t i = 0; i < cores.size(); ++i)
+	{
+		if (countBits(cores[i].processorMask) > 1)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+ULONG_PTR bsCpuTopology::getAllProcessorsMask() const
+{
+	ULONG_PTR mask = 0;
+	for (size_t i = 0; i < cores.size(); ++i)
+	{
+		mask |= cores[i].processorMask;
+	}
+
+	return mask;
+}
+
+std::string bsCpuTopology::toString() const
+{
+	bsString128 description;
+	description.printf("%u cores, %u logical processors, %u NUMA node%s", getCoreCount(),
+		logicalProcessorCount, numaNodeCount, numaNodeCount != 1 ? "s" : "");
+
+	return description.c_str();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <Windows.h>
+
+
+/*	The processors of the machine, grouped into physical cores and NUMA nodes.
+
+	Each core has the mask of its logical processors, which contains more than one bit
+	when the core runs several hardware threads (SMT, hyper-threading). Cores are sorted
+	by NUMA node, so cores next to each other in the list share a node where possible.
+
+	Only the processor group of the calling process is seen, which is every processor on
+	machines with at most 64 of them.
+*/
+struct bsCpuTopology
+{
+	struct Core
+	{
+		//Logical processors of this core, as an affinity mask.
+		ULONG_PTR		processorMask;
+		unsigned int	numaNode;
+	};
+
+	bsCpuTopology()
+		: logicalProcessorCount(0)
+		, numaNodeCount(0)
+	{
+	}
+
+	/*	Reads the topology with GetLogicalProcessorInformation. If that fails, every
+		processor the process may run on is treated as its own core on a single node.
+	*/
+	static bsCpuTopology query();
+
+	inline unsigned int getCoreCount() const
+	{
+		return cores.size();
+	}
+
+	//True if any core runs more than one hardware thread.
+	bool hasSmt() const;
+
+	//Mask with every logical processor of every core.
+	ULONG_PTR getAllProcessorsMask() const;
+
+	//Short description like "4 cores, 8 logical processors, 1 NUMA node", for logging.
+	std::string toString() const;
+
+
+	std::vector<Core>	cores;
+	unsigned int		logicalProcessorCount;
+	unsigned int		numaNodeCount;
+};
@@ -9,17 +9,19 @@
 #include "bsDx11Renderer.h"
 #include "bsRenderQueue.h"
 #include "bsRenderTarget.h"
-#include "bsWindow.h"
+#include "bsRenderDevice.h"
 #include "bsFullScreenQuad.h"
 #include "bsShaderManager.h"
 #include "bsAssert.h"
 #include "bsTimer.h"
 #include "bsFrameStatistics.h"
-#include "bsFixedSizeString.h"
+#include "bsMemoryTracker.h"
+#include "bsFrameSnapshot.h"
+#include "bsProfiler.h"
 
 
 bsDeferredRenderer::bsDeferredRenderer(bsDx11Renderer* dx11Renderer,
-	bsShaderManager* shaderManager, bsWindow* window, bsRenderQueue* renderQueue)
+	bsShaderManager* shaderManager, bsRenderQueue* renderQueue)
 	: mDx11Renderer(dx11Renderer)
 	, mShaderManager(shaderManager)
 	, mFxaaPass(shaderManager, dx11Renderer)
@@ -29,16 +31,16 @@ bsDeferredRenderer::bsDeferredRenderer(bsDx11Renderer* dx11Renderer,
 	BS_ASSERT(dx11Renderer);
 	BS_ASSERT(shaderManager);
 
-	ID3D11Device& device = *mDx11Renderer->getDevice();
-	ID3D11DeviceContext& deviceContext = *mDx11Renderer->getDeviceContext();
+	bsRenderDevice& renderDevice = mDx11Renderer->getRenderDevice();
 
-	const int windowWidth = window->getWindowWidth(), windowHeight = window->getWindowHeight();
+	const unsigned int width = mDx11Renderer->getBackBufferWidth();
+	const unsigned int height = mDx11Renderer->getBackBufferHeight();
 	
-	mGBuffer.position	= new bsRenderTarget(windowWidth, windowHeight, device);
-	mGBuffer.normal		= new bsRenderTarget(windowWidth, windowHeight, device);
-	mGBuffer.diffuse	= new bsRenderTarget(windowWidth, windowHeight, device);
-	mLightRenderTarget	= new bsRenderTarget(windowWidth, windowHeight, device);
-	mFinalRenderTarget	= new bsRenderTarget(windowWidth, windowHeight, device);
+	mGBuffer.position	= new bsRenderTarget(width, height, renderDevice);
+	mGBuffer.normal		= new bsRenderTarget(width, height, renderDevice);
+	mGBuffer.diffuse	= new bsRenderTarget(width, height, renderDevice);
+	mLightRenderTarget	= new bsRenderTarget(width, height, renderDevice);
+	mFinalRenderTarget	= new bsRenderTarget(width, height, renderDevice);
 
 	mDx11Renderer->registerRenderTarget(*mGBuffer.position);
 	mDx11Renderer->registerRenderTarget(*mGBuffer.normal);
@@ -52,22 +54,22 @@ bsDeferredRenderer::bsDeferredRenderer(bsDx11Renderer* dx11Renderer,
 	rasterizerDesc.CullMode = D3D11_CULL_BACK;
 	rasterizerDesc.DepthClipEnable = true;
 
-	device.CreateRasterizerState(&rasterizerDesc, &mGeometryRasterizerState);
+	renderDevice.createRasterizerState(rasterizerDesc, &mGeometryRasterizerState);
 
 	rasterizerDesc.DepthClipEnable = false;
 	rasterizerDesc.CullMode = D3D11_CULL_BACK;
-	device.CreateRasterizerState(&rasterizerDesc, &mCullBackFacingNoDepthClip);
+	renderDevice.createRasterizerState(rasterizerDesc, &mCullBackFacingNoDepthClip);
 
 	rasterizerDesc.CullMode = D3D11_CULL_FRONT;
-	device.CreateRasterizerState(&rasterizerDesc, &mCullFrontFacingNoDepthClip);
+	renderDevice.createRasterizerState(rasterizerDesc, &mCullFrontFacingNoDepthClip);
 
 	rasterizerDesc.CullMode = D3D11_CULL_NONE;
-	device.CreateRasterizerState(&rasterizerDesc, &mCullNoneNoDepthClip);
+	renderDevice.createRasterizerState(rasterizerDesc, &mCullNoneNoDepthClip);
 
 
-	deviceContext.RSSetState(mGeometryRasterizerState);
+	renderDevice.setRasterizerState(mGeometryRasterizerState);
 
-	mFullScreenQuad = new bsFullScreenQuad(&device);
+	mFullScreenQuad = new bsFullScreenQuad(renderDevice);
 
 	createShaders();
 
@@ -77,7 +79,7 @@ bsDeferredRenderer::bsDeferredRenderer(bsDx11Renderer* dx11Renderer,
 	blendDesc.IndependentBlendEnable = false;
 	blendDesc.RenderTarget[0].BlendEnable = false;
 	blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
-	HRESULT hresult = device.CreateBlendState(&blendDesc, &mGeometryBlendState);
+	HRESULT hresult = renderDevice.createBlendState(blendDesc, &mGeometryBlendState);
 	BS_ASSERT2(SUCCEEDED(hresult), "Failed to create blend state");
 
 	/*
@@ -99,10 +101,10 @@ bsDeferredRenderer::bsDeferredRenderer(bsDx11Renderer* dx11Renderer,
 	blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
 	blendDesc.RenderTarget[0].RenderTargetWriteMask = 0x0f;
 
-	hresult = device.CreateBlendState(&blendDesc, &mLightBlendState);
+	hresult = renderDevice.createBlendState(blendDesc, &mLightBlendState);
 	BS_ASSERT2(SUCCEEDED(hresult), "Failed to create blend state");
 
-	deviceContext.OMSetBlendState(mGeometryBlendState, nullptr, 0xFFFFFFFF);
+	renderDevice.setBlendState(mGeometryBlendState);
 
 
 	//Depth stencils
@@ -124,15 +126,17 @@ bsDeferredRenderer::bsDeferredRenderer(bsDx11Renderer* dx11Renderer,
 	depthStencilDescription.FrontFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
 	depthStencilDescription.DepthFunc = D3D11_COMPARISON_LESS;
 	
-	device.CreateDepthStencilState(&depthStencilDescription, &mDepthEnabledStencilState);
+	renderDevice.createDepthStencilState(depthStencilDescription,
+		&mDepthEnabledStencilState);
 
 	depthStencilDescription.DepthEnable = false;
 	depthStencilDescription.BackFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
 	depthStencilDescription.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
 	//depthStencilDescription.DepthFunc = D3D11_COMPARISON_LESS;
-	device.CreateDepthStencilState(&depthStencilDescription, &mDepthDisabledStencilState);
+	renderDevice.createDepthStencilState(depthStencilDescription,
+		&mDepthDisabledStencilState);
 
-	deviceContext.OMSetDepthStencilState(mDepthEnabledStencilState, 0);
+	renderDevice.setDepthStencilState(mDepthEnabledStencilState);
 
 	
 
@@ -140,119 +144,72 @@ bsDeferredRenderer::bsDeferredRenderer(bsDx11Renderer* dx11Renderer,
 #ifdef BS_DEBUG
 	//Set names for debugging purposes
 	//Position
-	bsString128 debugData = "SRV GBuffer Position";
-	mGBuffer.position->getShaderResourceView()->SetPrivateData(WKPDID_D3DDebugObjectName,
-		debugData.size(), debugData.c_str());
-
-	debugData = "RTV GBuffer Position";
-	mGBuffer.position->getRenderTargetView()->SetPrivateData(WKPDID_D3DDebugObjectName,
-		debugData.size(), debugData.c_str());
-
-	debugData = "RTT GBuffer Position";
-	mGBuffer.position->getRenderTargetTexture()->SetPrivateData(WKPDID_D3DDebugObjectName,
-		debugData.size(), debugData.c_str());
+	renderDevice.setDebugName(mGBuffer.position->getShaderResourceView(),
+		"SRV GBuffer Position");
+	renderDevice.setDebugName(mGBuffer.position->getRenderTargetView(),
+		"RTV GBuffer Position");
+	renderDevice.setDebugName(mGBuffer.position->getRenderTargetTexture(),
+		"RTT GBuffer Position");
 
 	//Normal
-	debugData = "SRV GBuffer Normal";
-	mGBuffer.normal->getShaderResourceView()->SetPrivateData(WKPDID_D3DDebugObjectName,
-		debugData.size(), debugData.c_str());
-
-	debugData = "RTV GBuffer Normal";
-	mGBuffer.normal->getRenderTargetView()->SetPrivateData(WKPDID_D3DDebugObjectName,
-		debugData.size(), debugData.c_str());
-
-	debugData = "RTT GBuffer Normal";
-	mGBuffer.normal->getRenderTargetTexture()->SetPrivateData(WKPDID_D3DDebugObjectName,
-		debugData.size(), debugData.c_str());
+	renderDevice.setDebugName(mGBuffer.normal->getShaderResourceView(),
+		"SRV GBuffer Normal");
+	renderDevice.setDebugName(mGBuffer.normal->getRenderTargetView(),
+		"RTV GBuffer Normal");
+	renderDevice.setDebugName(mGBuffer.normal->getRenderTargetTexture(),
+		"RTT GBuffer Normal");
 
 	//Diffuse
-	debugData = "SRV GBuffer Diffuse";
-	mGBuffer.diffuse->getShaderResourceView()->SetPrivateData(WKPDID_D3DDebugObjectName,
-		debugData.size(), debugData.c_str());
-
-	debugData = "RTV GBuffer Diffuse";
-	mGBuffer.diffuse->getRenderTargetView()->SetPrivateData(WKPDID_D3DDebugObjectName,
-		debugData.size(), debugData.c_str());
-
-	debugData = "RTT GBuffer Diffuse";
-	mGBuffer.diffuse->getRenderTargetTexture()->SetPrivateData(WKPDID_D3DDebugObjectName,
-		debugData.size(), debugData.c_str());
+	renderDevice.setDebugName(mGBuffer.diffuse->getShaderResourceView(),
+		"SRV GBuffer Diffuse");
+	renderDevice.setDebugName(mGBuffer.diffuse->getRenderTargetView(),
+		"RTV GBuffer Diffuse");
+	renderDevice.setDebugName(mGBuffer.diffuse->getRenderTargetTexture(),
+		"RTT GBuffer Diffuse");
 
 	//Light
-	debugData = "SRV Light";
-	mLightRenderTarget->getShaderResourceView()->SetPrivateData(WKPDID_D3DDebugObjectName,
-		debugData.size(), debugData.c_str());
-
-	debugData = "RTV Light";
-	mLightRenderTarget->getRenderTargetView()->SetPrivateData(WKPDID_D3DDebugObjectName,
-		debugData.size(), debugData.c_str());
-
-	debugData = "RTT Light";
-	mLightRenderTarget->getRenderTargetTexture()->SetPrivateData(WKPDID_D3DDebugObjectName,
-		debugData.size(), debugData.c_str());
+	renderDevice.setDebugName(mLightRenderTarget->getShaderResourceView(), "SRV Light");
+	renderDevice.setDebugName(mLightRenderTarget->getRenderTargetView(), "RTV Light");
+	renderDevice.setDebugName(mLightRenderTarget->getRenderTargetTexture(), "RTT Light");
 
 	//Final target
-	debugData = "SRV Final";
-	mFinalRenderTarget->getShaderResourceView()->SetPrivateData(WKPDID_D3DDebugObjectName,
-		debugData.size(), debugData.c_str());
-
-	debugData = "RTV Final";
-	mFinalRenderTarget->getRenderTargetView()->SetPrivateData(WKPDID_D3DDebugObjectName,
-		debugData.size(), debugData.c_str());
-
-	debugData = "RTT Final";
-	mFinalRenderTarget->getRenderTargetTexture()->SetPrivateData(WKPDID_D3DDebugObjectName,
-		debugData.size(), debugData.c_str());
+	renderDevice.setDebugName(mFinalRenderTarget->getShaderResourceView(), "SRV Final");
+	renderDevice.setDebugName(mFinalRenderTarget->getRenderTargetView(), "RTV Final");
+	renderDevice.setDebugName(mFinalRenderTarget->getRenderTargetTexture(), "RTT Final");
 
 	//Rasterizer states
-	debugData = "RasterizerState Geometry";
-	mGeometryRasterizerState->SetPrivateData(WKPDID_D3DDebugObjectName, debugData.size(),
-		debugData.c_str());
-
-	debugData = "RasterizerState Cull backfacing";
-	mCullBackFacingNoDepthClip->SetPrivateData(WKPDID_D3DDebugObjectName, debugData.size(),
-		debugData.c_str());
-
-	debugData = "RasterizerState Cull frontfacing";
-	mCullFrontFacingNoDepthClip->SetPrivateData(WKPDID_D3DDebugObjectName, debugData.size(),
-		debugData.c_str());
-
-	debugData = "RasterizerState Cull none no depth clip";
-	mCullNoneNoDepthClip->SetPrivateData(WKPDID_D3DDebugObjectName, debugData.size(),
-		debugData.c_str());
+	renderDevice.setDebugName(mGeometryRasterizerState, "RasterizerState Geometry");
+	renderDevice.setDebugName(mCullBackFacingNoDepthClip,
+		"RasterizerState Cull backfacing");
+	renderDevice.setDebugName(mCullFrontFacingNoDepthClip,
+		"RasterizerState Cull frontfacing");
+	renderDevice.setDebugName(mCullNoneNoDepthClip,
+		"RasterizerState Cull none no depth clip");
 
 	//Blend states
-	debugData = "BlendState Geometry";
-	mGeometryBlendState->SetPrivateData(WKPDID_D3DDebugObjectName, debugData.size(),
-		debugData.c_str());
-
-	debugData = "BlendState Light";
-	mLightBlendState->SetPrivateData(WKPDID_D3DDebugObjectName, debugData.size(),
-		debugData.c_str());
+	renderDevice.setDebugName(mGeometryBlendState, "BlendState Geometry");
+	renderDevice.setDebugName(mLightBlendState, "BlendState Light");
 
 	//Depth stencil states
-	debugData = "DepthStencil Depth enabled";
-	mDepthEnabledStencilState->SetPrivateData(WKPDID_D3DDebugObjectName, debugData.size(),
-		debugData.c_str());
-
-	debugData = "DepthStencil Depth disabled";
-	mDepthDisabledStencilState->SetPrivateData(WKPDID_D3DDebugObjectName, debugData.size(),
-		debugData.c_str());
+	renderDevice.setDebugName(mDepthEnabledStencilState, "DepthStencil Depth enabled");
+	renderDevice.setDebugName(mDepthDisabledStencilState, "DepthStencil Depth disabled");
 #endif
 }
 
 bsDeferredRenderer::~bsDeferredRenderer()
 {
-	mGeometryRasterizerState->Release();
-	mCullBackFacingNoDepthClip->Release();
-	mCullFrontFacingNoDepthClip->Release();
-	mCullNoneNoDepthClip->Release();
+	bsRenderDevice& renderDevice = mDx11Renderer->getRenderDevice();
+
+	renderDevice.release(mGeometryRasterizerState);
+	renderDevice.release(mCullBackFacingNoDepthClip);
+	renderDevice.release(mCullFrontFacingNoDepthClip);
+	renderDevice.release(mCullNoneNoDepthClip);
 
-	mGeometryBlendState->Release();
-	mLightBlendState->Release();
+	renderDevice.release(mGeometryBlendState);
+	renderDevice.release(mLightBlendState);
 
-	mDepthEnabledStencilState->Release();
-	mDepthDisabledStencilState->Release();
+	renderDevice.release(mDepthEnabledStencilState);
+	renderDevice.release(mDepthDisabledStencilState);
 
 	delete mFullScreenQuad;
 
@@ -279,64 +236,64 @@ void bsDeferredRenderer::createShaders()
 	inputDesc.Format = DXGI_FORMAT_R32G32_FLOAT;
 	inputLayout.push_back(inputDesc);
 
-	mMergerVertexShader = mShaderManager->getVertexShader("Merger.fx", inputLayout.data(), inputLayout.size());
-	mMergerPixelShader = mShaderManager->getPixelShader("Merger.fx");
+	mMergerVertexShader = mShaderManager->getVertexShader(bsStringId("Merger.fx"),
+		inputLayout.data(), inputLayout.size());
+	mMergerPixelShader = mShaderManager->getPixelShader(bsStringId("Merger.fx"));
 }
 
 void bsDeferredRenderer::renderOneFrame(bsFrameStatistics& frameStatistics)
 {
-	bsTimer timer;
-
-	float preCull, cullDuration,
-		preOpaque, opaqueDuration,
-		preTransparent, transparentDuration,//Normal transparent geometry + 3D texts
-		preLines, linesDuration,
-		preLight, lightDuration,
-		preAccumulate, accumulateDuration,
-		preFxaa, fxaaDuration,
-		prePresent, presentDuration,
-		preStateChange, stateChangeDuration;
-
-	ID3D11DeviceContext* deviceContext = mDx11Renderer->getDeviceContext();
+	bsMemoryTagScope memoryTag(bsMemoryTracker::TAG_RENDER);
+	BS_PROFILE_SCOPE("Render frame");
+
+	//Every zone adds its duration to one of these.
+	float cullDuration = 0.0f;
+	float opaqueDuration = 0.0f;
+	//Normal transparent geometry + 3D texts
+	float transparentDuration = 0.0f;
+	float linesDuration = 0.0f;
+	float lightDuration = 0.0f;
+	float accumulateDuration = 0.0f;
+	float fxaaDuration = 0.0f;
+	float presentDuration = 0.0f;
+	float stateChangeDuration = 0.0f;
+
+	bsRenderDevice& renderDevice = mDx11Renderer->getRenderDevice();
 
 	mRenderQueue->reset();
 
-	preCull = timer.getTimeMilliSeconds();
 	{
+		BS_PROFILE_SCOPE_STAT("Cull", cullDuration);
 		mRenderQueue->startFrame();
 	}
-	cullDuration = timer.getTimeMilliSeconds() - preCull;
 
 	//Set and clear G buffer
-	preStateChange = timer.getTimeMilliSeconds();
 	{
+		BS_PROFILE_SCOPE_STAT("Set G buffer", stateChangeDuration);
 		mDx11Renderer->setRenderTargets(&mGBuffer.position, 3);
 
 		//Enable depth testing.
-		deviceContext->OMSetDepthStencilState(mDepthEnabledStencilState, 0);
+		renderDevice.setDepthStencilState(mDepthEnabledStencilState);
 	}
-	stateChangeDuration = timer.getTimeMilliSeconds() - preStateChange;
 
-	preOpaque = timer.getTimeMilliSeconds();
 	{
+		BS_PROFILE_SCOPE_STAT("Opaque", opaqueDuration);
 		//Draw the geometry into the G buffers.
 		mRenderQueue->drawGeometry();
 	}
-	opaqueDuration = timer.getTimeMilliSeconds() - preOpaque;
 
-	preStateChange = timer.getTimeMilliSeconds();
+	ID3D11ShaderResourceView* shaderResourceViews[4];
 	{
+		BS_PROFILE_SCOPE_STAT("Set light pass", stateChangeDuration);
+
 		//Unbind G buffer render targets.
 		mDx11Renderer->setRenderTargets(nullptr, 3);
 
 		//Set the GBuffer as shader resources, allowing them to be used as input by shaders
-	}
-		ID3D11ShaderResourceView* shaderResourceViews[4];
-	{
 		shaderResourceViews[0] = mGBuffer.position->getShaderResourceView();
 		shaderResourceViews[1] = mGBuffer.normal->getShaderResourceView();
 		shaderResourceViews[2] = mGBuffer.diffuse->getShaderResourceView();
-		deviceContext->PSSetShaderResources(0, 3, shaderResourceViews);
+		renderDevice.setPixelShaderResources(0, 3, shaderResourceViews);
 
 		//////////////////////////////////////////////////////////////////////////
 		//Render lights
@@ -345,49 +302,46 @@ void bsDeferredRenderer::renderOneFrame(bsFrameStatistics& frameStatistics)
 		mDx11Renderer->setRenderTargets(&mLightRenderTarget, 1);
 
 		//Enable light rasterization, ie no cull backfacing
-		deviceContext->RSSetState(mCullFrontFacingNoDepthClip);
+		renderDevice.setRasterizerState(mCullFrontFacingNoDepthClip);
 		//Enable blending
-		deviceContext->OMSetBlendState(mLightBlendState, nullptr, 0xFFFFFFFF);
+		renderDevice.setBlendState(mLightBlendState);
 		//Disable depth
-		deviceContext->OMSetDepthStencilState(mDepthDisabledStencilState, 0);
+		renderDevice.setDepthStencilState(mDepthDisabledStencilState);
 	}
-	stateChangeDuration += timer.getTimeMilliSeconds() - preStateChange;
 
-	
-	preLight = timer.getTimeMilliSeconds();
 	{
+		BS_PROFILE_SCOPE_STAT("Lights", lightDuration);
 		mRenderQueue->drawLights();
 	}
-	lightDuration = timer.getTimeMilliSeconds() - preLight;
 
-	deviceContext->OMSetDepthStencilState(mDepthEnabledStencilState, 0);
+	renderDevice.setDepthStencilState(mDepthEnabledStencilState);
 
 	//Draw lines here since we don't want them to be affected by lights.
-	preLines = timer.getTimeMilliSeconds();
 	{
-		deviceContext->OMSetBlendState(mGeometryBlendState, nullptr, 0xFFFFFFFF);
+		BS_PROFILE_SCOPE_STAT("Lines", linesDuration);
+		renderDevice.setBlendState(mGeometryBlendState);
 		mRenderQueue->drawLines();
-		deviceContext->OMSetBlendState(mLightBlendState, nullptr, 0xFFFFFFFF);
+		renderDevice.setBlendState(mLightBlendState);
 	}
-	linesDuration = timer.getTimeMilliSeconds() - preLines;
 
-	preTransparent = timer.getTimeMilliSeconds();
 	{
+		BS_PROFILE_SCOPE_STAT("Transparent", transparentDuration);
 		mRenderQueue->drawTexts();
 	}
-	transparentDuration = timer.getTimeMilliSeconds() - preTransparent;
 
-	deviceContext->OMSetDepthStencilState(mDepthDisabledStencilState, 0);
+	mRenderQueue->endFrame();
+
+	renderDevice.setDepthStencilState(mDepthDisabledStencilState);
 
 	//////////////////////////////////////////////////////////////////////////
 	//
-	preStateChange = timer.getTimeMilliSeconds();
 	{
+		BS_PROFILE_SCOPE_STAT("Set merge pass", stateChangeDuration);
 		mDx11Renderer->setRenderTargets(&mFinalRenderTarget, 1);
 
 		shaderResourceViews[3] = mLightRenderTarget->getShaderResourceView();
 
-		deviceContext->PSSetShaderResources(0, 4, shaderResourceViews);
+		renderDevice.setPixelShaderResources(0, 4, shaderResourceViews);
 
 		//////////////////////////////////////////////////////////////////////////
 
@@ -395,75 +349,84 @@ void bsDeferredRenderer::renderOneFrame(bsFrameStatistics& frameStatistics)
 		mShaderManager->setVertexShader(mMergerVertexShader);
 
 		//Enable geometry rasterization for fullscreen quad and next geometry pass
-		deviceContext->RSSetState(mGeometryRasterizerState);
-		deviceContext->OMSetBlendState(mGeometryBlendState, nullptr, 0xFFFFFFFF);
+		renderDevice.setRasterizerState(mGeometryRasterizerState);
+		renderDevice.setBlendState(mGeometryBlendState);
 	}
-	stateChangeDuration += timer.getTimeMilliSeconds() - preStateChange;
 
 	//mDx11Renderer->setBackBufferAsRenderTarget();
 	//Draw a fullscreen quad with the merger shader to produce final output.
-	preAccumulate = timer.getTimeMilliSeconds();
 	{
-		mFullScreenQuad->draw(mDx11Renderer->getDeviceContext());
+		BS_PROFILE_SCOPE_STAT("Merge", accumulateDuration);
+		mFullScreenQuad->draw();
 	}
-	accumulateDuration = timer.getTimeMilliSeconds() - preAccumulate;
 
 
 	//////////////////////////////////////////////////////////////////////////
 	//FXAA
 
-	preStateChange = timer.getTimeMilliSeconds();
 	//Unbind previous render target.
 	{
+		BS_PROFILE_SCOPE_STAT("Set FXAA pass", stateChangeDuration);
 		mDx11Renderer->setRenderTargets(nullptr, 1);
 
 		mDx11Renderer->setBackBufferAsRenderTarget();
 
 		shaderResourceViews[0] = mFinalRenderTarget->getShaderResourceView();
-		deviceContext->PSSetShaderResources(0, 1, shaderResourceViews);
+		renderDevice.setPixelShaderResources(0, 1, shaderResourceViews);
 	}
-	stateChangeDuration += timer.getTimeMilliSeconds() - preAccumulate;
 
-	preFxaa = timer.getTimeMilliSeconds();
 	{
+		BS_PROFILE_SCOPE_STAT("FXAA", fxaaDuration);
 		mFxaaPass.draw();
 	}
-	fxaaDuration = timer.getTimeMilliSeconds() - preFxaa;
 
 
 	//deviceContext->OMSetDepthStencilState(mDepthEnabledStencilState, 0);
 	//deviceContext->RSSetState(mGeometryRasterizerState);
 	//mRenderQueue->drawLines();
 
-	preAccumulate = timer.getTimeMilliSeconds();
 	//Unbind shader resource views.
 	{
+		BS_PROFILE_SCOPE_STAT("Unbind resources", accumulateDuration);
 		memset(shaderResourceViews, 0, sizeof(ID3D11ShaderResourceView*)
 			* ARRAYSIZE(shaderResourceViews));
-		deviceContext->PSSetShaderResources(0, 4, shaderResourceViews);
+		renderDevice.setPixelShaderResources(0, 4, shaderResourceViews);
 	}
-	accumulateDuration += timer.getTimeMilliSeconds() - preAccumulate;
 
 	//Call the callbacks
-	for (unsigned int i = 0, count = mEndOfRenderCallbacks.size(); i < count; ++i)
 	{
-		mEndOfRenderCallbacks[i](frameStatistics);
+		BS_PROFILE_SCOPE("End of render callbacks");
+		for (unsigned int i = 0, count = mEndOfRenderCallbacks.size(); i < count; ++i)
+		{
+			mEndOfRenderCallbacks[i](frameStatistics);
+		}
 	}
 
-	prePresent = timer.getTimeMilliSeconds();
 	{
+		BS_PROFILE_SCOPE_STAT("Present", presentDuration);
 		mDx11Renderer->present();
 	}
-	presentDuration = timer.getTimeMilliSeconds() - prePresent;
 
-	preAccumulate = timer.getTimeMilliSeconds();
+	//Age of the presented state, from the capture of the snapshot it was drawn from.
+	const bsFrameSnapshot* snapshot = mRenderQueue->getFrameSnapshot();
+	if (snapshot != nullptr && snapshot->getCaptureTicks() != 0)
+	{
+		const long long age = bsTimer::getTicks() - snapshot->getCaptureTicks();
+		frameStatistics.pipelineInfo.simulationToPresentLatency =
+			static_cast<float>(bsTimer::ticksToMicroSeconds(age) / 1000.0);
+	}
+	else
+	{
+		frameStatistics.pipelineInfo.simulationToPresentLatency = 0.0f;
+	}
+
 	{
+		BS_PROFILE_SCOPE_STAT("Clear", accumulateDuration);
 		mDx11Renderer->clearBackBuffer();
 		mDx11Renderer->clearRenderTargets(&mGBuffer.position, 3);
 		mDx11Renderer->clearRenderTargets(&mLightRenderTarget, 1);
 		mDx11Renderer->clearRenderTargets(&mFinalRenderTarget, 1);
 	}
-	accumulateDuration += timer.getTimeMilliSeconds() - preAccumulate;
 
 
 	//Write frame timings.
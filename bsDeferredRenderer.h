@@ -13,7 +13,6 @@ class bsDx11Renderer;
 class bsRenderQueue;
 class bsShaderManager;
 class bsRenderTarget;
-class bsWindow;
 class bsFullScreenQuad;
 class bsVertexShader;
 class bsPixelShader;
@@ -35,8 +34,11 @@ public:
 	};
 
 
+	/*	Creates the G buffer and the other render targets with the size of the back buffer
+		of the renderer.
+	*/
 	bsDeferredRenderer(bsDx11Renderer* dx11Renderer, bsShaderManager* shaderManager,
-		bsWindow* window, bsRenderQueue* renderQueue);
+		bsRenderQueue* renderQueue);
 
 	~bsDeferredRenderer();
 
@@ -0,0 +1,320 @@
+#include "StdAfx.h"
+
+#include "bsDx11RenderDevice.h"
+
+#include <cstring>
+
+#include "bsAssert.h"
+
+
+bsDx11RenderDevice::bsDx11RenderDevice(ID3D11Device& device,
+	ID3D11DeviceContext& deviceContext, IDXGISwapChain* swapChain)
+	: mDevice(device)
+	, mDeviceContext(deviceContext)
+	, mSwapChain(swapChain)
+#ifdef BS_SUPPORT_D3D11_1
+	, mDeviceContext1(nullptr)
+#endif
+{
+#ifdef BS_SUPPORT_D3D11_1
+	//The D3D11.1 runtime on Windows 7 may not support offsets, even if the driver does.
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options;
+	memset(&options, 0, sizeof(options));
+
+	if (SUCCEEDED(mDevice.CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options,
+		sizeof(options))) && options.ConstantBufferOffsetting)
+	{
+		mDeviceContext.QueryInterface(__uuidof(ID3D11DeviceContext1),
+			reinterpret_cast<void**>(&mDeviceContext1));
+	}
+#endif
+}
+
+bsDx11RenderDevice::~bsDx11RenderDevice()
+{
+#ifdef BS_SUPPORT_D3D11_1
+	if (mDeviceContext1 != nullptr)
+	{
+		mDeviceContext1->Release();
+	}
+#endif
+}
+
+HRESULT bsDx11RenderDevice::createBuffer(const D3D11_BUFFER_DESC& desc,
+	const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Buffer** bufferOut)
+{
+	return mDevice.CreateBuffer(&desc, initialData, bufferOut);
+}
+
+HRESULT bsDx11RenderDevice::createTexture2D(const D3D11_TEXTURE2D_DESC& desc,
+	const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Texture2D** textureOut)
+{
+	return mDevice.CreateTexture2D(&desc, initialData, textureOut);
+}
+
+HRESULT bsDx11RenderDevice::createRenderTargetView(ID3D11Resource* resource,
+	const D3D11_RENDER_TARGET_VIEW_DESC* desc, ID3D11RenderTargetView** viewOut)
+{
+	return mDevice.CreateRenderTargetView(resource, desc, viewOut);
+}
+
+HRESULT bsDx11RenderDevice::createShaderResourceView(ID3D11Resource* resource,
+	const D3D11_SHADER_RESOURCE_VIEW_DESC* desc, ID3D11ShaderResourceView** viewOut)
+{
+	return mDevice.CreateShaderResourceView(resource, desc, viewOut);
+}
+
+HRESULT bsDx11RenderDevice::createDepthStencilView(ID3D11Resource* resource,
+	const D3D11_DEPTH_STENCIL_VIEW_DESC* desc, ID3D11DepthStencilView** viewOut)
+{
+	return mDevice.CreateDepthStencilView(resource, desc, viewOut);
+}
+
+HRESULT bsDx11RenderDevice::createRasterizerState(const D3D11_RASTERIZER_DESC& desc,
+	ID3D11RasterizerState** stateOut)
+{
+	return mDevice.CreateRasterizerState(&desc, stateOut);
+}
+
+HRESULT bsDx11RenderDevice::createBlendState(const D3D11_BLEND_DESC& desc,
+	ID3D11BlendState** stateOut)
+{
+	return mDevice.CreateBlendState(&desc, stateOut);
+}
+
+HRESULT bsDx11RenderDevice::createDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc,
+	ID3D11DepthStencilState** stateOut)
+{
+	return mDevice.CreateDepthStencilState(&desc, stateOut);
+}
+
+HRESULT bsDx11RenderDevice::createSamplerState(const D3D11_SAMPLER_DESC& desc,
+	ID3D11SamplerState** stateOut)
+{
+	return mDevice.CreateSamplerState(&desc, stateOut);
+}
+
+HRESULT bsDx11RenderDevice::createVertexShader(const void* byteCode, size_t byteCodeSize,
+	ID3D11VertexShader** shaderOut)
+{
+	return mDevice.CreateVertexShader(byteCode, byteCodeSize, nullptr, shaderOut);
+}
+
+HRESULT bsDx11RenderDevice::createPixelShader(const void* byteCode, size_t byteCodeSize,
+	ID3D11PixelShader** shaderOut)
+{
+	return mDevice.CreatePixelShader(byteCode, byteCodeSize, nullptr, shaderOut);
+}
+
+HRESULT bsDx11RenderDevice::createInputLayout(const D3D11_INPUT_ELEMENT_DESC* inputDescs,
+	unsigned int inputDescCount, const void* byteCode, size_t byteCodeSize,
+	ID3D11InputLayout** layoutOut)
+{
+	return mDevice.CreateInputLayout(inputDescs, inputDescCount, byteCode, byteCodeSize,
+		layoutOut);
+}
+
+unsigned long bsDx11RenderDevice::release(ID3D11DeviceChild* object)
+{
+	BS_ASSERT(object != nullptr);
+
+	return object->Release();
+}
+
+void bsDx11RenderDevice::setDebugName(ID3D11DeviceChild* object, const char* name)
+{
+	BS_ASSERT(object != nullptr);
+
+	object->SetPrivateData(WKPDID_D3DDebugObjectName, strlen(name), name);
+}
+
+void bsDx11RenderDevice::setRenderTargets(unsigned int count,
+	ID3D11RenderTargetView* const* renderTargetViews,
+	ID3D11DepthStencilView* depthStencilView)
+{
+	mDeviceContext.OMSetRenderTargets(count, renderTargetViews, depthStencilView);
+}
+
+void bsDx11RenderDevice::clearRenderTarget(ID3D11RenderTargetView* renderTargetView,
+	const float* colorRgba)
+{
+	mDeviceContext.ClearRenderTargetView(renderTargetView, colorRgba);
+}
+
+void bsDx11RenderDevice::clearDepthStencil(ID3D11DepthStencilView* depthStencilView,
+	unsigned int clearFlags, float depth, unsigned char stencil)
+{
+	mDeviceContext.ClearDepthStencilView(depthStencilView, clearFlags, depth, stencil);
+}
+
+void bsDx11RenderDevice::setViewport(const D3D11_VIEWPORT& viewport)
+{
+	mDeviceContext.RSSetViewports(1, &viewport);
+}
+
+void bsDx11RenderDevice::setRasterizerState(ID3D11RasterizerState* state)
+{
+	mDeviceContext.RSSetState(state);
+}
+
+void bsDx11RenderDevice::setBlendState(ID3D11BlendState* state)
+{
+	mDeviceContext.OMSetBlendState(state, nullptr, 0xFFFFFFFF);
+}
+
+void bsDx11RenderDevice::setDepthStencilState(ID3D11DepthStencilState* state)
+{
+	mDeviceContext.OMSetDepthStencilState(state, 0);
+}
+
+void bsDx11RenderDevice::setInputLayout(ID3D11InputLayout* inputLayout)
+{
+	mDeviceContext.IASetInputLayout(inputLayout);
+}
+
+void bsDx11RenderDevice::setVertexShader(ID3D11VertexShader* shader)
+{
+	mDeviceContext.VSSetShader(shader, nullptr, 0);
+}
+
+void bsDx11RenderDevice::setGeometryShader(ID3D11GeometryShader* shader)
+{
+	mDeviceContext.GSSetShader(shader, nullptr, 0);
+}
+
+void bsDx11RenderDevice::setPixelShader(ID3D11PixelShader* shader)
+{
+	mDeviceContext.PSSetShader(shader, nullptr, 0);
+}
+
+void bsDx11RenderDevice::setVertexConstantBuffers(unsigned int startSlot,
+	unsigned int count, ID3D11Buffer* const* buffers)
+{
+	mDeviceContext.VSSetConstantBuffers(startSlot, count, buffers);
+}
+
+void bsDx11RenderDevice::setPixelConstantBuffers(unsigned int startSlot,
+	unsigned int count, ID3D11Buffer* const* buffers)
+{
+	mDeviceContext.PSSetConstantBuffers(startSlot, count, buffers);
+}
+
+bool bsDx11RenderDevice::supportsConstantBufferOffsets() const
+{
+#ifdef BS_SUPPORT_D3D11_1
+	return mDeviceContext1 != nullptr;
+#else
+	return false;
+#endif
+}
+
+void bsDx11RenderDevice::setVertexConstantBufferRange(unsigned int slot,
+	ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int constantCount)
+{
+	BS_ASSERT2(supportsConstantBufferOffsets(),
+		"Constant buffer offsets are not supported");
+
+#ifdef BS_SUPPORT_D3D11_1
+	mDeviceContext1->VSSetConstantBuffers1(slot, 1, &buffer, &firstConstant,
+		&constantCount);
+#else
+	(void)slot;
+	(void)buffer;
+	(void)firstConstant;
+	(void)constantCount;
+#endif
+}
+
+void bsDx11RenderDevice::setPixelConstantBufferRange(unsigned int slot,
+	ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int constantCount)
+{
+	BS_ASSERT2(supportsConstantBufferOffsets(),
+		"Constant buffer offsets are not supported");
+
+#ifdef BS_SUPPORT_D3D11_1
+	mDeviceContext1->PSSetConstantBuffers1(slot, 1, &buffer, &firstConstant,
+		&constantCount);
+#else
+	(void)slot;
+	(void)buffer;
+	(void)firstConstant;
+	(void)constantCount;
+#endif
+}
+
+void bsDx11RenderDevice::setPixelShaderResources(unsigned int startSlot,
+	unsigned int count, ID3D11ShaderResourceView* const* views)
+{
+	mDeviceContext.PSSetShaderResources(startSlot, count, views);
+}
+
+void bsDx11RenderDevice::setPixelSamplers(unsigned int startSlot, unsigned int count,
+	ID3D11SamplerState* const* samplers)
+{
+	mDeviceContext.PSSetSamplers(startSlot, count, samplers);
+}
+
+void bsDx11RenderDevice::setPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+	mDeviceContext.IASetPrimitiveTopology(topology);
+}
+
+void bsDx11RenderDevice::setVertexBuffers(unsigned int startSlot, unsigned int count,
+	ID3D11Buffer* const* buffers, const unsigned int* strides,
+	const unsigned int* offsets)
+{
+	mDeviceContext.IASetVertexBuffers(startSlot, count, buffers, strides, offsets);
+}
+
+void bsDx11RenderDevice::setIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format,
+	unsigned int offset)
+{
+	mDeviceContext.IASetIndexBuffer(buffer, format, offset);
+}
+
+void bsDx11RenderDevice::updateBuffer(ID3D11Buffer* buffer, const void* data,
+	unsigned int /*dataSize*/)
+{
+	mDeviceContext.UpdateSubresource(buffer, 0, nullptr, data, 0, 0);
+}
+
+void* bsDx11RenderDevice::mapDiscard(ID3D11Buffer* buffer)
+{
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	if (FAILED(mDeviceContext.Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0,
+		&mappedResource)))
+	{
+		return nullptr;
+	}
+
+	return mappedResource.pData;
+}
+
+void bsDx11RenderDevice::unmap(ID3D11Buffer* buffer)
+{
+	mDeviceContext.Unmap(buffer, 0);
+}
+
+void bsDx11RenderDevice::drawIndexed(unsigned int indexCount, unsigned int startIndex,
+	int baseVertex)
+{
+	mDeviceContext.DrawIndexed(indexCount, startIndex, baseVertex);
+}
+
+void bsDx11RenderDevice::drawIndexedInstanced(unsigned int indexCountPerInstance,
+	unsigned int instanceCount, unsigned int startIndex, int baseVertex,
+	unsigned int startInstance)
+{
+	mDeviceContext.DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndex,
+		baseVertex, startInstance);
+}
+
+HRESULT bsDx11RenderDevice::present(unsigned int syncInterval)
+{
+	if (mSwapChain == nullptr)
+	{
+		return S_OK;
+	}
+
+	return mSwapChain->Present(syncInterval, 0);
+}
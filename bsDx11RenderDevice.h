@@ -0,0 +1,163 @@
+#pragma once
+
+#include <d3d11.h>
+
+//The Windows 8 SDK and later have the D3D11.1 headers, and define _WIN32_WINNT_WIN8.
+#if defined(_WIN32_WINNT_WIN8) && !defined(BS_SUPPORT_D3D11_1) \
+	&& !defined(BS_NO_D3D11_1)
+#define BS_SUPPORT_D3D11_1
+#endif
+
+#ifdef BS_SUPPORT_D3D11_1
+#include <d3d11_1.h>
+#endif
+
+#include "bsRenderDevice.h"
+
+
+/*	Render device forwarding everything to a D3D11 device and its immediate context.
+	Does not take references to the device, context or swap chain, they must outlive it.
+	The swap chain may be null, in which case present does nothing.
+
+	Binding constant buffers from an offset needs the D3D11.1 headers from the Windows 8
+	SDK. BS_SUPPORT_D3D11_1 is defined automatically when building with that SDK or a
+	later one, and offsets are then used where the runtime and driver support them.
+	Define BS_NO_D3D11_1 to always use the D3D11.0 fallback.
+*/
+class bsDx11RenderDevice : public bsRenderDevice
+{
+public:
+	bsDx11RenderDevice(ID3D11Device& device, ID3D11DeviceContext& deviceContext,
+		IDXGISwapChain* swapChain);
+
+	~bsDx11RenderDevice();
+
+
+	virtual HRESULT createBuffer(const D3D11_BUFFER_DESC& desc,
+		const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Buffer** bufferOut);
+
+	virtual HRESULT createTexture2D(const D3D11_TEXTURE2D_DESC& desc,
+		const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Texture2D** textureOut);
+
+	virtual HRESULT createRenderTargetView(ID3D11Resource* resource,
+		const D3D11_RENDER_TARGET_VIEW_DESC* desc, ID3D11RenderTargetView** viewOut);
+
+	virtual HRESULT createShaderResourceView(ID3D11Resource* resource,
+		const D3D11_SHADER_RESOURCE_VIEW_DESC* desc, ID3D11ShaderResourceView** viewOut);
+
+	virtual HRESULT createDepthStencilView(ID3D11Resource* resource,
+		const D3D11_DEPTH_STENCIL_VIEW_DESC* desc, ID3D11DepthStencilView** viewOut);
+
+	virtual HRESULT createRasterizerState(const D3D11_RASTERIZER_DESC& desc,
+		ID3D11RasterizerState** stateOut);
+
+	virtual HRESULT createBlendState(const D3D11_BLEND_DESC& desc,
+		ID3D11BlendState** stateOut);
+
+	virtual HRESULT createDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc,
+		ID3D11DepthStencilState** stateOut);
+
+	virtual HRESULT createSamplerState(const D3D11_SAMPLER_DESC& desc,
+		ID3D11SamplerState** stateOut);
+
+	virtual HRESULT createVertexShader(const void* byteCode, size_t byteCodeSize,
+		ID3D11VertexShader** shaderOut);
+
+	virtual HRESULT createPixelShader(const void* byteCode, size_t byteCodeSize,
+		ID3D11PixelShader** shaderOut);
+
+	virtual HRESULT createInputLayout(const D3D11_INPUT_ELEMENT_DESC* inputDescs,
+		unsigned int inputDescCount, const void* byteCode, size_t byteCodeSize,
+		ID3D11InputLayout** layoutOut);
+
+	virtual unsigned long release(ID3D11DeviceChild* object);
+
+	virtual void setDebugName(ID3D11DeviceChild* object, const char* name);
+
+
+	virtual void setRenderTargets(unsigned int count,
+		ID3D11RenderTargetView* const* renderTargetViews,
+		ID3D11DepthStencilView* depthStencilView);
+
+	virtual void clearRenderTarget(ID3D11RenderTargetView* renderTargetView,
+		const float* colorRgba);
+
+	virtual void clearDepthStencil(ID3D11DepthStencilView* depthStencilView,
+		unsigned int clearFlags, float depth, unsigned char stencil);
+
+	virtual void setViewport(const D3D11_VIEWPORT& viewport);
+
+	virtual void setRasterizerState(ID3D11RasterizerState* state);
+
+	virtual void setBlendState(ID3D11BlendState* state);
+
+	virtual void setDepthStencilState(ID3D11DepthStencilState* state);
+
+	virtual void setInputLayout(ID3D11InputLayout* inputLayout);
+
+	virtual void setVertexShader(ID3D11VertexShader* shader);
+
+	virtual void setGeometryShader(ID3D11GeometryShader* shader);
+
+	virtual void setPixelShader(ID3D11PixelShader* shader);
+
+	virtual void setVertexConstantBuffers(unsigned int startSlot, unsigned int count,
+		ID3D11Buffer* const* buffers);
+
+	virtual void setPixelConstantBuffers(unsigned int startSlot, unsigned int count,
+		ID3D11Buffer* const* buffers);
+
+	virtual bool supportsConstantBufferOffsets() const;
+
+	virtual void setVertexConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer,
+		unsigned int firstConstant, unsigned int constantCount);
+
+	virtual void setPixelConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer,
+		unsigned int firstConstant, unsigned int constantCount);
+
+	virtual void setPixelShaderResources(unsigned int startSlot, unsigned int count,
+		ID3D11ShaderResourceView* const* views);
+
+	virtual void setPixelSamplers(unsigned int startSlot, unsigned int count,
+		ID3D11SamplerState* const* samplers);
+
+	virtual void setPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology);
+
+	virtual void setVertexBuffers(unsigned int startSlot, unsigned int count,
+		ID3D11Buffer* const* buffers, const unsigned int* strides,
+		const unsigned int* offsets);
+
+	virtual void setIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format,
+		unsigned int offset);
+
+	virtual void updateBuffer(ID3D11Buffer* buffer, const void* data,
+		unsigned int dataSize);
+
+	virtual void* mapDiscard(ID3D11Buffer* buffer);
+
+	virtual void unmap(ID3D11Buffer* buffer);
+
+	virtual void drawIndexed(unsigned int indexCount, unsigned int startIndex,
+		int baseVertex);
+
+	virtual void drawIndexedInstanced(unsigned int indexCountPerInstance,
+		unsigned int instanceCount, unsigned int startIndex, int baseVertex,
+		unsigned int startInstance);
+
+	virtual HRESULT present(unsigned int syncInterval);
+
+private:
+	//Non-copyable.
+	bsDx11RenderDevice(const bsDx11RenderDevice&);
+	bsDx11RenderDevice& operator=(const bsDx11RenderDevice&);
+
+
+	ID3D11Device&			mDevice;
+	ID3D11DeviceContext&	mDeviceContext;
+	IDXGISwapChain*			mSwapChain;
+
+#ifdef BS_SUPPORT_D3D11_1
+	//Null if the runtime or driver can't bind constant buffers from an offset.
+	ID3D11DeviceContext1*	mDeviceContext1;
+#endif
+};
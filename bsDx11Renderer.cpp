@@ -2,6 +2,7 @@
 
 #include "bsDx11Renderer.h"
 
+#include "bsDx11RenderDevice.h"
 #include "bsLog.h"
 #include "bsRenderTarget.h"
 #include "bsAssert.h"
@@ -15,87 +16,97 @@ bsDx11Renderer::bsDx11Renderer(HWND hWnd, unsigned int renderWindowWidth, unsign
 	, mDevice(nullptr)
 	, mDeviceContext(nullptr)
 
+	, mRenderDevice(nullptr)
+	, mOwnsRenderDevice(true)
+	, mBackBufferWidth(renderWindowWidth)
+	, mBackBufferHeight(renderWindowHeight)
+
+	, mBackBufferRenderTargetView(nullptr)
 	, mDepthStencil(nullptr)
 	, mDepthStencilView(nullptr)
+	, mScreenSizeBuffer(nullptr)
 
 	, mVsyncEnabled(true)
 	, mIsFullscreenEnabled(false)
 {
-	bsLog::log("Starting initialization of Direct3D 11");
+	BS_LOG_INFO(RENDER, "Starting initialization of Direct3D 11");
 
 	mRenderTargetClearColor[0] = mRenderTargetClearColor[1] = mRenderTargetClearColor[2] = 0.3f;
 	mRenderTargetClearColor[3] = 0.0f;
 
 	createRenderWindow(hWnd, renderWindowWidth, renderWindowHeight);
 
+	createScreenSizeBuffer();
 
+	BS_LOG_INFO(RENDER, "DirectX initialization completed successfully");
+}
 
-	//Create buffer for screen size and upload current size to GPU.
-	{
-		D3D11_BUFFER_DESC bufferDescription = { 0 };
-		bufferDescription.Usage = D3D11_USAGE_DEFAULT;
-		bufferDescription.ByteWidth = sizeof(CBScreenSize);
-		bufferDescription.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-
-		const HRESULT hres = mDevice->CreateBuffer(&bufferDescription, nullptr,
-			&mScreenSizeBuffer);
+bsDx11Renderer::bsDx11Renderer(bsRenderDevice& renderDevice, unsigned int backBufferWidth,
+	unsigned int backBufferHeight)
+	: mSwapChain(nullptr)
+	, mDevice(nullptr)
+	, mDeviceContext(nullptr)
 
-		BS_ASSERT2(SUCCEEDED(hres), "Failed to create screen size buffer");
+	, mRenderDevice(&renderDevice)
+	, mOwnsRenderDevice(false)
+	, mBackBufferWidth(backBufferWidth)
+	, mBackBufferHeight(backBufferHeight)
 
+	, mBackBufferRenderTargetView(nullptr)
+	, mDepthStencil(nullptr)
+	, mDepthStencilView(nullptr)
+	, mScreenSizeBuffer(nullptr)
 
-		CBScreenSize constantBuffer;
-		constantBuffer.screenSizeAndOneOverScreenSize.x = (float)renderWindowWidth;
-		constantBuffer.screenSizeAndOneOverScreenSize.y = (float)renderWindowHeight;
+	, mVsyncEnabled(false)
+	, mIsFullscreenEnabled(false)
+{
+	BS_LOG_INFO(RENDER, "Creating headless renderer with dimensions %ux%u",
+		backBufferWidth, backBufferHeight);
 
-		constantBuffer.screenSizeAndOneOverScreenSize.z =
-			1.0f / constantBuffer.screenSizeAndOneOverScreenSize.x;
-		constantBuffer.screenSizeAndOneOverScreenSize.w =
-			1.0f / constantBuffer.screenSizeAndOneOverScreenSize.y;
+	mRenderTargetClearColor[0] = mRenderTargetClearColor[1] = mRenderTargetClearColor[2] = 0.3f;
+	mRenderTargetClearColor[3] = 0.0f;
 
-		mDeviceContext->PSSetConstantBuffers(4, 1, &mScreenSizeBuffer);
-		mDeviceContext->UpdateSubresource(mScreenSizeBuffer, 0, nullptr,
-			&constantBuffer, 0, 0);
-	}
+	createBackBufferAndDepthStencil(backBufferWidth, backBufferHeight);
 
+	createViewport(backBufferWidth, backBufferHeight);
 
-#ifdef BS_DEBUG
-	//Set debug info in D3D objects to help debugging their lifetimes if necessary.
-	bsString32 debugString("Screen size constant buffer");
-	mScreenSizeBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, debugString.size(),
-		debugString.c_str());
-#endif
-
-	bsLog::log("DirectX initialization completed successfully");
+	createScreenSizeBuffer();
 }
 
 bsDx11Renderer::~bsDx11Renderer()
 {
-	bsLog::log("Uninitializing DirectX");
+	BS_LOG_INFO(RENDER, "Uninitializing DirectX");
 
-	unsigned long remainingRefs = mScreenSizeBuffer->Release();
+	unsigned long remainingRefs = mRenderDevice->release(mScreenSizeBuffer);
 	BS_ASSERT2(remainingRefs == 0, "Screen size buffer has remaining references when"
 		" shutting down");
 	
 	if (mDepthStencil)
 	{
-		remainingRefs = mDepthStencil->Release();
+		remainingRefs = mRenderDevice->release(mDepthStencil);
 		BS_ASSERT2(remainingRefs == 0, "Depth stencil has remaining references when"
 			" shutting down");
 	}
 	if (mDepthStencilView)
 	{
-		remainingRefs = mDepthStencilView->Release();
+		remainingRefs = mRenderDevice->release(mDepthStencilView);
 		BS_ASSERT2(remainingRefs == 0, "Depth stencil view has remaining references when"
 			" shutting down");
 	}
 
 	if (mBackBufferRenderTargetView)
 	{
-		remainingRefs = mBackBufferRenderTargetView->Release();
+		remainingRefs = mRenderDevice->release(mBackBufferRenderTargetView);
 		BS_ASSERT2(remainingRefs == 0, "Back buffer has remaining references when"
 			" shutting down");
 	}
 
+	if (mOwnsRenderDevice)
+	{
+		delete mRenderDevice;
+	}
+	mRenderDevice = nullptr;
+
 	if (mSwapChain)
 	{
 		remainingRefs = mSwapChain->Release();
@@ -119,25 +130,25 @@ bsDx11Renderer::~bsDx11Renderer()
 		BS_ASSERT2(remainingRefs == 0, "Device has remaining references when shutting down");
 	}
 
-	bsLog::log("DirectX successfully uninitialized");
+	BS_LOG_INFO(RENDER, "DirectX successfully uninitialized");
 }
 
 bool bsDx11Renderer::createRenderWindow(HWND hWnd, unsigned int renderWindowWidth,
 	unsigned int renderWindowHeight)
 {
-	bsLog::log("Creating D3D11 device and swap chain");
+	BS_LOG_INFO(RENDER, "Creating D3D11 device and swap chain");
 	if (!createDeviceAndSwapChain(hWnd, renderWindowWidth, renderWindowHeight))
 	{
 		return false;
 	}
 
-	bsLog::log("Creating back buffer and depth stencil");
+	BS_LOG_INFO(RENDER, "Creating back buffer and depth stencil");
 	if (!createBackBufferAndDepthStencil(renderWindowWidth, renderWindowHeight))
 	{
 		return false;
 	}
 
-	bsLog::logf(bsLog::SEV_INFO, "Creating viewport with dimensions %ux%u",
+	BS_LOG_INFO(RENDER, "Creating viewport with dimensions %ux%u",
 		renderWindowWidth, renderWindowHeight);
 	createViewport(renderWindowWidth, renderWindowHeight);
 
@@ -183,6 +194,8 @@ bool bsDx11Renderer::createDeviceAndSwapChain(HWND hWnd, unsigned int windowWidt
 		return false;
 	}
 
+	mRenderDevice = new bsDx11RenderDevice(*mDevice, *mDeviceContext, mSwapChain);
+
 	IDXGIDevice* dxgiDevice;
 	HRESULT hr = mDevice->QueryInterface(__uuidof(IDXGIDevice), (void**)&dxgiDevice);
 
@@ -230,15 +243,39 @@ bool bsDx11Renderer::createBackBufferAndDepthStencil(unsigned int windowWidth,
 {
 	//Back buffer
 	ID3D11Texture2D* backBuffer = nullptr;
-	if (FAILED(mSwapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), (void**)&backBuffer)))
+	if (mSwapChain != nullptr)
 	{
-		BS_ASSERT2(false, "Failed to create back buffer");
+		if (FAILED(mSwapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), (void**)&backBuffer)))
+		{
+			BS_ASSERT2(false, "Failed to create back buffer");
 
-		return false;
+			return false;
+		}
 	}
+	else
+	{
+		//Headless, draw into an offscreen texture instead of a swap chain buffer.
+		D3D11_TEXTURE2D_DESC backBufferDesc = { 0 };
+		backBufferDesc.Width = windowWidth;
+		backBufferDesc.Height = windowHeight;
+		backBufferDesc.MipLevels = 1;
+		backBufferDesc.ArraySize = 1;
+		backBufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		backBufferDesc.SampleDesc.Count = 1;
+		backBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+		backBufferDesc.BindFlags = D3D11_BIND_RENDER_TARGET;
+
+		if (FAILED(mRenderDevice->createTexture2D(backBufferDesc, nullptr, &backBuffer)))
+		{
+			BS_ASSERT2(false, "Failed to create back buffer");
 
+			return false;
+		}
+	}
 
-	if (FAILED(mDevice->CreateRenderTargetView(backBuffer, nullptr, &mBackBufferRenderTargetView)))
+
+	if (FAILED(mRenderDevice->createRenderTargetView(backBuffer, nullptr,
+		&mBackBufferRenderTargetView)))
 	{
 		BS_ASSERT2(false, "Failed to create back buffer render target view");
 
@@ -246,16 +283,12 @@ bool bsDx11Renderer::createBackBufferAndDepthStencil(unsigned int windowWidth,
 	}
 
 #ifdef BS_DEBUG
-	bsString32 debugString("Back buffer");
-	backBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, debugString.size(),
-		debugString.c_str());
-
-	debugString = "Back buffer render target view";
-	mBackBufferRenderTargetView->SetPrivateData(WKPDID_D3DDebugObjectName, debugString.size(),
-		debugString.c_str());
+	mRenderDevice->setDebugName(backBuffer, "Back buffer");
+	mRenderDevice->setDebugName(mBackBufferRenderTargetView,
+		"Back buffer render target view");
 #endif
 
-	backBuffer->Release();
+	mRenderDevice->release(backBuffer);
 
 	//Depth stencil
 	D3D11_TEXTURE2D_DESC depthDesc = { 0 };
@@ -271,7 +304,7 @@ bool bsDx11Renderer::createBackBufferAndDepthStencil(unsigned int windowWidth,
 	depthDesc.CPUAccessFlags = 0;
 	depthDesc.MiscFlags = 0;
 
-	if (FAILED(mDevice->CreateTexture2D(&depthDesc, nullptr, &mDepthStencil)))
+	if (FAILED(mRenderDevice->createTexture2D(depthDesc, nullptr, &mDepthStencil)))
 	{
 		BS_ASSERT2(false, "Failed to create depth stencil texture");
 
@@ -305,7 +338,7 @@ bool bsDx11Renderer::createBackBufferAndDepthStencil(unsigned int windowWidth,
 	depthViewDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
 	depthViewDesc.Texture2D.MipSlice = 0;
 
-	if (FAILED(mDevice->CreateDepthStencilView(mDepthStencil, &depthViewDesc,
+	if (FAILED(mRenderDevice->createDepthStencilView(mDepthStencil, &depthViewDesc,
 		&mDepthStencilView)))
 	{
 		BS_ASSERT2(false, "Failed to create depth stencil view");
@@ -314,13 +347,8 @@ bool bsDx11Renderer::createBackBufferAndDepthStencil(unsigned int windowWidth,
 	}
 
 #ifdef BS_DEBUG
-	debugString = "Depth stencil";
-	mDepthStencil->SetPrivateData(WKPDID_D3DDebugObjectName, debugString.size(),
-		debugString.c_str());
-
-	debugString = "Depth stencil view";
-	mDepthStencilView->SetPrivateData(WKPDID_D3DDebugObjectName, debugString.size(),
-		debugString.c_str());
+	mRenderDevice->setDebugName(mDepthStencil, "Depth stencil");
+	mRenderDevice->setDebugName(mDepthStencilView, "Depth stencil view");
 #endif
 
 	return true;
@@ -336,7 +364,7 @@ void bsDx11Renderer::createViewport(unsigned int windowWidth, unsigned int windo
 	viewport.TopLeftX = 0;
 	viewport.TopLeftY = 0;
 
-	mDeviceContext->RSSetViewports(1, &viewport);
+	mRenderDevice->setViewport(viewport);
 }
 
 void bsDx11Renderer::resizeWindow(HWND hWnd, unsigned int windowWidth, unsigned int windowHeight)
@@ -344,27 +372,33 @@ void bsDx11Renderer::resizeWindow(HWND hWnd, unsigned int windowWidth, unsigned
 	BS_ASSERT2(windowWidth > 0 && windowHeight > 0, "Invalid window dimensions");
 	BS_ASSERT2(windowWidth < 8192 && windowHeight < 8192, "Invalid window dimensions");
 
-	bsLog::logf(bsLog::SEV_INFO, "Resizing window to %ux%u", windowWidth, windowHeight);
-
-	mDepthStencilView->Release();
-	mDepthStencil->Release();
-	mBackBufferRenderTargetView->Release();
+	BS_LOG_INFO(RENDER, "Resizing window to %ux%u", windowWidth, windowHeight);
 
+	mRenderDevice->release(mDepthStencilView);
+	mRenderDevice->release(mDepthStencil);
+	mRenderDevice->release(mBackBufferRenderTargetView);
 
-	const HRESULT hres = mSwapChain->ResizeBuffers(
-		0,//Buffer count, 0 preserves the existing number of buffers in the swap chain.
-		windowWidth, windowHeight,
-		DXGI_FORMAT_UNKNOWN,//DXGI format, UNKNOWN preserves current.
-		0);//Flags.
+	mBackBufferWidth = windowWidth;
+	mBackBufferHeight = windowHeight;
 
-	if (!SUCCEEDED(hres))
+	if (mSwapChain != nullptr)
 	{
-		std::string errorMessage = bsWindowsUtils::winApiErrorCodeToString(GetLastError());
+		const HRESULT hres = mSwapChain->ResizeBuffers(
+			0,//Buffer count, 0 preserves the existing number of buffers in the swap chain.
+			windowWidth, windowHeight,
+			DXGI_FORMAT_UNKNOWN,//DXGI format, UNKNOWN preserves current.
+			0);//Flags.
 
-		bsLog::logf(bsLog::SEV_CRICICAL, "Failed to resize swap chain, error message: %s",
-			errorMessage.c_str());
+		if (!SUCCEEDED(hres))
+		{
+			std::string errorMessage =
+				bsWindowsUtils::winApiErrorCodeToString(GetLastError());
+
+			BS_LOG_CRITICAL(RENDER, "Failed to resize swap chain, error message: %s",
+				errorMessage.c_str());
 
-		BS_ASSERT2(SUCCEEDED(hres), "Failed to resize swap chain buffers");
+			BS_ASSERT2(SUCCEEDED(hres), "Failed to resize swap chain buffers");
+		}
 	}
 
 
@@ -377,7 +411,7 @@ void bsDx11Renderer::resizeWindow(HWND hWnd, unsigned int windowWidth, unsigned
 	//Resize all registered render targets.
 	for (unsigned int i = 0; i < mRenderTargets.size(); ++i)
 	{
-		if (!mRenderTargets[i]->windowResized(windowWidth, windowHeight, *mDevice))
+		if (!mRenderTargets[i]->windowResized(windowWidth, windowHeight))
 		{
 			BS_ASSERT2(false, "Failed to resize render targets");
 		}
@@ -389,25 +423,48 @@ void bsDx11Renderer::resizeWindow(HWND hWnd, unsigned int windowWidth, unsigned
 	}
 
 	//Upload updated screen size to GPU.
-	{
-		CBScreenSize constantBuffer;
-		constantBuffer.screenSizeAndOneOverScreenSize.x = (float)windowWidth;
-		constantBuffer.screenSizeAndOneOverScreenSize.y = (float)windowHeight;
-
-		constantBuffer.screenSizeAndOneOverScreenSize.z =
-			1.0f / constantBuffer.screenSizeAndOneOverScreenSize.x;
-		constantBuffer.screenSizeAndOneOverScreenSize.w =
-			1.0f / constantBuffer.screenSizeAndOneOverScreenSize.y;
-
-		mDeviceContext->PSSetConstantBuffers(4, 1, &mScreenSizeBuffer);
-		mDeviceContext->UpdateSubresource(mScreenSizeBuffer, 0, nullptr,
-			&constantBuffer, 0, 0);
-	}
+	uploadScreenSize();
+}
+
+void bsDx11Renderer::createScreenSizeBuffer()
+{
+	D3D11_BUFFER_DESC bufferDescription = { 0 };
+	bufferDescription.Usage = D3D11_USAGE_DEFAULT;
+	bufferDescription.ByteWidth = sizeof(CBScreenSize);
+	bufferDescription.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+
+	const HRESULT hres = mRenderDevice->createBuffer(bufferDescription, nullptr,
+		&mScreenSizeBuffer);
+
+	BS_ASSERT2(SUCCEEDED(hres), "Failed to create screen size buffer");
+
+#ifdef BS_DEBUG
+	//Set debug info in D3D objects to help debugging their lifetimes if necessary.
+	mRenderDevice->setDebugName(mScreenSizeBuffer, "Screen size constant buffer");
+#endif
+
+	uploadScreenSize();
+}
+
+void bsDx11Renderer::uploadScreenSize()
+{
+	CBScreenSize constantBuffer;
+	constantBuffer.screenSizeAndOneOverScreenSize.x = (float)mBackBufferWidth;
+	constantBuffer.screenSizeAndOneOverScreenSize.y = (float)mBackBufferHeight;
+
+	constantBuffer.screenSizeAndOneOverScreenSize.z =
+		1.0f / constantBuffer.screenSizeAndOneOverScreenSize.x;
+	constantBuffer.screenSizeAndOneOverScreenSize.w =
+		1.0f / constantBuffer.screenSizeAndOneOverScreenSize.y;
+
+	mRenderDevice->setPixelConstantBuffers(4, 1, &mScreenSizeBuffer);
+	mRenderDevice->updateBuffer(mScreenSizeBuffer, &constantBuffer,
+		sizeof(constantBuffer));
 }
 
 void bsDx11Renderer::present() const
 {
-	if (FAILED(mSwapChain->Present(mVsyncEnabled ? 1 : 0, 0)))
+	if (FAILED(mRenderDevice->present(mVsyncEnabled ? 1 : 0)))
 	{
 		BS_ASSERT(!"IDXGISwapChain::Present failed");
 	}
@@ -433,7 +490,7 @@ HRESULT bsDx11Renderer::compileShader(const char* fileName, const char* entryPoi
 	{
 		if (errorBlob != nullptr)
 		{
-			bsLog::logf(bsLog::SEV_ERROR, "Failed to compile shader '%s. Error message: %s",
+			BS_LOG_ERROR(RENDER, "Failed to compile shader '%s. Error message: %s",
 				fileName, errorBlob->GetBufferPointer());
 
 			OutputDebugStringA((char*)errorBlob->GetBufferPointer());
@@ -442,7 +499,7 @@ HRESULT bsDx11Renderer::compileShader(const char* fileName, const char* entryPoi
 		}
 		else
 		{
-			bsLog::logf(bsLog::SEV_ERROR, "Failed to compile shader '%s'", fileName);
+			BS_LOG_ERROR(RENDER, "Failed to compile shader '%s'", fileName);
 
 		}
 	}
@@ -473,12 +530,13 @@ void bsDx11Renderer::setRenderTargets(bsRenderTarget** renderTargets,
 		}
 	}
 
-	mDeviceContext->OMSetRenderTargets(renderTargetCount, renderTargetViews, mDepthStencilView);
+	mRenderDevice->setRenderTargets(renderTargetCount, renderTargetViews,
+		mDepthStencilView);
 }
 
 void bsDx11Renderer::setBackBufferAsRenderTarget()
 {
-	mDeviceContext->OMSetRenderTargets(1, &mBackBufferRenderTargetView, mDepthStencilView);
+	mRenderDevice->setRenderTargets(1, &mBackBufferRenderTargetView, mDepthStencilView);
 }
 
 void bsDx11Renderer::clearRenderTargets(bsRenderTarget** renderTargets, unsigned int count)
@@ -486,16 +544,17 @@ void bsDx11Renderer::clearRenderTargets(bsRenderTarget** renderTargets, unsigned
 	//Clear every render target provided with pre-defined clear color.
 	for (unsigned int i = 0; i < count; ++i)
 	{
-		mDeviceContext->ClearRenderTargetView(renderTargets[i]->getRenderTargetView(),
+		mRenderDevice->clearRenderTarget(renderTargets[i]->getRenderTargetView(),
 			mRenderTargetClearColor);
 	}
 }
 
 void bsDx11Renderer::clearBackBuffer()
 {
-	mDeviceContext->ClearRenderTargetView(mBackBufferRenderTargetView, mRenderTargetClearColor);
+	mRenderDevice->clearRenderTarget(mBackBufferRenderTargetView,
+		mRenderTargetClearColor);
 	//Clear depth buffer to 1.0 (max depth)
-	mDeviceContext->ClearDepthStencilView(mDepthStencilView, D3D11_CLEAR_DEPTH, 1.0f, 0);
+	mRenderDevice->clearDepthStencil(mDepthStencilView, D3D11_CLEAR_DEPTH, 1.0f, 0);
 }
 
 void bsDx11Renderer::setRenderTargetClearColor(float* colorRgba)
@@ -540,6 +599,12 @@ void bsDx11Renderer::setFullscreenMode(bool enableFullscreen)
 		return;
 	}
 
+	if (mSwapChain == nullptr)
+	{
+		//Headless, there is no window to make fullscreen.
+		return;
+	}
+
 	//This sends a WM_SIZE message which will result in resizeWindow being called.
 	mSwapChain->SetFullscreenState(enableFullscreen, nullptr);
 
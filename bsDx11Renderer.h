@@ -9,6 +9,7 @@
 #include <vector>
 
 class bsRenderTarget;
+class bsRenderDevice;
 
 
 class bsDx11Renderer
@@ -16,6 +17,14 @@ class bsDx11Renderer
 public:
 	bsDx11Renderer(HWND hWnd, unsigned int renderWindowWidth, unsigned int renderWindowHeight);
 
+	/*	Creates a renderer without a window or swap chain, drawing into an offscreen back
+		buffer created by renderDevice, which must outlive the renderer.
+		Used with bsNullRenderDevice to run the frame path headless. getDevice and
+		getDeviceContext return null for renderers created this way.
+	*/
+	bsDx11Renderer(bsRenderDevice& renderDevice, unsigned int backBufferWidth,
+		unsigned int backBufferHeight);
+
 	~bsDx11Renderer();
 
 
@@ -41,6 +50,22 @@ public:
 		return mDevice;
 	}
 
+	//The device everything in the frame path creates, binds and draws through.
+	inline bsRenderDevice& getRenderDevice() const
+	{
+		return *mRenderDevice;
+	}
+
+	inline unsigned int getBackBufferWidth() const
+	{
+		return mBackBufferWidth;
+	}
+
+	inline unsigned int getBackBufferHeight() const
+	{
+		return mBackBufferHeight;
+	}
+
 	HRESULT compileShader(const char* fileName, const char* entryPoint,
 		const char* shaderModel, ID3DBlob** blobOut) const;
 
@@ -91,10 +116,22 @@ private:
 
 	void createViewport(unsigned int windowWidth, unsigned int windowHeight);
 
+	//Creates the screen size constant buffer, binds it and uploads the current size.
+	void createScreenSizeBuffer();
+
+	void uploadScreenSize();
+
 
 	IDXGISwapChain*			mSwapChain;
 	ID3D11Device*			mDevice;
 	ID3D11DeviceContext*	mDeviceContext;
+
+	bsRenderDevice*			mRenderDevice;
+	//False when the render device was provided by the creator of a headless renderer.
+	bool					mOwnsRenderDevice;
+
+	unsigned int			mBackBufferWidth;
+	unsigned int			mBackBufferHeight;
 	ID3D11RenderTargetView*	mBackBufferRenderTargetView;
 
 	ID3D11Texture2D*		mDepthStencil;
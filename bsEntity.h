@@ -1,7 +1,6 @@
 #pragma once
 
 #include <memory>//std::shared_ptr
-#include <stdlib.h>//_aligned_malloc/_aligned_free
 
 #include <Common/Base/hkBase.h>
 #include <Common/Base/Types/hkRefPtr.h>
@@ -10,6 +9,7 @@
 #include "bsTransform.h"
 #include "bsCollision.h"
 #include "bsAssert.h"
+#include "bsMemoryTracker.h"
 
 class hkpRigidBody;
 
@@ -56,11 +56,11 @@ __declspec(align(16)) class bsEntity
 public:
 	inline void* operator new(size_t)
 	{
-		return _aligned_malloc(sizeof(bsEntity), 16);
+		return bsMemoryTracker::allocate(sizeof(bsEntity), 16, bsMemoryTracker::TAG_SCENE);
 	}
 	inline void operator delete(void* p)
 	{
-		_aligned_free(p);
+		bsMemoryTracker::deallocate(p);
 	}
 
 
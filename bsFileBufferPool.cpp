@@ -0,0 +1,103 @@
+#include "StdAfx.h"
+
+#include "bsFileBufferPool.h"
+
+#include <stdlib.h>
+
+#include "bsAssert.h"
+
+
+bsFileBufferPool::bsFileBufferPool(size_t retentionLimit)
+	: mRetainedBytes(0)
+	, mRetentionLimit(retentionLimit)
+{
+	mHits = 0;
+	mMisses = 0;
+}
+
+bsFileBufferPool::~bsFileBufferPool()
+{
+	for (unsigned int i = 0; i < kSizeClassCount; ++i)
+	{
+		for (size_t j = 0; j < mFreeBuffers[i].size(); ++j)
+		{
+			free(mFreeBuffers[i][j]);
+		}
+	}
+}
+
+unsigned int bsFileBufferPool::getSizeClass(size_t size)
+{
+	unsigned int sizeClass = 0;
+	while (sizeClass < kSizeClassCount
+		&& (static_cast<size_t>(1) << (sizeClass + kMinSizeClassShift)) < size)
+	{
+		++sizeClass;
+	}
+
+	return sizeClass;
+}
+
+char* bsFileBufferPool::acquire(size_t size, size_t& capacityOut)
+{
+	const unsigned int sizeClass = getSizeClass(size);
+
+	if (sizeClass == kSizeClassCount)
+	{
+		//Too large to pool.
+		++mMisses;
+
+		capacityOut = size;
+		return static_cast<char*>(malloc(size));
+	}
+
+	capacityOut = static_cast<size_t>(1) << (sizeClass + kMinSizeClassShift);
+
+	{
+		tbb::spin_mutex::scoped_lock lock(mMutex);
+
+		std::vector<char*>& freeBuffers = mFreeBuffers[sizeClass];
+		if (!freeBuffers.empty())
+		{
+			char* buffer = freeBuffers.back();
+			freeBuffers.pop_back();
+			mRetainedBytes -= capacityOut;
+
+			++mHits;
+
+			return buffer;
+		}
+	}
+
+	++mMisses;
+
+	return static_cast<char*>(malloc(capacityOut));
+}
+
+void bsFileBufferPool::release(char* buffer, size_t capacity)
+{
+	if (buffer == nullptr)
+	{
+		return;
+	}
+
+	const unsigned int sizeClass = getSizeClass(capacity);
+
+	if (sizeClass != kSizeClassCount)
+	{
+		BS_ASSERT2((static_cast<size_t>(1) << (sizeClass + kMinSizeClassShift)) == capacity,
+			"Released buffer was not acquired from this pool");
+
+		tbb::spin_mutex::scoped_lock lock(mMutex);
+
+		if (mRetainedBytes + capacity <= mRetentionLimit)
+		{
+			mFreeBuffers[sizeClass].push_back(buffer);
+			mRetainedBytes += capacity;
+
+			return;
+		}
+	}
+
+	free(buffer);
+}
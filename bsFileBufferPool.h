@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+
+#include <tbb/spin_mutex.h>
+#include <tbb/atomic.h>
+
+
+/*	Pool of buffers used by file loaders to read files into.
+	Buffers are grouped in power of two size classes, and released buffers are kept for
+	reuse until the total size of the retained buffers reaches a limit.
+
+	Acquiring and releasing buffers is thread safe.
+*/
+class bsFileBufferPool
+{
+public:
+	/*	The retention limit is the maximum total size of released buffers kept for reuse,
+		in bytes.
+	*/
+	bsFileBufferPool(size_t retentionLimit = 64 * 1024 * 1024);
+
+	~bsFileBufferPool();
+
+	/*	Gets a buffer of at least the requested size.
+		The actual capacity of the buffer is written to capacityOut, and must be passed to
+		release along with the buffer.
+	*/
+	char* acquire(size_t size, size_t& capacityOut);
+
+	/*	Returns a buffer to the pool, or frees it if the pool is full.
+	*/
+	void release(char* buffer, size_t capacity);
+
+	//Number of acquires satisfied by a previously released buffer.
+	inline unsigned int getHitCount() const
+	{
+		return mHits;
+	}
+
+	//Number of acquires which had to allocate a new buffer.
+	inline unsigned int getMissCount() const
+	{
+		return mMisses;
+	}
+
+private:
+	//Smallest size class is 4 KB, largest 64 MB. Larger buffers are not pooled.
+	static const unsigned int kMinSizeClassShift = 12;
+	static const unsigned int kSizeClassCount = 15;
+
+	//Returns the size class for the size, or kSizeClassCount if it's too large to pool.
+	static unsigned int getSizeClass(size_t size);
+
+	//Non-copyable.
+	bsFileBufferPool(const bsFileBufferPool&);
+	bsFileBufferPool& operator=(const bsFileBufferPool&);
+
+
+	std::vector<char*>	mFreeBuffers[kSizeClassCount];
+	size_t				mRetainedBytes;
+	const size_t		mRetentionLimit;
+
+	tbb::spin_mutex		mMutex;
+
+	tbb::atomic<unsigned int>	mHits;
+	tbb::atomic<unsigned int>	mMisses;
+};
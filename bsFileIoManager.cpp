@@ -6,14 +6,33 @@
 
 #include <Windows.h>
 
+#include "bsFileSystem.h"
+#include "bsPackFile.h"
 #include "bsLog.h"
 #include "bsAssert.h"
 #include "bsWindowsUtils.h"
 #include "bsFileUtil.h"
+#include "bsTimer.h"
+#include "bsMemoryTracker.h"
+#include "bsProfiler.h"
 
 
+namespace
+{
+//Packed files are identified by file name only, without any directories.
+inline const char* fileNameWithoutPath(const std::string& path)
+{
+	const size_t lastSeparator = path.find_last_of("\\/");
+
+	return path.c_str() + (lastSeparator == std::string::npos ? 0 : lastSeparator + 1);
+}
+}
+
 void bsFileIoManager::threadLoop()
 {
+	bsMemoryTagScope memoryTag(bsMemoryTracker::TAG_IO);
+	bsProfiler::setThreadName("Background File Loader");
+
 	while (!mQuit)
 	{
 		if (!mAsynchronousLoaders.empty())
@@ -32,15 +51,111 @@ void bsFileIoManager::threadLoop()
 
 void bsFileIoManager::processRequest()
 {
-	FilenameCallbackPair asyncFileLoader;
-	while (mAsynchronousLoadRequests.try_pop(asyncFileLoader))
+	LoadRequest request;
+	while (mAsynchronousLoadRequests.try_pop(request))
 	{
+		const std::string& fileName = request.fileName;
+		const long long nowTicks = bsTimer::getTicks();
+
+		mStatistics.recordQueueWait(nowTicks - request.addedTicks);
+
+		auto inFlightRequest = mInFlightRequests.find(fileName);
+		if (inFlightRequest != mInFlightRequests.end())
+		{
+			//Already being loaded, call this callback too when it completes.
+			inFlightRequest->second.callbacks.push_back(request.callback);
+			mStatistics.requestCoalesced();
+
+			continue;
+		}
+
+		//Added before creating the loader since packed files complete immediately.
+		InFlightRequest& newRequest = mInFlightRequests[fileName];
+		newRequest.callbacks.push_back(request.callback);
+		newRequest.startTicks = nowTicks;
+		mStatistics.asyncLoadStarted(nowTicks);
+
 		//Create a new async file loader to process the popped request.
-		mAsynchronousLoaders.push_back(new bsFileLoader(asyncFileLoader.first,
-			bsFileLoader::ASYNCHRONOUS, asyncFileLoader.second));
+		mAsynchronousLoaders.push_back(createLoader(fileName,
+			[this, fileName](const bsFileLoader& fileLoader)
+		{
+			requestCompleted(fileName, fileLoader);
+		}));
 	};
 }
 
+void bsFileIoManager::requestCompleted(const std::string& fileName,
+	const bsFileLoader& fileLoader)
+{
+	auto inFlightRequest = mInFlightRequests.find(fileName);
+	BS_ASSERT2(inFlightRequest != mInFlightRequests.end(), "Completed load request was not"
+		" in flight");
+
+	const long long completedTicks = bsTimer::getTicks();
+	mStatistics.recordRead(completedTicks - inFlightRequest->second.startTicks,
+		fileLoader.getLoadedDataSize(), true);
+	mStatistics.asyncLoadCompleted(completedTicks);
+
+	std::vector<AsyncCompletionCallback> callbacks;
+	callbacks.swap(inFlightRequest->second.callbacks);
+	mInFlightRequests.erase(inFlightRequest);
+
+	for (size_t i = 0; i < callbacks.size(); ++i)
+	{
+		callbacks[i](fileLoader);
+	}
+
+	mStatistics.recordDecode(bsTimer::getTicks() - completedTicks);
+}
+
+bsFileLoader* bsFileIoManager::createLoader(const std::string& fileName,
+	const AsyncCompletionCallback& callback)
+{
+	if (mFileSystem)
+	{
+		const bsPackFile* packFile;
+		const bsPackFileEntry* entry;
+		if (mFileSystem->findPackedFile(fileNameWithoutPath(fileName), packFile, entry))
+		{
+			return new bsFileLoader(*packFile, *entry, callback, &mBufferPool);
+		}
+	}
+
+	return new bsFileLoader(fileName, bsFileLoader::ASYNCHRONOUS, callback, &mBufferPool);
+}
+
+bsFileLoader bsFileIoManager::loadBlocking(const std::string& fileName,
+	bool searchPacks /*= true*/)
+{
+	mStatistics.requestAdded();
+
+	const long long startTicks = bsTimer::getTicks();
+
+	bsFileLoader fileLoader(createBlockingLoader(fileName, searchPacks));
+
+	mStatistics.recordRead(bsTimer::getTicks() - startTicks, fileLoader.getLoadedDataSize(),
+		false);
+
+	return std::move(fileLoader);
+}
+
+bsFileLoader bsFileIoManager::createBlockingLoader(const std::string& fileName,
+	bool searchPacks)
+{
+	if (mFileSystem && searchPacks)
+	{
+		const bsPackFile* packFile;
+		const bsPackFileEntry* entry;
+		if (mFileSystem->findPackedFile(fileNameWithoutPath(fileName), packFile, entry))
+		{
+			return std::move(bsFileLoader(*packFile, *entry, nullptr, &mBufferPool));
+		}
+	}
+
+	return std::move(bsFileLoader(fileName, bsFileLoader::SYNCHRONOUS, nullptr,
+		&mBufferPool));
+}
+
 void bsFileIoManager::removeCompletedRequests()
 {
 	//Check state of all contained loaders, and remove the ones that are no
@@ -73,13 +188,13 @@ void bsFileIoManager::shutdown()
 		BOOL success = CancelIo(currentHandle);
 		if (success == 0)
 		{
-			bsLog::logf(bsLog::SEV_ERROR, "Cancellation of async I/O failed, error message: %s",
+			BS_LOG_ERROR(IO, "Cancellation of async I/O failed, error message: %s",
 				bsWindowsUtils::winApiErrorCodeToString(GetLastError()).c_str());
 		}
 		success = CloseHandle(currentHandle);
 		if (success == 0)
 		{
-			bsLog::logf(bsLog::SEV_ERROR, "Closing of handle failed, error message: %s",
+			BS_LOG_ERROR(IO, "Closing of handle failed, error message: %s",
 				bsWindowsUtils::winApiErrorCodeToString(GetLastError()).c_str());
 		}
 
@@ -88,6 +203,20 @@ void bsFileIoManager::shutdown()
 
 	mAsynchronousLoaders.clear();
 	mAsynchronousLoadRequests.clear();
+	mInFlightRequests.clear();
+
+	const unsigned int poolHits = mBufferPool.getHitCount();
+	const unsigned int poolAcquires = poolHits + mBufferPool.getMissCount();
+	BS_LOG_INFO(IO, "File IO: %u requests, %u coalesced, buffer pool hit rate"
+		" %.1f%% (%u of %u)", mStatistics.getRequestCount(),
+		mStatistics.getCoalescedRequestCount(),
+		poolAcquires ? 100.0f * poolHits / poolAcquires : 0.0f, poolHits, poolAcquires);
+
+	const bsHistogram& readTimes = mStatistics.getReadMicroSeconds();
+	BS_LOG_INFO(IO, "File IO: %llu bytes, %.2f MB/s, read time p50/p95/p99:"
+		" %llu/%llu/%llu us", mStatistics.getTotalBytes(), mStatistics.getThroughputMBps(),
+		readTimes.getPercentile(50.0f), readTimes.getPercentile(95.0f),
+		readTimes.getPercentile(99.0f));
 }
 
 void bsFileIoManager::addAsynchronousLoadRequest(const std::string& fileName,
@@ -96,9 +225,22 @@ void bsFileIoManager::addAsynchronousLoadRequest(const std::string& fileName,
 	//Make sure it's a not an empty callback.
 	BS_ASSERT2(callback, "Invalid callback");
 
-	BS_ASSERT2(bsFileUtil::fileExists(fileName.c_str()), "Load request for file which does"
-		" not exist added");
+#ifdef BS_DEBUG
+	if (!bsFileUtil::fileExists(fileName.c_str()))
+	{
+		const bsPackFile* packFile;
+		const bsPackFileEntry* entry;
+		BS_ASSERT2(mFileSystem && mFileSystem->findPackedFile(fileNameWithoutPath(fileName), packFile,
+			entry), "Load request for file which does not exist added");
+	}
+#endif
+
+	mStatistics.requestAdded();
+
+	LoadRequest request;
+	request.fileName = fileName;
+	request.callback = callback;
+	request.addedTicks = bsTimer::getTicks();
 
-	mAsynchronousLoadRequests.push(std::move
-		(std::make_pair<std::string, AsyncCompletionCallback>(fileName, callback)));
+	mAsynchronousLoadRequests.push(request);
 }
\ No newline at end of file
@@ -4,25 +4,38 @@
 #include <utility>
 #include <vector>
 #include <string>
+#include <unordered_map>
 
 #include <tbb/concurrent_queue.h>
+#include <tbb/atomic.h>
 
 #include "bsFileLoader.h"
+#include "bsFileBufferPool.h"
+#include "bsFileIoStatistics.h"
 
+class bsFileSystem;
 
 /*	Manager responsible for handling file load requests.
 	Supports both asynchronous (non-blocking) and synchronous (blocking) loading.
-	
+
+	If a file system is set, files are looked up by name in its mounted pack files before
+	being loaded from disk.
+
+	Files are read into buffers from a pool, which are recycled once the completion
+	callback has returned. Asynchronous requests for a file which is already being loaded
+	are coalesced into the existing load, and every callback is called when it completes.
+
+	Timings and sizes of every request are recorded, see getStatistics.
 */
 class bsFileIoManager
 {
 public:
 	typedef std::function<void(const bsFileLoader&)> AsyncCompletionCallback;
-	typedef std::pair<std::string, AsyncCompletionCallback> FilenameCallbackPair;
 
 
 	bsFileIoManager()
-		: mQuit(false)
+		: mFileSystem(nullptr)
+		, mQuit(false)
 	{}
 
 	~bsFileIoManager()
@@ -39,10 +52,44 @@ public:
 
 	/*	Loads a file and blocks until it is completely loaded/fails to load.
 		You may want to use this function when loading a small object
+		If searchPacks is false, the file is read from disk even if a mounted pack
+		contains a file with the same name, for example to reload a changed loose file.
+	*/
+	bsFileLoader loadBlocking(const std::string& fileName, bool searchPacks = true);
+
+	/*	Sets the file system whose mounted pack files are searched before loading files
+		from disk. Must be called before any load requests are added.
+	*/
+	inline void setFileSystem(const bsFileSystem* fileSystem)
+	{
+		mFileSystem = fileSystem;
+	}
+
+	inline const bsFileIoStatistics& getStatistics() const
+	{
+		return mStatistics;
+	}
+
+	/*	Read times are also recorded into this metric, in microseconds, to make them part
+		of the metrics exported while running. Must be set before the thread loop starts.
+	*/
+	inline void setReadLatencyMetric(bsMetricHistogram* metric)
+	{
+		mStatistics.setReadLatencyMetric(metric);
+	}
+
+	inline const bsFileBufferPool& getBufferPool() const
+	{
+		return mBufferPool;
+	}
+
+	/*	Writes the statistics to a JSON file, for example for tracking performance
+		regressions.
+		Returns false if the file could not be written.
 	*/
-	inline bsFileLoader loadBlocking(const std::string& fileName)
+	inline bool writeStatistics(const std::string& fileName) const
 	{
-		return std::move(bsFileLoader(fileName, bsFileLoader::SYNCHRONOUS, nullptr));
+		return mStatistics.writeJson(fileName, mBufferPool);
 	}
 
 	/*	Makes the thread loop exit, making it possible to join the thread running it
@@ -73,15 +120,56 @@ private:
 	*/
 	void shutdown();
 
+	/*	Creates a file loader for a blocking load, loading it from a pack file if
+		searchPacks is true and one of the mounted packs contains it.
+	*/
+	bsFileLoader createBlockingLoader(const std::string& fileName, bool searchPacks);
+
+	/*	Creates a file loader for the file, loading it from a pack file if one of the
+		mounted packs contains it.
+	*/
+	bsFileLoader* createLoader(const std::string& fileName,
+		const AsyncCompletionCallback& callback);
+
+	/*	Called when an asynchronous load has completed, calls the callbacks of every
+		request coalesced into the load.
+	*/
+	void requestCompleted(const std::string& fileName, const bsFileLoader& fileLoader);
+
+
+	struct LoadRequest
+	{
+		std::string				fileName;
+		AsyncCompletionCallback	callback;
+		//bsTimer::getTicks when the request was added.
+		long long				addedTicks;
+	};
+
+	struct InFlightRequest
+	{
+		std::vector<AsyncCompletionCallback>	callbacks;
+		//bsTimer::getTicks when loading started.
+		long long								startTicks;
+	};
 
 	//Async requests only, no synchronous ones.
-	tbb::concurrent_queue<FilenameCallbackPair>	mAsynchronousLoadRequests;
+	tbb::concurrent_queue<LoadRequest>	mAsynchronousLoadRequests;
 
 	/*	All stored async requests, in no particular order. May contain file loaders whose
 		state is completed, failed and incomplete at any given time.
 	*/
 	std::vector<bsFileLoader*>	mAsynchronousLoaders;
 
+	/*	Callbacks waiting for each file currently being loaded asynchronously.
+		Only accessed by the file IO thread.
+	*/
+	std::unordered_map<std::string, InFlightRequest>	mInFlightRequests;
+
+	bsFileBufferPool	mBufferPool;
+	bsFileIoStatistics	mStatistics;
+
+	const bsFileSystem*	mFileSystem;
+
 	//Set by quit(), terminates the thread loop.
 	bool	mQuit;
 };
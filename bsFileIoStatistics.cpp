@@ -0,0 +1,115 @@
+#include "StdAfx.h"
+
+#include "bsFileIoStatistics.h"
+
+#include <stdio.h>
+
+#include "bsFileBufferPool.h"
+#include "bsMetrics.h"
+#include "bsLog.h"
+
+
+bsFileIoStatistics::bsFileIoStatistics()
+	: mReadLatencyMetric(nullptr)
+{
+	mRequestCount = 0;
+	mCoalescedRequestCount = 0;
+	mAsyncBytes = 0;
+	mInFlightCount = 0;
+	mPeakInFlightCount = 0;
+	mBusyTicks = 0;
+	mBusyStartTicks = 0;
+}
+
+void bsFileIoStatistics::recordRead(long long ticks, unsigned long bytes, bool asynchronous)
+{
+	const unsigned long long microSeconds = ticksToRecordedMicroSeconds(ticks);
+	mReadMicroSeconds.record(microSeconds);
+	mRequestBytes.record(bytes);
+
+	if (mReadLatencyMetric)
+	{
+		mReadLatencyMetric->record(microSeconds);
+	}
+
+	if (asynchronous)
+	{
+		mAsyncBytes += bytes;
+	}
+}
+
+void bsFileIoStatistics::asyncLoadStarted(long long nowTicks)
+{
+	const unsigned int inFlightCount = ++mInFlightCount;
+	if (inFlightCount == 1)
+	{
+		mBusyStartTicks = nowTicks;
+	}
+
+	//Only the IO thread writes the peak, no need for compare and swap.
+	if (inFlightCount > mPeakInFlightCount)
+	{
+		mPeakInFlightCount = inFlightCount;
+	}
+}
+
+void bsFileIoStatistics::asyncLoadCompleted(long long nowTicks)
+{
+	if (--mInFlightCount == 0)
+	{
+		mBusyTicks += nowTicks - mBusyStartTicks;
+	}
+}
+
+double bsFileIoStatistics::getThroughputMBps() const
+{
+	long long busyTicks = mBusyTicks;
+	if (mInFlightCount != 0)
+	{
+		//Include the current busy period.
+		busyTicks += bsTimer::getTicks() - mBusyStartTicks;
+	}
+
+	const double busySeconds = bsTimer::ticksToMicroSeconds(busyTicks) * 1e-6;
+
+	return busySeconds > 0.0 ? (mAsyncBytes / (1024.0 * 1024.0)) / busySeconds : 0.0;
+}
+
+bool bsFileIoStatistics::writeJson(const std::string& fileName,
+	const bsFileBufferPool& bufferPool) const
+{
+#pragma warning (disable : 4996)//warning C4996: 'fopen' was declared deprecated
+	FILE* file = fopen(fileName.c_str(), "w");
+#pragma warning (default : 4996)
+	if (!file)
+	{
+		BS_LOG_ERROR(IO, "Failed to open '%s' for writing file IO statistics",
+			fileName.c_str());
+
+		return false;
+	}
+
+	fprintf(file, "{\n");
+	fprintf(file, "\t\"requests\": %u,\n", getRequestCount());
+	fprintf(file, "\t\"coalescedRequests\": %u,\n", getCoalescedRequestCount());
+	fprintf(file, "\t\"bufferPoolHits\": %u,\n", bufferPool.getHitCount());
+	fprintf(file, "\t\"bufferPoolMisses\": %u,\n", bufferPool.getMissCount());
+	fprintf(file, "\t\"totalBytes\": %llu,\n", getTotalBytes());
+	fprintf(file, "\t\"throughputMBps\": %.3f,\n", getThroughputMBps());
+	fprintf(file, "\t\"peakInFlight\": %u,\n", getPeakInFlightCount());
+
+	fprintf(file, "\t\"queueWaitMicroSeconds\": ");
+	mQueueWaitMicroSeconds.writeJson(file);
+	fprintf(file, ",\n\t\"readMicroSeconds\": ");
+	mReadMicroSeconds.writeJson(file);
+	fprintf(file, ",\n\t\"decodeMicroSeconds\": ");
+	mDecodeMicroSeconds.writeJson(file);
+	fprintf(file, ",\n\t\"requestBytes\": ");
+	mRequestBytes.writeJson(file);
+	fprintf(file, "\n}\n");
+
+	const bool success = ferror(file) == 0;
+	fclose(file);
+
+	return success;
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <string>
+
+#include <tbb/atomic.h>
+
+#include "bsHistogram.h"
+#include "bsTimer.h"
+
+class bsFileBufferPool;
+class bsMetricHistogram;
+
+
+/*	Statistics about file loading collected by bsFileIoManager.
+	All values can be read from any thread while loading is in progress.
+
+	Timings are in microseconds:
+	Queue wait: From an asynchronous request being added until it starts loading.
+	Read: From starting to load a file until all of its data has been read.
+	Decode: Time spent in completion callbacks for an asynchronous load, which is where
+		loaded data is turned into resources.
+*/
+class bsFileIoStatistics
+{
+public:
+	bsFileIoStatistics();
+
+
+	//Recording functions, called by bsFileIoManager.
+
+	inline void requestAdded()
+	{
+		++mRequestCount;
+	}
+
+	inline void requestCoalesced()
+	{
+		++mCoalescedRequestCount;
+	}
+
+	inline void recordQueueWait(long long ticks)
+	{
+		mQueueWaitMicroSeconds.record(ticksToRecordedMicroSeconds(ticks));
+	}
+
+	void recordRead(long long ticks, unsigned long bytes, bool asynchronous);
+
+	inline void recordDecode(long long ticks)
+	{
+		mDecodeMicroSeconds.record(ticksToRecordedMicroSeconds(ticks));
+	}
+
+	/*	Called when an asynchronous load starts and completes.
+		Must only be called from the file IO thread.
+	*/
+	void asyncLoadStarted(long long nowTicks);
+
+	void asyncLoadCompleted(long long nowTicks);
+
+	//Read times are also recorded into this metric if it is not null.
+	inline void setReadLatencyMetric(bsMetricHistogram* metric)
+	{
+		mReadLatencyMetric = metric;
+	}
+
+
+	inline unsigned int getRequestCount() const
+	{
+		return mRequestCount;
+	}
+
+	inline unsigned int getCoalescedRequestCount() const
+	{
+		return mCoalescedRequestCount;
+	}
+
+	inline const bsHistogram& getQueueWaitMicroSeconds() const
+	{
+		return mQueueWaitMicroSeconds;
+	}
+
+	inline const bsHistogram& getReadMicroSeconds() const
+	{
+		return mReadMicroSeconds;
+	}
+
+	inline const bsHistogram& getDecodeMicroSeconds() const
+	{
+		return mDecodeMicroSeconds;
+	}
+
+	inline const bsHistogram& getRequestBytes() const
+	{
+		return mRequestBytes;
+	}
+
+	inline unsigned long long getTotalBytes() const
+	{
+		return mRequestBytes.getSum();
+	}
+
+	//Number of asynchronous loads currently in progress.
+	inline unsigned int getInFlightCount() const
+	{
+		return mInFlightCount;
+	}
+
+	inline unsigned int getPeakInFlightCount() const
+	{
+		return mPeakInFlightCount;
+	}
+
+	/*	Returns the average throughput of asynchronous loading in megabytes per second,
+		counting only the time when at least one load was in progress.
+	*/
+	double getThroughputMBps() const;
+
+	/*	Writes all statistics to a JSON file.
+		Returns false if the file could not be written.
+	*/
+	bool writeJson(const std::string& fileName, const bsFileBufferPool& bufferPool) const;
+
+private:
+	static inline unsigned long long ticksToRecordedMicroSeconds(long long ticks)
+	{
+		return ticks > 0 ? static_cast<unsigned long long>(bsTimer::ticksToMicroSeconds(ticks))
+			: 0;
+	}
+
+	//Non-copyable.
+	bsFileIoStatistics(const bsFileIoStatistics&);
+	bsFileIoStatistics& operator=(const bsFileIoStatistics&);
+
+
+	tbb::atomic<unsigned int>	mRequestCount;
+	tbb::atomic<unsigned int>	mCoalescedRequestCount;
+
+	bsHistogram		mQueueWaitMicroSeconds;
+	bsHistogram		mReadMicroSeconds;
+	bsHistogram		mDecodeMicroSeconds;
+	bsHistogram		mRequestBytes;
+
+	bsMetricHistogram*	mReadLatencyMetric;
+
+	//Bytes loaded asynchronously, used for throughput.
+	tbb::atomic<unsigned long long>	mAsyncBytes;
+
+	tbb::atomic<unsigned int>	mInFlightCount;
+	tbb::atomic<unsigned int>	mPeakInFlightCount;
+
+	//Total time with at least one asynchronous load in progress, excluding the current
+	//busy period which started at mBusyStartTicks.
+	tbb::atomic<long long>		mBusyTicks;
+	tbb::atomic<long long>		mBusyStartTicks;
+};
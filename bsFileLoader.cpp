@@ -4,18 +4,24 @@
 
 #include <string>
 
+#include "bsPackFile.h"
+#include "bsFileBufferPool.h"
 #include "bsWindowsUtils.h"
 #include "bsLog.h"
 #include "bsAssert.h"
 
 
 bsFileLoader::bsFileLoader(const std::string& fileName, LoadingMethod loadingMethod,
-	const std::function<void(const bsFileLoader&)>& completionCallback)
+	const std::function<void(const bsFileLoader&)>& completionCallback,
+	bsFileBufferPool* bufferPool)
 	: mLoadState(INCOMPLETE)
 	, mLoadingMethod(loadingMethod)
 	, mFileHandle(nullptr)
 	, mDataSize(0)
 	, mData(nullptr)
+	, mOwnsData(true)
+	, mBufferPool(bufferPool)
+	, mDataCapacity(0)
 	, mFileName(fileName)
 	, mCompletionCallback(completionCallback)
 {
@@ -51,6 +57,49 @@ bsFileLoader::bsFileLoader(const std::string& fileName, LoadingMethod loadingMet
 	}
 }
 
+bsFileLoader::bsFileLoader(const bsPackFile& packFile, const bsPackFileEntry& entry,
+	const std::function<void(const bsFileLoader&)>& completionCallback,
+	bsFileBufferPool* bufferPool)
+	: mLoadState(INCOMPLETE)
+	, mLoadingMethod(SYNCHRONOUS)//No overlapped I/O is performed.
+	, mFileHandle(nullptr)
+	, mDataSize(entry.originalSize)
+	, mData(nullptr)
+	, mOwnsData(true)
+	, mBufferPool(bufferPool)
+	, mDataCapacity(0)
+	, mFileName(packFile.getEntryName(entry))
+	, mCompletionCallback(completionCallback)
+{
+	memset(&mOverlapped, 0, sizeof(mOverlapped));
+
+	if (entry.flags & bsPackFileEntry::COMPRESSED)
+	{
+		allocateData(mDataSize);
+
+		mLoadState = packFile.readEntry(entry, mData) ? SUCCEEDED : FAILED;
+	}
+	else
+	{
+		//Use the mapped data directly, the pack outlives any loader using it.
+		mData = const_cast<char*>(packFile.getEntryData(entry));
+		mOwnsData = false;
+
+		mLoadState = SUCCEEDED;
+	}
+
+	if (mCompletionCallback)
+	{
+		mCompletionCallback(*this);
+	}
+
+	if (mLoadState == SUCCEEDED)
+	{
+		BS_LOG_DEBUG(IO, "Successfully loaded '%s' from '%s'", mFileName.c_str(),
+			packFile.getFileName().c_str());
+	}
+}
+
 bsFileLoader::bsFileLoader(bsFileLoader&& other)
 	: mLoadState(other.mLoadState)
 	, mLoadingMethod(other.mLoadingMethod)
@@ -58,6 +107,9 @@ bsFileLoader::bsFileLoader(bsFileLoader&& other)
 	, mOverlapped()//Unused for synchronous.
 	, mDataSize(other.mDataSize)
 	, mData(other.mData)
+	, mOwnsData(other.mOwnsData)
+	, mBufferPool(other.mBufferPool)
+	, mDataCapacity(other.mDataCapacity)
 	, mFileName(std::move(other.mFileName))
 	, mCompletionCallback(nullptr)//Unused for synchronous.
 {
@@ -68,11 +120,35 @@ bsFileLoader::bsFileLoader(bsFileLoader&& other)
 
 	other.mDataSize = 0;
 	other.mData = nullptr;
+	other.mDataCapacity = 0;
 }
 
 bsFileLoader::~bsFileLoader()
 {
-	free(mData);
+	if (mOwnsData)
+	{
+		if (mBufferPool)
+		{
+			mBufferPool->release(mData, mDataCapacity);
+		}
+		else
+		{
+			free(mData);
+		}
+	}
+}
+
+void bsFileLoader::allocateData(unsigned long size)
+{
+	if (mBufferPool)
+	{
+		mData = mBufferPool->acquire(size, mDataCapacity);
+	}
+	else
+	{
+		mData = static_cast<char*>(malloc(size));
+		mDataCapacity = size;
+	}
 }
 
 void bsFileLoader::createHandle()
@@ -88,7 +164,7 @@ void bsFileLoader::createHandle()
 	{
 		//Probably invalid file/not permission to access.
 
-		bsLog::logf(bsLog::SEV_ERROR, "Failed to create file handle for '%s'."
+		BS_LOG_ERROR(IO, "Failed to create file handle for '%s'."
 			" Error message: %s", mFileName.c_str(),
 			bsWindowsUtils::winApiErrorCodeToString(GetLastError()).c_str());
 
@@ -117,6 +193,9 @@ void bsFileLoader::loadFileAsync()
 			mDataSize = 0;
 			CloseHandle(mFileHandle);
 
+			//The completion routine is never called, so call the callback directly.
+			mCompletionCallback(*this);
+
 			return;
 		}
 
@@ -130,14 +209,14 @@ void bsFileLoader::loadFileAsync()
 		mOverlapped.hEvent = this;
 
 		//Only using LowPart, file sizes over 4 GB will not work.
-		mData = static_cast<char*>(malloc(fileSize.LowPart));
+		allocateData(fileSize.LowPart);
 
 		const BOOL readFileSuccess = ReadFileEx(mFileHandle, mData, fileSize.LowPart,
 			&mOverlapped, &loadingFinishedCallback);
 
 		if (readFileSuccess == 0)
 		{
-			bsLog::logf(bsLog::SEV_ERROR, "Failed to read file '%s'. Error message: %s",
+			BS_LOG_ERROR(IO, "Failed to read file '%s'. Error message: %s",
 				mFileName.c_str(),
 				bsWindowsUtils::winApiErrorCodeToString(GetLastError()).c_str());
 
@@ -166,7 +245,7 @@ void bsFileLoader::loadFileBlocking()
 		}
 
 		//Only using LowPart, file sizes over 4 GB will not work.
-		mData = static_cast<char*>(malloc(fileSize.LowPart));
+		allocateData(fileSize.LowPart);
 
 		//ReadFile blocks until it completes.
 		const BOOL readFileSuccess = ReadFile(mFileHandle, mData, fileSize.LowPart,
@@ -174,7 +253,7 @@ void bsFileLoader::loadFileBlocking()
 
 		if (readFileSuccess == 0)
 		{
-			bsLog::logf(bsLog::SEV_ERROR, "Failed to read file '%s'. Error message: %s",
+			BS_LOG_ERROR(IO, "Failed to read file '%s'. Error message: %s",
 				mFileName.c_str(),
 				bsWindowsUtils::winApiErrorCodeToString(GetLastError()).c_str());
 
@@ -202,7 +281,7 @@ void WINAPI bsFileLoader::loadingFinishedCallback(DWORD errorCode, DWORD numByte
 	{
 		//Something went wrong while loading.
 
-		bsLog::logf(bsLog::SEV_ERROR, "An error occured while reading file '%s'."
+		BS_LOG_ERROR(IO, "An error occured while reading file '%s'."
 			" Error message: %s", loader.mFileName.c_str(),
 			bsWindowsUtils::winApiErrorCodeToString(GetLastError()).c_str());
 
@@ -220,7 +299,7 @@ void WINAPI bsFileLoader::loadingFinishedCallback(DWORD errorCode, DWORD numByte
 	{
 		//Overlapped operation failed.
 
-		bsLog::logf(bsLog::SEV_ERROR, "An error occured getting overlapped result '%s'."
+		BS_LOG_ERROR(IO, "An error occured getting overlapped result '%s'."
 			" Error message: %s", loader.mFileName.c_str(),
 			bsWindowsUtils::winApiErrorCodeToString(GetLastError()).c_str());
 
@@ -234,5 +313,5 @@ void WINAPI bsFileLoader::loadingFinishedCallback(DWORD errorCode, DWORD numByte
 	loader.mLoadState = SUCCEEDED;
 	loader.mCompletionCallback(loader);
 
-	bsLog::logf(bsLog::SEV_INFO, "Successfully loaded '%s'", loader.mFileName.c_str());
+	BS_LOG_DEBUG(IO, "Successfully loaded '%s'", loader.mFileName.c_str());
 }
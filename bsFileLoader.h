@@ -5,6 +5,9 @@
 
 #include <Windows.h>
 
+class bsPackFile;
+struct bsPackFileEntry;
+class bsFileBufferPool;
 
 /*	A file loader with support for both asynchronous and synchronous file loading.
 	Which method to load a file is specified as a constructor argument.
@@ -44,9 +47,23 @@ public:
 		If loading is successful, it will have been loaded once the constructor returns.
 
 		Use getCurrentLoadState and getLoadedData to get the loaded data.
+
+		If a buffer pool is provided, the data is read into a buffer from the pool, which is
+		returned to the pool when the file loader is destroyed.
 	*/
 	bsFileLoader(const std::string& fileName, LoadingMethod loadMethod,
-		const std::function<void(const bsFileLoader&)>& completionCallback = nullptr);
+		const std::function<void(const bsFileLoader&)>& completionCallback = nullptr,
+		bsFileBufferPool* bufferPool = nullptr);
+
+	/*	Loads a file from a mounted pack file. This always completes before the constructor
+		returns, and the completion callback (if any) is called from the constructor.
+
+		Uncompressed entries are not copied, the loaded data points directly into the
+		pack's memory mapping and must not be written to.
+	*/
+	bsFileLoader(const bsPackFile& packFile, const bsPackFileEntry& entry,
+		const std::function<void(const bsFileLoader&)>& completionCallback = nullptr,
+		bsFileBufferPool* bufferPool = nullptr);
 
 	/*	Never use this constructor for an asynchronous file loader, it requires to stay in
 		the same memory address while loading.
@@ -72,6 +89,8 @@ public:
 		Note: This data will go out of scope when the file loader does, which happens
 		at an undefined point in time after the callback function has been called.
 
+		Note: Data loaded from a pack file may be read-only, see the pack file constructor.
+
 		Note: The returned char array is not null terminated. To initialize a std::string,
 		do the following:
 		std::string(getLoadedData(), getLoadedData() + getLoadedDataSize());
@@ -125,6 +144,9 @@ private:
 
 	void loadFileBlocking();
 
+	//Allocates mData, from the buffer pool if there is one.
+	void allocateData(unsigned long size);
+
 	/*	Called by Windows on file load completion/failure.
 		Calls the user defined callback function given in the constructor.
 	*/
@@ -144,6 +166,12 @@ private:
 	OVERLAPPED		mOverlapped;
 	unsigned long	mDataSize;
 	char*			mData;
+	//False if mData points into a pack file's memory mapping.
+	bool			mOwnsData;
+
+	//Null if mData was allocated with malloc.
+	bsFileBufferPool*	mBufferPool;
+	size_t				mDataCapacity;
 
 	const std::string	mFileName;
 	const std::function<void(const bsFileLoader&)>	mCompletionCallback;
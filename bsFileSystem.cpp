@@ -2,56 +2,587 @@
 
 #include "bsFileSystem.h"
 
+#include <algorithm>
+#include <stdio.h>
+
 #include <boost/filesystem.hpp>
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
 
+#include "bsPackFile.h"
+#include "bsHash.h"
+#include "bsFileUtil.h"
 #include "bsLog.h"
 #include "bsAssert.h"
 
 
-bsFileSystem::bsFileSystem(const std::string& basePath)
+/*	Cache file layout:
+
+Byte		Description
+1-4			File format identification, "bsfc" (chars).
+5-8			Version information (uint).
+9-12		Amount of directories (uint).
+13-16		Amount of files (uint).
+17-20		Size of the string pool, in bytes (uint).
+21-24		Offset of the base path in the string pool (uint).
+
+25-...		DirectoryEntry * directory count (defined by bytes 9-12).
+...-...		FileEntry * file count (defined by bytes 13-16), sorted by name hash.
+...-...		String pool, null terminated strings referenced by offset.
+*/
+
+/*	Version info is stored in the cache, and must be equal to this value when loaded.
+
+	Version history:
+	0: Initial version.
+*/
+const unsigned int kCacheVersion = 0;
+
+namespace
+{
+struct CacheHeader
+{
+	char			magic[4];
+	unsigned int	version;
+	unsigned int	directoryCount;
+	unsigned int	fileCount;
+	unsigned int	stringPoolSize;
+	unsigned int	basePathOffset;
+};
+
+struct ScannedFile
+{
+	ScannedFile(const boost::filesystem::path& path)
+		: name(path.filename().string())
+		, path(path.relative_path().string())
+	{}
+
+	std::string	name;
+	std::string	path;
+};
+
+struct ScannedDirectory
+{
+	ScannedDirectory(const std::string& path)
+		: path(path)
+		, lastWriteTime(bsFileUtil::lastWriteTime(path.c_str()))
+	{}
+
+	std::string			path;
+	unsigned long long	lastWriteTime;
+};
+
+struct ScanResult
+{
+	std::vector<ScannedFile>		files;
+	std::vector<ScannedDirectory>	directories;
+};
+
+//Recursively scans a directory, recording every file and directory found.
+void scanDirectory(const boost::filesystem::path& directory, ScanResult& result)
+{
+	result.directories.push_back(ScannedDirectory(directory.string()));
+
+	boost::filesystem::recursive_directory_iterator itr(directory);
+	boost::filesystem::recursive_directory_iterator end;
+
+	for (; itr != end; ++itr)
+	{
+		if (boost::filesystem::is_regular_file(itr->path()))
+		{
+			result.files.push_back(ScannedFile(itr->path()));
+		}
+		else if (boost::filesystem::is_directory(itr->path()))
+		{
+			result.directories.push_back(ScannedDirectory(itr->path().string()));
+		}
+	}
+}
+}
+
+
+bsFileSystem::bsFileSystem(const std::string& basePath, const std::string& cacheFileName)
 	: mBasePath(basePath)
+	, mNextChangeListenerId(0)
 {
 	BS_ASSERT2(mBasePath.length(), "Zero length base path is not OK.");
 
+	if (!cacheFileName.empty() && loadCache(cacheFileName))
+	{
+		BS_LOG_INFO(IO, "Loaded file system index with %u files from '%s'",
+			getFileCount(), cacheFileName.c_str());
+
+		return;
+	}
+
 	buildFileSystem();
+
+	BS_LOG_INFO(IO, "Scanned %u files in %u directories in '%s'",
+		getFileCount(), mDirectories.size(), mBasePath.c_str());
+
+	if (!cacheFileName.empty())
+	{
+		saveCache(cacheFileName);
+	}
 }
 
 void bsFileSystem::buildFileSystem()
 {
-	boost::filesystem::recursive_directory_iterator itr(mBasePath);
-	boost::filesystem::recursive_directory_iterator end;
+	mFiles.clear();
+	mDirectories.clear();
+	mStringPool.clear();
+
+	//Files directly in the base path, and the base path itself.
+	ScanResult baseResult;
+	baseResult.directories.push_back(ScannedDirectory(mBasePath));
 
-	//Iterate through all sub directories and all files
+	std::vector<boost::filesystem::path> subDirectories;
+
+	boost::filesystem::directory_iterator itr(mBasePath);
+	boost::filesystem::directory_iterator end;
 	for (; itr != end; ++itr)
 	{
 		if (boost::filesystem::is_regular_file(itr->path()))
 		{
-			std::string fileName = itr->path().filename().string();
-			std::string pathName = itr->path().relative_path().string();
+			baseResult.files.push_back(ScannedFile(itr->path()));
+		}
+		else if (boost::filesystem::is_directory(itr->path()))
+		{
+			subDirectories.push_back(itr->path());
+		}
+	}
+
+	//Sorted so that the result (and which duplicate wins) does not depend on scheduling.
+	std::sort(subDirectories.begin(), subDirectories.end());
+
+	std::vector<ScanResult> subResults(subDirectories.size());
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, subDirectories.size(), 1),
+		[&](const tbb::blocked_range<size_t>& range)
+	{
+		for (size_t i = range.begin(); i != range.end(); ++i)
+		{
+			scanDirectory(subDirectories[i], subResults[i]);
+		}
+	});
+
+	//Merge the results in scan order.
+	std::vector<const ScanResult*> results;
+	results.push_back(&baseResult);
+	for (size_t i = 0; i < subResults.size(); ++i)
+	{
+		results.push_back(&subResults[i]);
+	}
+
+	std::vector<std::pair<unsigned long long, const ScannedFile*>> scannedFiles;
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const ScanResult& result = *results[i];
+
+		for (size_t j = 0; j < result.directories.size(); ++j)
+		{
+			DirectoryEntry directory;
+			directory.lastWriteTime = result.directories[j].lastWriteTime;
+			directory.pathOffset = addString(result.directories[j].path);
+			directory.padding = 0;
+			mDirectories.push_back(directory);
+		}
+
+		for (size_t j = 0; j < result.files.size(); ++j)
+		{
+			const ScannedFile& file = result.files[j];
+			scannedFiles.push_back(std::make_pair(bsHash::fnv1a64(file.name.c_str()), &file));
+		}
+	}
 
-			//Check if file already exists in the map, and log a warning message if so.
-			auto findResult = mFilePaths.find(fileName);
-			if (findResult == mFilePaths.end())
+	//Stable sort keeps scan order within equal hashes, so the first found file is kept.
+	std::stable_sort(scannedFiles.begin(), scannedFiles.end(),
+		[](const std::pair<unsigned long long, const ScannedFile*>& a,
+		const std::pair<unsigned long long, const ScannedFile*>& b)
+	{
+		return a.first < b.first;
+	});
+
+	mFiles.reserve(scannedFiles.size());
+	for (size_t i = 0; i < scannedFiles.size(); ++i)
+	{
+		const ScannedFile& file = *scannedFiles[i].second;
+
+		//Check if file already exists in the index, and log a warning message if so.
+		const char* existingPath = nullptr;
+		for (auto itr = mFiles.rbegin(); itr != mFiles.rend()
+			&& itr->nameHash == scannedFiles[i].first; ++itr)
+		{
+			if (file.name == getString(itr->nameOffset))
 			{
-				//Add the file and path to the map.
-				mFilePaths[fileName] = pathName;
+				existingPath = getString(itr->pathOffset);
+				break;
 			}
-			else
+		}
+
+		if (existingPath)
+		{
+			//Duplicate file name name found, which is probably not intended.
+
+			BS_LOG_WARNING(IO, "Duplicate file found, file name: '%s'"
+				" with path '%s'. Will use previously found path '%s' instead",
+				file.name.c_str(), file.path.c_str(), existingPath);
+
+			continue;
+		}
+
+		FileEntry entry;
+		entry.nameHash = scannedFiles[i].first;
+		entry.nameOffset = addString(file.name);
+		entry.pathOffset = addString(file.path);
+		mFiles.push_back(entry);
+	}
+}
+
+bool bsFileSystem::loadCache(const std::string& cacheFileName)
+{
+#pragma warning (disable : 4996)//warning C4996: 'fopen' was declared deprecated
+	FILE* file = fopen(cacheFileName.c_str(), "rb");
+#pragma warning (default : 4996)
+	if (!file)
+	{
+		return false;
+	}
+
+	CacheHeader header;
+	bool success = fread(&header, sizeof(header), 1, file) == 1
+		&& memcmp(header.magic, "bsfc", 4) == 0
+		&& header.version == kCacheVersion
+		&& header.stringPoolSize != 0;
+
+	if (success)
+	{
+		mDirectories.resize(header.directoryCount);
+		mFiles.resize(header.fileCount);
+		mStringPool.resize(header.stringPoolSize);
+
+		success = (mDirectories.empty() || fread(&mDirectories[0],
+			sizeof(DirectoryEntry) * mDirectories.size(), 1, file) == 1)
+			&& (mFiles.empty() || fread(&mFiles[0], sizeof(FileEntry) * mFiles.size(), 1,
+			file) == 1)
+			&& fread(&mStringPool[0], mStringPool.size(), 1, file) == 1;
+	}
+
+	fclose(file);
+
+	//Every string must be inside the pool, and the pool must end with a terminator.
+	success = success && mStringPool.back() == '\0'
+		&& header.basePathOffset < header.stringPoolSize;
+	for (size_t i = 0; success && i < mDirectories.size(); ++i)
+	{
+		success = mDirectories[i].pathOffset < header.stringPoolSize;
+	}
+	for (size_t i = 0; success && i < mFiles.size(); ++i)
+	{
+		success = mFiles[i].nameOffset < header.stringPoolSize
+			&& mFiles[i].pathOffset < header.stringPoolSize;
+	}
+
+	if (!success)
+	{
+		BS_LOG_WARNING(IO, "File system cache '%s' is corrupt or was created"
+			" with an old version, rescanning", cacheFileName.c_str());
+	}
+	else if (mBasePath != getString(header.basePathOffset))
+	{
+		success = false;
+	}
+
+	//Any added, removed or renamed file changes the last write time of its directory.
+	for (size_t i = 0; success && i < mDirectories.size(); ++i)
+	{
+		const char* directory = getString(mDirectories[i].pathOffset);
+
+		if (bsFileUtil::lastWriteTime(directory) != mDirectories[i].lastWriteTime)
+		{
+			BS_LOG_INFO(IO, "File system cache '%s' is out of date, '%s' has"
+				" been modified", cacheFileName.c_str(), directory);
+
+			success = false;
+		}
+	}
+
+	if (!success)
+	{
+		mFiles.clear();
+		mDirectories.clear();
+		mStringPool.clear();
+	}
+
+	return success;
+}
+
+void bsFileSystem::saveCache(const std::string& cacheFileName) const
+{
+	std::vector<char> stringPool(mStringPool);
+	const unsigned int basePathOffset = stringPool.size();
+	stringPool.insert(stringPool.end(), mBasePath.begin(), mBasePath.end());
+	stringPool.push_back('\0');
+
+	CacheHeader header;
+	memcpy(header.magic, "bsfc", 4);
+	header.version = kCacheVersion;
+	header.directoryCount = mDirectories.size();
+	header.fileCount = mFiles.size();
+	header.stringPoolSize = stringPool.size();
+	header.basePathOffset = basePathOffset;
+
+#pragma warning (disable : 4996)//warning C4996: 'fopen' was declared deprecated
+	FILE* file = fopen(cacheFileName.c_str(), "wb");
+#pragma warning (default : 4996)
+	if (!file)
+	{
+		BS_LOG_WARNING(IO, "Failed to open file system cache '%s' for writing",
+			cacheFileName.c_str());
+
+		return;
+	}
+
+	const bool success = fwrite(&header, sizeof(header), 1, file) == 1
+		&& (mDirectories.empty() || fwrite(&mDirectories[0],
+		sizeof(DirectoryEntry) * mDirectories.size(), 1, file) == 1)
+		&& (mFiles.empty() || fwrite(&mFiles[0], sizeof(FileEntry) * mFiles.size(), 1,
+		file) == 1)
+		&& fwrite(&stringPool[0], stringPool.size(), 1, file) == 1;
+
+	fclose(file);
+
+	if (!success)
+	{
+		BS_LOG_WARNING(IO, "Failed to write file system cache '%s'",
+			cacheFileName.c_str());
+
+		remove(cacheFileName.c_str());
+	}
+}
+
+unsigned int bsFileSystem::addString(const std::string& string)
+{
+	const unsigned int offset = mStringPool.size();
+
+	mStringPool.insert(mStringPool.end(), string.begin(), string.end());
+	mStringPool.push_back('\0');
+
+	return offset;
+}
+
+const char* bsFileSystem::findPath(const char* fileName) const
+{
+	const unsigned long long nameHash = bsHash::fnv1a64(fileName);
+
+	auto itr = std::lower_bound(mFiles.begin(), mFiles.end(), nameHash,
+		[](const FileEntry& entry, unsigned long long hash)
+	{
+		return entry.nameHash < hash;
+	});
+
+	//Several names may share a hash, compare the names to find the right one.
+	for (; itr != mFiles.end() && itr->nameHash == nameHash; ++itr)
+	{
+		if (strcmp(getString(itr->nameOffset), fileName) == 0)
+		{
+			return getString(itr->pathOffset);
+		}
+	}
+
+	return nullptr;
+}
+
+bool bsFileSystem::insertFile(const std::string& name, const std::string& path)
+{
+	const unsigned long long nameHash = bsHash::fnv1a64(name.c_str());
+
+	auto itr = std::lower_bound(mFiles.begin(), mFiles.end(), nameHash,
+		[](const FileEntry& entry, unsigned long long hash)
+	{
+		return entry.nameHash < hash;
+	});
+
+	for (auto sameHash = itr; sameHash != mFiles.end() && sameHash->nameHash == nameHash;
+		++sameHash)
+	{
+		if (name == getString(sameHash->nameOffset))
+		{
+			if (path != getString(sameHash->pathOffset))
 			{
-				//Duplicate file name name found, which is probably not intended.
-				
-				bsLog::logf(bsLog::SEV_WARNING, "Duplicate file found, file name: '%s'"
+				BS_LOG_WARNING(IO, "Duplicate file found, file name: '%s'"
 					" with path '%s'. Will use previously found path '%s' instead",
-					fileName.c_str(), pathName.c_str(), findResult->second.c_str());
+					name.c_str(), path.c_str(), getString(sameHash->pathOffset));
 			}
+
+			return false;
+		}
+	}
+
+	FileEntry entry;
+	entry.nameHash = nameHash;
+	entry.nameOffset = addString(name);
+	entry.pathOffset = addString(path);
+	mFiles.insert(itr, entry);
+
+	return true;
+}
+
+void bsFileSystem::addFile(const std::string& path)
+{
+	if (boost::filesystem::is_directory(path))
+	{
+		ScanResult result;
+		scanDirectory(path, result);
+
+		for (size_t i = 0; i < result.files.size(); ++i)
+		{
+			addFile(result.files[i].path);
+		}
+
+		return;
+	}
+
+	const ScannedFile file(path);
+	if (insertFile(file.name, file.path))
+	{
+		notifyListeners(file.name.c_str(), file.path.c_str(), FILE_ADDED);
+	}
+}
+
+void bsFileSystem::removeFile(const std::string& path)
+{
+	const ScannedFile file(path);
+
+	//Strings in the pool are not reclaimed until the next rescan.
+	const std::string directoryPrefix(file.path + '\\');
+	std::vector<FileEntry> removedFiles;
+
+	mFiles.erase(std::remove_if(mFiles.begin(), mFiles.end(),
+		[&](const FileEntry& entry) -> bool
+	{
+		const char* entryPath = getString(entry.pathOffset);
+
+		//Either the file itself, or a file in a removed directory.
+		const bool removeThis = file.path == entryPath
+			|| strncmp(entryPath, directoryPrefix.c_str(), directoryPrefix.length()) == 0;
+		if (removeThis)
+		{
+			removedFiles.push_back(entry);
 		}
+
+		return removeThis;
+	}), mFiles.end());
+
+	for (size_t i = 0; i < removedFiles.size(); ++i)
+	{
+		notifyListeners(getString(removedFiles[i].nameOffset),
+			getString(removedFiles[i].pathOffset), FILE_REMOVED);
+	}
+}
+
+void bsFileSystem::fileModified(const std::string& path)
+{
+	const ScannedFile file(path);
+
+	//Only notify for files which are in the index, ignoring duplicates.
+	const char* indexedPath = findPath(file.name.c_str());
+	if (indexedPath && file.path == indexedPath)
+	{
+		notifyListeners(file.name.c_str(), indexedPath, FILE_MODIFIED);
+	}
+}
+
+void bsFileSystem::rescan()
+{
+	buildFileSystem();
+
+	BS_LOG_INFO(IO, "Rescanned %u files in %u directories in '%s'",
+		getFileCount(), mDirectories.size(), mBasePath.c_str());
+}
+
+unsigned int bsFileSystem::addChangeListener(const ChangeListener& listener)
+{
+	BS_ASSERT2(listener, "Invalid change listener");
+
+	mChangeListeners.push_back(std::make_pair(++mNextChangeListenerId, listener));
+
+	return mNextChangeListenerId;
+}
+
+void bsFileSystem::removeChangeListener(unsigned int listenerId)
+{
+	for (auto itr = mChangeListeners.begin(), end = mChangeListeners.end(); itr != end; ++itr)
+	{
+		if (itr->first == listenerId)
+		{
+			mChangeListeners.erase(itr);
+
+			return;
+		}
+	}
+
+	BS_ASSERT2(false, "Tried to remove a change listener which was not registered");
+}
+
+void bsFileSystem::notifyListeners(const char* fileName, const char* path,
+	ChangeType changeType) const
+{
+	for (size_t i = 0; i < mChangeListeners.size(); ++i)
+	{
+		mChangeListeners[i].second(fileName, path, changeType);
 	}
 }
 
 std::string bsFileSystem::getPathFromFilename(const std::string& fileName) const
 {
-	auto findResult = mFilePaths.find(fileName);
+	const char* path = findPath(fileName.c_str());
+	if (path)
+	{
+		return path;
+	}
+
+	//Packed files are loaded by name.
+	const bsPackFile* packFile;
+	const bsPackFileEntry* entry;
+	if (findPackedFile(fileName.c_str(), packFile, entry))
+	{
+		return fileName;
+	}
+
+	return "";
+}
+
+bool bsFileSystem::mountPackFile(const std::string& packFilePath)
+{
+	std::shared_ptr<bsPackFile> packFile(new bsPackFile(packFilePath));
+	if (!packFile->isOpen())
+	{
+		BS_LOG_ERROR(IO, "Failed to mount pack file '%s'",
+			packFilePath.c_str());
+
+		return false;
+	}
+
+	mPackFiles.push_back(packFile);
+
+	return true;
+}
+
+bool bsFileSystem::findPackedFile(const char* fileName, const bsPackFile*& packFileOut,
+	const bsPackFileEntry*& entryOut) const
+{
+	//Search most recently mounted first, so that patch packs override base packs.
+	for (auto itr = mPackFiles.rbegin(), end = mPackFiles.rend(); itr != end; ++itr)
+	{
+		const bsPackFileEntry* entry = (*itr)->findEntry(fileName);
+		if (entry)
+		{
+			packFileOut = itr->get();
+			entryOut = entry;
+
+			return true;
+		}
+	}
 
-	//Return empty string if not found, else the actual path
-	return findResult == mFilePaths.end() ? "" : findResult->second;
+	return false;
 }
@@ -1,42 +1,183 @@
 #pragma once
 
 
-#include <unordered_map>
 #include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+
+class bsPackFile;
+struct bsPackFileEntry;
 
 /*	Contains a map of files, using the filename as the key and the full/relative path
 	as the value.
 	This makes it possible to refer to something like "assets\images\forest\tree.jpg" as
 	just "tree.jpg" and the file system will be able to convert the filename to the
 	full/relative path.
+
+	Pack files can be mounted to make the files they contain available through the file
+	system. Files in mounted packs take priority over loose files with the same name.
+
+	The index can be updated incrementally with addFile/removeFile (see
+	bsFileSystemWatcher), which also notifies any registered change listeners.
 */
 class bsFileSystem
 {
 public:
+	enum ChangeType
+	{
+		FILE_ADDED,
+		FILE_REMOVED,
+		FILE_MODIFIED,
+	};
+
+	/*	Called when a file has been added, removed or modified. The first parameter is the
+		file name, the second the path of the file.
+	*/
+	typedef std::function<void(const char*, const char*, ChangeType)> ChangeListener;
+
 	/*	The base path is the root of the scanned directories.
 		All subfolders of the base path will be scanned, and every contained file will
 		be mapped.
+
+		If a cache file name is given, the index is loaded from that file if none of the
+		scanned directories have been modified since it was written, skipping the scan.
+		Otherwise the directories are scanned and the cache file is (re)written.
 	*/
-	bsFileSystem(const std::string& basePath);
+	bsFileSystem(const std::string& basePath, const std::string& cacheFileName = "");
 
 
 	/*	Returns the full path of the file.
+		If the file only exists in a mounted pack file, the file name itself is returned,
+		which bsFileIoManager will resolve to the packed file.
 		If the file does not exist, an empty string is returned.
 	*/
 	std::string getPathFromFilename(const std::string& fileName) const;
 
+	/*	Returns the full path of a loose file, or null if no such file has been found.
+		Does not search mounted pack files.
+		The returned string is valid until the file system is modified.
+	*/
+	const char* findPath(const char* fileName) const;
+
+	/*	Mounts a pack file, making the files it contains loadable through bsFileIoManager.
+		Packs mounted later override files with the same name in packs mounted earlier,
+		making it possible to mount patch packs on top of a base pack.
+		Returns false if the pack could not be opened.
+
+		This is not thread safe, mount all packs before issuing load requests.
+	*/
+	bool mountPackFile(const std::string& packFilePath);
+
+	/*	Finds a file in the mounted pack files, searching the most recently mounted pack
+		first.
+		Returns false if no mounted pack contains a file with the given name.
+	*/
+	bool findPackedFile(const char* fileName, const bsPackFile*& packFileOut,
+		const bsPackFileEntry*& entryOut) const;
+
 	inline const std::string& getBasePath() const
 	{
 		return mBasePath;
 	}
 
+	//Returns the number of loose files in the index.
+	inline unsigned int getFileCount() const
+	{
+		return mFiles.size();
+	}
+
+	/*	Adds a file to the index, or all the files in it if the path is a directory.
+		The path must be relative to the working directory, in the same form as the paths
+		returned by getPathFromFilename.
+		Change listeners are notified of every file added.
+	*/
+	void addFile(const std::string& path);
+
+	/*	Removes a file from the index, or all the files in it if the path is a directory.
+		Change listeners are notified of every file removed.
+	*/
+	void removeFile(const std::string& path);
+
+	/*	Notifies change listeners that a file in the index has been modified.
+	*/
+	void fileModified(const std::string& path);
+
+	/*	Discards the index and scans the base path again. Change listeners are not
+		notified.
+	*/
+	void rescan();
+
+	/*	Registers a function to be called whenever a file is added, removed or modified.
+		Returns an ID which can be used to remove the listener.
+	*/
+	unsigned int addChangeListener(const ChangeListener& listener);
+
+	void removeChangeListener(unsigned int listenerId);
+
 private:
+	//A loose file. Strings are offsets into mStringPool.
+	struct FileEntry
+	{
+		unsigned long long	nameHash;
+		unsigned int		nameOffset;
+		unsigned int		pathOffset;
+	};
+
+	/*	A scanned directory and its last write time when it was scanned. Used to validate
+		the cache, since a directory's last write time changes whenever files are added to,
+		removed from or renamed in it.
+	*/
+	struct DirectoryEntry
+	{
+		unsigned long long	lastWriteTime;
+		unsigned int		pathOffset;
+		//Always 0, so that no uninitialized tail padding is written to the cache.
+		unsigned int		padding;
+	};
+
 	/*	Builds the file system by scanning the base path and all the folders it contains
 		and maps file names to file paths.
+		The sub directories of the base path are scanned in parallel.
 	*/
 	void buildFileSystem();
 
+	/*	Loads the index from the cache file.
+		Returns false if the cache does not exist, is corrupt or is out of date.
+	*/
+	bool loadCache(const std::string& cacheFileName);
+
+	void saveCache(const std::string& cacheFileName) const;
+
+	//Appends a null terminated string to the string pool and returns its offset.
+	unsigned int addString(const std::string& string);
+
+	inline const char* getString(unsigned int offset) const
+	{
+		return &mStringPool[offset];
+	}
+
+	//Inserts a single file into the index, keeping it sorted. Returns false if a file with
+	//the same name already exists.
+	bool insertFile(const std::string& name, const std::string& path);
+
+	void notifyListeners(const char* fileName, const char* path, ChangeType changeType) const;
+
 
 	std::string	mBasePath;
-	std::unordered_map<std::string, std::string>	mFilePaths;
+
+	//Sorted by name hash.
+	std::vector<FileEntry>		mFiles;
+	std::vector<DirectoryEntry>	mDirectories;
+	std::vector<char>			mStringPool;
+
+	//In mount order.
+	std::vector<std::shared_ptr<bsPackFile>>	mPackFiles;
+
+	std::vector<std::pair<unsigned int, ChangeListener>>	mChangeListeners;
+	unsigned int	mNextChangeListenerId;
+
+	//Non-copyable.
+	bsFileSystem(const bsFileSystem&);
+	bsFileSystem& operator=(const bsFileSystem&);
 };
@@ -0,0 +1,199 @@
+#include "StdAfx.h"
+
+#include "bsFileSystemWatcher.h"
+
+#include <boost/filesystem.hpp>
+
+#include "bsFileSystem.h"
+#include "bsWindowsUtils.h"
+#include "bsLog.h"
+#include "bsAssert.h"
+
+
+namespace
+{
+//Size of the buffer change notifications are written to, in DWORDs.
+const size_t kBufferSize = 16 * 1024;
+
+const DWORD kNotifyFilter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME
+	| FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE;
+
+//Converts a path relative to the base path to the form used in the file system's index.
+std::string toIndexPath(const std::string& basePath, const wchar_t* relativePath,
+	unsigned int relativePathLength)
+{
+	std::string narrowPath;
+
+	const int narrowLength = WideCharToMultiByte(CP_ACP, 0, relativePath,
+		relativePathLength, nullptr, 0, nullptr, nullptr);
+	if (narrowLength > 0)
+	{
+		narrowPath.resize(narrowLength);
+		WideCharToMultiByte(CP_ACP, 0, relativePath, relativePathLength, &narrowPath[0],
+			narrowLength, nullptr, nullptr);
+	}
+
+	return (boost::filesystem::path(basePath) / narrowPath).relative_path().string();
+}
+}
+
+
+bsFileSystemWatcher::bsFileSystemWatcher(bsFileSystem& fileSystem)
+	: mFileSystem(fileSystem)
+	, mDirectoryHandle(nullptr)
+	, mBuffer(kBufferSize)
+{
+	memset(&mOverlapped, 0, sizeof(mOverlapped));
+
+	mDirectoryHandle = CreateFileA(mFileSystem.getBasePath().c_str(), FILE_LIST_DIRECTORY,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+		FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+	if (mDirectoryHandle == INVALID_HANDLE_VALUE)
+	{
+		BS_LOG_ERROR(IO, "Failed to open '%s' for watching. Error message: %s",
+			mFileSystem.getBasePath().c_str(),
+			bsWindowsUtils::winApiErrorCodeToString(GetLastError()).c_str());
+
+		mDirectoryHandle = nullptr;
+
+		return;
+	}
+
+	mOverlapped.hEvent = CreateEvent(nullptr, true, false, nullptr);
+
+	if (beginRead())
+	{
+		BS_LOG_INFO(IO, "Watching '%s' for changes",
+			mFileSystem.getBasePath().c_str());
+	}
+}
+
+bsFileSystemWatcher::~bsFileSystemWatcher()
+{
+	stop();
+
+	if (mOverlapped.hEvent)
+	{
+		CloseHandle(mOverlapped.hEvent);
+	}
+}
+
+bool bsFileSystemWatcher::beginRead()
+{
+	const BOOL success = ReadDirectoryChangesW(mDirectoryHandle, &mBuffer[0],
+		mBuffer.size() * sizeof(DWORD), true, kNotifyFilter, nullptr, &mOverlapped, nullptr);
+	if (success == 0)
+	{
+		BS_LOG_ERROR(IO, "Failed to watch '%s' for changes. Error message: %s",
+			mFileSystem.getBasePath().c_str(),
+			bsWindowsUtils::winApiErrorCodeToString(GetLastError()).c_str());
+
+		stop();
+
+		return false;
+	}
+
+	return true;
+}
+
+void bsFileSystemWatcher::stop()
+{
+	if (mDirectoryHandle)
+	{
+		//Wait for the cancellation to complete, the OS may still be writing to the buffer.
+		DWORD bytesTransferred;
+		if (CancelIo(mDirectoryHandle) != 0)
+		{
+			GetOverlappedResult(mDirectoryHandle, &mOverlapped, &bytesTransferred, true);
+		}
+
+		CloseHandle(mDirectoryHandle);
+		mDirectoryHandle = nullptr;
+	}
+}
+
+void bsFileSystemWatcher::update()
+{
+	if (!isWatching())
+	{
+		return;
+	}
+
+	DWORD bytesTransferred = 0;
+	if (GetOverlappedResult(mDirectoryHandle, &mOverlapped, &bytesTransferred, false) == 0)
+	{
+		const DWORD error = GetLastError();
+		if (error != ERROR_IO_INCOMPLETE)
+		{
+			BS_LOG_ERROR(IO, "Watching '%s' for changes failed. Error message:"
+				" %s", mFileSystem.getBasePath().c_str(),
+				bsWindowsUtils::winApiErrorCodeToString(error).c_str());
+
+			stop();
+		}
+
+		//No changes yet.
+		return;
+	}
+
+	if (bytesTransferred == 0)
+	{
+		//Too many changes happened at once to fit in the buffer, rebuild the whole index.
+		BS_LOG_WARNING(IO, "Too many changes in '%s' to apply incrementally,"
+			" rescanning", mFileSystem.getBasePath().c_str());
+
+		mFileSystem.rescan();
+	}
+	else
+	{
+		processChanges(bytesTransferred);
+	}
+
+	beginRead();
+}
+
+void bsFileSystemWatcher::processChanges(unsigned long bufferSize)
+{
+	const char* buffer = reinterpret_cast<const char*>(&mBuffer[0]);
+	const std::string& basePath = mFileSystem.getBasePath();
+
+	//Saving a file usually results in several modifications in a row, only notify once.
+	std::string previousModifiedPath;
+
+	unsigned long offset = 0;
+	while (offset < bufferSize)
+	{
+		const FILE_NOTIFY_INFORMATION& notification =
+			*reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(buffer + offset);
+
+		const std::string path(toIndexPath(basePath, notification.FileName,
+			notification.FileNameLength / sizeof(wchar_t)));
+
+		switch (notification.Action)
+		{
+		case FILE_ACTION_ADDED:
+		case FILE_ACTION_RENAMED_NEW_NAME:
+			mFileSystem.addFile(path);
+			break;
+
+		case FILE_ACTION_REMOVED:
+		case FILE_ACTION_RENAMED_OLD_NAME:
+			mFileSystem.removeFile(path);
+			break;
+
+		case FILE_ACTION_MODIFIED:
+			if (path != previousModifiedPath)
+			{
+				mFileSystem.fileModified(path);
+				previousModifiedPath = path;
+			}
+			break;
+		}
+
+		if (notification.NextEntryOffset == 0)
+		{
+			break;
+		}
+		offset += notification.NextEntryOffset;
+	}
+}
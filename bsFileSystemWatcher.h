@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <Windows.h>
+
+class bsFileSystem;
+
+
+/*	Watches a file system's base path for changes and applies them to the file system's
+	index incrementally, making it possible to add, remove and modify assets without
+	restarting.
+
+	Changes are collected in the background by the OS, but are only applied when update is
+	called, so change listeners registered with the file system are called from the thread
+	calling update.
+*/
+class bsFileSystemWatcher
+{
+public:
+	bsFileSystemWatcher(bsFileSystem& fileSystem);
+
+	~bsFileSystemWatcher();
+
+	/*	Applies any changes which have happened since the previous update to the file
+		system. Does not block.
+	*/
+	void update();
+
+	//Returns false if watching failed to start or has stopped because of an error.
+	inline bool isWatching() const
+	{
+		return mDirectoryHandle != nullptr;
+	}
+
+private:
+	//Starts reading the next batch of changes.
+	bool beginRead();
+
+	void processChanges(unsigned long bufferSize);
+
+	void stop();
+
+
+	//Non-copyable.
+	bsFileSystemWatcher(const bsFileSystemWatcher&);
+	bsFileSystemWatcher& operator=(const bsFileSystemWatcher&);
+
+
+	bsFileSystem&	mFileSystem;
+
+	HANDLE			mDirectoryHandle;
+	OVERLAPPED		mOverlapped;
+
+	//Change notifications are written here by the OS. Must be DWORD aligned.
+	std::vector<DWORD>	mBuffer;
+};
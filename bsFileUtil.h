@@ -42,4 +42,21 @@ namespace bsFileUtil
 
 		return filetimeToTime_t(fileAttributes.ftLastWriteTime);
 	}
+
+	/*	Returns the last write time of a file or directory in 100-nanosecond intervals,
+		or 0 if it could not be read. Has higher resolution than lastModifiedTime.
+	*/
+	inline unsigned long long lastWriteTime(const char* fileName)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA fileAttributes;
+		if (GetFileAttributesEx(fileName, GetFileExInfoStandard, &fileAttributes) == 0)
+		{
+			return 0;
+		}
+
+		ULARGE_INTEGER ull;
+		ull.LowPart = fileAttributes.ftLastWriteTime.dwLowDateTime;
+		ull.HighPart = fileAttributes.ftLastWriteTime.dwHighDateTime;
+		return ull.QuadPart;
+	}
 }
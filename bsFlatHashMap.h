@@ -0,0 +1,691 @@
+#pragma once
+
+#include <emmintrin.h>//SSE2
+#include <intrin.h>//_BitScanForward
+#include <string.h>
+
+#include <functional>
+#include <new>
+#include <utility>
+
+#include "bsAssert.h"
+#include "bsMemoryTracker.h"
+
+
+/*	Default hash function for bsFlatHashMap.
+	Integers and pointers are used as they are, since the map mixes every hash before
+	using it. Other types use std::hash.
+*/
+template <typename T>
+struct bsFlatHash
+{
+	inline size_t operator()(const T& value) const
+	{
+		return std::hash<T>()(value);
+	}
+};
+
+template <typename T>
+struct bsFlatHash<T*>
+{
+	inline size_t operator()(const T* value) const
+	{
+		return reinterpret_cast<size_t>(value);
+	}
+};
+
+template <>
+struct bsFlatHash<unsigned int>
+{
+	inline size_t operator()(unsigned int value) const
+	{
+		return value;
+	}
+};
+
+template <>
+struct bsFlatHash<unsigned long long>
+{
+	inline size_t operator()(unsigned long long value) const
+	{
+		return static_cast<size_t>(value ^ (value >> 32));
+	}
+};
+
+
+/*	Default key comparison for bsFlatHashMap.
+	Templated on both arguments, allowing lookups with any type that can be compared with
+	the key type without converting it to the key type first.
+*/
+struct bsFlatEqual
+{
+	template <typename A, typename B>
+	inline bool operator()(const A& a, const B& b) const
+	{
+		return a == b;
+	}
+};
+
+
+/*	Open addressing hash map with the same interface as the commonly used parts of
+	std::unordered_map.
+
+	All entries are stored in a single array, together with one control byte per entry.
+	The control byte is either empty, deleted, or 7 bits of the entry's hash. Lookups load
+	16 control bytes at a time and compare them all against the hash with SSE2, so only
+	entries whose hash bits match are compared with the key. This makes lookups and
+	insertions touch very little memory compared to a node based map, and inserting does
+	not allocate unless the map has to grow.
+
+	find, count and erase accept any type which the hasher and the key comparison accept,
+	for example a bsStringView when the key is a std::string, without creating a key.
+
+	Unlike std::unordered_map, inserting or erasing invalidates all iterators and pointers
+	to entries. The key of an entry must not be modified through an iterator.
+*/
+template <typename Key, typename Value, typename Hasher = bsFlatHash<Key>,
+	typename KeyEqual = bsFlatEqual>
+class bsFlatHashMap
+{
+public:
+	typedef Key						key_type;
+	typedef Value					mapped_type;
+	typedef std::pair<Key, Value>	value_type;
+	typedef size_t					size_type;
+
+
+	//Iterator over full entries, T is either value_type or const value_type.
+	template <typename T>
+	class IteratorBase
+	{
+	public:
+		IteratorBase()
+			: mControl(nullptr)
+			, mControlEnd(nullptr)
+			, mSlot(nullptr)
+		{}
+
+		IteratorBase(const signed char* control, const signed char* controlEnd, T* slot)
+			: mControl(control)
+			, mControlEnd(controlEnd)
+			, mSlot(slot)
+		{
+			skipNonFull();
+		}
+
+		//Allows conversion from iterator to const_iterator.
+		template <typename U>
+		IteratorBase(const IteratorBase<U>& other)
+			: mControl(other.mControl)
+			, mControlEnd(other.mControlEnd)
+			, mSlot(other.mSlot)
+		{}
+
+		inline T& operator*() const
+		{
+			return *mSlot;
+		}
+
+		inline T* operator->() const
+		{
+			return mSlot;
+		}
+
+		inline IteratorBase& operator++()
+		{
+			++mControl;
+			++mSlot;
+			skipNonFull();
+
+			return *this;
+		}
+
+		inline IteratorBase operator++(int)
+		{
+			IteratorBase previous(*this);
+			++*this;
+
+			return previous;
+		}
+
+		inline bool operator==(const IteratorBase& other) const
+		{
+			return mControl == other.mControl;
+		}
+
+		inline bool operator!=(const IteratorBase& other) const
+		{
+			return mControl != other.mControl;
+		}
+
+	private:
+		template <typename U>
+		friend class IteratorBase;
+
+		friend class bsFlatHashMap;
+
+		inline void skipNonFull()
+		{
+			while (mControl != mControlEnd && *mControl < 0)
+			{
+				++mControl;
+				++mSlot;
+			}
+		}
+
+
+		const signed char*	mControl;
+		const signed char*	mControlEnd;
+		T*					mSlot;
+	};
+
+	typedef IteratorBase<value_type>		iterator;
+	typedef IteratorBase<const value_type>	const_iterator;
+
+
+	bsFlatHashMap()
+		: mControl(nullptr)
+		, mSlots(nullptr)
+		, mCapacity(0)
+		, mSize(0)
+		, mGrowthLeft(0)
+	{}
+
+	bsFlatHashMap(const bsFlatHashMap& other)
+		: mControl(nullptr)
+		, mSlots(nullptr)
+		, mCapacity(0)
+		, mSize(0)
+		, mGrowthLeft(0)
+		, mHasher(other.mHasher)
+		, mKeyEqual(other.mKeyEqual)
+	{
+		copyFrom(other);
+	}
+
+	bsFlatHashMap(bsFlatHashMap&& other)
+		: mControl(other.mControl)
+		, mSlots(other.mSlots)
+		, mCapacity(other.mCapacity)
+		, mSize(other.mSize)
+		, mGrowthLeft(other.mGrowthLeft)
+		, mHasher(other.mHasher)
+		, mKeyEqual(other.mKeyEqual)
+	{
+		other.mControl = nullptr;
+		other.mSlots = nullptr;
+		other.mCapacity = other.mSize = other.mGrowthLeft = 0;
+	}
+
+	~bsFlatHashMap()
+	{
+		destroyAndFree();
+	}
+
+	bsFlatHashMap& operator=(const bsFlatHashMap& other)
+	{
+		if (this != &other)
+		{
+			destroyAndFree();
+			mHasher = other.mHasher;
+			mKeyEqual = other.mKeyEqual;
+			copyFrom(other);
+		}
+
+		return *this;
+	}
+
+	bsFlatHashMap& operator=(bsFlatHashMap&& other)
+	{
+		if (this != &other)
+		{
+			destroyAndFree();
+
+			mControl = other.mControl;
+			mSlots = other.mSlots;
+			mCapacity = other.mCapacity;
+			mSize = other.mSize;
+			mGrowthLeft = other.mGrowthLeft;
+			mHasher = other.mHasher;
+			mKeyEqual = other.mKeyEqual;
+
+			other.mControl = nullptr;
+			other.mSlots = nullptr;
+			other.mCapacity = other.mSize = other.mGrowthLeft = 0;
+		}
+
+		return *this;
+	}
+
+
+	inline iterator begin()
+	{
+		return iterator(mControl, mControl + mCapacity, mSlots);
+	}
+
+	inline const_iterator begin() const
+	{
+		return const_iterator(mControl, mControl + mCapacity, mSlots);
+	}
+
+	inline iterator end()
+	{
+		return iterator(mControl + mCapacity, mControl + mCapacity, mSlots + mCapacity);
+	}
+
+	inline const_iterator end() const
+	{
+		return const_iterator(mControl + mCapacity, mControl + mCapacity,
+			mSlots + mCapacity);
+	}
+
+	inline size_t size() const
+	{
+		return mSize;
+	}
+
+	inline bool empty() const
+	{
+		return mSize == 0;
+	}
+
+	//Number of entries the map has room for, including the ones it must leave empty.
+	inline size_t capacity() const
+	{
+		return mCapacity;
+	}
+
+
+	template <typename LookupKey>
+	inline iterator find(const LookupKey& key)
+	{
+		const size_t index = findIndex(key, hashOf(key));
+		return index == mCapacity ? end() : iteratorAt(index);
+	}
+
+	template <typename LookupKey>
+	inline const_iterator find(const LookupKey& key) const
+	{
+		const size_t index = findIndex(key, hashOf(key));
+		return index == mCapacity ? end()
+			: const_iterator(mControl + index, mControl + mCapacity, mSlots + index);
+	}
+
+	template <typename LookupKey>
+	inline size_t count(const LookupKey& key) const
+	{
+		return findIndex(key, hashOf(key)) != mCapacity ? 1 : 0;
+	}
+
+	/*	Inserts the entry if no entry with the same key exists.
+		Returns an iterator to the entry with the key, and whether it was inserted.
+	*/
+	std::pair<iterator, bool> insert(const value_type& entry)
+	{
+		bool inserted;
+		const size_t index = findOrPrepareInsert(entry.first, inserted);
+		if (inserted)
+		{
+			new (mSlots + index) value_type(entry);
+		}
+
+		return std::make_pair(iteratorAt(index), inserted);
+	}
+
+	std::pair<iterator, bool> insert(value_type&& entry)
+	{
+		bool inserted;
+		const size_t index = findOrPrepareInsert(entry.first, inserted);
+		if (inserted)
+		{
+			new (mSlots + index) value_type(std::move(entry));
+		}
+
+		return std::make_pair(iteratorAt(index), inserted);
+	}
+
+	//Returns the value for the key, inserting a default constructed one if it's missing.
+	Value& operator[](const Key& key)
+	{
+		bool inserted;
+		const size_t index = findOrPrepareInsert(key, inserted);
+		if (inserted)
+		{
+			new (mSlots + index) value_type(key, Value());
+		}
+
+		return mSlots[index].second;
+	}
+
+	//Erases the entry, returning an iterator to the next entry.
+	iterator erase(iterator position)
+	{
+		return erase(const_iterator(position));
+	}
+
+	iterator erase(const_iterator position)
+	{
+		const size_t index = position.mControl - mControl;
+		eraseAt(index);
+
+		return iterator(mControl + index + 1, mControl + mCapacity, mSlots + index + 1);
+	}
+
+	//Returns the number of erased entries, 0 or 1.
+	template <typename LookupKey>
+	size_t erase(const LookupKey& key)
+	{
+		const size_t index = findIndex(key, hashOf(key));
+		if (index == mCapacity)
+		{
+			return 0;
+		}
+
+		eraseAt(index);
+
+		return 1;
+	}
+
+	//Destroys all entries, but keeps the allocated memory for reuse.
+	void clear()
+	{
+		if (mSize != 0)
+		{
+			destroyEntries();
+		}
+
+		if (mCapacity != 0)
+		{
+			memset(mControl, kEmpty, mCapacity);
+		}
+		mSize = 0;
+		mGrowthLeft = maxLoad(mCapacity);
+	}
+
+	/*	Makes room for at least entryCount entries, so that inserting up to that many will
+		not allocate.
+	*/
+	void reserve(size_t entryCount)
+	{
+		size_t newCapacity = kGroupSize;
+		while (maxLoad(newCapacity) < entryCount)
+		{
+			newCapacity *= 2;
+		}
+
+		if (newCapacity > mCapacity)
+		{
+			rehash(newCapacity);
+		}
+	}
+
+private:
+	//The number of control bytes compared at once.
+	static const size_t kGroupSize = 16;
+
+	/*	Control byte values. Full entries store 7 bits of their hash, making the sign bit
+		set only for empty and deleted entries.
+	*/
+	static const signed char kEmpty = -128;
+	static const signed char kDeleted = -2;
+
+
+	//At most 7/8 of the entries can be used, guaranteeing that every probe terminates.
+	static inline size_t maxLoad(size_t capacity)
+	{
+		return capacity - capacity / 8;
+	}
+
+	/*	Mixes the hasher's result, since both the lowest and highest bits of the hash are
+		used and many hash functions (like the ones for integers and pointers) leave some
+		of those unchanged.
+	*/
+	template <typename LookupKey>
+	inline size_t hashOf(const LookupKey& key) const
+	{
+		const unsigned long long mixed = mHasher(key) * 0x9E3779B97F4A7C15ULL;
+		return static_cast<size_t>(mixed ^ (mixed >> 32));
+	}
+
+	inline iterator iteratorAt(size_t index)
+	{
+		return iterator(mControl + index, mControl + mCapacity, mSlots + index);
+	}
+
+	//Returns the index of the entry with the key, or mCapacity if it does not exist.
+	template <typename LookupKey>
+	size_t findIndex(const LookupKey& key, size_t hash) const
+	{
+		if (mCapacity == 0)
+		{
+			return 0;
+		}
+
+		const __m128i hashBits = _mm_set1_epi8(static_cast<char>(hash & 0x7F));
+		const __m128i empty = _mm_set1_epi8(kEmpty);
+		const size_t groupMask = mCapacity / kGroupSize - 1;
+
+		//Triangular probing, which visits every group when the group count is a power of 2.
+		size_t group = (hash >> 7) & groupMask;
+		for (size_t probe = 1; ; ++probe)
+		{
+			const __m128i control = _mm_load_si128(
+				reinterpret_cast<const __m128i*>(mControl + group * kGroupSize));
+
+			unsigned int matches = _mm_movemask_epi8(_mm_cmpeq_epi8(control, hashBits));
+			while (matches != 0)
+			{
+				unsigned long bit;
+				_BitScanForward(&bit, matches);
+
+				const size_t index = group * kGroupSize + bit;
+				if (mKeyEqual(mSlots[index].first, key))
+				{
+					return index;
+				}
+
+				//Clear the lowest set bit.
+				matches &= matches - 1;
+			}
+
+			//An empty entry means that the key would have been inserted here if it existed.
+			if (_mm_movemask_epi8(_mm_cmpeq_epi8(control, empty)) != 0)
+			{
+				return mCapacity;
+			}
+
+			group = (group + probe) & groupMask;
+		}
+	}
+
+	//Returns the index of the first empty or deleted entry in the key's probe sequence.
+	size_t findFirstNonFull(size_t hash) const
+	{
+		const size_t groupMask = mCapacity / kGroupSize - 1;
+
+		size_t group = (hash >> 7) & groupMask;
+		for (size_t probe = 1; ; ++probe)
+		{
+			const __m128i control = _mm_load_si128(
+				reinterpret_cast<const __m128i*>(mControl + group * kGroupSize));
+
+			//The sign bit is only set for empty and deleted entries.
+			const unsigned int nonFull = _mm_movemask_epi8(control);
+			if (nonFull != 0)
+			{
+				unsigned long bit;
+				_BitScanForward(&bit, nonFull);
+
+				return group * kGroupSize + bit;
+			}
+
+			group = (group + probe) & groupMask;
+		}
+	}
+
+	/*	Returns the index of the entry with the key. If it doesn't exist, space is made for
+		it and the index it must be constructed at is returned.
+	*/
+	size_t findOrPrepareInsert(const Key& key, bool& inserted)
+	{
+		const size_t hash = hashOf(key);
+
+		const size_t existingIndex = findIndex(key, hash);
+		if (existingIndex != mCapacity)
+		{
+			inserted = false;
+			return existingIndex;
+		}
+
+		if (mGrowthLeft == 0)
+		{
+			//If deleted entries take up most of the room, reclaim them instead of growing.
+			rehash(mCapacity != 0 && mSize < maxLoad(mCapacity) / 2
+				? mCapacity : (mCapacity != 0 ? mCapacity * 2 : kGroupSize));
+		}
+
+		const size_t index = findFirstNonFull(hash);
+		if (mControl[index] == kEmpty)
+		{
+			//Reusing a deleted entry does not reduce the number of empty entries.
+			--mGrowthLeft;
+		}
+		mControl[index] = static_cast<signed char>(hash & 0x7F);
+		++mSize;
+
+		inserted = true;
+		return index;
+	}
+
+	void eraseAt(size_t index)
+	{
+		BS_ASSERT(mControl[index] >= 0);
+
+		mSlots[index].~value_type();
+		--mSize;
+
+		/*	If the group has an empty entry, lookups passing through it stop here anyway, so
+			the entry can be marked as empty. Otherwise it must be marked as deleted to keep
+			lookups for keys stored further along the probe sequence going.
+		*/
+		const size_t groupStart = index & ~(kGroupSize - 1);
+		const __m128i control = _mm_load_si128(
+			reinterpret_cast<const __m128i*>(mControl + groupStart));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(kEmpty))) != 0)
+		{
+			mControl[index] = kEmpty;
+			++mGrowthLeft;
+		}
+		else
+		{
+			mControl[index] = kDeleted;
+		}
+	}
+
+	//Moves every entry into newly allocated storage with the given capacity.
+	void rehash(size_t newCapacity)
+	{
+		BS_ASSERT((newCapacity & (newCapacity - 1)) == 0 && newCapacity >= kGroupSize);
+		BS_ASSERT(maxLoad(newCapacity) >= mSize);
+
+		signed char* oldControl = mControl;
+		value_type* oldSlots = mSlots;
+		const size_t oldCapacity = mCapacity;
+
+		allocate(newCapacity);
+
+		for (size_t i = 0; i < oldCapacity; ++i)
+		{
+			if (oldControl[i] >= 0)
+			{
+				const size_t hash = hashOf(oldSlots[i].first);
+				const size_t index = findFirstNonFull(hash);
+
+				mControl[index] = static_cast<signed char>(hash & 0x7F);
+				new (mSlots + index) value_type(std::move(oldSlots[i]));
+				oldSlots[i].~value_type();
+			}
+		}
+
+		mGrowthLeft = maxLoad(mCapacity) - mSize;
+
+		bsMemoryTracker::deallocate(oldControl);
+	}
+
+	/*	Allocates the control bytes and the entries in one block, with all entries empty.
+		The capacity is a multiple of the group size, so the entries following the control
+		bytes are 16 byte aligned.
+	*/
+	void allocate(size_t capacity)
+	{
+		const size_t alignment = __alignof(value_type) > kGroupSize
+			? __alignof(value_type) : kGroupSize;
+
+		mControl = static_cast<signed char*>(bsMemoryTracker::allocate(
+			capacity + capacity * sizeof(value_type), alignment,
+			bsMemoryTracker::getThreadTag()));
+		BS_ASSERT2(mControl, "Out of memory");
+
+		mSlots = reinterpret_cast<value_type*>(mControl + capacity);
+		mCapacity = capacity;
+
+		memset(mControl, kEmpty, capacity);
+	}
+
+	void destroyEntries()
+	{
+		for (size_t i = 0; i < mCapacity; ++i)
+		{
+			if (mControl[i] >= 0)
+			{
+				mSlots[i].~value_type();
+			}
+		}
+	}
+
+	void destroyAndFree()
+	{
+		destroyEntries();
+		bsMemoryTracker::deallocate(mControl);
+
+		mControl = nullptr;
+		mSlots = nullptr;
+		mCapacity = mSize = mGrowthLeft = 0;
+	}
+
+	//This map must be empty with no allocated memory.
+	void copyFrom(const bsFlatHashMap& other)
+	{
+		if (other.mCapacity == 0)
+		{
+			return;
+		}
+
+		//Same capacity and control bytes, so every entry can be copied to the same index.
+		allocate(other.mCapacity);
+		memcpy(mControl, other.mControl, mCapacity);
+
+		for (size_t i = 0; i < mCapacity; ++i)
+		{
+			if (mControl[i] >= 0)
+			{
+				new (mSlots + i) value_type(other.mSlots[i]);
+			}
+		}
+
+		mSize = other.mSize;
+		mGrowthLeft = other.mGrowthLeft;
+	}
+
+
+	signed char*	mControl;
+	value_type*		mSlots;
+	size_t			mCapacity;
+	size_t			mSize;
+
+	//Number of empty entries which can be filled before the map must grow.
+	size_t			mGrowthLeft;
+
+	Hasher			mHasher;
+	KeyEqual		mKeyEqual;
+};
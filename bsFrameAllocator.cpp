@@ -0,0 +1,97 @@
+#include "StdAfx.h"
+
+#include "bsFrameAllocator.h"
+
+#include "bsAssert.h"
+#include "bsLog.h"
+#include "bsMemory.h"
+#include "bsMemoryTracker.h"
+
+
+bsFrameAllocator::bsFrameAllocator(size_t bytesPerFrame, bool useHugePages)
+	: mCurrentAllocator(0)
+	, mPeakBytesPerFrame(0)
+{
+	if (useHugePages && bsMemory::getHugePageSize() != 0)
+	{
+		//The rest of the last huge page would be wasted otherwise.
+		const size_t hugePageSize = bsMemory::getHugePageSize();
+		bytesPerFrame = (bytesPerFrame + hugePageSize - 1) / hugePageSize * hugePageSize;
+	}
+
+	for (unsigned int i = 0; i < 2; ++i)
+	{
+		mBuffers[i] = bsMemory::allocateLarge(bytesPerFrame, useHugePages);
+		BS_ASSERT2(mBuffers[i] != nullptr, "Out of memory");
+
+		mAllocators[i] = new bsLinearHeapAllocator(mBuffers[i], bytesPerFrame);
+	}
+
+	mOverflowBytes[0] = mOverflowBytes[1] = 0;
+}
+
+bsFrameAllocator::~bsFrameAllocator()
+{
+	freeOverflowAllocations(0);
+	freeOverflowAllocations(1);
+
+	delete mAllocators[0];
+	delete mAllocators[1];
+
+	bsMemory::freeLarge(mBuffers[0]);
+	bsMemory::freeLarge(mBuffers[1]);
+}
+
+void bsFrameAllocator::beginFrame()
+{
+	//Record how much the frame that just ended used before switching.
+	bsLinearHeapAllocator& previous = *mAllocators[mCurrentAllocator];
+	const size_t usedBytes = previous.getMemorySize() - previous.getNumRemainingBytes()
+		+ mOverflowBytes[mCurrentAllocator];
+	if (usedBytes > mPeakBytesPerFrame)
+	{
+		mPeakBytesPerFrame = usedBytes;
+	}
+
+	if (mOverflowBytes[mCurrentAllocator] != 0)
+	{
+		BS_LOG_WARNING(RENDER, "Frame allocator ran out of memory, a frame needed %u"
+			" bytes but only %u are available", static_cast<unsigned int>(usedBytes),
+			static_cast<unsigned int>(previous.getMemorySize()));
+	}
+
+	mCurrentAllocator ^= 1;
+
+	freeOverflowAllocations(mCurrentAllocator);
+	mAllocators[mCurrentAllocator]->clear();
+}
+
+void* bsFrameAllocator::allocate(size_t bytes, size_t alignment)
+{
+	void* memory = mAllocators[mCurrentAllocator]->allocate(bytes, alignment);
+	if (memory != nullptr)
+	{
+		return memory;
+	}
+
+	//Out of memory, fall back to the heap until this buffer is cleared.
+	memory = bsMemoryTracker::allocate(bytes, alignment, bsMemoryTracker::TAG_ALLOCATORS);
+	BS_ASSERT2(memory != nullptr, "Out of memory");
+
+	mOverflowAllocations[mCurrentAllocator].push_back(memory);
+	mOverflowBytes[mCurrentAllocator] += bytes;
+
+	return memory;
+}
+
+void bsFrameAllocator::freeOverflowAllocations(unsigned int allocatorIndex)
+{
+	std::vector<void*>& allocations = mOverflowAllocations[allocatorIndex];
+	for (size_t i = 0; i < allocations.size(); ++i)
+	{
+		bsMemoryTracker::deallocate(allocations[i]);
+	}
+
+	allocations.clear();
+	mOverflowBytes[allocatorIndex] = 0;
+}
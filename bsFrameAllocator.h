@@ -0,0 +1,95 @@
+#pragma once
+
+#include <vector>
+
+#include "bsLinearHeapAllocator.h"
+
+
+/*	Double buffered linear allocator for data which only lives for a frame.
+
+	Every frame allocates from one of two buffers, alternating between them. A buffer is
+	cleared when a frame starts using it, so memory allocated during a frame stays valid
+	until the end of the next frame. This allows a frame's data to still be read while the
+	next frame is being built.
+	Nothing allocated from this allocator is destructed, so only use it for types which
+	don't need destructing.
+
+	If a buffer runs out of memory, allocations fall back to the heap until that buffer
+	is cleared again, and a warning containing the required size is logged so that the
+	buffer size can be increased.
+
+	Not thread safe.
+*/
+class bsFrameAllocator
+{
+public:
+	typedef bsLinearHeapAllocator::Marker Marker;
+
+	/*	Allocates two buffers of bytesPerFrame bytes each.
+		With useHugePages, the buffers are backed by huge pages if available, see
+		bsMemory::allocateLarge. This rounds their size up to the huge page size.
+	*/
+	explicit bsFrameAllocator(size_t bytesPerFrame, bool useHugePages = false);
+
+	~bsFrameAllocator();
+
+	/*	Switches to the other buffer and clears it, invalidating everything allocated from
+		it two frames ago. Call once at the start of every frame.
+	*/
+	void beginFrame();
+
+	/*	Allocates bytes bytes aligned to alignment, which must be a power of 2.
+		Never returns null.
+	*/
+	void* allocate(size_t bytes, size_t alignment);
+
+	/*	Allocates enough memory for the requested amount of objects, aligned to the type's
+		alignment requirement. The objects are not constructed.
+	*/
+	template <typename T>
+	inline T* allocate(size_t count)
+	{
+		return static_cast<T*>(allocate(sizeof(T) * count, __alignof(T)));
+	}
+
+	/*	Marker for the current frame's buffer, see bsLinearHeapAllocator::getMarker.
+		Heap allocations made because the buffer ran out of memory are not freed by
+		rewinding, only when the buffer is cleared.
+	*/
+	inline Marker getMarker() const
+	{
+		return mAllocators[mCurrentAllocator]->getMarker();
+	}
+
+	inline void rewind(Marker marker)
+	{
+		mAllocators[mCurrentAllocator]->rewind(marker);
+	}
+
+	/*	The highest number of bytes a single frame has needed, including heap allocations
+		made when running out of memory.
+	*/
+	inline size_t getPeakBytesPerFrame() const
+	{
+		return mPeakBytesPerFrame;
+	}
+
+private:
+	//Non-copyable.
+	bsFrameAllocator(const bsFrameAllocator&);
+	bsFrameAllocator& operator=(const bsFrameAllocator&);
+
+	void freeOverflowAllocations(unsigned int allocatorIndex);
+
+
+	bsLinearHeapAllocator*	mAllocators[2];
+	//The allocators' buffers, from bsMemory::allocateLarge.
+	void*					mBuffers[2];
+	unsigned int			mCurrentAllocator;
+
+	//Heap allocations made when a buffer ran out of memory, freed when it is cleared.
+	std::vector<void*>		mOverflowAllocations[2];
+	size_t					mOverflowBytes[2];
+
+	size_t					mPeakBytesPerFrame;
+};
@@ -0,0 +1,269 @@
+#include "StdAfx.h"
+
+#include "bsFrameCapture.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "bsFrameSnapshot.h"
+#include "bsRenderBatcher.h"
+#include "bsFlatHashMap.h"
+#include "bsLog.h"
+#include "bsAssert.h"
+#include "bsMemoryTracker.h"
+
+
+namespace
+{
+/*	Assigns indices to the distinct components of one type, in the order they are first
+	seen.
+*/
+class ComponentIndexer
+{
+public:
+	ComponentIndexer()
+		: mCount(0)
+	{
+	}
+
+	unsigned int getIndex(const void* component)
+	{
+		if (component == nullptr)
+		{
+			return kFrameCaptureNoComponent;
+		}
+
+		auto itr = mIndices.find(component);
+		if (itr != mIndices.end())
+		{
+			return itr->second;
+		}
+
+		mIndices.insert(std::make_pair(component, mCount));
+
+		return mCount++;
+	}
+
+	inline unsigned int getCount() const
+	{
+		return mCount;
+	}
+
+private:
+	bsFlatHashMap<const void*, unsigned int>	mIndices;
+	unsigned int	mCount;
+};
+}
+
+
+bool bsSaveFrameCapture(const std::string& fileName, const bsFrameSnapshot& snapshot,
+	const bsRenderBatcher& batcher)
+{
+	return bsSaveFrameCapture(fileName, snapshot.getEntities(), snapshot.getEntityCount(),
+		snapshot.getView(), snapshot.getCameraPosition(), snapshot.getFrustum(), batcher);
+}
+
+bool bsSaveFrameCapture(const std::string& fileName, const bsEntitySnapshot* entities,
+	unsigned int entityCount, const XMMATRIX& view, const XMVECTOR& cameraPosition,
+	const bsFrustum& frustum, const bsRenderBatcher& batcher)
+{
+	ComponentIndexer meshRenderers;
+	ComponentIndexer lineRenderers;
+	ComponentIndexer lights;
+	ComponentIndexer texts;
+
+	std::vector<bsFrameCaptureEntity> capturedEntities(entityCount);
+	for (unsigned int i = 0; i < entityCount; ++i)
+	{
+		const bsEntitySnapshot& entity = entities[i];
+		bsFrameCaptureEntity& captured = capturedEntities[i];
+
+		XMStoreFloat4x4(&captured.transposedTransform, entity.transposedTransform);
+		XMStoreFloat4(&captured.position, entity.position);
+		XMStoreFloat4(&captured.rotation, entity.rotation);
+		XMStoreFloat4(&captured.boundingSphere, entity.boundingSphere.positionAndRadius);
+
+		captured.meshRenderer = meshRenderers.getIndex(entity.meshRenderer);
+		captured.lineRenderer = lineRenderers.getIndex(entity.lineRenderer);
+		captured.light = lights.getIndex(entity.light);
+		captured.textRenderer = texts.getIndex(entity.textRenderer);
+		captured.lightType = entity.lightType;
+		captured.removed = entity.entity == nullptr ? 1 : 0;
+	}
+
+	bsFrameCaptureHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "bsfc", 4);
+	header.version = kFrameCaptureVersion;
+
+	header.entityCount = entityCount;
+	header.meshRendererCount = meshRenderers.getCount();
+	header.lineRendererCount = lineRenderers.getCount();
+	header.lightCount = lights.getCount();
+	header.textCount = texts.getCount();
+
+	header.visibleEntityCount = batcher.getBatchedEntityCount();
+	header.meshBatchCount = batcher.getMeshBatches().size();
+	header.lineBatchCount = batcher.getLineBatches().size();
+	header.pointLightCount = batcher.getPointLights().size();
+	header.spotLightCount = batcher.getSpotLights().size();
+
+	XMStoreFloat4x4(&header.view, view);
+	XMStoreFloat4(&header.cameraPosition, cameraPosition);
+	for (unsigned int i = 0; i < 6; ++i)
+	{
+		XMStoreFloat4(&header.frustumPlanes[i], frustum.planes[i]);
+	}
+
+#pragma warning (disable : 4996)//warning C4996: 'fopen' was declared deprecated
+	FILE* file = fopen(fileName.c_str(), "wb");
+#pragma warning (default : 4996)
+	if (file == nullptr)
+	{
+		BS_LOG_ERROR(IO, "Failed to open '%s' for writing a frame capture",
+			fileName.c_str());
+
+		return false;
+	}
+
+	bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+	if (success && entityCount != 0)
+	{
+		success = fwrite(&capturedEntities[0], sizeof(bsFrameCaptureEntity) * entityCount,
+			1, file) == 1;
+	}
+
+	fclose(file);
+
+	if (!success)
+	{
+		BS_LOG_ERROR(IO, "Failed to write frame capture '%s'", fileName.c_str());
+
+		return false;
+	}
+
+	BS_LOG_INFO(RENDER, "Captured a frame with %u entities (%u visible) to '%s'",
+		entityCount, header.visibleEntityCount, fileName.c_str());
+
+	return true;
+}
+
+
+bsFrameCapture::bsFrameCapture()
+	: mEntities(nullptr)
+{
+	memset(&mHeader, 0, sizeof(mHeader));
+}
+
+bsFrameCapture::~bsFrameCapture()
+{
+	clear();
+}
+
+void bsFrameCapture::clear()
+{
+	bsMemoryTracker::deallocate(mEntities);
+	mEntities = nullptr;
+
+	memset(&mHeader, 0, sizeof(mHeader));
+	mPlaceholders.clear();
+}
+
+bool bsFrameCapture::load(const std::string& fileName)
+{
+	clear();
+
+#pragma warning (disable : 4996)//warning C4996: 'fopen' was declared deprecated
+	FILE* file = fopen(fileName.c_str(), "rb");
+#pragma warning (default : 4996)
+	if (file == nullptr)
+	{
+		BS_LOG_ERROR(IO, "Failed to open frame capture '%s'", fileName.c_str());
+
+		return false;
+	}
+
+	bsFrameCaptureHeader header;
+	if (fread(&header, sizeof(header), 1, file) != 1
+		|| memcmp(header.magic, "bsfc", 4) != 0
+		|| header.version != kFrameCaptureVersion)
+	{
+		fclose(file);
+
+		BS_LOG_ERROR(IO, "'%s' is not a frame capture of version %u", fileName.c_str(),
+			kFrameCaptureVersion);
+
+		return false;
+	}
+
+	std::vector<bsFrameCaptureEntity> capturedEntities(header.entityCount);
+	const bool success = header.entityCount == 0 || fread(&capturedEntities[0],
+		sizeof(bsFrameCaptureEntity) * header.entityCount, 1, file) == 1;
+
+	fclose(file);
+
+	if (!success)
+	{
+		BS_LOG_ERROR(IO, "Frame capture '%s' is truncated", fileName.c_str());
+
+		return false;
+	}
+
+	//One placeholder per component, meshes first, then lines, lights and texts.
+	const unsigned int lineOffset = header.meshRendererCount;
+	const unsigned int lightOffset = lineOffset + header.lineRendererCount;
+	const unsigned int textOffset = lightOffset + header.lightCount;
+	mPlaceholders.resize(textOffset + header.textCount);
+
+	mEntities = static_cast<bsEntitySnapshot*>(bsMemoryTracker::allocate(
+		sizeof(bsEntitySnapshot) * std::max(header.entityCount, 1u),
+		__alignof(bsEntitySnapshot), bsMemoryTracker::TAG_SCENE));
+
+	for (unsigned int i = 0; i < header.entityCount; ++i)
+	{
+		const bsFrameCaptureEntity& captured = capturedEntities[i];
+		bsEntitySnapshot& entity = mEntities[i];
+
+		entity.transposedTransform = XMLoadFloat4x4(&captured.transposedTransform);
+		entity.position = XMLoadFloat4(&captured.position);
+		entity.rotation = XMLoadFloat4(&captured.rotation);
+		entity.boundingSphere.positionAndRadius = XMLoadFloat4(&captured.boundingSphere);
+
+		entity.meshRenderer = reinterpret_cast<const bsMeshRenderer*>(getPlaceholder(
+			captured.meshRenderer, 0, header.meshRendererCount));
+		entity.lineRenderer = reinterpret_cast<const bsLineRenderer*>(getPlaceholder(
+			captured.lineRenderer, lineOffset, header.lineRendererCount));
+		entity.light = reinterpret_cast<const bsLight*>(getPlaceholder(
+			captured.light, lightOffset, header.lightCount));
+		entity.textRenderer = reinterpret_cast<const bsText3D*>(getPlaceholder(
+			captured.textRenderer, textOffset, header.textCount));
+		entity.lightType = static_cast<unsigned char>(captured.lightType);
+
+		//Culling skips entities without a bsEntity, like it did when captured.
+		entity.entity = captured.removed != 0 ? nullptr
+			: reinterpret_cast<const bsEntity*>(&mEntityPlaceholder);
+	}
+
+	mHeader = header;
+
+	return true;
+}
+
+const void* bsFrameCapture::getPlaceholder(unsigned int index, unsigned int offset,
+	unsigned int count) const
+{
+	if (index == kFrameCaptureNoComponent)
+	{
+		return nullptr;
+	}
+
+	BS_ASSERT2(index < count, "Frame capture refers to a component which does not exist");
+	if (index >= count)
+	{
+		return nullptr;
+	}
+
+	return &mPlaceholders[offset + index];
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <Windows.h>
+#include <xnamath.h>
+
+#include "bsFrustum.h"
+
+class bsFrameSnapshot;
+class bsRenderBatcher;
+struct bsEntitySnapshot;
+
+
+/*	Frame capture layout, all values are little endian:
+
+Byte		Description
+1-4			File format identification, "bsfc" (chars).
+5-8			Version information (uint).
+9-224		Rest of bsFrameCaptureHeader: counts, camera and frustum.
+225-...		bsFrameCaptureEntity * entity count (defined in the header).
+
+A capture is the snapshot a frame was drawn from, which is everything culling and
+batching read, together with what they produced when the frame was captured.
+*/
+
+/*	Version info is stored in the header, and must be equal to this value when loaded.
+
+	Version history:
+	0: Initial version.
+	1: Entities store whether they had been removed from the scene.
+*/
+const unsigned int kFrameCaptureVersion = 1;
+
+//Component index of entities which don't have the component.
+const unsigned int kFrameCaptureNoComponent = 0xFFFFFFFF;
+
+
+#pragma pack(push, 1)
+struct bsFrameCaptureHeader
+{
+	char			magic[4];
+	unsigned int	version;
+
+	unsigned int	entityCount;
+	//Distinct components referenced by the entities.
+	unsigned int	meshRendererCount;
+	unsigned int	lineRendererCount;
+	unsigned int	lightCount;
+	unsigned int	textCount;
+
+	//What culling and batching produced when the frame was captured.
+	unsigned int	visibleEntityCount;
+	unsigned int	meshBatchCount;
+	unsigned int	lineBatchCount;
+	unsigned int	pointLightCount;
+	unsigned int	spotLightCount;
+
+	XMFLOAT4X4		view;
+	XMFLOAT4		cameraPosition;
+	//Near, far, right, left, top and bottom, like bsFrustum.
+	XMFLOAT4		frustumPlanes[6];
+};
+
+struct bsFrameCaptureEntity
+{
+	XMFLOAT4X4		transposedTransform;
+	XMFLOAT4		position;
+	XMFLOAT4		rotation;
+	XMFLOAT4		boundingSphere;
+
+	//Indices of the entity's components, or kFrameCaptureNoComponent.
+	unsigned int	meshRenderer;
+	unsigned int	lineRenderer;
+	unsigned int	light;
+	unsigned int	textRenderer;
+
+	unsigned int	lightType;
+
+	/*	1 if the entity was removed from the scene after the snapshot was captured (see
+		bsFrameSnapshot::removeEntity), 0 otherwise. Culling skips removed entities.
+	*/
+	unsigned int	removed;
+};
+#pragma pack(pop)
+
+
+/*	Saves the snapshot a frame was drawn from to a file, so that a slow frame can be
+	reproduced without the scene it came from. See bsRenderQueue::requestFrameCapture.
+
+	The components are not saved, only which entities share them. batcher must have
+	batched the snapshot's visible entities, its results are saved so that replays can
+	check that they reproduce the frame.
+	Returns true on success.
+*/
+bool bsSaveFrameCapture(const std::string& fileName, const bsFrameSnapshot& snapshot,
+	const bsRenderBatcher& batcher);
+
+/*	Saves entities which were not captured by a bsFrameSnapshot, like the synthetic
+	scenes of the benchmarks, as if they were a snapshot with the given camera.
+*/
+bool bsSaveFrameCapture(const std::string& fileName, const bsEntitySnapshot* entities,
+	unsigned int entityCount, const XMMATRIX& view, const XMVECTOR& cameraPosition,
+	const bsFrustum& frustum, const bsRenderBatcher& batcher);
+
+
+/*	A frame capture loaded from a file, with entities ready to be culled and batched
+	again by bsRenderBatcher. See tools/bsFrameReplay.cpp.
+
+	The entities refer to placeholder addresses instead of components, one for every
+	distinct component in the captured frame. Batching only uses them as keys, so it
+	groups the entities like it did when the frame was captured. Entities which had not
+	been removed from the scene refer to a placeholder bsEntity, so that culling keeps
+	them. The placeholders must never be dereferenced, and the entities can't be drawn.
+*/
+class bsFrameCapture
+{
+public:
+	bsFrameCapture();
+
+	~bsFrameCapture();
+
+	/*	Loads a capture, replacing the one loaded before.
+		Returns false and leaves this capture empty if the file is missing, truncated or
+		from a different version.
+	*/
+	bool load(const std::string& fileName);
+
+
+	inline const bsFrameCaptureHeader& getHeader() const
+	{
+		return mHeader;
+	}
+
+	inline const bsEntitySnapshot* getEntities() const
+	{
+		return mEntities;
+	}
+
+	inline unsigned int getEntityCount() const
+	{
+		return mHeader.entityCount;
+	}
+
+	inline XMMATRIX getView() const
+	{
+		return XMLoadFloat4x4(&mHeader.view);
+	}
+
+	inline XMVECTOR getCameraPosition() const
+	{
+		return XMLoadFloat4(&mHeader.cameraPosition);
+	}
+
+	inline bsFrustum getFrustum() const
+	{
+		bsFrustum frustum;
+		for (unsigned int i = 0; i < 6; ++i)
+		{
+			frustum.planes[i] = XMLoadFloat4(&mHeader.frustumPlanes[i]);
+		}
+
+		return frustum;
+	}
+
+private:
+	//Non-copyable.
+	bsFrameCapture(const bsFrameCapture&);
+	bsFrameCapture& operator=(const bsFrameCapture&);
+
+	void clear();
+
+	/*	Returns the placeholder standing in for component index of one type, whose
+		placeholders start at offset, or null if the entity has no such component.
+	*/
+	const void* getPlaceholder(unsigned int index, unsigned int offset,
+		unsigned int count) const;
+
+
+	struct Placeholder
+	{
+		char	data[16];
+	};
+
+	bsFrameCaptureHeader	mHeader;
+
+	//Aligned, allocated like the entities of bsFrameSnapshot.
+	bsEntitySnapshot*		mEntities;
+
+	std::vector<Placeholder>	mPlaceholders;
+	//Stands in for the bsEntity of every entity which had not been removed.
+	Placeholder				mEntityPlaceholder;
+};
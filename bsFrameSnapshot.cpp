@@ -0,0 +1,110 @@
+#include "StdAfx.h"
+
+#include "bsFrameSnapshot.h"
+
+#include "bsEntity.h"
+#include "bsCamera.h"
+#include "bsLight.h"
+#include "bsJobSystem.h"
+#include "bsTimer.h"
+#include "bsAssert.h"
+#include "bsMemoryTracker.h"
+#include "bsProfiler.h"
+
+
+namespace
+{
+//Entities copied per job.
+const unsigned int kCaptureGrainSize = 512;
+}
+
+
+bsFrameSnapshot::bsFrameSnapshot()
+	: mEntities(nullptr)
+	, mEntityCount(0)
+	, mEntityCapacity(0)
+	, mView(XMMatrixIdentity())
+	, mCameraPosition(XMVectorZero())
+	, mCaptureTicks(0)
+{
+	memset(&mFrustum, 0, sizeof(mFrustum));
+}
+
+bsFrameSnapshot::~bsFrameSnapshot()
+{
+	bsMemoryTracker::deallocate(mEntities);
+}
+
+void bsFrameSnapshot::capture(const std::vector<bsEntity*>& entities,
+	const bsCamera& camera, bsJobSystem& jobSystem)
+{
+	BS_ASSERT2(camera.getEntity() != nullptr, "Camera must be attached to an entity"
+		" before capturing a snapshot");
+
+	const unsigned int entityCount = entities.size();
+	if (entityCount > mEntityCapacity)
+	{
+		//Grow with some slack, since entities are usually added a few at a time.
+		bsMemoryTracker::deallocate(mEntities);
+		mEntityCapacity = entityCount + entityCount / 2;
+		mEntities = static_cast<bsEntitySnapshot*>(bsMemoryTracker::allocate(
+			sizeof(bsEntitySnapshot) * mEntityCapacity, __alignof(bsEntitySnapshot),
+			bsMemoryTracker::TAG_SCENE));
+	}
+	mEntityCount = entityCount;
+
+	bsEntity* const* source = entities.data();
+	bsEntitySnapshot* destination = mEntities;
+
+	jobSystem.parallelFor(entityCount, kCaptureGrainSize,
+		[=](unsigned int begin, unsigned int end)
+	{
+		BS_PROFILE_SCOPE("Capture entities");
+
+		for (unsigned int i = begin; i < end; ++i)
+		{
+			const bsEntity& entity = *source[i];
+			const bsTransform& transform = entity.getTransform();
+			bsEntitySnapshot& snapshot = destination[i];
+
+			snapshot.transposedTransform = transform.getTransposedTransform();
+			snapshot.position = transform.getPosition();
+			snapshot.rotation = transform.getRotation();
+			snapshot.boundingSphere = entity.getBoundingSphere();
+
+			snapshot.meshRenderer = entity.getMeshRenderer();
+			snapshot.lineRenderer = entity.getLineRenderer();
+			snapshot.light = entity.getLight();
+			snapshot.textRenderer = entity.getTextRenderer();
+			snapshot.lightType = static_cast<unsigned char>(snapshot.light != nullptr
+				? snapshot.light->getLightType() : 0);
+
+			snapshot.entity = &entity;
+		}
+	});
+
+	mView = camera.getViewMatrix();
+	mCameraPosition = camera.getEntity()->getTransform().getPosition();
+	mFrustum = camera.getTransformedFrustum();
+
+	mCaptureTicks = bsTimer::getTicks();
+}
+
+void bsFrameSnapshot::removeEntity(const bsEntity& entity)
+{
+	for (unsigned int i = 0; i < mEntityCount; ++i)
+	{
+		bsEntitySnapshot& snapshot = mEntities[i];
+		if (snapshot.entity == &entity)
+		{
+			//Kept in place but no longer drawn.
+			snapshot.meshRenderer = nullptr;
+			snapshot.lineRenderer = nullptr;
+			snapshot.light = nullptr;
+			snapshot.textRenderer = nullptr;
+			snapshot.entity = nullptr;
+
+			return;
+		}
+	}
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <vector>
+
+#include <Windows.h>
+#include <xnamath.h>
+
+#include "bsCollision.h"
+#include "bsFrustum.h"
+#include "bsMemoryTracker.h"
+
+class bsEntity;
+class bsCamera;
+class bsMeshRenderer;
+class bsLineRenderer;
+class bsLight;
+class bsText3D;
+class bsJobSystem;
+
+
+/*	Everything the render queue needs from an entity, copied when a snapshot is captured.
+*/
+__declspec(align(16)) struct bsEntitySnapshot
+{
+	XMMATRIX	transposedTransform;
+	XMVECTOR	position;
+	XMVECTOR	rotation;
+	//In the entity's space, like bsEntity::getBoundingSphere.
+	bsCollision::Sphere	boundingSphere;
+
+	//Null when the entity does not have the component.
+	const bsMeshRenderer*	meshRenderer;
+	const bsLineRenderer*	lineRenderer;
+	const bsLight*			light;
+	const bsText3D*			textRenderer;
+
+	const bsEntity*			entity;
+
+	//The light's bsLight::LightType, copied so that batching does not read the light.
+	unsigned char			lightType;
+};
+
+
+/*	The renderable state of a scene at one point in time: the transform and renderable
+	components of every entity, and the camera.
+
+	The render queue draws from a snapshot instead of from the live entities, so the
+	scene can be simulated while a previous snapshot is being rendered. Snapshots are
+	double buffered by bsScene, see bsScene::setPipelinedSimulation.
+
+	Components are referenced, not copied, so they must outlive the snapshots referring
+	to them. bsScene::removeEntity takes care of this.
+*/
+__declspec(align(16)) class bsFrameSnapshot
+{
+public:
+	void* operator new(size_t size)
+	{
+		return bsMemoryTracker::allocate(size, 16, bsMemoryTracker::TAG_SCENE);
+	}
+
+	void operator delete(void* p)
+	{
+		bsMemoryTracker::deallocate(p);
+	}
+
+
+	bsFrameSnapshot();
+
+	~bsFrameSnapshot();
+
+	/*	Copies the state of the entities and the camera into this snapshot, overwriting
+		what was there before. The copying is split into jobs.
+		The entities must not be modified until this returns.
+	*/
+	void capture(const std::vector<bsEntity*>& entities, const bsCamera& camera,
+		bsJobSystem& jobSystem);
+
+	/*	Makes this snapshot stop referring to an entity's components, so that the entity
+		can be destroyed without leaving dangling pointers behind.
+	*/
+	void removeEntity(const bsEntity& entity);
+
+
+	inline const bsEntitySnapshot* getEntities() const
+	{
+		return mEntities;
+	}
+
+	inline unsigned int getEntityCount() const
+	{
+		return mEntityCount;
+	}
+
+	//The camera's view matrix when captured.
+	inline const XMMATRIX& getView() const
+	{
+		return mView;
+	}
+
+	inline const XMVECTOR& getCameraPosition() const
+	{
+		return mCameraPosition;
+	}
+
+	//The camera's frustum in world space when captured.
+	inline const bsFrustum& getFrustum() const
+	{
+		return mFrustum;
+	}
+
+	/*	bsTimer ticks when the snapshot was captured, or 0 if it has never been captured.
+		Used to measure latency from simulation to present.
+	*/
+	inline long long getCaptureTicks() const
+	{
+		return mCaptureTicks;
+	}
+
+private:
+	//Non-copyable.
+	bsFrameSnapshot(const bsFrameSnapshot&);
+	bsFrameSnapshot& operator=(const bsFrameSnapshot&);
+
+
+	/*	Only grows, so that the memory is reused by later captures. Not a vector, since
+		vectors of aligned types can't be resized.
+	*/
+	bsEntitySnapshot*	mEntities;
+	unsigned int		mEntityCount;
+	unsigned int		mEntityCapacity;
+
+	XMMATRIX	mView;
+	XMVECTOR	mCameraPosition;
+	bsFrustum	mFrustum;
+
+	long long	mCaptureTicks;
+};
@@ -24,11 +24,25 @@ struct bsFrameStatistics
 	{
 		float stepDuration;
 		float synchronizationDuration;
+		unsigned int numSteps;
 		unsigned int numActiveRigidBodies;
 		unsigned int numActiveSimulationIslands;
 		unsigned int numContacts;
 	};
 
+	struct PipelineInfo
+	{
+		//True if the simulation ran concurrently with rendering, see bsScene.
+		bool pipelined;
+		/*	Time from when the rendered state was captured, right after it was simulated,
+			until the frame was presented.
+		*/
+		float simulationToPresentLatency;
+		//Time the calling thread spent waiting for the simulation thread.
+		float simulationWaitDuration;
+	};
+
 	RenderingInfo renderingInfo;
 	PhysicsInfo physicsInfo;
+	PipelineInfo pipelineInfo;
 };
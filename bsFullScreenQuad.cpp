@@ -7,14 +7,15 @@
 #include "bsLog.h"
 #include "bsVertexTypes.h"
 #include "bsAssert.h"
-#include "bsFixedSizeString.h"
+#include "bsRenderDevice.h"
 
 
-bsFullScreenQuad::bsFullScreenQuad(ID3D11Device* const device)
-	: mVertexBuffer(nullptr)
+bsFullScreenQuad::bsFullScreenQuad(bsRenderDevice& renderDevice)
+	: mRenderDevice(renderDevice)
+	, mVertexBuffer(nullptr)
 	, mIndexBuffer(nullptr)
+	, mSamplerState(nullptr)
 {
-	BS_ASSERT(device);
 
 	bsVertexTex vertices[] = 
 	{
@@ -42,11 +43,10 @@ bsFullScreenQuad::bsFullScreenQuad(ID3D11Device* const device)
 	memset(&initData, 0, sizeof(initData));
 	initData.pSysMem = &vertices[0];
 
-	if (FAILED(device->CreateBuffer(&bufferDescription, &initData,
+	if (FAILED(mRenderDevice.createBuffer(bufferDescription, &initData,
 		&mVertexBuffer)))
 	{
-		bsLog::log("Failed to create vertex buffer for fullscreen quad",
-			bsLog::SEV_ERROR);
+		BS_LOG_ERROR(RENDER, "Failed to create vertex buffer for fullscreen quad");
 	}
 
 	//Index buffer
@@ -54,11 +54,10 @@ bsFullScreenQuad::bsFullScreenQuad(ID3D11Device* const device)
 	bufferDescription.BindFlags = D3D11_BIND_INDEX_BUFFER;
 	initData.pSysMem = &indices[0];
 
-	if (FAILED(device->CreateBuffer(&bufferDescription, &initData,
+	if (FAILED(mRenderDevice.createBuffer(bufferDescription, &initData,
 		&mIndexBuffer)))
 	{
-		bsLog::log("Failed to create index buffer for fullscreen quad",
-			bsLog::SEV_ERROR);
+		BS_LOG_ERROR(RENDER, "Failed to create index buffer for fullscreen quad");
 	}
 
 	//Sampler state
@@ -72,49 +71,38 @@ bsFullScreenQuad::bsFullScreenQuad(ID3D11Device* const device)
 	samplerDesc.MinLOD = 0;
 	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
 	
-	if (FAILED(device->CreateSamplerState(&samplerDesc, &mSamplerState)))
+	if (FAILED(mRenderDevice.createSamplerState(samplerDesc, &mSamplerState)))
 	{
-		bsLog::log("Failed to create sampler state for fullscreen quad",
-			bsLog::SEV_ERROR);
+		BS_LOG_ERROR(RENDER, "Failed to create sampler state for fullscreen quad");
 	}
 
 
 #ifdef BS_DEBUG
-	bsString64 debugString("VertexBuffer fullscreen quad");
-	
-	mVertexBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, debugString.size(),
-		debugString.c_str());
-
-	debugString = "IndexBuffer fullscreen quad";
-	mIndexBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, debugString.size(),
-		debugString.c_str());
-
-	debugString = "ID3D11SamplerState fullscreen quad";
-
-	mSamplerState->SetPrivateData(WKPDID_D3DDebugObjectName, debugString.size(),
-		debugString.c_str());
+	mRenderDevice.setDebugName(mVertexBuffer, "VertexBuffer fullscreen quad");
+	mRenderDevice.setDebugName(mIndexBuffer, "IndexBuffer fullscreen quad");
+	mRenderDevice.setDebugName(mSamplerState, "ID3D11SamplerState fullscreen quad");
 #endif
 }
 
 bsFullScreenQuad::~bsFullScreenQuad()
 {
-	mVertexBuffer->Release();
-	mIndexBuffer->Release();
+	mRenderDevice.release(mVertexBuffer);
+	mRenderDevice.release(mIndexBuffer);
 
-	mSamplerState->Release();
+	mRenderDevice.release(mSamplerState);
 }
 
-void bsFullScreenQuad::draw(ID3D11DeviceContext* const deviceContext) const
+void bsFullScreenQuad::draw() const
 {
-	deviceContext->IASetIndexBuffer(mIndexBuffer, DXGI_FORMAT_R16_UINT, 0);
+	mRenderDevice.setIndexBuffer(mIndexBuffer, DXGI_FORMAT_R16_UINT, 0);
 
-	UINT offsets =  0;
-	UINT stride = sizeof(bsVertexTex);
-	deviceContext->IASetVertexBuffers(0, 1, &mVertexBuffer, &stride, &offsets);
+	const unsigned int offsets =  0;
+	const unsigned int stride = sizeof(bsVertexTex);
+	mRenderDevice.setVertexBuffers(0, 1, &mVertexBuffer, &stride, &offsets);
 
-	deviceContext->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	mRenderDevice.setPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-	deviceContext->PSSetSamplers(0, 1, &mSamplerState);
+	mRenderDevice.setPixelSamplers(0, 1, &mSamplerState);
 
-	deviceContext->DrawIndexed(6, 0, 0);
+	mRenderDevice.drawIndexed(6, 0, 0);
 }
@@ -3,6 +3,7 @@
 
 #include <d3d11.h>
 
+class bsRenderDevice;
 
 /*	Used for drawing full screen quads (two triangles with coordinates between
 	-1,-1-1 and	1,1,1).
@@ -12,16 +13,22 @@ class bsFullScreenQuad
 {
 	friend class bsRenderQueue;
 public:
-	bsFullScreenQuad(ID3D11Device* const device);
+	explicit bsFullScreenQuad(bsRenderDevice& renderDevice);
 
 	~bsFullScreenQuad();
 
 	/*	Draws the full screen quad.
 		Remember to set an appropriate shader before calling this.
 	*/
-	void draw(ID3D11DeviceContext* const deviceContext) const;
+	void draw() const;
 
 private:
+	//Non-copyable.
+	bsFullScreenQuad(const bsFullScreenQuad&);
+	bsFullScreenQuad& operator=(const bsFullScreenQuad&);
+
+	bsRenderDevice&	mRenderDevice;
+
 	ID3D11Buffer*	mVertexBuffer;
 	ID3D11Buffer*	mIndexBuffer;
 
@@ -12,11 +12,10 @@
 
 
 bsFxaaPass::bsFxaaPass(bsShaderManager* shaderManager, bsDx11Renderer* dx11Renderer)
-	: mDeviceContext(dx11Renderer->getDeviceContext())
-	, mShaderManager(shaderManager)
-	, mFullscreenQuad(dx11Renderer->getDevice())
-	, mFxaaPixelShader(shaderManager->getPixelShader("Fxaa.fx"))
-	, mPassthroughPixelShader(shaderManager->getPixelShader("Passthrough.fx"))
+	: mShaderManager(shaderManager)
+	, mFullscreenQuad(dx11Renderer->getRenderDevice())
+	, mFxaaPixelShader(shaderManager->getPixelShader(bsStringId("Fxaa.fx")))
+	, mPassthroughPixelShader(shaderManager->getPixelShader(bsStringId("Passthrough.fx")))
 {
 	std::vector<D3D11_INPUT_ELEMENT_DESC> inputLayout(2);
 	D3D11_INPUT_ELEMENT_DESC inputDesc;
@@ -31,7 +30,8 @@ bsFxaaPass::bsFxaaPass(bsShaderManager* shaderManager, bsDx11Renderer* dx11Rende
 	inputDesc.Format = DXGI_FORMAT_R32G32_FLOAT;
 	inputLayout[1] = inputDesc;
 
-	mVertexShader = mShaderManager->getVertexShader("Fxaa.fx", inputLayout.data(), inputLayout.size());
+	mVertexShader = mShaderManager->getVertexShader(bsStringId("Fxaa.fx"),
+		inputLayout.data(), inputLayout.size());
 }
 
 void bsFxaaPass::draw()
@@ -39,5 +39,5 @@ void bsFxaaPass::draw()
 	mShaderManager->setVertexShader(mVertexShader);
 	mShaderManager->setPixelShader(mFxaaPixelShader);
 
-	mFullscreenQuad.draw(mDeviceContext);
+	mFullscreenQuad.draw();
 }
@@ -8,7 +8,6 @@
 class bsPixelShader;
 class bsVertexShader;
 class bsShaderManager;
-struct ID3D11DeviceContext;
 
 
 class bsFxaaPass
@@ -21,7 +20,6 @@ public:
 
 
 private:
-	ID3D11DeviceContext*	mDeviceContext;
 	bsShaderManager*		mShaderManager;
 
 	bsFullScreenQuad	mFullscreenQuad;
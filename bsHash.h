@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string.h>
+
+
+/*	Contains hash functions used for file names and other identifiers.
+*/
+namespace bsHash
+{
+
+/*	64 bit FNV-1a hash of an array of bytes.
+	This hash is stored on disk (for example in pack file tables of contents), so changing
+	it will invalidate existing files.
+*/
+inline unsigned long long fnv1a64(const void* data, size_t dataSize)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+	unsigned long long hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < dataSize; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+/*	64 bit FNV-1a hash of a null terminated string, not including the null terminator.
+*/
+inline unsigned long long fnv1a64(const char* string)
+{
+	return fnv1a64(string, strlen(string));
+}
+
+}
@@ -59,6 +59,7 @@
 
 #include "bsLog.h"
 #include "bsAssert.h"
+#include "bsThreadPlacement.h"
 
 
 /*	Simple class which forwards all messages sent by Havok to bsLog, with correct severity
@@ -93,15 +94,15 @@ public:
 		{
 		case MESSAGE_ERROR:
 		case MESSAGE_ASSERT:
-			bsLog::log(correctedMessage.c_str(), bsLog::SEV_ERROR);
+			BS_LOG_ERROR(PHYSICS, "%s", correctedMessage.c_str());
 			return 1;
 
 		case MESSAGE_WARNING:
-			bsLog::log(correctedMessage.c_str(), bsLog::SEV_WARNING);
+			BS_LOG_WARNING(PHYSICS, "%s", correctedMessage.c_str());
 			break;
 
 		case MESSAGE_REPORT:
-			bsLog::log(correctedMessage.c_str(), bsLog::SEV_INFO);
+			BS_LOG_INFO(PHYSICS, "%s", correctedMessage.c_str());
 			break;
 		}
 
@@ -109,8 +110,10 @@ public:
 	}
 };
 
-bsHavokManager::bsHavokManager()
-	: mContext(nullptr)
+bsHavokManager::bsHavokManager(const bsThreadPlacement& threadPlacement,
+	unsigned int workerThreadCount)
+	: mThreadPlacement(threadPlacement)
+	, mContext(nullptr)
 	, mVisualDebugger(nullptr)
 {
 	//Allocate 2.5 MB for physics solver.
@@ -124,14 +127,23 @@ bsHavokManager::bsHavokManager()
 	//hkError::replaceInstance(new bsHavokErrorMessageRouter(errorReport, nullptr));
 	hkError::replaceInstance(new bsHavokErrorMessageRouter(nullptr, nullptr));
 
-	//Get number of available physical threads
-	hkHardwareInfo hwInfo;
-	hkGetHardwareInfo(hwInfo);
-	int totalNumThreadsUsed = hwInfo.m_numThreads;
+	//The pool's threads plus the thread stepping the world.
+	const int totalNumThreadsUsed = workerThreadCount + 1;
 
 	hkCpuJobThreadPoolCinfo threadPoolCinfo;
-	threadPoolCinfo.m_numThreads = totalNumThreadsUsed - 1;
+	threadPoolCinfo.m_numThreads = workerThreadCount;
 	threadPoolCinfo.m_timerBufferPerThreadAllocation = 2000000;//2 MB
+
+	//Havok creates the pool's threads itself, so they can only be given ideal processors.
+	if (threadPlacement.getPolicy() != bsThreadPlacement::POLICY_NONE)
+	{
+		for (unsigned int i = 0; i < workerThreadCount; ++i)
+		{
+			const int processor = threadPlacement.getIdealProcessor(
+				bsThreadPlacement::ROLE_PHYSICS, i + 1);
+			threadPoolCinfo.m_hardwareThreadIds.pushBack(processor);
+		}
+	}
 	mThreadPool = new hkCpuJobThreadPool(threadPoolCinfo);
 
 	hkJobQueueCinfo jobQueueInfo;
@@ -9,6 +9,7 @@ class hkProcessContext;
 class hkpPhysicsContext;
 class hkVisualDebugger;
 class hkpWorld;
+class bsThreadPlacement;
 
 
 /*	This class manages the core Havok objects, like the memory system, thread pool, etc.
@@ -17,7 +18,11 @@ class hkpWorld;
 class bsHavokManager
 {
 public:
-	bsHavokManager();
+	/*	Starts Havok with workerThreadCount threads in its thread pool, in addition to the
+		thread stepping a world.
+	*/
+	bsHavokManager(const bsThreadPlacement& threadPlacement,
+		unsigned int workerThreadCount);
 	~bsHavokManager();
 
 	void createVisualDebuggerForWorld(hkpWorld& world);
@@ -34,6 +39,14 @@ public:
 		return *mJobQueue;
 	}
 
+	/*	Placement of the physics threads. Threads which step worlds should be placed with
+		bsThreadPlacement::ROLE_PHYSICS and index 0.
+	*/
+	inline const bsThreadPlacement& getThreadPlacement() const
+	{
+		return mThreadPlacement;
+	}
+
 	/*	Returns information about memory used by Havok.
 	*/
 	hkMemoryAllocator::MemoryStatistics getMemoryStatistics() const;
@@ -42,6 +55,8 @@ private:
 	void createVDB(hkpWorld* world);
 
 
+	const bsThreadPlacement&	mThreadPlacement;
+
 	hkJobThreadPool*	mThreadPool;
 	hkJobQueue*			mJobQueue;
 
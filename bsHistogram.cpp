@@ -0,0 +1,161 @@
+#include "StdAfx.h"
+
+#include "bsHistogram.h"
+
+#include <intrin.h>
+
+#include "bsAssert.h"
+
+
+bsHistogram::bsHistogram()
+{
+	reset();
+}
+
+void bsHistogram::reset()
+{
+	for (unsigned int i = 0; i < kBucketCount; ++i)
+	{
+		mBuckets[i] = 0;
+	}
+
+	mCount = 0;
+	mSum = 0;
+	mMin = ~0ULL;
+	mMax = 0;
+}
+
+void bsHistogram::add(const bsHistogram& other)
+{
+	for (unsigned int i = 0; i < kBucketCount; ++i)
+	{
+		mBuckets[i] += other.mBuckets[i];
+	}
+
+	mCount += other.mCount;
+	mSum += other.mSum;
+
+	const unsigned long long otherMin = other.mMin;
+	if (otherMin < mMin)
+	{
+		mMin = otherMin;
+	}
+	const unsigned long long otherMax = other.mMax;
+	if (otherMax > mMax)
+	{
+		mMax = otherMax;
+	}
+}
+
+unsigned int bsHistogram::getBucket(unsigned long long value)
+{
+	if (value < 4)
+	{
+		return static_cast<unsigned int>(value);
+	}
+
+	//Index of the most significant bit, _BitScanReverse64 is not available on x86.
+	unsigned long mostSignificantBit;
+	const unsigned long high = static_cast<unsigned long>(value >> 32);
+	if (high != 0)
+	{
+		_BitScanReverse(&mostSignificantBit, high);
+		mostSignificantBit += 32;
+	}
+	else
+	{
+		_BitScanReverse(&mostSignificantBit, static_cast<unsigned long>(value));
+	}
+
+	//The two bits below the most significant bit select one of four sub buckets.
+	const unsigned int subBucket = static_cast<unsigned int>(
+		(value >> (mostSignificantBit - 2)) & 3);
+
+	return (mostSignificantBit - 1) * 4 + subBucket;
+}
+
+unsigned long long bsHistogram::getBucketUpperBound(unsigned int bucket)
+{
+	if (bucket < 4)
+	{
+		return bucket;
+	}
+
+	const unsigned int mostSignificantBit = bucket / 4 + 1;
+	const unsigned long long subBucket = bucket % 4;
+
+	const unsigned long long lowerBound = (4 + subBucket) << (mostSignificantBit - 2);
+	return lowerBound + (1ULL << (mostSignificantBit - 2)) - 1;
+}
+
+void bsHistogram::record(unsigned long long value)
+{
+	const unsigned int bucket = getBucket(value);
+	BS_ASSERT(bucket < kBucketCount);
+
+	++mBuckets[bucket];
+	++mCount;
+	mSum += value;
+
+	//Lock-free min/max, retry if another thread changed the value in between.
+	unsigned long long currentMin = mMin;
+	while (value < currentMin)
+	{
+		const unsigned long long previous = mMin.compare_and_swap(value, currentMin);
+		if (previous == currentMin)
+		{
+			break;
+		}
+		currentMin = previous;
+	}
+
+	unsigned long long currentMax = mMax;
+	while (value > currentMax)
+	{
+		const unsigned long long previous = mMax.compare_and_swap(value, currentMax);
+		if (previous == currentMax)
+		{
+			break;
+		}
+		currentMax = previous;
+	}
+}
+
+unsigned long long bsHistogram::getPercentile(float percentile) const
+{
+	const unsigned long long count = mCount;
+	if (count == 0)
+	{
+		return 0;
+	}
+
+	//Number of values at or below the percentile, rounded up.
+	unsigned long long target = static_cast<unsigned long long>(
+		(percentile / 100.0f) * count + 0.5f);
+	if (target == 0)
+	{
+		target = 1;
+	}
+
+	unsigned long long accumulated = 0;
+	for (unsigned int i = 0; i < kBucketCount; ++i)
+	{
+		accumulated += mBuckets[i];
+		if (accumulated >= target)
+		{
+			//The bucket's upper bound may be larger than anything actually recorded.
+			const unsigned long long upperBound = getBucketUpperBound(i);
+			const unsigned long long max = mMax;
+			return upperBound < max ? upperBound : max;
+		}
+	}
+
+	return mMax;
+}
+
+void bsHistogram::writeJson(FILE* file) const
+{
+	fprintf(file, "{ \"count\": %llu, \"min\": %llu, \"max\": %llu, \"mean\": %.2f,"
+		" \"p50\": %llu, \"p95\": %llu, \"p99\": %llu }", getCount(), getMin(), getMax(),
+		getMean(), getPercentile(50.0f), getPercentile(95.0f), getPercentile(99.0f));
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdio.h>
+
+#include <tbb/atomic.h>
+
+
+/*	Histogram of unsigned integer values, for example durations in microseconds or sizes
+	in bytes.
+
+	Values are counted in logarithmic buckets, four per power of two, so percentiles are
+	accurate to within 25% of the actual value. Values below 4 are counted exactly.
+
+	Recording is lock-free and can be done from any number of threads at once. Reading
+	while other threads are recording gives approximate results.
+*/
+class bsHistogram
+{
+public:
+	bsHistogram();
+
+	void record(unsigned long long value);
+
+	//Sets all counts to zero. Not safe to call while other threads are recording.
+	void reset();
+
+	/*	Adds everything recorded in another histogram to this one, for example to combine
+		histograms covering different periods. Not safe to call while other threads are
+		recording into this histogram.
+	*/
+	void add(const bsHistogram& other);
+
+
+	inline unsigned long long getCount() const
+	{
+		return mCount;
+	}
+
+	inline unsigned long long getSum() const
+	{
+		return mSum;
+	}
+
+	//Returns 0 if nothing has been recorded.
+	inline unsigned long long getMin() const
+	{
+		return mCount ? static_cast<unsigned long long>(mMin) : 0;
+	}
+
+	inline unsigned long long getMax() const
+	{
+		return mMax;
+	}
+
+	inline double getMean() const
+	{
+		const unsigned long long count = mCount;
+		return count ? static_cast<double>(mSum) / count : 0.0;
+	}
+
+	/*	Returns an approximation of the value below which the given percentage of recorded
+		values are, for example 99.0f for the 99th percentile.
+		Returns 0 if nothing has been recorded.
+	*/
+	unsigned long long getPercentile(float percentile) const;
+
+	/*	Writes the histogram's summary as a JSON object, without a trailing newline.
+	*/
+	void writeJson(FILE* file) const;
+
+private:
+	static const unsigned int kBucketCount = 252;
+
+	static unsigned int getBucket(unsigned long long value);
+
+	//Returns the largest value which would be counted in the bucket.
+	static unsigned long long getBucketUpperBound(unsigned int bucket);
+
+	//Non-copyable.
+	bsHistogram(const bsHistogram&);
+	bsHistogram& operator=(const bsHistogram&);
+
+
+	tbb::atomic<unsigned int>	mBuckets[kBucketCount];
+
+	tbb::atomic<unsigned long long>	mCount;
+	tbb::atomic<unsigned long long>	mSum;
+	tbb::atomic<unsigned long long>	mMin;
+	tbb::atomic<unsigned long long>	mMax;
+};
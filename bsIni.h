@@ -1,23 +1,21 @@
 #pragma once
 
-#include <string>
-#include <unordered_map>
+#include <vector>
+
+#include "bsStringView.h"
 
 
 /*	A property is defined by a name and a value.
 	Appears as something like "pi=3.14" in an ini file.
+
+	The name and value refer to the buffer owned by the bsIniParser which parsed them, and
+	are both null terminated.
 */
 struct bsIniProperty
 {
 	bsIniProperty()
+		: nameHash(0)
 	{}
-	~bsIniProperty()
-	{}
-	bsIniProperty(bsIniProperty&& other)
-		: name(std::move(other.name))
-		, value(std::move(other.value))
-	{
-	}
 
 	/*	Returns true if this property is not invalid (contains no proper data).
 		A property is required to contain both a name and a value in order to be
@@ -27,7 +25,7 @@ struct bsIniProperty
 	{
 		return !name.empty() && !value.empty();
 	}
-	
+
 	/*	Converts this property's value as converted to the template argument type.
 		Returns true on successful conversions, false otherwise. If conversion is not
 		successful, result is undefined.
@@ -45,8 +43,11 @@ struct bsIniProperty
 	inline T getValue() const;
 
 
-	std::string name;
-	std::string value;
+	bsStringView name;
+	bsStringView value;
+
+	//name.hash(), used for lookups.
+	unsigned long long nameHash;
 };
 
 
@@ -57,14 +58,24 @@ class bsIniSection
 {
 public:
 	bsIniSection()
+		: mNameHash(mName.hash())
 	{}
-	~bsIniSection()
-	{}
+
 	bsIniSection(bsIniSection&& other)
-		: mName(std::move(other.mName))
+		: mName(other.mName)
+		, mNameHash(other.mNameHash)
 		, mProperties(std::move(other.mProperties))
 	{}
 
+	bsIniSection& operator=(bsIniSection&& other)
+	{
+		mName = other.mName;
+		mNameHash = other.mNameHash;
+		mProperties = std::move(other.mProperties);
+
+		return *this;
+	}
+
 	/*	True if this section contains no properties. Note that this means that sections
 		with no properties or only commented out properties will be considered empty
 	*/
@@ -77,48 +88,61 @@ public:
 	inline void clear()
 	{
 		mProperties.clear();
-		mName.clear();
+		mName = bsStringView();
+		mNameHash = mName.hash();
 	}
 
 	/*	Searches for a property with the given name.
-		Returns the property if found, or an empty property if not found
-		Use bsIniProperty::good() to see if the return value was found.
-
-		Possibly useful functions: stod, stof, stoi, stol, stold, stoll, stoul, stoull.
+		Returns the property if found, or null if not found.
 	*/
-	inline const bsIniProperty* getProperty(const std::string& propertyName) const;
+	inline const bsIniProperty* getProperty(const bsStringView& propertyName) const;
 
 	//Gets the name of this section.
-	inline const std::string& getName() const
+	inline const bsStringView& getName() const
 	{
 		return mName;
 	}
 
+	inline unsigned long long getNameHash() const
+	{
+		return mNameHash;
+	}
+
 	//Sets the name of this section.
-	inline void setName(const std::string& newName)
+	inline void setName(const bsStringView& newName)
 	{
 		mName = newName;
+		mNameHash = newName.hash();
 	}
 
-	//Returns internal set used to contain owned properties with read-only access.
-	inline const std::unordered_map<std::string, bsIniProperty>& getProperties() const
+	/*	Returns the properties contained in this section, sorted by name hash.
+	*/
+	inline const std::vector<bsIniProperty>& getProperties() const
 	{
 		return mProperties;
 	}
 
-	//Returns internal set used to contain owned properties with read/write access.
-	inline std::unordered_map<std::string, bsIniProperty>& getProperties()
+	/*	Adds a property. Properties must be sorted with sortProperties before searching
+		for them.
+	*/
+	inline void addProperty(const bsIniProperty& property)
 	{
-		return mProperties;
+		mProperties.push_back(property);
 	}
 
+	/*	Sorts properties by name hash. Properties with identical names keep the order
+		they were added in, and the first one will be found.
+	*/
+	inline void sortProperties();
+
 
 private:
 	//Name of this section.
-	std::string mName;
+	bsStringView		mName;
+	unsigned long long	mNameHash;
 
-	//Properties contained in this section.
-	std::unordered_map<std::string, bsIniProperty> mProperties;
+	//Properties contained in this section, sorted by name hash.
+	std::vector<bsIniProperty>	mProperties;
 };
 
 #include "bsIni.inl"
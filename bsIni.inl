@@ -1,29 +1,29 @@
 #include "bsIni.h"
 
 #include <algorithm>
+#include <assert.h>
+#include <errno.h>
+#include <float.h>
+#include <limits.h>
+#include <stdlib.h>
 #include <string>
 #include <sstream>
 
 
-/*	Tries to convert a string to a type with the provided conversion function,
-	catching any conversion failure exceptions.
+/*	Converts a null terminated string with a strto* style conversion function.
+	Like the std::sto* functions, leading whitespace and trailing characters are ignored,
+	but conversion fails if no characters could be converted or the result is out of range.
 	Returns true on successful conversion, false otherwise. If returning false, the value
 	of the output parameter is undefined.
 */
 template <typename T, typename ConversionFunction>
-inline bool tryConvertValue(const std::string& value, ConversionFunction func, T& output)
+inline bool tryConvertValue(const char* value, ConversionFunction func, T& output)
 {
-	T conversionResult;
+	char* end;
+	errno = 0;
+	const T conversionResult = func(value, &end);
 
-	try
-	{
-		conversionResult = func(value, nullptr);
-	}
-	catch (const std::invalid_argument&)
-	{
-		return false;
-	}
-	catch (const std::out_of_range&)
+	if (end == value || errno == ERANGE)
 	{
 		return false;
 	}
@@ -34,20 +34,14 @@ inline bool tryConvertValue(const std::string& value, ConversionFunction func, T
 
 //Same as above, but also supports specifying base for integer conversion.
 template <typename T, typename ConversionFunction>
-inline bool tryConvertValue(const std::string& value, ConversionFunction func, T& output,
+inline bool tryConvertValue(const char* value, ConversionFunction func, T& output,
 	int base)
 {
-	T conversionResult;
+	char* end;
+	errno = 0;
+	const T conversionResult = func(value, &end, base);
 
-	try
-	{
-		conversionResult = func(value, nullptr, base);
-	}
-	catch (const std::invalid_argument&)
-	{
-		return false;
-	}
-	catch (const std::out_of_range&)
+	if (end == value || errno == ERANGE)
 	{
 		return false;
 	}
@@ -60,17 +54,13 @@ inline bool tryConvertValue(const std::string& value, ConversionFunction func, T
 template <>
 inline bool bsIniProperty::tryGetValue(bool& result) const
 {
-	//Convert the value to lower case for easier comparison.
-	std::string lowerCaseValue(value);
-	std::transform(lowerCaseValue.begin(), lowerCaseValue.end(),
-		lowerCaseValue.begin(), tolower);
-
-	if (lowerCaseValue == "true" || lowerCaseValue == "1")
+	//Case insensitive comparison, the value is null terminated.
+	if (_stricmp(value.data(), "true") == 0 || _stricmp(value.data(), "1") == 0)
 	{
 		result = true;
 		return true;
 	}
-	else if (lowerCaseValue == "false" || lowerCaseValue == "0")
+	else if (_stricmp(value.data(), "false") == 0 || _stricmp(value.data(), "0") == 0)
 	{
 		result = false;
 		return true;
@@ -82,79 +72,101 @@ inline bool bsIniProperty::tryGetValue(bool& result) const
 }
 
 /*	Template specialization for float.
-	The following number specializations use the tryConvertValue function with standard
-	library conversion functions.
+	The following number specializations use the tryConvertValue function with C
+	library conversion functions, which work directly on the parsed buffer.
 */
 template <>
 inline bool bsIniProperty::tryGetValue(float& result) const
 {
-	//stof is overloaded with std::string and std::wstring functions, need to specify
-	//which version to call.
-	return tryConvertValue(value,
-		(float (*)(const std::string&, size_t*))std::stof, result);
+	double conversionResult;
+	if (!tryConvertValue(value.data(), strtod, conversionResult)
+		|| conversionResult > FLT_MAX || conversionResult < -FLT_MAX)
+	{
+		return false;
+	}
+
+	result = static_cast<float>(conversionResult);
+	return true;
 }
 
 //Template specialization for double.
 template <>
 inline bool bsIniProperty::tryGetValue(double& result) const
 {
-	return tryConvertValue(value,
-		(double (*)(const std::string&, size_t*))std::stod, result);
+	return tryConvertValue(value.data(), strtod, result);
 }
 
 //Template specialization for long double.
 template <>
 inline bool bsIniProperty::tryGetValue(long double& result) const
 {
-	return tryConvertValue(value,
-		(long double (*)(const std::string&, size_t*))std::stold, result);
+	//long double is the same as double with MSVC.
+	double conversionResult;
+	if (!tryConvertValue(value.data(), strtod, conversionResult))
+	{
+		return false;
+	}
+
+	result = conversionResult;
+	return true;
 }
 
 //Template specialization for int.
 template <>
 inline bool bsIniProperty::tryGetValue(int& result) const
 {
-	return tryConvertValue(value,
-		(int (*)(const std::string&, size_t*, int))std::stoi, result, 10);
+	long conversionResult;
+	if (!tryConvertValue(value.data(), strtol, conversionResult, 10)
+		|| conversionResult > INT_MAX || conversionResult < INT_MIN)
+	{
+		return false;
+	}
+
+	result = static_cast<int>(conversionResult);
+	return true;
 }
 
 //Template specialization for long.
 template <>
 inline bool bsIniProperty::tryGetValue(long& result) const
 {
-	return tryConvertValue(value,
-		(long (*)(const std::string&, size_t*, int))std::stol, result, 10);
+	return tryConvertValue(value.data(), strtol, result, 10);
 }
 
 //Template specialization for long long.
 template <>
 inline bool bsIniProperty::tryGetValue(long long& result) const
 {
-	return tryConvertValue(value,
-		(long long (*)(const std::string&, size_t*, int))std::stoll, result, 10);
+	return tryConvertValue(value.data(), _strtoi64, result, 10);
 }
 
 //Template specialization for unsigned long.
 template <>
 inline bool bsIniProperty::tryGetValue(unsigned long& result) const
 {
-	return tryConvertValue(value,
-		(unsigned long (*)(const std::string&, size_t*, int))std::stoul, result, 10);
+	return tryConvertValue(value.data(), strtoul, result, 10);
 }
 
 //Template specialization for unsigned long long.
 template <>
 inline bool bsIniProperty::tryGetValue(unsigned long long& result) const
 {
-	return tryConvertValue(value,
-		(unsigned long long (*)(const std::string&, size_t*, int))std::stoull, result, 10);
+	return tryConvertValue(value.data(), _strtoui64, result, 10);
+}
+
+//Template specialization for std::string, copies the value.
+template <>
+inline bool bsIniProperty::tryGetValue(std::string& result) const
+{
+	result = value.toString();
+	return true;
 }
 
 //Unknown type, use a stringstream.
 template <typename T>
 inline bool bsIniProperty::tryGetValue(T& result) const
 {
-	std::stringstream ss(value);
+	std::stringstream ss(value.toString());
 	T temp;
 	ss >> temp;
 	result = temp;
@@ -173,16 +185,35 @@ T bsIniProperty::getValue() const
 	return conversionResult;
 }
 
-const bsIniProperty* bsIniSection::getProperty(const std::string& propertyName) const
+const bsIniProperty* bsIniSection::getProperty(const bsStringView& propertyName) const
 {
-	//Make a dummy property to search for it.
-	auto findResult = mProperties.find(propertyName);
+	const unsigned long long nameHash = propertyName.hash();
+
+	auto itr = std::lower_bound(mProperties.cbegin(), mProperties.cend(), nameHash,
+		[](const bsIniProperty& property, unsigned long long hash)
+	{
+		return property.nameHash < hash;
+	});
 
-	if (findResult == mProperties.end())
+	//Several names may share a hash, compare the names to find the right one.
+	for (; itr != mProperties.cend() && itr->nameHash == nameHash; ++itr)
 	{
-		//Not found.
-		return nullptr;
+		if (itr->name == propertyName)
+		{
+			return &*itr;
+		}
 	}
 
-	return &findResult->second;
-}
\ No newline at end of file
+	//Not found.
+	return nullptr;
+}
+
+void bsIniSection::sortProperties()
+{
+	//Stable, so the first of several identically named properties is found.
+	std::stable_sort(mProperties.begin(), mProperties.end(),
+		[](const bsIniProperty& a, const bsIniProperty& b)
+	{
+		return a.nameHash < b.nameHash;
+	});
+}
@@ -2,11 +2,20 @@
 
 #include "bsIniParser.h"
 
-#include <sstream>
+#include <string.h>
 
 #include "bsAssert.h"
 
 
+namespace
+{
+inline bool isWhitespace(char c)
+{
+	return c == ' ' || c == '\t';
+}
+}
+
+
 void bsIniParser::parseData(const char* data, size_t dataSizeBytes)
 {
 	BS_ASSERT(data);
@@ -14,184 +23,168 @@ void bsIniParser::parseData(const char* data, size_t dataSizeBytes)
 
 	//Don't want old data from previous parses mixed in with this parse.
 	mSections.clear();
+	mSectionIndices.clear();
 
-	//Assume line length, save some reallocation, possibly waste some space
-	std::vector<std::string> lines;
-	lines.reserve(dataSizeBytes / 30);
+	//Copy the data once, everything parsed will refer to this buffer. The extra byte
+	//null terminates the last line.
+	mBuffer.reserve(dataSizeBytes + 1);
+	mBuffer.assign(data, data + dataSizeBytes);
+	mBuffer.push_back('\0');
 
-	//Split into individual lines.
-	std::stringstream ss(std::move(std::string(data, data + dataSizeBytes)));
-	std::string line;
-	while (std::getline(ss, line))
-	{
-		lines.push_back(line);
-	}
-
-	parseLines(lines);
-}
-
-inline bool bsIniParser::isBadLine(const std::string& line) const
-{
-	//False if line is empty or if it starts with comment or whitespace.
-	if (line.empty())
-	{
-		return true;
-	}
-	const char first = line[0];
-	return first == ';' || first == ' ' || first == '\t';
-}
+	//Properties before the first section go in an unnamed section.
+	mSections.push_back(bsIniSection());
 
-void bsIniParser::parseLines(const std::vector<std::string>& lines)
-{
-	//The section which properties are currently being written to.
-	bsIniSection currentSection;
+	char* current = &mBuffer[0];
+	char* const end = current + dataSizeBytes;
 
-	for (size_t i = 0, count = lines.size(); i < count; ++i)
+	//Split into individual lines.
+	while (current < end)
 	{
-		const std::string& currentLine = lines[i];
-
-		if (isBadLine(currentLine))
+		char* lineEnd = static_cast<char*>(memchr(current, '\n', end - current));
+		if (!lineEnd)
 		{
-			continue;
+			lineEnd = end;
 		}
+		char* nextLine = lineEnd + 1;
 
-		if (currentLine[0] == '[')
+		//Ignore the carriage return of \r\n line endings.
+		if (lineEnd > current && lineEnd[-1] == '\r')
 		{
-			//Start of new section.
-
-			//bsIniSection name ("[something]")
-			std::string newSectionName(std::move(parseSectionStart(currentLine)));
-
-			if (!newSectionName.empty())
-			{
-				if (!currentSection.empty())
-				{
-					//Insert previous section
-					
-					//Duplicate section names is not supported.
-					//assert(mSections.find(currentSection.getName()) == mSections.end()
-					//	&& "Duplicate section names found!");
-
-					mSections.insert(std::move(std::make_pair<std::string, bsIniSection>
-						(currentSection.getName(), currentSection)));
-					currentSection.clear();
-				}
-
-				currentSection.clear();
-				currentSection.setName(newSectionName);
-			}
-		}
-		else
-		{
-			//Normal prop line ("x=y")
-
-			bsIniProperty prop = parseProperty(currentLine);
-			if (prop.good())
-			{
-				//Duplicate property names is not supported.
-				//assert(currentSection.getProperties().find(prop.name) ==
-				//	currentSection.getProperties().end()
-				//	&& "Duplicate property names found!");
-
-				currentSection.getProperties().insert(std::move(
-					std::make_pair<std::string, bsIniProperty>(prop.name, prop)));
-			}
+			--lineEnd;
 		}
+		*lineEnd = '\0';
+
+		parseLine(current, lineEnd);
+
+		current = nextLine;
 	}
 
-	/*	Check if anything has been parsed at all, and if so, insert the parsed section.
-		This will also insert the last parsed section, as a section is normally only
-		inserted when a new section starts.
-	*/
-	if (!currentSection.empty())
+	//A section is only kept if it contains properties.
+	if (mSections.back().empty())
 	{
-		//Duplicate section names is not supported.
-		//assert(mSections.find(currentSection.getName()) == mSections.end()
-		//	&& "Duplicate section names found!");
+		mSections.pop_back();
+	}
+
+	mSectionIndices.reserve(mSections.size());
+	for (unsigned int i = 0; i < mSections.size(); ++i)
+	{
+		mSections[i].sortProperties();
 
-		mSections.insert(std::move(std::make_pair<std::string, bsIniSection>
-			(currentSection.getName(), currentSection)));
+		//Insert does not replace, so the first of several identically named sections is
+		//found.
+		mSectionIndices.insert(std::make_pair(mSections[i].getName(), i));
 	}
 }
 
-std::string bsIniParser::parseSectionStart(const std::string& line)
+void bsIniParser::parseLine(char* line, char* lineEnd)
 {
-	//Get index of end bracket, then get substring between the two.
-	//"[xyz]" becomes "xyz".
-	
-	const size_t endBracketIndex = line.find_first_of(']', 1);
-	if (endBracketIndex != std::string::npos)
+	//Skip lines which are empty or start with comment or whitespace.
+	if (line == lineEnd || *line == ';' || isWhitespace(*line))
 	{
-		return(line.substr(1, endBracketIndex - 1));
+		return;
+	}
+
+	if (*line == '[')
+	{
+		//Start of new section.
+		parseSectionStart(line, lineEnd);
 	}
 	else
 	{
-		return std::string();
+		//Normal prop line ("x=y")
+		parseProperty(line, lineEnd);
 	}
 }
 
-bsIniProperty bsIniParser::parseProperty(const std::string& line)
+void bsIniParser::parseSectionStart(char* line, char* lineEnd)
 {
-	const size_t findIndex = line.find_first_of('=');
-	if (findIndex != std::string::npos)
+	//Get index of end bracket, then get substring between the two.
+	//"[xyz]" becomes "xyz".
+	char* endBracket = static_cast<char*>(memchr(line + 1, ']', lineEnd - (line + 1)));
+	if (!endBracket || endBracket == line + 1)
 	{
-		//Insert the string into a property so that name = "x" and value = "y"
-		//for the line "x=y".
-		bsIniProperty prop;
-		prop.name = line.substr(0, findIndex);
-		prop.value = line.substr(findIndex + 1);
+		//Missing end bracket or empty name, keep adding to the current section.
+		return;
+	}
 
+	*endBracket = '\0';
+	const bsStringView sectionName(line + 1, endBracket - (line + 1));
 
-		//Trim whitespace.
+	if (!mSections.back().empty())
+	{
+		mSections.push_back(bsIniSection());
+	}
 
-		//Trim end for name. If there was whitespace before the name, this function
-		//wouldn't have been called
-		while (!prop.name.empty() && prop.name.back() == ' ' || prop.name.back() == '\t')
-		{
-			prop.name.pop_back();
-		}
+	//The current section has no properties, so it's simply renamed.
+	mSections.back().setName(sectionName);
+}
 
-		//Trim end for value.
-		while (!prop.value.empty() && (prop.value.back() == ' ' || prop.value.back() == '\t'))
-		{
-			prop.value.pop_back();
-		}
-		//Get index of first non-whitespace char.
-		const size_t firstAfterWhitespaceIndex = prop.value.find_first_not_of(" \t");
-		if (firstAfterWhitespaceIndex != 0 && firstAfterWhitespaceIndex != std::string::npos)
-		{
-			//First non-whitespace char was not first char, trim beginning.
-			prop.value.erase(prop.value.begin(), prop.value.begin() + firstAfterWhitespaceIndex);
-		}
+void bsIniParser::parseProperty(char* line, char* lineEnd)
+{
+	char* equals = static_cast<char*>(memchr(line, '=', lineEnd - line));
+	if (!equals)
+	{
+		//No '=' found, invalid property.
+		return;
+	}
 
-		return prop;
+	//Trim end for name. If there was whitespace before the name, this function
+	//wouldn't have been called
+	char* nameEnd = equals;
+	while (nameEnd > line && isWhitespace(nameEnd[-1]))
+	{
+		--nameEnd;
 	}
-	else
+
+	//Trim beginning and end for value.
+	char* valueBegin = equals + 1;
+	while (valueBegin < lineEnd && isWhitespace(*valueBegin))
 	{
-		//No '=' found, invalid property.
-		return bsIniProperty();
+		++valueBegin;
+	}
+	char* valueEnd = lineEnd;
+	while (valueEnd > valueBegin && isWhitespace(valueEnd[-1]))
+	{
+		--valueEnd;
+	}
+
+	if (nameEnd == line || valueEnd == valueBegin)
+	{
+		//A property needs both a name and a value.
+		return;
 	}
+
+	//Null terminate both in place, making conversion to numbers possible without copying.
+	*nameEnd = '\0';
+	*valueEnd = '\0';
+
+	bsIniProperty prop;
+	prop.name = bsStringView(line, nameEnd - line);
+	prop.value = bsStringView(valueBegin, valueEnd - valueBegin);
+	prop.nameHash = prop.name.hash();
+
+	mSections.back().addProperty(prop);
 }
 
-const bsIniSection* bsIniParser::getSection(const std::string& sectionName) const
+const bsIniSection* bsIniParser::getSection(const bsStringView& sectionName) const
 {
-	const auto findResult = mSections.find(sectionName);
-	if (findResult != mSections.end())
+	auto itr = mSectionIndices.find(sectionName);
+	if (itr != mSectionIndices.end())
 	{
 		//Found it, return its address.
-		return &findResult->second;
+		return &mSections[itr->second];
 	}
 
 	//Didn't find it.
 	return nullptr;
 }
 
-const bsIniProperty* bsIniParser::getProperty(const std::string& propertyName) const
+const bsIniProperty* bsIniParser::getProperty(const bsStringView& propertyName) const
 {
 	//Iterate through all sections until we find one which contains the requested property.
 	for (auto itr = mSections.cbegin(), end = mSections.cend(); itr != end; ++itr)
 	{
-		const bsIniProperty* findResult = itr->second.getProperty(propertyName);
+		const bsIniProperty* findResult = itr->getProperty(propertyName);
 		if (findResult != nullptr)
 		{
 			return findResult;
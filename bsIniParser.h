@@ -1,10 +1,10 @@
 #pragma once
 
-#include <string>
 #include <vector>
-#include <unordered_map>
 
+#include "bsFlatHashMap.h"
 #include "bsIni.h"
+#include "bsStringView.h"
 
 
 /*	Parser for ini files.
@@ -15,6 +15,11 @@
 	Comments must start at the first character of a line, and continues until the end
 	of that line.
 	Whitespace is allowed anywhere. Lines starting with whitespace are ignored.
+	Both \n and \r\n line endings are supported.
+
+	The parsed data is copied once into a buffer owned by the parser, and tokenized in
+	place. Sections and properties refer to this buffer, so they are only valid until the
+	parser is destroyed or parses new data.
 
 
 	Example ini file contents (ignore the first tab of each line):
@@ -36,9 +41,6 @@ public:
 	bsIniParser()
 	{}
 
-	~bsIniParser()
-	{}
-
 	/*	Parses raw text as an ini file.
 		Use the below get functions to retrieve information parsed after calling this
 		function.
@@ -57,7 +59,7 @@ public:
 		results in undefined behavior.
 	*/
 
-	const bsIniSection* getSection(const std::string& sectionName) const;
+	const bsIniSection* getSection(const bsStringView& sectionName) const;
 
 
 	/*	Gets the specified property from an undefined section.
@@ -68,23 +70,41 @@ public:
 
 		If the property was not found, null is returned.
 	*/
-	const bsIniProperty* getProperty(const std::string& propertyName) const;
+	const bsIniProperty* getProperty(const bsStringView& propertyName) const;
 
+	/*	Returns all sections, in the order they appear in the parsed data.
+	*/
+	inline const std::vector<bsIniSection>& getSections() const
+	{
+		return mSections;
+	}
 
-private:
-	//Returns true for lines which should not be parsed (malformed or commented out most likely).
-	inline bool isBadLine(const std::string& line) const;
 
-	//Iterates through input lines and puts valid lines into their respective sections.
-	void parseLines(const std::vector<std::string>& lines);
+private:
+	/*	Parses a single line in place. lineEnd points to the end of the line, which has
+		been replaced by a null terminator.
+	*/
+	void parseLine(char* line, char* lineEnd);
 
 	//Parse line starting with '['
-	std::string parseSectionStart(const std::string& line);
+	void parseSectionStart(char* line, char* lineEnd);
 
 	//Parse normal line, should contain x=y
-	bsIniProperty parseProperty(const std::string& line);
+	void parseProperty(char* line, char* lineEnd);
+
+	//Non-copyable, the parsed sections point into mBuffer.
+	bsIniParser(const bsIniParser&);
+	bsIniParser& operator=(const bsIniParser&);
+
 
+	//Copy of the parsed data, tokenized in place.
+	std::vector<char>	mBuffer;
+
+	/*	The sections contained in a loaded ini file. The last section is the one currently
+		being parsed into while parsing.
+	*/
+	std::vector<bsIniSection>	mSections;
 
-	//The sections contained in a loaded ini file.
-	std::unordered_map<std::string, bsIniSection>	mSections;
+	//Maps section names to indices in mSections. Built after parsing has finished.
+	bsFlatHashMap<bsStringView, unsigned int, bsStringView::Hasher>	mSectionIndices;
 };
@@ -0,0 +1,174 @@
+#include "StdAfx.h"
+
+#include "bsInputRecording.h"
+
+#include <string.h>
+
+#include "bsLog.h"
+#include "bsAssert.h"
+
+
+bsInputRecorder::bsInputRecorder()
+	: mFile(nullptr)
+	, mFrameCount(0)
+{
+}
+
+bsInputRecorder::~bsInputRecorder()
+{
+	if (mFile != nullptr)
+	{
+		fclose(mFile);
+
+		BS_LOG_INFO(IO, "Recorded input of %u frames", mFrameCount);
+	}
+}
+
+bool bsInputRecorder::open(const std::string& fileName, unsigned int randomSeed)
+{
+	BS_ASSERT2(mFile == nullptr, "Input recorder is already recording");
+
+#pragma warning (disable : 4996)//warning C4996: 'fopen' was declared deprecated
+	mFile = fopen(fileName.c_str(), "wb");
+#pragma warning (default : 4996)
+	if (mFile == nullptr)
+	{
+		BS_LOG_ERROR(IO, "Failed to open '%s' for recording input", fileName.c_str());
+
+		return false;
+	}
+
+	bsInputRecordingHeader header;
+	memcpy(header.magic, "bsir", 4);
+	header.version = kInputRecordingVersion;
+	header.randomSeed = randomSeed;
+	header.unused = 0;
+
+	if (fwrite(&header, sizeof(header), 1, mFile) != 1)
+	{
+		BS_LOG_ERROR(IO, "Failed to write input recording '%s'", fileName.c_str());
+
+		fclose(mFile);
+		mFile = nullptr;
+
+		return false;
+	}
+
+	mFrameEvents.reserve(64);
+
+	return true;
+}
+
+void bsInputRecorder::endFrame(float deltaTimeMs)
+{
+	BS_ASSERT2(mFile != nullptr, "Input recorder has not been opened");
+
+	bsInputFrameHeader frameHeader;
+	frameHeader.deltaTimeMs = deltaTimeMs;
+	frameHeader.eventCount = mFrameEvents.size();
+
+	fwrite(&frameHeader, sizeof(frameHeader), 1, mFile);
+	if (!mFrameEvents.empty())
+	{
+		fwrite(mFrameEvents.data(), sizeof(bsInputEvent) * mFrameEvents.size(), 1, mFile);
+	}
+
+	mFrameEvents.clear();
+	++mFrameCount;
+}
+
+
+bsInputPlayback::bsInputPlayback()
+	: mCurrentFrame(0)
+	, mRandomSeed(0)
+{
+}
+
+bool bsInputPlayback::load(const std::string& fileName)
+{
+	mFrames.clear();
+	mEvents.clear();
+	mCurrentFrame = 0;
+	mRandomSeed = 0;
+
+#pragma warning (disable : 4996)//warning C4996: 'fopen' was declared deprecated
+	FILE* file = fopen(fileName.c_str(), "rb");
+#pragma warning (default : 4996)
+	if (file == nullptr)
+	{
+		BS_LOG_ERROR(IO, "Failed to open input recording '%s'", fileName.c_str());
+
+		return false;
+	}
+
+	bsInputRecordingHeader header;
+	if (fread(&header, sizeof(header), 1, file) != 1
+		|| memcmp(header.magic, "bsir", 4) != 0
+		|| header.version != kInputRecordingVersion)
+	{
+		fclose(file);
+
+		BS_LOG_ERROR(IO, "'%s' is not an input recording of version %u",
+			fileName.c_str(), kInputRecordingVersion);
+
+		return false;
+	}
+
+	bool truncated = false;
+
+	bsInputFrameHeader frameHeader;
+	while (fread(&frameHeader, sizeof(frameHeader), 1, file) == 1)
+	{
+		Frame frame;
+		frame.deltaTimeMs = frameHeader.deltaTimeMs;
+		frame.firstEvent = mEvents.size();
+		frame.eventCount = frameHeader.eventCount;
+
+		if (frame.eventCount != 0)
+		{
+			mEvents.resize(frame.firstEvent + frame.eventCount);
+			if (fread(&mEvents[frame.firstEvent], sizeof(bsInputEvent) * frame.eventCount,
+				1, file) != 1)
+			{
+				truncated = true;
+				break;
+			}
+		}
+
+		mFrames.push_back(frame);
+	}
+
+	truncated |= ferror(file) != 0;
+	fclose(file);
+
+	if (truncated)
+	{
+		BS_LOG_ERROR(IO, "Input recording '%s' is truncated", fileName.c_str());
+
+		mFrames.clear();
+		mEvents.clear();
+
+		return false;
+	}
+
+	mRandomSeed = header.randomSeed;
+	//Rewound to before the first frame, so the first nextFrame lands on frame 0.
+	mCurrentFrame = static_cast<unsigned int>(-1);
+
+	BS_LOG_INFO(IO, "Loaded input recording '%s' with %u frames", fileName.c_str(),
+		getFrameCount());
+
+	return true;
+}
+
+bool bsInputPlayback::nextFrame()
+{
+	if (mCurrentFrame == getFrameCount())
+	{
+		return false;
+	}
+
+	++mCurrentFrame;
+
+	return mCurrentFrame < getFrameCount();
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+
+
+/*	Input recording layout, all values are little endian:
+
+Byte		Description
+1-4			File format identification, "bsir" (chars).
+5-8			Version information (uint).
+9-12		Seed for the random number generators of the recorded session (uint).
+13-16		Unused.
+
+17-...		Frames, until the end of the file. Every frame is a bsInputFrameHeader,
+				followed by bsInputEvent * event count (defined in the frame header).
+
+Frames are appended while recording, so there is no frame count in the header.
+*/
+
+/*	Version info is stored in the header, and must be equal to this value when loaded.
+
+	Version history:
+	0: Initial version.
+*/
+const unsigned int kInputRecordingVersion = 0;
+
+
+#pragma pack(push, 1)
+struct bsInputRecordingHeader
+{
+	char			magic[4];
+	unsigned int	version;
+	unsigned int	randomSeed;
+	unsigned int	unused;
+};
+
+struct bsInputFrameHeader
+{
+	//Time the frame advanced the simulation by.
+	float			deltaTimeMs;
+	unsigned int	eventCount;
+};
+
+/*	A single keyboard or mouse event.
+	Key and button values are those of the input library (OIS), this file does not
+	interpret them.
+*/
+struct bsInputEvent
+{
+	enum Type
+	{
+		KEY_PRESSED,
+		KEY_RELEASED,
+		MOUSE_MOVED,
+		MOUSE_PRESSED,
+		MOUSE_RELEASED
+	};
+
+	unsigned char	type;
+	//Mouse button for MOUSE_PRESSED and MOUSE_RELEASED.
+	unsigned char	button;
+	//Key code for KEY_PRESSED and KEY_RELEASED.
+	unsigned short	key;
+
+	//Mouse state when the event happened, 0 for key events.
+	int				absX, absY, absZ;
+	int				relX, relY, relZ;
+	int				buttons;
+};
+#pragma pack(pop)
+
+
+/*	Writes every input event of every frame, and the time each frame advanced by, to a
+	file. Replaying the file with bsInputPlayback drives the same session again, so performance
+	runs of different builds can use identical simulation and camera paths.
+*/
+class bsInputRecorder
+{
+public:
+	bsInputRecorder();
+
+	~bsInputRecorder();
+
+	/*	Creates the file, replacing any existing file with the same name.
+		randomSeed should seed everything random in the session, so that playback can
+		repeat it.
+	*/
+	bool open(const std::string& fileName, unsigned int randomSeed);
+
+	//Adds an event to the current frame.
+	inline void addEvent(const bsInputEvent& inputEvent)
+	{
+		mFrameEvents.push_back(inputEvent);
+	}
+
+	/*	Writes the current frame with the events added since the previous call and starts
+		the next frame.
+	*/
+	void endFrame(float deltaTimeMs);
+
+	inline unsigned int getFrameCount() const
+	{
+		return mFrameCount;
+	}
+
+private:
+	//Non-copyable.
+	bsInputRecorder(const bsInputRecorder&);
+	bsInputRecorder& operator=(const bsInputRecorder&);
+
+
+	FILE*	mFile;
+	std::vector<bsInputEvent>	mFrameEvents;
+	unsigned int	mFrameCount;
+};
+
+
+/*	Replays a file written by bsInputRecorder one frame at a time.
+	The whole file is read on load, so playback does no file IO.
+*/
+class bsInputPlayback
+{
+public:
+	bsInputPlayback();
+
+	/*	Loads a recording, replacing the one loaded before, and rewinds to before the
+		first frame.
+		Returns false and leaves the playback empty if the file is missing, truncated or
+		from a different version.
+	*/
+	bool load(const std::string& fileName);
+
+	/*	Advances to the next frame.
+		Returns false once every frame has been played back.
+	*/
+	bool nextFrame();
+
+	//Delta time of the current frame.
+	inline float getDeltaTime() const
+	{
+		return mFrames[mCurrentFrame].deltaTimeMs;
+	}
+
+	//Events of the current frame, in the order they were recorded.
+	inline const bsInputEvent* getEvents() const
+	{
+		return mEvents.data() + mFrames[mCurrentFrame].firstEvent;
+	}
+
+	inline unsigned int getEventCount() const
+	{
+		return mFrames[mCurrentFrame].eventCount;
+	}
+
+	//Index of the current frame, equal to the frame count once playback has finished.
+	inline unsigned int getCurrentFrame() const
+	{
+		return mCurrentFrame;
+	}
+
+	inline unsigned int getFrameCount() const
+	{
+		return mFrames.size();
+	}
+
+	inline unsigned int getRandomSeed() const
+	{
+		return mRandomSeed;
+	}
+
+private:
+	struct Frame
+	{
+		float			deltaTimeMs;
+		unsigned int	firstEvent;
+		unsigned int	eventCount;
+	};
+
+	std::vector<Frame>			mFrames;
+	std::vector<bsInputEvent>	mEvents;
+
+	unsigned int	mCurrentFrame;
+	unsigned int	mRandomSeed;
+};
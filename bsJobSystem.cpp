@@ -0,0 +1,519 @@
+#include "StdAfx.h"
+
+#include "bsJobSystem.h"
+
+#include <stdio.h>
+
+#include <functional>
+
+#include <intrin.h>
+
+#include "bsWindowsUtils.h"
+#include "bsThreadPlacement.h"
+#include "bsProfiler.h"
+
+
+namespace
+{
+//Index of the calling thread in gThreadJobSystem.
+__declspec(thread) unsigned int gThreadIndex = bsJobSystem::kNotAJobThread;
+__declspec(thread) const bsJobSystem* gThreadJobSystem = nullptr;
+
+/*	Attempts to find work before a thread gives up its time slice, and before an idle
+	worker goes to sleep. Yielding keeps spinning threads from starving the ones running
+	jobs when there are more threads than cores.
+*/
+const unsigned int kSpinCountBeforeYield = 64;
+const unsigned int kSpinCountBeforeSleep = 256;
+
+const long long kDequeMask = bsJobSystem::kMaxJobsPerThread - 1;
+
+
+//Xorshift, only used to spread steal attempts over the other threads.
+inline unsigned int nextRandom(unsigned int& state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+
+	return state;
+}
+}
+
+
+bsJobSystem::Deque::Deque()
+{
+	mTop = 0;
+	mBottom = 0;
+}
+
+bool bsJobSystem::Deque::push(bsJob* job)
+{
+	const long long bottom = mBottom;
+	//Thieves only increase the top, so a stale top can only make the deque look fuller.
+	if (bottom - mTop >= static_cast<long long>(kMaxJobsPerThread))
+	{
+		return false;
+	}
+
+	mJobs[bottom & kDequeMask] = job;
+	//Release store, the job is written before thieves can see it.
+	mBottom = bottom + 1;
+
+	return true;
+}
+
+bsJob* bsJobSystem::Deque::pop()
+{
+	const long long bottom = mBottom - 1;
+	//Full fence, the top must be read after the bottom is reserved.
+	mBottom.fetch_and_store(bottom);
+	const long long top = mTop;
+
+	if (top > bottom)
+	{
+		//Empty.
+		mBottom = top;
+		return nullptr;
+	}
+
+	bsJob* job = mJobs[bottom & kDequeMask];
+	if (top == bottom)
+	{
+		//Last job, race thieves for it.
+		if (mTop.compare_and_swap(top + 1, top) != top)
+		{
+			job = nullptr;
+		}
+		mBottom = top + 1;
+	}
+
+	return job;
+}
+
+bsJob* bsJobSystem::Deque::steal()
+{
+	const long long top = mTop;
+	const long long bottom = mBottom;
+
+	if (top >= bottom)
+	{
+		return nullptr;
+	}
+
+	bsJob* job = mJobs[top & kDequeMask];
+	if (mTop.compare_and_swap(top + 1, top) != top)
+	{
+		//Lost to the owner or another thief.
+		return nullptr;
+	}
+
+	return job;
+}
+
+bool bsJobSystem::Deque::isEmpty() const
+{
+	return mTop >= mBottom;
+}
+
+
+bsJobSystem::bsJobSystem(unsigned int workerThreadCount,
+	const bsThreadPlacement* threadPlacement)
+	: mThreadCount(workerThreadCount + 1)
+	, mNextSharedJob(0)
+{
+	BS_ASSERT2(gThreadJobSystem == nullptr, "The calling thread already belongs to a job"
+		" system");
+
+	mSharedQueueSize = 0;
+	mSleepingWorkers = 0;
+	mQuit = false;
+
+	mThreadData = new ThreadData[mThreadCount];
+	for (unsigned int i = 0; i < mThreadCount; ++i)
+	{
+		ThreadData& threadData = mThreadData[i];
+		threadData.nextJob = 0;
+		threadData.random = 2463534242u + i * 7919u;
+
+		for (unsigned int j = 0; j < kMaxJobsPerThread; ++j)
+		{
+			threadData.jobs[j].function = nullptr;
+		}
+	}
+	for (unsigned int i = 0; i < kMaxJobsPerThread; ++i)
+	{
+		mSharedJobs[i].function = nullptr;
+	}
+
+	mWakeSemaphore = CreateSemaphore(nullptr, 0, LONG_MAX, nullptr);
+	BS_ASSERT2(mWakeSemaphore != nullptr, "Failed to create job system semaphore");
+
+	gThreadIndex = 0;
+	gThreadJobSystem = this;
+
+	mWorkers.reserve(workerThreadCount);
+	for (unsigned int i = 1; i < mThreadCount; ++i)
+	{
+		mWorkers.push_back(new tbb::tbb_thread(std::bind(&bsJobSystem::workerLoop, this,
+			i)));
+
+		if (threadPlacement != nullptr)
+		{
+			threadPlacement->apply(mWorkers.back()->native_handle(),
+				bsThreadPlacement::ROLE_JOB_WORKER, i);
+		}
+	}
+}
+
+bsJobSystem::~bsJobSystem()
+{
+	BS_ASSERT2(gThreadJobSystem == this && gThreadIndex == 0, "Job system must be"
+		" destroyed by the thread which created it");
+	BS_ASSERT2(!hasQueuedJobs(), "Job system destroyed with queued jobs");
+
+	mQuit = true;
+	if (!mWorkers.empty())
+	{
+		ReleaseSemaphore(mWakeSemaphore, mWorkers.size(), nullptr);
+	}
+
+	for (size_t i = 0; i < mWorkers.size(); ++i)
+	{
+		mWorkers[i]->join();
+		delete mWorkers[i];
+	}
+
+	CloseHandle(mWakeSemaphore);
+	delete[] mThreadData;
+
+	gThreadIndex = kNotAJobThread;
+	gThreadJobSystem = nullptr;
+}
+
+void bsJobSystem::run(bsJobFunction function, void* data, unsigned int begin,
+	unsigned int end, bsJobCounter& counter, bsJobCounter* dependency)
+{
+	BS_ASSERT(function != nullptr);
+
+	const unsigned int threadIndex = getThreadIndex();
+
+	counter.mPending += 1;
+
+	bsJob* job = allocateJob(threadIndex);
+	job->data = data;
+	job->begin = begin;
+	job->end = end;
+	job->counter = &counter;
+	job->nextContinuation = nullptr;
+	//Written last, marks the job as in use.
+	job->function = function;
+
+	schedule(job, dependency, threadIndex);
+}
+
+void bsJobSystem::runRange(bsJobFunction function, void* data, unsigned int count,
+	unsigned int grainSize, bsJobCounter& counter, bsJobCounter* dependency)
+{
+	BS_ASSERT(function != nullptr);
+	BS_ASSERT2(grainSize != 0, "Grain size must be at least 1");
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	const unsigned int threadIndex = getThreadIndex();
+	const unsigned int jobCount = (count + grainSize - 1) / grainSize;
+
+	//Counted up front, so the counter can't reach zero while jobs are being created.
+	counter.mPending += jobCount;
+
+	for (unsigned int begin = 0; begin < count; begin += grainSize)
+	{
+		bsJob* job = allocateJob(threadIndex);
+		job->data = data;
+		job->begin = begin;
+		job->end = count - begin > grainSize ? begin + grainSize : count;
+		job->counter = &counter;
+		job->nextContinuation = nullptr;
+		job->function = function;
+
+		schedule(job, dependency, threadIndex);
+	}
+}
+
+void bsJobSystem::wait(bsJobCounter& counter)
+{
+	const unsigned int threadIndex = getThreadIndex();
+	unsigned int failedAttempts = 0;
+
+	while (!counter.isDone())
+	{
+		bsJob* job = findJob(threadIndex);
+		if (job != nullptr)
+		{
+			execute(*job, threadIndex);
+			failedAttempts = 0;
+		}
+		else if (++failedAttempts < kSpinCountBeforeYield)
+		{
+			//The remaining jobs are running on other threads.
+			_mm_pause();
+		}
+		else
+		{
+			tbb::this_tbb_thread::yield();
+		}
+	}
+}
+
+void bsJobSystem::waitUntilUnused(const bsJob& job, unsigned int threadIndex)
+{
+	unsigned int failedAttempts = 0;
+
+	//Volatile, the job is marked as unused by whichever thread runs it.
+	while (static_cast<const volatile bsJob&>(job).function != nullptr)
+	{
+		bsJob* otherJob = findJob(threadIndex);
+		if (otherJob != nullptr)
+		{
+			execute(*otherJob, threadIndex);
+			failedAttempts = 0;
+		}
+		else if (++failedAttempts < kSpinCountBeforeYield)
+		{
+			//The job is running on another thread.
+			_mm_pause();
+		}
+		else
+		{
+			tbb::this_tbb_thread::yield();
+		}
+	}
+}
+
+unsigned int bsJobSystem::getThreadIndex() const
+{
+	return gThreadJobSystem == this ? gThreadIndex : kNotAJobThread;
+}
+
+void bsJobSystem::workerLoop(unsigned int threadIndex)
+{
+	gThreadIndex = threadIndex;
+	gThreadJobSystem = this;
+
+	char threadName[32];
+	sprintf_s(threadName, "Job Worker %u", threadIndex);
+	bsWindowsUtils::setThreadName(static_cast<DWORD>(-1), threadName);
+	bsProfiler::setThreadName(threadName);
+
+	unsigned int failedAttempts = 0;
+
+	while (!mQuit)
+	{
+		bsJob* job = findJob(threadIndex);
+		if (job != nullptr)
+		{
+			execute(*job, threadIndex);
+			failedAttempts = 0;
+
+			continue;
+		}
+
+		if (++failedAttempts < kSpinCountBeforeYield)
+		{
+			_mm_pause();
+
+			continue;
+		}
+		else if (failedAttempts < kSpinCountBeforeSleep)
+		{
+			tbb::this_tbb_thread::yield();
+
+			continue;
+		}
+
+		/*	Announce the sleep before checking for work one last time. Pushing threads
+			check for sleepers after pushing, so either this sees the job, or the pusher
+			sees this worker and wakes it.
+		*/
+		mSleepingWorkers.fetch_and_increment();
+		if (!hasQueuedJobs() && !mQuit)
+		{
+			WaitForSingleObject(mWakeSemaphore, INFINITE);
+		}
+		mSleepingWorkers.fetch_and_decrement();
+
+		failedAttempts = 0;
+	}
+}
+
+bsJob* bsJobSystem::allocateJob(unsigned int threadIndex)
+{
+	bsJob* job;
+
+	if (threadIndex != kNotAJobThread)
+	{
+		ThreadData& threadData = mThreadData[threadIndex];
+		job = &threadData.jobs[threadData.nextJob];
+		threadData.nextJob = (threadData.nextJob + 1) & (kMaxJobsPerThread - 1);
+	}
+	else
+	{
+		tbb::spin_mutex::scoped_lock lock(mSharedMutex);
+		job = &mSharedJobs[mNextSharedJob];
+		mNextSharedJob = (mNextSharedJob + 1) & (kMaxJobsPerThread - 1);
+	}
+
+	if (job->function != nullptr)
+	{
+		//The ring has wrapped around to a job in flight, help until it has finished
+		//instead of overwriting it.
+		waitUntilUnused(*job, threadIndex);
+	}
+
+	return job;
+}
+
+void bsJobSystem::schedule(bsJob* job, bsJobCounter* dependency, unsigned int threadIndex)
+{
+	if (dependency != nullptr)
+	{
+		tbb::spin_mutex::scoped_lock lock(dependency->mContinuationMutex);
+
+		if (dependency->mPending != 0)
+		{
+			//Pushed by the dependency's last job when it finishes.
+			job->nextContinuation = dependency->mContinuations;
+			dependency->mContinuations = job;
+
+			return;
+		}
+	}
+
+	push(job, threadIndex);
+}
+
+void bsJobSystem::push(bsJob* job, unsigned int threadIndex)
+{
+	if (threadIndex != kNotAJobThread)
+	{
+		if (!mThreadData[threadIndex].deque.push(job))
+		{
+			//Full, since it also takes the continuations of other threads' jobs. Run
+			//the job here instead, its dependency is done or it would not be pushed.
+			execute(*job, threadIndex);
+
+			return;
+		}
+	}
+	else
+	{
+		tbb::spin_mutex::scoped_lock lock(mSharedMutex);
+		mSharedQueue.push_back(job);
+		++mSharedQueueSize;
+	}
+
+	//Locked add to act as a full fence, see workerLoop.
+	if (mSleepingWorkers.fetch_and_add(0) > 0)
+	{
+		ReleaseSemaphore(mWakeSemaphore, 1, nullptr);
+	}
+}
+
+bsJob* bsJobSystem::findJob(unsigned int threadIndex)
+{
+	unsigned int random = 0;
+
+	if (threadIndex != kNotAJobThread)
+	{
+		bsJob* job = mThreadData[threadIndex].deque.pop();
+		if (job != nullptr)
+		{
+			return job;
+		}
+
+		random = nextRandom(mThreadData[threadIndex].random);
+	}
+
+	if (mSharedQueueSize != 0)
+	{
+		tbb::spin_mutex::scoped_lock lock(mSharedMutex);
+		if (!mSharedQueue.empty())
+		{
+			bsJob* job = mSharedQueue.back();
+			mSharedQueue.pop_back();
+			--mSharedQueueSize;
+
+			return job;
+		}
+	}
+
+	//Steal, starting at a random thread so thieves don't all hit the same victim.
+	for (unsigned int i = 0; i < mThreadCount; ++i)
+	{
+		const unsigned int victim = (random + i) % mThreadCount;
+		if (victim == threadIndex)
+		{
+			continue;
+		}
+
+		bsJob* job = mThreadData[victim].deque.steal();
+		if (job != nullptr)
+		{
+			return job;
+		}
+	}
+
+	return nullptr;
+}
+
+bool bsJobSystem::hasQueuedJobs() const
+{
+	if (mSharedQueueSize != 0)
+	{
+		return true;
+	}
+
+	for (unsigned int i = 0; i < mThreadCount; ++i)
+	{
+		if (!mThreadData[i].deque.isEmpty())
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void bsJobSystem::execute(bsJob& job, unsigned int threadIndex)
+{
+	job.function(job.data, job.begin, job.end);
+
+	bsJobCounter& counter = *job.counter;
+	//The job may be reused as soon as it is marked as unused.
+	job.function = nullptr;
+
+	//Keeps waiters from seeing the counter as done until the continuations are pushed.
+	counter.mFinishing.fetch_and_increment();
+
+	if (counter.mPending.fetch_and_decrement() == 1)
+	{
+		bsJob* continuations;
+		{
+			tbb::spin_mutex::scoped_lock lock(counter.mContinuationMutex);
+			continuations = counter.mContinuations;
+			counter.mContinuations = nullptr;
+		}
+
+		while (continuations != nullptr)
+		{
+			bsJob* next = continuations->nextContinuation;
+			push(continuations, threadIndex);
+			continuations = next;
+		}
+	}
+
+	counter.mFinishing.fetch_and_decrement();
+}
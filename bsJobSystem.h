@@ -0,0 +1,262 @@
+#pragma once
+
+#include <vector>
+
+#include <Windows.h>
+
+#include <tbb/atomic.h>
+#include <tbb/spin_mutex.h>
+#include <tbb/tbb_thread.h>
+
+#include "bsAssert.h"
+
+struct bsJob;
+class bsThreadPlacement;
+
+
+/*	Function run by a job, with the data pointer and the range passed to
+	bsJobSystem::run. Jobs created by runRange each get part of the range.
+*/
+typedef void (*bsJobFunction)(void* data, unsigned int begin, unsigned int end);
+
+
+/*	Counts the unfinished jobs it was passed to, and can be waited on or used as another
+	job's dependency.
+	A counter must not be destroyed before it is done. Wait for it before destroying it,
+	also when it was only used as a dependency. It can be reused once it is done.
+*/
+class bsJobCounter
+{
+public:
+	bsJobCounter()
+		: mContinuations(nullptr)
+	{
+		mPending = 0;
+		mFinishing = 0;
+	}
+
+	~bsJobCounter()
+	{
+		BS_ASSERT2(isDone(), "Job counter destroyed while its jobs are running");
+	}
+
+	//True when every job counted by this counter has finished.
+	inline bool isDone() const
+	{
+		return mPending == 0 && mFinishing == 0;
+	}
+
+private:
+	friend class bsJobSystem;
+
+	//Non-copyable.
+	bsJobCounter(const bsJobCounter&);
+	bsJobCounter& operator=(const bsJobCounter&);
+
+	tbb::atomic<int>	mPending;
+	//Jobs which have decremented mPending, but may still access the counter.
+	tbb::atomic<int>	mFinishing;
+
+	//Jobs depending on this counter, pushed when it reaches zero.
+	tbb::spin_mutex		mContinuationMutex;
+	bsJob*				mContinuations;
+};
+
+
+//Internal, a single job. Jobs are owned by the job system.
+struct bsJob
+{
+	bsJobFunction	function;
+	void*			data;
+	unsigned int	begin;
+	unsigned int	end;
+
+	bsJobCounter*	counter;
+	//Next job depending on the same counter.
+	bsJob*			nextContinuation;
+};
+
+
+/*	Work stealing job system for running frame work such as culling, transform
+	synchronization and asset decoding in parallel.
+
+	The job system starts a number of worker threads, each with its own deque of jobs.
+	Jobs created on a worker are pushed to that worker's deque, and workers which run
+	out of jobs steal from the others. Jobs created on other threads go to a shared queue.
+	The thread which created the job system has a deque too, and runs jobs while it waits
+	for a counter, so it is never idle while work it depends on is queued.
+
+	Jobs are expressed as a function, a data pointer and a range. Every job is counted by
+	a bsJobCounter, which can be waited on, and a job can depend on another counter, in
+	which case it is not started until every job counted by that counter has finished.
+	This is enough to build job graphs:
+
+	bsJobCounter decoded, uploaded;
+	jobSystem.runRange(decodeChunk, &mesh, chunkCount, 1, decoded);
+	jobSystem.run(uploadMesh, &mesh, 0, 1, uploaded, &decoded);
+	jobSystem.wait(uploaded);
+
+	parallelFor is the simple case of splitting a loop into jobs and waiting for them.
+
+	Jobs are stored in a ring of kMaxJobsPerThread per thread, and are reused after that
+	many newer jobs. A thread whose ring wraps around to a job which is still in flight
+	runs other jobs until that one has finished, so any number of jobs can be created,
+	but creating more than kMaxJobsPerThread at once makes the creating thread help.
+*/
+class bsJobSystem
+{
+public:
+	//Must be a power of two.
+	static const unsigned int kMaxJobsPerThread = 4096;
+
+	//Returned by getThreadIndex for threads which are not part of the job system.
+	static const unsigned int kNotAJobThread = ~0u;
+
+
+	/*	Starts workerThreadCount worker threads. The calling thread becomes thread 0,
+		and must be the one that destroys the job system.
+		With 0 workers, jobs run on whichever thread waits for them.
+		If threadPlacement is not null, the workers are placed on processors by it.
+	*/
+	explicit bsJobSystem(unsigned int workerThreadCount,
+		const bsThreadPlacement* threadPlacement = nullptr);
+
+	//Stops and joins the workers. All jobs must be finished.
+	~bsJobSystem();
+
+	/*	Runs function(data, begin, end) as a single job, counted by counter.
+		If dependency is not null, the job does not start before dependency is done.
+		Thread safe.
+	*/
+	void run(bsJobFunction function, void* data, unsigned int begin, unsigned int end,
+		bsJobCounter& counter, bsJobCounter* dependency = nullptr);
+
+	/*	Splits [0, count) into jobs of at most grainSize elements each, and runs them like
+		run does.
+	*/
+	void runRange(bsJobFunction function, void* data, unsigned int count,
+		unsigned int grainSize, bsJobCounter& counter, bsJobCounter* dependency = nullptr);
+
+	/*	Runs jobs until every job counted by counter has finished.
+		Can be called from any thread, including from inside a job.
+	*/
+	void wait(bsJobCounter& counter);
+
+	/*	Calls body(begin, end) for ranges of at most grainSize elements covering
+		[0, count), in parallel, and returns when all of them have finished.
+		Ranges small enough to not be split run directly on the calling thread.
+	*/
+	template <typename Body>
+	void parallelFor(unsigned int count, unsigned int grainSize, const Body& body)
+	{
+		if (count <= grainSize)
+		{
+			if (count != 0)
+			{
+				body(0, count);
+			}
+
+			return;
+		}
+
+		bsJobCounter counter;
+		runRange(&invokeBody<Body>, const_cast<void*>(static_cast<const void*>(&body)),
+			count, grainSize, counter);
+		wait(counter);
+	}
+
+	//The number of threads running jobs, including the thread which created the system.
+	inline unsigned int getThreadCount() const
+	{
+		return mThreadCount;
+	}
+
+	/*	Index of the calling thread, in [0, getThreadCount()), or kNotAJobThread.
+		Useful for indexing per thread data from inside jobs.
+	*/
+	unsigned int getThreadIndex() const;
+
+private:
+	//Non-copyable.
+	bsJobSystem(const bsJobSystem&);
+	bsJobSystem& operator=(const bsJobSystem&);
+
+	/*	Fixed size Chase-Lev work stealing deque. The owning thread pushes and pops at the
+		bottom, other threads steal from the top.
+	*/
+	class Deque
+	{
+	public:
+		Deque();
+
+		//Owner only. push returns false without pushing if the deque is full.
+		bool push(bsJob* job);
+		bsJob* pop();
+
+		//Any thread.
+		bsJob* steal();
+		bool isEmpty() const;
+
+	private:
+		bsJob*					mJobs[kMaxJobsPerThread];
+
+		//Top is written by thieves and bottom by the owner, keep them on separate lines.
+		tbb::atomic<long long>	mTop;
+		char					mPadding[64];
+		tbb::atomic<long long>	mBottom;
+	};
+
+	struct ThreadData
+	{
+		Deque			deque;
+
+		bsJob			jobs[kMaxJobsPerThread];
+		unsigned int	nextJob;
+
+		//State for picking steal victims.
+		unsigned int	random;
+	};
+
+	template <typename Body>
+	static void invokeBody(void* body, unsigned int begin, unsigned int end)
+	{
+		(*static_cast<const Body*>(body))(begin, end);
+	}
+
+	void workerLoop(unsigned int threadIndex);
+
+	bsJob* allocateJob(unsigned int threadIndex);
+
+	//Runs other jobs until job has finished, so that it can be reused.
+	void waitUntilUnused(const bsJob& job, unsigned int threadIndex);
+
+	/*	Queues a job, or attaches it to its dependency if the dependency has unfinished
+		jobs.
+	*/
+	void schedule(bsJob* job, bsJobCounter* dependency, unsigned int threadIndex);
+	void push(bsJob* job, unsigned int threadIndex);
+
+	//Returns a job to run on the given thread, or null if there is none.
+	bsJob* findJob(unsigned int threadIndex);
+	bool hasQueuedJobs() const;
+
+	void execute(bsJob& job, unsigned int threadIndex);
+
+
+	unsigned int				mThreadCount;
+	ThreadData*					mThreadData;
+	std::vector<tbb::tbb_thread*>	mWorkers;
+
+	//Jobs created by threads which are not part of the job system.
+	tbb::spin_mutex				mSharedMutex;
+	std::vector<bsJob*>			mSharedQueue;
+	tbb::atomic<unsigned int>	mSharedQueueSize;
+	bsJob						mSharedJobs[kMaxJobsPerThread];
+	unsigned int				mNextSharedJob;
+
+	//Idle workers sleep on this semaphore, and are woken when jobs are pushed.
+	HANDLE						mWakeSemaphore;
+	tbb::atomic<int>			mSleepingWorkers;
+
+	tbb::atomic<bool>			mQuit;
+};
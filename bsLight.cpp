@@ -6,6 +6,7 @@
 #include "bsMeshCache.h"
 #include "bsAssert.h"
 #include "bsConstantBuffers.h"
+#include "bsRenderDevice.h"
 
 
 bsLight::bsLight(LightType lightType, bsMeshCache* meshCache,
@@ -13,7 +14,7 @@ bsLight::bsLight(LightType lightType, bsMeshCache* meshCache,
 	: mLightType(lightType)
 	, mLightData(lightData)
 	//, mMesh(meshCache->getMesh("sphere_1m_d.bsm"))
-	, mMesh(meshCache->getMesh("unit_cube.bsm"))
+	, mMesh(meshCache->getMesh(bsStringId("unit_cube.bsm")))
 {
 	//BS_ASSERT2(lightType == LT_POINT, "Only points lights are functional");
 
@@ -21,7 +22,7 @@ bsLight::bsLight(LightType lightType, bsMeshCache* meshCache,
 	mBoundingSphere.setRadius(mLightData.radius);
 }
 
-void bsLight::drawInstanced(ID3D11DeviceContext& deviceContext,
+void bsLight::drawInstanced(bsRenderDevice& renderDevice,
 	ID3D11Buffer* instanceBuffer, unsigned int instanceCount) const
 {
 	if (!mMesh->hasFinishedLoading())
@@ -42,9 +43,9 @@ void bsLight::drawInstanced(ID3D11DeviceContext& deviceContext,
 	for (unsigned int i = 0; i < bufferCount; ++i)
 	{
 		vertexInstanceBuffers[0] = vertexBuffers[i];
-		deviceContext.IASetVertexBuffers(0, 2, vertexInstanceBuffers, strides, offsets);
-		deviceContext.IASetIndexBuffer(indexBuffers[i], DXGI_FORMAT_R32_UINT, 0);
+		renderDevice.setVertexBuffers(0, 2, vertexInstanceBuffers, strides, offsets);
+		renderDevice.setIndexBuffer(indexBuffers[i], DXGI_FORMAT_R32_UINT, 0);
 
-		deviceContext.DrawIndexedInstanced(indexCounts[i], instanceCount, 0, 0, 0);
+		renderDevice.drawIndexedInstanced(indexCounts[i], instanceCount, 0, 0, 0);
 	}
 }
@@ -6,10 +6,12 @@
 #include <xnamath.h>
 
 #include "bsCollision.h"
+#include "bsMemoryTracker.h"
 
 class bsMesh;
 class bsMeshCache;
 class bsDx11Renderer;
+class bsRenderDevice;
 struct LightInstanceData;
 
 
@@ -50,11 +52,11 @@ public:
 
 	inline void* operator new(size_t)
 	{
-		return _aligned_malloc(sizeof(bsLight), 16);
+		return bsMemoryTracker::allocate(sizeof(bsLight), 16, bsMemoryTracker::TAG_SCENE);
 	}
 	inline void operator delete(void* p)
 	{
-		_aligned_free(p);
+		bsMemoryTracker::deallocate(p);
 	}
 
 
@@ -65,7 +67,7 @@ public:
 	
 	/*	Draws light using instancing.
 	*/
-	void drawInstanced(ID3D11DeviceContext& deviceContext, ID3D11Buffer* instanceBuffer,
+	void drawInstanced(bsRenderDevice& renderDevice, ID3D11Buffer* instanceBuffer,
 		unsigned int instanceCount) const;
 
 	inline LightType getLightType() const
@@ -7,6 +7,7 @@
 
 #include "bsLineRenderer.h"
 #include "bsDx11Renderer.h"
+#include "bsRenderDevice.h"
 #include "bsVertexTypes.h"
 #include "bsLog.h"
 #include "bsAssert.h"
@@ -17,6 +18,7 @@
 bsLineRenderer::bsLineRenderer(const XMFLOAT4& colorRgba)
 	: mFinished(true)
 	, mColor(colorRgba)
+	, mRenderDevice(nullptr)
 	, mVertexBuffer(nullptr)
 	, mIndexBuffer(nullptr)
 	, mEntity(nullptr)
@@ -28,11 +30,11 @@ bsLineRenderer::~bsLineRenderer()
 {
 	if (mVertexBuffer)
 	{
-		mVertexBuffer->Release();
+		mRenderDevice->release(mVertexBuffer);
 	}
 	if (mIndexBuffer)
 	{
-		mIndexBuffer->Release();
+		mRenderDevice->release(mIndexBuffer);
 	}
 }
 
@@ -56,13 +58,17 @@ bool bsLineRenderer::build(bsDx11Renderer* dx11Renderer)
 {
 	if (mVertexBuffer)
 	{
-		mVertexBuffer->Release();
+		mRenderDevice->release(mVertexBuffer);
+		mVertexBuffer = nullptr;
 	}
 	if (mIndexBuffer)
 	{
-		mIndexBuffer->Release();
+		mRenderDevice->release(mIndexBuffer);
+		mIndexBuffer = nullptr;
 	}
 
+	mRenderDevice = &dx11Renderer->getRenderDevice();
+
 	const unsigned int pointCount = mPoints.size();
 
 	BS_ASSERT2(mPoints.size(), "Tried to build line renderer, but no points have been added");
@@ -80,7 +86,7 @@ bool bsLineRenderer::build(bsDx11Renderer* dx11Renderer)
 	memset(&initData, 0, sizeof(initData));
 	initData.pSysMem = &mPoints[0];
 
-	if (FAILED(dx11Renderer->getDevice()->CreateBuffer(&bufferDescription, &initData,
+	if (FAILED(mRenderDevice->createBuffer(bufferDescription, &initData,
 		&mVertexBuffer)))
 	{
 		BS_ASSERT(!"Failed to build vertex buffer");
@@ -89,9 +95,7 @@ bool bsLineRenderer::build(bsDx11Renderer* dx11Renderer)
 	}
 
 #ifdef BS_DEBUG
-	std::string vertexBufferName("VB Line3D");
-	mVertexBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, vertexBufferName.length(),
-		vertexBufferName.c_str());
+	mRenderDevice->setDebugName(mVertexBuffer, "VB Line3D");
 #endif // BS_DEBUG
 
 	///Index buffer
@@ -108,7 +112,7 @@ bool bsLineRenderer::build(bsDx11Renderer* dx11Renderer)
 
 	initData.pSysMem = &indices[0];
 
-	if (FAILED(dx11Renderer->getDevice()->CreateBuffer(&bufferDescription, &initData,
+	if (FAILED(mRenderDevice->createBuffer(bufferDescription, &initData,
 		&mIndexBuffer)))
 	{
 		BS_ASSERT(!"Failed to build index buffer");
@@ -118,9 +122,7 @@ bool bsLineRenderer::build(bsDx11Renderer* dx11Renderer)
 	
 
 #ifdef BS_DEBUG
-	std::string indexBufferName("IB Line3D");
-	mIndexBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, indexBufferName.length(),
-		indexBufferName.c_str());
+	mRenderDevice->setDebugName(mIndexBuffer, "IB Line3D");
 #endif // BS_DEBUG
 
 	mBoundingSphere = bsCollision::createSphereFromPoints(mPoints.data(), mPoints.size());
@@ -147,14 +149,14 @@ void bsLineRenderer::draw(bsDx11Renderer* dx11Renderer) const
 	BS_ASSERT2(mFinished, "Trying to draw a bsLineRenderer which has not had its buffers created."
 		" Did you forget to call build()?");
 
-	ID3D11DeviceContext* context = dx11Renderer->getDeviceContext();
+	bsRenderDevice& renderDevice = dx11Renderer->getRenderDevice();
 
 	const unsigned int offsets =  0;
 	const unsigned int stride = sizeof(XMFLOAT3);
-	context->IASetVertexBuffers(0, 1, &mVertexBuffer, &stride, &offsets);
-	context->IASetIndexBuffer(mIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	renderDevice.setVertexBuffers(0, 1, &mVertexBuffer, &stride, &offsets);
+	renderDevice.setIndexBuffer(mIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
 
-	context->DrawIndexed(mPoints.size(), 0, 0);
+	renderDevice.drawIndexed(mPoints.size(), 0, 0);
 
 	/*
 	hkVector4 start, end;
@@ -175,12 +177,12 @@ void bsLineRenderer::clear()
 
 	if (mVertexBuffer)
 	{
-		mVertexBuffer->Release();
+		mRenderDevice->release(mVertexBuffer);
 		mVertexBuffer = nullptr;
 	}
 	if (mIndexBuffer)
 	{
-		mIndexBuffer->Release();
+		mRenderDevice->release(mIndexBuffer);
 		mIndexBuffer = nullptr;
 	}
 }
@@ -6,10 +6,12 @@
 #include <xnamath.h>
 
 #include "bsCollision.h"
+#include "bsMemoryTracker.h"
 
 struct ID3D11Buffer;
 struct ID3D11Buffer;
 class bsDx11Renderer;
+class bsRenderDevice;
 class bsEntity;
 
 
@@ -25,11 +27,12 @@ class bsLineRenderer
 public:
 	inline void* operator new(size_t)
 	{
-		return _aligned_malloc(sizeof(bsLineRenderer), 16);
+		return bsMemoryTracker::allocate(sizeof(bsLineRenderer), 16,
+			bsMemoryTracker::TAG_SCENE);
 	}
 	inline void operator delete(void* p)
 	{
-		_aligned_free(p);
+		bsMemoryTracker::deallocate(p);
 	}
 
 
@@ -99,6 +102,8 @@ private:
 
 	std::vector<XMFLOAT3>	mPoints;
 
+	//Device the buffers were created by, null until the first build.
+	bsRenderDevice*	mRenderDevice;
 	ID3D11Buffer*	mVertexBuffer;
 	ID3D11Buffer*	mIndexBuffer;
 
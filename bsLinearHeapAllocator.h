@@ -2,6 +2,8 @@
 
 #include <stdlib.h>//malloc/free
 
+#include "bsAssert.h"
+
 
 /*	Linear heap allocator.
 	This allocator stores its memory buffer on the heap. This buffer is a single
@@ -15,19 +17,40 @@
 
 	Memory allocated from this allocator does not need to be freed manually, as the whole
 	buffer will be freed by the destructor (unless takeOwnershipOfAllocatedMemory is called).
+	Memory allocated after a marker can be freed by rewinding to that marker, which
+	bsAllocatorScope does automatically.
 */
 class bsLinearHeapAllocator
 {
 public:
+	//A position in the buffer, see getMarker and rewind.
+	typedef size_t Marker;
+
+
 	inline explicit bsLinearHeapAllocator(size_t memorySize)
 		: mBuffer(static_cast<char*>(malloc(memorySize)))
 		, mBufferHead(mBuffer)
 		, mMemorySize(memorySize)
+		, mOwnsBuffer(true)
+	{}
+
+	/*	Allocates from a buffer owned by someone else, for example one allocated with
+		bsMemory::allocateLarge to get huge pages. The buffer is not freed by the
+		allocator, and must outlive it.
+	*/
+	inline bsLinearHeapAllocator(void* buffer, size_t memorySize)
+		: mBuffer(static_cast<char*>(buffer))
+		, mBufferHead(mBuffer)
+		, mMemorySize(memorySize)
+		, mOwnsBuffer(false)
 	{}
 
 	inline ~bsLinearHeapAllocator()
 	{
-		free(mBuffer);
+		if (mOwnsBuffer)
+		{
+			free(mBuffer);
+		}
 	}
 
 	/*	Allocates enough memory for the requested amount of objects (sizeof(T) * count).
@@ -47,6 +70,54 @@ public:
 		return static_cast<char*>(internalAllocate(bytes));
 	}
 
+	/*	Allocates bytes bytes, aligned to alignment, which must be a power of 2.
+		Returns null if there is not enough memory, including the padding needed to align
+		the allocation.
+	*/
+	inline void* allocate(size_t bytes, size_t alignment)
+	{
+		BS_ASSERT2((alignment & (alignment - 1)) == 0, "Alignment must be a power of 2");
+
+		const size_t address = reinterpret_cast<size_t>(mBufferHead);
+		const size_t padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+		if (!canFit(padding + bytes))
+		{
+			return nullptr;
+		}
+
+		mBufferHead += padding;
+		return internalAllocate(bytes);
+	}
+
+	/*	Allocates enough memory for the requested amount of objects, aligned to the type's
+		alignment requirement (for example 16 bytes for XMMATRIX).
+		Returns null if there is not enough free memory.
+	*/
+	template <typename T>
+	inline T* allocateAligned(size_t count)
+	{
+		return static_cast<T*>(allocate(sizeof(T) * count, __alignof(T)));
+	}
+
+	/*	Returns the current position in the buffer. Rewinding to it later frees everything
+		allocated after this call.
+	*/
+	inline Marker getMarker() const
+	{
+		return static_cast<Marker>(mBufferHead - mBuffer);
+	}
+
+	/*	Frees everything allocated after the marker was retrieved. All memory allocated
+		after it is invalid after calling this.
+	*/
+	inline void rewind(Marker marker)
+	{
+		BS_ASSERT2(marker <= getMarker(), "Rewinding to a marker which has already been"
+			" rewound past");
+
+		mBufferHead = mBuffer + marker;
+	}
+
 	/*	Resets allocator. All previously allocated memory is invalid after calling this.
 	*/
 	inline void clear()
@@ -72,6 +143,8 @@ public:
 	*/
 	inline void* takeOwnershipOfAllocatedMemory()
 	{
+		BS_ASSERT2(mOwnsBuffer, "Taking ownership of a buffer the allocator doesn't own");
+
 		void* buffer = mBuffer;
 		//Null out own data so destructor's free won't it.
 		mBuffer = nullptr;
@@ -86,6 +159,11 @@ public:
 	{
 		return static_cast<size_t>((mBuffer + mMemorySize) - mBufferHead);
 	}
+
+	inline size_t getMemorySize() const
+	{
+		return mMemorySize;
+	}
 	
 
 private:
@@ -116,4 +194,39 @@ private:
 	char* mBufferHead;
 	//Size of the buffer.
 	size_t mMemorySize;
+	//False if the buffer was provided by the user, and must not be freed.
+	bool mOwnsBuffer;
+};
+
+
+/*	Rewinds an allocator to where it was when the scope was created, when the scope is
+	destroyed. Works with any allocator which has getMarker and rewind functions.
+
+	{
+		bsAllocatorScope<bsLinearHeapAllocator> scope(allocator);
+		float* temporary = allocator.allocateAligned<float>(100);
+		...
+	}//temporary is freed here.
+*/
+template <typename Allocator>
+class bsAllocatorScope
+{
+public:
+	explicit bsAllocatorScope(Allocator& allocator)
+		: mAllocator(allocator)
+		, mMarker(allocator.getMarker())
+	{}
+
+	~bsAllocatorScope()
+	{
+		mAllocator.rewind(mMarker);
+	}
+
+private:
+	//Non-copyable.
+	bsAllocatorScope(const bsAllocatorScope&);
+	bsAllocatorScope& operator=(const bsAllocatorScope&);
+
+	Allocator&							mAllocator;
+	const typename Allocator::Marker	mMarker;
 };
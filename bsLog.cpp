@@ -1,11 +1,25 @@
 #include "StdAfx.h"
 
 #include "bsLog.h"
+
+#include <map>
+
+#include <tbb/atomic.h>
+#include <tbb/spin_mutex.h>
+#include <tbb/tbb_thread.h>
+
 #include "bsAssert.h"
+#include "bsLogFormat.h"
+#include "bsWindowsUtils.h"
 
 
 #ifndef BS_DISABLE_FEATURE_LOGGING
 
+//Visual Studio 2010 has no va_copy, but its va_list is a plain pointer.
+#ifndef va_copy
+#define va_copy(destination, source) ((destination) = (source))
+#endif
+
 unsigned short bsLog::mMinSevAndFlags = 0;
 
 FILE* bsLog::mFile = nullptr;
@@ -19,9 +33,125 @@ const char* bsLog::mSeverityStrings[bsLog::SEVERITY_COUNT] =
 	"Critical",
 };
 
+const char* bsLog::mChannelStrings[bsLog::CHANNEL_COUNT] =
+{
+	"",
+	"Render: ",
+	"IO: ",
+	"Physics: ",
+	"Resources: ",
+};
+
+unsigned char bsLog::mChannelMinSeverities[bsLog::CHANNEL_COUNT] = { 0 };
+
 std::vector<std::function<void(const char*)>> bsLog::mCallbacks
 	= std::vector<std::function<void(const char*)>>();
 
+bsLog::Message* bsLog::mMessages = nullptr;
+
+
+/*	The ring buffer is a bounded multi-producer queue where every slot has a sequence
+	number. A producer owns a slot once it has advanced the enqueue position past it, and
+	publishes it by setting its sequence to position + 1. The consumer releases a slot by
+	setting its sequence to position + capacity, making it available to the producers on
+	the next lap.
+*/
+struct bsLog::Message
+{
+	tbb::atomic<unsigned int>	sequence;
+
+	Severity		severity;
+	Channel			channel;
+	unsigned long	threadId;
+	FILETIME		time;
+
+	//Format string for messages logged with logf, null for messages logged with log.
+	const char*		format;
+	//Size of the captured arguments, only used if format is not null.
+	unsigned int	argumentsSize;
+
+	/*	The message text for log, or the captured arguments for logf.
+		longData is null if they fit in data.
+	*/
+	char*			longData;
+	char			data[kInlineMessageSize];
+};
+
+namespace
+{
+//Keep producer and consumer positions on separate cache lines.
+__declspec(align(64)) struct AlignedPosition
+{
+	tbb::atomic<unsigned int>	position;
+	char						padding[60];
+};
+
+AlignedPosition		gEnqueuePosition;
+AlignedPosition		gDequeuePosition;
+
+tbb::atomic<unsigned int>	gDroppedMessageCount;
+unsigned int				gReportedDroppedMessageCount = 0;
+
+//Held by whichever thread is currently writing messages.
+tbb::spin_mutex		gConsumerMutex;
+//ID of the thread holding gConsumerMutex, 0 when nobody is writing.
+tbb::atomic<DWORD>	gConsumerThreadId;
+//Protects bsLog::mCallbacks.
+tbb::spin_mutex		gCallbackMutex;
+
+tbb::tbb_thread*	gWriterThread = nullptr;
+tbb::atomic<int>	gQuitWriter;
+HANDLE				gWakeWriterEvent = nullptr;
+
+LPTOP_LEVEL_EXCEPTION_FILTER	gPreviousExceptionFilter = nullptr;
+
+//Formatted messages are batched here before being written to the file.
+const size_t kWriteBufferSize = 64 * 1024;
+char		gWriteBuffer[kWriteBufferSize];
+size_t		gWriteBufferUsed = 0;
+
+//How long the writer sleeps when there are no messages, in milliseconds.
+const DWORD kWriterSleepTime = 5;
+
+//How many times an error message retries when the queue is full before being dropped.
+const unsigned int kFullQueueRetries = 1000;
+
+//Messages logged with logf are formatted here by the consumer.
+char		gFormatBuffer[bsLog::kTempBufferSize];
+
+/*	IDs written to binary logs for format strings, by format string pointer. Only used by
+	the consumer. IDs are assigned in order of first use.
+*/
+std::map<const char*, unsigned int>	gFormatIds;
+
+void writeBufferedMessages(FILE* file)
+{
+	if (gWriteBufferUsed != 0)
+	{
+		fwrite(gWriteBuffer, 1, gWriteBufferUsed, file);
+		gWriteBufferUsed = 0;
+	}
+}
+
+void appendToWriteBuffer(FILE* file, const void* data, size_t length)
+{
+	if (gWriteBufferUsed + length > kWriteBufferSize)
+	{
+		writeBufferedMessages(file);
+
+		if (length > kWriteBufferSize)
+		{
+			//Too long to batch.
+			fwrite(data, 1, length, file);
+			return;
+		}
+	}
+
+	memcpy(gWriteBuffer + gWriteBufferUsed, data, length);
+	gWriteBufferUsed += length;
+}
+}
+
 
 void bsLog::init(FILE* file, Severity minSeverity /*= INFO*/, unsigned char flags /*= 0*/)
 {
@@ -29,10 +159,57 @@ void bsLog::init(FILE* file, Severity minSeverity /*= INFO*/, unsigned char flag
 
 	mFile = file;
 	mMinSevAndFlags = (unsigned short)((minSeverity << 12) | flags);
+
+	mMessages = new Message[kQueueCapacity];
+	for (unsigned int i = 0; i < kQueueCapacity; ++i)
+	{
+		mMessages[i].sequence = i;
+	}
+	gEnqueuePosition.position = 0;
+	gDequeuePosition.position = 0;
+	gDroppedMessageCount = 0;
+	gReportedDroppedMessageCount = 0;
+	gFormatIds.clear();
+
+	if (flags & BINARY_OUTPUT)
+	{
+		bsLogFormat::BinaryLogHeader header;
+		memcpy(header.magic, "bslg", 4);
+		header.version = bsLogFormat::kBinaryLogVersion;
+		header.flags = getFlags();
+		header.unused = 0;
+		fwrite(&header, sizeof(header), 1, mFile);
+	}
+
+	gQuitWriter = 0;
+	gWakeWriterEvent = CreateEvent(nullptr, false, false, nullptr);
+	gWriterThread = new tbb::tbb_thread(&bsLog::writerThreadLoop);
+	bsWindowsUtils::setThreadName(GetThreadId(gWriterThread->native_handle()), "Log Writer");
+
+	gPreviousExceptionFilter = SetUnhandledExceptionFilter(&bsLog::unhandledExceptionFilter);
 }
 
 void bsLog::deinit()
 {
+	if (gWriterThread)
+	{
+		gQuitWriter = 1;
+		SetEvent(gWakeWriterEvent);
+		gWriterThread->join();
+		delete gWriterThread;
+		gWriterThread = nullptr;
+
+		SetUnhandledExceptionFilter(gPreviousExceptionFilter);
+		CloseHandle(gWakeWriterEvent);
+		gWakeWriterEvent = nullptr;
+	}
+
+	//Write anything logged after the writer thread stopped.
+	flush();
+
+	delete[] mMessages;
+	mMessages = nullptr;
+
 	if (!(getFlags() & DONT_CLOSE_FILE))
 	{
 		fclose(mFile);
@@ -41,135 +218,356 @@ void bsLog::deinit()
 	mCallbacks.clear();
 }
 
-void bsLog::log(const char* message, Severity severity /*= INFO*/)
+void bsLog::flush()
 {
-	//Only log the message if severity is over current severity level.
-	if (severity < getMinSeverity())
+	if (!mMessages)
+	{
+		return;
+	}
+
+	/*	A callback (or a failed assertion in one) flushing from the thread which is
+		already writing. Messages are being drained right now, and the lock is not
+		recursive.
+	*/
+	if (gConsumerThreadId == GetCurrentThreadId())
 	{
 		return;
 	}
 
+	tbb::spin_mutex::scoped_lock lock(gConsumerMutex);
+
+	gConsumerThreadId = GetCurrentThreadId();
+	drainMessages();
+	gConsumerThreadId = 0;
+}
+
+unsigned int bsLog::getDroppedMessageCount()
+{
+	return gDroppedMessageCount;
+}
+
+void bsLog::addCallback(const std::function<void(const char*)>& func)
+{
+	tbb::spin_mutex::scoped_lock lock(gCallbackMutex);
+
+	mCallbacks.push_back(func);
+}
+
+void bsLog::clearAllCallbacks()
+{
+	//Messages logged so far should still reach the callbacks.
+	flush();
+
+	tbb::spin_mutex::scoped_lock lock(gCallbackMutex);
+
+	mCallbacks.clear();
+}
+
+bsLog::Message* bsLog::claimMessage(Channel channel, Severity severity)
+{
+	if (!mMessages)
+	{
+		//Not initialized.
+		return nullptr;
+	}
+
+	unsigned int retries = 0;
+	unsigned int position = gEnqueuePosition.position;
+
+	for (;;)
+	{
+		Message& message = mMessages[position & (kQueueCapacity - 1)];
+		const int difference = static_cast<int>(message.sequence - position);
+
+		if (difference == 0)
+		{
+			//Slot is free, try to claim it.
+			if (gEnqueuePosition.position.compare_and_swap(position + 1, position)
+				== position)
+			{
+				message.severity = severity;
+				message.channel = channel;
+				message.threadId = GetCurrentThreadId();
+				GetSystemTimeAsFileTime(&message.time);
+				message.format = nullptr;
+				message.argumentsSize = 0;
+				message.longData = nullptr;
+
+				return &message;
+			}
+
+			position = gEnqueuePosition.position;
+		}
+		else if (difference < 0)
+		{
+			//Queue is full.
+			if (severity < SEV_ERROR || ++retries > kFullQueueRetries)
+			{
+				++gDroppedMessageCount;
+
+				return nullptr;
+			}
+
+			//Errors are important, give the writer a chance to catch up.
+			SetEvent(gWakeWriterEvent);
+			SwitchToThread();
+
+			position = gEnqueuePosition.position;
+		}
+		else
+		{
+			//Another thread claimed this slot first.
+			position = gEnqueuePosition.position;
+		}
+	}
+}
+
+void bsLog::commitMessage(Message* message)
+{
+	const Severity severity = message->severity;
+
+	//Release store, the message contents are visible before the new sequence.
+	message->sequence = message->sequence + 1;
+
+	//Write errors promptly, everything else is picked up when the writer wakes up.
+	if (severity >= SEV_ERROR && gWakeWriterEvent)
+	{
+		SetEvent(gWakeWriterEvent);
+	}
+}
+
+void bsLog::drainMessages(bool invokeCallbacks /*= true*/)
+{
 	/*	Need exactly 47 characters when everything is enabled, unless thread ID requires
 		more than 4 digits.
 		Allocate some extra bytes to make sure everything goes smoothly in the event of
 		something unpredicted happens.
 	*/
 	const size_t bufferSize = 64;
-	char formatBuffer[bufferSize] = { 0 };
+	char prefixBuffer[bufferSize];
 
-	//Currently active flags.
-	const unsigned short flags = getFlags();
+	const bool binaryOutput = (getFlags() & BINARY_OUTPUT) != 0;
 
-	//True if any extra formatting is enabled. Will need [] and something between the two.
-	const bool startEndBrace = (flags & (TIMESTAMP_SECS | TIMESTAMP_MILLISECS |
-		DATE_ENABLED | SEVERITY_AS_TEXT | SEVERITY_AS_INT | THREAD_ID_ENABLED)) != 0;
+	bool wroteAnything = false;
 
-	if (startEndBrace)
+	tbb::spin_mutex::scoped_lock callbackLock;
+	if (invokeCallbacks)
 	{
-		//Characters written to formatBuffer.
-		size_t written = 0;
+		callbackLock.acquire(gCallbackMutex);
+	}
 
-		formatBuffer[0] = '[';
-		++written;
+	//Text is only needed for binary logs if someone is listening.
+	const bool needText = !binaryOutput || (invokeCallbacks && !mCallbacks.empty());
 
-		//Get system time to we can provide a timestamp.
-		SYSTEMTIME localTime;
-		GetLocalTime(&localTime);
+	for (;;)
+	{
+		const unsigned int position = gDequeuePosition.position;
+		Message& message = mMessages[position & (kQueueCapacity - 1)];
 
-		//Date.
-		if (flags & DATE_ENABLED)
+		if (message.sequence != position + 1)
 		{
-			written += sprintf_s(formatBuffer + written, bufferSize - written,
-				"%04u/%02u/%02u", localTime.wYear, localTime.wMonth, localTime.wDay);
+			//Empty, or the next message has been claimed but not yet committed.
+			break;
 		}
 
-		//Time (HH:MM:SS).
-		if (flags & (TIMESTAMP_SECS | TIMESTAMP_MILLISECS))
+		const char* data = message.longData ? message.longData : message.data;
+
+		//Format deferred messages.
+		const char* text = data;
+		if (message.format && needText)
 		{
-			if (written != 1)
-			{
-				//Date has been written, need a comma.
-				formatBuffer[written] = ',';
-				formatBuffer[written + 1] = ' ';
-				written += 2;
-			}
+			bsLogFormat::formatArguments(message.format, data, message.argumentsSize,
+				gFormatBuffer, kTempBufferSize);
+			text = gFormatBuffer;
+		}
 
-			written += sprintf_s(formatBuffer + written, bufferSize - written,
-				"%02u:%02u:%02u", localTime.wHour, localTime.wMinute, localTime.wSecond);
+		if (binaryOutput)
+		{
+			writeBinaryMessage(message, data);
 		}
-		//Milliseconds.
-		if (flags & TIMESTAMP_MILLISECS)
+		else
 		{
-			written += sprintf_s(formatBuffer + written, bufferSize - written,
-				":%03u", localTime.wMilliseconds);
+			bsLogFormat::formatPrefix(getFlags(), message.severity,
+				mSeverityStrings[message.severity], message.threadId, message.time,
+				prefixBuffer, bufferSize);
+			appendToWriteBuffer(mFile, prefixBuffer, strlen(prefixBuffer));
+			appendToWriteBuffer(mFile, mChannelStrings[message.channel],
+				strlen(mChannelStrings[message.channel]));
+			appendToWriteBuffer(mFile, text, strlen(text));
+			appendToWriteBuffer(mFile, "\n", 1);
 		}
 
-		//Severity level.
-		if (flags & SEVERITY_AS_TEXT)
+		//Call registered callback functions.
+		if (invokeCallbacks)
 		{
-			if (written != 1)
+			for (unsigned int i = 0; i < mCallbacks.size(); ++i)
 			{
-				//Date or time has been written, need a comma.
-				formatBuffer[written] = ',';
-				formatBuffer[written + 1] = ' ';
-				written += 2;
+				mCallbacks[i](text);
 			}
-			written += sprintf_s(formatBuffer + written, bufferSize - written,
-				mSeverityStrings[severity]);
 		}
-		else if (flags & SEVERITY_AS_INT)
+
+		free(message.longData);
+		message.longData = nullptr;
+
+		//Make the slot available to producers again.
+		message.sequence = position + kQueueCapacity;
+		gDequeuePosition.position = position + 1;
+
+		wroteAnything = true;
+	}
+
+	const unsigned int droppedMessageCount = gDroppedMessageCount;
+	if (droppedMessageCount != gReportedDroppedMessageCount)
+	{
+		const unsigned int newlyDropped = droppedMessageCount - gReportedDroppedMessageCount;
+		if (binaryOutput)
 		{
-			if (written != 1)
-			{
-				//Date or time has been written, need a comma.
-				formatBuffer[written] = ',';
-				formatBuffer[written + 1] = ' ';
-				written += 2;
-			}
-			written += sprintf_s(formatBuffer + written, bufferSize - written,
-				"%u", severity);
+			const unsigned char recordType = bsLogFormat::RECORD_DROPPED;
+			bsLogFormat::BinaryDroppedRecord record;
+			record.count = newlyDropped;
+			appendToWriteBuffer(mFile, &recordType, sizeof(recordType));
+			appendToWriteBuffer(mFile, &record, sizeof(record));
+		}
+		else
+		{
+			char droppedBuffer[bufferSize];
+			const int length = sprintf_s(droppedBuffer, "[%u log messages dropped]\n",
+				newlyDropped);
+			appendToWriteBuffer(mFile, droppedBuffer, length);
 		}
 
-		//Thread ID.
-		if (flags & THREAD_ID_ENABLED)
+		gReportedDroppedMessageCount = droppedMessageCount;
+		wroteAnything = true;
+	}
+
+	if (wroteAnything)
+	{
+		writeBufferedMessages(mFile);
+
+		//Flush immediately, don't want to lose unflushed data if the program crashes.
+		fflush(mFile);
+	}
+}
+
+void bsLog::writeBinaryMessage(const Message& message, const char* data)
+{
+	unsigned int formatId = bsLogFormat::kPlainTextFormatId;
+	unsigned int dataSize = message.argumentsSize;
+
+	if (message.format)
+	{
+		auto formatIdItr = gFormatIds.find(message.format);
+		if (formatIdItr != gFormatIds.end())
 		{
-			if (written != 1)
-			{
-				//Something has been written, need a comma.
-				formatBuffer[written] = ',';
-				formatBuffer[written + 1] = ' ';
-				written += 2;
-			}
+			formatId = formatIdItr->second;
+		}
+		else
+		{
+			//First use of this format string, write it before the message.
+			formatId = static_cast<unsigned int>(gFormatIds.size());
+			gFormatIds.insert(std::make_pair(message.format, formatId));
+
+			const unsigned char recordType = bsLogFormat::RECORD_FORMAT;
+			bsLogFormat::BinaryFormatRecord record;
+			record.formatId = formatId;
+			record.length = static_cast<unsigned int>(strlen(message.format));
+			appendToWriteBuffer(mFile, &recordType, sizeof(recordType));
+			appendToWriteBuffer(mFile, &record, sizeof(record));
+			appendToWriteBuffer(mFile, message.format, record.length);
+		}
+	}
+	else
+	{
+		dataSize = static_cast<unsigned int>(strlen(data) + 1);
+	}
 
-			const unsigned long threadId = GetThreadId(GetCurrentThread());
+	const unsigned char recordType = bsLogFormat::RECORD_MESSAGE;
+	bsLogFormat::BinaryMessageRecord record;
+	record.formatId = formatId;
+	record.severity = static_cast<unsigned char>(message.severity);
+	record.channel = static_cast<unsigned char>(message.channel);
+	record.threadId = message.threadId;
+	record.time = (static_cast<unsigned long long>(message.time.dwHighDateTime) << 32)
+		| message.time.dwLowDateTime;
+	record.argumentsSize = dataSize;
+	appendToWriteBuffer(mFile, &recordType, sizeof(recordType));
+	appendToWriteBuffer(mFile, &record, sizeof(record));
+	appendToWriteBuffer(mFile, data, dataSize);
+}
+
+void bsLog::writerThreadLoop()
+{
+	while (!gQuitWriter)
+	{
+		WaitForSingleObject(gWakeWriterEvent, kWriterSleepTime);
+
+		tbb::spin_mutex::scoped_lock lock(gConsumerMutex);
+		gConsumerThreadId = GetCurrentThreadId();
+		drainMessages();
+		gConsumerThreadId = 0;
+	}
+}
 
-			written += sprintf_s(formatBuffer + written, bufferSize - written,
-				"0x%04X", threadId);
+LONG WINAPI bsLog::unhandledExceptionFilter(EXCEPTION_POINTERS* exceptionInfo)
+{
+	/*	The process is about to die, write whatever is in the queue. If the writer
+		thread is holding the consumer lock (possibly because it is the one crashing),
+		give up on waiting for it after a while and write anyway.
+	*/
+	tbb::spin_mutex::scoped_lock lock;
+	bool locked = false;
+	for (unsigned int i = 0; i < 100 && !locked; ++i)
+	{
+		locked = lock.try_acquire(gConsumerMutex);
+		if (!locked)
+		{
+			Sleep(1);
 		}
+	}
 
-		formatBuffer[written] = ']';
-		formatBuffer[written + 1] = ' ';
-		formatBuffer[written + 2] = '\0';
+	if (mMessages)
+	{
+		drainMessages(false);
 	}
 
-	//Print the actual message.
-	fprintf(mFile, "%s%s\n", formatBuffer, message);
+	return gPreviousExceptionFilter ? gPreviousExceptionFilter(exceptionInfo)
+		: EXCEPTION_CONTINUE_SEARCH;
+}
 
-	//Flush immediately, don't want to lose unflushed data if the program crashes.
-	fflush(mFile);
+void bsLog::log(const char* message, Severity severity /*= INFO*/,
+	Channel channel /*= CHANNEL_GENERAL*/)
+{
+	//Only log the message if severity is over current severity level.
+	if (!isEnabled(channel, severity))
+	{
+		return;
+	}
 
+	Message* queuedMessage = claimMessage(channel, severity);
+	if (!queuedMessage)
+	{
+		//Dropped.
+		return;
+	}
 
-	//Call registered callback functions.
-	for (unsigned int i = 0; i < mCallbacks.size(); ++i)
+	const size_t length = strlen(message);
+	if (length < kInlineMessageSize)
+	{
+		memcpy(queuedMessage->data, message, length + 1);
+	}
+	else
 	{
-		mCallbacks[i](message);
+		queuedMessage->longData = static_cast<char*>(malloc(length + 1));
+		memcpy(queuedMessage->longData, message, length + 1);
 	}
+
+	commitMessage(queuedMessage);
 }
 
 void bsLog::logf(Severity severity, const char* format, ...)
 {
 	//Only log the message if severity is over current severity level.
-	if (severity < getMinSeverity())
+	if (!isEnabled(CHANNEL_GENERAL, severity))
 	{
 		return;
 	}
@@ -178,15 +576,79 @@ void bsLog::logf(Severity severity, const char* format, ...)
 	va_list args;
 	va_start(args, format);
 
-	char buffer[kTempBufferSize];
+	logArguments(CHANNEL_GENERAL, severity, format, args);
 
-	//Write args into buffer.
-	vsprintf_s(buffer, format, args);
+	va_end(args);
+}
+
+void bsLog::logf(Channel channel, Severity severity, const char* format, ...)
+{
+	//Only log the message if severity is over current severity level.
+	if (!isEnabled(channel, severity))
+	{
+		return;
+	}
+
+	//Get ... args.
+	va_list args;
+	va_start(args, format);
+
+	logArguments(channel, severity, format, args);
 
 	va_end(args);
-	
-	//Log the formatted message through the normal log function.
-	log(buffer, severity);
+}
+
+void bsLog::logArguments(Channel channel, Severity severity, const char* format,
+	va_list args)
+{
+	Message* queuedMessage = claimMessage(channel, severity);
+	if (!queuedMessage)
+	{
+		//Dropped.
+		return;
+	}
+
+	//Copy the raw arguments, formatting is done by the consumer.
+	//Every pass reads its own copy of args, a va_list can't be read again once consumed.
+	va_list argumentsCopy;
+	va_copy(argumentsCopy, args);
+	const int argumentsSize = bsLogFormat::captureArguments(format, argumentsCopy,
+		queuedMessage->data, kInlineMessageSize);
+	va_end(argumentsCopy);
+
+	if (argumentsSize > static_cast<int>(kInlineMessageSize))
+	{
+		//Too large to store inline, capture again into a heap buffer.
+		queuedMessage->longData = static_cast<char*>(malloc(argumentsSize));
+
+		va_copy(argumentsCopy, args);
+		bsLogFormat::captureArguments(format, argumentsCopy, queuedMessage->longData,
+			argumentsSize);
+		va_end(argumentsCopy);
+	}
+
+	if (argumentsSize >= 0)
+	{
+		queuedMessage->format = format;
+		queuedMessage->argumentsSize = argumentsSize;
+	}
+	else
+	{
+		//Can't be captured, format immediately.
+		char buffer[kTempBufferSize];
+		vsprintf_s(buffer, format, args);
+
+		const size_t length = strlen(buffer);
+		char* destination = queuedMessage->data;
+		if (length >= kInlineMessageSize)
+		{
+			queuedMessage->longData = static_cast<char*>(malloc(length + 1));
+			destination = queuedMessage->longData;
+		}
+		memcpy(destination, buffer, length + 1);
+	}
+
+	commitMessage(queuedMessage);
 }
 
 
@@ -2,6 +2,10 @@
 
 #include <vector>
 #include <functional>
+#include <stdarg.h>
+#include <stdio.h>
+
+#include <Windows.h>
 
 
 #ifndef BS_DISABLE_FEATURE_LOGGING
@@ -9,6 +13,22 @@
 
 /*	Class for logging messages with severity levels to a file.
 	Multiple instances of this class is not supported.
+
+	Logging is asynchronous. Messages are copied into a lock-free ring buffer and the
+	calling thread returns immediately, while a background thread formats the messages,
+	writes them to the file in batches and calls the registered callbacks.
+
+	If the ring buffer is full, messages below SEV_ERROR are dropped (and counted), while
+	errors wait a short while for space before being dropped.
+	Call flush to make sure everything logged so far has been written. This is done
+	automatically for unhandled exceptions and failed assertions.
+
+	logf does not format messages when they are logged. It only copies the format string
+	pointer and the raw arguments, and formatting is done by the background thread. The
+	format string must therefore be a string literal (or otherwise outlive the log).
+	With the BINARY_OUTPUT flag, messages are not formatted at all unless there are
+	callbacks, and the file contains the raw arguments. Use tools/bsLogDecoder to convert
+	it to text.
 */
 class bsLog
 {
@@ -21,6 +41,15 @@ public:
 	*/
 	static const unsigned int kTempBufferSize = 5 * 1024;
 
+	/*	Maximum number of messages waiting to be written. Must be a power of two.
+	*/
+	static const unsigned int kQueueCapacity = 4096;
+
+	/*	Messages shorter than this are stored directly in the ring buffer, longer messages
+		require a heap allocation.
+	*/
+	static const unsigned int kInlineMessageSize = 232;
+
 	/*	The severity of a log message.
 		When updating this, also update mSeverityStrings in the .cpp file.
 	*/
@@ -46,6 +75,31 @@ public:
 		SEVERITY_COUNT = 5,
 	};
 
+	/*	The subsystem a message was logged from. Every channel has its own minimum severity
+		level in addition to the global one.
+		When updating this, also update mChannelStrings in the .cpp file.
+	*/
+	enum Channel
+	{
+		//Messages which don't belong to any particular subsystem.
+		CHANNEL_GENERAL = 0,
+
+		//Rendering and Direct3D.
+		CHANNEL_RENDER = 1,
+
+		//File system and file loading.
+		CHANNEL_IO = 2,
+
+		//Havok and collision.
+		CHANNEL_PHYSICS = 3,
+
+		//Resource caches (meshes, textures, materials, shaders, text).
+		CHANNEL_RESOURCES = 4,
+
+		//Don't use. Used for determining array size of channel to string mapping.
+		CHANNEL_COUNT = 5,
+	};
+
 	/*	Flags for configuring string formatting.
 		Any flags that are not specified will default to disabled.
 		These can be combined used bit operators.
@@ -70,6 +124,12 @@ public:
 
 		//Does not close the file provided in the constructor upon destruction of this object.
 		DONT_CLOSE_FILE = 1 << 6,
+
+		/*	Writes messages in the binary format described in bsLogFormat.h instead of
+			text. The file must be opened in binary mode. The other formatting flags are
+			stored in the file and applied when decoding.
+		*/
+		BINARY_OUTPUT = 1 << 7,
 	};
 
 
@@ -78,15 +138,31 @@ public:
 		minSeverity represents the minimum severity of messages to log to the file.
 		flags represents options used for formatting timestamps and similar.
 
+		Starts the background thread writing messages, and installs an unhandled exception
+		filter which flushes the log.
+
 		This function is NOT thread safe.
 	*/
 	static void init(FILE* file, Severity minSeverity = SEV_DEBUG, unsigned char flags = 0);
 
-	/*	Call this function when done logging messages. It will close the file (unless 
-		the DONT_CLOSE_FILE flag has been specified).
+	/*	Call this function when done logging messages. It will write any remaining
+		messages and close the file (unless the DONT_CLOSE_FILE flag has been specified).
 	*/
 	static void deinit();
 
+	/*	Blocks until every message logged before the call has been written to the file and
+		passed to the callbacks, and flushes the file.
+		Does nothing when called from a callback, since messages are already being
+		written by the calling thread.
+
+		This function is thread safe.
+	*/
+	static void flush();
+
+	/*	Returns the number of messages dropped because the ring buffer was full.
+	*/
+	static unsigned int getDroppedMessageCount();
+
 
 	/*	Logs a message to file with the specified severity level.
 		
@@ -96,14 +172,15 @@ public:
 		Also sends the message to all callback functions registered with the addCallback
 		function.
 
-		This function is thread safe.
+		This function is thread safe, and does not wait for the message to be written.
 	*/
-	static void log(const char* message, Severity severity = SEV_INFO);
+	static void log(const char* message, Severity severity = SEV_INFO,
+		Channel channel = CHANNEL_GENERAL);
 
 	/*	Logs a formatted message to file with the specified severity level.
 		This function supports printf-style logging, using the exact same syntax as printf.
-		Keep in mind that a buff is stack allocated whenever this function is called, with
-		size equal kTempBufferSize, so very long messages may need to be formatted externally.
+		Formatting is deferred to the background thread, format must be a string literal.
+		Formatted messages are truncated to kTempBufferSize characters.
 
 		If the specified severity level is below the current minimum severity level, the
 		message is ignored.
@@ -115,6 +192,11 @@ public:
 	*/
 	static void logf(Severity severity, const char* format, ...);
 
+	/*	Same as above, but logs to a specific channel. Prefer using the BS_LOG_ macros,
+		which also filter out messages at compile time.
+	*/
+	static void logf(Channel channel, Severity severity, const char* format, ...);
+
 
 
 	/*	Get currently active flags (from Flags enum).
@@ -152,20 +234,79 @@ public:
 		mMinSevAndFlags = ((mMinSevAndFlags & 0xFFF) | (unsigned short)(severity << 12));
 	}
 
+	/*	Get the minimum severity level of a channel.
+		Messages to the channel are ignored if they are below either this or the global
+		minimum severity level.
+	*/
+	static inline Severity getChannelMinSeverity(Channel channel)
+	{
+		return (Severity)mChannelMinSeverities[channel];
+	}
 
-	/*	Adds a callback function which will receive every message logged.
+	/*	Set minimum severity level required for messages to a channel to be logged.
+		All channels default to SEV_DEBUG, leaving filtering to the global level.
+
+		This function is thread safe, but messages logged by other threads at the same time
+		may be filtered with the previous level.
 	*/
-	static inline void addCallback(const std::function<void(const char*)>& func)
+	static inline void setChannelMinSeverity(Channel channel, Severity severity)
 	{
-		mCallbacks.push_back(func);
+		mChannelMinSeverities[channel] = (unsigned char)severity;
 	}
 
-	static inline void clearAllCallbacks()
+	/*	Returns true if a message with the given severity to the given channel would be
+		logged. Useful for skipping expensive work done only to produce a message.
+	*/
+	static inline bool isEnabled(Channel channel, Severity severity)
 	{
-		mCallbacks.clear();
+		return severity >= getMinSeverity() && severity >= mChannelMinSeverities[channel];
 	}
 
+
+	/*	Adds a callback function which will receive every message logged.
+		Callbacks are called from the background thread (or a thread calling flush), so
+		they must be thread safe.
+	*/
+	static void addCallback(const std::function<void(const char*)>& func);
+
+	/*	Removes all callbacks, after first flushing any messages waiting to be passed to
+		them.
+	*/
+	static void clearAllCallbacks();
+
 private:
+	//An entry in the ring buffer.
+	struct Message;
+
+	/*	Reserves a message in the ring buffer.
+		Returns null if the message was dropped.
+	*/
+	static Message* claimMessage(Channel channel, Severity severity);
+
+	//Captures or formats the arguments of logf and queues the message.
+	static void logArguments(Channel channel, Severity severity, const char* format,
+		va_list args);
+
+	//Makes a claimed message visible to the background thread.
+	static void commitMessage(Message* message);
+
+	/*	Writes and removes all committed messages from the ring buffer.
+		Must only be called while holding the consumer lock.
+		Callbacks are skipped if invokeCallbacks is false, used when the process is
+		crashing and a callback may be what crashed.
+	*/
+	static void drainMessages(bool invokeCallbacks = true);
+
+	/*	Writes a message to the write buffer in the binary format, preceded by its format
+		string if this is the first message using it.
+	*/
+	static void writeBinaryMessage(const Message& message, const char* data);
+
+	static void writerThreadLoop();
+
+	static LONG WINAPI unhandledExceptionFilter(EXCEPTION_POINTERS* exceptionInfo);
+
+
 	//Non-copyable.
 	bsLog(const bsLog&);
 	void operator=(const bsLog&);
@@ -180,7 +321,16 @@ private:
 	//Text versions of Severity enum.
 	static const char* mSeverityStrings[SEVERITY_COUNT];
 
+	//Text versions of Channel enum, written before messages. Empty for CHANNEL_GENERAL.
+	static const char* mChannelStrings[CHANNEL_COUNT];
+
+	//Severity for every channel.
+	static unsigned char mChannelMinSeverities[CHANNEL_COUNT];
+
 	static std::vector<std::function<void(const char*)>>	mCallbacks;
+
+	//Ring buffer of kQueueCapacity messages, allocated in init.
+	static Message*	mMessages;
 };
 
 #else // BS_DISABLE_FEATURE_LOGGING
@@ -199,6 +349,16 @@ public:
 		SEVERITY_COUNT = 5,
 	};
 
+	enum Channel
+	{
+		CHANNEL_GENERAL = 0,
+		CHANNEL_RENDER = 1,
+		CHANNEL_IO = 2,
+		CHANNEL_PHYSICS = 3,
+		CHANNEL_RESOURCES = 4,
+		CHANNEL_COUNT = 5,
+	};
+
 	enum Flags
 	{
 		DATE_ENABLED = 1 << 0,
@@ -208,6 +368,7 @@ public:
 		SEVERITY_AS_INT = 1 << 4,
 		THREAD_ID_ENABLED = 1 << 5,
 		DONT_CLOSE_FILE = 1 << 6,
+		BINARY_OUTPUT = 1 << 7,
 	};
 
 
@@ -217,12 +378,23 @@ public:
 	static void deinit()
 	{}
 
+	static void flush()
+	{}
+
+	static unsigned int getDroppedMessageCount()
+	{
+		return 0;
+	}
+
 	static void logMessage(const char*, Severity = SEV_INFO)
 	{}
 
 	static void logf(Severity, const char*, ...)
 	{}
 
+	static void logf(Channel, Severity, const char*, ...)
+	{}
+
 	static inline unsigned short getFlags()
 	{}
 
@@ -235,12 +407,94 @@ public:
 	static inline void setMinSeverity(Severity)
 	{}
 
+	static inline Severity getChannelMinSeverity(Channel)
+	{
+		return SEV_DEBUG;
+	}
+
+	static inline void setChannelMinSeverity(Channel, Severity)
+	{}
+
+	static inline bool isEnabled(Channel, Severity)
+	{
+		return false;
+	}
+
 	static inline void addCallback(const std::function<void(const char*)>&)
 	{}
 
+	static inline void clearAllCallbacks()
+	{}
+
 private:
 	//Non-copyable
 	bsLog(const bsLog&);
 	void operator=(const bsLog&);
 };
 #endif // BS_DISABLE_LOGGING
+
+
+/*	Logging macros with compile-time filtering.
+
+	Usage: BS_LOG_INFO(IO, "Loaded '%s'", fileName);
+	where the first parameter is a bsLog::Channel without the CHANNEL_ prefix.
+
+	Messages with a severity below BS_LOG_MIN_SEVERITY are removed by the preprocessor,
+	arguments included, so they cost nothing. BS_LOG_MIN_SEVERITY uses the values of
+	bsLog::Severity (0 = debug, 4 = critical), and defaults to debug in debug builds and
+	info otherwise. Messages which are compiled in are also checked against the global and
+	channel severity levels at runtime before any arguments are evaluated.
+*/
+#ifdef BS_DISABLE_FEATURE_LOGGING
+#undef BS_LOG_MIN_SEVERITY
+#define BS_LOG_MIN_SEVERITY 5
+#endif // BS_DISABLE_FEATURE_LOGGING
+
+#ifndef BS_LOG_MIN_SEVERITY
+#ifdef BS_DEBUG
+#define BS_LOG_MIN_SEVERITY 0
+#else
+#define BS_LOG_MIN_SEVERITY 1
+#endif // BS_DEBUG
+#endif // BS_LOG_MIN_SEVERITY
+
+#define BS_LOG_IMPL(channel, severity, ...)												 \
+do																						 \
+{																						 \
+	if (bsLog::isEnabled(bsLog::CHANNEL_##channel, severity))							 \
+	{																					 \
+		bsLog::logf(bsLog::CHANNEL_##channel, severity, __VA_ARGS__);					 \
+	}																					 \
+} while (false)
+
+#define BS_LOG_DISABLED() do {} while (false)
+
+#if BS_LOG_MIN_SEVERITY <= 0
+#define BS_LOG_DEBUG(channel, ...) BS_LOG_IMPL(channel, bsLog::SEV_DEBUG, __VA_ARGS__)
+#else
+#define BS_LOG_DEBUG(channel, ...) BS_LOG_DISABLED()
+#endif
+
+#if BS_LOG_MIN_SEVERITY <= 1
+#define BS_LOG_INFO(channel, ...) BS_LOG_IMPL(channel, bsLog::SEV_INFO, __VA_ARGS__)
+#else
+#define BS_LOG_INFO(channel, ...) BS_LOG_DISABLED()
+#endif
+
+#if BS_LOG_MIN_SEVERITY <= 2
+#define BS_LOG_WARNING(channel, ...) BS_LOG_IMPL(channel, bsLog::SEV_WARNING, __VA_ARGS__)
+#else
+#define BS_LOG_WARNING(channel, ...) BS_LOG_DISABLED()
+#endif
+
+#if BS_LOG_MIN_SEVERITY <= 3
+#define BS_LOG_ERROR(channel, ...) BS_LOG_IMPL(channel, bsLog::SEV_ERROR, __VA_ARGS__)
+#else
+#define BS_LOG_ERROR(channel, ...) BS_LOG_DISABLED()
+#endif
+
+#if BS_LOG_MIN_SEVERITY <= 4
+#define BS_LOG_CRITICAL(channel, ...) BS_LOG_IMPL(channel, bsLog::SEV_CRICICAL, __VA_ARGS__)
+#else
+#define BS_LOG_CRITICAL(channel, ...) BS_LOG_DISABLED()
+#endif
@@ -0,0 +1,551 @@
+#ifndef BS_LOG_FORMAT_EXTERNAL
+#include "StdAfx.h"
+#endif
+
+#include "bsLogFormat.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bsLog.h"
+
+
+namespace
+{
+enum ArgumentType
+{
+	//%%, consumes no arguments.
+	ARG_NONE,
+	ARG_INT,
+	ARG_INT64,
+	ARG_DOUBLE,
+	ARG_POINTER,
+	ARG_STRING,
+	ARG_UNSUPPORTED,
+};
+
+//A single conversion specification in a format string, like "%-8.3f".
+struct Specification
+{
+	//Points to the '%'.
+	const char*		begin;
+	//Points one past the conversion character.
+	const char*		end;
+
+	//Number of '*' widths/precisions, each consuming an int argument.
+	unsigned int	starCount;
+
+	ArgumentType	type;
+};
+
+//format must point to a '%'.
+void parseSpecification(const char* format, Specification& specification)
+{
+	specification.begin = format;
+	specification.starCount = 0;
+
+	++format;
+
+	if (*format == '%')
+	{
+		specification.end = format + 1;
+		specification.type = ARG_NONE;
+		return;
+	}
+
+	//Flags.
+	while (*format == '-' || *format == '+' || *format == ' ' || *format == '#'
+		|| *format == '0')
+	{
+		++format;
+	}
+
+	//Width.
+	if (*format == '*')
+	{
+		++specification.starCount;
+		++format;
+	}
+	else
+	{
+		while (*format >= '0' && *format <= '9')
+		{
+			++format;
+		}
+	}
+
+	//Precision.
+	if (*format == '.')
+	{
+		++format;
+
+		if (*format == '*')
+		{
+			++specification.starCount;
+			++format;
+		}
+		else
+		{
+			while (*format >= '0' && *format <= '9')
+			{
+				++format;
+			}
+		}
+	}
+
+	//Length modifiers. long is 32 bits, and long double is the same as double.
+	bool is64Bit = false;
+	bool isWide = false;
+	if (format[0] == 'l' && format[1] == 'l')
+	{
+		is64Bit = true;
+		format += 2;
+	}
+	else if (format[0] == 'I' && format[1] == '6' && format[2] == '4')
+	{
+		is64Bit = true;
+		format += 3;
+	}
+	else if (format[0] == 'I' && format[1] == '3' && format[2] == '2')
+	{
+		format += 3;
+	}
+	else if (format[0] == 'I')
+	{
+		is64Bit = sizeof(void*) == 8;
+		++format;
+	}
+	else if (format[0] == 'h')
+	{
+		++format;
+		if (*format == 'h')
+		{
+			++format;
+		}
+	}
+	else if (format[0] == 'l' || format[0] == 'w')
+	{
+		isWide = true;
+		++format;
+	}
+	else if (format[0] == 'L')
+	{
+		++format;
+	}
+
+	switch (*format)
+	{
+	case 'd':
+	case 'i':
+	case 'u':
+	case 'x':
+	case 'X':
+	case 'o':
+		specification.type = is64Bit ? ARG_INT64 : ARG_INT;
+		break;
+
+	case 'c':
+	case 'C':
+		//Characters (wide or not) are promoted to int.
+		specification.type = ARG_INT;
+		break;
+
+	case 'e':
+	case 'E':
+	case 'f':
+	case 'g':
+	case 'G':
+	case 'a':
+	case 'A':
+		specification.type = ARG_DOUBLE;
+		break;
+
+	case 'p':
+		specification.type = ARG_POINTER;
+		break;
+
+	case 's':
+		specification.type = isWide ? ARG_UNSUPPORTED : ARG_STRING;
+		break;
+
+	default:
+		//%n, %S and malformed specifications.
+		specification.type = ARG_UNSUPPORTED;
+		break;
+	}
+
+	specification.end = *format ? format + 1 : format;
+}
+
+inline void appendArgument(char* buffer, size_t bufferSize, size_t& written,
+	const void* data, size_t size)
+{
+	if (written + size <= bufferSize)
+	{
+		memcpy(buffer + written, data, size);
+	}
+
+	written += size;
+}
+
+//Returns false if there is not enough data left.
+inline bool readArgument(const char* arguments, size_t argumentsSize, size_t& read,
+	void* data, size_t size)
+{
+	if (read + size > argumentsSize)
+	{
+		return false;
+	}
+
+	memcpy(data, arguments + read, size);
+	read += size;
+
+	return true;
+}
+
+//Formats a single value with a specification which may contain up to two '*'.
+template <typename T>
+int formatValue(char* buffer, size_t bufferSize, const char* specification,
+	unsigned int starCount, const int* stars, T value)
+{
+	switch (starCount)
+	{
+	case 0:
+		return _snprintf_s(buffer, bufferSize, _TRUNCATE, specification, value);
+
+	case 1:
+		return _snprintf_s(buffer, bufferSize, _TRUNCATE, specification, stars[0], value);
+
+	default:
+		return _snprintf_s(buffer, bufferSize, _TRUNCATE, specification, stars[0], stars[1],
+			value);
+	}
+}
+}
+
+
+int bsLogFormat::captureArguments(const char* format, va_list args, char* buffer,
+	size_t bufferSize)
+{
+	size_t written = 0;
+
+	const char* current = format;
+	while (*current)
+	{
+		if (*current != '%')
+		{
+			++current;
+			continue;
+		}
+
+		Specification specification;
+		parseSpecification(current, specification);
+		current = specification.end;
+
+		if (specification.type == ARG_UNSUPPORTED)
+		{
+			return -1;
+		}
+
+		for (unsigned int i = 0; i < specification.starCount; ++i)
+		{
+			const int star = va_arg(args, int);
+			appendArgument(buffer, bufferSize, written, &star, sizeof(star));
+		}
+
+		switch (specification.type)
+		{
+		case ARG_INT:
+			{
+				const int value = va_arg(args, int);
+				appendArgument(buffer, bufferSize, written, &value, sizeof(value));
+			}
+			break;
+
+		case ARG_INT64:
+			{
+				const long long value = va_arg(args, long long);
+				appendArgument(buffer, bufferSize, written, &value, sizeof(value));
+			}
+			break;
+
+		case ARG_DOUBLE:
+			{
+				const double value = va_arg(args, double);
+				appendArgument(buffer, bufferSize, written, &value, sizeof(value));
+			}
+			break;
+
+		case ARG_POINTER:
+			{
+				const unsigned long long value = reinterpret_cast<size_t>(va_arg(args, void*));
+				appendArgument(buffer, bufferSize, written, &value, sizeof(value));
+			}
+			break;
+
+		case ARG_STRING:
+			{
+				const char* value = va_arg(args, const char*);
+				if (!value)
+				{
+					value = "(null)";
+				}
+				appendArgument(buffer, bufferSize, written, value, strlen(value) + 1);
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	return static_cast<int>(written);
+}
+
+size_t bsLogFormat::formatArguments(const char* format, const char* arguments,
+	size_t argumentsSize, char* buffer, size_t bufferSize)
+{
+	if (bufferSize == 0)
+	{
+		return 0;
+	}
+
+	size_t written = 0;
+	size_t read = 0;
+
+	//Every specification is copied here so it can be used as a format string on its own.
+	char specificationBuffer[64];
+
+	const char* current = format;
+	while (*current && written + 1 < bufferSize)
+	{
+		if (*current != '%')
+		{
+			buffer[written++] = *current++;
+			continue;
+		}
+
+		Specification specification;
+		parseSpecification(current, specification);
+		current = specification.end;
+
+		if (specification.type == ARG_NONE)
+		{
+			buffer[written++] = '%';
+			continue;
+		}
+
+		const size_t specificationLength = specification.end - specification.begin;
+		if (specification.type == ARG_UNSUPPORTED
+			|| specificationLength >= sizeof(specificationBuffer))
+		{
+			break;
+		}
+		memcpy(specificationBuffer, specification.begin, specificationLength);
+		specificationBuffer[specificationLength] = '\0';
+
+		int stars[2];
+		bool validArguments = true;
+		for (unsigned int i = 0; i < specification.starCount; ++i)
+		{
+			validArguments &= readArgument(arguments, argumentsSize, read, &stars[i],
+				sizeof(stars[i]));
+		}
+
+		char* output = buffer + written;
+		const size_t outputSize = bufferSize - written;
+		int result = 0;
+
+		switch (specification.type)
+		{
+		case ARG_INT:
+			{
+				int value;
+				validArguments &= readArgument(arguments, argumentsSize, read, &value,
+					sizeof(value));
+				if (validArguments)
+				{
+					result = formatValue(output, outputSize, specificationBuffer,
+						specification.starCount, stars, value);
+				}
+			}
+			break;
+
+		case ARG_INT64:
+			{
+				long long value;
+				validArguments &= readArgument(arguments, argumentsSize, read, &value,
+					sizeof(value));
+				if (validArguments)
+				{
+					result = formatValue(output, outputSize, specificationBuffer,
+						specification.starCount, stars, value);
+				}
+			}
+			break;
+
+		case ARG_DOUBLE:
+			{
+				double value;
+				validArguments &= readArgument(arguments, argumentsSize, read, &value,
+					sizeof(value));
+				if (validArguments)
+				{
+					result = formatValue(output, outputSize, specificationBuffer,
+						specification.starCount, stars, value);
+				}
+			}
+			break;
+
+		case ARG_POINTER:
+			{
+				unsigned long long value;
+				validArguments &= readArgument(arguments, argumentsSize, read, &value,
+					sizeof(value));
+				if (validArguments)
+				{
+					result = formatValue(output, outputSize, specificationBuffer,
+						specification.starCount, stars,
+						reinterpret_cast<void*>(static_cast<size_t>(value)));
+				}
+			}
+			break;
+
+		case ARG_STRING:
+			{
+				const char* value = arguments + read;
+				const void* terminator = read < argumentsSize
+					? memchr(value, '\0', argumentsSize - read) : nullptr;
+				validArguments &= terminator != nullptr;
+				if (validArguments)
+				{
+					read += static_cast<const char*>(terminator) - value + 1;
+					result = formatValue(output, outputSize, specificationBuffer,
+						specification.starCount, stars, value);
+				}
+			}
+			break;
+
+		default:
+			break;
+		}
+
+		if (!validArguments)
+		{
+			//Corrupt or truncated arguments.
+			break;
+		}
+
+		if (result < 0)
+		{
+			//Output was truncated.
+			written = bufferSize - 1;
+			break;
+		}
+
+		written += result;
+	}
+
+	buffer[written] = '\0';
+
+	return written;
+}
+
+void bsLogFormat::formatPrefix(unsigned short flags, unsigned int severity,
+	const char* severityText, unsigned long threadId, const FILETIME& time, char* buffer,
+	size_t bufferSize)
+{
+	buffer[0] = '\0';
+
+	//True if any extra formatting is enabled. Will need [] and something between the two.
+	const bool startEndBrace = (flags & (bsLog::TIMESTAMP_SECS | bsLog::TIMESTAMP_MILLISECS
+		| bsLog::DATE_ENABLED | bsLog::SEVERITY_AS_TEXT | bsLog::SEVERITY_AS_INT
+		| bsLog::THREAD_ID_ENABLED)) != 0;
+
+	if (!startEndBrace)
+	{
+		return;
+	}
+
+	//Characters written to buffer.
+	size_t written = 0;
+
+	buffer[0] = '[';
+	++written;
+
+	//Convert the time the message was logged so we can provide a timestamp.
+	FILETIME localFileTime;
+	SYSTEMTIME localTime;
+	FileTimeToLocalFileTime(&time, &localFileTime);
+	FileTimeToSystemTime(&localFileTime, &localTime);
+
+	//Date.
+	if (flags & bsLog::DATE_ENABLED)
+	{
+		written += sprintf_s(buffer + written, bufferSize - written,
+			"%04u/%02u/%02u", localTime.wYear, localTime.wMonth, localTime.wDay);
+	}
+
+	//Time (HH:MM:SS).
+	if (flags & (bsLog::TIMESTAMP_SECS | bsLog::TIMESTAMP_MILLISECS))
+	{
+		if (written != 1)
+		{
+			//Date has been written, need a comma.
+			buffer[written] = ',';
+			buffer[written + 1] = ' ';
+			written += 2;
+		}
+
+		written += sprintf_s(buffer + written, bufferSize - written,
+			"%02u:%02u:%02u", localTime.wHour, localTime.wMinute, localTime.wSecond);
+	}
+	//Milliseconds.
+	if (flags & bsLog::TIMESTAMP_MILLISECS)
+	{
+		written += sprintf_s(buffer + written, bufferSize - written,
+			":%03u", localTime.wMilliseconds);
+	}
+
+	//Severity level.
+	if (flags & bsLog::SEVERITY_AS_TEXT)
+	{
+		if (written != 1)
+		{
+			//Date or time has been written, need a comma.
+			buffer[written] = ',';
+			buffer[written + 1] = ' ';
+			written += 2;
+		}
+		written += sprintf_s(buffer + written, bufferSize - written, "%s", severityText);
+	}
+	else if (flags & bsLog::SEVERITY_AS_INT)
+	{
+		if (written != 1)
+		{
+			//Date or time has been written, need a comma.
+			buffer[written] = ',';
+			buffer[written + 1] = ' ';
+			written += 2;
+		}
+		written += sprintf_s(buffer + written, bufferSize - written, "%u", severity);
+	}
+
+	//Thread ID.
+	if (flags & bsLog::THREAD_ID_ENABLED)
+	{
+		if (written != 1)
+		{
+			//Something has been written, need a comma.
+			buffer[written] = ',';
+			buffer[written + 1] = ' ';
+			written += 2;
+		}
+
+		written += sprintf_s(buffer + written, bufferSize - written, "0x%04X", threadId);
+	}
+
+	buffer[written] = ']';
+	buffer[written + 1] = ' ';
+	buffer[written + 2] = '\0';
+}
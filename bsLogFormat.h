@@ -0,0 +1,120 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+
+#include <Windows.h>
+
+
+/*	Functions for deferred formatting of printf-style log messages, shared between bsLog
+	and the log decoder tool.
+
+	Instead of formatting a message when it is logged, the raw arguments are captured into
+	a buffer together with the format string, and formatted later by the log writer thread
+	or offline when decoding a binary log.
+
+	Captured argument layout, in the order the format string consumes them:
+	Integers (d, i, u, x, X, o, c, and * widths/precisions): 4 bytes, or 8 bytes with the
+		ll/I64 length modifiers.
+	Floating point (f, e, g, a and upper case variants): 8 byte double.
+	Pointers (p): 8 bytes, regardless of platform.
+	Strings (s): The characters including the null terminator.
+
+	Values are stored unaligned in native (little endian) byte order.
+*/
+namespace bsLogFormat
+{
+/*	Binary log layout (bsLog::BINARY_OUTPUT), all values are little endian:
+
+Byte		Description
+1-4			File format identification, "bslg" (chars).
+5-8			Version information (uint).
+9-10		bsLog::Flags active when the log was written (ushort), used by the decoder to
+				format message prefixes the same way a text log would.
+11-12		Unused.
+
+13-...		Records. Every record starts with a one byte RecordType, followed by:
+
+RECORD_FORMAT:	BinaryFormatRecord, then the format string (not null terminated).
+				Written the first time a format string is used, before any messages using it.
+RECORD_MESSAGE:	BinaryMessageRecord, then the captured arguments.
+RECORD_DROPPED:	BinaryDroppedRecord.
+*/
+
+/*	Version info is stored in the header, and must be equal to this value when decoding.
+
+	Version history:
+	0: Initial version.
+	1: Added channel to message records.
+*/
+const unsigned int kBinaryLogVersion = 1;
+
+//Format ID of messages logged with bsLog::log, their arguments are the null terminated text.
+const unsigned int kPlainTextFormatId = 0xFFFFFFFF;
+
+enum RecordType
+{
+	RECORD_FORMAT = 0,
+	RECORD_MESSAGE = 1,
+	RECORD_DROPPED = 2,
+};
+
+#pragma pack(push, 1)
+struct BinaryLogHeader
+{
+	char			magic[4];
+	unsigned int	version;
+	unsigned short	flags;
+	unsigned short	unused;
+};
+
+struct BinaryFormatRecord
+{
+	unsigned int	formatId;
+	unsigned int	length;
+};
+
+struct BinaryMessageRecord
+{
+	unsigned int		formatId;
+	unsigned char		severity;
+	//bsLog::Channel.
+	unsigned char		channel;
+	unsigned int		threadId;
+	//UTC FILETIME.
+	unsigned long long	time;
+	unsigned int		argumentsSize;
+};
+
+struct BinaryDroppedRecord
+{
+	unsigned int	count;
+};
+#pragma pack(pop)
+
+
+/*	Copies the arguments consumed by format into buffer.
+	Returns the number of bytes needed to hold all arguments. Nothing is written past
+	bufferSize, so if the return value is larger than bufferSize, call again with a buffer
+	of at least that size.
+	Returns -1 if format uses features which can not be captured (%n, wide strings), in
+	which case the message must be formatted immediately.
+*/
+int captureArguments(const char* format, va_list args, char* buffer, size_t bufferSize);
+
+/*	Formats captured arguments according to format, like vsprintf_s would have done with
+	the original arguments.
+	Output longer than bufferSize - 1 characters is truncated. Returns the number of
+	characters written, not counting the null terminator.
+*/
+size_t formatArguments(const char* format, const char* arguments, size_t argumentsSize,
+	char* buffer, size_t bufferSize);
+
+/*	Formats the "[date, time, severity, thread] " prefix of a log message.
+	flags are bsLog::Flags, severityText is the severity as text, used if
+	bsLog::SEVERITY_AS_TEXT is enabled. time is UTC and is converted to local time.
+	Writes an empty string if no prefix is enabled by flags.
+*/
+void formatPrefix(unsigned short flags, unsigned int severity, const char* severityText,
+	unsigned long threadId, const FILETIME& time, char* buffer, size_t bufferSize);
+}
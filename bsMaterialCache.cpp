@@ -4,6 +4,7 @@
 #include "bsMaterial.h"
 #include "bsAssert.h"
 #include "bsLog.h"
+#include "bsMemoryTracker.h"
 
 
 bsMaterialCache::bsMaterialCache()
@@ -20,7 +21,7 @@ bsMaterialCache::~bsMaterialCache()
 	{
 		if (!itr->second.unique())
 		{
-			bsLog::logf(bsLog::SEV_WARNING, "All references to texture '%s' have not"
+			BS_LOG_WARNING(RESOURCES, "All references to texture '%s' have not"
 				" been released when bsTextureCache is being destroyed (%u external refs)",
 				itr->first.c_str(), itr->second.use_count() - 1);
 		}
@@ -28,7 +29,7 @@ bsMaterialCache::~bsMaterialCache()
 #endif //ifdef BS_DEBUG
 }
 
-std::shared_ptr<bsMaterial> bsMaterialCache::getMaterial(const std::string& materialName)
+std::shared_ptr<bsMaterial> bsMaterialCache::getMaterial(const bsStringId& materialName)
 {
 	auto itr = mMaterials.find(materialName);
 	if (itr != std::end(mMaterials))
@@ -38,7 +39,7 @@ std::shared_ptr<bsMaterial> bsMaterialCache::getMaterial(const std::string& mate
 	}
 
 	//Didn't find it, log an error message.
-	bsLog::logf(bsLog::SEV_ERROR, "The requested material '%s' does not exist",
+	BS_LOG_ERROR(RESOURCES, "The requested material '%s' does not exist",
 		materialName.c_str());
 	
 	BS_ASSERT2(false, "Failed to find material");
@@ -46,15 +47,17 @@ std::shared_ptr<bsMaterial> bsMaterialCache::getMaterial(const std::string& mate
 	return nullptr;
 }
 
-std::shared_ptr<bsMaterial> bsMaterialCache::createNewMaterial(const std::string& materialName)
+std::shared_ptr<bsMaterial> bsMaterialCache::createNewMaterial(const bsStringId& materialName)
 {
+	bsMemoryTagScope memoryTag(bsMemoryTracker::TAG_RESOURCES);
+
 	auto itr = mMaterials.find(materialName);
 	if (itr != std::end(mMaterials))
 	{
 		//A material with the provided name already exists, return null instead of
 		//overwriting it.
 
-		bsLog::logf(bsLog::SEV_WARNING, "bsMaterialCache::createNewMaterial called with"
+		BS_LOG_WARNING(RESOURCES, "bsMaterialCache::createNewMaterial called with"
 			" name '%s', which already existed in the cache.", materialName.c_str());
 
 		return nullptr;
@@ -1,9 +1,11 @@
 #pragma once
 
-#include <unordered_map>
 #include <string>
 #include <memory>
 
+#include "bsFlatHashMap.h"
+#include "bsStringId.h"
+
 struct bsMaterial;
 
 
@@ -17,12 +19,12 @@ public:
 	/*	Returns the material with the provided name, or null if a material with that
 		name does not exist.
 	*/
-	std::shared_ptr<bsMaterial> getMaterial(const std::string& materialName);
+	std::shared_ptr<bsMaterial> getMaterial(const bsStringId& materialName);
 
 	/*	Creates a material with the provided name.
 		If a material with the provided name already exists, null with be returned.
 	*/
-	std::shared_ptr<bsMaterial> createNewMaterial(const std::string& materialName);
+	std::shared_ptr<bsMaterial> createNewMaterial(const bsStringId& materialName);
 
 
 private:
@@ -35,7 +37,7 @@ private:
 		return ++mNumCreatedMaterials;
 	}
 
-	std::unordered_map<std::string, std::shared_ptr<bsMaterial>> mMaterials;
+	bsFlatHashMap<bsStringId, std::shared_ptr<bsMaterial>, bsStringId::Hasher> mMaterials;
 
 	unsigned int		mNumCreatedMaterials;
 };
@@ -0,0 +1,118 @@
+#include "StdAfx.h"
+
+#include "bsMemory.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif // _WIN32
+
+
+namespace
+{
+size_t roundUp(size_t bytes, size_t multiple)
+{
+	return (bytes + multiple - 1) / multiple * multiple;
+}
+
+#ifdef _WIN32
+//Large pages can only be allocated by processes which hold SeLockMemoryPrivilege.
+bool enableLockMemoryPrivilege()
+{
+	HANDLE token;
+	if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY,
+		&token))
+	{
+		return false;
+	}
+
+	TOKEN_PRIVILEGES privileges;
+	privileges.PrivilegeCount = 1;
+	privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+	bool enabled = LookupPrivilegeValueA(nullptr, "SeLockMemoryPrivilege",
+		&privileges.Privileges[0].Luid) != FALSE;
+	if (enabled)
+	{
+		//Succeeds even if the privilege was not assigned, so check the last error too.
+		enabled = AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr)
+			!= FALSE && GetLastError() == ERROR_SUCCESS;
+	}
+
+	CloseHandle(token);
+
+	return enabled;
+}
+#endif // _WIN32
+}
+
+
+void* bsMemory::allocateLarge(size_t bytes, bool useHugePages)
+{
+	const size_t hugePageSize = useHugePages ? getHugePageSize() : 0;
+
+#ifdef _WIN32
+	if (hugePageSize != 0)
+	{
+		void* memory = VirtualAlloc(nullptr, roundUp(bytes, hugePageSize),
+			MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		if (memory != nullptr)
+		{
+			return memory;
+		}
+
+		//Not enough contiguous physical memory for large pages, use normal pages.
+	}
+
+	return VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+	if (hugePageSize != 0)
+	{
+		const size_t roundedBytes = roundUp(bytes, hugePageSize);
+
+		void* memory = allocateAligned(roundedBytes, hugePageSize);
+		if (memory != nullptr)
+		{
+			//Only a hint, the kernel falls back to normal pages when it has to.
+			madvise(memory, roundedBytes, MADV_HUGEPAGE);
+		}
+
+		return memory;
+	}
+
+	return allocateAligned(bytes, static_cast<size_t>(sysconf(_SC_PAGESIZE)));
+#endif // _WIN32
+}
+
+void bsMemory::freeLarge(void* memory)
+{
+	if (memory == nullptr)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	VirtualFree(memory, 0, MEM_RELEASE);
+#else
+	freeAligned(memory);
+#endif // _WIN32
+}
+
+size_t bsMemory::getHugePageSize()
+{
+#ifdef _WIN32
+	//Checked once, racing initializations get the same result.
+	static int privilegeEnabled = -1;
+	if (privilegeEnabled == -1)
+	{
+		privilegeEnabled = enableLockMemoryPrivilege() ? 1 : 0;
+	}
+
+	return privilegeEnabled == 1 ? GetLargePageMinimum() : 0;
+#else
+	//Transparent huge pages are 2 MB on x64.
+	return 2 * 1024 * 1024;
+#endif // _WIN32
+}
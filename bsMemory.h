@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdlib.h>//_aligned_malloc/posix_memalign
+
+
+/*	Platform independent aligned and page level allocation.
+
+	allocateAligned and freeAligned are what everything allocating aligned memory uses,
+	usually through bsMemoryTracker. They forward to _aligned_malloc on Windows and to
+	posix_memalign elsewhere.
+
+	allocateLarge is for big, long lived blocks such as pools, arenas and structure of
+	arrays data, which can opt into being backed by huge pages (2 MB on x64 instead of
+	4 KB). Walking through arrays of many megabytes touches a new 4 KB page every few
+	dozen entries, and each new page may miss the TLB; with huge pages one TLB entry
+	covers 512 times as much memory.
+	On Linux, transparent huge pages are requested with madvise. On Windows, large pages
+	require the "Lock pages in memory" privilege, which is enabled on first use if the
+	user has it. If huge pages are unavailable, normal pages are used.
+	The engine only builds on Windows, so the non-Windows paths are untested.
+*/
+namespace bsMemory
+{
+/*	Allocates bytes bytes aligned to alignment, which must be a power of 2.
+	Returns null if out of memory. Free with freeAligned.
+*/
+inline void* allocateAligned(size_t bytes, size_t alignment)
+{
+#ifdef _WIN32
+	return _aligned_malloc(bytes, alignment);
+#else
+	//posix_memalign requires at least pointer alignment.
+	if (alignment < sizeof(void*))
+	{
+		alignment = sizeof(void*);
+	}
+
+	void* memory = nullptr;
+	return posix_memalign(&memory, alignment, bytes) == 0 ? memory : nullptr;
+#endif // _WIN32
+}
+
+inline void freeAligned(void* memory)
+{
+#ifdef _WIN32
+	_aligned_free(memory);
+#else
+	free(memory);
+#endif // _WIN32
+}
+
+
+/*	Allocates at least bytes bytes of page aligned memory directly from the OS.
+	When useHugePages is true, the size is rounded up to a multiple of the huge page size
+	and huge pages are requested.
+	Returns null if out of memory. Free with freeLarge.
+*/
+void* allocateLarge(size_t bytes, bool useHugePages);
+
+void freeLarge(void* memory);
+
+/*	The size of a huge page, or 0 if huge pages are not supported or (on Windows) the
+	privilege needed to use them could not be enabled.
+*/
+size_t getHugePageSize();
+}
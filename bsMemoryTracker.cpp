@@ -0,0 +1,451 @@
+#include "StdAfx.h"
+
+#include "bsMemoryTracker.h"
+
+#ifdef BS_ENABLE_MEMORY_TRACKING
+
+#include <intrin.h>//_ReturnAddress
+#include <stdio.h>
+
+#include <algorithm>
+#include <new>
+#include <vector>
+
+#include <Windows.h>
+#include <DbgHelp.h>
+
+#include <tbb/atomic.h>
+
+#include "bsLog.h"
+#include "bsTimer.h"
+#include "bsAssert.h"
+
+#pragma comment(lib, "DbgHelp.lib")
+#pragma intrinsic(_ReturnAddress)
+
+
+namespace
+{
+const char* const gTagNames[bsMemoryTracker::TAG_COUNT] =
+{
+	"General",
+	"Render",
+	"Scene",
+	"Mesh",
+	"Texture",
+	"Text",
+	"Resources",
+	"IO",
+	"Allocators",
+};
+
+//Stored right before every tracked allocation.
+struct AllocationHeader
+{
+	size_t			bytes;
+	unsigned int	siteIndex;
+	unsigned short	tag;
+	//Distance from the start of the underlying allocation to the returned memory.
+	unsigned short	offset;
+};
+
+//Space reserved for the header. Also the minimum alignment of tracked allocations.
+const size_t kHeaderSize = 16;
+
+//Each tag's counters are on their own cache line, so that threads allocating with
+//different tags don't slow each other down.
+struct __declspec(align(64)) TagCounters
+{
+	tbb::atomic<size_t>				liveBytes;
+	tbb::atomic<size_t>				peakBytes;
+	tbb::atomic<unsigned int>		liveAllocations;
+	tbb::atomic<unsigned long long>	totalAllocations;
+};
+
+TagCounters gTagCounters[bsMemoryTracker::TAG_COUNT];
+
+/*	Allocation sites, in a fixed size lock free hash table keyed on return address.
+	Entries are never removed. Allocations from sites which don't fit in the table are
+	recorded in entry 0.
+*/
+const unsigned int kSiteCapacity = 8192;
+
+struct Site
+{
+	tbb::atomic<const void*>		address;
+	tbb::atomic<unsigned int>		tag;
+	tbb::atomic<unsigned int>		allocations;
+	tbb::atomic<unsigned long long>	totalBytes;
+	tbb::atomic<size_t>				liveBytes;
+};
+
+Site gSites[kSiteCapacity];
+
+__declspec(thread) bsMemoryTracker::Tag gThreadTag = bsMemoryTracker::TAG_GENERAL;
+
+//Allocation rate measurement, only touched by update.
+long long			gRateStartTicks = 0;
+unsigned long long	gRateStartAllocations[bsMemoryTracker::TAG_COUNT];
+float				gAllocationsPerSecond[bsMemoryTracker::TAG_COUNT];
+
+
+unsigned int findSite(const void* address, bsMemoryTracker::Tag tag)
+{
+	unsigned long long hash = reinterpret_cast<size_t>(address);
+	hash = (hash ^ (hash >> 29)) * 0x9E3779B97F4A7C15ULL;
+	const unsigned int start = static_cast<unsigned int>(hash >> 32);
+
+	for (unsigned int probe = 0; probe < kSiteCapacity; ++probe)
+	{
+		const unsigned int index = (start + probe) & (kSiteCapacity - 1);
+		if (index == 0)
+		{
+			continue;
+		}
+
+		Site& site = gSites[index];
+		const void* siteAddress = site.address;
+		if (siteAddress == nullptr)
+		{
+			siteAddress = site.address.compare_and_swap(address,
+				static_cast<const void*>(nullptr));
+			if (siteAddress == nullptr)
+			{
+				site.tag = tag;
+				return index;
+			}
+		}
+
+		if (siteAddress == address)
+		{
+			return index;
+		}
+	}
+
+	return 0;
+}
+
+void updatePeakBytes(TagCounters& counters, size_t liveBytes)
+{
+	size_t peak = counters.peakBytes;
+	while (liveBytes > peak)
+	{
+		const size_t previous = counters.peakBytes.compare_and_swap(liveBytes, peak);
+		if (previous == peak)
+		{
+			break;
+		}
+
+		peak = previous;
+	}
+}
+
+void* allocateFromSite(size_t bytes, size_t alignment, bsMemoryTracker::Tag tag,
+	const void* returnAddress)
+{
+	BS_ASSERT2((alignment & (alignment - 1)) == 0, "Alignment must be a power of 2");
+	BS_ASSERT2(tag < bsMemoryTracker::TAG_COUNT, "Invalid memory tag");
+
+	//The header is placed in the last 16 bytes before the returned memory, and the
+	//returned memory must keep the requested alignment, so it is offset by the alignment.
+	if (alignment < kHeaderSize)
+	{
+		alignment = kHeaderSize;
+	}
+	BS_ASSERT2(alignment <= 0x8000, "Alignment too large to be tracked");
+
+	char* base = static_cast<char*>(bsMemory::allocateAligned(bytes + alignment,
+		alignment));
+	if (base == nullptr)
+	{
+		return nullptr;
+	}
+
+	char* memory = base + alignment;
+	AllocationHeader& header = *(reinterpret_cast<AllocationHeader*>(memory) - 1);
+	header.bytes = bytes;
+	header.siteIndex = findSite(returnAddress, tag);
+	header.tag = static_cast<unsigned short>(tag);
+	header.offset = static_cast<unsigned short>(alignment);
+
+	TagCounters& counters = gTagCounters[tag];
+	updatePeakBytes(counters, counters.liveBytes += bytes);
+	++counters.liveAllocations;
+	++counters.totalAllocations;
+
+	Site& site = gSites[header.siteIndex];
+	++site.allocations;
+	site.totalBytes += bytes;
+	site.liveBytes += bytes;
+
+	return memory;
+}
+
+struct SiteSnapshot
+{
+	const void*			address;
+	unsigned int		tag;
+	unsigned int		allocations;
+	unsigned long long	totalBytes;
+	size_t				liveBytes;
+};
+
+bool hasMoreTotalBytes(const SiteSnapshot& a, const SiteSnapshot& b)
+{
+	return a.totalBytes > b.totalBytes;
+}
+
+void logSite(HANDLE process, bool symbolsLoaded, const SiteSnapshot& site)
+{
+	const char* tagName = gTagNames[site.tag];
+
+	if (site.address == nullptr)
+	{
+		BS_LOG_INFO(GENERAL, "%12llu bytes in %8u allocations, %10llu live, %-10s"
+			" <sites which did not fit in the table>", site.totalBytes, site.allocations,
+			static_cast<unsigned long long>(site.liveBytes), tagName);
+		return;
+	}
+
+	const DWORD64 address = reinterpret_cast<DWORD64>(site.address);
+
+	char symbolBuffer[sizeof(SYMBOL_INFO) + MAX_SYM_NAME];
+	SYMBOL_INFO& symbol = *reinterpret_cast<SYMBOL_INFO*>(symbolBuffer);
+	symbol.SizeOfStruct = sizeof(SYMBOL_INFO);
+	symbol.MaxNameLen = MAX_SYM_NAME;
+	DWORD64 symbolDisplacement = 0;
+
+	IMAGEHLP_LINE64 line;
+	line.SizeOfStruct = sizeof(line);
+	DWORD lineDisplacement = 0;
+
+	if (symbolsLoaded && SymFromAddr(process, address, &symbolDisplacement, &symbol)
+		&& SymGetLineFromAddr64(process, address, &lineDisplacement, &line))
+	{
+		BS_LOG_INFO(GENERAL, "%12llu bytes in %8u allocations, %10llu live, %-10s %s"
+			" (%s:%u)", site.totalBytes, site.allocations,
+			static_cast<unsigned long long>(site.liveBytes), tagName, symbol.Name,
+			line.FileName, static_cast<unsigned int>(line.LineNumber));
+	}
+	else
+	{
+		BS_LOG_INFO(GENERAL, "%12llu bytes in %8u allocations, %10llu live, %-10s %p",
+			site.totalBytes, site.allocations,
+			static_cast<unsigned long long>(site.liveBytes), tagName, site.address);
+	}
+}
+}
+
+
+__declspec(noinline) void* bsMemoryTracker::allocate(size_t bytes, size_t alignment,
+	Tag tag)
+{
+	return allocateFromSite(bytes, alignment, tag, _ReturnAddress());
+}
+
+void bsMemoryTracker::deallocate(void* memory)
+{
+	if (memory == nullptr)
+	{
+		return;
+	}
+
+	const AllocationHeader& header = *(static_cast<AllocationHeader*>(memory) - 1);
+
+	TagCounters& counters = gTagCounters[header.tag];
+	counters.liveBytes -= header.bytes;
+	--counters.liveAllocations;
+
+	gSites[header.siteIndex].liveBytes -= header.bytes;
+
+	bsMemory::freeAligned(static_cast<char*>(memory) - header.offset);
+}
+
+bsMemoryTracker::Tag bsMemoryTracker::getThreadTag()
+{
+	return gThreadTag;
+}
+
+void bsMemoryTracker::setThreadTag(Tag tag)
+{
+	BS_ASSERT2(tag < TAG_COUNT, "Invalid memory tag");
+
+	gThreadTag = tag;
+}
+
+void bsMemoryTracker::update()
+{
+	const long long ticks = bsTimer::getTicks();
+	if (gRateStartTicks == 0)
+	{
+		gRateStartTicks = ticks;
+		for (unsigned int i = 0; i < TAG_COUNT; ++i)
+		{
+			gRateStartAllocations[i] = gTagCounters[i].totalAllocations;
+		}
+
+		return;
+	}
+
+	const double seconds = bsTimer::ticksToMicroSeconds(ticks - gRateStartTicks) * 1e-6;
+	if (seconds < 1.0)
+	{
+		return;
+	}
+
+	for (unsigned int i = 0; i < TAG_COUNT; ++i)
+	{
+		const unsigned long long totalAllocations = gTagCounters[i].totalAllocations;
+		gAllocationsPerSecond[i] = static_cast<float>((totalAllocations
+			- gRateStartAllocations[i]) / seconds);
+		gRateStartAllocations[i] = totalAllocations;
+	}
+
+	gRateStartTicks = ticks;
+}
+
+bsMemoryTracker::TagStatistics bsMemoryTracker::getTagStatistics(Tag tag)
+{
+	BS_ASSERT2(tag < TAG_COUNT, "Invalid memory tag");
+
+	const TagCounters& counters = gTagCounters[tag];
+
+	TagStatistics statistics;
+	statistics.liveBytes = counters.liveBytes;
+	statistics.peakBytes = counters.peakBytes;
+	statistics.liveAllocations = counters.liveAllocations;
+	statistics.totalAllocations = counters.totalAllocations;
+	statistics.allocationsPerSecond = gAllocationsPerSecond[tag];
+
+	return statistics;
+}
+
+const char* bsMemoryTracker::getTagName(Tag tag)
+{
+	BS_ASSERT2(tag < TAG_COUNT, "Invalid memory tag");
+
+	return gTagNames[tag];
+}
+
+std::string bsMemoryTracker::getReport()
+{
+	std::string report("Memory      Live KB   Peak KB    Allocs  Allocs/s");
+
+	char line[128];
+	for (unsigned int i = 0; i < TAG_COUNT; ++i)
+	{
+		const TagStatistics statistics = getTagStatistics(static_cast<Tag>(i));
+		sprintf_s(line, "\n%-10s %8u %9u %9u %9.0f", gTagNames[i],
+			static_cast<unsigned int>(statistics.liveBytes / 1024),
+			static_cast<unsigned int>(statistics.peakBytes / 1024),
+			statistics.liveAllocations, statistics.allocationsPerSecond);
+		report.append(line);
+	}
+
+	return report;
+}
+
+void bsMemoryTracker::logReport(unsigned int siteCount)
+{
+	BS_LOG_INFO(GENERAL, "Memory by tag:");
+	for (unsigned int i = 0; i < TAG_COUNT; ++i)
+	{
+		const TagStatistics statistics = getTagStatistics(static_cast<Tag>(i));
+		BS_LOG_INFO(GENERAL, "%-10s %12llu bytes live, %12llu peak, %8u live allocations,"
+			" %10llu total", gTagNames[i],
+			static_cast<unsigned long long>(statistics.liveBytes),
+			static_cast<unsigned long long>(statistics.peakBytes),
+			statistics.liveAllocations, statistics.totalAllocations);
+	}
+
+	//Copy the sites before sorting, they may change while this runs.
+	std::vector<SiteSnapshot> sites;
+	for (unsigned int i = 0; i < kSiteCapacity; ++i)
+	{
+		const Site& site = gSites[i];
+		if (site.allocations != 0)
+		{
+			const SiteSnapshot snapshot = { site.address, site.tag, site.allocations,
+				site.totalBytes, site.liveBytes };
+			sites.push_back(snapshot);
+		}
+	}
+
+	const size_t sitesToLog = std::min<size_t>(siteCount, sites.size());
+	std::partial_sort(sites.begin(), sites.begin() + sitesToLog, sites.end(),
+		hasMoreTotalBytes);
+
+	HANDLE process = GetCurrentProcess();
+	SymSetOptions(SymGetOptions() | SYMOPT_DEFERRED_LOADS | SYMOPT_LOAD_LINES
+		| SYMOPT_UNDNAME);
+	const bool symbolsLoaded = SymInitialize(process, nullptr, TRUE) != FALSE;
+
+	BS_LOG_INFO(GENERAL, "Top %u of %u allocation sites by total bytes allocated:",
+		static_cast<unsigned int>(sitesToLog), static_cast<unsigned int>(sites.size()));
+	for (size_t i = 0; i < sitesToLog; ++i)
+	{
+		logSite(process, symbolsLoaded, sites[i]);
+	}
+
+	if (symbolsLoaded)
+	{
+		SymCleanup(process);
+	}
+}
+
+
+/*	Global operator new and delete, tagged with the calling thread's tag.
+*/
+__declspec(noinline) void* operator new(size_t bytes)
+{
+	void* memory = allocateFromSite(bytes, kHeaderSize, gThreadTag, _ReturnAddress());
+	if (memory == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+
+	return memory;
+}
+
+__declspec(noinline) void* operator new[](size_t bytes)
+{
+	void* memory = allocateFromSite(bytes, kHeaderSize, gThreadTag, _ReturnAddress());
+	if (memory == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+
+	return memory;
+}
+
+__declspec(noinline) void* operator new(size_t bytes, const std::nothrow_t&) throw()
+{
+	return allocateFromSite(bytes, kHeaderSize, gThreadTag, _ReturnAddress());
+}
+
+__declspec(noinline) void* operator new[](size_t bytes, const std::nothrow_t&) throw()
+{
+	return allocateFromSite(bytes, kHeaderSize, gThreadTag, _ReturnAddress());
+}
+
+void operator delete(void* memory) throw()
+{
+	bsMemoryTracker::deallocate(memory);
+}
+
+void operator delete[](void* memory) throw()
+{
+	bsMemoryTracker::deallocate(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) throw()
+{
+	bsMemoryTracker::deallocate(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) throw()
+{
+	bsMemoryTracker::deallocate(memory);
+}
+
+#endif // BS_ENABLE_MEMORY_TRACKING
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <string>
+
+#include "bsMemory.h"
+
+
+/*	Tracks the engine's heap memory by subsystem.
+
+	Every allocation made through bsMemoryTracker::allocate is tagged with the subsystem
+	it belongs to, and live bytes, peak bytes and allocation rate are recorded per tag.
+	The classes which override operator new, bsAlignedAllocator, bsFlatHashMap and the
+	frame and scratch allocators' heap fallbacks all allocate through it.
+
+	When BS_ENABLE_MEMORY_TRACKING is defined, the global operator new and delete are
+	also replaced, and allocations made through them are tagged with the calling
+	thread's current tag, which is set with bsMemoryTagScope. The address each
+	allocation was made from is recorded as well, so the biggest allocation sites can be
+	listed by logReport.
+	Tracking costs a 16 byte header and a few atomic operations per allocation, which
+	is cheap enough to leave on in profiling builds.
+
+	When BS_ENABLE_MEMORY_TRACKING is not defined, allocate and deallocate forward
+	directly to bsMemory::allocateAligned and bsMemory::freeAligned, and nothing is
+	recorded.
+
+	Memory which is not allocated by the engine, such as Havok's, Direct3D's and memory
+	allocated with malloc, is not tracked.
+*/
+namespace bsMemoryTracker
+{
+/*	The subsystem an allocation belongs to.
+	When updating this, also update gTagNames in the .cpp file.
+*/
+enum Tag
+{
+	//Allocations which don't belong to any particular subsystem.
+	TAG_GENERAL = 0,
+
+	//Render queue, renderers and everything created while drawing a frame.
+	TAG_RENDER = 1,
+
+	//Entities, transforms, cameras, lights and line renderers.
+	TAG_SCENE = 2,
+
+	//Meshes, mesh loading and the mesh cache.
+	TAG_MESH = 3,
+
+	//Textures, texture loading and the texture cache.
+	TAG_TEXTURE = 4,
+
+	//2D and 3D texts.
+	TAG_TEXT = 5,
+
+	//Material and shader caches, and other resource bookkeeping.
+	TAG_RESOURCES = 6,
+
+	//File system index, file loading and the file IO thread.
+	TAG_IO = 7,
+
+	//Heap fallbacks of the frame and scratch allocators.
+	TAG_ALLOCATORS = 8,
+
+	//Don't use. Used for determining array size of per tag data.
+	TAG_COUNT = 9,
+};
+
+struct TagStatistics
+{
+	//Bytes allocated and not yet freed, excluding tracking overhead.
+	size_t				liveBytes;
+	//The highest liveBytes has been.
+	size_t				peakBytes;
+
+	unsigned int		liveAllocations;
+	unsigned long long	totalAllocations;
+
+	//Allocations per second, measured over roughly the last second, see update.
+	float				allocationsPerSecond;
+};
+
+
+#ifdef BS_ENABLE_MEMORY_TRACKING
+
+/*	Allocates bytes bytes aligned to alignment, which must be a power of 2, and records
+	it with the given tag and the calling address.
+	Returns null if out of memory.
+*/
+void* allocate(size_t bytes, size_t alignment, Tag tag);
+
+/*	Frees memory returned by allocate. Null is allowed.
+*/
+void deallocate(void* memory);
+
+/*	The calling thread's current tag, used for allocations which don't specify one, such
+	as those made with the global operator new. Defaults to TAG_GENERAL.
+*/
+Tag getThreadTag();
+
+void setThreadTag(Tag tag);
+
+/*	Updates the allocation rates. Call once per frame from the main thread.
+*/
+void update();
+
+//Thread safe.
+TagStatistics getTagStatistics(Tag tag);
+
+const char* getTagName(Tag tag);
+
+/*	Returns a table with one line per tag, suitable for displaying in a text box.
+*/
+std::string getReport();
+
+/*	Logs the per tag statistics and the siteCount call sites which have allocated the
+	most memory, with function names and line numbers when debug symbols are available.
+	Also called at shutdown, to show what is still alive.
+*/
+void logReport(unsigned int siteCount);
+
+#else
+
+inline void* allocate(size_t bytes, size_t alignment, Tag)
+{
+	return bsMemory::allocateAligned(bytes, alignment);
+}
+
+inline void deallocate(void* memory)
+{
+	bsMemory::freeAligned(memory);
+}
+
+inline Tag getThreadTag()
+{
+	return TAG_GENERAL;
+}
+
+inline void setThreadTag(Tag)
+{}
+
+inline void update()
+{}
+
+inline TagStatistics getTagStatistics(Tag)
+{
+	const TagStatistics statistics = { 0, 0, 0, 0, 0.0f };
+	return statistics;
+}
+
+inline const char* getTagName(Tag)
+{
+	return "";
+}
+
+inline std::string getReport()
+{
+	return "Memory tracking is disabled";
+}
+
+inline void logReport(unsigned int)
+{}
+
+#endif // BS_ENABLE_MEMORY_TRACKING
+}
+
+
+/*	Sets the calling thread's memory tag for the lifetime of the scope, restoring the
+	previous tag when it is destroyed.
+
+	{
+		bsMemoryTagScope memoryTag(bsMemoryTracker::TAG_MESH);
+		//Everything allocated with new in here is tagged as a mesh allocation.
+	}
+*/
+class bsMemoryTagScope
+{
+public:
+	explicit bsMemoryTagScope(bsMemoryTracker::Tag tag)
+		: mPreviousTag(bsMemoryTracker::getThreadTag())
+	{
+		bsMemoryTracker::setThreadTag(tag);
+	}
+
+	~bsMemoryTagScope()
+	{
+		bsMemoryTracker::setThreadTag(mPreviousTag);
+	}
+
+private:
+	//Non-copyable.
+	bsMemoryTagScope(const bsMemoryTagScope&);
+	bsMemoryTagScope& operator=(const bsMemoryTagScope&);
+
+	const bsMemoryTracker::Tag	mPreviousTag;
+};
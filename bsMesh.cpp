@@ -10,16 +10,17 @@
 #include "bsShaderManager.h"
 #include "bsConstantBuffers.h"
 #include "bsVertexTypes.h"
-#include "bsDx11Renderer.h"
+#include "bsRenderDevice.h"
 #include "bsAssert.h"
 #include "bsEntity.h"
 
 
-bsMesh::bsMesh(unsigned int id, std::vector<ID3D11Buffer*>&& vertexBuffers,
-	std::vector<ID3D11Buffer*>&& indexBuffers,
+bsMesh::bsMesh(unsigned int id, bsRenderDevice& renderDevice,
+	std::vector<ID3D11Buffer*>&& vertexBuffers, std::vector<ID3D11Buffer*>&& indexBuffers,
 	std::vector<unsigned int>&& indexCounts, std::vector<unsigned int>&& vertexCounts,
 	const bsCollision::Sphere& boundingSphere)
 	: mBoundingSphere(boundingSphere)
+	, mRenderDevice(&renderDevice)
 	, mVertexBuffers(std::move(vertexBuffers))
 	, mIndexBuffers(std::move(indexBuffers))
 	, mIndexCounts(std::move(indexCounts))
@@ -44,11 +45,11 @@ bsMesh::~bsMesh()
 
 	for (size_t i = 0; i < bufferCount; ++i)
 	{
-		mVertexBuffers[i]->Release();
+		mRenderDevice->release(mVertexBuffers[i]);
 	}
 	for (size_t i = 0; i < bufferCount; ++i)
 	{
-		mIndexBuffers[i]->Release();
+		mRenderDevice->release(mIndexBuffers[i]);
 	}
 }
 
@@ -56,6 +57,7 @@ bsMesh& bsMesh::operator=(bsMesh&& other)
 {
 	mBoundingSphere = other.mBoundingSphere;
 
+	mRenderDevice = other.mRenderDevice;
 	mVertexBuffers = std::move(other.mVertexBuffers);
 	mIndexBuffers = std::move(other.mIndexBuffers);
 	mIndexCounts = std::move(other.mIndexCounts);
@@ -82,7 +84,7 @@ bsMesh& bsMesh::operator=(bsMesh&& other)
 	return *this;
 }
 
-void bsMesh::drawInstanced(ID3D11DeviceContext& deviceContext, ID3D11Buffer* instanceBuffer,
+void bsMesh::drawInstanced(bsRenderDevice& renderDevice, ID3D11Buffer* instanceBuffer,
 	unsigned int instanceCount) const
 {
 	if (!mLoadingFinished)
@@ -98,10 +100,10 @@ void bsMesh::drawInstanced(ID3D11DeviceContext& deviceContext, ID3D11Buffer* ins
 	for (unsigned int i = 0; i < bufferCount; ++i)
 	{
 		vertexInstanceBuffers[0] = mVertexBuffers[i];
-		deviceContext.IASetVertexBuffers(0, 2, vertexInstanceBuffers, strides, offsets);
-		deviceContext.IASetIndexBuffer(mIndexBuffers[i], DXGI_FORMAT_R32_UINT, 0);
+		renderDevice.setVertexBuffers(0, 2, vertexInstanceBuffers, strides, offsets);
+		renderDevice.setIndexBuffer(mIndexBuffers[i], DXGI_FORMAT_R32_UINT, 0);
 
-		deviceContext.DrawIndexedInstanced(mIndexCounts[i], instanceCount, 0, 0, 0);
+		renderDevice.drawIndexedInstanced(mIndexCounts[i], instanceCount, 0, 0, 0);
 	}
 }
 
@@ -7,8 +7,10 @@
 #include <d3d11.h>
 
 #include "bsCollision.h"
+#include "bsMemoryTracker.h"
 
 class bsDx11Renderer;
+class bsRenderDevice;
 class bsEntity;
 
 
@@ -20,26 +22,30 @@ __declspec(align(16)) class bsMesh
 public:
 	inline void* operator new(size_t)
 	{
-		return _aligned_malloc(sizeof(bsMesh), 16);
+		return bsMemoryTracker::allocate(sizeof(bsMesh), 16, bsMemoryTracker::TAG_MESH);
 	}
 
 	inline void operator delete(void* p)
 	{
-		_aligned_free(p);
+		bsMemoryTracker::deallocate(p);
 	}
 
 
 	//For container purposes only, do not use this constructor.
 	inline bsMesh(unsigned int id)
-		: mID(id)
+		: mRenderDevice(nullptr)
+		, mID(id)
 		, mLoadingFinished(false)
 	{}
 
 	/*	Creates a mesh given a unique ID, vertex and index buffer(s), index count for each
 		index/vertex buffer pair, and an AABB whose extents covers every single vertex
 		in the vertex buffer.
+		The buffers must have been created by the render device, which releases them when
+		the mesh is destroyed.
 	*/
-	bsMesh(unsigned int id, std::vector<ID3D11Buffer*>&& vertexBuffers,
+	bsMesh(unsigned int id, bsRenderDevice& renderDevice,
+		std::vector<ID3D11Buffer*>&& vertexBuffers,
 		std::vector<ID3D11Buffer*>&& indexBuffers,
 		std::vector<unsigned int>&& indexCounts, std::vector<unsigned int>&& vertexCounts,
 		const bsCollision::Sphere& boundingSphere);
@@ -50,7 +56,7 @@ public:
 
 	/*	Renders the mesh using instancing.
 	*/
-	void drawInstanced(ID3D11DeviceContext& deviceContext, ID3D11Buffer* instanceBuffer,
+	void drawInstanced(bsRenderDevice& renderDevice, ID3D11Buffer* instanceBuffer,
 		unsigned int instanceCount) const;
 
 	/*	Returns true if this mesh has finished loading and is ready to be rendered.
@@ -98,6 +104,8 @@ private:
 
 	bsCollision::Sphere mBoundingSphere;
 
+	//Device the buffers were created by, null until loading has finished.
+	bsRenderDevice*				mRenderDevice;
 	std::vector<ID3D11Buffer*>	mVertexBuffers;
 	std::vector<ID3D11Buffer*>	mIndexBuffers;
 	std::vector<unsigned int>	mIndexCounts;
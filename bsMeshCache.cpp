@@ -10,6 +10,7 @@
 #include "bsDx11Renderer.h"
 #include "bsMeshSerializer.h"
 #include "bsAssert.h"
+#include "bsMemoryTracker.h"
 
 
 #pragma warning(push)
@@ -18,11 +19,11 @@
 #pragma warning(disable:4355)// warning C4355: 'this' : used in base member initializer list
 
 bsMeshCache::bsMeshCache(bsDx11Renderer* dx11Renderer, const bsFileSystem& fileSystem,
-	bsFileIoManager& fileIoManager)
+	bsFileIoManager& fileIoManager, bsJobSystem& jobSystem)
 	: mNumLoadedMeshes(0)
 	, mFileSystem(fileSystem)
 	, mFileIoManager(fileIoManager)
-	, mMeshCreator(*this, *dx11Renderer, fileSystem, mFileIoManager)
+	, mMeshCreator(*this, *dx11Renderer, fileSystem, mFileIoManager, jobSystem)
 {
 	BS_ASSERT(dx11Renderer);
 }
@@ -39,7 +40,7 @@ bsMeshCache::~bsMeshCache()
 	{
 		if (!itr->second.unique())
 		{
-			bsLog::logf(bsLog::SEV_WARNING, "All references to mesh '%s' have not"
+			BS_LOG_WARNING(RESOURCES, "All references to mesh '%s' have not"
 				" been released when bsMeshCache is being destroyed (%u external refs)",
 				itr->first.c_str(), itr->second.use_count() - 1);
 		}
@@ -47,9 +48,9 @@ bsMeshCache::~bsMeshCache()
 #endif //BS_DEBUG
 }
 
-std::shared_ptr<bsMesh> bsMeshCache::getMesh(const std::string& meshName) const
+std::shared_ptr<bsMesh> bsMeshCache::getMesh(const bsStringId& meshName) const
 {
-	BS_ASSERT2(meshName.length(), "Zero length file names are not OK");
+	BS_ASSERT2(*meshName.c_str(), "Zero length file names are not OK");
 
 	//See if the mesh already exists
 	auto findResult = mMeshes.find(meshName);
@@ -61,13 +62,15 @@ std::shared_ptr<bsMesh> bsMeshCache::getMesh(const std::string& meshName) const
 	//Not found, need to create it now.
 	//Cast const away since the load function is not const
 	std::shared_ptr<bsMesh> mesh(const_cast<bsMeshCache*>(this)->loadMeshAsync(meshName));
-	BS_ASSERT2(mesh != nullptr, std::string("Something went wrong while creating \'") + meshName + '\'');
+	BS_ASSERT2(mesh != nullptr, std::string("Something went wrong while creating \'") + meshName.c_str() + '\'');
 
 	return mesh;
 }
 
-std::shared_ptr<bsMesh> bsMeshCache::loadMeshAsync(const std::string& meshName)
+std::shared_ptr<bsMesh> bsMeshCache::loadMeshAsync(const bsStringId& meshName)
 {
+	bsMemoryTagScope memoryTag(bsMemoryTracker::TAG_MESH);
+
 #ifdef BS_DEBUG
 	if (!verifyMeshIsNotAlreadyInCache(meshName))
 	{
@@ -76,7 +79,7 @@ std::shared_ptr<bsMesh> bsMeshCache::loadMeshAsync(const std::string& meshName)
 #endif
 
 	//Get relative path of the mesh file.
-	const std::string meshPath(mFileSystem.getPathFromFilename(meshName));
+	const std::string meshPath(mFileSystem.getPathFromFilename(meshName.c_str()));
 	if (!verifyMeshPathIsValid(meshPath, meshName))
 	{
 		return nullptr;
@@ -90,8 +93,10 @@ std::shared_ptr<bsMesh> bsMeshCache::loadMeshAsync(const std::string& meshName)
 	return mesh;
 }
 
-std::shared_ptr<bsMesh> bsMeshCache::loadMeshSynchronously(const std::string& meshName)
+std::shared_ptr<bsMesh> bsMeshCache::loadMeshSynchronously(const bsStringId& meshName)
 {
+	bsMemoryTagScope memoryTag(bsMemoryTracker::TAG_MESH);
+
 #ifdef BS_DEBUG
 	if (!verifyMeshIsNotAlreadyInCache(meshName))
 	{
@@ -99,7 +104,7 @@ std::shared_ptr<bsMesh> bsMeshCache::loadMeshSynchronously(const std::string& me
 	}
 #endif
 
-	const std::string meshPath(mFileSystem.getPathFromFilename(meshName));
+	const std::string meshPath(mFileSystem.getPathFromFilename(meshName.c_str()));
 	if (!verifyMeshPathIsValid(meshPath, meshName))
 	{
 		return nullptr;
@@ -112,13 +117,13 @@ std::shared_ptr<bsMesh> bsMeshCache::loadMeshSynchronously(const std::string& me
 	return mesh;
 }
 
-inline bool bsMeshCache::verifyMeshIsNotAlreadyInCache(const std::string& meshName)
+inline bool bsMeshCache::verifyMeshIsNotAlreadyInCache(const bsStringId& meshName)
 {
 	//Verify that the mesh has not already been loaded. This should only happen due to
 	//incorrect usage of this class.
 	if (mMeshes.find(meshName) != mMeshes.end())
 	{
-		bsLog::logf(bsLog::SEV_ERROR, "bsMeshCache::loadMeshAsync was called, but the"
+		BS_LOG_ERROR(RESOURCES, "bsMeshCache::loadMeshAsync was called, but the"
 			" requested mesh has already been loaded. Mesh name: '%s'", meshName.c_str());
 		
 		BS_ASSERT2(false, "bsMeshCache::loadMeshAsync was "
@@ -131,13 +136,13 @@ inline bool bsMeshCache::verifyMeshIsNotAlreadyInCache(const std::string& meshNa
 }
 
 inline bool bsMeshCache::verifyMeshPathIsValid(const std::string& meshPath,
-	const std::string& meshName)
+	const bsStringId& meshName)
 {
 	//Verify that the path of the mesh actually exists.
 	if (meshPath.empty())
 	{
-		bsLog::logf(bsLog::SEV_ERROR, "'%s' does not exist in any known resource paths,"
-			" it will not be loaded");
+		BS_LOG_ERROR(RESOURCES, "'%s' does not exist in any known resource paths,"
+			" it will not be loaded", meshName.c_str());
 
 		BS_ASSERT2(false, "Failed to load mesh");
 
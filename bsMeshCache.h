@@ -1,7 +1,6 @@
 #pragma once
 
 
-#include <unordered_map>
 #include <memory>
 #include <string>
 
@@ -10,20 +9,25 @@
 #include "bsMesh.h"
 #include "bsVertexTypes.h"
 #include "bsMeshCreator.h"
+#include "bsFlatHashMap.h"
+#include "bsStringId.h"
 
 class bsFileSystem;
 class bsFileIoManager;
+class bsJobSystem;
 
 
 /*	The mesh manager keeps track of every loaded mesh, and it loads meshes.
-	The meshes are stored in a map with the file path as the key, making it possible to
+	The meshes are stored in a map with the file name's ID as the key, making it possible to
 	easily return a pointer to a mesh that has already been loaded if it exists in the map.
+	Looking up an already loaded mesh by a literal name, like
+	getMesh(bsStringId("teapot.bsm")), does not hash or compare any strings at run time.
 */
 class bsMeshCache
 {
 public:
 	bsMeshCache(bsDx11Renderer* dx11Renderer, const bsFileSystem& fileSystem,
-		bsFileIoManager& fileIoManager);
+		bsFileIoManager& fileIoManager, bsJobSystem& jobSystem);
 
 	~bsMeshCache();
 
@@ -31,7 +35,7 @@ public:
 		This will look for the mesh name in the known resource locations and load it if it
 		has not already been loaded.
 	*/
-	std::shared_ptr<bsMesh> getMesh(const std::string& meshName) const;
+	std::shared_ptr<bsMesh> getMesh(const bsStringId& meshName) const;
 
 	/*	Loads a mesh from disk asynchronously.
 		This function will be called automatically by getMesh if the requested mesh has not
@@ -40,7 +44,7 @@ public:
 		Attempting to load an already load a mesh may result in memory leaks and internal
 		corruption.
 	*/
-	std::shared_ptr<bsMesh> loadMeshAsync(const std::string& meshName);
+	std::shared_ptr<bsMesh> loadMeshAsync(const bsStringId& meshName);
 
 	/*	Loads a mesh from disk and blocks until the mesh has finished loading.
 
@@ -50,7 +54,7 @@ public:
 		Attempting to load an already load a mesh may result in memory leaks and internal
 		corruption.
 	*/
-	std::shared_ptr<bsMesh> loadMeshSynchronously(const std::string& meshName);
+	std::shared_ptr<bsMesh> loadMeshSynchronously(const bsStringId& meshName);
 
 
 	bsMeshCreator& getMeshCreator()
@@ -72,16 +76,16 @@ private:
 	/*	Verifies that the mesh specified by the parameter has not already been loaded.
 		Returns true if the mesh is not in the cache.
 	*/
-	inline bool verifyMeshIsNotAlreadyInCache(const std::string& meshName);
+	inline bool verifyMeshIsNotAlreadyInCache(const bsStringId& meshName);
 
 	/*	Verifies that the mesh path is valid, ie not empty.
 		Returns true if the path is valid.
 	*/
 	inline bool verifyMeshPathIsValid(const std::string& meshPath,
-		const std::string& meshName);
+		const bsStringId& meshName);
 
 
-	std::unordered_map<std::string, std::shared_ptr<bsMesh>>	mMeshes;
+	bsFlatHashMap<bsStringId, std::shared_ptr<bsMesh>, bsStringId::Hasher>	mMeshes;
 
 	const bsFileSystem&	mFileSystem;
 	bsFileIoManager&	mFileIoManager;
@@ -7,10 +7,11 @@
 #include "bsAssert.h"
 #include "bsMesh.h"
 #include "bsMeshCache.h"
-#include "bsDx11Renderer.h"
+#include "bsRenderDevice.h"
 #include "bsMath.h"
 #include "bsFileSystem.h"
 #include "bsFileIoManager.h"
+#include "bsJobSystem.h"
 
 
 /*	Function object passed to file loader when loading meshes asynchronously.
@@ -48,18 +49,17 @@ private:
 
 
 bsMeshCreator::bsMeshCreator(bsMeshCache& meshCache, const bsDx11Renderer& dx11Renderer,
-	const bsFileSystem& fileSystem, bsFileIoManager& fileManager)
+	const bsFileSystem& fileSystem, bsFileIoManager& fileManager, bsJobSystem& jobSystem)
 	: mMeshCache(meshCache)
-	, mD3dDevice(dx11Renderer.getDevice())
+	, mRenderDevice(dx11Renderer.getRenderDevice())
 	, mFileSystem(fileSystem)
 	, mFileManager(fileManager)
+	, mJobSystem(jobSystem)
 {
-	mD3dDevice->AddRef();
 }
 
 bsMeshCreator::~bsMeshCreator()
 {
-	mD3dDevice->Release();
 }
 
 std::shared_ptr<bsMesh> bsMeshCreator::loadMeshAsync(const std::string& meshName)
@@ -85,7 +85,7 @@ std::shared_ptr<bsMesh> bsMeshCreator::loadMeshSynchronous(const std::string& me
 		return nullptr;
 	}
 
-	bsLog::logf(bsLog::SEV_INFO, "Loaded mesh '%s'", meshName.c_str());
+	BS_LOG_DEBUG(RESOURCES, "Loaded mesh '%s'", meshName.c_str());
 
 	std::shared_ptr<bsMesh> mesh(constructMeshFromSerializedMesh(serializedMesh, meshName));
 
@@ -100,29 +100,52 @@ std::shared_ptr<bsMesh> bsMeshCreator::constructMeshFromSerializedMesh(
 	std::vector<ID3D11Buffer*> indexBuffers(meshCount);
 	std::vector<unsigned int>  indexCounts(meshCount);
 	std::vector<unsigned int>  vertexCounts(meshCount);
+	//Not bool, since vector<bool> elements can't be written from multiple threads.
+	std::vector<unsigned char> succeeded(meshCount);
+
+	//Create buffers for each mesh, one job per mesh.
+	mJobSystem.parallelFor(meshCount, 1, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; ++i)
+		{
+			vertexBuffers[i] = nullptr;
+			indexBuffers[i] = nullptr;
+			succeeded[i] = createBuffers(vertexBuffers[i], indexBuffers[i], meshName, i,
+				serializedMesh);
 
-	//Create buffers and check for failure for each mesh
+			indexCounts[i] = serializedMesh.indexBuffers[i].indexCount;
+			vertexCounts[i] = serializedMesh.vertexBuffers[i].vertexCount;
+		}
+	});
+
+	//Check for failure for each mesh.
 	for (unsigned int i = 0; i < meshCount; ++i)
 	{
-		if (!createBuffers(vertexBuffers[i], indexBuffers[i], meshName, i, serializedMesh))
+		if (!succeeded[i])
 		{
-			std::string errorMessage("Failed to create buffers when loading \'");
-			errorMessage.append(meshName);
-			errorMessage.append("\'");
-			bsLog::logf(bsLog::SEV_ERROR, "Failed to create buffers when loading '%s'",
+			BS_LOG_ERROR(RESOURCES, "Failed to create buffers when loading '%s'",
 				meshName.c_str());
 
+			for (unsigned int j = 0; j < meshCount; ++j)
+			{
+				if (vertexBuffers[j] != nullptr)
+				{
+					mRenderDevice.release(vertexBuffers[j]);
+				}
+				if (indexBuffers[j] != nullptr)
+				{
+					mRenderDevice.release(indexBuffers[j]);
+				}
+			}
+
 			return nullptr;
 		}
-
-		indexCounts[i] = serializedMesh.indexBuffers[i].indexCount;
-		vertexCounts[i] = serializedMesh.vertexBuffers[i].vertexCount;
 	}
 
 	bsCollision::Sphere boundingSphere;
 	boundingSphere.positionAndRadius = XMLoadFloat4(&serializedMesh.boundingSphereCenterAndRadius);
 
-	return std::shared_ptr<bsMesh>(new bsMesh(mMeshCache.getNewMeshId(),
+	return std::shared_ptr<bsMesh>(new bsMesh(mMeshCache.getNewMeshId(), mRenderDevice,
 		std::move(vertexBuffers), std::move(indexBuffers), std::move(indexCounts),
 		std::move(vertexCounts), boundingSphere));
 }
@@ -150,7 +173,7 @@ bool bsMeshCreator::createBuffers(ID3D11Buffer*& vertexBuffer, ID3D11Buffer*& in
 	memset(&initData, 0, sizeof(initData));
 	initData.pSysMem = currentVertexBuffer.vertices;
 
-	if (FAILED(mD3dDevice->CreateBuffer(&bufferDescription, &initData,
+	if (FAILED(mRenderDevice.createBuffer(bufferDescription, &initData,
 		&vertexBuffer)))
 	{
 		BS_ASSERT(!"Failed to create vertex buffer, aborting mesh creation");
@@ -166,7 +189,7 @@ bool bsMeshCreator::createBuffers(ID3D11Buffer*& vertexBuffer, ID3D11Buffer*& in
 
 	initData.pSysMem = currentIndexBuffer.indices;
 
-	if (FAILED(mD3dDevice->CreateBuffer(&bufferDescription, &initData,
+	if (FAILED(mRenderDevice.createBuffer(bufferDescription, &initData,
 		&indexBuffer)))
 	{
 		BS_ASSERT(!"Failed to create index buffer, aborting mesh creation");
@@ -178,13 +201,11 @@ bool bsMeshCreator::createBuffers(ID3D11Buffer*& vertexBuffer, ID3D11Buffer*& in
 	//Add some debug info
 	std::string debugString("VB ");
 	debugString.append(meshName);
-	vertexBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, debugString.size(),
-		debugString.c_str());
+	mRenderDevice.setDebugName(vertexBuffer, debugString.c_str());
 
 	debugString = "IB ";
 	debugString.append(meshName);
-	indexBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, debugString.size(),
-		debugString.c_str());
+	mRenderDevice.setDebugName(indexBuffer, debugString.c_str());
 #endif // BS_DEBUG
 
 	return true;
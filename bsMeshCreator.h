@@ -17,7 +17,8 @@ class bsDx11Renderer;
 class bsFileSystem;
 class bsFileLoader;
 class bsFileIoManager;
-struct ID3D11Device;
+class bsJobSystem;
+class bsRenderDevice;
 
 
 class bsMeshCreator
@@ -26,7 +27,8 @@ class bsMeshCreator
 
 public:
 	bsMeshCreator(bsMeshCache& meshCache, const bsDx11Renderer& dx11Renderer,
-		const bsFileSystem& fileSystem, bsFileIoManager& fileManager);
+		const bsFileSystem& fileSystem, bsFileIoManager& fileManager,
+		bsJobSystem& jobSystem);
 
 	~bsMeshCreator();
 
@@ -45,6 +47,10 @@ private:
 	bsMeshCreator& operator=(const bsMeshCreator&);
 	bsMeshCreator(const bsMeshCreator&);
 
+	/*	Creates the buffers for every sub-mesh in parallel on the job system. Device buffer
+		creation is free threaded, and meshes with many sub-meshes spend most of their
+		construction time here.
+	*/
 	std::shared_ptr<bsMesh> constructMeshFromSerializedMesh(
 		const bsSerializedMesh& serializedMesh, const std::string& meshName) const;
 
@@ -57,7 +63,8 @@ private:
 
 
 	bsMeshCache&		mMeshCache;
-	ID3D11Device*		mD3dDevice;
+	bsRenderDevice&		mRenderDevice;
 	const bsFileSystem&	mFileSystem;
 	bsFileIoManager&	mFileManager;
+	bsJobSystem&		mJobSystem;
 };
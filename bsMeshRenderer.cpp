@@ -22,19 +22,19 @@ bsMeshRenderer::bsMeshRenderer(const bsSharedMesh& mesh,
 	mMaterial.vertexShader = vertexShader;
 }
 
-void bsMeshRenderer::drawInstanced(ID3D11DeviceContext& deviceContext,
+void bsMeshRenderer::drawInstanced(bsRenderDevice& renderDevice,
 	ID3D11Buffer* instanceBuffer, unsigned int instanceCount) const
 {
 	if (mMaterial.diffuse != nullptr)
 	{
-		mMaterial.diffuse->apply(deviceContext, 0);
+		mMaterial.diffuse->apply(renderDevice, 0);
 	}
 	if (mMaterial.normal != nullptr)
 	{
-		mMaterial.normal->apply(deviceContext, 1);
+		mMaterial.normal->apply(renderDevice, 1);
 	}
 
-	mMesh->drawInstanced(deviceContext, instanceBuffer, instanceCount);
+	mMesh->drawInstanced(renderDevice, instanceBuffer, instanceCount);
 }
 
 bool bsMeshRenderer::hasFinishedLoading() const
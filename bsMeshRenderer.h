@@ -5,6 +5,7 @@
 #include "bsMaterial.h"
 
 class bsDx11Renderer;
+class bsRenderDevice;
 class bsTexture2D;
 class bsMesh;
 
@@ -24,7 +25,7 @@ public:
 
 
 	
-	void drawInstanced(ID3D11DeviceContext& deviceContext, ID3D11Buffer* instanceBuffer,
+	void drawInstanced(bsRenderDevice& renderDevice, ID3D11Buffer* instanceBuffer,
 		unsigned int instanceCount) const;
 
 
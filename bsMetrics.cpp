@@ -0,0 +1,305 @@
+#include "StdAfx.h"
+
+#include "bsMetrics.h"
+
+#include "bsLog.h"
+#include "bsAssert.h"
+
+
+bsMetricHistogram::bsMetricHistogram(float sliceDurationMs)
+	: mSliceDurationMs(sliceDurationMs)
+	, mSliceElapsedMs(0.0f)
+{
+	BS_ASSERT2(sliceDurationMs > 0.0f, "Slice duration must be positive");
+
+	mCurrentSlice = 0;
+}
+
+void bsMetricHistogram::advance(float elapsedMs)
+{
+	mSliceElapsedMs += elapsedMs;
+	if (mSliceElapsedMs < mSliceDurationMs)
+	{
+		return;
+	}
+
+	//Skip a slice for every slice duration that passed, clearing all of them if there
+	//was a pause longer than the window.
+	unsigned int slicesPassed = static_cast<unsigned int>(
+		mSliceElapsedMs / mSliceDurationMs);
+	mSliceElapsedMs -= slicesPassed * mSliceDurationMs;
+	if (slicesPassed > kSliceCount)
+	{
+		slicesPassed = kSliceCount;
+	}
+
+	unsigned int slice = mCurrentSlice;
+	for (unsigned int i = 0; i < slicesPassed; ++i)
+	{
+		slice = (slice + 1) % kSliceCount;
+		mSlices[slice].reset();
+	}
+
+	mCurrentSlice = slice;
+}
+
+void bsMetricHistogram::setSliceDuration(float sliceDurationMs)
+{
+	BS_ASSERT2(sliceDurationMs > 0.0f, "Slice duration must be positive");
+
+	mSliceDurationMs = sliceDurationMs;
+}
+
+bsMetricHistogram::Summary bsMetricHistogram::getSummary()
+{
+	mCombined.reset();
+	for (unsigned int i = 0; i < kSliceCount; ++i)
+	{
+		mCombined.add(mSlices[i]);
+	}
+
+	Summary summary;
+	summary.count = mCombined.getCount();
+	summary.mean = mCombined.getMean();
+	summary.p50 = mCombined.getPercentile(50.0f);
+	summary.p90 = mCombined.getPercentile(90.0f);
+	summary.p99 = mCombined.getPercentile(99.0f);
+	summary.max = mCombined.getMax();
+
+	return summary;
+}
+
+
+bsMetricsRegistry::bsMetricsRegistry(float sliceDurationMs)
+	: mSliceDurationMs(sliceDurationMs)
+	, mTimeMs(0.0)
+	, mExportCsv(false)
+	, mExportIntervalMs(0.0f)
+	, mTimeSinceExportMs(0.0f)
+{
+}
+
+bsMetricsRegistry::~bsMetricsRegistry()
+{
+	for (size_t i = 0; i < mCounters.size(); ++i)
+	{
+		delete mCounters[i].metric;
+	}
+	for (size_t i = 0; i < mGauges.size(); ++i)
+	{
+		delete mGauges[i].metric;
+	}
+	for (size_t i = 0; i < mHistograms.size(); ++i)
+	{
+		delete mHistograms[i].metric;
+	}
+}
+
+bsMetricCounter& bsMetricsRegistry::getCounter(const char* name)
+{
+	for (size_t i = 0; i < mCounters.size(); ++i)
+	{
+		if (mCounters[i].name == name)
+		{
+			return *mCounters[i].metric;
+		}
+	}
+
+	NamedMetric<bsMetricCounter> counter;
+	counter.name = name;
+	counter.metric = new bsMetricCounter();
+	mCounters.push_back(counter);
+
+	return *counter.metric;
+}
+
+bsMetricGauge& bsMetricsRegistry::getGauge(const char* name)
+{
+	for (size_t i = 0; i < mGauges.size(); ++i)
+	{
+		if (mGauges[i].name == name)
+		{
+			return *mGauges[i].metric;
+		}
+	}
+
+	NamedMetric<bsMetricGauge> gauge;
+	gauge.name = name;
+	gauge.metric = new bsMetricGauge();
+	mGauges.push_back(gauge);
+
+	return *gauge.metric;
+}
+
+bsMetricHistogram& bsMetricsRegistry::getHistogram(const char* name)
+{
+	for (size_t i = 0; i < mHistograms.size(); ++i)
+	{
+		if (mHistograms[i].name == name)
+		{
+			return *mHistograms[i].metric;
+		}
+	}
+
+	NamedMetric<bsMetricHistogram> histogram;
+	histogram.name = name;
+	histogram.metric = new bsMetricHistogram(mSliceDurationMs);
+	mHistograms.push_back(histogram);
+
+	return *histogram.metric;
+}
+
+void bsMetricsRegistry::update(float deltaTimeMs)
+{
+	mTimeMs += deltaTimeMs;
+
+	for (size_t i = 0; i < mHistograms.size(); ++i)
+	{
+		mHistograms[i].metric->advance(deltaTimeMs);
+	}
+
+	if (mExportFileName.empty())
+	{
+		return;
+	}
+
+	mTimeSinceExportMs += deltaTimeMs;
+	if (mTimeSinceExportMs >= mExportIntervalMs)
+	{
+		mTimeSinceExportMs = 0.0f;
+
+		exportMetrics();
+	}
+}
+
+bool bsMetricsRegistry::setExport(const std::string& fileName, float intervalMs)
+{
+	mExportFileName = fileName;
+	mExportIntervalMs = intervalMs;
+	mTimeSinceExportMs = 0.0f;
+
+	if (fileName.empty())
+	{
+		return true;
+	}
+
+	mExportCsv = fileName.size() >= 4
+		&& fileName.compare(fileName.size() - 4, 4, ".csv") == 0;
+	if (!mExportCsv)
+	{
+		return true;
+	}
+
+	//Start a new time series with a header, later exports append to it.
+#pragma warning (disable : 4996)//warning C4996: 'fopen' was declared deprecated
+	FILE* file = fopen(fileName.c_str(), "w");
+#pragma warning (default : 4996)
+	if (!file)
+	{
+		BS_LOG_ERROR(GENERAL, "Failed to create metrics file '%s'", fileName.c_str());
+		mExportFileName.clear();
+
+		return false;
+	}
+
+	fprintf(file, "timeMs,name,type,value,count,mean,p50,p90,p99,max\n");
+	fclose(file);
+
+	return true;
+}
+
+bool bsMetricsRegistry::writeJson(const std::string& fileName)
+{
+#pragma warning (disable : 4996)//warning C4996: 'fopen' was declared deprecated
+	FILE* file = fopen(fileName.c_str(), "w");
+#pragma warning (default : 4996)
+	if (!file)
+	{
+		BS_LOG_ERROR(GENERAL, "Failed to open '%s' for writing metrics",
+			fileName.c_str());
+
+		return false;
+	}
+
+	fprintf(file, "{\n\t\"timeMs\": %.1f,\n\t\"counters\": {", mTimeMs);
+	for (size_t i = 0; i < mCounters.size(); ++i)
+	{
+		fprintf(file, "%s\n\t\t\"%s\": %llu", i ? "," : "", mCounters[i].name.c_str(),
+			mCounters[i].metric->get());
+	}
+
+	fprintf(file, "\n\t},\n\t\"gauges\": {");
+	for (size_t i = 0; i < mGauges.size(); ++i)
+	{
+		fprintf(file, "%s\n\t\t\"%s\": %lld", i ? "," : "", mGauges[i].name.c_str(),
+			mGauges[i].metric->get());
+	}
+
+	fprintf(file, "\n\t},\n\t\"histograms\": {");
+	for (size_t i = 0; i < mHistograms.size(); ++i)
+	{
+		bsMetricHistogram& histogram = *mHistograms[i].metric;
+		const bsMetricHistogram::Summary summary = histogram.getSummary();
+
+		fprintf(file, "%s\n\t\t\"%s\": {\"windowMs\": %.0f, \"count\": %llu, "
+			"\"mean\": %.1f, \"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"max\": %llu}",
+			i ? "," : "", mHistograms[i].name.c_str(), histogram.getWindowDuration(),
+			summary.count, summary.mean, summary.p50, summary.p90, summary.p99,
+			summary.max);
+	}
+	fprintf(file, "\n\t}\n}\n");
+
+	const bool success = ferror(file) == 0;
+	fclose(file);
+
+	return success;
+}
+
+bool bsMetricsRegistry::appendCsv()
+{
+#pragma warning (disable : 4996)//warning C4996: 'fopen' was declared deprecated
+	FILE* file = fopen(mExportFileName.c_str(), "a");
+#pragma warning (default : 4996)
+	if (!file)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < mCounters.size(); ++i)
+	{
+		fprintf(file, "%.1f,%s,counter,%llu,,,,,,\n", mTimeMs, mCounters[i].name.c_str(),
+			mCounters[i].metric->get());
+	}
+
+	for (size_t i = 0; i < mGauges.size(); ++i)
+	{
+		fprintf(file, "%.1f,%s,gauge,%lld,,,,,,\n", mTimeMs, mGauges[i].name.c_str(),
+			mGauges[i].metric->get());
+	}
+
+	for (size_t i = 0; i < mHistograms.size(); ++i)
+	{
+		const bsMetricHistogram::Summary summary = mHistograms[i].metric->getSummary();
+
+		fprintf(file, "%.1f,%s,histogram,,%llu,%.1f,%llu,%llu,%llu,%llu\n", mTimeMs,
+			mHistograms[i].name.c_str(), summary.count, summary.mean, summary.p50,
+			summary.p90, summary.p99, summary.max);
+	}
+
+	const bool success = ferror(file) == 0;
+	fclose(file);
+
+	return success;
+}
+
+void bsMetricsRegistry::exportMetrics()
+{
+	const bool success = mExportCsv ? appendCsv() : writeJson(mExportFileName);
+	if (!success)
+	{
+		BS_LOG_ERROR(GENERAL, "Failed to export metrics to '%s', disabling export",
+			mExportFileName.c_str());
+
+		mExportFileName.clear();
+	}
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include <tbb/atomic.h>
+
+#include "bsHistogram.h"
+
+
+/*	A value which only grows, like the number of meshes drawn since startup.
+	Can be added to from any thread.
+*/
+class bsMetricCounter
+{
+public:
+	bsMetricCounter()
+	{
+		mValue = 0;
+	}
+
+	inline void add(unsigned long long amount = 1)
+	{
+		mValue += amount;
+	}
+
+	inline unsigned long long get() const
+	{
+		return mValue;
+	}
+
+private:
+	//Non-copyable.
+	bsMetricCounter(const bsMetricCounter&);
+	bsMetricCounter& operator=(const bsMetricCounter&);
+
+	tbb::atomic<unsigned long long>	mValue;
+};
+
+
+/*	The latest value of something, like the number of visible lights this frame.
+	Can be set from any thread.
+*/
+class bsMetricGauge
+{
+public:
+	bsMetricGauge()
+	{
+		mValue = 0;
+	}
+
+	inline void set(long long value)
+	{
+		mValue = value;
+	}
+
+	inline long long get() const
+	{
+		return mValue;
+	}
+
+private:
+	//Non-copyable.
+	bsMetricGauge(const bsMetricGauge&);
+	bsMetricGauge& operator=(const bsMetricGauge&);
+
+	tbb::atomic<long long>	mValue;
+};
+
+
+/*	Distribution of values, like frame times, over a sliding window.
+
+	The window is split into kSliceCount slices, each a bsHistogram, and values are
+	recorded into the newest one. advance moves time forward, and once a slice's duration
+	has passed, the oldest slice is cleared and becomes the newest. Summaries therefore
+	cover between kSliceCount - 1 and kSliceCount slices of history.
+
+	Durations should be recorded in microseconds, since bsHistogram counts integers.
+	Recording is lock-free and can be done from any thread. advance and getSummary must
+	be called from a single thread, and values recorded while a slice is being cleared
+	may be lost.
+*/
+class bsMetricHistogram
+{
+public:
+	static const unsigned int kSliceCount = 10;
+
+	struct Summary
+	{
+		unsigned long long	count;
+		double				mean;
+		unsigned long long	p50;
+		unsigned long long	p90;
+		unsigned long long	p99;
+		unsigned long long	max;
+	};
+
+
+	//The window lasts kSliceCount * sliceDurationMs.
+	explicit bsMetricHistogram(float sliceDurationMs = 1000.0f);
+
+	inline void record(unsigned long long value)
+	{
+		mSlices[mCurrentSlice].record(value);
+	}
+
+	inline void recordMilliSeconds(float durationMs)
+	{
+		record(durationMs > 0.0f ? static_cast<unsigned long long>(durationMs * 1000.0f)
+			: 0);
+	}
+
+	//Moves the window forward by elapsedMs.
+	void advance(float elapsedMs);
+
+	void setSliceDuration(float sliceDurationMs);
+
+	inline float getWindowDuration() const
+	{
+		return mSliceDurationMs * kSliceCount;
+	}
+
+	//Summary of every value recorded in the window.
+	Summary getSummary();
+
+private:
+	//Non-copyable.
+	bsMetricHistogram(const bsMetricHistogram&);
+	bsMetricHistogram& operator=(const bsMetricHistogram&);
+
+	bsHistogram					mSlices[kSliceCount];
+	tbb::atomic<unsigned int>	mCurrentSlice;
+
+	float	mSliceDurationMs;
+	//Time since the current slice became the newest.
+	float	mSliceElapsedMs;
+
+	//The slices combined, reused by getSummary.
+	bsHistogram					mCombined;
+};
+
+
+/*	Named counters, gauges and histograms, which can be exported to a file periodically.
+
+	Metrics are created the first time they are requested, which allocates. Request them
+	once during initialization and keep the returned reference, after which recording
+	allocates nothing:
+
+	bsMetricHistogram& cullTimes = metrics.getHistogram("render.cull_us");
+	...
+	cullTimes.recordMilliSeconds(cullDuration);
+
+	update must be called once per frame from the main thread. It advances the histogram
+	windows and writes the export file when the export interval has passed.
+	Names should not contain commas or quotes, since they are written to CSV and JSON as
+	they are.
+*/
+class bsMetricsRegistry
+{
+public:
+	//Histograms get windows of kSliceCount * sliceDurationMs.
+	explicit bsMetricsRegistry(float sliceDurationMs = 1000.0f);
+
+	~bsMetricsRegistry();
+
+	bsMetricCounter& getCounter(const char* name);
+
+	bsMetricGauge& getGauge(const char* name);
+
+	bsMetricHistogram& getHistogram(const char* name);
+
+	void update(float deltaTimeMs);
+
+	/*	Writes every metric to a file every intervalMs, starting with the next update.
+		Files ending in .csv get one row per metric appended every interval, making a
+		time series. Other files are overwritten with a JSON object holding the latest
+		values. An empty file name disables exporting.
+		Returns false if the file could not be created.
+	*/
+	bool setExport(const std::string& fileName, float intervalMs);
+
+	/*	Writes every metric as a JSON object, overwriting the file.
+		Returns false if the file could not be written.
+	*/
+	bool writeJson(const std::string& fileName);
+
+private:
+	//Non-copyable.
+	bsMetricsRegistry(const bsMetricsRegistry&);
+	bsMetricsRegistry& operator=(const bsMetricsRegistry&);
+
+	template <typename Metric>
+	struct NamedMetric
+	{
+		std::string	name;
+		Metric*		metric;
+	};
+
+	//Appends one row per metric to the export file.
+	bool appendCsv();
+
+	void exportMetrics();
+
+
+	std::vector<NamedMetric<bsMetricCounter>>	mCounters;
+	std::vector<NamedMetric<bsMetricGauge>>		mGauges;
+	std::vector<NamedMetric<bsMetricHistogram>>	mHistograms;
+
+	float	mSliceDurationMs;
+
+	//Time since the registry was created.
+	double	mTimeMs;
+
+	std::string	mExportFileName;
+	bool		mExportCsv;
+	float		mExportIntervalMs;
+	float		mTimeSinceExportMs;
+};
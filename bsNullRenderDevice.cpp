@@ -0,0 +1,304 @@
+#include "StdAfx.h"
+
+#include "bsNullRenderDevice.h"
+
+#include "bsLog.h"
+#include "bsAssert.h"
+
+
+namespace
+{
+/*	Handles are spaced like real allocations, starting above the first 64 KB so they are
+	never mistaken for null or a small integer.
+*/
+const size_t kFirstHandle = 0x10000;
+const size_t kHandleSpacing = 16;
+}
+
+
+bsNullRenderDevice::bsNullRenderDevice(bool constantBufferOffsets)
+	: mConstantBufferOffsets(constantBufferOffsets)
+{
+	mCreatedObjectCount = 0;
+	mLiveObjectCount = 0;
+	mLargestWritableBufferSize = 0;
+}
+
+bsNullRenderDevice::~bsNullRenderDevice()
+{
+	if (mLiveObjectCount != 0)
+	{
+		BS_LOG_WARNING(RENDER, "Null render device destroyed with %u objects which have"
+			" not been released", static_cast<unsigned int>(mLiveObjectCount));
+	}
+}
+
+template <typename T>
+HRESULT bsNullRenderDevice::createHandle(T** handleOut)
+{
+	BS_ASSERT(handleOut != nullptr);
+
+	const unsigned int index = mCreatedObjectCount++;
+	++mLiveObjectCount;
+
+	*handleOut = reinterpret_cast<T*>(kFirstHandle + index * kHandleSpacing);
+
+	return S_OK;
+}
+
+HRESULT bsNullRenderDevice::createBuffer(const D3D11_BUFFER_DESC& desc,
+	const D3D11_SUBRESOURCE_DATA* /*initialData*/, ID3D11Buffer** bufferOut)
+{
+	if (desc.CPUAccessFlags & D3D11_CPU_ACCESS_WRITE)
+	{
+		//Raise the largest size, unless another thread raised it even further.
+		unsigned int largest = mLargestWritableBufferSize;
+		while (desc.ByteWidth > largest)
+		{
+			const unsigned int previous =
+				mLargestWritableBufferSize.compare_and_swap(desc.ByteWidth, largest);
+			if (previous == largest)
+			{
+				break;
+			}
+
+			largest = previous;
+		}
+	}
+
+	return createHandle(bufferOut);
+}
+
+HRESULT bsNullRenderDevice::createTexture2D(const D3D11_TEXTURE2D_DESC& /*desc*/,
+	const D3D11_SUBRESOURCE_DATA* /*initialData*/, ID3D11Texture2D** textureOut)
+{
+	return createHandle(textureOut);
+}
+
+HRESULT bsNullRenderDevice::createRenderTargetView(ID3D11Resource* resource,
+	const D3D11_RENDER_TARGET_VIEW_DESC* /*desc*/, ID3D11RenderTargetView** viewOut)
+{
+	BS_ASSERT(resource != nullptr);
+
+	return createHandle(viewOut);
+}
+
+HRESULT bsNullRenderDevice::createShaderResourceView(ID3D11Resource* resource,
+	const D3D11_SHADER_RESOURCE_VIEW_DESC* /*desc*/, ID3D11ShaderResourceView** viewOut)
+{
+	BS_ASSERT(resource != nullptr);
+
+	return createHandle(viewOut);
+}
+
+HRESULT bsNullRenderDevice::createDepthStencilView(ID3D11Resource* resource,
+	const D3D11_DEPTH_STENCIL_VIEW_DESC* /*desc*/, ID3D11DepthStencilView** viewOut)
+{
+	BS_ASSERT(resource != nullptr);
+
+	return createHandle(viewOut);
+}
+
+HRESULT bsNullRenderDevice::createRasterizerState(const D3D11_RASTERIZER_DESC& /*desc*/,
+	ID3D11RasterizerState** stateOut)
+{
+	return createHandle(stateOut);
+}
+
+HRESULT bsNullRenderDevice::createBlendState(const D3D11_BLEND_DESC& /*desc*/,
+	ID3D11BlendState** stateOut)
+{
+	return createHandle(stateOut);
+}
+
+HRESULT bsNullRenderDevice::createDepthStencilState(
+	const D3D11_DEPTH_STENCIL_DESC& /*desc*/, ID3D11DepthStencilState** stateOut)
+{
+	return createHandle(stateOut);
+}
+
+HRESULT bsNullRenderDevice::createSamplerState(const D3D11_SAMPLER_DESC& /*desc*/,
+	ID3D11SamplerState** stateOut)
+{
+	return createHandle(stateOut);
+}
+
+HRESULT bsNullRenderDevice::createVertexShader(const void* /*byteCode*/,
+	size_t /*byteCodeSize*/, ID3D11VertexShader** shaderOut)
+{
+	return createHandle(shaderOut);
+}
+
+HRESULT bsNullRenderDevice::createPixelShader(const void* /*byteCode*/,
+	size_t /*byteCodeSize*/, ID3D11PixelShader** shaderOut)
+{
+	return createHandle(shaderOut);
+}
+
+HRESULT bsNullRenderDevice::createInputLayout(
+	const D3D11_INPUT_ELEMENT_DESC* /*inputDescs*/, unsigned int /*inputDescCount*/,
+	const void* /*byteCode*/, size_t /*byteCodeSize*/, ID3D11InputLayout** layoutOut)
+{
+	return createHandle(layoutOut);
+}
+
+unsigned long bsNullRenderDevice::release(ID3D11DeviceChild* object)
+{
+	BS_ASSERT(object != nullptr);
+	BS_ASSERT2(mLiveObjectCount != 0, "Releasing more objects than have been created");
+
+	--mLiveObjectCount;
+
+	//Every handle has a single reference.
+	return 0;
+}
+
+void bsNullRenderDevice::setDebugName(ID3D11DeviceChild* /*object*/,
+	const char* /*name*/)
+{
+}
+
+void bsNullRenderDevice::setRenderTargets(unsigned int /*count*/,
+	ID3D11RenderTargetView* const* /*renderTargetViews*/,
+	ID3D11DepthStencilView* /*depthStencilView*/)
+{
+}
+
+void bsNullRenderDevice::clearRenderTarget(ID3D11RenderTargetView* /*renderTargetView*/,
+	const float* /*colorRgba*/)
+{
+}
+
+void bsNullRenderDevice::clearDepthStencil(ID3D11DepthStencilView* /*depthStencilView*/,
+	unsigned int /*clearFlags*/, float /*depth*/, unsigned char /*stencil*/)
+{
+}
+
+void bsNullRenderDevice::setViewport(const D3D11_VIEWPORT& /*viewport*/)
+{
+}
+
+void bsNullRenderDevice::setRasterizerState(ID3D11RasterizerState* /*state*/)
+{
+}
+
+void bsNullRenderDevice::setBlendState(ID3D11BlendState* /*state*/)
+{
+}
+
+void bsNullRenderDevice::setDepthStencilState(ID3D11DepthStencilState* /*state*/)
+{
+}
+
+void bsNullRenderDevice::setInputLayout(ID3D11InputLayout* /*inputLayout*/)
+{
+}
+
+void bsNullRenderDevice::setVertexShader(ID3D11VertexShader* /*shader*/)
+{
+}
+
+void bsNullRenderDevice::setGeometryShader(ID3D11GeometryShader* /*shader*/)
+{
+}
+
+void bsNullRenderDevice::setPixelShader(ID3D11PixelShader* /*shader*/)
+{
+}
+
+void bsNullRenderDevice::setVertexConstantBuffers(unsigned int /*startSlot*/,
+	unsigned int /*count*/, ID3D11Buffer* const* /*buffers*/)
+{
+}
+
+void bsNullRenderDevice::setPixelConstantBuffers(unsigned int /*startSlot*/,
+	unsigned int /*count*/, ID3D11Buffer* const* /*buffers*/)
+{
+}
+
+bool bsNullRenderDevice::supportsConstantBufferOffsets() const
+{
+	return mConstantBufferOffsets;
+}
+
+void bsNullRenderDevice::setVertexConstantBufferRange(unsigned int /*slot*/,
+	ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int constantCount)
+{
+	BS_ASSERT2(mConstantBufferOffsets, "Constant buffer offsets are not supported");
+	BS_ASSERT(buffer != nullptr);
+	BS_ASSERT(firstConstant % 16 == 0 && constantCount % 16 == 0);
+}
+
+void bsNullRenderDevice::setPixelConstantBufferRange(unsigned int /*slot*/,
+	ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int constantCount)
+{
+	BS_ASSERT2(mConstantBufferOffsets, "Constant buffer offsets are not supported");
+	BS_ASSERT(buffer != nullptr);
+	BS_ASSERT(firstConstant % 16 == 0 && constantCount % 16 == 0);
+}
+
+void bsNullRenderDevice::setPixelShaderResources(unsigned int /*startSlot*/,
+	unsigned int /*count*/, ID3D11ShaderResourceView* const* /*views*/)
+{
+}
+
+void bsNullRenderDevice::setPixelSamplers(unsigned int /*startSlot*/,
+	unsigned int /*count*/, ID3D11SamplerState* const* /*samplers*/)
+{
+}
+
+void bsNullRenderDevice::setPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY /*topology*/)
+{
+}
+
+void bsNullRenderDevice::setVertexBuffers(unsigned int /*startSlot*/,
+	unsigned int /*count*/, ID3D11Buffer* const* /*buffers*/,
+	const unsigned int* /*strides*/, const unsigned int* /*offsets*/)
+{
+}
+
+void bsNullRenderDevice::setIndexBuffer(ID3D11Buffer* /*buffer*/, DXGI_FORMAT /*format*/,
+	unsigned int /*offset*/)
+{
+}
+
+void bsNullRenderDevice::updateBuffer(ID3D11Buffer* buffer, const void* data,
+	unsigned int /*dataSize*/)
+{
+	BS_ASSERT(buffer != nullptr);
+	BS_ASSERT(data != nullptr);
+}
+
+void* bsNullRenderDevice::mapDiscard(ID3D11Buffer* buffer)
+{
+	BS_ASSERT(buffer != nullptr);
+	BS_ASSERT2(mLargestWritableBufferSize != 0, "No writable buffer has been created");
+
+	if (mMapScratch.size() < mLargestWritableBufferSize)
+	{
+		mMapScratch.resize(mLargestWritableBufferSize);
+	}
+
+	return mMapScratch.data();
+}
+
+void bsNullRenderDevice::unmap(ID3D11Buffer* buffer)
+{
+	BS_ASSERT(buffer != nullptr);
+}
+
+void bsNullRenderDevice::drawIndexed(unsigned int /*indexCount*/,
+	unsigned int /*startIndex*/, int /*baseVertex*/)
+{
+}
+
+void bsNullRenderDevice::drawIndexedInstanced(unsigned int /*indexCountPerInstance*/,
+	unsigned int /*instanceCount*/, unsigned int /*startIndex*/, int /*baseVertex*/,
+	unsigned int /*startInstance*/)
+{
+}
+
+HRESULT bsNullRenderDevice::present(unsigned int /*syncInterval*/)
+{
+	return S_OK;
+}
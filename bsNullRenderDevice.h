@@ -0,0 +1,171 @@
+#pragma once
+
+#include <vector>
+
+#include <tbb/atomic.h>
+
+#include "bsRenderDevice.h"
+
+
+/*	Render device which needs neither a GPU nor a window. Creating an object always
+	succeeds and returns a unique handle, every command does nothing.
+	Used to run and measure the frame path headless, often behind a
+	bsRecordingRenderDevice to check which commands it issues.
+
+	The handles are not D3D11 objects and must never be dereferenced, see bsRenderDevice.
+	Mapping any buffer returns the same scratch memory, large enough for the largest
+	writable buffer created so far.
+*/
+class bsNullRenderDevice : public bsRenderDevice
+{
+public:
+	/*	constantBufferOffsets is returned by supportsConstantBufferOffsets, so that code
+		with a fallback for D3D11.0 can be run both ways.
+	*/
+	explicit bsNullRenderDevice(bool constantBufferOffsets = true);
+
+	~bsNullRenderDevice();
+
+
+	/*	Returns the number of objects which have been created but not released.
+		Should be 0 once everything using the device has been destroyed.
+	*/
+	inline unsigned int getLiveObjectCount() const
+	{
+		return mLiveObjectCount;
+	}
+
+
+	virtual HRESULT createBuffer(const D3D11_BUFFER_DESC& desc,
+		const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Buffer** bufferOut);
+
+	virtual HRESULT createTexture2D(const D3D11_TEXTURE2D_DESC& desc,
+		const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Texture2D** textureOut);
+
+	virtual HRESULT createRenderTargetView(ID3D11Resource* resource,
+		const D3D11_RENDER_TARGET_VIEW_DESC* desc, ID3D11RenderTargetView** viewOut);
+
+	virtual HRESULT createShaderResourceView(ID3D11Resource* resource,
+		const D3D11_SHADER_RESOURCE_VIEW_DESC* desc, ID3D11ShaderResourceView** viewOut);
+
+	virtual HRESULT createDepthStencilView(ID3D11Resource* resource,
+		const D3D11_DEPTH_STENCIL_VIEW_DESC* desc, ID3D11DepthStencilView** viewOut);
+
+	virtual HRESULT createRasterizerState(const D3D11_RASTERIZER_DESC& desc,
+		ID3D11RasterizerState** stateOut);
+
+	virtual HRESULT createBlendState(const D3D11_BLEND_DESC& desc,
+		ID3D11BlendState** stateOut);
+
+	virtual HRESULT createDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc,
+		ID3D11DepthStencilState** stateOut);
+
+	virtual HRESULT createSamplerState(const D3D11_SAMPLER_DESC& desc,
+		ID3D11SamplerState** stateOut);
+
+	virtual HRESULT createVertexShader(const void* byteCode, size_t byteCodeSize,
+		ID3D11VertexShader** shaderOut);
+
+	virtual HRESULT createPixelShader(const void* byteCode, size_t byteCodeSize,
+		ID3D11PixelShader** shaderOut);
+
+	virtual HRESULT createInputLayout(const D3D11_INPUT_ELEMENT_DESC* inputDescs,
+		unsigned int inputDescCount, const void* byteCode, size_t byteCodeSize,
+		ID3D11InputLayout** layoutOut);
+
+	virtual unsigned long release(ID3D11DeviceChild* object);
+
+	virtual void setDebugName(ID3D11DeviceChild* object, const char* name);
+
+
+	virtual void setRenderTargets(unsigned int count,
+		ID3D11RenderTargetView* const* renderTargetViews,
+		ID3D11DepthStencilView* depthStencilView);
+
+	virtual void clearRenderTarget(ID3D11RenderTargetView* renderTargetView,
+		const float* colorRgba);
+
+	virtual void clearDepthStencil(ID3D11DepthStencilView* depthStencilView,
+		unsigned int clearFlags, float depth, unsigned char stencil);
+
+	virtual void setViewport(const D3D11_VIEWPORT& viewport);
+
+	virtual void setRasterizerState(ID3D11RasterizerState* state);
+
+	virtual void setBlendState(ID3D11BlendState* state);
+
+	virtual void setDepthStencilState(ID3D11DepthStencilState* state);
+
+	virtual void setInputLayout(ID3D11InputLayout* inputLayout);
+
+	virtual void setVertexShader(ID3D11VertexShader* shader);
+
+	virtual void setGeometryShader(ID3D11GeometryShader* shader);
+
+	virtual void setPixelShader(ID3D11PixelShader* shader);
+
+	virtual void setVertexConstantBuffers(unsigned int startSlot, unsigned int count,
+		ID3D11Buffer* const* buffers);
+
+	virtual void setPixelConstantBuffers(unsigned int startSlot, unsigned int count,
+		ID3D11Buffer* const* buffers);
+
+	virtual bool supportsConstantBufferOffsets() const;
+
+	virtual void setVertexConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer,
+		unsigned int firstConstant, unsigned int constantCount);
+
+	virtual void setPixelConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer,
+		unsigned int firstConstant, unsigned int constantCount);
+
+	virtual void setPixelShaderResources(unsigned int startSlot, unsigned int count,
+		ID3D11ShaderResourceView* const* views);
+
+	virtual void setPixelSamplers(unsigned int startSlot, unsigned int count,
+		ID3D11SamplerState* const* samplers);
+
+	virtual void setPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology);
+
+	virtual void setVertexBuffers(unsigned int startSlot, unsigned int count,
+		ID3D11Buffer* const* buffers, const unsigned int* strides,
+		const unsigned int* offsets);
+
+	virtual void setIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format,
+		unsigned int offset);
+
+	virtual void updateBuffer(ID3D11Buffer* buffer, const void* data,
+		unsigned int dataSize);
+
+	virtual void* mapDiscard(ID3D11Buffer* buffer);
+
+	virtual void unmap(ID3D11Buffer* buffer);
+
+	virtual void drawIndexed(unsigned int indexCount, unsigned int startIndex,
+		int baseVertex);
+
+	virtual void drawIndexedInstanced(unsigned int indexCountPerInstance,
+		unsigned int instanceCount, unsigned int startIndex, int baseVertex,
+		unsigned int startInstance);
+
+	virtual HRESULT present(unsigned int syncInterval);
+
+private:
+	//Non-copyable.
+	bsNullRenderDevice(const bsNullRenderDevice&);
+	bsNullRenderDevice& operator=(const bsNullRenderDevice&);
+
+	//Writes a new unique handle to handleOut.
+	template <typename T>
+	HRESULT createHandle(T** handleOut);
+
+
+	tbb::atomic<unsigned int>	mCreatedObjectCount;
+	tbb::atomic<unsigned int>	mLiveObjectCount;
+
+	bool						mConstantBufferOffsets;
+
+	//Size of the largest buffer created with D3D11_CPU_ACCESS_WRITE.
+	tbb::atomic<unsigned int>	mLargestWritableBufferSize;
+	//Returned by mapDiscard, only used from the rendering thread.
+	std::vector<char>			mMapScratch;
+};
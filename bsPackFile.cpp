@@ -0,0 +1,230 @@
+#include "StdAfx.h"
+
+#include "bsPackFile.h"
+
+#include <algorithm>
+
+#include "bsCompression.h"
+#include "bsHash.h"
+#include "bsWindowsUtils.h"
+#include "bsLog.h"
+#include "bsAssert.h"
+
+
+bsPackFile::bsPackFile(const std::string& fileName)
+	: mFileName(fileName)
+	, mFileHandle(nullptr)
+	, mMappingHandle(nullptr)
+	, mMappedData(nullptr)
+	, mHeader(nullptr)
+	, mEntries(nullptr)
+	, mStringTable(nullptr)
+{
+	BS_ASSERT(!fileName.empty());
+
+	mFileHandle = CreateFileA(mFileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_READONLY | FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (mFileHandle == INVALID_HANDLE_VALUE)
+	{
+		BS_LOG_ERROR(IO, "Failed to open pack file '%s'. Error message: %s",
+			mFileName.c_str(),
+			bsWindowsUtils::winApiErrorCodeToString(GetLastError()).c_str());
+
+		mFileHandle = nullptr;
+
+		return;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (GetFileSizeEx(mFileHandle, &fileSize) == 0
+		|| fileSize.QuadPart < static_cast<LONGLONG>(sizeof(bsPackFileHeader)))
+	{
+		BS_LOG_ERROR(IO, "Pack file '%s' is too small to be valid",
+			mFileName.c_str());
+
+		close();
+
+		return;
+	}
+
+	mMappingHandle = CreateFileMappingA(mFileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mMappingHandle == nullptr)
+	{
+		BS_LOG_ERROR(IO, "Failed to create file mapping for pack file '%s'."
+			" Error message: %s", mFileName.c_str(),
+			bsWindowsUtils::winApiErrorCodeToString(GetLastError()).c_str());
+
+		close();
+
+		return;
+	}
+
+	mMappedData = static_cast<const char*>(MapViewOfFile(mMappingHandle, FILE_MAP_READ,
+		0, 0, 0));
+	if (mMappedData == nullptr)
+	{
+		BS_LOG_ERROR(IO, "Failed to map view of pack file '%s'."
+			" Error message: %s", mFileName.c_str(),
+			bsWindowsUtils::winApiErrorCodeToString(GetLastError()).c_str());
+
+		close();
+
+		return;
+	}
+
+	mHeader = reinterpret_cast<const bsPackFileHeader*>(mMappedData);
+
+	if (!validate(fileSize.QuadPart))
+	{
+		close();
+
+		return;
+	}
+
+	mEntries = reinterpret_cast<const bsPackFileEntry*>(mMappedData
+		+ mHeader->tableOfContentsOffset);
+	mStringTable = mMappedData + mHeader->stringTableOffset;
+
+	BS_LOG_INFO(IO, "Mounted pack file '%s' with %u entries",
+		mFileName.c_str(), mHeader->entryCount);
+}
+
+bsPackFile::~bsPackFile()
+{
+	close();
+}
+
+bool bsPackFile::validate(unsigned long long fileSize) const
+{
+	if (memcmp(mHeader->magic, "bspk", 4) != 0)
+	{
+		BS_LOG_ERROR(IO, "Bad file header in pack file '%s'",
+			mFileName.c_str());
+
+		return false;
+	}
+
+	if (mHeader->version != kPackFileVersion)
+	{
+		BS_LOG_ERROR(IO, "Pack file '%s' was created with version %u, expected"
+			" version %u", mFileName.c_str(), mHeader->version, kPackFileVersion);
+
+		return false;
+	}
+
+	//Offsets are compared against what is left of the file after them, so that
+	//corrupt offsets can't overflow the sums.
+	const unsigned long long tableOfContentsSize =
+		static_cast<unsigned long long>(mHeader->entryCount) * sizeof(bsPackFileEntry);
+
+	if (mHeader->tableOfContentsOffset > fileSize
+		|| tableOfContentsSize > fileSize - mHeader->tableOfContentsOffset
+		|| mHeader->stringTableOffset > fileSize
+		|| mHeader->stringTableSize > fileSize - mHeader->stringTableOffset
+		|| (mHeader->stringTableSize != 0 && mMappedData[mHeader->stringTableOffset
+		+ mHeader->stringTableSize - 1] != '\0'))
+	{
+		BS_LOG_ERROR(IO, "Pack file '%s' has a corrupt table of contents",
+			mFileName.c_str());
+
+		return false;
+	}
+
+	/*	Every entry must be fully contained in the file and refer to a valid name.
+		Uncompressed entries are copied or used in place with their original size, so it
+		must be their stored size.
+	*/
+	const bsPackFileEntry* entries = reinterpret_cast<const bsPackFileEntry*>(mMappedData
+		+ mHeader->tableOfContentsOffset);
+	for (unsigned int i = 0; i < mHeader->entryCount; ++i)
+	{
+		const bsPackFileEntry& entry = entries[i];
+
+		if (entry.storedSize > fileSize || entry.dataOffset > fileSize - entry.storedSize
+			|| (!(entry.flags & bsPackFileEntry::COMPRESSED)
+			&& entry.originalSize != entry.storedSize)
+			|| entry.nameOffset >= mHeader->stringTableSize
+			|| (i > 0 && entries[i - 1].nameHash > entry.nameHash))
+		{
+			BS_LOG_ERROR(IO, "Pack file '%s' has a corrupt entry at index %u",
+				mFileName.c_str(), i);
+
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void bsPackFile::close()
+{
+	if (mMappedData)
+	{
+		UnmapViewOfFile(mMappedData);
+		mMappedData = nullptr;
+	}
+	if (mMappingHandle)
+	{
+		CloseHandle(mMappingHandle);
+		mMappingHandle = nullptr;
+	}
+	if (mFileHandle)
+	{
+		CloseHandle(mFileHandle);
+		mFileHandle = nullptr;
+	}
+
+	mHeader = nullptr;
+	mEntries = nullptr;
+	mStringTable = nullptr;
+}
+
+const bsPackFileEntry* bsPackFile::findEntry(const char* name) const
+{
+	if (!isOpen())
+	{
+		return nullptr;
+	}
+
+	const unsigned long long nameHash = bsHash::fnv1a64(name);
+
+	const bsPackFileEntry* end = mEntries + mHeader->entryCount;
+	const bsPackFileEntry* itr = std::lower_bound(mEntries, end, nameHash,
+		[](const bsPackFileEntry& entry, unsigned long long hash)
+	{
+		return entry.nameHash < hash;
+	});
+
+	//Several names may share a hash, compare the names to find the right one.
+	for (; itr != end && itr->nameHash == nameHash; ++itr)
+	{
+		if (strcmp(getEntryName(*itr), name) == 0)
+		{
+			return itr;
+		}
+	}
+
+	return nullptr;
+}
+
+bool bsPackFile::readEntry(const bsPackFileEntry& entry, char* destination) const
+{
+	BS_ASSERT(isOpen());
+
+	if (entry.flags & bsPackFileEntry::COMPRESSED)
+	{
+		const bool success = bsCompression::decompress(getEntryData(entry), entry.storedSize,
+			destination, entry.originalSize);
+		if (!success)
+		{
+			BS_LOG_ERROR(IO, "Failed to decompress '%s' from pack file '%s'",
+				getEntryName(entry), mFileName.c_str());
+		}
+
+		return success;
+	}
+
+	memcpy(destination, getEntryData(entry), entry.originalSize);
+
+	return true;
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <string>
+
+#include <Windows.h>
+
+
+/*	Pack file layout, all values are little endian:
+
+Byte		Description
+1-4			File format identification, "bspk" (chars).
+5-8			Version information (uint).
+9-12		Amount of entries in the table of contents (uint).
+13-16		Alignment of entry data, in bytes (uint).
+17-24		Offset of the table of contents from the start of the file (uint64).
+25-32		Offset of the string table from the start of the file (uint64).
+33-36		Size of the string table, in bytes (uint).
+37-40		Unused.
+
+41-...		Entry data. Every entry starts at an offset which is a multiple of the
+				data alignment (bytes 13-16).
+
+...-...		bsPackFileEntry * entry count (defined by bytes 9-12), sorted by name hash.
+...-...		String table. Contains null terminated entry names, referenced by offset
+				from the entries.
+
+The table of contents is stored at the end of the file so that the builder can write entry
+data in a single pass.
+*/
+
+/*	Version info is stored in the header, and must be equal to this value when mounted.
+
+	Version history:
+	0: Initial version.
+*/
+const unsigned int kPackFileVersion = 0;
+
+
+#pragma pack(push, 1)
+struct bsPackFileHeader
+{
+	char				magic[4];
+	unsigned int		version;
+	unsigned int		entryCount;
+	unsigned int		dataAlignment;
+	unsigned long long	tableOfContentsOffset;
+	unsigned long long	stringTableOffset;
+	unsigned int		stringTableSize;
+	unsigned int		unused;
+};
+
+struct bsPackFileEntry
+{
+	enum Flags
+	{
+		//Data is compressed with bsCompression, storedSize is the compressed size.
+		COMPRESSED = 1 << 0,
+	};
+
+	//bsHash::fnv1a64 of the entry's name.
+	unsigned long long	nameHash;
+	//Offset of the entry's data from the start of the file.
+	unsigned long long	dataOffset;
+	//Size of the data in the pack.
+	unsigned int		storedSize;
+	//Size of the data after decompression. Equal to storedSize if not compressed.
+	unsigned int		originalSize;
+	//Offset of the null terminated name in the string table.
+	unsigned int		nameOffset;
+	unsigned int		flags;
+};
+#pragma pack(pop)
+
+
+/*	A read-only pack file containing many assets in a single file.
+	The whole pack is memory mapped on open, so uncompressed entries can be used directly
+	from the mapping without copying them.
+
+	Entries are identified by their file name only (no directories), the same way
+	bsFileSystem identifies loose files.
+*/
+class bsPackFile
+{
+public:
+	/*	Opens and memory maps the pack file.
+		Use isOpen to check whether the pack was successfully opened and validated.
+	*/
+	bsPackFile(const std::string& fileName);
+
+	~bsPackFile();
+
+
+	inline bool isOpen() const
+	{
+		return mMappedData != nullptr;
+	}
+
+	inline const std::string& getFileName() const
+	{
+		return mFileName;
+	}
+
+	inline unsigned int getEntryCount() const
+	{
+		return isOpen() ? mHeader->entryCount : 0;
+	}
+
+	/*	Finds the entry with the given name.
+		Returns null if no such entry exists in this pack.
+	*/
+	const bsPackFileEntry* findEntry(const char* name) const;
+
+	/*	Returns the name of an entry from this pack.
+	*/
+	inline const char* getEntryName(const bsPackFileEntry& entry) const
+	{
+		return mStringTable + entry.nameOffset;
+	}
+
+	/*	Returns a pointer to the stored (possibly compressed) data of an entry in this pack.
+		The data is valid for as long as the pack file is.
+	*/
+	inline const char* getEntryData(const bsPackFileEntry& entry) const
+	{
+		return mMappedData + entry.dataOffset;
+	}
+
+	/*	Copies the entry's data into destination, decompressing it if necessary.
+		The destination buffer must be at least entry.originalSize bytes.
+		Returns false if decompression failed.
+	*/
+	bool readEntry(const bsPackFileEntry& entry, char* destination) const;
+
+private:
+	/*	Validates the header and table of contents of the mapped file.
+		Returns false if the pack is corrupt or was created with a different version.
+	*/
+	bool validate(unsigned long long fileSize) const;
+
+	void close();
+
+
+	//Non-copyable.
+	bsPackFile(const bsPackFile&);
+	bsPackFile& operator=(const bsPackFile&);
+
+
+	const std::string	mFileName;
+
+	HANDLE			mFileHandle;
+	HANDLE			mMappingHandle;
+
+	const char*		mMappedData;
+
+	//Pointers into the mapped data.
+	const bsPackFileHeader*	mHeader;
+	const bsPackFileEntry*	mEntries;
+	const char*				mStringTable;
+};
@@ -0,0 +1,277 @@
+#ifndef BS_PACK_FILE_EXTERNAL
+#include "StdAfx.h"
+#endif
+
+#include "bsPackFileBuilder.h"
+
+#include <algorithm>
+#include <stdarg.h>
+#include <stdio.h>
+
+#include <boost/filesystem.hpp>
+
+#include "bsCompression.h"
+#include "bsHash.h"
+
+#ifndef BS_PACK_FILE_EXTERNAL
+#include "bsLog.h"
+#else
+extern void bsPackFileLogErrorMessage(const char*);
+#endif
+
+
+namespace
+{
+void logError(const char* format, ...)
+{
+	char buffer[1024];
+
+	va_list args;
+	va_start(args, format);
+	vsprintf_s(buffer, sizeof(buffer), format, args);
+	va_end(args);
+
+#ifndef BS_PACK_FILE_EXTERNAL
+	bsLog::log(buffer, bsLog::SEV_ERROR);
+#else
+	bsPackFileLogErrorMessage(buffer);
+#endif
+}
+
+//Writes zeroes until the offset is a multiple of alignment.
+bool writePadding(FILE* file, unsigned long long& offset, unsigned int alignment)
+{
+	static const char zeroes[256] = { 0 };
+
+	unsigned long long padding = (alignment - (offset % alignment)) % alignment;
+	offset += padding;
+
+	while (padding > 0)
+	{
+		const size_t toWrite = static_cast<size_t>(std::min<unsigned long long>(padding,
+			sizeof(zeroes)));
+		if (fwrite(zeroes, toWrite, 1, file) != 1)
+		{
+			return false;
+		}
+		padding -= toWrite;
+	}
+
+	return true;
+}
+
+bool readWholeFile(const std::string& path, std::vector<char>& dataOut)
+{
+#pragma warning (disable : 4996)//warning C4996: 'fopen' was declared deprecated
+	FILE* file = fopen(path.c_str(), "rb");
+#pragma warning (default : 4996)
+	if (!file)
+	{
+		return false;
+	}
+
+	boost::system::error_code errorCode;
+	const boost::uintmax_t fileSize = boost::filesystem::file_size(path, errorCode);
+	if (errorCode || fileSize > 0xFFFFFFFF)
+	{
+		fclose(file);
+
+		return false;
+	}
+
+	dataOut.resize(static_cast<size_t>(fileSize));
+	const bool success = fileSize == 0 || fread(&dataOut[0], dataOut.size(), 1, file) == 1;
+
+	fclose(file);
+
+	return success;
+}
+}
+
+
+bsPackFileBuilder::bsPackFileBuilder(unsigned int dataAlignment)
+	: mDataAlignment(dataAlignment)
+{
+	if (mDataAlignment == 0 || (mDataAlignment & (mDataAlignment - 1)) != 0)
+	{
+		logError("Pack file data alignment must be a power of two, was %u. Using 16 instead",
+			dataAlignment);
+
+		mDataAlignment = 16;
+	}
+}
+
+bool bsPackFileBuilder::addFile(const std::string& filePath, bool compress)
+{
+	FileToPack file;
+	file.name = boost::filesystem::path(filePath).filename().string();
+	file.path = filePath;
+	file.nameHash = bsHash::fnv1a64(file.name.c_str());
+	file.compress = compress;
+
+	for (size_t i = 0; i < mFiles.size(); ++i)
+	{
+		if (mFiles[i].nameHash == file.nameHash && mFiles[i].name == file.name)
+		{
+			logError("Duplicate file found, file name: '%s' with path '%s'. Will use"
+				" previously found path '%s' instead", file.name.c_str(), filePath.c_str(),
+				mFiles[i].path.c_str());
+
+			return false;
+		}
+	}
+
+	mFiles.push_back(file);
+
+	return true;
+}
+
+unsigned int bsPackFileBuilder::addDirectory(const std::string& directory, bool compress)
+{
+	boost::filesystem::recursive_directory_iterator itr(directory);
+	boost::filesystem::recursive_directory_iterator end;
+
+	unsigned int filesAdded = 0;
+
+	for (; itr != end; ++itr)
+	{
+		if (boost::filesystem::is_regular_file(itr->path()))
+		{
+			if (addFile(itr->path().string(), compress))
+			{
+				++filesAdded;
+			}
+		}
+	}
+
+	return filesAdded;
+}
+
+bool bsPackFileBuilder::write(const std::string& packFileName) const
+{
+#pragma warning (disable : 4996)//warning C4996: 'fopen' was declared deprecated
+	FILE* file = fopen(packFileName.c_str(), "wb");
+#pragma warning (default : 4996)
+	if (!file)
+	{
+		logError("Failed to open '%s' for writing", packFileName.c_str());
+
+		return false;
+	}
+
+	//Sort by hash so that the reader can binary search the table of contents.
+	std::vector<const FileToPack*> sortedFiles(mFiles.size());
+	for (size_t i = 0; i < mFiles.size(); ++i)
+	{
+		sortedFiles[i] = &mFiles[i];
+	}
+	std::stable_sort(sortedFiles.begin(), sortedFiles.end(),
+		[](const FileToPack* a, const FileToPack* b)
+	{
+		return a->nameHash < b->nameHash;
+	});
+
+	bsPackFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "bspk", 4);
+	header.version = kPackFileVersion;
+	header.entryCount = sortedFiles.size();
+	header.dataAlignment = mDataAlignment;
+
+	//Header is rewritten once the offsets are known.
+	bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+	unsigned long long offset = sizeof(header);
+
+	std::vector<bsPackFileEntry> entries(sortedFiles.size());
+	std::string stringTable;
+
+	std::vector<char> fileData;
+	std::vector<char> compressedData;
+
+	for (size_t i = 0; success && i < sortedFiles.size(); ++i)
+	{
+		const FileToPack& fileToPack = *sortedFiles[i];
+
+		if (!readWholeFile(fileToPack.path, fileData))
+		{
+			logError("Failed to read '%s'", fileToPack.path.c_str());
+
+			success = false;
+			break;
+		}
+
+		const char* dataToWrite = fileData.empty() ? nullptr : &fileData[0];
+		unsigned int sizeToWrite = fileData.size();
+
+		bsPackFileEntry& entry = entries[i];
+		entry.nameHash = fileToPack.nameHash;
+		entry.originalSize = fileData.size();
+		entry.nameOffset = stringTable.size();
+		entry.flags = 0;
+
+		//Only store the compressed data if it's actually smaller.
+		if (fileToPack.compress && !fileData.empty())
+		{
+			compressedData.resize(fileData.size());
+			const unsigned int compressedSize = bsCompression::compress(&fileData[0],
+				fileData.size(), &compressedData[0], compressedData.size());
+
+			if (compressedSize != 0 && compressedSize < fileData.size())
+			{
+				dataToWrite = &compressedData[0];
+				sizeToWrite = compressedSize;
+				entry.flags |= bsPackFileEntry::COMPRESSED;
+			}
+		}
+
+		stringTable.append(fileToPack.name);
+		stringTable.push_back('\0');
+
+		success = writePadding(file, offset, mDataAlignment);
+
+		entry.dataOffset = offset;
+		entry.storedSize = sizeToWrite;
+
+		if (success && sizeToWrite > 0)
+		{
+			success = fwrite(dataToWrite, sizeToWrite, 1, file) == 1;
+		}
+		offset += sizeToWrite;
+	}
+
+	if (success)
+	{
+		//Table of contents is read directly from the mapping, keep it 8 byte aligned.
+		success = writePadding(file, offset, 8);
+
+		header.tableOfContentsOffset = offset;
+		if (success && !entries.empty())
+		{
+			success = fwrite(&entries[0], sizeof(bsPackFileEntry) * entries.size(), 1,
+				file) == 1;
+		}
+		offset += sizeof(bsPackFileEntry) * entries.size();
+
+		header.stringTableOffset = offset;
+		header.stringTableSize = stringTable.size();
+		if (success && !stringTable.empty())
+		{
+			success = fwrite(stringTable.data(), stringTable.size(), 1, file) == 1;
+		}
+	}
+
+	if (success)
+	{
+		success = fseek(file, 0, SEEK_SET) == 0
+			&& fwrite(&header, sizeof(header), 1, file) == 1;
+	}
+
+	if (!success)
+	{
+		logError("Failed to write pack file '%s'", packFileName.c_str());
+	}
+
+	fclose(file);
+
+	return success;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "bsPackFile.h"
+
+
+/*	Creates pack files readable by bsPackFile.
+
+	Files are added by name, and the data is read from disk when write is called, so adding
+	files is cheap. Entry names are file names without directories, so adding two files with
+	the same name is not allowed; the first file added is kept.
+
+	Define BS_PACK_FILE_EXTERNAL when using this outside the engine. Errors will then be
+	reported with bsPackFileLogErrorMessage, which must be defined by the user.
+*/
+class bsPackFileBuilder
+{
+public:
+	/*	Data alignment is the alignment of every entry's data in the pack, and must be a
+		power of two.
+	*/
+	bsPackFileBuilder(unsigned int dataAlignment = 16);
+
+	/*	Adds a single file. If compress is true, the file will be compressed if that makes
+		it smaller.
+		Returns false if a file with the same name has already been added.
+	*/
+	bool addFile(const std::string& filePath, bool compress);
+
+	/*	Adds every file in the directory and all its sub directories.
+		Returns the number of files added.
+	*/
+	unsigned int addDirectory(const std::string& directory, bool compress);
+
+	/*	Writes the pack file.
+		Returns false if writing failed or any of the added files could not be read.
+	*/
+	bool write(const std::string& packFileName) const;
+
+	inline unsigned int getFileCount() const
+	{
+		return mFiles.size();
+	}
+
+private:
+	struct FileToPack
+	{
+		std::string			name;
+		std::string			path;
+		unsigned long long	nameHash;
+		bool				compress;
+	};
+
+	unsigned int			mDataAlignment;
+	std::vector<FileToPack>	mFiles;
+};
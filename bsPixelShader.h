@@ -3,6 +3,8 @@
 
 #include <d3d11.h>
 
+#include "bsRenderDevice.h"
+
 struct ID3D11PixelShader;
 
 
@@ -14,15 +16,18 @@ class bsPixelShader
 	friend class bsShaderManager;
 
 public:
-	bsPixelShader(ID3D11PixelShader* pixelShader, unsigned int id)
+	//The shader is released through the device which created it.
+	bsPixelShader(ID3D11PixelShader* pixelShader, bsRenderDevice& renderDevice,
+		unsigned int id)
 		: mPixelShader(pixelShader)
+		, mRenderDevice(&renderDevice)
 		, mID(id)
 	{
 	}
 
 	~bsPixelShader()
 	{
-		mPixelShader->Release();
+		mRenderDevice->release(mPixelShader);
 	}
 
 	inline ID3D11PixelShader* getD3dPixelShader() const
@@ -36,5 +41,6 @@ private:
 	void operator=(const bsPixelShader&);
 
 	ID3D11PixelShader*	mPixelShader;
+	bsRenderDevice*		mRenderDevice;
 	unsigned int		mID;
 };
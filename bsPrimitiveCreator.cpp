@@ -24,7 +24,8 @@
 bsPrimitiveCreator::bsPrimitiveCreator(bsMeshCache& meshCache, bsMaterialCache& materialCache,
 	bsTextureCache& textureCache)
 	: mMeshCache(meshCache)
-	, mDefaultMaterial(materialCache.createNewMaterial("Primitive default material"))
+	, mDefaultMaterial(materialCache.createNewMaterial(
+		bsStringId("Primitive default material")))
 {
 	mDefaultMaterial->diffuse = textureCache.getDefaultTexture();
 }
@@ -34,8 +35,8 @@ bsEntity* bsPrimitiveCreator::createSphere(float radius) const
 	BS_ASSERT2(radius > 0.0f, "A sphere's radius must be positive and non-zero");
 
 	bsEntity* entity = new bsEntity();
-	entity->attachMeshRenderer(*new bsMeshRenderer(mMeshCache.getMesh("sphere_1m_d.bsm"),
-		mDefaultMaterial));
+	entity->attachMeshRenderer(*new bsMeshRenderer(
+		mMeshCache.getMesh(bsStringId("sphere_1m_d.bsm")), mDefaultMaterial));
 
 	hkpRigidBodyCinfo rbCinfo;
 	rbCinfo.m_shape = new hkpSphereShape(radius);
@@ -68,8 +69,8 @@ bsEntity* bsPrimitiveCreator::createBox(const XMVECTOR& halfExtents) const
 		" direction");
 
 	bsEntity* entity = new bsEntity();
-	entity->attachMeshRenderer(*new bsMeshRenderer(mMeshCache.getMesh("unit_cube.bsm"),
-		mDefaultMaterial));
+	entity->attachMeshRenderer(*new bsMeshRenderer(
+		mMeshCache.getMesh(bsStringId("unit_cube.bsm")), mDefaultMaterial));
 
 	hkVector4 halfExt(bsMath::toHK(halfExtents));
 	//Subtract convex radius from the half extents to prevent the box from
@@ -108,8 +109,8 @@ bsEntity* bsPrimitiveCreator::createPlane(const XMVECTOR& halfExtents) const
 		" both X and Z");
 
 	bsEntity* entity = new bsEntity();
-	entity->attachMeshRenderer(*new bsMeshRenderer(mMeshCache.getMesh("plane_1m.bsm"),
-		mDefaultMaterial));
+	entity->attachMeshRenderer(*new bsMeshRenderer(
+		mMeshCache.getMesh(bsStringId("plane_1m.bsm")), mDefaultMaterial));
 
 	XMFLOAT4A halfExtents4A;
 	XMStoreFloat4A(&halfExtents4A, halfExtents);
@@ -147,8 +148,8 @@ bsEntity* bsPrimitiveCreator::createCapsule(float height, float radius) const
 	//Capsule mesh dimensions: vertex0: (0, 0.5, 0), vertex1: (0, 1.5, 0), radius: 0.5
 
 	bsEntity* entity = new bsEntity();
-	entity->attachMeshRenderer(*new bsMeshRenderer(mMeshCache.getMesh("capsule.bsm"),
-		mDefaultMaterial));
+	entity->attachMeshRenderer(*new bsMeshRenderer(
+		mMeshCache.getMesh(bsStringId("capsule.bsm")), mDefaultMaterial));
 
 	const hkVector4 vertexBottom(0.0f, radius, 0.0f);
 	const hkVector4 vertexTop(0.0f, height - radius, 0.0f);
@@ -194,8 +195,8 @@ bsEntity* bsPrimitiveCreator::createCylinder(float height, float radius) const
 	//Cylinder mesh dimensions: vertex0: (0, 0, 0), vertex1: (0, 2, 0), radius: 0.5
 
 	bsEntity* entity = new bsEntity();
-	entity->attachMeshRenderer(*new bsMeshRenderer(mMeshCache.getMesh("cylinder.bsm"),
-		mDefaultMaterial));
+	entity->attachMeshRenderer(*new bsMeshRenderer(
+		mMeshCache.getMesh(bsStringId("cylinder.bsm")), mDefaultMaterial));
 
 	//Bake convex radius into the cylinder's shape.
 	const hkVector4 vertexBottom(0.0f, hkConvexShapeDefaultRadius, 0.0f);
@@ -0,0 +1,263 @@
+#include "StdAfx.h"
+
+#include "bsProfiler.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include <intrin.h>
+
+#include <tbb/atomic.h>
+#include <tbb/spin_mutex.h>
+
+
+#ifndef BS_DISABLE_FEATURE_PROFILING
+
+static_assert((bsProfiler::kEventsPerThread & (bsProfiler::kEventsPerThread - 1)) == 0,
+	"kEventsPerThread must be a power of two");
+
+
+//A single zone. The timestamps are in cycle counter ticks.
+struct bsProfileEvent
+{
+	const char*			name;
+	unsigned long long	begin;
+	//0 while the zone is open.
+	unsigned long long	end;
+	unsigned int		depth;
+};
+
+namespace
+{
+struct ThreadBuffer
+{
+	bsProfileEvent				events[bsProfiler::kEventsPerThread];
+
+	//Zones started on this thread so far. Only written by the owning thread.
+	tbb::atomic<unsigned int>	eventCount;
+	//Currently open zones, including ones too deep to be recorded.
+	unsigned int				depth;
+
+	DWORD						threadId;
+	char						name[32];
+};
+
+__declspec(thread) ThreadBuffer* gThreadBuffer = nullptr;
+
+//Every thread's buffer, kept after the thread exits so its zones can be exported.
+tbb::spin_mutex				gBuffersMutex;
+std::vector<ThreadBuffer*>	gBuffers;
+
+//Set by calibrate before the first buffer is created.
+double				gTicksPerMicroSecond = 0.0;
+//Exported traces start at this timestamp.
+unsigned long long	gStartTicks = 0;
+
+
+/*	Measures the cycle counter's rate against the performance counter.
+	Busy waits for 10 ms, once, when the first zone is recorded.
+*/
+void calibrate()
+{
+	const long long startTime = bsTimer::getTicks();
+	const unsigned long long startTicks = __rdtsc();
+
+	double elapsedMicroSeconds = 0.0;
+	while (elapsedMicroSeconds < 10000.0)
+	{
+		const long long elapsed = bsTimer::getTicks() - startTime;
+		elapsedMicroSeconds = bsTimer::ticksToMicroSeconds(elapsed);
+	}
+
+	gStartTicks = __rdtsc();
+	gTicksPerMicroSecond = (gStartTicks - startTicks) / elapsedMicroSeconds;
+}
+
+ThreadBuffer& getThreadBuffer()
+{
+	if (gThreadBuffer == nullptr)
+	{
+		ThreadBuffer* buffer = new ThreadBuffer;
+		buffer->eventCount = 0;
+		buffer->depth = 0;
+		buffer->threadId = GetCurrentThreadId();
+		buffer->name[0] = '\0';
+
+		tbb::spin_mutex::scoped_lock lock(gBuffersMutex);
+		if (gBuffers.empty())
+		{
+			calibrate();
+		}
+		gBuffers.push_back(buffer);
+
+		gThreadBuffer = buffer;
+	}
+
+	return *gThreadBuffer;
+}
+
+//Writes a string as a JSON string, with quotes.
+void writeJsonString(FILE* file, const char* string)
+{
+	fputc('"', file);
+	for (const char* c = string; *c != '\0'; ++c)
+	{
+		if (*c == '"' || *c == '\\')
+		{
+			fputc('\\', file);
+		}
+		fputc(*c, file);
+	}
+	fputc('"', file);
+}
+}
+
+
+bsProfileScope::bsProfileScope(const char* name, float* durationMs)
+	: mEvent(nullptr)
+	, mEventIndex(0)
+	, mDurationMs(durationMs)
+{
+	ThreadBuffer& buffer = getThreadBuffer();
+
+	if (buffer.depth < bsProfiler::kMaxDepth)
+	{
+		mEventIndex = buffer.eventCount;
+		mEvent = &buffer.events[mEventIndex & (bsProfiler::kEventsPerThread - 1)];
+		mEvent->name = name;
+		mEvent->end = 0;
+		mEvent->depth = buffer.depth;
+
+		//Publishes the event to writeChromeTrace.
+		buffer.eventCount = mEventIndex + 1;
+	}
+	++buffer.depth;
+
+	mBegin = __rdtsc();
+	if (mEvent != nullptr)
+	{
+		mEvent->begin = mBegin;
+	}
+}
+
+bsProfileScope::~bsProfileScope()
+{
+	const unsigned long long end = __rdtsc();
+
+	ThreadBuffer& buffer = *gThreadBuffer;
+	--buffer.depth;
+
+	//The event may have been overwritten if this zone contained a full ring of others.
+	if (mEvent != nullptr
+		&& buffer.eventCount - mEventIndex <= bsProfiler::kEventsPerThread)
+	{
+		mEvent->end = end;
+	}
+
+	if (mDurationMs != nullptr)
+	{
+		*mDurationMs += static_cast<float>((end - mBegin) / gTicksPerMicroSecond * 0.001);
+	}
+}
+
+
+void bsProfiler::setThreadName(const char* name)
+{
+	ThreadBuffer& buffer = getThreadBuffer();
+
+	strncpy_s(buffer.name, name, _TRUNCATE);
+}
+
+bool bsProfiler::writeChromeTrace(const std::string& fileName)
+{
+#pragma warning (disable : 4996)//warning C4996: 'fopen' was declared deprecated
+	FILE* file = fopen(fileName.c_str(), "w");
+#pragma warning (default : 4996)
+	if (!file)
+	{
+		return false;
+	}
+
+	//Buffers are never removed before shutdown, so a copy of the list stays valid.
+	std::vector<ThreadBuffer*> buffers;
+	{
+		tbb::spin_mutex::scoped_lock lock(gBuffersMutex);
+		buffers = gBuffers;
+	}
+
+	fprintf(file, "{\"traceEvents\":[\n");
+	bool first = true;
+
+	for (size_t i = 0; i < buffers.size(); ++i)
+	{
+		const ThreadBuffer& buffer = *buffers[i];
+
+		if (buffer.name[0] != '\0')
+		{
+			fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+				"\"tid\":%lu,\"args\":{\"name\":", first ? "" : ",\n", buffer.threadId);
+			writeJsonString(file, buffer.name);
+			fprintf(file, "}}");
+			first = false;
+		}
+
+		const unsigned int eventCount = buffer.eventCount;
+		const unsigned int firstEvent = eventCount > kEventsPerThread
+			? eventCount - kEventsPerThread : 0;
+
+		for (unsigned int j = firstEvent; j < eventCount; ++j)
+		{
+			const bsProfileEvent event = buffer.events[j & (kEventsPerThread - 1)];
+			if (event.end == 0 || event.end < event.begin || event.begin < gStartTicks)
+			{
+				continue;
+			}
+
+			fprintf(file, "%s{\"name\":", first ? "" : ",\n");
+			writeJsonString(file, event.name);
+			fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f}",
+				buffer.threadId, (event.begin - gStartTicks) / gTicksPerMicroSecond,
+				(event.end - event.begin) / gTicksPerMicroSecond);
+			first = false;
+		}
+	}
+
+	fprintf(file, "\n]}\n");
+
+	const bool success = ferror(file) == 0;
+	fclose(file);
+
+	return success;
+}
+
+void bsProfiler::shutdown()
+{
+	tbb::spin_mutex::scoped_lock lock(gBuffersMutex);
+
+	for (size_t i = 0; i < gBuffers.size(); ++i)
+	{
+		delete gBuffers[i];
+	}
+	gBuffers.clear();
+
+	gThreadBuffer = nullptr;
+}
+
+#else // BS_DISABLE_FEATURE_PROFILING
+
+void bsProfiler::setThreadName(const char*)
+{
+}
+
+bool bsProfiler::writeChromeTrace(const std::string&)
+{
+	return true;
+}
+
+void bsProfiler::shutdown()
+{
+}
+
+#endif // BS_DISABLE_FEATURE_PROFILING
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <string>
+
+#include <Windows.h>
+
+#include "bsTimer.h"
+
+struct bsProfileEvent;
+
+
+/*	Hierarchical CPU profiler.
+
+	Code is instrumented with scoped zones, which record when they start and end:
+
+	void bsRenderQueue::drawLines()
+	{
+		BS_PROFILE_SCOPE("Draw lines");
+		...
+	}
+
+	Zones can be nested, and can be used on any thread. Every thread which opens a zone
+	gets a ring buffer holding its most recent kEventsPerThread zones, so recording never
+	takes a lock or allocates. Timestamps come from the processor's cycle counter, which
+	is assumed to be invariant (constant rate and synchronized between cores), as it is
+	on processors from the last several years.
+
+	The recorded zones of all threads can be written to a file in Chrome's trace event
+	format with writeChromeTrace, and viewed in chrome://tracing.
+
+	BS_PROFILE_SCOPE_STAT also adds the zone's duration to a float, in milliseconds,
+	which is how the durations in bsFrameStatistics are measured.
+
+	Defining BS_DISABLE_FEATURE_PROFILING, as shipping builds should, removes the zones
+	entirely. BS_PROFILE_SCOPE then expands to nothing, and BS_PROFILE_SCOPE_STAT to a
+	plain timer, so frame statistics keep working.
+*/
+namespace bsProfiler
+{
+//Zones kept per thread. Older zones are overwritten.
+const unsigned int kEventsPerThread = 16384;
+
+//Zones nested deeper than this are not recorded.
+const unsigned int kMaxDepth = 64;
+
+/*	Names the calling thread in exported traces. The name is copied, and is limited to
+	31 characters.
+*/
+void setThreadName(const char* name);
+
+/*	Writes every thread's recorded zones to a file in Chrome's trace event JSON format.
+	Zones which are still open are left out. Threads may keep recording while this
+	runs, but zones overwritten during the export may then be missing or garbled, so
+	prefer calling it while the engine is idle, such as on shutdown.
+	Returns false if the file could not be written.
+*/
+bool writeChromeTrace(const std::string& fileName);
+
+/*	Frees every thread's ring buffer.
+	Call during shutdown, after all threads which may have recorded zones are done.
+*/
+void shutdown();
+}
+
+
+/*	Adds the time between construction and destruction to a float, in milliseconds.
+	Used by BS_PROFILE_SCOPE_STAT when profiling is disabled.
+*/
+class bsScopedDuration
+{
+public:
+	explicit bsScopedDuration(float& durationMs)
+		: mDurationMs(durationMs)
+		, mStartTicks(bsTimer::getTicks())
+	{
+	}
+
+	~bsScopedDuration()
+	{
+		mDurationMs += static_cast<float>(
+			bsTimer::ticksToMicroSeconds(bsTimer::getTicks() - mStartTicks) * 0.001);
+	}
+
+private:
+	//Non-copyable.
+	bsScopedDuration(const bsScopedDuration&);
+	bsScopedDuration& operator=(const bsScopedDuration&);
+
+	float&			mDurationMs;
+	const long long	mStartTicks;
+};
+
+
+#define BS_PROFILE_CONCATENATE_IMPL(a, b) a##b
+#define BS_PROFILE_CONCATENATE(a, b) BS_PROFILE_CONCATENATE_IMPL(a, b)
+
+#ifndef BS_DISABLE_FEATURE_PROFILING
+
+/*	Records a zone lasting from its construction to its destruction.
+	Use BS_PROFILE_SCOPE instead of creating these directly.
+*/
+class bsProfileScope
+{
+public:
+	/*	The name is not copied, and must outlive the profiler. String literals are fine.
+		If durationMs is not null, the zone's duration is added to it when it ends.
+	*/
+	explicit bsProfileScope(const char* name, float* durationMs = nullptr);
+
+	~bsProfileScope();
+
+private:
+	//Non-copyable.
+	bsProfileScope(const bsProfileScope&);
+	bsProfileScope& operator=(const bsProfileScope&);
+
+	//The event this scope is recording, null if it was nested too deep.
+	bsProfileEvent*		mEvent;
+	//The thread's event count when the event was started.
+	unsigned int		mEventIndex;
+	unsigned long long	mBegin;
+	float*				mDurationMs;
+};
+
+#define BS_PROFILE_SCOPE(name)															 \
+	bsProfileScope BS_PROFILE_CONCATENATE(profileScope, __LINE__)(name)
+
+#define BS_PROFILE_SCOPE_STAT(name, durationMs)											 \
+	bsProfileScope BS_PROFILE_CONCATENATE(profileScope, __LINE__)(name, &(durationMs))
+
+#else // BS_DISABLE_FEATURE_PROFILING
+
+#define BS_PROFILE_SCOPE(name) do {} while (false)
+
+#define BS_PROFILE_SCOPE_STAT(name, durationMs)											 \
+	bsScopedDuration BS_PROFILE_CONCATENATE(profileScope, __LINE__)(durationMs)
+
+#endif // BS_DISABLE_FEATURE_PROFILING
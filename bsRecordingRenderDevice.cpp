@@ -0,0 +1,379 @@
+#include "StdAfx.h"
+
+#include "bsRecordingRenderDevice.h"
+
+#include <cstring>
+
+#include "bsAssert.h"
+
+
+bsRecordingRenderDevice::bsRecordingRenderDevice(bsRenderDevice& target)
+	: mTarget(target)
+{
+	mCommands.reserve(4096);
+
+	clear();
+}
+
+void bsRecordingRenderDevice::clear()
+{
+	mCommands.clear();
+	memset(mCommandCounts, 0, sizeof(mCommandCounts));
+	mUpdatedByteCount = 0;
+
+	mCreatedObjectCount = 0;
+	mReleasedObjectCount = 0;
+}
+
+const char* bsRecordingRenderDevice::getCommandTypeName(CommandType type)
+{
+	static const char* names[COMMAND_TYPE_COUNT] =
+	{
+		"setRenderTargets",
+		"clearRenderTarget",
+		"clearDepthStencil",
+		"setViewport",
+		"setRasterizerState",
+		"setBlendState",
+		"setDepthStencilState",
+		"setInputLayout",
+		"setVertexShader",
+		"setGeometryShader",
+		"setPixelShader",
+		"setVertexConstantBuffers",
+		"setPixelConstantBuffers",
+		"setVertexConstantBufferRange",
+		"setPixelConstantBufferRange",
+		"setPixelShaderResources",
+		"setPixelSamplers",
+		"setPrimitiveTopology",
+		"setVertexBuffers",
+		"setIndexBuffer",
+		"updateBuffer",
+		"mapDiscard",
+		"unmap",
+		"drawIndexed",
+		"drawIndexedInstanced",
+		"present",
+	};
+
+	BS_ASSERT(type < COMMAND_TYPE_COUNT);
+
+	return names[type];
+}
+
+void bsRecordingRenderDevice::record(CommandType type, unsigned int slot,
+	unsigned int count, unsigned int value, const void* object)
+{
+	Command command;
+	command.type = static_cast<unsigned short>(type);
+	command.slot = static_cast<unsigned short>(slot);
+	command.count = count;
+	command.value = value;
+	command.object = object;
+
+	mCommands.push_back(command);
+	++mCommandCounts[type];
+}
+
+HRESULT bsRecordingRenderDevice::countCreated(HRESULT result)
+{
+	if (SUCCEEDED(result))
+	{
+		++mCreatedObjectCount;
+	}
+
+	return result;
+}
+
+HRESULT bsRecordingRenderDevice::createBuffer(const D3D11_BUFFER_DESC& desc,
+	const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Buffer** bufferOut)
+{
+	return countCreated(mTarget.createBuffer(desc, initialData, bufferOut));
+}
+
+HRESULT bsRecordingRenderDevice::createTexture2D(const D3D11_TEXTURE2D_DESC& desc,
+	const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Texture2D** textureOut)
+{
+	return countCreated(mTarget.createTexture2D(desc, initialData, textureOut));
+}
+
+HRESULT bsRecordingRenderDevice::createRenderTargetView(ID3D11Resource* resource,
+	const D3D11_RENDER_TARGET_VIEW_DESC* desc, ID3D11RenderTargetView** viewOut)
+{
+	return countCreated(mTarget.createRenderTargetView(resource, desc, viewOut));
+}
+
+HRESULT bsRecordingRenderDevice::createShaderResourceView(ID3D11Resource* resource,
+	const D3D11_SHADER_RESOURCE_VIEW_DESC* desc, ID3D11ShaderResourceView** viewOut)
+{
+	return countCreated(mTarget.createShaderResourceView(resource, desc, viewOut));
+}
+
+HRESULT bsRecordingRenderDevice::createDepthStencilView(ID3D11Resource* resource,
+	const D3D11_DEPTH_STENCIL_VIEW_DESC* desc, ID3D11DepthStencilView** viewOut)
+{
+	return countCreated(mTarget.createDepthStencilView(resource, desc, viewOut));
+}
+
+HRESULT bsRecordingRenderDevice::createRasterizerState(const D3D11_RASTERIZER_DESC& desc,
+	ID3D11RasterizerState** stateOut)
+{
+	return countCreated(mTarget.createRasterizerState(desc, stateOut));
+}
+
+HRESULT bsRecordingRenderDevice::createBlendState(const D3D11_BLEND_DESC& desc,
+	ID3D11BlendState** stateOut)
+{
+	return countCreated(mTarget.createBlendState(desc, stateOut));
+}
+
+HRESULT bsRecordingRenderDevice::createDepthStencilState(
+	const D3D11_DEPTH_STENCIL_DESC& desc, ID3D11DepthStencilState** stateOut)
+{
+	return countCreated(mTarget.createDepthStencilState(desc, stateOut));
+}
+
+HRESULT bsRecordingRenderDevice::createSamplerState(const D3D11_SAMPLER_DESC& desc,
+	ID3D11SamplerState** stateOut)
+{
+	return countCreated(mTarget.createSamplerState(desc, stateOut));
+}
+
+HRESULT bsRecordingRenderDevice::createVertexShader(const void* byteCode,
+	size_t byteCodeSize, ID3D11VertexShader** shaderOut)
+{
+	return countCreated(mTarget.createVertexShader(byteCode, byteCodeSize, shaderOut));
+}
+
+HRESULT bsRecordingRenderDevice::createPixelShader(const void* byteCode,
+	size_t byteCodeSize, ID3D11PixelShader** shaderOut)
+{
+	return countCreated(mTarget.createPixelShader(byteCode, byteCodeSize, shaderOut));
+}
+
+HRESULT bsRecordingRenderDevice::createInputLayout(
+	const D3D11_INPUT_ELEMENT_DESC* inputDescs, unsigned int inputDescCount,
+	const void* byteCode, size_t byteCodeSize, ID3D11InputLayout** layoutOut)
+{
+	return countCreated(mTarget.createInputLayout(inputDescs, inputDescCount, byteCode,
+		byteCodeSize, layoutOut));
+}
+
+unsigned long bsRecordingRenderDevice::release(ID3D11DeviceChild* object)
+{
+	++mReleasedObjectCount;
+
+	return mTarget.release(object);
+}
+
+void bsRecordingRenderDevice::setDebugName(ID3D11DeviceChild* object, const char* name)
+{
+	mTarget.setDebugName(object, name);
+}
+
+void bsRecordingRenderDevice::setRenderTargets(unsigned int count,
+	ID3D11RenderTargetView* const* renderTargetViews,
+	ID3D11DepthStencilView* depthStencilView)
+{
+	record(SET_RENDER_TARGETS, 0, count, 0, count != 0 ? renderTargetViews[0] : nullptr);
+
+	mTarget.setRenderTargets(count, renderTargetViews, depthStencilView);
+}
+
+void bsRecordingRenderDevice::clearRenderTarget(ID3D11RenderTargetView* renderTargetView,
+	const float* colorRgba)
+{
+	record(CLEAR_RENDER_TARGET, 0, 1, 0, renderTargetView);
+
+	mTarget.clearRenderTarget(renderTargetView, colorRgba);
+}
+
+void bsRecordingRenderDevice::clearDepthStencil(ID3D11DepthStencilView* depthStencilView,
+	unsigned int clearFlags, float depth, unsigned char stencil)
+{
+	record(CLEAR_DEPTH_STENCIL, 0, 1, clearFlags, depthStencilView);
+
+	mTarget.clearDepthStencil(depthStencilView, clearFlags, depth, stencil);
+}
+
+void bsRecordingRenderDevice::setViewport(const D3D11_VIEWPORT& viewport)
+{
+	record(SET_VIEWPORT, 0, 1, 0, nullptr);
+
+	mTarget.setViewport(viewport);
+}
+
+void bsRecordingRenderDevice::setRasterizerState(ID3D11RasterizerState* state)
+{
+	record(SET_RASTERIZER_STATE, 0, 1, 0, state);
+
+	mTarget.setRasterizerState(state);
+}
+
+void bsRecordingRenderDevice::setBlendState(ID3D11BlendState* state)
+{
+	record(SET_BLEND_STATE, 0, 1, 0, state);
+
+	mTarget.setBlendState(state);
+}
+
+void bsRecordingRenderDevice::setDepthStencilState(ID3D11DepthStencilState* state)
+{
+	record(SET_DEPTH_STENCIL_STATE, 0, 1, 0, state);
+
+	mTarget.setDepthStencilState(state);
+}
+
+void bsRecordingRenderDevice::setInputLayout(ID3D11InputLayout* inputLayout)
+{
+	record(SET_INPUT_LAYOUT, 0, 1, 0, inputLayout);
+
+	mTarget.setInputLayout(inputLayout);
+}
+
+void bsRecordingRenderDevice::setVertexShader(ID3D11VertexShader* shader)
+{
+	record(SET_VERTEX_SHADER, 0, 1, 0, shader);
+
+	mTarget.setVertexShader(shader);
+}
+
+void bsRecordingRenderDevice::setGeometryShader(ID3D11GeometryShader* shader)
+{
+	record(SET_GEOMETRY_SHADER, 0, 1, 0, shader);
+
+	mTarget.setGeometryShader(shader);
+}
+
+void bsRecordingRenderDevice::setPixelShader(ID3D11PixelShader* shader)
+{
+	record(SET_PIXEL_SHADER, 0, 1, 0, shader);
+
+	mTarget.setPixelShader(shader);
+}
+
+void bsRecordingRenderDevice::setVertexConstantBuffers(unsigned int startSlot,
+	unsigned int count, ID3D11Buffer* const* buffers)
+{
+	record(SET_VERTEX_CONSTANT_BUFFERS, startSlot, count, 0, buffers[0]);
+
+	mTarget.setVertexConstantBuffers(startSlot, count, buffers);
+}
+
+void bsRecordingRenderDevice::setPixelConstantBuffers(unsigned int startSlot,
+	unsigned int count, ID3D11Buffer* const* buffers)
+{
+	record(SET_PIXEL_CONSTANT_BUFFERS, startSlot, count, 0, buffers[0]);
+
+	mTarget.setPixelConstantBuffers(startSlot, count, buffers);
+}
+
+bool bsRecordingRenderDevice::supportsConstantBufferOffsets() const
+{
+	return mTarget.supportsConstantBufferOffsets();
+}
+
+void bsRecordingRenderDevice::setVertexConstantBufferRange(unsigned int slot,
+	ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int constantCount)
+{
+	record(SET_VERTEX_CONSTANT_BUFFER_RANGE, slot, constantCount, firstConstant, buffer);
+
+	mTarget.setVertexConstantBufferRange(slot, buffer, firstConstant, constantCount);
+}
+
+void bsRecordingRenderDevice::setPixelConstantBufferRange(unsigned int slot,
+	ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int constantCount)
+{
+	record(SET_PIXEL_CONSTANT_BUFFER_RANGE, slot, constantCount, firstConstant, buffer);
+
+	mTarget.setPixelConstantBufferRange(slot, buffer, firstConstant, constantCount);
+}
+
+void bsRecordingRenderDevice::setPixelShaderResources(unsigned int startSlot,
+	unsigned int count, ID3D11ShaderResourceView* const* views)
+{
+	record(SET_PIXEL_SHADER_RESOURCES, startSlot, count, 0, views[0]);
+
+	mTarget.setPixelShaderResources(startSlot, count, views);
+}
+
+void bsRecordingRenderDevice::setPixelSamplers(unsigned int startSlot, unsigned int count,
+	ID3D11SamplerState* const* samplers)
+{
+	record(SET_PIXEL_SAMPLERS, startSlot, count, 0, samplers[0]);
+
+	mTarget.setPixelSamplers(startSlot, count, samplers);
+}
+
+void bsRecordingRenderDevice::setPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+	record(SET_PRIMITIVE_TOPOLOGY, 0, 1, static_cast<unsigned int>(topology), nullptr);
+
+	mTarget.setPrimitiveTopology(topology);
+}
+
+void bsRecordingRenderDevice::setVertexBuffers(unsigned int startSlot, unsigned int count,
+	ID3D11Buffer* const* buffers, const unsigned int* strides,
+	const unsigned int* offsets)
+{
+	record(SET_VERTEX_BUFFERS, startSlot, count, 0, buffers[0]);
+
+	mTarget.setVertexBuffers(startSlot, count, buffers, strides, offsets);
+}
+
+void bsRecordingRenderDevice::setIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format,
+	unsigned int offset)
+{
+	record(SET_INDEX_BUFFER, 0, 1, static_cast<unsigned int>(format), buffer);
+
+	mTarget.setIndexBuffer(buffer, format, offset);
+}
+
+void bsRecordingRenderDevice::updateBuffer(ID3D11Buffer* buffer, const void* data,
+	unsigned int dataSize)
+{
+	record(UPDATE_BUFFER, 0, 1, dataSize, buffer);
+	mUpdatedByteCount += dataSize;
+
+	mTarget.updateBuffer(buffer, data, dataSize);
+}
+
+void* bsRecordingRenderDevice::mapDiscard(ID3D11Buffer* buffer)
+{
+	record(MAP_BUFFER, 0, 1, 0, buffer);
+
+	return mTarget.mapDiscard(buffer);
+}
+
+void bsRecordingRenderDevice::unmap(ID3D11Buffer* buffer)
+{
+	record(UNMAP_BUFFER, 0, 1, 0, buffer);
+
+	mTarget.unmap(buffer);
+}
+
+void bsRecordingRenderDevice::drawIndexed(unsigned int indexCount,
+	unsigned int startIndex, int baseVertex)
+{
+	record(DRAW_INDEXED, 0, 1, indexCount, nullptr);
+
+	mTarget.drawIndexed(indexCount, startIndex, baseVertex);
+}
+
+void bsRecordingRenderDevice::drawIndexedInstanced(unsigned int indexCountPerInstance,
+	unsigned int instanceCount, unsigned int startIndex, int baseVertex,
+	unsigned int startInstance)
+{
+	record(DRAW_INDEXED_INSTANCED, 0, instanceCount, indexCountPerInstance, nullptr);
+
+	mTarget.drawIndexedInstanced(indexCountPerInstance, instanceCount, startIndex,
+		baseVertex, startInstance);
+}
+
+HRESULT bsRecordingRenderDevice::present(unsigned int syncInterval)
+{
+	record(PRESENT, 0, 0, syncInterval, nullptr);
+
+	return mTarget.present(syncInterval);
+}
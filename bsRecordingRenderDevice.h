@@ -0,0 +1,247 @@
+#pragma once
+
+#include <vector>
+
+#include <tbb/atomic.h>
+
+#include "bsRenderDevice.h"
+
+
+/*	Render device which records every command into a compact stream and counts them by
+	type, then forwards everything to another device.
+	Put it in front of a bsNullRenderDevice to check or measure what the frame path does
+	without a GPU, or in front of a bsDx11RenderDevice to capture what a real frame did.
+
+	Object creation and release are forwarded and counted, but not recorded, since they
+	may happen on any thread.
+*/
+class bsRecordingRenderDevice : public bsRenderDevice
+{
+public:
+	enum CommandType
+	{
+		SET_RENDER_TARGETS,
+		CLEAR_RENDER_TARGET,
+		CLEAR_DEPTH_STENCIL,
+		SET_VIEWPORT,
+		SET_RASTERIZER_STATE,
+		SET_BLEND_STATE,
+		SET_DEPTH_STENCIL_STATE,
+		SET_INPUT_LAYOUT,
+		SET_VERTEX_SHADER,
+		SET_GEOMETRY_SHADER,
+		SET_PIXEL_SHADER,
+		SET_VERTEX_CONSTANT_BUFFERS,
+		SET_PIXEL_CONSTANT_BUFFERS,
+		SET_VERTEX_CONSTANT_BUFFER_RANGE,
+		SET_PIXEL_CONSTANT_BUFFER_RANGE,
+		SET_PIXEL_SHADER_RESOURCES,
+		SET_PIXEL_SAMPLERS,
+		SET_PRIMITIVE_TOPOLOGY,
+		SET_VERTEX_BUFFERS,
+		SET_INDEX_BUFFER,
+		UPDATE_BUFFER,
+		MAP_BUFFER,
+		UNMAP_BUFFER,
+		DRAW_INDEXED,
+		DRAW_INDEXED_INSTANCED,
+		PRESENT,
+
+		COMMAND_TYPE_COUNT
+	};
+
+	/*	A single recorded command.
+		Binds store their start slot, the number of objects and the first object.
+		Draws store the index count in value and the instance count in count.
+		Constant buffer range binds store the first constant in value and the number of
+		constants in count.
+		Buffer updates store the number of bytes in value, topology binds the topology,
+		clears their flags (0 for render targets) and present the sync interval.
+	*/
+	struct Command
+	{
+		unsigned short	type;
+		unsigned short	slot;
+		unsigned int	count;
+		unsigned int	value;
+		const void*		object;
+	};
+
+
+	//Commands are forwarded to target, which must outlive this device.
+	explicit bsRecordingRenderDevice(bsRenderDevice& target);
+
+	//Removes every recorded command and resets the counts, keeping the stream's memory.
+	void clear();
+
+	inline const std::vector<Command>& getCommands() const
+	{
+		return mCommands;
+	}
+
+	inline unsigned int getCommandCount(CommandType type) const
+	{
+		return mCommandCounts[type];
+	}
+
+	//Number of indexed and instanced draws.
+	inline unsigned int getDrawCount() const
+	{
+		return mCommandCounts[DRAW_INDEXED] + mCommandCounts[DRAW_INDEXED_INSTANCED];
+	}
+
+	//Bytes uploaded by updateBuffer.
+	inline unsigned long long getUpdatedByteCount() const
+	{
+		return mUpdatedByteCount;
+	}
+
+	//Objects created since construction or the last clear.
+	inline unsigned int getCreatedObjectCount() const
+	{
+		return mCreatedObjectCount;
+	}
+
+	//Objects released since construction or the last clear.
+	inline unsigned int getReleasedObjectCount() const
+	{
+		return mReleasedObjectCount;
+	}
+
+	static const char* getCommandTypeName(CommandType type);
+
+
+	virtual HRESULT createBuffer(const D3D11_BUFFER_DESC& desc,
+		const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Buffer** bufferOut);
+
+	virtual HRESULT createTexture2D(const D3D11_TEXTURE2D_DESC& desc,
+		const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Texture2D** textureOut);
+
+	virtual HRESULT createRenderTargetView(ID3D11Resource* resource,
+		const D3D11_RENDER_TARGET_VIEW_DESC* desc, ID3D11RenderTargetView** viewOut);
+
+	virtual HRESULT createShaderResourceView(ID3D11Resource* resource,
+		const D3D11_SHADER_RESOURCE_VIEW_DESC* desc, ID3D11ShaderResourceView** viewOut);
+
+	virtual HRESULT createDepthStencilView(ID3D11Resource* resource,
+		const D3D11_DEPTH_STENCIL_VIEW_DESC* desc, ID3D11DepthStencilView** viewOut);
+
+	virtual HRESULT createRasterizerState(const D3D11_RASTERIZER_DESC& desc,
+		ID3D11RasterizerState** stateOut);
+
+	virtual HRESULT createBlendState(const D3D11_BLEND_DESC& desc,
+		ID3D11BlendState** stateOut);
+
+	virtual HRESULT createDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc,
+		ID3D11DepthStencilState** stateOut);
+
+	virtual HRESULT createSamplerState(const D3D11_SAMPLER_DESC& desc,
+		ID3D11SamplerState** stateOut);
+
+	virtual HRESULT createVertexShader(const void* byteCode, size_t byteCodeSize,
+		ID3D11VertexShader** shaderOut);
+
+	virtual HRESULT createPixelShader(const void* byteCode, size_t byteCodeSize,
+		ID3D11PixelShader** shaderOut);
+
+	virtual HRESULT createInputLayout(const D3D11_INPUT_ELEMENT_DESC* inputDescs,
+		unsigned int inputDescCount, const void* byteCode, size_t byteCodeSize,
+		ID3D11InputLayout** layoutOut);
+
+	virtual unsigned long release(ID3D11DeviceChild* object);
+
+	virtual void setDebugName(ID3D11DeviceChild* object, const char* name);
+
+
+	virtual void setRenderTargets(unsigned int count,
+		ID3D11RenderTargetView* const* renderTargetViews,
+		ID3D11DepthStencilView* depthStencilView);
+
+	virtual void clearRenderTarget(ID3D11RenderTargetView* renderTargetView,
+		const float* colorRgba);
+
+	virtual void clearDepthStencil(ID3D11DepthStencilView* depthStencilView,
+		unsigned int clearFlags, float depth, unsigned char stencil);
+
+	virtual void setViewport(const D3D11_VIEWPORT& viewport);
+
+	virtual void setRasterizerState(ID3D11RasterizerState* state);
+
+	virtual void setBlendState(ID3D11BlendState* state);
+
+	virtual void setDepthStencilState(ID3D11DepthStencilState* state);
+
+	virtual void setInputLayout(ID3D11InputLayout* inputLayout);
+
+	virtual void setVertexShader(ID3D11VertexShader* shader);
+
+	virtual void setGeometryShader(ID3D11GeometryShader* shader);
+
+	virtual void setPixelShader(ID3D11PixelShader* shader);
+
+	virtual void setVertexConstantBuffers(unsigned int startSlot, unsigned int count,
+		ID3D11Buffer* const* buffers);
+
+	virtual void setPixelConstantBuffers(unsigned int startSlot, unsigned int count,
+		ID3D11Buffer* const* buffers);
+
+	virtual bool supportsConstantBufferOffsets() const;
+
+	virtual void setVertexConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer,
+		unsigned int firstConstant, unsigned int constantCount);
+
+	virtual void setPixelConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer,
+		unsigned int firstConstant, unsigned int constantCount);
+
+	virtual void setPixelShaderResources(unsigned int startSlot, unsigned int count,
+		ID3D11ShaderResourceView* const* views);
+
+	virtual void setPixelSamplers(unsigned int startSlot, unsigned int count,
+		ID3D11SamplerState* const* samplers);
+
+	virtual void setPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology);
+
+	virtual void setVertexBuffers(unsigned int startSlot, unsigned int count,
+		ID3D11Buffer* const* buffers, const unsigned int* strides,
+		const unsigned int* offsets);
+
+	virtual void setIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format,
+		unsigned int offset);
+
+	virtual void updateBuffer(ID3D11Buffer* buffer, const void* data,
+		unsigned int dataSize);
+
+	virtual void* mapDiscard(ID3D11Buffer* buffer);
+
+	virtual void unmap(ID3D11Buffer* buffer);
+
+	virtual void drawIndexed(unsigned int indexCount, unsigned int startIndex,
+		int baseVertex);
+
+	virtual void drawIndexedInstanced(unsigned int indexCountPerInstance,
+		unsigned int instanceCount, unsigned int startIndex, int baseVertex,
+		unsigned int startInstance);
+
+	virtual HRESULT present(unsigned int syncInterval);
+
+private:
+	//Non-copyable.
+	bsRecordingRenderDevice(const bsRecordingRenderDevice&);
+	bsRecordingRenderDevice& operator=(const bsRecordingRenderDevice&);
+
+	void record(CommandType type, unsigned int slot, unsigned int count,
+		unsigned int value, const void* object);
+
+	//Counts a created object if creation succeeded, returning result.
+	HRESULT countCreated(HRESULT result);
+
+
+	bsRenderDevice&			mTarget;
+
+	std::vector<Command>	mCommands;
+	unsigned int			mCommandCounts[COMMAND_TYPE_COUNT];
+	unsigned long long		mUpdatedByteCount;
+
+	tbb::atomic<unsigned int>	mCreatedObjectCount;
+	tbb::atomic<unsigned int>	mReleasedObjectCount;
+};
@@ -0,0 +1,164 @@
+#include "StdAfx.h"
+
+#include "bsRenderBatcher.h"
+
+#include "bsFrameSnapshot.h"
+#include "bsFrustum.h"
+#include "bsCollision.h"
+#include "bsLight.h"
+#include "bsJobSystem.h"
+#include "bsScratchAllocator.h"
+#include "bsProfiler.h"
+
+
+namespace
+{
+//Entities tested per culling job.
+const unsigned int kCullingGrainSize = 1024;
+
+/*	Empties the entity lists while keeping their memory, and removes the lists which were
+	already empty, since their renderers were not visible during the previous frame.
+*/
+template <typename EntityGroupMap>
+void clearEntityGroups(EntityGroupMap& groups)
+{
+	for (auto itr = groups.begin(); itr != groups.end(); /*nothing*/)
+	{
+		if (itr->second.empty())
+		{
+			itr = groups.erase(itr);
+		}
+		else
+		{
+			itr->second.clear();
+			++itr;
+		}
+	}
+}
+}
+
+
+bsRenderBatcher::bsRenderBatcher(bsJobSystem& jobSystem)
+	: mJobSystem(jobSystem)
+	, mBatchedEntityCount(0)
+{
+}
+
+void bsRenderBatcher::reset()
+{
+	clearEntityGroups(mMeshBatches);
+	clearEntityGroups(mLineBatches);
+
+	mPointLights.clear();
+	mSpotLights.clear();
+	mDirectionalLights.clear();
+
+	mTexts.clear();
+
+	mBatchedEntityCount = 0;
+}
+
+void bsRenderBatcher::cullAndBatch(const bsEntitySnapshot* entities,
+	unsigned int entityCount, const bsFrustum& frustum)
+{
+	//Room for every entity, since any number of them may be visible. Only needed until
+	//the visible entities have been sorted into batches.
+	bsScratchScope scratch;
+	const bsEntitySnapshot** visibleEntities =
+		scratch.allocate<const bsEntitySnapshot*>(entityCount);
+
+	const unsigned int visibleEntityCount = cull(entities, entityCount, frustum,
+		visibleEntities);
+
+	batch(visibleEntities, visibleEntityCount);
+}
+
+unsigned int bsRenderBatcher::cull(const bsEntitySnapshot* entities,
+	unsigned int entityCount, const bsFrustum& frustum,
+	const bsEntitySnapshot** visibleEntities)
+{
+	bsScratchScope scratch;
+	unsigned char* visible = scratch.allocate<unsigned char>(entityCount);
+
+	//Test every entity against the frustum in parallel, each job writing its own flags.
+	mJobSystem.parallelFor(entityCount, kCullingGrainSize,
+		[=, &frustum](unsigned int begin, unsigned int end)
+	{
+		BS_PROFILE_SCOPE("Cull entities");
+
+		for (unsigned int i = begin; i < end; ++i)
+		{
+			//Entities removed since the capture have nothing left to draw.
+			const bsEntitySnapshot& entity = entities[i];
+			visible[i] = entity.entity != nullptr
+				&& bsCollision::intersectSphereFrustum(entity.boundingSphere,
+				entity.position, frustum) != bsCollision::OUTSIDE;
+		}
+	});
+
+	//Gather the entities that are inside/intersecting the frustum, serially to keep the
+	//scene's order.
+	unsigned int visibleEntityCount = 0;
+	for (unsigned int i = 0; i < entityCount; ++i)
+	{
+		if (visible[i])
+		{
+			visibleEntities[visibleEntityCount++] = &entities[i];
+		}
+	}
+
+	return visibleEntityCount;
+}
+
+void bsRenderBatcher::batch(const bsEntitySnapshot* const* entities,
+	unsigned int entityCount)
+{
+	mBatchedEntityCount += entityCount;
+
+	for (unsigned int i = 0; i < entityCount; ++i)
+	{
+		const bsEntitySnapshot& entity = *entities[i];
+
+		const bsMeshRenderer* meshRenderer = entity.meshRenderer;
+		if (meshRenderer)
+		{
+			//Add the entity to the mesh' list of entities, creating it if not found.
+			mMeshBatches[meshRenderer].push_back(&entity);
+		}
+
+		const bsLineRenderer* line = entity.lineRenderer;
+		if (line != nullptr)
+		{
+			mLineBatches[line].push_back(&entity);
+		}
+
+		const bsLight* light = entity.light;
+		if (light != nullptr)
+		{
+			XMFLOAT3 position;
+			XMStoreFloat3(&position, entity.position);
+
+			//The type was copied into the snapshot, so the light itself is not read here.
+			switch (entity.lightType)
+			{
+			case bsLight::LT_POINT:
+				mPointLights.push_back(std::make_pair(light, position));
+				break;
+
+			case bsLight::LT_SPOT:
+				mSpotLights.push_back(std::make_pair(light, &entity));
+				break;
+
+			case bsLight::LT_DIRECTIONAL:
+				mDirectionalLights.push_back(std::make_pair(light, position));
+				break;
+			}
+		}
+
+		const bsText3D* text = entity.textRenderer;
+		if (text != nullptr)
+		{
+			mTexts.push_back(std::make_pair(&entity, text));
+		}
+	}
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+
+#include <Windows.h>
+#include <xnamath.h>
+
+#include "bsFlatHashMap.h"
+
+class bsMeshRenderer;
+class bsLineRenderer;
+class bsLight;
+class bsText3D;
+class bsJobSystem;
+struct bsEntitySnapshot;
+struct bsFrustum;
+
+
+/*	Culls the entities of a frame snapshot against a frustum, and groups the visible ones
+	by what draws them: meshes and lines by the renderer they share, lights by type, and
+	texts.
+
+	Nothing here touches the device, so culling and batching can be measured on their own,
+	see benchmarks/bsFramePipelineBenchmark.cpp. bsRenderQueue draws the batches.
+
+	The entity lists are emptied rather than destroyed by reset, so their memory is reused
+	by the following frames. Lists which stay empty for a whole frame are removed.
+*/
+class bsRenderBatcher
+{
+public:
+	typedef std::vector<const bsEntitySnapshot*> EntityList;
+	typedef bsFlatHashMap<const bsMeshRenderer*, EntityList> MeshBatches;
+	typedef bsFlatHashMap<const bsLineRenderer*, EntityList> LineBatches;
+
+
+	explicit bsRenderBatcher(bsJobSystem& jobSystem);
+
+	//Empties every batch, starting a new frame.
+	void reset();
+
+	/*	Culls the entities against the frustum and adds the visible ones to the batches.
+		The entities must stay alive until the batches have been drawn.
+	*/
+	void cullAndBatch(const bsEntitySnapshot* entities, unsigned int entityCount,
+		const bsFrustum& frustum);
+
+	/*	Writes pointers to the entities that are inside or intersecting the frustum to
+		visibleEntities, keeping their order. visibleEntities must have room for
+		entityCount pointers.
+		The frustum tests run in parallel on the job system.
+		Returns the number of visible entities.
+	*/
+	unsigned int cull(const bsEntitySnapshot* entities, unsigned int entityCount,
+		const bsFrustum& frustum, const bsEntitySnapshot** visibleEntities);
+
+	//Adds entities to the batches of their renderable components.
+	void batch(const bsEntitySnapshot* const* entities, unsigned int entityCount);
+
+
+	inline const MeshBatches& getMeshBatches() const
+	{
+		return mMeshBatches;
+	}
+
+	inline const LineBatches& getLineBatches() const
+	{
+		return mLineBatches;
+	}
+
+	inline const std::vector<std::pair<const bsLight*, XMFLOAT3>>& getPointLights() const
+	{
+		return mPointLights;
+	}
+
+	inline const std::vector<std::pair<const bsLight*, const bsEntitySnapshot*>>&
+		getSpotLights() const
+	{
+		return mSpotLights;
+	}
+
+	inline const std::vector<std::pair<const bsLight*, XMFLOAT3>>&
+		getDirectionalLights() const
+	{
+		return mDirectionalLights;
+	}
+
+	inline const std::vector<std::pair<const bsEntitySnapshot*, const bsText3D*>>&
+		getTexts() const
+	{
+		return mTexts;
+	}
+
+	//Number of entities batched since the last reset.
+	inline unsigned int getBatchedEntityCount() const
+	{
+		return mBatchedEntityCount;
+	}
+
+private:
+	//Non-copyable.
+	bsRenderBatcher(const bsRenderBatcher&);
+	bsRenderBatcher& operator=(const bsRenderBatcher&);
+
+
+	bsJobSystem&	mJobSystem;
+
+	MeshBatches		mMeshBatches;
+	LineBatches		mLineBatches;
+
+	std::vector<std::pair<const bsLight*, XMFLOAT3>>				mPointLights;
+	std::vector<std::pair<const bsLight*, const bsEntitySnapshot*>>	mSpotLights;
+	std::vector<std::pair<const bsLight*, XMFLOAT3>>				mDirectionalLights;
+
+	std::vector<std::pair<const bsEntitySnapshot*, const bsText3D*>>	mTexts;
+
+	unsigned int	mBatchedEntityCount;
+};
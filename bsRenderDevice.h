@@ -0,0 +1,166 @@
+#pragma once
+
+#include <d3d11.h>
+
+
+/*	Thin interface over the device and immediate context functions used by the renderer.
+	The render queue, deferred renderer, cameras, meshes and shaders create, bind and draw
+	through this rather than through D3D11 directly, so the frame path can run without a
+	GPU or window (bsNullRenderDevice), and its commands can be captured and counted
+	(bsRecordingRenderDevice). bsDx11RenderDevice forwards everything to D3D11.
+
+	D3D11 interface pointers are used as opaque handles. A handle may only be used with
+	the device which created it. Handles from a null device are not D3D11 objects, so
+	they must be released and named through the device rather than through their own
+	functions.
+
+	Resource creation and release are thread safe, like ID3D11Device. All other functions
+	must be called from the rendering thread, like ID3D11DeviceContext.
+*/
+class bsRenderDevice
+{
+public:
+	virtual ~bsRenderDevice()
+	{
+	}
+
+	//Resource creation, these return the same codes as the ID3D11Device functions.
+
+	virtual HRESULT createBuffer(const D3D11_BUFFER_DESC& desc,
+		const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Buffer** bufferOut) = 0;
+
+	virtual HRESULT createTexture2D(const D3D11_TEXTURE2D_DESC& desc,
+		const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Texture2D** textureOut) = 0;
+
+	virtual HRESULT createRenderTargetView(ID3D11Resource* resource,
+		const D3D11_RENDER_TARGET_VIEW_DESC* desc, ID3D11RenderTargetView** viewOut) = 0;
+
+	virtual HRESULT createShaderResourceView(ID3D11Resource* resource,
+		const D3D11_SHADER_RESOURCE_VIEW_DESC* desc,
+		ID3D11ShaderResourceView** viewOut) = 0;
+
+	virtual HRESULT createDepthStencilView(ID3D11Resource* resource,
+		const D3D11_DEPTH_STENCIL_VIEW_DESC* desc, ID3D11DepthStencilView** viewOut) = 0;
+
+	virtual HRESULT createRasterizerState(const D3D11_RASTERIZER_DESC& desc,
+		ID3D11RasterizerState** stateOut) = 0;
+
+	virtual HRESULT createBlendState(const D3D11_BLEND_DESC& desc,
+		ID3D11BlendState** stateOut) = 0;
+
+	virtual HRESULT createDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc,
+		ID3D11DepthStencilState** stateOut) = 0;
+
+	virtual HRESULT createSamplerState(const D3D11_SAMPLER_DESC& desc,
+		ID3D11SamplerState** stateOut) = 0;
+
+	virtual HRESULT createVertexShader(const void* byteCode, size_t byteCodeSize,
+		ID3D11VertexShader** shaderOut) = 0;
+
+	virtual HRESULT createPixelShader(const void* byteCode, size_t byteCodeSize,
+		ID3D11PixelShader** shaderOut) = 0;
+
+	virtual HRESULT createInputLayout(const D3D11_INPUT_ELEMENT_DESC* inputDescs,
+		unsigned int inputDescCount, const void* byteCode, size_t byteCodeSize,
+		ID3D11InputLayout** layoutOut) = 0;
+
+	/*	Releases a reference to an object created by this device.
+		Returns the number of remaining references.
+	*/
+	virtual unsigned long release(ID3D11DeviceChild* object) = 0;
+
+	//Names an object for graphics debuggers and the debug layer.
+	virtual void setDebugName(ID3D11DeviceChild* object, const char* name) = 0;
+
+
+	//Commands.
+
+	virtual void setRenderTargets(unsigned int count,
+		ID3D11RenderTargetView* const* renderTargetViews,
+		ID3D11DepthStencilView* depthStencilView) = 0;
+
+	virtual void clearRenderTarget(ID3D11RenderTargetView* renderTargetView,
+		const float* colorRgba) = 0;
+
+	virtual void clearDepthStencil(ID3D11DepthStencilView* depthStencilView,
+		unsigned int clearFlags, float depth, unsigned char stencil) = 0;
+
+	virtual void setViewport(const D3D11_VIEWPORT& viewport) = 0;
+
+	virtual void setRasterizerState(ID3D11RasterizerState* state) = 0;
+
+	//Sets a blend state with no blend factor and every sample enabled.
+	virtual void setBlendState(ID3D11BlendState* state) = 0;
+
+	//Sets a depth stencil state with a stencil reference of 0.
+	virtual void setDepthStencilState(ID3D11DepthStencilState* state) = 0;
+
+	virtual void setInputLayout(ID3D11InputLayout* inputLayout) = 0;
+
+	virtual void setVertexShader(ID3D11VertexShader* shader) = 0;
+
+	virtual void setGeometryShader(ID3D11GeometryShader* shader) = 0;
+
+	virtual void setPixelShader(ID3D11PixelShader* shader) = 0;
+
+	virtual void setVertexConstantBuffers(unsigned int startSlot, unsigned int count,
+		ID3D11Buffer* const* buffers) = 0;
+
+	virtual void setPixelConstantBuffers(unsigned int startSlot, unsigned int count,
+		ID3D11Buffer* const* buffers) = 0;
+
+	/*	Whether constant buffers can be bound from an offset with
+		setVertexConstantBufferRange and setPixelConstantBufferRange. This requires
+		D3D11.1 and driver support.
+	*/
+	virtual bool supportsConstantBufferOffsets() const = 0;
+
+	/*	Binds constantCount 16 byte constants of a constant buffer to slot, starting at
+		firstConstant. Both must be multiples of 16.
+		Only valid if supportsConstantBufferOffsets.
+	*/
+	virtual void setVertexConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer,
+		unsigned int firstConstant, unsigned int constantCount) = 0;
+
+	virtual void setPixelConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer,
+		unsigned int firstConstant, unsigned int constantCount) = 0;
+
+	virtual void setPixelShaderResources(unsigned int startSlot, unsigned int count,
+		ID3D11ShaderResourceView* const* views) = 0;
+
+	virtual void setPixelSamplers(unsigned int startSlot, unsigned int count,
+		ID3D11SamplerState* const* samplers) = 0;
+
+	virtual void setPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology) = 0;
+
+	virtual void setVertexBuffers(unsigned int startSlot, unsigned int count,
+		ID3D11Buffer* const* buffers, const unsigned int* strides,
+		const unsigned int* offsets) = 0;
+
+	virtual void setIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format,
+		unsigned int offset) = 0;
+
+	/*	Replaces the whole content of a buffer created with D3D11_USAGE_DEFAULT.
+		dataSize must be the size of the buffer.
+	*/
+	virtual void updateBuffer(ID3D11Buffer* buffer, const void* data,
+		unsigned int dataSize) = 0;
+
+	/*	Maps a buffer created with D3D11_USAGE_DYNAMIC and D3D11_CPU_ACCESS_WRITE for
+		writing, discarding its previous content. Returns null on failure.
+		The buffer must be unmapped before anything draws with it.
+	*/
+	virtual void* mapDiscard(ID3D11Buffer* buffer) = 0;
+
+	virtual void unmap(ID3D11Buffer* buffer) = 0;
+
+	virtual void drawIndexed(unsigned int indexCount, unsigned int startIndex,
+		int baseVertex) = 0;
+
+	virtual void drawIndexedInstanced(unsigned int indexCountPerInstance,
+		unsigned int instanceCount, unsigned int startIndex, int baseVertex,
+		unsigned int startInstance) = 0;
+
+	//Presents the back buffer. Returns the same codes as IDXGISwapChain::Present.
+	virtual HRESULT present(unsigned int syncInterval) = 0;
+};
@@ -12,6 +12,7 @@
 #include "bsLight.h"
 
 #include "bsDx11Renderer.h"
+#include "bsRenderDevice.h"
 #include "bsShaderManager.h"
 #include "bsVertexShader.h"
 #include "bsPixelShader.h"
@@ -23,21 +24,37 @@
 #include "bsConstantBuffers.h"
 #include "bsFrustum.h"
 
-#include "bsAlignedAllocator.h"
-#include "bsFixedSizeString.h"
+#include "bsAllocationCounter.h"
+#include "bsScratchAllocator.h"
+#include "bsJobSystem.h"
+#include "bsFrameSnapshot.h"
+#include "bsFrameCapture.h"
+#include "bsScene.h"
 
 
-bsRenderQueue::bsRenderQueue(bsDx11Renderer* dx11Renderer, bsShaderManager* shaderManager)
+bsRenderQueue::bsRenderQueue(bsDx11Renderer* dx11Renderer, bsShaderManager* shaderManager,
+	bsJobSystem* jobSystem)
 	: mCamera(nullptr)
 	, mScene(nullptr)
+	, mRegisteredSnapshot(nullptr)
+	, mSnapshot(nullptr)
 	, mDx11Renderer(dx11Renderer)
 	, mShaderManager(shaderManager)
+	, mJobSystem(jobSystem)
+	, mBatcher(*jobSystem)
+	, mFrameAllocator(1024 * 1024)
+	, mConstantRing(dx11Renderer->getRenderDevice(), 64 * 1024)
+	, mMeshBatchConstants(nullptr)
+	, mLineConstants(nullptr)
+	, mFrameStartAllocationCount(0)
+	, mFrameStartScratchOverflowCount(0)
 {
 	BS_ASSERT(dx11Renderer);
 	BS_ASSERT(shaderManager);
+	BS_ASSERT(jobSystem);
 
 
-	ID3D11Device& device = *mDx11Renderer->getDevice();
+	bsRenderDevice& renderDevice = mDx11Renderer->getRenderDevice();
 
 	D3D11_BUFFER_DESC bufferDescription;
 	memset(&bufferDescription, 0, sizeof(bufferDescription));
@@ -47,16 +64,12 @@ bsRenderQueue::bsRenderQueue(bsDx11Renderer* dx11Renderer, bsShaderManager* shad
 	bufferDescription.CPUAccessFlags = 0;
 	bufferDescription.MiscFlags = 0;
 
-	HRESULT hres = device.CreateBuffer(&bufferDescription, nullptr, &mWorldBuffer);
+	HRESULT hres = renderDevice.createBuffer(bufferDescription, nullptr, &mWorldBuffer);
 
 	BS_ASSERT2(SUCCEEDED(hres), "bsRenderQueue::bsRenderQueue failed to create world buffer");
 
-	bufferDescription.ByteWidth = sizeof(CBWireFrame);
-	hres = device.CreateBuffer(&bufferDescription, nullptr, &mWireframeWorldBuffer);
-	BS_ASSERT(SUCCEEDED(hres));
-
 	bufferDescription.ByteWidth = sizeof(CBLight);
-	hres = device.CreateBuffer(&bufferDescription, nullptr, &mLightBuffer);
+	hres = renderDevice.createBuffer(bufferDescription, nullptr, &mLightBuffer);
 	BS_ASSERT(SUCCEEDED(hres));
 
 	//Shaders
@@ -73,9 +86,9 @@ bsRenderQueue::bsRenderQueue(bsDx11Renderer* dx11Renderer, bsShaderManager* shad
 	inputElementDesc.InstanceDataStepRate = 0;
 	inputLayout.push_back(inputElementDesc);
 
-	mWireframeVertexShader = mShaderManager->getVertexShader("Wireframe.fx",
+	mWireframeVertexShader = mShaderManager->getVertexShader(bsStringId("Wireframe.fx"),
 		inputLayout.data(), inputLayout.size());
-	mWireframePixelShader = mShaderManager->getPixelShader("Wireframe.fx");
+	mWireframePixelShader = mShaderManager->getPixelShader(bsStringId("Wireframe.fx"));
 
 
 	D3D11_INPUT_ELEMENT_DESC layout[8] =
@@ -93,9 +106,12 @@ bsRenderQueue::bsRenderQueue(bsDx11Renderer* dx11Renderer, bsShaderManager* shad
 		{ "TEXCOORD", 4, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 48, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
 	};
 
-	mMeshInstancedVertexShader = mShaderManager->getVertexShader("MeshInstanced.fx", layout, 8);
-	mInstancedTexturedMeshPixelShader = mShaderManager->getPixelShader("MeshInstancedTextured.fx");
-	mInstancedTexturedMeshNormalPixelShader = mShaderManager->getPixelShader("MeshInstancedTexturedNormal.fx");
+	mMeshInstancedVertexShader = mShaderManager->getVertexShader(
+		bsStringId("MeshInstanced.fx"), layout, 8);
+	mInstancedTexturedMeshPixelShader = mShaderManager->getPixelShader(
+		bsStringId("MeshInstancedTextured.fx"));
+	mInstancedTexturedMeshNormalPixelShader = mShaderManager->getPixelShader(
+		bsStringId("MeshInstancedTexturedNormal.fx"));
 
 	//Light
 	inputLayout.clear();
@@ -104,9 +120,9 @@ bsRenderQueue::bsRenderQueue(bsDx11Renderer* dx11Renderer, bsShaderManager* shad
 	inputElementDesc.AlignedByteOffset = 0;
 	inputLayout.push_back(inputElementDesc);
 
-	mLightVertexShader = mShaderManager->getVertexShader("Light.fx", inputLayout.data(),
-		inputLayout.size());
-	mLightPixelShader = mShaderManager->getPixelShader("Light.fx");
+	mLightVertexShader = mShaderManager->getVertexShader(bsStringId("Light.fx"),
+		inputLayout.data(), inputLayout.size());
+	mLightPixelShader = mShaderManager->getPixelShader(bsStringId("Light.fx"));
 
 	D3D11_INPUT_ELEMENT_DESC lightInstanced[8] =
 	{
@@ -125,16 +141,12 @@ bsRenderQueue::bsRenderQueue(bsDx11Renderer* dx11Renderer, bsShaderManager* shad
 		{ "TEXCOORD", 6, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 96, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
 	};
 
-	mLightInstancedVertexShader = mShaderManager->getVertexShader("LightInstanced.fx",
-		lightInstanced, ARRAYSIZE(lightInstanced));
-	mPointLightInstancedPixelShader = mShaderManager->getPixelShader("LightInstanced.fx");
-	mSpotLightInstancedPixelShader = mShaderManager->getPixelShader("SpotLightInstanced.fx");
-
-	//Create material buffer.
-	bufferDescription.ByteWidth = sizeof(XMFLOAT4) * 2;
-	hres = mDx11Renderer->getDevice()->CreateBuffer(&bufferDescription, nullptr, &mMaterialBuffer);
-	BS_ASSERT2(SUCCEEDED(hres), "Failed to create material buffer");
-
+	mLightInstancedVertexShader = mShaderManager->getVertexShader(
+		bsStringId("LightInstanced.fx"), lightInstanced, ARRAYSIZE(lightInstanced));
+	mPointLightInstancedPixelShader = mShaderManager->getPixelShader(
+		bsStringId("LightInstanced.fx"));
+	mSpotLightInstancedPixelShader = mShaderManager->getPixelShader(
+		bsStringId("SpotLightInstanced.fx"));
 
 	D3D11_SAMPLER_DESC lightSamplerDesc;
 	lightSamplerDesc.AddressU = lightSamplerDesc.AddressV = lightSamplerDesc.AddressW =
@@ -148,85 +160,81 @@ bsRenderQueue::bsRenderQueue(bsDx11Renderer* dx11Renderer, bsShaderManager* shad
 	lightSamplerDesc.BorderColor[0] = lightSamplerDesc.BorderColor[1] =
 		lightSamplerDesc.BorderColor[2] = lightSamplerDesc.BorderColor[3] = 0.0f;
 
-	hres = device.CreateSamplerState(&lightSamplerDesc, &mLightSamplerState);
+	hres = renderDevice.createSamplerState(lightSamplerDesc, &mLightSamplerState);
 	BS_ASSERT2(SUCCEEDED(hres), "Failed to create light sampler state");
 
 
 #ifdef BS_DEBUG
-	bsString128 debugName("bsRenderQueue world buffer");
-	mWorldBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, debugName.size(),
-		debugName.c_str());
-
-	debugName = "bsRenderQueue wireframe world buffer";
-	mWireframeWorldBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, debugName.size(),
-		debugName.c_str());
-
-	debugName = "bsRenderQueue light buffer buffer";
-	mLightBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, debugName.size(),
-		debugName.c_str());
-
-	debugName = "bsRenderQueue material buffer";
-	mMaterialBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, debugName.size(),
-		debugName.c_str());
-
-	debugName = "bsREnderQueue light sampler state";
-	mLightSamplerState->SetPrivateData(WKPDID_D3DDebugObjectName, debugName.size(),
-		debugName.c_str());
+	renderDevice.setDebugName(mWorldBuffer, "bsRenderQueue world buffer");
+	renderDevice.setDebugName(mLightBuffer, "bsRenderQueue light buffer buffer");
+	renderDevice.setDebugName(mLightSamplerState, "bsREnderQueue light sampler state");
 #endif
 }
 
 bsRenderQueue::~bsRenderQueue()
 {
-	mLightSamplerState->Release();
-	mMaterialBuffer->Release();
-	mWorldBuffer->Release();
-	mWireframeWorldBuffer->Release();
-	mLightBuffer->Release();
+	bsRenderDevice& renderDevice = mDx11Renderer->getRenderDevice();
+
+	renderDevice.release(mLightSamplerState);
+	renderDevice.release(mWorldBuffer);
+	renderDevice.release(mLightBuffer);
 }
 
 void bsRenderQueue::reset()
 {
-	mFrameStats.reset();
+	mFrameStartAllocationCount = bsAllocationCounter::getAllocationCount();
+	mFrameStartScratchOverflowCount = bsScratchAllocator::getStatistics().overflowCount;
 
-	mMeshesToDraw.clear();
-	mLinesToDraw.clear();
-	
-	mPointLightPositionPairs.clear();
-	mSpotLightPositionPairs.clear();
-	mDirectionalLightPositionPairs.clear();
+	mFrameStats.reset();
+	mFrameAllocator.beginFrame();
+	mConstantRing.beginFrame();
 
-	mText3dToDraw.clear();
+	mBatcher.reset();
 }
 
 void bsRenderQueue::startFrame()
 {
-	BS_ASSERT2(mScene != nullptr, "startFrame called, but no scene has been registered");
+	BS_ASSERT2(mScene != nullptr || mRegisteredSnapshot != nullptr, "startFrame called,"
+		" but no scene or snapshot has been registered");
 
-	const std::vector<bsEntity*>& entities = mScene->getEntities();
-	std::vector<const bsEntity*> entities2(entities.begin(), entities.end());
+	bsCamera* camera;
+	if (mScene != nullptr)
+	{
+		mSnapshot = &mScene->getRenderSnapshot();
+		camera = mScene->getCamera();
+	}
+	else
+	{
+		BS_ASSERT2(mCamera != nullptr, "A registered snapshot needs a camera");
 
-	addAndCullObjects(entities2.data(), entities2.size(), mScene->getCamera()->getTransformedFrustum());
-}
+		mSnapshot = mRegisteredSnapshot;
+		camera = mCamera;
+	}
 
-void bsRenderQueue::addAndCullObjects(const bsEntity** entities, unsigned int entityCount,
-	const bsFrustum& frustum)
-{
-	std::vector<const bsEntity*> visibleEntities;
-	visibleEntities.reserve(entityCount / 4);
+	//The camera is drawn from where it was when the snapshot was captured.
+	camera->update(mSnapshot->getView(), mSnapshot->getCameraPosition());
 
-	//Add entities that are inside/intersecting the frustum to the list of visible entities.
-	for (unsigned int i = 0; i < entityCount; ++i)
+	mBatcher.cullAndBatch(mSnapshot->getEntities(), mSnapshot->getEntityCount(),
+		mSnapshot->getFrustum());
+
+	mFrameStats.visibleEntityCount = mBatcher.getBatchedEntityCount();
+	mFrameStats.visibleLights = mBatcher.getPointLights().size();
+
+	writeConstants();
+
+	if (!mFrameCaptureFileName.empty())
 	{
-		const bsEntity& entity = *entities[i];
-		if (bsCollision::intersectSphereFrustum(entity.getBoundingSphere(),
-			entity.getTransform().getPosition(), frustum)
-			!= bsCollision::OUTSIDE)
-		{
-			visibleEntities.push_back(&entity);
-		}
+		bsSaveFrameCapture(mFrameCaptureFileName, *mSnapshot, mBatcher);
+		mFrameCaptureFileName.clear();
 	}
+}
 
-	sortRenderables(visibleEntities.data(), visibleEntities.size());
+void bsRenderQueue::endFrame()
+{
+	mFrameStats.heapAllocations = bsAllocationCounter::getAllocationCount()
+		- mFrameStartAllocationCount;
+	mFrameStats.scratchOverflows = bsScratchAllocator::getStatistics().overflowCount
+		- mFrameStartScratchOverflowCount;
 }
 
 void bsRenderQueue::drawGeometry()
@@ -241,171 +249,124 @@ void bsRenderQueue::drawGeometry()
 
 void bsRenderQueue::setWorldConstantBuffer(const XMMATRIX& world)
 {
-	ID3D11DeviceContext* context = mDx11Renderer->getDeviceContext();
-
-	context->VSSetConstantBuffers(1, 1, &mWorldBuffer);
-	context->PSSetConstantBuffers(1, 1, &mWorldBuffer);
-
-	context->UpdateSubresource(mWorldBuffer, 0, nullptr, &world, 0, 0);
-}
-
-void bsRenderQueue::setWireframeConstantBuffer(const XMMATRIX& world, const XMFLOAT4& color)
-{
-	ID3D11DeviceContext* context = mDx11Renderer->getDeviceContext();
+	bsRenderDevice& renderDevice = mDx11Renderer->getRenderDevice();
 
-	context->VSSetConstantBuffers(1, 1, &mWireframeWorldBuffer);
-	context->PSSetConstantBuffers(1, 1, &mWireframeWorldBuffer);
+	renderDevice.setVertexConstantBuffers(1, 1, &mWorldBuffer);
+	renderDevice.setPixelConstantBuffers(1, 1, &mWorldBuffer);
 
-	CBWireFrame cbWireFrame;
-	//XMStoreFloat4x4(&cbWireFrame.world, world);
-	cbWireFrame.world = world;
-	XMFLOAT4A colorAligned;
-	memcpy(&colorAligned, &color, sizeof(XMFLOAT4));
-	cbWireFrame.color = colorAligned;
-
-	context->UpdateSubresource(mWireframeWorldBuffer, 0, nullptr, &cbWireFrame, 0, 0);
+	renderDevice.updateBuffer(mWorldBuffer, &world, sizeof(world));
 }
 
-void bsRenderQueue::setLightConstantBuffer(const CBLight& cbLight)
+void bsRenderQueue::writeConstants()
 {
-	ID3D11DeviceContext* context = mDx11Renderer->getDeviceContext();
+	//Material constants, for every batch which may be drawn.
+	const bsRenderBatcher::MeshBatches& meshBatches = mBatcher.getMeshBatches();
+	mMeshBatchConstants = mFrameAllocator.allocate<bsConstantBufferRing::Allocation>(
+		std::max(meshBatches.size(), static_cast<size_t>(1)));
 
-	context->VSSetConstantBuffers(3, 1, &mLightBuffer);
-	context->PSSetConstantBuffers(3, 1, &mLightBuffer);
-
-	context->UpdateSubresource(mLightBuffer, 0, nullptr, &cbLight, 0, 0);
-}
+	unsigned int batchIndex = 0;
+	for (auto itr = meshBatches.begin(), end = meshBatches.end(); itr != end; ++itr)
+	{
+		if (itr->second.empty())
+		{
+			continue;
+		}
 
-void bsRenderQueue::sortRenderables(const bsEntity** entities, unsigned int entityCount)
-{
-	//BS_ASSERT2(mCamera, "Camera must be set before attempting to render a frame");
+		//Written even if the mesh is still loading, it may finish before it's drawn.
+		CBMaterial* material = mConstantRing.allocate<CBMaterial>(
+			mMeshBatchConstants[batchIndex++]);
+		material->color = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+		material->uvTile = itr->first->getMaterial()->uvTile;
+	}
 
-	//std::vector<bsEntity*> entities = mCamera->getVisibleEntities();
+	//Wireframe constants, for every line entity.
+	const bsRenderBatcher::LineBatches& lineBatches = mBatcher.getLineBatches();
+	size_t lineCount = 0;
+	for (auto itr = lineBatches.begin(), end = lineBatches.end(); itr != end; ++itr)
+	{
+		lineCount += itr->second.size();
+	}
 
-	//mFrameStats.visibleEntityCount = entities.size();
-	mFrameStats.visibleEntityCount += entityCount;
-	
+	mLineConstants = mFrameAllocator.allocate<bsConstantBufferRing::Allocation>(
+		std::max(lineCount, static_cast<size_t>(1)));
 
-	//Gather all the renderables from the visible meshEntities.
-	for (unsigned int i = 0, count = entityCount; i < count; ++i)
+	unsigned int lineIndex = 0;
+	for (auto itr = lineBatches.begin(), end = lineBatches.end(); itr != end; ++itr)
 	{
-		const bsEntity& entity = *entities[i];
-
-		const bsMeshRenderer* meshRenderer = entity.getMeshRenderer();
+		const bsLineRenderer* line = itr->first;
+		const std::vector<const bsEntitySnapshot*>& entities = itr->second;
 
-		if (meshRenderer)
+		for (unsigned int i = 0, count = entities.size(); i < count; ++i)
 		{
-			auto finder = mMeshesToDraw.find(meshRenderer);
-
-			for (auto itr = mMeshesToDraw.begin(), end = mMeshesToDraw.end(); itr != end; ++itr)
-			{
-				if (itr->first->getUniqueID() == meshRenderer->getUniqueID())
-				{
-					finder = itr;
-					break;
-				}
-			}
-
-
-			if (finder == mMeshesToDraw.end())
-			{
-				//Not found, create it
-				std::vector<const bsEntity*> meshEntities(1);
-				meshEntities[0] = &entity;
-				mMeshesToDraw.insert(std::make_pair(meshRenderer, meshEntities));
-			}
-			else
-			{
-				//Found, add the entity to the mesh' list of entities
-				finder->second.push_back(&entity);
-			}
+			const XMMATRIX position =
+				XMMatrixTranslationFromVector(entities[i]->position);
+			const XMMATRIX rotation = XMMatrixRotationQuaternion(entities[i]->rotation);
+
+			CBWireFrame* wireFrame = mConstantRing.allocate<CBWireFrame>(
+				mLineConstants[lineIndex++]);
+			wireFrame->world = XMMatrixMultiplyTranspose(rotation, position);
+			memcpy(&wireFrame->color, &line->mColor, sizeof(XMFLOAT4));
 		}
+	}
 
-		const bsLineRenderer* line = entity.getLineRenderer();
-		if (line != nullptr)
-		{
-			auto finder = mLinesToDraw.find(line);
-
-			if (finder == mLinesToDraw.end())
-			{
-				//Not found, create it
-				std::vector<const bsEntity*> lineEntities(1);
-				lineEntities[0] = &entity;
-				mLinesToDraw.insert(std::make_pair(line, lineEntities));
-			}
-			else
-			{
-				//Found
-				finder->second.push_back(&entity);
-			}
-		}
+	mConstantRing.upload();
+}
 
-		const bsLight* light = entity.getLight();
-		if (light != nullptr)
-		{
-			XMFLOAT3 position;
-			XMStoreFloat3(&position, entity.getTransform().getPosition());
-			switch (light->getLightType())
-			{
-			case bsLight::LT_POINT:
-				mPointLightPositionPairs.push_back(std::make_pair(light, position));
-				break;
-
-			case bsLight::LT_SPOT:
-				mSpotLightPositionPairs.push_back(std::make_pair(light, &entity));
-				break;
-
-			case bsLight::LT_DIRECTIONAL:
-				mDirectionalLightPositionPairs.push_back(std::make_pair(light, position));
-				break;
-			}
-		}
+void bsRenderQueue::setLightConstantBuffer(const CBLight& cbLight)
+{
+	bsRenderDevice& renderDevice = mDx11Renderer->getRenderDevice();
 
-		const bsText3D* text = entity.getTextRenderer();
-		if (text != nullptr)
-		{
-			mText3dToDraw.push_back(std::make_pair(&entity, text));
-		}
-	}
+	renderDevice.setVertexConstantBuffers(3, 1, &mLightBuffer);
+	renderDevice.setPixelConstantBuffers(3, 1, &mLightBuffer);
 
-	mFrameStats.visibleLights = mPointLightPositionPairs.size();
+	renderDevice.updateBuffer(mLightBuffer, &cbLight, sizeof(cbLight));
 }
 
 void bsRenderQueue::unbindGeometryShader()
 {
-	mDx11Renderer->getDeviceContext()->GSSetShader(nullptr, nullptr, 0);
+	mDx11Renderer->getRenderDevice().setGeometryShader(nullptr);
 }
 
 void bsRenderQueue::drawMeshesInstanced()
 {
-	mDx11Renderer->getDeviceContext()->IASetPrimitiveTopology(
+	mDx11Renderer->getRenderDevice().setPrimitiveTopology(
 		D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 	mShaderManager->setVertexShader(mMeshInstancedVertexShader);
 
-	mFrameStats.uniqueMeshesDrawn = mMeshesToDraw.size();
+	//Index of the batch's constants, in the order writeConstants wrote them.
+	unsigned int batchIndex = 0;
 
+	const bsRenderBatcher::MeshBatches& meshBatches = mBatcher.getMeshBatches();
+	for (auto itr = meshBatches.begin(), end = meshBatches.end(); itr != end; ++itr)
+	{
+		const std::vector<const bsEntitySnapshot*>& entities = itr->second;
+		if (entities.empty())
+		{
+			//Not visible this frame, kept only to reuse the list's memory.
+			continue;
+		}
 
-	std::vector<XMMATRIX, bsAlignedAllocator<XMMATRIX>> transforms;
+		const bsConstantBufferRing::Allocation& materialConstants =
+			mMeshBatchConstants[batchIndex++];
 
-	for (auto itr = mMeshesToDraw.begin(), end = mMeshesToDraw.end(); itr != end; ++itr)
-	{
 		const bsMeshRenderer& meshRenderer = *itr->first;
 		if (!meshRenderer.hasFinishedLoading())
 		{
 			continue;
 		}
 
-		const std::vector<const bsEntity*>& entities = itr->second;
+		++mFrameStats.uniqueMeshesDrawn;
 		mFrameStats.totalMeshesDrawn += entities.size();
 		mFrameStats.totalTrianglesDrawn += meshRenderer.getTriangleCount();
 		mFrameStats.totalTrianglesDrawnNotInstanced += meshRenderer.getTriangleCount() * entities.size();
 
-		transforms.clear();
-		transforms.reserve(entities.size());
+		//The transforms are only needed until they have been copied to the GPU.
+		bsAllocatorScope<bsFrameAllocator> transformsScope(mFrameAllocator);
+		XMMATRIX* transforms = mFrameAllocator.allocate<XMMATRIX>(entities.size());
 		for (unsigned int i = 0; i < entities.size(); ++i)
 		{
-			transforms.push_back(entities[i]->getTransform().getTransposedTransform());
+			transforms[i] = entities[i]->transposedTransform;
 		}
 
 		if (meshRenderer.getMaterial()->normal)
@@ -417,12 +378,13 @@ void bsRenderQueue::drawMeshesInstanced()
 			mShaderManager->setPixelShader(mInstancedTexturedMeshPixelShader);
 		}
 
-		drawMeshInstanced(meshRenderer, transforms.data(), transforms.size());
+		drawMeshInstanced(meshRenderer, transforms, entities.size(), materialConstants);
 	}
 }
 
 void bsRenderQueue::drawMeshInstanced(const bsMeshRenderer& meshRenderer,
-	const XMMATRIX* transforms, unsigned int transformCount)
+	const XMMATRIX* transforms, unsigned int transformCount,
+	const bsConstantBufferRing::Allocation& materialConstants)
 {
 	//Create instance buffer. TODO: Find a less terrible way to do this.
 
@@ -434,29 +396,24 @@ void bsRenderQueue::drawMeshInstanced(const bsMeshRenderer& meshRenderer,
 	D3D11_SUBRESOURCE_DATA instanceData = { 0 };
 	instanceData.pSysMem = transforms;
 
+	bsRenderDevice& renderDevice = mDx11Renderer->getRenderDevice();
+
 	ID3D11Buffer* instanceBuffer;
-	HRESULT hr = mDx11Renderer->getDevice()->CreateBuffer(&instanceBufferDesc, &instanceData, &instanceBuffer);
+	HRESULT hr = renderDevice.createBuffer(instanceBufferDesc, &instanceData,
+		&instanceBuffer);
 	BS_ASSERT(SUCCEEDED(hr));
 
 #ifdef BS_DEBUG
-	bsString32 debugName("Mesh instance buffer");
-	instanceBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, debugName.size(), debugName.c_str());
+	renderDevice.setDebugName(instanceBuffer, "Mesh instance buffer");
 #endif
 
-	ID3D11DeviceContext& deviceContext = *mDx11Renderer->getDeviceContext();
-
-	CBMaterial materialContent;
-	materialContent.color = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
-	materialContent.uvTile = meshRenderer.getMaterial()->uvTile;
-	deviceContext.UpdateSubresource(mMaterialBuffer, 0, nullptr, &materialContent, 0, 0);
-
-	deviceContext.VSSetConstantBuffers(5, 1, &mMaterialBuffer);
+	mConstantRing.bind(5, materialConstants, bsConstantBufferRing::VERTEX_STAGE);
 
 
-	meshRenderer.drawInstanced(deviceContext, instanceBuffer, transformCount);
+	meshRenderer.drawInstanced(renderDevice, instanceBuffer, transformCount);
 
 
-	instanceBuffer->Release();
+	renderDevice.release(instanceBuffer);
 }
 
 void bsRenderQueue::drawLines()
@@ -464,53 +421,32 @@ void bsRenderQueue::drawLines()
 	mShaderManager->setPixelShader(mWireframePixelShader);
 	mShaderManager->setVertexShader(mWireframeVertexShader);
 
-	mDx11Renderer->getDeviceContext()->IASetPrimitiveTopology(
-		D3D_PRIMITIVE_TOPOLOGY_LINELIST);
+	mDx11Renderer->getRenderDevice().setPrimitiveTopology(
+		D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
 		//D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-	static float angle = 0.0f;
-	angle += XMConvertToRadians(2.0f);
-	if (angle > XM_PI * 2.0f)
-	{
-		angle = 0.0f;
-	}
+	//Index of the line's constants, in the order writeConstants wrote them.
+	unsigned int lineIndex = 0;
 
-	for (auto itr = mLinesToDraw.begin(), end = mLinesToDraw.end(); itr != end; ++itr)
+	const bsRenderBatcher::LineBatches& lineBatches = mBatcher.getLineBatches();
+	for (auto itr = lineBatches.begin(), end = lineBatches.end(); itr != end; ++itr)
 	{
 		const bsLineRenderer* currentLine = itr->first;
-		const std::vector<const bsEntity*>& entities = itr->second;
+		const std::vector<const bsEntitySnapshot*>& entities = itr->second;
 
 		mFrameStats.linesDrawn += entities.size();
 
 		for (unsigned int i = 0, count = entities.size(); i < count; ++i)
 		{
-			/*
-			const hkTransform& transform = entities[i]->getDerivedTransformation();
-			float f4x4[16];
-			transform.get4x4ColumnMajor(f4x4);
-			XMFLOAT4X4 world(f4x4);
-			bsMath::XMFloat4x4Transpose(world);
-			*/
-
-			const XMMATRIX position = XMMatrixTranslationFromVector(entities[i]->getTransform().getPosition());
-			XMMATRIX rotation = XMMatrixRotationQuaternion(entities[i]->getTransform().getRotation());
-			const XMMATRIX extraRot = XMMatrixRotationY(angle);
-
-			//rotation = XMMatrixMultiply(rotation, extraRot);
-			//rotation = extraRot;
-
-			//rotation = XMMatrixRotationQuaternion(mCamera->getEntity()->getOwner()->getRotation());
-			//XMVECTOR determinant;
-			//rotation = XMMatrixInverse(&determinant, rotation);
-			
-			setWireframeConstantBuffer(XMMatrixMultiplyTranspose(rotation, position), currentLine->mColor);
+			mConstantRing.bind(1, mLineConstants[lineIndex++],
+				bsConstantBufferRing::VERTEX_STAGE | bsConstantBufferRing::PIXEL_STAGE);
 
 			currentLine->draw(mDx11Renderer);
 		}
 	}
 }
 
-void drawInstancedLight(const bsDx11Renderer& renderer, const bsLight& light,
+void drawInstancedLight(bsRenderDevice& renderDevice, const bsLight& light,
 	const LightInstanceData* lightInstanceData, unsigned int instanceCount)
 {
 	D3D11_BUFFER_DESC instanceBufferDesc = { 0 };
@@ -522,36 +458,36 @@ void drawInstancedLight(const bsDx11Renderer& renderer, const bsLight& light,
 	instanceData.pSysMem = lightInstanceData;
 
 	ID3D11Buffer* instanceBuffer;
-	HRESULT hr = renderer.getDevice()->CreateBuffer(&instanceBufferDesc, &instanceData, &instanceBuffer);
+	HRESULT hr = renderDevice.createBuffer(instanceBufferDesc, &instanceData,
+		&instanceBuffer);
 	BS_ASSERT(SUCCEEDED(hr));
 
 #ifdef BS_DEBUG
-	bsString32 debugName("Light instance buffer");
-	instanceBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, debugName.size(), debugName.c_str());
+	renderDevice.setDebugName(instanceBuffer, "Light instance buffer");
 #endif
 
-	//bsLight::drawInstanced(*renderer.getDeviceContext(), instanceBuffer, instanceCount);
-	light.drawInstanced(*renderer.getDeviceContext(), instanceBuffer, instanceCount);
+	light.drawInstanced(renderDevice, instanceBuffer, instanceCount);
 
-	instanceBuffer->Release();
+	renderDevice.release(instanceBuffer);
 }
 
 void bsRenderQueue::drawLights()
 {
-	mDx11Renderer->getDeviceContext()->IASetPrimitiveTopology(
-		D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	bsRenderDevice& renderDevice = mDx11Renderer->getRenderDevice();
 
-	mDx11Renderer->getDeviceContext()->PSSetSamplers(3, 1, &mLightSamplerState);
+	renderDevice.setPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	renderDevice.setPixelSamplers(3, 1, &mLightSamplerState);
 
 	mShaderManager->setVertexShader(mLightInstancedVertexShader);
 
-	if (!mPointLightPositionPairs.empty())
+	if (!mBatcher.getPointLights().empty())
 	{
 		mShaderManager->setPixelShader(mPointLightInstancedPixelShader);
 		drawPointLights();
 	}
 
-	if (!mSpotLightPositionPairs.empty())
+	if (!mBatcher.getSpotLights().empty())
 	{
 		mShaderManager->setPixelShader(mSpotLightInstancedPixelShader);
 		drawSpotLights();
@@ -571,7 +507,7 @@ void bsRenderQueue::sortLights()
 	std::vector<std::pair<const bsLight*, XMFLOAT4X4>> containingCamera;
 
 	
-	const XMVECTOR& cameraPosition = mCamera->getEntity()->getTransform().getPosition();
+	const XMVECTOR& cameraPosition = mSnapshot->getCameraPosition();
 	const float nearClip = mCamera->getProjectionInfo().mNearClip;
 	const float nearClipSquared = nearClip * nearClip;
 
@@ -582,10 +518,12 @@ void bsRenderQueue::sortLights()
 	//Light position - camera position.
 	XMVECTOR deltaPosition;
 
-	for (size_t i = 0; i < mPointLightPositionPairs.size(); ++i)
+	const std::vector<std::pair<const bsLight*, XMFLOAT3>>& pointLights =
+		mBatcher.getPointLights();
+	for (size_t i = 0; i < pointLights.size(); ++i)
 	{
-		const bsLight* light = mPointLightPositionPairs[i].first;
-		const XMFLOAT3& position = mPointLightPositionPairs[i].second;
+		const bsLight* light = pointLights[i].first;
+		const XMFLOAT3& position = pointLights[i].second;
 
 		//Create the light's transform, which includes the light's radius as scaling factor
 		//and the entity's position.
@@ -627,10 +565,13 @@ void bsRenderQueue::drawTexts()
 {
 	const XMMATRIX viewProjection = mCamera->getViewProjection();
 
-	std::for_each(std::begin(mText3dToDraw), std::end(mText3dToDraw),
-		[&](const std::pair<const bsEntity*, const bsText3D*>& text)
+	const std::vector<std::pair<const bsEntitySnapshot*, const bsText3D*>>& texts =
+		mBatcher.getTexts();
+	std::for_each(std::begin(texts), std::end(texts),
+		[&](const std::pair<const bsEntitySnapshot*, const bsText3D*>& text)
 	{
-		const XMMATRIX& entityTransform = text.first->getTransform().getTransform();
+		const XMMATRIX entityTransform =
+			XMMatrixTranspose(text.first->transposedTransform);
 		const XMMATRIX worldTransform = XMMatrixMultiply(
 			//180 degrees around X axis
 			XMMatrixRotationAxis(XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f), XMConvertToRadians(180.0f)),
@@ -645,7 +586,9 @@ void bsRenderQueue::drawTexts()
 
 void bsRenderQueue::drawPointLights()
 {
-	BS_ASSERT2(!mPointLightPositionPairs.empty(), "drawPointLights called, but there are"
+	const std::vector<std::pair<const bsLight*, XMFLOAT3>>& pointLights =
+		mBatcher.getPointLights();
+	BS_ASSERT2(!pointLights.empty(), "drawPointLights called, but there are"
 		" no point lights to draw");
 
 	XMMATRIX scalingMatrix;
@@ -653,15 +596,14 @@ void bsRenderQueue::drawPointLights()
 	XMFLOAT4X4 lightWorldTransform;
 	CBLight cbLight;
 
-	const unsigned int lightCount = mPointLightPositionPairs.size();
+	const unsigned int lightCount = pointLights.size();
 
-	std::vector<LightInstanceData, bsAlignedAllocator<LightInstanceData>> lightData;
-	lightData.reserve(lightCount);
+	LightInstanceData* lightData = mFrameAllocator.allocate<LightInstanceData>(lightCount);
 
 	for (size_t i = 0; i < lightCount; ++i)
 	{
-		const bsLight* light = mPointLightPositionPairs[i].first;
-		const XMFLOAT3& position = mPointLightPositionPairs[i].second;
+		const bsLight* light = pointLights[i].first;
+		const XMFLOAT3& position = pointLights[i].second;
 
 		//Create the light's transform, which includes the light's radius as scaling factor
 		//and the entity's position.
@@ -673,7 +615,7 @@ void bsRenderQueue::drawPointLights()
 		fullTransform = XMMatrixTranspose(fullTransform);
 
 
-		LightInstanceData data;
+		LightInstanceData& data = lightData[i];
 		data.world = fullTransform;
 		const XMFLOAT3& lightColor = light->getLightData().color;
 		data.colorIntensity.x = lightColor.x;
@@ -689,17 +631,17 @@ void bsRenderQueue::drawPointLights()
 		//Unused for point lights.
 		memset(&data.attenuation, 0, sizeof(data.attenuation));
 		memset(&data.direction, 0, sizeof(data.direction));
-
-		lightData.push_back(data);
 	}
 
-	drawInstancedLight(*mDx11Renderer, *mPointLightPositionPairs[0].first,
-		lightData.data(), lightData.size());
+	drawInstancedLight(mDx11Renderer->getRenderDevice(), *pointLights[0].first,
+		lightData, lightCount);
 }
 
 void bsRenderQueue::drawSpotLights()
 {
-	BS_ASSERT2(!mSpotLightPositionPairs.empty(), "drawSpotLights called, but there are"
+	const std::vector<std::pair<const bsLight*, const bsEntitySnapshot*>>& spotLights =
+		mBatcher.getSpotLights();
+	BS_ASSERT2(!spotLights.empty(), "drawSpotLights called, but there are"
 		" no spot lights to draw");
 
 	XMMATRIX scalingMatrix;
@@ -707,18 +649,17 @@ void bsRenderQueue::drawSpotLights()
 	XMFLOAT4X4 lightWorldTransform;
 	CBLight cbLight;
 
-	const unsigned int lightCount = mSpotLightPositionPairs.size();
+	const unsigned int lightCount = spotLights.size();
 
-	std::vector<LightInstanceData, bsAlignedAllocator<LightInstanceData>> lightData;
-	lightData.reserve(lightCount);
+	LightInstanceData* lightData = mFrameAllocator.allocate<LightInstanceData>(lightCount);
 
 	for (size_t i = 0; i < lightCount; ++i)
 	{
-		const bsLight* light = mSpotLightPositionPairs[i].first;
+		const bsLight* light = spotLights[i].first;
 
-		const bsTransform& lightTransform = mSpotLightPositionPairs[i].second->getTransform();
-		const XMVECTOR& position = lightTransform.getPosition();
-		const XMVECTOR& rotation = lightTransform.getRotation();
+		const bsEntitySnapshot& lightEntity = *spotLights[i].second;
+		const XMVECTOR& position = lightEntity.position;
+		const XMVECTOR& rotation = lightEntity.rotation;
 
 
 		//Create the light's transform, which includes the light's radius as scaling factor
@@ -731,7 +672,7 @@ void bsRenderQueue::drawSpotLights()
 		fullTransform = XMMatrixTranspose(fullTransform);
 
 
-		LightInstanceData data;
+		LightInstanceData& data = lightData[i];
 		data.world = fullTransform;
 		const XMFLOAT3& lightColor = light->getLightData().color;
 		data.colorIntensity.x = lightColor.x;
@@ -753,15 +694,8 @@ void bsRenderQueue::drawSpotLights()
 
 		//Unused for spot lights.
 		memset(&data.attenuation, 0, sizeof(data.attenuation));
-
-		lightData.push_back(data);
 	}
 
-	drawInstancedLight(*mDx11Renderer, *mSpotLightPositionPairs[0].first,
-		lightData.data(), lightData.size());
-}
-
-size_t bsRenderQueue::MeshRendererHasher::operator()(const bsMeshRenderer* meshRenderer) const
-{
-	return std::hash<unsigned int>()(meshRenderer->getUniqueID());
+	drawInstancedLight(mDx11Renderer->getRenderDevice(), *spotLights[0].first,
+		lightData, lightCount);
 }
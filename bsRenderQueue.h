@@ -5,12 +5,15 @@
 #include <memory>
 #include <sstream>
 #include <string>
-#include <unordered_map>
 
 #include <D3DX11.h>
 #include <Windows.h>
 #include <xnamath.h>
 
+#include "bsFrameAllocator.h"
+#include "bsRenderBatcher.h"
+#include "bsConstantBufferRing.h"
+
 class bsEntity;
 class bsRenderable;
 class bsMeshRenderer;
@@ -24,10 +27,12 @@ class bsLineRenderer;
 class bsLight;
 class bsText3D;
 class bsScene;
+class bsJobSystem;
+class bsFrameSnapshot;
+struct bsEntitySnapshot;
 struct CBLight;
 struct bsFrustum;
 
-struct ID3D11DeviceContext;
 struct ID3D11Buffer;
 
 
@@ -60,7 +65,9 @@ struct bsFrameStats
 			<< "\nTotal lines drawn: " << linesDrawn
 			<< "\nVisible lights: " << visibleLights
 			<< "\nTris (w/instanced): " << totalTrianglesDrawn
-			<< '(' << totalTrianglesDrawnNotInstanced << ')';
+			<< '(' << totalTrianglesDrawnNotInstanced << ')'
+			<< "\nHeap allocations: " << heapAllocations
+			<< "\nScratch overflows: " << scratchOverflows;
 
 		return ss.str();
 	}
@@ -77,7 +84,9 @@ struct bsFrameStats
 			<< L"\nTotal lines drawn: " << linesDrawn
 			<< L"\nVisible lights: " << visibleLights
 			<< L"\nTris (w/instanced): " << totalTrianglesDrawn
-			<< L'(' << totalTrianglesDrawnNotInstanced << L')';
+			<< L'(' << totalTrianglesDrawnNotInstanced << L')'
+			<< L"\nHeap allocations: " << heapAllocations
+			<< L"\nScratch overflows: " << scratchOverflows;
 
 		return ss.str();
 	}
@@ -91,6 +100,17 @@ struct bsFrameStats
 
 	unsigned int	totalTrianglesDrawn;
 	unsigned int	totalTrianglesDrawnNotInstanced;
+
+	/*	Heap allocations made on any thread between reset and endFrame. Should be 0 once
+		the scene has been visible for a frame. Only counted in debug builds and with
+		memory tracking, see bsAllocationCounter.
+	*/
+	unsigned int	heapAllocations;
+
+	/*	Scratch allocations made on any thread between reset and endFrame which did not
+		fit in their thread's arena, see bsScratchAllocator.
+	*/
+	unsigned int	scratchOverflows;
 };
 
 
@@ -101,15 +121,25 @@ struct bsFrameStats
 class bsRenderQueue
 {
 public:
-	bsRenderQueue(bsDx11Renderer* dx11Renderer, bsShaderManager* shaderManager);
+	bsRenderQueue(bsDx11Renderer* dx11Renderer, bsShaderManager* shaderManager,
+		bsJobSystem* jobSystem);
 
 	~bsRenderQueue();
 
-	//Clears all current collections of renderables.
+	/*	Clears all current collections of renderables and starts a new frame, invalidating
+		the transient data of the frame before the previous one.
+	*/
 	void reset();
 
+	/*	Culls and groups the entities in the scene's render snapshot, updates the
+		camera's constant buffer from the snapshot, and uploads the constants of every
+		draw in the frame.
+	*/
 	void startFrame();
 
+	//Finishes the frame's stats. Call after the last draw function.
+	void endFrame();
+
 	//Draws the geometry
 	void drawGeometry();
 
@@ -135,6 +165,18 @@ public:
 	inline void registerScene(const bsScene& scene)
 	{
 		mScene = &scene;
+		mRegisteredSnapshot = nullptr;
+	}
+
+	/*	Register a snapshot to be drawn every frame instead of a scene's, from the camera
+		set with setCamera. This makes it possible to draw without a scene, for example
+		in benchmarks without physics.
+		Replaces the registered scene, if any.
+	*/
+	inline void registerSnapshot(const bsFrameSnapshot& snapshot)
+	{
+		mScene = nullptr;
+		mRegisteredSnapshot = &snapshot;
 	}
 
 	/*	Gets the current frame stats.
@@ -146,25 +188,30 @@ public:
 		return mFrameStats;
 	}
 
-private:
-	/*	Add a batch of entities (or all entities) and cull the ones that are not visible
-		to the specified frustum.
-	*/
-	void addAndCullObjects(const bsEntity** entities, unsigned int entityCount,
-		const bsFrustum& frustum);
+	//The snapshot being drawn since the last startFrame, or null before the first frame.
+	inline const bsFrameSnapshot* getFrameSnapshot() const
+	{
+		return mSnapshot;
+	}
 
-	/*	Gets the renderables from the entities and groups them based on what kind of
-		renderable they are
+	/*	Saves the next frame's snapshot and batching results to a file once they have been
+		culled and batched, see bsFrameCapture.h. The file is written by the next
+		startFrame, so that frame will take longer than usual.
 	*/
-	void sortRenderables(const bsEntity** entities, unsigned int entityCount);
+	inline void requestFrameCapture(const std::string& fileName)
+	{
+		mFrameCaptureFileName = fileName;
+	}
 
+private:
 	void sortLights();
 
 	//Functions to draw individual renderable types.
 	void drawMeshesInstanced();
 
 	void drawMeshInstanced(const bsMeshRenderer& meshRenderer, const XMMATRIX* transforms,
-		unsigned int transformCount);
+		unsigned int transformCount,
+		const bsConstantBufferRing::Allocation& materialConstants);
 
 	void drawPointLights();
 
@@ -173,7 +220,10 @@ private:
 
 	void setWorldConstantBuffer(const XMMATRIX& world);
 
-	void setWireframeConstantBuffer(const XMMATRIX& world, const XMFLOAT4& color);
+	/*	Writes the material constants of every mesh batch and the wireframe constants of
+		every line to the constant buffer ring, and uploads them.
+	*/
+	void writeConstants();
 
 	void setLightConstantBuffer(const CBLight& cbLight);
 
@@ -181,15 +231,16 @@ private:
 
 	bsCamera*		mCamera;
 
-	//The currently registered scene which will be rendered.
+	//The currently registered scene or snapshot which will be rendered.
 	const bsScene* mScene;
+	const bsFrameSnapshot*	mRegisteredSnapshot;
+	const bsFrameSnapshot*	mSnapshot;
 	
 	bsDx11Renderer*		mDx11Renderer;
 	bsShaderManager*	mShaderManager;
+	bsJobSystem*		mJobSystem;
 	ID3D11Buffer*		mWorldBuffer;
-	ID3D11Buffer*		mWireframeWorldBuffer;
 	ID3D11Buffer*		mLightBuffer;
-	ID3D11Buffer*		mMaterialBuffer;
 
 	ID3D11SamplerState*	mLightSamplerState;
 
@@ -211,21 +262,25 @@ private:
 
 	bsFrameStats		mFrameStats;
 
-	struct MeshRendererHasher
-	{
-		size_t operator()(const bsMeshRenderer* meshRenderer) const;
-	};
+	//Visible entities grouped by what draws them.
+	bsRenderBatcher		mBatcher;
 
-	typedef std::unordered_map<const bsMeshRenderer*, std::vector<const bsEntity*>,
-		MeshRendererHasher> MeshRendererMap;
+	//Where to save the next frame capture, empty when none has been requested.
+	std::string			mFrameCaptureFileName;
 
-	MeshRendererMap mMeshesToDraw;
-	//std::unordered_map<const bsMeshRenderer*, std::vector<const bsEntity*>>		mMeshesToDraw;
-	std::unordered_map<const bsLineRenderer*, std::vector<const bsEntity*>>	mLinesToDraw;
-	std::vector<std::pair<const bsLight*, XMFLOAT3>>	mPointLightPositionPairs;
-	std::vector<std::pair<const bsLight*, const bsEntity*>>	mSpotLightPositionPairs;
-	std::vector<std::pair<const bsLight*, XMFLOAT3>>	mDirectionalLightPositionPairs;
+	//Transient arrays used while building and drawing a frame.
+	bsFrameAllocator	mFrameAllocator;
 
+	//Per draw constants of the frame, written by writeConstants.
+	bsConstantBufferRing	mConstantRing;
+	/*	Constants of each non-empty mesh batch and of each line entity, in the order they
+		are drawn. Allocated from mFrameAllocator.
+	*/
+	bsConstantBufferRing::Allocation*	mMeshBatchConstants;
+	bsConstantBufferRing::Allocation*	mLineConstants;
 
-	std::vector<std::pair<const bsEntity*, const bsText3D*>> mText3dToDraw;
+	//bsAllocationCounter's count when the frame started.
+	unsigned int		mFrameStartAllocationCount;
+	//bsScratchAllocator's overflow count when the frame started.
+	unsigned int		mFrameStartScratchOverflowCount;
 };
@@ -1,20 +1,14 @@
 #pragma once
 
 #include <string>
-#include <map>
-#include <set>
-#include <deque>
 
-class bsTrackedTimeCompare
-{
-public:
-	inline bool operator()(const std::pair<float, float>& lhs,
-		const std::pair<float, float>& rhs) const
-	{
-		return lhs.first < rhs.first;
-	}
-};
+#include "bsMetrics.h"
+
 
+/*	Frame rate and frame time statistics shown on screen.
+	Frame times are kept in a sliding window histogram, so updating them does not allocate
+	and percentiles can be shown instead of only the extremes.
+*/
 class bsRenderStats
 {
 public:
@@ -25,12 +19,7 @@ public:
 		, mFrameTimeMs(0.0f)
 		, mAverageTimeMs(16.67f)
 		, mAverageWeight(1.0f)
-		, mHistoryDuration(10000.0f)
-
-		//These 2 will be updated by the setFrameTime functions so we can just set them to
-		//silly values here to force the update to happen during the first function call
-		, mCurrentMin(1e5f, 0.0f)
-		, mCurrentMax(0.0f, 0.0f)
+		, mFrameTimes(10000.0f / bsMetricHistogram::kSliceCount)
 	{}
 
 	std::wstring getStatsString() const;
@@ -48,20 +37,21 @@ public:
 	//Default: 10000.0f (10 seconds)
 	inline void setHistoryLength(float durationMs)
 	{
-		mHistoryDuration = durationMs;
+		mFrameTimes.setSliceDuration(durationMs / bsMetricHistogram::kSliceCount);
 	}
 
 private:
+	//Non-copyable.
+	bsRenderStats(const bsRenderStats&);
+	bsRenderStats& operator=(const bsRenderStats&);
+
 	float	mFps;
 	float	mAverageFps;
 	float	mFrameTimeMs;
 	float	mAverageTimeMs;
 
 	float	mAverageWeight;
-	float	mHistoryDuration;
 
-	//pair<frame time, age in ms>
-	std::pair<float, float>	mCurrentMin;
-	std::pair<float, float>	mCurrentMax;
-	std::set<std::pair<float, float>, bsTrackedTimeCompare>	mTrackedTimes;
+	//Frame times in microseconds. Mutable since summarizing reuses a scratch histogram.
+	mutable bsMetricHistogram	mFrameTimes;
 };
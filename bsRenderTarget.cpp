@@ -4,14 +4,14 @@
 
 #include <string>
 
-#include "bsDx11Renderer.h"
+#include "bsRenderDevice.h"
 #include "bsAssert.h"
-#include "bsFixedSizeString.h"
 
 
 bsRenderTarget::bsRenderTarget(unsigned int width, unsigned int height,
-	ID3D11Device& device)
-	: mFormat(DXGI_FORMAT_R16G16B16A16_FLOAT)
+	bsRenderDevice& renderDevice)
+	: mRenderDevice(renderDevice)
+	, mFormat(DXGI_FORMAT_R16G16B16A16_FLOAT)
 	, mRenderTargetTexture(nullptr)
 	, mRenderTargetView(nullptr)
 	, mShaderResourceView(nullptr)
@@ -19,13 +19,13 @@ bsRenderTarget::bsRenderTarget(unsigned int width, unsigned int height,
 	//DXGI_FORMAT_R32G32B32A32_FLOAT
 
 	//Create the texture
-	bool success = createTexture(width, height, device);
+	bool success = createTexture(width, height);
 
 	//Create the render target view
-	success |= createView(device);
+	success |= createView();
 
 	//Create shader resource
-	success |= createShaderResourceView(device);
+	success |= createShaderResourceView();
 
 	//TODO: Do something sensible when something fails.
 	(void)success;
@@ -35,35 +35,29 @@ bsRenderTarget::bsRenderTarget(unsigned int width, unsigned int height,
 
 bsRenderTarget::~bsRenderTarget()
 {
-	mRenderTargetTexture->Release();
-	mRenderTargetView->Release();
-	mShaderResourceView->Release();
+	release();
 }
 
-bool bsRenderTarget::windowResized(unsigned int width, unsigned int height,
-	ID3D11Device& device)
+bool bsRenderTarget::windowResized(unsigned int width, unsigned int height)
 {
 	//Release resources and recreate them.
 
-	mRenderTargetTexture->Release();
-	mRenderTargetView->Release();
-	mShaderResourceView->Release();
+	release();
 
 
 	//Create the texture
-	bool success = createTexture(width, height, device);
+	bool success = createTexture(width, height);
 
 	//Create the render target view
-	success |= createView(device);
+	success |= createView();
 
 	//Create shader resource
-	success |= createShaderResourceView(device);
+	success |= createShaderResourceView();
 
 	return success;
 }
 
-bool bsRenderTarget::createTexture(unsigned int width, unsigned int height,
-	ID3D11Device& device)
+bool bsRenderTarget::createTexture(unsigned int width, unsigned int height)
 {
 	D3D11_TEXTURE2D_DESC textureDesc;
 	memset(&textureDesc, 0, sizeof(textureDesc));
@@ -77,21 +71,19 @@ bool bsRenderTarget::createTexture(unsigned int width, unsigned int height,
 	textureDesc.Usage = D3D11_USAGE_DEFAULT;
 	textureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
 
-	const HRESULT hr = device.CreateTexture2D(&textureDesc, nullptr,
+	const HRESULT hr = mRenderDevice.createTexture2D(textureDesc, nullptr,
 		&mRenderTargetTexture);
 
 	BS_ASSERT2(SUCCEEDED(hr), "Failed to create texture");
 
 #ifdef BS_DEBUG
-	const bsString32 debugName("Render target texture");
-	mRenderTargetTexture->SetPrivateData(WKPDID_D3DDebugObjectName, debugName.size(),
-		debugName.c_str());
+	mRenderDevice.setDebugName(mRenderTargetTexture, "Render target texture");
 #endif
 
 	return SUCCEEDED(hr);
 }
 
-bool bsRenderTarget::createView(ID3D11Device& device)
+bool bsRenderTarget::createView()
 {
 	D3D11_RENDER_TARGET_VIEW_DESC renderTargetDesc;
 	memset(&renderTargetDesc, 0, sizeof(renderTargetDesc));
@@ -100,21 +92,19 @@ bool bsRenderTarget::createView(ID3D11Device& device)
 	renderTargetDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
 	renderTargetDesc.Texture2D.MipSlice = 0;
 
-	const HRESULT hr = device.CreateRenderTargetView(mRenderTargetTexture, &renderTargetDesc,
-		&mRenderTargetView);
+	const HRESULT hr = mRenderDevice.createRenderTargetView(mRenderTargetTexture,
+		&renderTargetDesc, &mRenderTargetView);
 
 	BS_ASSERT2(SUCCEEDED(hr), "Failed to create render target view");
 
 #ifdef BS_DEBUG
-	const bsString32 debugName("Render target view");
-	mRenderTargetView->SetPrivateData(WKPDID_D3DDebugObjectName, debugName.size(),
-		debugName.c_str());
+	mRenderDevice.setDebugName(mRenderTargetView, "Render target view");
 #endif
 
 	return SUCCEEDED(hr);
 }
 
-bool bsRenderTarget::createShaderResourceView(ID3D11Device& device)
+bool bsRenderTarget::createShaderResourceView()
 {
 	D3D11_SHADER_RESOURCE_VIEW_DESC shaderResourceDesc;
 	memset(&shaderResourceDesc, 0, sizeof(shaderResourceDesc));
@@ -124,16 +114,21 @@ bool bsRenderTarget::createShaderResourceView(ID3D11Device& device)
 	shaderResourceDesc.Texture2D.MostDetailedMip = 0;
 	shaderResourceDesc.Texture2D.MipLevels = 1;
 
-	const HRESULT hr = device.CreateShaderResourceView(mRenderTargetTexture,
+	const HRESULT hr = mRenderDevice.createShaderResourceView(mRenderTargetTexture,
 		&shaderResourceDesc, &mShaderResourceView);
 
 	BS_ASSERT2(SUCCEEDED(hr), "Failed to create shader resource view");
 
 #ifdef BS_DEBUG
-	const bsString64 debugName("Render target shader resource view");
-	mShaderResourceView->SetPrivateData(WKPDID_D3DDebugObjectName, debugName.size(),
-		debugName.c_str());
+	mRenderDevice.setDebugName(mShaderResourceView, "Render target shader resource view");
 #endif
 
 	return SUCCEEDED(hr);
 }
+
+void bsRenderTarget::release()
+{
+	mRenderDevice.release(mRenderTargetTexture);
+	mRenderDevice.release(mRenderTargetView);
+	mRenderDevice.release(mShaderResourceView);
+}
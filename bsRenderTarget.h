@@ -2,6 +2,8 @@
 
 #include <d3d11.h>
 
+class bsRenderDevice;
+
 
 /*	Defines a render target which can be used as both a render target, texture and shader
 	resource (input for shaders).
@@ -11,7 +13,7 @@
 class bsRenderTarget
 {
 public:
-	bsRenderTarget(unsigned int width, unsigned int height, ID3D11Device& device);
+	bsRenderTarget(unsigned int width, unsigned int height, bsRenderDevice& renderDevice);
 
 	~bsRenderTarget();
 
@@ -19,7 +21,7 @@ public:
 	/*	Called when the screen is resized.
 		This resizes the render target to match the size of the screen.
 	*/
-	bool windowResized(unsigned int width, unsigned int height, ID3D11Device& device);
+	bool windowResized(unsigned int width, unsigned int height);
 	
 	inline ID3D11RenderTargetView* getRenderTargetView() const
 	{
@@ -38,13 +40,16 @@ public:
 
 
 private:
-	bool createTexture(unsigned int width, unsigned int height, ID3D11Device& device);
+	bool createTexture(unsigned int width, unsigned int height);
+
+	bool createView();
 
-	bool createView(ID3D11Device& device);
+	bool createShaderResourceView();
 
-	bool createShaderResourceView(ID3D11Device& device);
+	void release();
 
 
+	bsRenderDevice&				mRenderDevice;
 	DXGI_FORMAT					mFormat;
 	ID3D11Texture2D*			mRenderTargetTexture;
 	ID3D11RenderTargetView*		mRenderTargetView;
@@ -21,31 +21,34 @@ bsResourceManager::bsResourceManager()
 
 bsResourceManager::~bsResourceManager()
 {
-	delete mFileSystem;
 	delete mShaderManager;
 	delete mMeshCache;
 	delete mTextManager;
 	delete mTextureCache;
 	delete mMaterialCache;
+	//Deleted last since the caches refer to it.
+	delete mFileSystem;
 }
 
 void bsResourceManager::initAll(const std::string& fileSystemBasePath,
-	bsDx11Renderer* dx11Renderer, bsFileIoManager& fileIoManager)
+	bsDx11Renderer* dx11Renderer, bsFileIoManager& fileIoManager, bsJobSystem& jobSystem,
+	const std::string& fileSystemCacheFileName)
 {
-	initFileSystem(fileSystemBasePath);
+	initFileSystem(fileSystemBasePath, fileSystemCacheFileName);
 	initShaderManager(dx11Renderer);
-	initMeshCache(dx11Renderer, fileIoManager);
+	initMeshCache(dx11Renderer, fileIoManager, jobSystem);
 	initTextManager(dx11Renderer);
 	initTextureCache(*dx11Renderer->getDevice(), fileIoManager);
 	initMaterialCache();
 }
 
-void bsResourceManager::initFileSystem(const std::string& basePath)
+void bsResourceManager::initFileSystem(const std::string& basePath,
+	const std::string& cacheFileName)
 {
 	BS_ASSERT2(!mFileSystem, "Attempting to initialize file system multiple times, "
 		"memory will leak and other problems may arise");
 
-	mFileSystem = new bsFileSystem(basePath);
+	mFileSystem = new bsFileSystem(basePath, cacheFileName);
 }
 
 void bsResourceManager::initShaderManager(bsDx11Renderer* dx11Renderer)
@@ -63,14 +66,15 @@ void bsResourceManager::initShaderManager(bsDx11Renderer* dx11Renderer)
 	mShaderManager = new bsShaderManager(*dx11Renderer, *mFileSystem, shaderCachePath);
 }
 
-void bsResourceManager::initMeshCache(bsDx11Renderer* dx11Renderer, bsFileIoManager& fileIoManager)
+void bsResourceManager::initMeshCache(bsDx11Renderer* dx11Renderer,
+	bsFileIoManager& fileIoManager, bsJobSystem& jobSystem)
 {
 	BS_ASSERT(dx11Renderer);
 
 	BS_ASSERT2(!mMeshCache, "Attempting to initialize mesh manager multiple times, "
 		"memory will leak and other problems may arise");
 
-	mMeshCache = new bsMeshCache(dx11Renderer, *getFileSystem(), fileIoManager);
+	mMeshCache = new bsMeshCache(dx11Renderer, *getFileSystem(), fileIoManager, jobSystem);
 }
 
 void bsResourceManager::initTextManager(bsDx11Renderer* dx11Renderer)
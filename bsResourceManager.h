@@ -8,6 +8,7 @@
 
 class bsDx11Renderer;
 class bsFileIoManager;
+class bsJobSystem;
 class bsTextureCache;
 class bsMaterialCache;
 
@@ -26,13 +27,15 @@ public:
 
 	//Initiates all resource managers
 	void initAll(const std::string& fileSystemBasePath, bsDx11Renderer* dx11Renderer,
-		bsFileIoManager& fileIoManager);
+		bsFileIoManager& fileIoManager, bsJobSystem& jobSystem,
+		const std::string& fileSystemCacheFileName = "");
 
-	void initFileSystem(const std::string& basePath);
+	void initFileSystem(const std::string& basePath, const std::string& cacheFileName = "");
 
 	void initShaderManager(bsDx11Renderer* dx11Renderer);
 
-	void initMeshCache(bsDx11Renderer* dx11Renderer, bsFileIoManager& fileIoManager);
+	void initMeshCache(bsDx11Renderer* dx11Renderer, bsFileIoManager& fileIoManager,
+		bsJobSystem& jobSystem);
 
 	void initTextManager(bsDx11Renderer* dx11Renderer);
 
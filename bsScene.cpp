@@ -9,9 +9,10 @@
 #include <Physics/Dynamics/Entity/hkpRigidBody.h>
 #include <Physics/Dynamics/World/hkpSimulationIsland.h>
 #include <Physics/Collide/Dispatch/hkpAgentRegisterUtil.h>
+#include <Common/Base/System/hkBaseSystem.h>
+#include <Common/Base/Memory/System/hkMemorySystem.h>
 
 #include "bsEntity.h"
-#include "bsTimer.h"
 #include "bsCamera.h"
 #include "bsLog.h"
 #include "bsAssert.h"
@@ -21,21 +22,69 @@
 #include "bsTemplates.h"
 #include "bsFrameStatistics.h"
 #include "bsDx11Renderer.h"
+#include "bsMemoryTracker.h"
+#include "bsScratchAllocator.h"
+#include "bsJobSystem.h"
+#include "bsFrameSnapshot.h"
+#include "bsWindowsUtils.h"
+#include "bsThreadPlacement.h"
+#include "bsProfiler.h"
+
+
+namespace
+{
+//A rigid body's transform, read while the physics world is locked.
+struct RigidBodyTransform
+{
+	XMVECTOR	position;
+	XMVECTOR	rotation;
+	bsEntity*	entity;
+};
+
+//Entities synchronized per job.
+const unsigned int kSynchronizationGrainSize = 256;
+
+/*	Entities in a hierarchy update their children's transforms and read their parent's,
+	so only entities which are not part of one can be synchronized in parallel.
+*/
+inline bool isInHierarchy(const bsEntity& entity)
+{
+	const bsTransform& transform = entity.getTransform();
+
+	return transform.getParentTransform() != nullptr || !transform.getChildren().empty();
+}
+}
 
 
 bsScene::bsScene(bsDx11Renderer* renderer, bsHavokManager* havokManager,
-	const bsCoreCInfo& cInfo)
+	bsJobSystem* jobSystem, const bsCoreCInfo& cInfo)
 	: mNumCreatedEntities(0)
 	, mDx11Renderer(renderer)
 	, mPhysicsWorld(nullptr)
 	, mHavokManager(havokManager)
+	, mJobSystem(jobSystem)
 	, mStepPhysics(true)
 	, mTimeScale(1.0f)
 	, mPhysicsFrequency(60.0f)
 	, mPhysicsStepSizeMs(1000.0f / 60.0f)
+	, mRenderSnapshotIndex(0)
+	, mPipelined(false)
+	, mSimulationThread(nullptr)
+	, mSimulationStartEvent(nullptr)
+	, mSimulationFinishedEvent(nullptr)
+	, mQuitSimulation(false)
+	, mSimulationRunning(false)
+	, mSimulatedSnapshotReady(false)
+	, mSimulationDeltaTimeMs(0.0f)
+	, mSimulationWaitDuration(0.0f)
 {
 	BS_ASSERT(renderer);
 	BS_ASSERT(havokManager);
+	BS_ASSERT(jobSystem);
+
+	mSnapshots[0] = new bsFrameSnapshot();
+	mSnapshots[1] = new bsFrameSnapshot();
+	memset(&mSimulationPhysicsInfo, 0, sizeof(mSimulationPhysicsInfo));
 
 	//Create physics world and visual debugger.
 	createPhysicsWorld(mHavokManager->getJobQueue());
@@ -56,17 +105,35 @@ bsScene::bsScene(bsDx11Renderer* renderer, bsHavokManager* havokManager,
 	mDx11Renderer->addResizeListener(
 		[this](unsigned int screenWidth, unsigned int screenHeight)
 	{
+		//The simulation thread reads the camera while capturing the frame snapshot.
+		waitForSimulation();
+
 		bsProjectionInfo projectionInfo = mCamera->getProjectionInfo();
 		projectionInfo.mScreenSize.x = (float)screenWidth;
 		projectionInfo.mScreenSize.y = (float)screenHeight;
 		mCamera->setProjectionInfo(projectionInfo);
 	});
 
+	setPipelinedSimulation(cInfo.pipelinedSimulation);
+
 	bsLog::log("Scene graph initialized successfully");
 }
 
 bsScene::~bsScene()
 {
+	if (mSimulationThread != nullptr)
+	{
+		waitForSimulation();
+
+		mQuitSimulation = true;
+		SetEvent(mSimulationStartEvent);
+		mSimulationThread->join();
+		delete mSimulationThread;
+
+		CloseHandle(mSimulationStartEvent);
+		CloseHandle(mSimulationFinishedEvent);
+	}
+
 	mHavokManager->destroyVisualDebuggerForWorld(*mPhysicsWorld);
 
 	//Delete all entities in this scene.
@@ -81,11 +148,18 @@ bsScene::~bsScene()
 	mPhysicsWorld->removeContactListener(&mContactCounter);
 	mPhysicsWorld->removeReference();
 
+	delete mSnapshots[0];
+	delete mSnapshots[1];
+
 	//Camera is attached to an entity and will be deleted by that entity.
 }
 
 void bsScene::addEntity(bsEntity& entity)
 {
+	bsMemoryTagScope memoryTag(bsMemoryTracker::TAG_SCENE);
+
+	waitForSimulation();
+
 	mEntities.push_back(&entity);
 
 	entity.addedToScene(*this, getNewId());
@@ -105,6 +179,8 @@ void bsScene::removeEntity(bsEntity& entityToRemove)
 	BS_ASSERT2(entityToRemove.getScene() == this, "Trying to remove an entity from a scene"
 		" it is not a part of");
 
+	waitForSimulation();
+
 	auto itr = std::find(std::begin(mEntities), std::end(mEntities), &entityToRemove);
 
 	//Verify that the entity was found in this scene.
@@ -124,6 +200,10 @@ void bsScene::removeEntity(bsEntity& entityToRemove)
 
 	bs::unordered_erase(mEntities, itr);
 
+	//The entity may be deleted before the snapshots are captured again.
+	mSnapshots[0]->removeEntity(entityToRemove);
+	mSnapshots[1]->removeEntity(entityToRemove);
+
 	entityToRemove.removedFromScene(*this);
 
 	//Remove the entity's rigid body (if one is present) to the physics simulation.
@@ -147,14 +227,140 @@ void bsScene::removeEntity(bsEntity& entityToRemove)
 
 void bsScene::update(float deltaTimeMs, bsFrameStatistics& framStatistics)
 {
-	bsTimer timer;
+	BS_PROFILE_SCOPE("Scene update");
+
+	bsFrameStatistics::PipelineInfo& pipelineInfo = framStatistics.pipelineInfo;
+	pipelineInfo.pipelined = mPipelined;
+
+	if (!mPipelined)
+	{
+		simulate(deltaTimeMs, framStatistics.physicsInfo);
+		captureSnapshot();
+		mRenderSnapshotIndex = 1 - mRenderSnapshotIndex;
+
+		pipelineInfo.simulationWaitDuration = 0.0f;
+
+		return;
+	}
+
+	waitForSimulation();
+
+	if (mSimulatedSnapshotReady)
+	{
+		framStatistics.physicsInfo = mSimulationPhysicsInfo;
+		mSimulatedSnapshotReady = false;
+	}
+	else
+	{
+		//Nothing has been simulated yet, render the current state.
+		captureSnapshot();
+		memset(&framStatistics.physicsInfo, 0, sizeof(framStatistics.physicsInfo));
+	}
+	mRenderSnapshotIndex = 1 - mRenderSnapshotIndex;
+
+	pipelineInfo.simulationWaitDuration = mSimulationWaitDuration;
+	mSimulationWaitDuration = 0.0f;
+
+	//Simulate the next frame while this one is rendered.
+	mSimulationDeltaTimeMs = deltaTimeMs;
+	mSimulationRunning = true;
+	SetEvent(mSimulationStartEvent);
+}
+
+void bsScene::waitForSimulation()
+{
+	if (!mSimulationRunning)
+	{
+		return;
+	}
+
+	BS_PROFILE_SCOPE_STAT("Wait for simulation", mSimulationWaitDuration);
+	WaitForSingleObject(mSimulationFinishedEvent, INFINITE);
+
+	mSimulationRunning = false;
+	mSimulatedSnapshotReady = true;
+}
+
+void bsScene::setPipelinedSimulation(bool pipelined)
+{
+	if (pipelined == mPipelined)
+	{
+		return;
+	}
+
+	waitForSimulation();
+	//A step finished before the switch would be rendered out of order.
+	mSimulatedSnapshotReady = false;
+
+	if (pipelined && mSimulationThread == nullptr)
+	{
+		mSimulationStartEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+		mSimulationFinishedEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+		BS_ASSERT2(mSimulationStartEvent != nullptr
+			&& mSimulationFinishedEvent != nullptr, "Failed to create simulation events");
+
+		mSimulationThread = new tbb::tbb_thread(std::bind(&bsScene::simulationThreadLoop,
+			this));
+		bsWindowsUtils::setThreadName(GetThreadId(mSimulationThread->native_handle()),
+			"Simulation");
+		mHavokManager->getThreadPlacement().apply(mSimulationThread->native_handle(),
+			bsThreadPlacement::ROLE_PHYSICS);
+	}
+
+	mPipelined = pipelined;
+
+	BS_LOG_INFO(PHYSICS, "Pipelined simulation %s", pipelined ? "enabled" : "disabled");
+}
+
+void bsScene::captureSnapshot()
+{
+	BS_PROFILE_SCOPE("Capture snapshot");
+
+	mSnapshots[1 - mRenderSnapshotIndex]->capture(mEntities, *mCamera, *mJobSystem);
+}
+
+void bsScene::simulationThreadLoop()
+{
+	//Havok requires every thread using it to have its own memory router.
+	hkMemoryRouter memoryRouter;
+	hkMemorySystem::getInstance().threadInit(memoryRouter, "Simulation");
+	hkBaseSystem::initThread(&memoryRouter);
+
+	bsProfiler::setThreadName("Simulation");
 
-	const float preStep = timer.getTimeMilliSeconds();
+	{
+		bsMemoryTagScope memoryTag(bsMemoryTracker::TAG_SCENE);
+
+		for (;;)
+		{
+			WaitForSingleObject(mSimulationStartEvent, INFINITE);
+			if (mQuitSimulation)
+			{
+				break;
+			}
+
+			simulate(mSimulationDeltaTimeMs, mSimulationPhysicsInfo);
+			captureSnapshot();
+
+			SetEvent(mSimulationFinishedEvent);
+		}
+	}
+
+	hkBaseSystem::quitThread();
+	hkMemorySystem::getInstance().threadQuit(memoryRouter);
+}
+
+void bsScene::simulate(float deltaTimeMs, bsFrameStatistics::PhysicsInfo& physicsInfo)
+{
+	physicsInfo.stepDuration = 0.0f;
+	physicsInfo.synchronizationDuration = 0.0f;
 
 	unsigned int numPhysicsSteps = 0;
 
 	if (mStepPhysics)
 	{
+		BS_PROFILE_SCOPE_STAT("Physics step", physicsInfo.stepDuration);
+
 		mPhysicsWorld->setFrameTimeMarker(deltaTimeMs * 0.001f * mTimeScale);
 
 		const hkpStepResult result = mPhysicsWorld->advanceTime();
@@ -178,19 +384,17 @@ void bsScene::update(float deltaTimeMs, bsFrameStatistics& framStatistics)
 		}
 	}
 
-	const float preSynchronize = timer.getTimeMilliSeconds();
 	unsigned int totalActiveRigidBodies, totalActiveSimulationIslands;
-	synchronizeActiveEntities(&totalActiveRigidBodies, &totalActiveSimulationIslands);
-
-	framStatistics.physicsInfo.synchronizationDuration = timer.getTimeMilliSeconds() - preSynchronize;
-	framStatistics.physicsInfo.stepDuration = preSynchronize - preStep;
-
-	framStatistics.physicsInfo.numSteps = numPhysicsSteps;
-	framStatistics.physicsInfo.numActiveRigidBodies = totalActiveRigidBodies;
-	framStatistics.physicsInfo.numActiveSimulationIslands = totalActiveSimulationIslands;
-	framStatistics.physicsInfo.numContacts = mContactCounter.getNumContacts();
+	{
+		BS_PROFILE_SCOPE_STAT("Synchronize entities",
+			physicsInfo.synchronizationDuration);
+		synchronizeActiveEntities(&totalActiveRigidBodies, &totalActiveSimulationIslands);
+	}
 
-	mCamera->update();
+	physicsInfo.numSteps = numPhysicsSteps;
+	physicsInfo.numActiveRigidBodies = totalActiveRigidBodies;
+	physicsInfo.numActiveSimulationIslands = totalActiveSimulationIslands;
+	physicsInfo.numContacts = mContactCounter.getNumContacts();
 }
 
 void bsScene::createPhysicsWorld(hkJobQueue& jobQueue)
@@ -238,6 +442,16 @@ void bsScene::synchronizeActiveEntities(unsigned int* totalActiveRigidBodies,
 	const hkArray<hkpSimulationIsland*>& activeIslands = mPhysicsWorld->getActiveSimulationIslands();
 	*totalActiveSimulationIslands = activeIslands.getSize();
 
+	for (int i = 0; i < activeIslands.getSize(); ++i)
+	{
+		numActiveRigidBodies += activeIslands[i]->getEntities().getSize();
+	}
+
+	bsScratchScope scratch;
+	RigidBodyTransform* transforms = scratch.allocate<RigidBodyTransform>(
+		numActiveRigidBodies);
+	unsigned int transformCount = 0;
+
 	for (int i = 0; i < activeIslands.getSize(); ++i)
 	{
 		const hkArray<hkpEntity*>& entities = activeIslands[i]->getEntities();
@@ -246,26 +460,45 @@ void bsScene::synchronizeActiveEntities(unsigned int* totalActiveRigidBodies,
 		{
 			//Can use unchecked here as non-rigid body entites are not in simulation islands.
 			const hkpRigidBody* rigidBody = hkpGetRigidBodyUnchecked(entities[j]->getCollidable());
-			
-			++numActiveRigidBodies;
 
-			bsEntity& entity = bsGetEntity(*rigidBody);
-			//entity.getTransform().setTransformFromRigidBody(bsMath::toXM(rigidBody->getPosition()),
-			//	bsMath::toXM(rigidBody->getRotation()));
+			hkTransform transform;
+			rigidBody->approxCurrentTransform(transform);
 
-			{
-				hkTransform transform;
-				rigidBody->approxCurrentTransform(transform);
+			RigidBodyTransform& rigidBodyTransform = transforms[transformCount++];
+			rigidBodyTransform.position = bsMath::toXM(transform.getTranslation());
+			rigidBodyTransform.rotation = bsMath::toXM(transform.getRotation());
+			rigidBodyTransform.entity = &bsGetEntity(*rigidBody);
+		}
+	}
 
-				const XMVECTOR position = bsMath::toXM(transform.getTranslation());
-				const XMVECTOR rotation = bsMath::toXM(transform.getRotation());
+	mPhysicsWorld->unmarkForRead();
+
+	//Entities outside of hierarchies only touch their own transform.
+	mJobSystem->parallelFor(transformCount, kSynchronizationGrainSize,
+		[=](unsigned int begin, unsigned int end)
+	{
+		BS_PROFILE_SCOPE("Synchronize transforms");
 
-				entity.getTransform().setTransformFromRigidBody(position, rotation);
+		for (unsigned int i = begin; i < end; ++i)
+		{
+			const RigidBodyTransform& rigidBodyTransform = transforms[i];
+			if (!isInHierarchy(*rigidBodyTransform.entity))
+			{
+				rigidBodyTransform.entity->getTransform().setTransformFromRigidBody(
+					rigidBodyTransform.position, rigidBodyTransform.rotation);
 			}
 		}
-	}
+	});
 
-	mPhysicsWorld->unmarkForRead();
+	for (unsigned int i = 0; i < transformCount; ++i)
+	{
+		const RigidBodyTransform& rigidBodyTransform = transforms[i];
+		if (isInHierarchy(*rigidBodyTransform.entity))
+		{
+			rigidBodyTransform.entity->getTransform().setTransformFromRigidBody(
+				rigidBodyTransform.position, rigidBodyTransform.rotation);
+		}
+	}
 
 	*totalActiveRigidBodies = numActiveRigidBodies;
 }
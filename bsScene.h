@@ -2,19 +2,26 @@
 
 #include <vector>
 
+#include <Windows.h>
+
+#include <tbb/tbb_thread.h>
+
 #include <Common/Base/hkBase.h>
 
 #include "bsContactCounter.h"
+#include "bsFrameStatistics.h"
 
 class bsCamera;
 class bsDx11Renderer;
 class bsRenderable;
 class bsHavokManager;
+class bsJobSystem;
 class hkpWorld;
 struct bsCoreCInfo;
 struct bsFrameStatistics;
 class hkJobQueue;
 class bsEntity;
+class bsFrameSnapshot;
 
 
 /*	A scene represents a collection of entities.
@@ -24,12 +31,17 @@ class bsEntity;
 	all of the entities in it will also be destroyed. If you do not want specific entities
 	to be destroyed when the scene is destroyed, remove them before destroying the scene
 	by calling removeEntity().
+
+	Every update captures the state of the entities into a bsFrameSnapshot, which is what
+	the render queue draws. With pipelined simulation, the physics step and the capture
+	run on a separate thread while the previous snapshot is rendered, see
+	setPipelinedSimulation.
 */
 class bsScene
 {
 public:
 	bsScene(bsDx11Renderer* renderer, bsHavokManager* havokManager,
-		const bsCoreCInfo& cInfo);
+		bsJobSystem* jobSystem, const bsCoreCInfo& cInfo);
 
 	~bsScene();
 
@@ -67,8 +79,44 @@ public:
 		return mPhysicsWorld;
 	}
 
+	/*	Steps the physics simulation, synchronizes entities with their rigid bodies and
+		captures a new render snapshot.
+		With pipelined simulation, this instead makes the snapshot captured by the
+		previous simulation step the render snapshot, and starts the next step on the
+		simulation thread. The physics statistics are those of the previous step.
+	*/
 	void update(float deltaTimeMs, bsFrameStatistics& framStatistics);
 
+	/*	Blocks until a simulation step started by update has finished. Entities and the
+		physics world must not be accessed while a step is running, so call this before
+		modifying the scene every frame. Does nothing without pipelined simulation.
+		Adding and removing entities waits automatically.
+	*/
+	void waitForSimulation();
+
+	/*	Enables or disables pipelined simulation.
+		Without it, update simulates and captures a snapshot, which is then rendered, all
+		on the calling thread.
+		With it, the next frame is simulated on a separate thread while the current one
+		is rendered. Frames show the state from one simulation step earlier, adding a
+		frame of latency in exchange for overlapping simulation and rendering.
+		bsFrameStatistics::pipelineInfo measures the latency in either mode.
+	*/
+	void setPipelinedSimulation(bool pipelined);
+
+	inline bool isPipelinedSimulationEnabled() const
+	{
+		return mPipelined;
+	}
+
+	/*	The snapshot to render this frame, captured by the most recently finished
+		simulation step.
+	*/
+	inline const bsFrameSnapshot& getRenderSnapshot() const
+	{
+		return *mSnapshots[mRenderSnapshotIndex];
+	}
+
 
 	/*	Enabled or disables stepping of physics. This can be used to closely inspect the
 		state of the world during a frame without the physics affecting objects, making
@@ -136,9 +184,21 @@ private:
 	*/
 	void createPhysicsWorld(hkJobQueue& jobQueue);
 
+	/*	Steps physics and synchronizes the entities with their rigid bodies.
+	*/
+	void simulate(float deltaTimeMs, bsFrameStatistics::PhysicsInfo& physicsInfo);
+
+	//Captures the snapshot which is not being rendered.
+	void captureSnapshot();
+
+	//Runs simulation steps started by update, with pipelined simulation.
+	void simulationThreadLoop();
+
 	/*	Synchronizes all active (non-sleeping) rigid bodies with their entities.
 		The two parameters are output parameters and will contain information about the
 		current state of the physics simulation.
+		Rigid body transforms are read serially, since the physics world is locked for
+		reading by this thread, and then applied to the entities in parallel.
 	*/
 	void synchronizeActiveEntities(unsigned int* totalActiveRigidBodies,
 		unsigned int* totalActiveSimulationIslands);
@@ -155,6 +215,7 @@ private:
 	bsContactCounter	mContactCounter;
 
 	bsHavokManager* mHavokManager;
+	bsJobSystem*	mJobSystem;
 
 	//Whether physics should be stepped.
 	bool mStepPhysics;
@@ -164,4 +225,28 @@ private:
 	float				mPhysicsFrequency;
 	//Size of each physics step, in milliseconds.
 	float				mPhysicsStepSizeMs;
+
+	/*	One snapshot is rendered while the other is captured. Pointers, since snapshots
+		need to be 16 byte aligned.
+	*/
+	bsFrameSnapshot*	mSnapshots[2];
+	unsigned int		mRenderSnapshotIndex;
+
+	bool				mPipelined;
+
+	//Created the first time pipelined simulation is enabled.
+	tbb::tbb_thread*	mSimulationThread;
+	HANDLE				mSimulationStartEvent;
+	HANDLE				mSimulationFinishedEvent;
+	bool				mQuitSimulation;
+
+	//Whether a step has been started, and whether a finished step's snapshot is ready.
+	bool				mSimulationRunning;
+	bool				mSimulatedSnapshotReady;
+
+	//Inputs and results of the step running on the simulation thread.
+	float							mSimulationDeltaTimeMs;
+	bsFrameStatistics::PhysicsInfo	mSimulationPhysicsInfo;
+	//Time spent in waitForSimulation since the last update.
+	float							mSimulationWaitDuration;
 };
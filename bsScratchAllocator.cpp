@@ -0,0 +1,137 @@
+#include "StdAfx.h"
+
+#include "bsScratchAllocator.h"
+
+#include <vector>
+
+#include <tbb/atomic.h>
+#include <tbb/spin_mutex.h>
+
+#include "bsAssert.h"
+#include "bsMemoryTracker.h"
+
+
+namespace
+{
+//The calling thread's arena, created by the first scope on that thread.
+__declspec(thread) bsLinearHeapAllocator* gThreadArena = nullptr;
+
+//Every arena ever created, so that they can be freed on shutdown.
+std::vector<bsLinearHeapAllocator*> gArenas;
+tbb::spin_mutex gArenasMutex;
+
+tbb::atomic<size_t>				gPeakArenaBytes;
+tbb::atomic<unsigned int>		gOverflowCount;
+tbb::atomic<unsigned long long>	gOverflowBytes;
+
+
+bsLinearHeapAllocator& getThreadArena()
+{
+	if (gThreadArena == nullptr)
+	{
+		gThreadArena = new bsLinearHeapAllocator(bsScratchAllocator::kArenaSize);
+
+		tbb::spin_mutex::scoped_lock lock(gArenasMutex);
+		gArenas.push_back(gThreadArena);
+	}
+
+	return *gThreadArena;
+}
+
+void updatePeakArenaBytes(size_t usedBytes)
+{
+	size_t peak = gPeakArenaBytes;
+	while (usedBytes > peak)
+	{
+		const size_t previous = gPeakArenaBytes.compare_and_swap(usedBytes, peak);
+		if (previous == peak)
+		{
+			break;
+		}
+
+		peak = previous;
+	}
+}
+}
+
+
+bsScratchScope::bsScratchScope()
+	: mArena(getThreadArena())
+	, mMarker(mArena.getMarker())
+	, mOverflowBlocks(nullptr)
+{
+}
+
+bsScratchScope::~bsScratchScope()
+{
+	//The arena's head is at its highest right before it is rewound.
+	updatePeakArenaBytes(mArena.getMarker());
+
+	mArena.rewind(mMarker);
+
+	while (mOverflowBlocks != nullptr)
+	{
+		OverflowBlock* next = mOverflowBlocks->next;
+		bsMemoryTracker::deallocate(mOverflowBlocks);
+		mOverflowBlocks = next;
+	}
+}
+
+void* bsScratchScope::allocate(size_t bytes, size_t alignment)
+{
+	void* memory = mArena.allocate(bytes, alignment);
+	if (memory != nullptr)
+	{
+		return memory;
+	}
+
+	//Out of memory, fall back to the heap until this scope is destroyed.
+	//The header is padded so that the memory after it keeps the requested alignment.
+	if (alignment < __alignof(OverflowBlock))
+	{
+		alignment = __alignof(OverflowBlock);
+	}
+	const size_t headerSize = (sizeof(OverflowBlock) + alignment - 1) & ~(alignment - 1);
+
+	OverflowBlock* block = static_cast<OverflowBlock*>(bsMemoryTracker::allocate(
+		headerSize + bytes, alignment, bsMemoryTracker::TAG_ALLOCATORS));
+	BS_ASSERT2(block != nullptr, "Out of memory");
+
+	block->next = mOverflowBlocks;
+	mOverflowBlocks = block;
+
+	++gOverflowCount;
+	gOverflowBytes += bytes;
+
+	return reinterpret_cast<char*>(block) + headerSize;
+}
+
+
+bsScratchAllocator::Statistics bsScratchAllocator::getStatistics()
+{
+	Statistics statistics;
+	{
+		tbb::spin_mutex::scoped_lock lock(gArenasMutex);
+		statistics.arenaCount = gArenas.size();
+	}
+	statistics.peakArenaBytes = gPeakArenaBytes;
+	statistics.overflowCount = gOverflowCount;
+	statistics.overflowBytes = gOverflowBytes;
+
+	return statistics;
+}
+
+void bsScratchAllocator::shutdown()
+{
+	tbb::spin_mutex::scoped_lock lock(gArenasMutex);
+
+	for (size_t i = 0; i < gArenas.size(); ++i)
+	{
+		delete gArenas[i];
+	}
+	gArenas.clear();
+
+	//Only the calling thread's pointer can be reset, other threads must not use scratch
+	//memory after this.
+	gThreadArena = nullptr;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "bsLinearHeapAllocator.h"
+
+
+/*	Per thread scratch memory for temporary buffers, such as lists of visible objects or
+	transforms being resolved inside a job.
+
+	Every thread which uses scratch memory gets its own linear arena the first time it
+	creates a bsScratchScope, so allocating never takes a lock or touches the heap.
+	Scopes are created on the stack at the start of a job (or frame, or any function which
+	needs temporary memory), and everything allocated through a scope is freed when it is
+	destroyed. Scopes can be nested, but must be destroyed in the reverse order of
+	creation, which is always the case for scopes on the stack.
+
+	{
+		bsScratchScope scratch;
+		XMMATRIX* transforms = scratch.allocate<XMMATRIX>(entityCount);
+		...
+	}//transforms is freed here.
+
+	If a thread's arena runs out of memory, allocations fall back to the heap and are
+	freed together with the scope. These fallbacks are counted, see getStatistics.
+	Nothing allocated from a scope is constructed or destructed, so only use it for types
+	which don't need destructing.
+*/
+class bsScratchScope
+{
+public:
+	bsScratchScope();
+
+	~bsScratchScope();
+
+	/*	Allocates bytes bytes aligned to alignment, which must be a power of 2.
+		Never returns null.
+	*/
+	void* allocate(size_t bytes, size_t alignment);
+
+	/*	Allocates enough memory for the requested amount of objects, aligned to the type's
+		alignment requirement. The objects are not constructed.
+	*/
+	template <typename T>
+	inline T* allocate(size_t count)
+	{
+		return static_cast<T*>(allocate(sizeof(T) * count, __alignof(T)));
+	}
+
+private:
+	//Non-copyable.
+	bsScratchScope(const bsScratchScope&);
+	bsScratchScope& operator=(const bsScratchScope&);
+
+	//Header of a heap allocation made when the arena ran out of memory.
+	struct OverflowBlock
+	{
+		OverflowBlock*	next;
+	};
+
+
+	bsLinearHeapAllocator&				mArena;
+	const bsLinearHeapAllocator::Marker	mMarker;
+
+	//Heap allocations made by this scope, freed when it is destroyed.
+	OverflowBlock*						mOverflowBlocks;
+};
+
+
+namespace bsScratchAllocator
+{
+//Size of each thread's arena.
+const size_t kArenaSize = 256 * 1024;
+
+struct Statistics
+{
+	//Number of threads which have created an arena.
+	unsigned int		arenaCount;
+
+	//The most memory used from a single thread's arena at once.
+	size_t				peakArenaBytes;
+
+	/*	Allocations which did not fit in an arena and were made on the heap instead, and
+		their total size. Should stay at 0, if not, kArenaSize may need to be increased.
+	*/
+	unsigned int		overflowCount;
+	unsigned long long	overflowBytes;
+};
+
+//Returns statistics for all threads since startup. Thread safe.
+Statistics getStatistics();
+
+/*	Frees every thread's arena.
+	Call during shutdown, after all threads which may have used scratch memory are done.
+*/
+void shutdown();
+}
@@ -12,8 +12,10 @@
 #include "bsLog.h"
 #include "bsAssert.h"
 #include "bsDx11Renderer.h"
+#include "bsRenderDevice.h"
 #include "bsFileUtil.h"
 #include "bsTimer.h"
+#include "bsMemoryTracker.h"
 
 
 bsShaderManager::bsShaderManager(bsDx11Renderer& dx11Renderer, const bsFileSystem& fileSystem,
@@ -31,7 +33,7 @@ bsShaderManager::bsShaderManager(bsDx11Renderer& dx11Renderer, const bsFileSyste
 	//failed to create a directory with the same name.
 	if (!bsFileUtil::directoryExists(mPrecompiledShaderDirectory.c_str()))
 	{
-		bsLog::logf(bsLog::SEV_CRICICAL, "Unable to create precompiled shader directory"
+		BS_LOG_CRITICAL(RESOURCES, "Unable to create precompiled shader directory"
 			" '%s'. Please ensure that the directory name is not used by a file",
 			mPrecompiledShaderDirectory.c_str());
 
@@ -44,34 +46,39 @@ void bsShaderManager::setVertexShader(const std::shared_ptr<bsVertexShader>& ver
 {
 	BS_ASSERT(vertexShader);
 
-	ID3D11DeviceContext* context = mDx11Renderer->getDeviceContext();
+	bsRenderDevice& renderDevice = mDx11Renderer->getRenderDevice();
 
-	context->IASetInputLayout(vertexShader->mInputLayout);
-	context->VSSetShader(vertexShader->mVertexShader, nullptr, 0);
+	renderDevice.setInputLayout(vertexShader->mInputLayout);
+	renderDevice.setVertexShader(vertexShader->mVertexShader);
 }
 
 void bsShaderManager::setPixelShader(const std::shared_ptr<bsPixelShader>& pixelShader)
 {
 	BS_ASSERT(pixelShader);
 
-	ID3D11DeviceContext* context = mDx11Renderer->getDeviceContext();
-
-	context->PSSetShader(pixelShader->mPixelShader, nullptr, 0);
+	mDx11Renderer->getRenderDevice().setPixelShader(pixelShader->mPixelShader);
 }
 
-std::shared_ptr<bsVertexShader> bsShaderManager::getVertexShader(const std::string& fileName,
+std::shared_ptr<bsVertexShader> bsShaderManager::getVertexShader(const bsStringId& fileName,
 	const D3D11_INPUT_ELEMENT_DESC* inputDescs, unsigned int inputDescCount) const
 {
-	BS_ASSERT(fileName.length());
+	BS_ASSERT(*fileName.c_str());
 	BS_ASSERT2(inputDescCount, "Zero length input description");
 
+	//See if the shader already exists
+	auto val = mVertexShaders.find(fileName);
+	if (val != mVertexShaders.end())
+	{
+		return val->second;
+	}
+
 	//Get the path for the file
-	const std::string filePath = mFileSystem.getPathFromFilename(fileName);
+	const std::string filePath = mFileSystem.getPathFromFilename(fileName.c_str());
 	if (!filePath.length())
 	{
 		//The path for the given mesh name was not found
 
-		bsLog::logf(bsLog::SEV_ERROR, "Shader '%s' does not exist in any known resource"
+		BS_LOG_ERROR(RESOURCES, "Shader '%s' does not exist in any known resource"
 			"paths, it will not be created", fileName.c_str());
 
 		BS_ASSERT2(false, "Failed to load shader, file not found");
@@ -79,22 +86,19 @@ std::shared_ptr<bsVertexShader> bsShaderManager::getVertexShader(const std::stri
 		return nullptr;
 	}
 
-	//See if the shader already exists
-	auto val = mVertexShaders.find(filePath);
-	if (val != mVertexShaders.end())
-	{
-		return val->second;
-	}
-
 
 	//Not found, create and return the shader
 	//createVertexShader is not const, so must cast const away
-	return const_cast<bsShaderManager*>(this)->createVertexShader(filePath, inputDescs, inputDescCount);
+	return const_cast<bsShaderManager*>(this)->createVertexShader(fileName, filePath,
+		inputDescs, inputDescCount);
 }
 
-std::shared_ptr<bsVertexShader> bsShaderManager::createVertexShader(const std::string& fileName,
-	const D3D11_INPUT_ELEMENT_DESC* inputDescs, unsigned int inputDescCount)
+std::shared_ptr<bsVertexShader> bsShaderManager::createVertexShader(const bsStringId& shaderName,
+	const std::string& fileName, const D3D11_INPUT_ELEMENT_DESC* inputDescs,
+	unsigned int inputDescCount)
 {
+	bsMemoryTagScope memoryTag(bsMemoryTracker::TAG_RESOURCES);
+
 	//Load shader blob and create the shader.
 
 
@@ -135,25 +139,27 @@ std::shared_ptr<bsVertexShader> bsShaderManager::createVertexShader(const std::s
 
 
 	//Create the shader from the loaded blob.
-	return createVertexShaderFromBlob(blob, usingPrecompiledShader ? precompiledPath : fileName,
-		inputDescs, inputDescCount);
+	return createVertexShaderFromBlob(shaderName, blob,
+		usingPrecompiledShader ? precompiledPath : fileName, inputDescs, inputDescCount);
 }
 
-std::shared_ptr<bsVertexShader> bsShaderManager::createVertexShaderFromBlob(ID3DBlob* blob,
-	const std::string& fileName, const D3D11_INPUT_ELEMENT_DESC* inputDescs,
-	unsigned int inputDescCount)
+std::shared_ptr<bsVertexShader> bsShaderManager::createVertexShaderFromBlob(
+	const bsStringId& shaderName, ID3DBlob* blob, const std::string& fileName,
+	const D3D11_INPUT_ELEMENT_DESC* inputDescs, unsigned int inputDescCount)
 {
+	bsRenderDevice& renderDevice = mDx11Renderer->getRenderDevice();
+
 	//Create shader
 	ID3D11VertexShader* vertexShader = nullptr;
-	if (FAILED(mDx11Renderer->getDevice()->CreateVertexShader(blob->GetBufferPointer(),
-		blob->GetBufferSize(), nullptr, &vertexShader)))
+	if (FAILED(renderDevice.createVertexShader(blob->GetBufferPointer(),
+		blob->GetBufferSize(), &vertexShader)))
 	{
 		if (blob)
 		{
 			blob->Release();
 		}
 
-		bsLog::logf(bsLog::SEV_ERROR, "Failed to create vertex shader '%s'",
+		BS_LOG_ERROR(RESOURCES, "Failed to create vertex shader '%s'",
 			fileName.c_str());
 
 		BS_ASSERT2(false, "Failed to create vertex shader");
@@ -163,7 +169,7 @@ std::shared_ptr<bsVertexShader> bsShaderManager::createVertexShaderFromBlob(ID3D
 
 	//Create input layout
 	ID3D11InputLayout* vertexLayout = nullptr;
-	if (FAILED(mDx11Renderer->getDevice()->CreateInputLayout(inputDescs, inputDescCount,
+	if (FAILED(renderDevice.createInputLayout(inputDescs, inputDescCount,
 		blob->GetBufferPointer(), blob->GetBufferSize(), &vertexLayout)))
 	{
 		if (blob)
@@ -179,8 +185,8 @@ std::shared_ptr<bsVertexShader> bsShaderManager::createVertexShaderFromBlob(ID3D
 		return nullptr;
 	}
 
-	auto vs = std::make_pair(fileName, std::make_shared<bsVertexShader>(vertexShader,
-		vertexLayout, getUniqueShaderID()));
+	auto vs = std::make_pair(shaderName, std::make_shared<bsVertexShader>(vertexShader,
+		vertexLayout, renderDevice, getUniqueShaderID()));
 
 	vs.second->mInputLayoutDescriptions.insert(std::begin(vs.second->mInputLayoutDescriptions),
 		inputDescs, inputDescs + inputDescCount);
@@ -189,18 +195,16 @@ std::shared_ptr<bsVertexShader> bsShaderManager::createVertexShaderFromBlob(ID3D
 	//Set debug data in the D3D objects.
 	std::string bufferName("VS ");
 	bufferName.append(fileName);
-	vs.second->mVertexShader->SetPrivateData(WKPDID_D3DDebugObjectName,
-		bufferName.size(), bufferName.c_str());
+	renderDevice.setDebugName(vs.second->mVertexShader, bufferName.c_str());
 
 	bufferName = "IL ";
 	bufferName.append(fileName);
-	vs.second->mInputLayout->SetPrivateData(WKPDID_D3DDebugObjectName,
-		bufferName.size(), bufferName.c_str());
+	renderDevice.setDebugName(vs.second->mInputLayout, bufferName.c_str());
 #endif // BS_DEBUG
 
 	mVertexShaders.insert(vs);
 
-	bsLog::logf(bsLog::SEV_INFO, "Created vertex shader '%s'", fileName.c_str());
+	BS_LOG_INFO(RESOURCES, "Created vertex shader '%s'", fileName.c_str());
 
 	return vs.second;
 }
@@ -238,16 +242,23 @@ bool bsShaderManager::compileVertexShaderBlobFromFile(ID3DBlob** blobOut,
 //////////////////////////////////////////////////////////////////////////
 
 
-std::shared_ptr<bsPixelShader> bsShaderManager::getPixelShader(const std::string& fileName) const
+std::shared_ptr<bsPixelShader> bsShaderManager::getPixelShader(const bsStringId& fileName) const
 {
-	BS_ASSERT2(fileName.length(), "Zero length file name. Use \".\" for current path");
+	BS_ASSERT2(*fileName.c_str(), "Zero length file name. Use \".\" for current path");
+
+	//See if the shader already exists
+	auto val = mPixelShaders.find(fileName);
+	if (val != mPixelShaders.end())
+	{
+		return val->second;
+	}
 
 	//Get the path for the file
-	const std::string filePath = mFileSystem.getPathFromFilename(fileName);
+	const std::string filePath = mFileSystem.getPathFromFilename(fileName.c_str());
 
 	if (!filePath.length())
 	{
-		bsLog::logf(bsLog::SEV_ERROR, "'%s' does not exist in any known resource paths,"
+		BS_LOG_ERROR(RESOURCES, "'%s' does not exist in any known resource paths,"
 			" it will not be created", fileName.c_str());
 
 		BS_ASSERT2(false, "Failed to create pixel shader, file not found");
@@ -255,19 +266,15 @@ std::shared_ptr<bsPixelShader> bsShaderManager::getPixelShader(const std::string
 		return nullptr;
 	}
 
-	//See if the shader already exists
-	auto val = mPixelShaders.find(filePath);
-	if (val != mPixelShaders.end())
-	{
-		return val->second;
-	}
-
 	//Create the shader from the loaded blob.
-	return const_cast<bsShaderManager*>(this)->createPixelShader(filePath);
+	return const_cast<bsShaderManager*>(this)->createPixelShader(fileName, filePath);
 }
 
-std::shared_ptr<bsPixelShader> bsShaderManager::createPixelShader(const std::string& fileName)
+std::shared_ptr<bsPixelShader> bsShaderManager::createPixelShader(const bsStringId& shaderName,
+	const std::string& fileName)
 {
+	bsMemoryTagScope memoryTag(bsMemoryTracker::TAG_RESOURCES);
+
 	//Load shader blob and create the shader.
 
 
@@ -307,20 +314,23 @@ std::shared_ptr<bsPixelShader> bsShaderManager::createPixelShader(const std::str
 	}
 
 	//Create the shader from the loaded blob.
-	return createPixelShaderFromBlob(blob, usingPrecompiledShader ? precompiledPath : fileName);
+	return createPixelShaderFromBlob(shaderName, blob,
+		usingPrecompiledShader ? precompiledPath : fileName);
 }
 
-std::shared_ptr<bsPixelShader> bsShaderManager::createPixelShaderFromBlob(ID3DBlob* blob,
-	const std::string& fileName)
+std::shared_ptr<bsPixelShader> bsShaderManager::createPixelShaderFromBlob(
+	const bsStringId& shaderName, ID3DBlob* blob, const std::string& fileName)
 {
+	bsRenderDevice& renderDevice = mDx11Renderer->getRenderDevice();
+
 	//Create shader
 	ID3D11PixelShader* pixelShader = nullptr;
-	if (FAILED(mDx11Renderer->getDevice()->CreatePixelShader(blob->GetBufferPointer(),
-		blob->GetBufferSize(), nullptr, &pixelShader)))
+	if (FAILED(renderDevice.createPixelShader(blob->GetBufferPointer(),
+		blob->GetBufferSize(), &pixelShader)))
 	{
 		if (pixelShader)
 		{
-			pixelShader->Release();
+			renderDevice.release(pixelShader);
 		}
 
 		std::string message("Failed to create pixel shader '");
@@ -331,21 +341,20 @@ std::shared_ptr<bsPixelShader> bsShaderManager::createPixelShaderFromBlob(ID3DBl
 		return nullptr;
 	}
 
-	auto ps = std::make_pair(fileName, std::make_shared<bsPixelShader>(pixelShader,
-		getUniqueShaderID()));
+	auto ps = std::make_pair(shaderName, std::make_shared<bsPixelShader>(pixelShader,
+		renderDevice, getUniqueShaderID()));
 
 #ifdef BS_DEBUG
 	//Set debug data in the D3D object.
 
 	std::string bufferName("PS ");
 	bufferName.append(fileName);
-	ps.second->mPixelShader->SetPrivateData(WKPDID_D3DDebugObjectName,
-		bufferName.size(), bufferName.c_str());
+	renderDevice.setDebugName(ps.second->mPixelShader, bufferName.c_str());
 #endif // BS_DEBUG
 
 	mPixelShaders.insert(ps);
 
-	bsLog::logf(bsLog::SEV_INFO, "Created pixel shader '%s'", fileName.c_str());
+	BS_LOG_INFO(RESOURCES, "Created pixel shader '%s'", fileName.c_str());
 	
 	return ps.second;
 }
@@ -1,7 +1,6 @@
 #pragma once
 
 
-#include <unordered_map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -12,13 +11,15 @@
 
 #include "bsVertexShader.h"
 #include "bsPixelShader.h"
+#include "bsFlatHashMap.h"
+#include "bsStringId.h"
 
 class bsFileSystem;
 class bsDx11Renderer;
 
 
-/*	Contains shaders used by the application, mapped with file path as key to allow for
-	fast fetching of already loaded shaders.
+/*	Contains shaders used by the application, mapped with the file name's ID as key to allow
+	for fast fetching of already loaded shaders without looking up their paths.
 */
 class bsShaderManager
 {
@@ -37,39 +38,42 @@ public:
 
 
 	//Get a shader, or create it if it isn't already loaded.
-	std::shared_ptr<bsVertexShader> getVertexShader(const std::string& fileName,
+	std::shared_ptr<bsVertexShader> getVertexShader(const bsStringId& fileName,
 		const D3D11_INPUT_ELEMENT_DESC* inputDescs, unsigned int inputDescCount) const;
 
 	//Get a shader, or create it if it isn't already loaded.
-	std::shared_ptr<bsPixelShader> getPixelShader(const std::string& fileName) const;
+	std::shared_ptr<bsPixelShader> getPixelShader(const bsStringId& fileName) const;
 
 
 private:
-	//Create/compile vertex shader
-	std::shared_ptr<bsVertexShader> createVertexShader(const std::string& fileName,
-		const D3D11_INPUT_ELEMENT_DESC* inputDescs, unsigned int inputDescCount);
+	//Create/compile vertex shader and add it to the map with shaderName as the key.
+	std::shared_ptr<bsVertexShader> createVertexShader(const bsStringId& shaderName,
+		const std::string& fileName, const D3D11_INPUT_ELEMENT_DESC* inputDescs,
+		unsigned int inputDescCount);
 
 	bool compileVertexShaderBlobFromFile(ID3DBlob** blobOut, const std::string& fileName,
 		const D3D11_INPUT_ELEMENT_DESC* inputDescs, unsigned int inputDescCount);
 
-	/*	Create vertex shader from a shader blob.
-		The fileName parameter is only used for debugging and logging.
+	/*	Create vertex shader from a shader blob and add it to the map with shaderName as
+		the key. The fileName parameter is only used for debugging and logging.
 	*/
-	std::shared_ptr<bsVertexShader> createVertexShaderFromBlob(ID3DBlob* blob,
-		const std::string& fileName, const D3D11_INPUT_ELEMENT_DESC* inputDescs,
-		unsigned int inputDescCount);
+	std::shared_ptr<bsVertexShader> createVertexShaderFromBlob(
+		const bsStringId& shaderName, ID3DBlob* blob, const std::string& fileName,
+		const D3D11_INPUT_ELEMENT_DESC* inputDescs, unsigned int inputDescCount);
 
 
 
-	std::shared_ptr<bsPixelShader> createPixelShader(const std::string& fileName);
+	//Create/compile pixel shader and add it to the map with shaderName as the key.
+	std::shared_ptr<bsPixelShader> createPixelShader(const bsStringId& shaderName,
+		const std::string& fileName);
 
 	bool compilePixelShaderBlobFromFile(ID3DBlob** blobOut, const std::string& fileName);
 
-	/*	Create pixel shader from a shader blob.
-		The fileName parameter is only used for debugging and logging.
+	/*	Create pixel shader from a shader blob and add it to the map with shaderName as
+		the key. The fileName parameter is only used for debugging and logging.
 	*/
-	std::shared_ptr<bsPixelShader> createPixelShaderFromBlob(ID3DBlob* blob,
-		const std::string& fileName);
+	std::shared_ptr<bsPixelShader> createPixelShaderFromBlob(const bsStringId& shaderName,
+		ID3DBlob* blob, const std::string& fileName);
 
 
 	/*	Returns the path for the precompiled version of the shader specified by fileName.
@@ -98,8 +102,10 @@ private:
 
 
 	//Mappings of file names to shaders.
-	std::unordered_map<std::string, std::shared_ptr<bsVertexShader>>	mVertexShaders;
-	std::unordered_map<std::string, std::shared_ptr<bsPixelShader>>		mPixelShaders;
+	bsFlatHashMap<bsStringId, std::shared_ptr<bsVertexShader>, bsStringId::Hasher>
+		mVertexShaders;
+	bsFlatHashMap<bsStringId, std::shared_ptr<bsPixelShader>, bsStringId::Hasher>
+		mPixelShaders;
 
 	const bsFileSystem&	mFileSystem;
 	bsDx11Renderer*		mDx11Renderer;
@@ -0,0 +1,67 @@
+#include "StdAfx.h"
+
+#include "bsStringId.h"
+
+#include <string>
+#include <unordered_map>
+
+#include <tbb/spin_mutex.h>
+
+#include "bsAssert.h"
+#include "bsLog.h"
+
+
+namespace
+{
+/*	Maps hashes to interned strings. Created on first use, and intentionally never destroyed
+	so that IDs stay valid during static destruction.
+	The mutex needs no dynamic initialization, which makes it safe to use from IDs
+	constructed during static initialization.
+*/
+typedef std::unordered_map<unsigned long long, std::string> StringTable;
+
+StringTable*	gStringTable = nullptr;
+tbb::spin_mutex	gStringTableMutex;
+
+//Must be called with gStringTableMutex held.
+const char* internLocked(unsigned long long hash, const bsStringView& string)
+{
+	if (!gStringTable)
+	{
+		gStringTable = new StringTable();
+	}
+
+	auto itr = gStringTable->find(hash);
+	if (itr == gStringTable->end())
+	{
+		itr = gStringTable->insert(std::make_pair(hash, string.toString())).first;
+	}
+#ifdef BS_DEBUG
+	else if (bsStringView(itr->second) != string)
+	{
+		const std::string newString(string.toString());
+		bsLog::logf(bsLog::SEV_CRICICAL, "String ID collision: '%s' and '%s' both hash to"
+			" %016llX", itr->second.c_str(), newString.c_str(), hash);
+
+		BS_ASSERT2(false, "String ID collision");
+	}
+#endif
+
+	//The table never erases, and strings in an unordered_map's nodes are never moved.
+	return itr->second.c_str();
+}
+}
+
+
+void bsStringIdDetail::registerLiteral(unsigned long long hash, const char* literal)
+{
+	tbb::spin_mutex::scoped_lock lock(gStringTableMutex);
+	internLocked(hash, literal);
+}
+
+bsStringId::bsStringId(const bsStringView& string)
+	: mHash(string.hash())
+{
+	tbb::spin_mutex::scoped_lock lock(gStringTableMutex);
+	mString = internLocked(mHash, string);
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <string.h>
+
+#include "bsAssert.h"
+#include "bsHash.h"
+#include "bsStringView.h"
+
+
+namespace bsStringIdDetail
+{
+/*	FNV-1a of the first Length characters of a string, unrolled with one instantiation per
+	character. When called with a string literal, the compiler folds the whole thing into a
+	constant, giving compile time hashing without constexpr.
+	Must produce the same result as bsHash::fnv1a64.
+*/
+template <size_t Length>
+struct UnrolledFnv1a64
+{
+	static __forceinline unsigned long long hash(const char* string)
+	{
+		return (UnrolledFnv1a64<Length - 1>::hash(string)
+			^ static_cast<unsigned char>(string[Length - 1])) * 1099511628211ULL;
+	}
+};
+
+template <>
+struct UnrolledFnv1a64<0>
+{
+	static __forceinline unsigned long long hash(const char*)
+	{
+		return 14695981039346656037ULL;
+	}
+};
+
+//Adds a literal to the intern table in debug builds, to detect collisions.
+void registerLiteral(unsigned long long hash, const char* literal);
+}
+
+
+/*	Compact identifier for a string, used to key resources, shaders, materials and
+	entities by name without storing, copying or comparing strings.
+
+	The ID is the bsHash::fnv1a64 of the string, the same hash the file system and pack
+	files use for file names. Two IDs are equal if their hashes are equal.
+
+	IDs can be created in two ways:
+	- From a string literal, like bsStringId("teapot.bsm"). The hash is computed at compile
+	  time and the ID refers to the literal itself. This constructor is explicit, so that
+	  every place an ID refers to an array is visible, and it does not accept arrays
+	  which are not const.
+	- From any other string with the explicit constructor. The string is interned in a
+	  global table which owns a copy of it, so the ID's string stays valid forever.
+
+	In debug builds, every string which ends up with an ID is checked against the intern
+	table, and an assert fires if two different strings hash to the same ID.
+*/
+class bsStringId
+{
+public:
+	//The ID of the empty string.
+	bsStringId()
+		: mHash(bsStringIdDetail::UnrolledFnv1a64<0>::hash(""))
+		, mString("")
+	{}
+
+	/*	Creates an ID from a string literal. Only use this with string literals, other
+		character arrays must use the bsStringView constructor, since the array's size is
+		used as the string's length, and the ID refers to the array.
+	*/
+	template <size_t Size>
+	explicit bsStringId(const char (&literal)[Size])
+		: mHash(bsStringIdDetail::UnrolledFnv1a64<Size - 1>::hash(literal))
+		, mString(literal)
+	{
+#ifdef BS_DEBUG
+		BS_ASSERT2(strlen(literal) == Size - 1, "bsStringId created from a character array"
+			" which is not a string literal");
+		bsStringIdDetail::registerLiteral(mHash, literal);
+#endif
+	}
+
+	//Creates an ID from any string, interning it. Thread safe.
+	explicit bsStringId(const bsStringView& string);
+
+
+	inline unsigned long long getHash() const
+	{
+		return mHash;
+	}
+
+	/*	The string this ID was created from. Null terminated and valid for the lifetime of
+		the application.
+	*/
+	inline const char* c_str() const
+	{
+		return mString;
+	}
+
+
+	inline bool operator==(const bsStringId& other) const
+	{
+		return mHash == other.mHash;
+	}
+
+	inline bool operator!=(const bsStringId& other) const
+	{
+		return mHash != other.mHash;
+	}
+
+	inline bool operator<(const bsStringId& other) const
+	{
+		return mHash < other.mHash;
+	}
+
+
+	/*	Hash function object for unordered containers keyed on IDs. The ID already is a
+		hash, so no further hashing is done.
+	*/
+	struct Hasher
+	{
+		inline size_t operator()(const bsStringId& id) const
+		{
+			return static_cast<size_t>(id.getHash() ^ (id.getHash() >> 32));
+		}
+	};
+
+private:
+	/*	Not defined. Chosen over the literal constructor for arrays which are not const,
+		so that creating an ID from a buffer fails to compile instead of referring to it.
+	*/
+	template <size_t Size>
+	explicit bsStringId(char (&buffer)[Size]);
+
+
+	unsigned long long	mHash;
+	const char*			mString;
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <string.h>
+
+#include <string>
+
+#include "bsHash.h"
+
+
+/*	Non-owning reference to a range of characters.
+
+	The referenced characters must outlive the view. A view is not guaranteed to be null
+	terminated, unless whatever created it says so.
+
+	Can be constructed implicitly from null terminated strings and std::strings, so
+	functions taking a view can be called with either without allocating.
+*/
+class bsStringView
+{
+public:
+	bsStringView()
+		: mData("")
+		, mLength(0)
+	{}
+
+	bsStringView(const char* string)
+		: mData(string)
+		, mLength(strlen(string))
+	{}
+
+	bsStringView(const char* string, size_t length)
+		: mData(string)
+		, mLength(length)
+	{}
+
+	bsStringView(const std::string& string)
+		: mData(string.c_str())
+		, mLength(string.length())
+	{}
+
+
+	inline const char* data() const
+	{
+		return mData;
+	}
+
+	inline size_t length() const
+	{
+		return mLength;
+	}
+
+	inline bool empty() const
+	{
+		return mLength == 0;
+	}
+
+	inline char operator[](size_t index) const
+	{
+		return mData[index];
+	}
+
+	inline const char* begin() const
+	{
+		return mData;
+	}
+
+	inline const char* end() const
+	{
+		return mData + mLength;
+	}
+
+	//Copies the referenced characters into a new string.
+	inline std::string toString() const
+	{
+		return std::string(mData, mLength);
+	}
+
+	//bsHash::fnv1a64 of the referenced characters.
+	inline unsigned long long hash() const
+	{
+		return bsHash::fnv1a64(mData, mLength);
+	}
+
+
+	inline bool operator==(const bsStringView& other) const
+	{
+		return mLength == other.mLength && memcmp(mData, other.mData, mLength) == 0;
+	}
+
+	inline bool operator!=(const bsStringView& other) const
+	{
+		return !(*this == other);
+	}
+
+
+	//Hash function object for hash maps keyed on views.
+	struct Hasher
+	{
+		inline size_t operator()(const bsStringView& string) const
+		{
+			return static_cast<size_t>(string.hash());
+		}
+	};
+
+private:
+	const char*	mData;
+	size_t		mLength;
+};
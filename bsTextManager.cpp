@@ -7,8 +7,9 @@
 #include "bsAssert.h"
 #include "bsScrollingText2D.h"
 #include "bsFrameStatistics.h"
-#include "bsTimer.h"
 #include "bsStringUtils.h"
+#include "bsMemoryTracker.h"
+#include "bsProfiler.h"
 
 
 bsTextManager::bsTextManager(bsDx11Renderer* dx11Renderer)
@@ -33,7 +34,7 @@ bsTextManager::~bsTextManager()
 			const std::wstring& text = (*itr)->getText();
 			std::string charText(bsStringUtils::wideToChar(text));
 
-			bsLog::logf(bsLog::SEV_WARNING, "A bsText2D has %i remaining references when"
+			BS_LOG_WARNING(RESOURCES, "A bsText2D has %i remaining references when"
 				" bsTextManager is shutting down. Text: %s", useCount - 1, charText.c_str());
 		}
 	}
@@ -51,6 +52,8 @@ bsTextManager::~bsTextManager()
 std::shared_ptr<bsText2D> bsTextManager::createText2D(const std::wstring& text,
 	const std::wstring& font /*= L"Consolas"*/)
 {
+	bsMemoryTagScope memoryTag(bsMemoryTracker::TAG_TEXT);
+
 	IFW1FontWrapper* fontWrapper;
 	
 	HRESULT hres = mFw1Factory->CreateFontWrapper(mDx11Renderer->getDevice(), font.c_str(),
@@ -68,6 +71,8 @@ std::shared_ptr<bsText2D> bsTextManager::createText2D(const std::wstring& text,
 std::shared_ptr<bsScrollingText2D> bsTextManager::createScrollingText2D(float fadeDelay,
 	unsigned int maxLineCount, const std::wstring& font /*= L"Consolas"*/)
 {
+	bsMemoryTagScope memoryTag(bsMemoryTracker::TAG_TEXT);
+
 	std::shared_ptr<bsScrollingText2D> textBox(new bsScrollingText2D(fadeDelay, maxLineCount));
 	textBox->mText = createText2D(L"", font);
 
@@ -94,16 +99,14 @@ void bsTextManager::destroyUnusedTexts()
 
 void bsTextManager::drawAllTexts(bsFrameStatistics& frameStatistics)
 {
-	bsTimer timer;
-	float preDraw = timer.getTimeMilliSeconds();
+	frameStatistics.renderingInfo.textDuration = 0.0f;
+	BS_PROFILE_SCOPE_STAT("Draw 2D texts", frameStatistics.renderingInfo.textDuration);
 
 	std::for_each(mTexts.begin(), mTexts.end(),
 		[](const std::shared_ptr<bsText2D>& textObject)
 	{
 		textObject->draw();
 	});
-
-	frameStatistics.renderingInfo.textDuration = timer.getTimeMilliSeconds() - preDraw;
 }
 
 void bsTextManager::updateTexts(float deltaTime)
@@ -3,6 +3,7 @@
 #include "bsTexture2D.h"
 #include "bsAssert.h"
 #include "bsFixedSizeString.h"
+#include "bsRenderDevice.h"
 
 
 bsTexture2D::bsTexture2D(ID3D11ShaderResourceView* texture, ID3D11Device& device,
@@ -57,12 +58,12 @@ bsTexture2D::~bsTexture2D()
 	}
 }
 
-void bsTexture2D::apply(ID3D11DeviceContext& deviceContext, unsigned int slot)
+void bsTexture2D::apply(bsRenderDevice& renderDevice, unsigned int slot)
 {
 	if (mLoadingCompleted)
 	{
-		deviceContext.PSSetShaderResources(slot, 1, &mShaderResourceView);
-		deviceContext.PSSetSamplers(slot, 1, &mSamplerState);
+		renderDevice.setPixelShaderResources(slot, 1, &mShaderResourceView);
+		renderDevice.setPixelSamplers(slot, 1, &mSamplerState);
 	}
 }
 
@@ -75,3 +76,14 @@ void bsTexture2D::loadingCompleted(ID3D11ShaderResourceView* texture, bool succe
 		InterlockedIncrementRelease(&mLoadingCompleted);
 	}
 }
+
+void bsTexture2D::reloadCompleted(ID3D11ShaderResourceView* texture)
+{
+	BS_ASSERT2(texture, "Invalid texture");
+	BS_ASSERT2(hasLoadedFromFile(), "Reloading a texture which has not finished loading");
+
+	ID3D11ShaderResourceView* previousTexture = mShaderResourceView;
+	mShaderResourceView = texture;
+
+	previousTexture->Release();
+}
@@ -2,6 +2,7 @@
 
 #include "D3D11.h"
 
+class bsRenderDevice;
 
 class bsTexture2D
 {
@@ -11,7 +12,7 @@ public:
 
 	~bsTexture2D();
 
-	void apply(ID3D11DeviceContext& deviceContext, unsigned int slot);
+	void apply(bsRenderDevice& renderDevice, unsigned int slot);
 
 	inline ID3D11ShaderResourceView* getShaderResourceView() const
 	{
@@ -28,6 +29,21 @@ public:
 	*/
 	void loadingCompleted(ID3D11ShaderResourceView* texture, bool success);
 
+	/*	Replaces the texture with a reloaded version and releases the previous one.
+		Must be called from the thread rendering the texture, and only after the initial
+		loading has completed (see hasLoadedFromFile).
+	*/
+	void reloadCompleted(ID3D11ShaderResourceView* texture);
+
+	/*	Returns true once the texture has been loaded from a file, meaning it is no longer
+		using a placeholder.
+	*/
+	inline bool hasLoadedFromFile() const
+	{
+		//Starts at 1 from the constructor, incremented once loading completes.
+		return mLoadingCompleted > 1;
+	}
+
 
 private:
 	ID3D11ShaderResourceView*	mShaderResourceView;
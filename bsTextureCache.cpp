@@ -7,10 +7,11 @@
 #include "bsLog.h"
 #include "bsFixedSizeString.h"
 #include "bsFileSystem.h"
+#include "bsMemoryTracker.h"
 
 
 //Name for the default pink/yellow checker texture.
-const char* bsTextureCacheDefaultTextureName = "__internal_default_pink_yellow_checker";
+const bsStringId bsTextureCacheDefaultTextureName("__internal_default_pink_yellow_checker");
 
 
 
@@ -21,7 +22,7 @@ class bsTextureFileLoadFinishedCallback
 {
 public:
 	bsTextureFileLoadFinishedCallback(const std::shared_ptr<bsTexture2D>& texture,
-		const std::string& textureName, ID3D11Device& device)
+		const bsStringId& textureName, ID3D11Device& device)
 		: mTexture(texture)
 		, mTextureName(textureName)
 		, mDevice(device)
@@ -43,7 +44,7 @@ public:
 
 		mTexture->loadingCompleted(shaderResourceView, SUCCEEDED(hres));
 
-		bsLog::logf(bsLog::SEV_INFO, "Loading of texture '%s' finished, success: %u",
+		BS_LOG_DEBUG(RESOURCES, "Loading of texture '%s' finished, success: %u",
 			fileLoader.getFileName().c_str(),
 			fileLoader.getCurrentLoadState() == bsFileLoader::SUCCEEDED);
 
@@ -59,12 +60,12 @@ public:
 
 private:
 	std::shared_ptr<bsTexture2D> mTexture;
-	std::string				mTextureName;
+	bsStringId				mTextureName;
 	ID3D11Device&			mDevice;
 };
 
 
-bsTextureCache::bsTextureCache(ID3D11Device& device, const bsFileSystem& fileSystem,
+bsTextureCache::bsTextureCache(ID3D11Device& device, bsFileSystem& fileSystem,
 	bsFileIoManager& fileIoManager)
 	: mFileSystem(fileSystem)
 	, mFileIoManager(fileIoManager)
@@ -109,18 +110,23 @@ bsTextureCache::bsTextureCache(ID3D11Device& device, const bsFileSystem& fileSys
 		std::make_shared<bsTexture2D>(shaderResourceView, mDevice, getNewTextureId(),
 		D3D11_FILTER_MIN_MAG_MIP_POINT));
 
-	mTextures.insert(std::move(StringTexturePair(bsTextureCacheDefaultTextureName, defaultTexture)));
+	mTextures.insert(std::move(IdTexturePair(bsTextureCacheDefaultTextureName, defaultTexture)));
+
+	mChangeListenerId = mFileSystem.addChangeListener(std::bind(&bsTextureCache::fileChanged,
+		this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
 }
 
 bsTextureCache::~bsTextureCache()
 {
+	mFileSystem.removeChangeListener(mChangeListenerId);
+
 #ifdef BS_DEBUG
 	//Warn if there are external references to any textures.
 	for (auto itr = mTextures.begin(), end = mTextures.end(); itr != end; ++itr)
 	{
 		if (!itr->second.unique())
 		{
-			bsLog::logf(bsLog::SEV_WARNING, "All references to texture '%s' have not"
+			BS_LOG_WARNING(RESOURCES, "All references to texture '%s' have not"
 				" been released when bsTextureCache is being destroyed (%u external refs)",
 				itr->first.c_str(), itr->second.use_count() - 1);
 		}
@@ -130,7 +136,7 @@ bsTextureCache::~bsTextureCache()
 	mTextures.clear();
 }
 
-std::shared_ptr<bsTexture2D> bsTextureCache::getTexture(const char* fileName)
+std::shared_ptr<bsTexture2D> bsTextureCache::getTexture(const bsStringId& fileName)
 {
 	const auto findResult = mTextures.find(fileName);
 	if (findResult != std::end(mTextures))
@@ -140,12 +146,14 @@ std::shared_ptr<bsTexture2D> bsTextureCache::getTexture(const char* fileName)
 	}
 
 	//Not found in cache, load it asynchronously.
+	bsMemoryTagScope memoryTag(bsMemoryTracker::TAG_TEXTURE);
 
-	const std::string fullFilePath(mFileSystem.getPathFromFilename(fileName));
+	const std::string fullFilePath(mFileSystem.getPathFromFilename(fileName.c_str()));
 	
 	if (fullFilePath.empty())
 	{
-		bsLog::logf(bsLog::SEV_ERROR, "Failed to find path for file '%s'", fileName);
+		BS_LOG_ERROR(RESOURCES, "Failed to find path for file '%s'",
+			fileName.c_str());
 
 		BS_ASSERT2(false, "Failed to find texture file");
 
@@ -158,7 +166,7 @@ std::shared_ptr<bsTexture2D> bsTextureCache::getTexture(const char* fileName)
 		mTextures[bsTextureCacheDefaultTextureName]->getShaderResourceView(), mDevice,
 		getNewTextureId())));
 
-	mTextures.insert(StringTexturePair(fileName, texture));
+	mTextures.insert(IdTexturePair(fileName, texture));
 
 	mFileIoManager.addAsynchronousLoadRequest(fullFilePath,
 		bsTextureFileLoadFinishedCallback(texture, fileName, mDevice));
@@ -166,7 +174,7 @@ std::shared_ptr<bsTexture2D> bsTextureCache::getTexture(const char* fileName)
 	return texture;
 }
 
-std::shared_ptr<bsTexture2D> bsTextureCache::getTextureBlocking(const char* fileName)
+std::shared_ptr<bsTexture2D> bsTextureCache::getTextureBlocking(const bsStringId& fileName)
 {
 	const auto findResult = mTextures.find(fileName);
 	if (findResult != std::end(mTextures))
@@ -176,12 +184,14 @@ std::shared_ptr<bsTexture2D> bsTextureCache::getTextureBlocking(const char* file
 	}
 
 	//Not found in cache, load it synchronously.
+	bsMemoryTagScope memoryTag(bsMemoryTracker::TAG_TEXTURE);
 
-	const std::string fullFilePath(mFileSystem.getPathFromFilename(fileName));
+	const std::string fullFilePath(mFileSystem.getPathFromFilename(fileName.c_str()));
 
 	if (fullFilePath.empty())
 	{
-		bsLog::logf(bsLog::SEV_ERROR, "Failed to find path for file '%s'", fileName);
+		BS_LOG_ERROR(RESOURCES, "Failed to find path for file '%s'",
+			fileName.c_str());
 
 		BS_ASSERT2(false, "Failed to find texture file");
 
@@ -194,7 +204,7 @@ std::shared_ptr<bsTexture2D> bsTextureCache::getTextureBlocking(const char* file
 		mTextures[bsTextureCacheDefaultTextureName]->getShaderResourceView(), mDevice,
 		getNewTextureId())));
 
-	mTextures.insert(StringTexturePair(fileName, texture));
+	mTextures.insert(IdTexturePair(fileName, texture));
 
 	//Do the same as with async loading, but call loadBlocking instead.
 	bsTextureFileLoadFinishedCallback finishedCallback(texture, fileName, mDevice);
@@ -203,6 +213,62 @@ std::shared_ptr<bsTexture2D> bsTextureCache::getTextureBlocking(const char* file
 	return texture;
 }
 
+void bsTextureCache::fileChanged(const char* fileName, const char* path,
+	bsFileSystem::ChangeType changeType)
+{
+	if (changeType == bsFileSystem::FILE_REMOVED)
+	{
+		//Keep using the previously loaded texture.
+		return;
+	}
+
+	const auto findResult = mTextures.find(bsStringId(fileName));
+	if (findResult == std::end(mTextures))
+	{
+		return;
+	}
+
+	bsTexture2D& texture = *findResult->second;
+	if (!texture.hasLoadedFromFile())
+	{
+		//Still loading, the pending load may already contain the changes.
+		return;
+	}
+
+	/*	Reloading is done synchronously since the texture is replaced on this thread.
+		The changed file is loose, so a pack containing the same name must not be read.
+	*/
+	const bsFileLoader fileLoader(mFileIoManager.loadBlocking(path, false));
+	if (fileLoader.getCurrentLoadState() != bsFileLoader::SUCCEEDED)
+	{
+		BS_LOG_ERROR(RESOURCES, "Failed to reload texture '%s'", fileName);
+
+		return;
+	}
+
+	ID3D11ShaderResourceView* shaderResourceView = nullptr;
+	const HRESULT hres = D3DX11CreateShaderResourceViewFromMemory(&mDevice,
+		fileLoader.getLoadedData(), fileLoader.getLoadedDataSize(), nullptr, nullptr,
+		&shaderResourceView, nullptr);
+	if (FAILED(hres))
+	{
+		BS_LOG_ERROR(RESOURCES, "Failed to create texture when reloading '%s'",
+			fileName);
+
+		return;
+	}
+
+#ifdef BS_DEBUG
+	bsString256 debugString(fileName);
+	shaderResourceView->SetPrivateData(WKPDID_D3DDebugObjectName,
+		debugString.size(), debugString.c_str());
+#endif
+
+	texture.reloadCompleted(shaderResourceView);
+
+	BS_LOG_INFO(RESOURCES, "Reloaded texture '%s'", fileName);
+}
+
 std::shared_ptr<bsTexture2D> bsTextureCache::getDefaultTexture() const
 {
 	BS_ASSERT2(mTextures.find(bsTextureCacheDefaultTextureName) != std::end(mTextures),
@@ -1,11 +1,13 @@
 #pragma once
 
-#include <unordered_map>
 #include <string>
 #include <memory>
 
+#include "bsFileSystem.h"
+#include "bsFlatHashMap.h"
+#include "bsStringId.h"
+
 class bsTexture2D;
-class bsFileSystem;
 class bsFileIoManager;
 class bsFileLoader;
 class bsDx11Renderer;
@@ -15,28 +17,37 @@ class bsTextureFileLoadFinishedCallback;
 class bsTextureCache
 {
 public:
-	bsTextureCache(ID3D11Device& device, const bsFileSystem& fileSystem,
+	/*	The texture cache registers itself as a change listener with the file system, and
+		reloads textures in place when their files are modified.
+	*/
+	bsTextureCache(ID3D11Device& device, bsFileSystem& fileSystem,
 		bsFileIoManager& fileIoManager);
 
 	~bsTextureCache();
 
 
-	std::shared_ptr<bsTexture2D> getTexture(const char* fileName);
+	std::shared_ptr<bsTexture2D> getTexture(const bsStringId& fileName);
 
-	std::shared_ptr<bsTexture2D> getTextureBlocking(const char* fileName);
+	std::shared_ptr<bsTexture2D> getTextureBlocking(const bsStringId& fileName);
 	
 	std::shared_ptr<bsTexture2D> getDefaultTexture() const;
 
 private:
+	/*	Called by the file system when a file has changed. Reloads the texture if it has
+		been loaded from that file.
+	*/
+	void fileChanged(const char* fileName, const char* path,
+		bsFileSystem::ChangeType changeType);
+
 	//Non-copyable.
 	bsTextureCache(const bsTextureCache&);
 	bsTextureCache& operator=(const bsTextureCache&);
 
 
-	typedef std::pair<std::string, std::shared_ptr<bsTexture2D>> StringTexturePair;
+	typedef std::pair<bsStringId, std::shared_ptr<bsTexture2D>> IdTexturePair;
 
 	//Mapping of file name to texture resource.
-	std::unordered_map<std::string, std::shared_ptr<bsTexture2D>> mTextures;
+	bsFlatHashMap<bsStringId, std::shared_ptr<bsTexture2D>, bsStringId::Hasher> mTextures;
 
 
 	/*	Used for giving new textures unique IDs.
@@ -47,7 +58,8 @@ private:
 	}
 
 
-	const bsFileSystem&	mFileSystem;
+	bsFileSystem&		mFileSystem;
+	unsigned int		mChangeListenerId;
 	bsFileIoManager&	mFileIoManager;
 	ID3D11Device&		mDevice;
 
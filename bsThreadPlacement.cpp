@@ -0,0 +1,188 @@
+#include "StdAfx.h"
+
+#include "bsThreadPlacement.h"
+
+#include "bsAssert.h"
+
+
+bsThreadPlacement::bsThreadPlacement(const bsCpuTopology& topology, Policy policy)
+	: mTopology(topology)
+	, mPolicy(policy)
+{
+	//Without any known cores there is nothing to place threads on.
+	if (mTopology.getCoreCount() == 0)
+	{
+		mPolicy = POLICY_NONE;
+	}
+}
+
+unsigned int bsThreadPlacement::getDefaultJobWorkerCount() const
+{
+	const unsigned int count = mPolicy == POLICY_NONE
+		? mTopology.logicalProcessorCount : mTopology.getCoreCount();
+
+	return count > 1 ? count - 1 : 0;
+}
+
+unsigned int bsThreadPlacement::getDefaultPhysicsThreadCount() const
+{
+	//The thread stepping the world works too, so one less than the processors used.
+	return getDefaultJobWorkerCount();
+}
+
+ULONG_PTR bsThreadPlacement::getAffinityMask(Role role, unsigned int index) const
+{
+	if (mPolicy == POLICY_NONE)
+	{
+		return 0;
+	}
+
+	const unsigned int coreCount = mTopology.getCoreCount();
+
+	switch (role)
+	{
+	case ROLE_MAIN:
+		return getCoreMask(0, 0);
+
+	case ROLE_JOB_WORKER:
+		return getCoreMask(index % coreCount, 0);
+
+	case ROLE_PHYSICS:
+		return getCoreMask(getPhysicsCoreIndex(index), 1);
+
+	case ROLE_BACKGROUND:
+		{
+			ULONG_PTR mask = 0;
+			if (mTopology.hasSmt())
+			{
+				for (unsigned int i = 0; i < coreCount; ++i)
+				{
+					const ULONG_PTR coreMask = mTopology.cores[i].processorMask;
+					mask |= coreMask & ~getHardwareThread(coreMask, 0);
+				}
+			}
+			else
+			{
+				for (unsigned int i = 1; i < coreCount; ++i)
+				{
+					mask |= mTopology.cores[i].processorMask;
+				}
+			}
+
+			//A single core without SMT has nowhere else to go.
+			return mask != 0 ? mask : mTopology.getAllProcessorsMask();
+		}
+
+	default:
+		BS_ASSERT(!"Unknown thread role");
+		return 0;
+	}
+}
+
+int bsThreadPlacement::getIdealProcessor(Role role, unsigned int index) const
+{
+	if (mPolicy == POLICY_NONE)
+	{
+		return -1;
+	}
+
+	ULONG_PTR mask = getAffinityMask(role, index);
+	if (mask == 0 && role == ROLE_PHYSICS)
+	{
+		//Not restricted, since the core has no hardware thread to spare, but prefers it.
+		mask = mTopology.cores[getPhysicsCoreIndex(index)].processorMask;
+	}
+
+	if (mask == 0)
+	{
+		return -1;
+	}
+
+	int processor = 0;
+	while (!(mask & (static_cast<ULONG_PTR>(1) << processor)))
+	{
+		++processor;
+	}
+
+	return processor;
+}
+
+bool bsThreadPlacement::apply(HANDLE thread, Role role, unsigned int index) const
+{
+	const ULONG_PTR mask = getAffinityMask(role, index);
+	if (mask != 0)
+	{
+		return SetThreadAffinityMask(thread, mask) != 0;
+	}
+
+	const int processor = getIdealProcessor(role, index);
+	if (processor < 0)
+	{
+		return true;
+	}
+
+	return SetThreadIdealProcessor(thread, processor) != static_cast<DWORD>(-1);
+}
+
+const char* bsThreadPlacement::getPolicyName(Policy policy)
+{
+	switch (policy)
+	{
+	case POLICY_NONE:
+		return "none";
+
+	case POLICY_CORE:
+		return "core";
+
+	case POLICY_PIN:
+		return "pin";
+
+	default:
+		return "unknown";
+	}
+}
+
+ULONG_PTR bsThreadPlacement::getHardwareThread(ULONG_PTR coreMask, unsigned int smtIndex)
+{
+	ULONG_PTR lowest = coreMask & (~coreMask + 1);
+	ULONG_PTR remaining = coreMask;
+
+	for (unsigned int i = 0; i < smtIndex; ++i)
+	{
+		remaining &= remaining - 1;
+		if (remaining == 0)
+		{
+			return lowest;
+		}
+	}
+
+	return remaining & (~remaining + 1);
+}
+
+ULONG_PTR bsThreadPlacement::getCoreMask(unsigned int coreIndex,
+	unsigned int smtIndex) const
+{
+	const ULONG_PTR coreMask = mTopology.cores[coreIndex].processorMask;
+
+	if (smtIndex == 0)
+	{
+		return mPolicy == POLICY_PIN ? getHardwareThread(coreMask, 0) : coreMask;
+	}
+
+	//Physics threads stay off the job worker's hardware thread. Without another one on
+	//the core, they are left unrestricted rather than sharing it.
+	const ULONG_PTR others = coreMask & ~getHardwareThread(coreMask, 0);
+	if (others == 0)
+	{
+		return 0;
+	}
+
+	return mPolicy == POLICY_PIN ? getHardwareThread(coreMask, smtIndex) : others;
+}
+
+unsigned int bsThreadPlacement::getPhysicsCoreIndex(unsigned int index) const
+{
+	const unsigned int coreCount = mTopology.getCoreCount();
+
+	return coreCount - 1 - index % coreCount;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <Windows.h>
+
+#include "bsCpuTopology.h"
+
+
+/*	Decides which processors the engine's threads run on, based on the CPU topology.
+
+	Without placement, the job workers and Havok's worker threads are each sized to the
+	number of logical processors, and the operating system is free to move any of them
+	around. With placement, the threads are spread over the physical cores like this:
+	- The main thread gets the first core.
+	- Job worker n gets core n, so the default of one worker per remaining core gives
+	  every worker a core of its own.
+	- Physics threads are placed from the last core backwards, starting with the
+	  simulation thread. On cores with SMT they get the core's second hardware thread,
+	  leaving the first one to the job worker on the same core. Cores without SMT
+	  belong to their job worker, so physics threads are only given the core as their
+	  ideal processor there, and may run anywhere.
+	- Background threads (file IO) may run on every second hardware thread, or on every
+	  core except the main thread's without SMT. They mostly wait for the disk, so they
+	  are never pinned.
+	Cores are ordered by NUMA node, so threads with neighbouring indices share a node.
+*/
+class bsThreadPlacement
+{
+public:
+	enum Policy
+	{
+		//Threads may run on any processor.
+		POLICY_NONE,
+		//Each thread is restricted to its physical core.
+		POLICY_CORE,
+		//Each thread is pinned to a single hardware thread.
+		POLICY_PIN
+	};
+
+	enum Role
+	{
+		ROLE_MAIN,
+		//Index is the job system's thread index, starting at 1.
+		ROLE_JOB_WORKER,
+		//Index 0 is the simulation thread, Havok's worker threads start at 1.
+		ROLE_PHYSICS,
+		ROLE_BACKGROUND
+	};
+
+
+	bsThreadPlacement(const bsCpuTopology& topology, Policy policy);
+
+	inline Policy getPolicy() const
+	{
+		return mPolicy;
+	}
+
+	inline const bsCpuTopology& getTopology() const
+	{
+		return mTopology;
+	}
+
+	/*	The number of job workers and Havok worker threads to start when not configured.
+		Without placement this is one less than the logical processors, like before
+		placement existed. With placement it is one less than the physical cores.
+	*/
+	unsigned int getDefaultJobWorkerCount() const;
+	unsigned int getDefaultPhysicsThreadCount() const;
+
+	/*	The processors a thread with the given role and index may run on, or 0 if it may
+		run anywhere.
+	*/
+	ULONG_PTR getAffinityMask(Role role, unsigned int index = 0) const;
+
+	/*	The lowest processor number in the role's affinity mask, for APIs which take an
+		ideal processor rather than a mask. Physics threads without a hardware thread of
+		their own get the lowest one of their core. Returns -1 without placement.
+	*/
+	int getIdealProcessor(Role role, unsigned int index = 0) const;
+
+	/*	Restricts a thread to its affinity mask, or sets its ideal processor if it may
+		run anywhere but still has one. Does nothing without placement.
+		Returns false if the operating system refused.
+	*/
+	bool apply(HANDLE thread, Role role, unsigned int index = 0) const;
+
+	//Name of a policy, for logging.
+	static const char* getPolicyName(Policy policy);
+
+private:
+	/*	The hardware thread of a core to use. 0 is the lowest one in the core's mask.
+		Falls back to the lowest one if the core has fewer hardware threads.
+	*/
+	static ULONG_PTR getHardwareThread(ULONG_PTR coreMask, unsigned int smtIndex);
+
+	/*	Mask for a thread which gets one core, narrowed to one hardware thread when
+		pinning. Returns 0 for smtIndex 1 if the core has a single hardware thread.
+	*/
+	ULONG_PTR getCoreMask(unsigned int coreIndex, unsigned int smtIndex) const;
+
+	//The core of a physics thread.
+	unsigned int getPhysicsCoreIndex(unsigned int index) const;
+
+
+	bsCpuTopology	mTopology;
+	Policy			mPolicy;
+};
@@ -37,6 +37,32 @@ public:
 		return (1e3f * (mEnd.QuadPart - mStart.QuadPart)) * mOneOverFrequency;
 	}
 
+	/*	Returns the current value of the performance counter.
+		Unlike getTimeMilliSeconds, this does not lose precision over time, so it is
+		suitable for timestamps which are compared much later.
+	*/
+	static inline long long getTicks()
+	{
+		LARGE_INTEGER ticks;
+		QueryPerformanceCounter(&ticks);
+		return ticks.QuadPart;
+	}
+
+	//Converts a difference between two getTicks values to microseconds.
+	static inline double ticksToMicroSeconds(long long ticks)
+	{
+		//The frequency is fixed at boot, so racing initializations store the same value.
+		static double microSecondsPerTick = 0.0;
+		if (microSecondsPerTick == 0.0)
+		{
+			LARGE_INTEGER frequency;
+			QueryPerformanceFrequency(&frequency);
+			microSecondsPerTick = 1e6 / static_cast<double>(frequency.QuadPart);
+		}
+
+		return ticks * microSecondsPerTick;
+	}
+
 private:
 	LARGE_INTEGER mStart;
 	mutable LARGE_INTEGER mEnd;
@@ -2,6 +2,8 @@
 
 #include <xnamath.h>
 
+#include "bsMemoryTracker.h"
+
 class bsEntity;
 
 
@@ -4,12 +4,12 @@
 inline void* bsTransform::operator new(size_t)
 {
 	//Need to use this to make sure SSE types are properly aligned.
-	return _aligned_malloc(sizeof(bsTransform), 16);
+	return bsMemoryTracker::allocate(sizeof(bsTransform), 16, bsMemoryTracker::TAG_SCENE);
 }
 
 inline void bsTransform::operator delete(void* p)
 {
-	_aligned_free(p);
+	bsMemoryTracker::deallocate(p);
 }
 
 inline const XMVECTOR& bsTransform::getPosition() const
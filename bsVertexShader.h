@@ -3,6 +3,8 @@
 
 #include <d3d11.h>
 
+#include "bsRenderDevice.h"
+
 struct ID3D11VertexShader;
 struct ID3D11InputLayout;
 
@@ -15,18 +17,20 @@ class bsVertexShader
 	friend class bsShaderManager;
 
 public:
+	//The shader and input layout are released through the device which created them.
 	bsVertexShader(ID3D11VertexShader* vertexShader, ID3D11InputLayout* inputLayout,
-		unsigned int id)
+		bsRenderDevice& renderDevice, unsigned int id)
 		: mVertexShader(vertexShader)
 		, mInputLayout(inputLayout)
+		, mRenderDevice(&renderDevice)
 		, mID(id)
 	{
 	}
 
 	~bsVertexShader()
 	{
-		mVertexShader->Release();
-		mInputLayout->Release();
+		mRenderDevice->release(mVertexShader);
+		mRenderDevice->release(mInputLayout);
 	}
 
 	inline ID3D11VertexShader* getD3dVertexShader() const
@@ -46,6 +50,7 @@ private:
 
 	ID3D11VertexShader*	mVertexShader;
 	ID3D11InputLayout*	mInputLayout;
+	bsRenderDevice*		mRenderDevice;
 	unsigned int		mID;
 	std::vector<D3D11_INPUT_ELEMENT_DESC>	mInputLayoutDescriptions;
 };
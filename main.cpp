@@ -4,21 +4,62 @@
 
 #include <windows.h>
 
+#include <stdlib.h>
+#include <sstream>
+#include <string>
+
 #include "Application.h"
 #include "bsTimer.h"
 #include "bsAssert.h"
 
 
-int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int showCmd)
+namespace
+{
+/*	Reads input recording and playback options from the command line:
+	-record <file>		Records the input of every frame to file.
+	-playback <file>	Drives the application from a recording, quitting when it ends.
+	-timestep <ms>		Advances the simulation by a fixed ms every frame.
+	Unknown options are ignored.
+*/
+void parseReplayInfo(const char* commandLine, ApplicationReplayInfo& replayInfo)
+{
+	std::istringstream stream(commandLine);
+	std::string option;
+	std::string value;
+
+	while (stream >> option >> value)
+	{
+		if (option == "-record")
+		{
+			replayInfo.recordFileName = value;
+		}
+		else if (option == "-playback")
+		{
+			replayInfo.playbackFileName = value;
+		}
+		else if (option == "-timestep")
+		{
+			replayInfo.fixedTimeStepMs = static_cast<float>(atof(value.c_str()));
+		}
+	}
+}
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR commandLine, int showCmd)
 {
 	VLDDisable();
 
 	const int windowWidth = 1280;
 	const int windowHeight = 720;
+
+	ApplicationReplayInfo replayInfo;
+	parseReplayInfo(commandLine, replayInfo);
 	
 	try
 	{
-		Application application(hInstance, showCmd, windowWidth, windowHeight);
+		Application application(hInstance, showCmd, windowWidth, windowHeight,
+			replayInfo);
 
 		bsTimer timer;
 		float startTime = 0.0f;
@@ -0,0 +1,275 @@
+/*	Command line tool for replaying a frame capture, see bsFrameCapture.h.
+
+	Usage: bsFrameReplay <capture file> [-iterations N] [-threads N] [-output file]
+
+	Feeds the captured snapshot through culling and batching repeatedly, measuring each
+	stage like bsFramePipelineBenchmark does and writing the results as JSON in the same
+	format. Replaying the same capture with two builds compares them on exactly the same
+	frame.
+	The results of every iteration are checked against what the frame produced when it
+	was captured, returning 1 if they differ.
+
+	Options:
+	-iterations N	Times every stage is measured. Default 100.
+	-threads N		Job system threads, including the main thread. Default: all.
+	-output file	Where the results are written. Default "frame_replay.json".
+
+	Captured components are replaced by placeholder addresses, see bsFrameCapture.
+
+	Build together with the engine's sources except main.cpp and Application.cpp, and
+	link the same libraries. No device or window is created.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <tbb/tbb_thread.h>
+
+#include "../bsFrameCapture.h"
+#include "../bsFrameSnapshot.h"
+#include "../bsJobSystem.h"
+#include "../bsRenderBatcher.h"
+#include "../bsTimer.h"
+
+
+namespace
+{
+struct Options
+{
+	std::string		captureFileName;
+	unsigned int	threadCount;
+	unsigned int	iterations;
+	std::string		outputFileName;
+};
+
+struct Result
+{
+	std::string		name;
+	unsigned int	entityCount;
+	unsigned int	outputCount;
+	double			minMs;
+	double			medianMs;
+	double			maxMs;
+};
+
+double elapsedMilliSeconds(long long startTicks)
+{
+	return bsTimer::ticksToMicroSeconds(bsTimer::getTicks() - startTicks) * 0.001;
+}
+
+Result summarize(const char* name, unsigned int entityCount, unsigned int outputCount,
+	std::vector<double>& samples)
+{
+	std::sort(samples.begin(), samples.end());
+
+	Result result;
+	result.name = name;
+	result.entityCount = entityCount;
+	result.outputCount = outputCount;
+	result.minMs = samples.front();
+	result.medianMs = samples[samples.size() / 2];
+	result.maxMs = samples.back();
+
+	printf("%-16s %8u entities: min %9.3f ms, median %9.3f ms, max %9.3f ms (%u)\n",
+		name, entityCount, result.minMs, result.medianMs, result.maxMs, outputCount);
+
+	return result;
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+	if (argc < 2)
+	{
+		return false;
+	}
+
+	options.captureFileName = argv[1];
+	options.threadCount = std::max(tbb::tbb_thread::hardware_concurrency(), 1u);
+	options.iterations = 100;
+	options.outputFileName = "frame_replay.json";
+
+	for (int i = 2; i + 1 < argc; i += 2)
+	{
+		const char* value = argv[i + 1];
+		const unsigned int number = strtoul(value, nullptr, 10);
+
+		if (strcmp(argv[i], "-threads") == 0)
+		{
+			options.threadCount = number;
+		}
+		else if (strcmp(argv[i], "-iterations") == 0)
+		{
+			options.iterations = number;
+		}
+		else if (strcmp(argv[i], "-output") == 0)
+		{
+			options.outputFileName = value;
+		}
+		else
+		{
+			printf("Unknown option '%s'\n", argv[i]);
+			return false;
+		}
+	}
+
+	return options.threadCount > 0 && options.iterations > 0;
+}
+
+//Prints a mismatch and returns false if the replayed value differs from the captured.
+bool check(const char* name, unsigned int captured, unsigned int replayed)
+{
+	if (captured == replayed)
+	{
+		return true;
+	}
+
+	printf("Replayed %s differs from the capture: %u, captured %u\n", name, replayed,
+		captured);
+
+	return false;
+}
+
+//Returns false if what batcher produced differs from what the capture recorded.
+bool checkResults(const bsFrameCaptureHeader& header, const bsRenderBatcher& batcher)
+{
+	bool identical = check("visible entity count", header.visibleEntityCount,
+		batcher.getBatchedEntityCount());
+	identical &= check("mesh batch count", header.meshBatchCount,
+		batcher.getMeshBatches().size());
+	identical &= check("line batch count", header.lineBatchCount,
+		batcher.getLineBatches().size());
+	identical &= check("point light count", header.pointLightCount,
+		batcher.getPointLights().size());
+	identical &= check("spot light count", header.spotLightCount,
+		batcher.getSpotLights().size());
+
+	return identical;
+}
+
+bool replay(const bsFrameCapture& capture, const Options& options,
+	bsJobSystem& jobSystem, std::vector<Result>& results)
+{
+	bsRenderBatcher batcher(jobSystem);
+
+	const bsFrustum frustum = capture.getFrustum();
+	const unsigned int entityCount = capture.getEntityCount();
+
+	std::vector<const bsEntitySnapshot*> visibleEntities(std::max(entityCount, 1u));
+	unsigned int visibleEntityCount = 0;
+
+	std::vector<double> cullSamples;
+	std::vector<double> batchSamples;
+	std::vector<double> cullAndBatchSamples;
+
+	bool identical = true;
+
+	for (unsigned int iteration = 0; iteration < options.iterations; ++iteration)
+	{
+		long long startTicks = bsTimer::getTicks();
+		visibleEntityCount = batcher.cull(capture.getEntities(), entityCount, frustum,
+			visibleEntities.data());
+		cullSamples.push_back(elapsedMilliSeconds(startTicks));
+
+		batcher.reset();
+		startTicks = bsTimer::getTicks();
+		batcher.batch(visibleEntities.data(), visibleEntityCount);
+		batchSamples.push_back(elapsedMilliSeconds(startTicks));
+
+		//The same path bsRenderQueue::startFrame takes.
+		startTicks = bsTimer::getTicks();
+		batcher.cullAndBatch(capture.getEntities(), entityCount, frustum);
+		cullAndBatchSamples.push_back(elapsedMilliSeconds(startTicks));
+
+		//Only report the first mismatch, later iterations would repeat it.
+		if (identical)
+		{
+			identical = checkResults(capture.getHeader(), batcher);
+		}
+	}
+
+	results.push_back(summarize("cull", entityCount, visibleEntityCount, cullSamples));
+	results.push_back(summarize("batch", entityCount,
+		batcher.getMeshBatches().size(), batchSamples));
+	results.push_back(summarize("cullAndBatch", entityCount,
+		batcher.getBatchedEntityCount(), cullAndBatchSamples));
+
+	return identical;
+}
+
+bool writeJson(const Options& options, const std::vector<Result>& results)
+{
+#pragma warning (disable : 4996)//warning C4996: 'fopen' was declared deprecated
+	FILE* file = fopen(options.outputFileName.c_str(), "w");
+#pragma warning (default : 4996)
+	if (!file)
+	{
+		return false;
+	}
+
+	//The capture file name is written as it is, it's not expected to need escaping.
+	fprintf(file, "{\n\t\"config\": {\"capture\": \"%s\", \"threads\": %u, "
+		"\"iterations\": %u},\n\t\"results\": [", options.captureFileName.c_str(),
+		options.threadCount, options.iterations);
+
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const Result& result = results[i];
+		fprintf(file, "%s\n\t\t{\"name\": \"%s\", \"entities\": %u, \"output\": %u, "
+			"\"minMs\": %.4f, \"medianMs\": %.4f, \"maxMs\": %.4f}", i ? "," : "",
+			result.name.c_str(), result.entityCount, result.outputCount, result.minMs,
+			result.medianMs, result.maxMs);
+	}
+	fprintf(file, "\n\t]\n}\n");
+
+	const bool success = ferror(file) == 0;
+	fclose(file);
+
+	return success;
+}
+}
+
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!parseOptions(argc, argv, options))
+	{
+		printf("Usage: %s <capture file> [-iterations N] [-threads N] [-output file]\n",
+			argv[0]);
+		return 1;
+	}
+
+	bsFrameCapture capture;
+	if (!capture.load(options.captureFileName))
+	{
+		printf("Failed to load frame capture '%s'\n", options.captureFileName.c_str());
+		return 1;
+	}
+
+	const bsFrameCaptureHeader& header = capture.getHeader();
+	printf("%u entities, %u visible when captured, %u threads, %u iterations\n",
+		header.entityCount, header.visibleEntityCount, options.threadCount,
+		options.iterations);
+
+	std::vector<Result> results;
+	bool identical;
+	{
+		bsJobSystem jobSystem(options.threadCount - 1);
+
+		identical = replay(capture, options, jobSystem, results);
+	}
+
+	if (!writeJson(options, results))
+	{
+		printf("Failed to write results to '%s'\n", options.outputFileName.c_str());
+		return 1;
+	}
+	printf("Results written to '%s'\n", options.outputFileName.c_str());
+
+	return identical ? 0 : 1;
+}
@@ -0,0 +1,271 @@
+/*	Command line tool for converting binary logs (written with bsLog::BINARY_OUTPUT) to text.
+
+	Usage: bsLogDecoder <binary log file> [output text file]
+
+	Messages are written to standard output if no output file is specified. The output is
+	identical to what bsLog would have written with the same flags in text mode.
+
+	Build together with bsLogFormat.cpp, with BS_LOG_FORMAT_EXTERNAL defined.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "../bsLog.h"
+#include "../bsLogFormat.h"
+
+
+namespace
+{
+//Must match bsLog::mSeverityStrings.
+const char* kSeverityStrings[] =
+{
+	"Debug   ",
+	"Info    ",
+	"Warning ",
+	"Error   ",
+	"Critical",
+};
+
+const unsigned int kSeverityCount = sizeof(kSeverityStrings) / sizeof(kSeverityStrings[0]);
+
+//Must match bsLog::mChannelStrings.
+const char* kChannelStrings[] =
+{
+	"",
+	"Render: ",
+	"IO: ",
+	"Physics: ",
+	"Resources: ",
+};
+
+const unsigned int kChannelCount = sizeof(kChannelStrings) / sizeof(kChannelStrings[0]);
+
+bool readFile(const char* fileName, std::vector<char>& data)
+{
+#pragma warning (disable : 4996)//warning C4996: 'fopen' was declared deprecated
+	FILE* file = fopen(fileName, "rb");
+#pragma warning (default : 4996)
+	if (!file)
+	{
+		fprintf(stderr, "Failed to open '%s'\n", fileName);
+
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	const long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	data.resize(size);
+	const bool success = size == 0 || fread(&data[0], 1, size, file) == (size_t)size;
+	fclose(file);
+
+	if (!success)
+	{
+		fprintf(stderr, "Failed to read '%s'\n", fileName);
+	}
+
+	return success;
+}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("Usage: %s <binary log file> [output text file]\n", argv[0]);
+
+		return 1;
+	}
+
+	std::vector<char> data;
+	if (!readFile(argv[1], data))
+	{
+		return 1;
+	}
+
+	if (data.size() < sizeof(bsLogFormat::BinaryLogHeader))
+	{
+		fprintf(stderr, "'%s' is too small to be a binary log\n", argv[1]);
+
+		return 1;
+	}
+
+	bsLogFormat::BinaryLogHeader header;
+	memcpy(&header, &data[0], sizeof(header));
+
+	if (memcmp(header.magic, "bslg", 4) != 0)
+	{
+		fprintf(stderr, "'%s' is not a binary log\n", argv[1]);
+
+		return 1;
+	}
+
+	if (header.version != bsLogFormat::kBinaryLogVersion)
+	{
+		fprintf(stderr, "'%s' has version %u, expected version %u\n", argv[1],
+			header.version, bsLogFormat::kBinaryLogVersion);
+
+		return 1;
+	}
+
+	FILE* output = stdout;
+	if (argc > 2)
+	{
+#pragma warning (disable : 4996)//warning C4996: 'fopen' was declared deprecated
+		output = fopen(argv[2], "w");
+#pragma warning (default : 4996)
+		if (!output)
+		{
+			fprintf(stderr, "Failed to open '%s' for writing\n", argv[2]);
+
+			return 1;
+		}
+	}
+
+	//Format strings by ID.
+	std::vector<std::string> formats;
+
+	std::vector<char> text(bsLog::kTempBufferSize);
+	char prefix[64];
+
+	unsigned int messageCount = 0;
+	size_t offset = sizeof(header);
+	bool corrupt = false;
+
+	while (offset < data.size() && !corrupt)
+	{
+		const unsigned char recordType = data[offset];
+		++offset;
+
+		switch (recordType)
+		{
+		case bsLogFormat::RECORD_FORMAT:
+			{
+				bsLogFormat::BinaryFormatRecord record;
+				if (offset + sizeof(record) > data.size())
+				{
+					corrupt = true;
+					break;
+				}
+				memcpy(&record, &data[offset], sizeof(record));
+				offset += sizeof(record);
+
+				if (offset + record.length > data.size())
+				{
+					corrupt = true;
+					break;
+				}
+
+				if (record.formatId >= formats.size())
+				{
+					formats.resize(record.formatId + 1);
+				}
+				formats[record.formatId].assign(&data[offset], record.length);
+				offset += record.length;
+			}
+			break;
+
+		case bsLogFormat::RECORD_MESSAGE:
+			{
+				bsLogFormat::BinaryMessageRecord record;
+				if (offset + sizeof(record) > data.size())
+				{
+					corrupt = true;
+					break;
+				}
+				memcpy(&record, &data[offset], sizeof(record));
+				offset += sizeof(record);
+
+				if (offset + record.argumentsSize > data.size())
+				{
+					corrupt = true;
+					break;
+				}
+				//Formatted messages without arguments have none, and may end the file.
+				const char* arguments = data.data() + offset;
+				offset += record.argumentsSize;
+
+				const char* message = nullptr;
+				if (record.formatId == bsLogFormat::kPlainTextFormatId)
+				{
+					//Plain text always has its terminator.
+					if (record.argumentsSize == 0
+						|| arguments[record.argumentsSize - 1] != '\0')
+					{
+						corrupt = true;
+						break;
+					}
+					message = arguments;
+				}
+				else if (record.formatId < formats.size())
+				{
+					bsLogFormat::formatArguments(formats[record.formatId].c_str(), arguments,
+						record.argumentsSize, &text[0], text.size());
+					message = &text[0];
+				}
+				else
+				{
+					corrupt = true;
+					break;
+				}
+
+				FILETIME time;
+				time.dwLowDateTime = static_cast<DWORD>(record.time);
+				time.dwHighDateTime = static_cast<DWORD>(record.time >> 32);
+
+				bsLogFormat::formatPrefix(header.flags, record.severity,
+					record.severity < kSeverityCount ? kSeverityStrings[record.severity] : "",
+					record.threadId, time, prefix, sizeof(prefix));
+
+				fprintf(output, "%s%s%s\n", prefix,
+					record.channel < kChannelCount ? kChannelStrings[record.channel] : "",
+					message);
+				++messageCount;
+			}
+			break;
+
+		case bsLogFormat::RECORD_DROPPED:
+			{
+				bsLogFormat::BinaryDroppedRecord record;
+				if (offset + sizeof(record) > data.size())
+				{
+					corrupt = true;
+					break;
+				}
+				memcpy(&record, &data[offset], sizeof(record));
+				offset += sizeof(record);
+
+				fprintf(output, "[%u log messages dropped]\n", record.count);
+			}
+			break;
+
+		default:
+			corrupt = true;
+			break;
+		}
+	}
+
+	if (output != stdout)
+	{
+		fclose(output);
+	}
+
+	if (corrupt)
+	{
+		//A crash can leave a partially written record at the end.
+		fprintf(stderr, "Corrupt or truncated record at offset %u, decoded %u messages\n",
+			static_cast<unsigned int>(offset), messageCount);
+
+		return 1;
+	}
+
+	fprintf(stderr, "Decoded %u messages\n", messageCount);
+
+	return 0;
+}
@@ -0,0 +1,68 @@
+/*	Command line tool for creating pack files.
+
+	Usage: bsPackBuilder <output pack file> <input directory> [-compress] [-align <bytes>]
+
+	Every file in the input directory and its sub directories is added to the pack, using
+	its file name (without directories) as the entry name.
+
+	Build together with bsPackFileBuilder.cpp and bsCompression.cpp, with
+	BS_PACK_FILE_EXTERNAL defined.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../bsPackFileBuilder.h"
+
+
+void bsPackFileLogErrorMessage(const char* message)
+{
+	fprintf(stderr, "%s\n", message);
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		printf("Usage: %s <output pack file> <input directory> [-compress]"
+			" [-align <bytes>]\n", argv[0]);
+
+		return 1;
+	}
+
+	bool compress = false;
+	unsigned int alignment = 16;
+
+	for (int i = 3; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-compress") == 0)
+		{
+			compress = true;
+		}
+		else if (strcmp(argv[i], "-align") == 0 && i + 1 < argc)
+		{
+			alignment = strtoul(argv[++i], nullptr, 10);
+		}
+		else
+		{
+			fprintf(stderr, "Unknown argument '%s'\n", argv[i]);
+
+			return 1;
+		}
+	}
+
+	bsPackFileBuilder builder(alignment);
+
+	const unsigned int filesAdded = builder.addDirectory(argv[2], compress);
+	printf("Added %u files from '%s'\n", filesAdded, argv[2]);
+
+	if (!builder.write(argv[1]))
+	{
+		return 1;
+	}
+
+	printf("Wrote '%s'\n", argv[1]);
+
+	return 0;
+}